@@ -35,6 +35,7 @@
 #include <crtdbg.h>                 // For _ASSERTE
 #include <process.h>
 #include <math.h>                               // only for calculation of data simulation values
+#include "Logger.h"
 #include "IClassicBaseNodeManager.h"
 #include "ClassicNodeManager.h"
 
@@ -163,14 +164,17 @@ protected:
 DataSimulation gDataSimulation;
 
 
+// Number of simulation items updated by the RefreshThread
+#define NUM_SIM_ITEMS					3
+
 //-----------------------------------------------------------------------------
 // Update Thread														 SAMPLE
 // -------------
 //    This thread calls the function UpdateServerClassInstances()
-//    to activate the client update threads.
-//    There is a thread for each connected client. These threads checks
-//    the refresh interval of the defined groups and executes an
-//    OnDataChange() callback if required.
+//    to activate the client updates.
+//    The groups of all connected clients which must be updated are
+//    queued to a pool of worker threads which executes the
+//    OnDataChange() callbacks if required.
 // 
 //    Typically this thread also refreshes the the input signal cache.
 //    The client update is so synchronized with the cache refresh.
@@ -182,9 +186,21 @@ unsigned __stdcall RefreshThread(LPVOID pAttr)
 	FILETIME	TimeStamp;
 	VARIANT     Value;
 
+	void*       SimItems[NUM_SIM_ITEMS];
+	VARIANT     SimValues[NUM_SIM_ITEMS];
+	short       SimQualities[NUM_SIM_ITEMS];
+	FILETIME    SimTimeStamps[NUM_SIM_ITEMS];
+	HRESULT     SimErrors[NUM_SIM_ITEMS];
+	LARGE_INTEGER liFrequency, liStart, liEnd;
+	LONGLONG    llUpdateTicks = 0;               // time used for the cache updates
+	DWORD       dwUpdates = 0;                   // number of updated values
+	DWORD       dwUpdateCycles = 0;
+
 
 	_variant_t     devfailattrs[2];
 
+	QueryPerformanceFrequency(&liFrequency);
+
 	CoFileTimeNow(&TimeStamp);
 
 	// Keep this thread running until the Terminate Event is received
@@ -204,21 +220,37 @@ unsigned __stdcall RefreshThread(LPVOID pAttr)
 
 		CoFileTimeNow(&TimeStamp);
 
-		// update server cache for this item
-		V_I4(&Value) = gDataSimulation.RampValue();
-		V_VT(&Value) = VT_I4;
-
-		SetItemValue(gDeviceItem_SimRamp, &Value, (OPC_QUALITY_GOOD | OPC_LIMIT_OK), TimeStamp);
-
-		V_R8(&Value) = gDataSimulation.SineValue();
-		V_VT(&Value) = VT_R8;
-
-		SetItemValue(gDeviceItem_SimSine, &Value, (OPC_QUALITY_GOOD | OPC_LIMIT_OK), TimeStamp);
-
-		V_I4(&Value) = gDataSimulation.RandomValue();
-		V_VT(&Value) = VT_I4;
+		// update server cache for the simulation items with one call
+		V_I4(&SimValues[0]) = gDataSimulation.RampValue();
+		V_VT(&SimValues[0]) = VT_I4;
+		V_R8(&SimValues[1]) = gDataSimulation.SineValue();
+		V_VT(&SimValues[1]) = VT_R8;
+		V_I4(&SimValues[2]) = gDataSimulation.RandomValue();
+		V_VT(&SimValues[2]) = VT_I4;
+
+		SimItems[0] = gDeviceItem_SimRamp;
+		SimItems[1] = gDeviceItem_SimSine;
+		SimItems[2] = gDeviceItem_SimRandom;
+		for (int i = 0; i < NUM_SIM_ITEMS; i++) {
+			SimQualities[i] = (OPC_QUALITY_GOOD | OPC_LIMIT_OK);
+			SimTimeStamps[i] = TimeStamp;
+		}
 
-		SetItemValue(gDeviceItem_SimRandom, &Value, (OPC_QUALITY_GOOD | OPC_LIMIT_OK), TimeStamp);
+		QueryPerformanceCounter(&liStart);
+		SetItemValues(NUM_SIM_ITEMS, SimItems, SimValues, SimQualities, SimTimeStamps, SimErrors);
+		QueryPerformanceCounter(&liEnd);
+
+		// report the cache update throughput every minute
+		llUpdateTicks += liEnd.QuadPart - liStart.QuadPart;
+		dwUpdates += NUM_SIM_ITEMS;
+		if (++dwUpdateCycles == 60) {
+			double dblSeconds = (double)llUpdateTicks / liFrequency.QuadPart;
+			LOGFMTI("RefreshThread: %lu cache updates in %.3f ms (%.0f updates/s)",
+				dwUpdates, dblSeconds * 1000.0, dblSeconds > 0.0 ? dwUpdates / dblSeconds : 0.0);
+			llUpdateTicks = 0;
+			dwUpdates = 0;
+			dwUpdateCycles = 0;
+		}
 
 		}
 
@@ -43,9 +43,12 @@ namespace IClassicBaseNodeManager
 // GLOBALS (DON'T CHANGE)
 //-----------------------------------------------------------------------------
 AddItemPtr								addItemCallback;
+AddItemsPtr								addItemsCallback;
 RemoveItemPtr							removeItemCallback;
 AddPropertyPtr							addPropertyCallback;
 SetItemValuePtr							setItemValueCallback;
+SetItemValuesPtr						setItemValuesCallback;
+SetItemQualitiesPtr						setItemQualitiesCallback;
 SetServerStatePtr						setServerStateCallback;
 GetActiveItemsPtr						getActiveItemsCallback;
 
@@ -92,6 +95,27 @@ HRESULT AddAnalogItem(LPWSTR itemID, DaAccessRights accessRights, LPVARIANT init
 	return addItemCallback(itemID, accessRights, initValue, true, DaEuType::Analog, minValue, maxValue, deviceItemHandle);
 }
 
+HRESULT AddItems(int count, DaItemDefinition* items, void** deviceItemHandles, HRESULT* errors)
+{
+    if (addItemsCallback != nullptr) {
+        return addItemsCallback(count, items, deviceItemHandles, errors);
+    }
+    // Server without bulk callbacks: add the items one by one
+    HRESULT hres = S_OK;
+    for (int i = 0; i < count; i++) {
+        void* deviceItemHandle = nullptr;
+        errors[i] = addItemCallback(items[i].ItemId, items[i].AccessRights, &items[i].InitValue, items[i].Active,
+                                    items[i].EuType, items[i].MinValue, items[i].MaxValue, &deviceItemHandle);
+        if (FAILED(errors[i])) {
+            hres = S_FALSE;
+        }
+        if (deviceItemHandles != nullptr) {
+            deviceItemHandles[i] = SUCCEEDED(errors[i]) ? deviceItemHandle : nullptr;
+        }
+    }
+    return hres;
+}
+
 HRESULT RemoveItem(void* deviceItemHandle)
 {
 	return removeItemCallback(deviceItemHandle);
@@ -107,6 +131,46 @@ HRESULT SetItemValue(void* deviceItemHandle, LPVARIANT newValue, short quality,
 	return setItemValueCallback(deviceItemHandle, newValue, quality, timestamp);
 }
 
+HRESULT SetItemValues(int count, void** deviceItemHandles, LPVARIANT newValues, short* qualities, FILETIME* timestamps, HRESULT* errors)
+{
+    if (setItemValuesCallback != nullptr) {
+        return setItemValuesCallback(count, deviceItemHandles, newValues, qualities, timestamps, errors);
+    }
+    // Server without bulk callbacks: update the items one by one
+    FILETIME now;
+    HRESULT hres = S_OK;
+    if (timestamps == nullptr) {
+        CoFileTimeNow(&now);
+    }
+    for (int i = 0; i < count; i++) {
+        errors[i] = setItemValueCallback(deviceItemHandles[i], &newValues[i], qualities[i], timestamps ? timestamps[i] : now);
+        if (FAILED(errors[i])) {
+            hres = S_FALSE;
+        }
+    }
+    return hres;
+}
+
+HRESULT SetItemQualities(int count, void** deviceItemHandles, short* qualities, FILETIME* timestamps, HRESULT* errors)
+{
+    if (setItemQualitiesCallback != nullptr) {
+        return setItemQualitiesCallback(count, deviceItemHandles, qualities, timestamps, errors);
+    }
+    // Server without bulk callbacks: update the items one by one
+    FILETIME now;
+    HRESULT hres = S_OK;
+    if (timestamps == nullptr) {
+        CoFileTimeNow(&now);
+    }
+    for (int i = 0; i < count; i++) {
+        errors[i] = setItemValueCallback(deviceItemHandles[i], nullptr, qualities[i], timestamps ? timestamps[i] : now);
+        if (FAILED(errors[i])) {
+            hres = S_FALSE;
+        }
+    }
+    return hres;
+}
+
 void SetServerState( ServerState serverState )
 {
     setServerStateCallback(serverState);
@@ -170,6 +234,18 @@ DLLEXP HRESULT DLLCALL OnDefineDaCallbacks(
 }
 
 
+DLLEXP HRESULT DLLCALL OnDefineDaBulkCallbacks(
+                        SetItemValuesPtr            setItemValues,
+                        SetItemQualitiesPtr         setItemQualities,
+                        AddItemsPtr                 addItems )
+{
+    setItemValuesCallback = setItemValues;
+    setItemQualitiesCallback = setItemQualities;
+    addItemsCallback = addItems;
+    return S_OK;
+}
+
+
 DLLEXP HRESULT DLLCALL OnDefineAeCallbacks( 
 						AddSimpleEventCategoryPtr				addSimpleEventCat, 
 						AddTrackingEventCategoryPtr				addTrackingEventCat,
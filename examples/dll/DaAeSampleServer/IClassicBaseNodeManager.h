@@ -269,6 +269,36 @@ struct DaQuality
 
 };
 
+/**
+ * @struct    DaItemDefinition
+ *
+ * @brief    Contains the definition of an item added with AddItems.
+ */
+
+struct DaItemDefinition
+{
+    /// Fully qualified item name.
+    LPWSTR ItemId;
+
+    /// Access rights of the item.
+    DaAccessRights AccessRights;
+
+    /// Initial value which also defines the canonical data type.
+    VARIANT InitValue;
+
+    /// true to set the item in active state.
+    bool Active;
+
+    /// Type of the Engineering Unit, NoEnum or Analog.
+    DaEuType EuType;
+
+    /// Analog engineering unit, corresponding to the LOW EU range.
+    double MinValue;
+
+    /// Analog engineering unit, corresponding to the HIGH EU range.
+    double MaxValue;
+};
+
 /**
  * @enum    DaBrowseMode
  *
@@ -680,6 +710,37 @@ HRESULT AddItem(LPWSTR itemId, DaAccessRights accessRights, LPVARIANT initValue,
 
 HRESULT AddAnalogItem(LPWSTR itemId, DaAccessRights accessRights, LPVARIANT initValue, double minValue, double maxValue, void** deviceItemHandle = nullptr);
 
+/**
+ * @fn  HRESULT AddItems(int count, DaItemDefinition* items, void** deviceItemHandles, HRESULT* errors);
+ *
+ * @brief   This function is called by the customization plugin and adds several items to the
+ *          generic server cache. Same as calling
+ *          <see cref="AddItem" text="AddItem" />
+ *          for each item but much faster for a large number of items, e.g. if the whole
+ *          address space is defined in
+ *          <see cref="OnCreateServerItems" text="OnCreateServerItems" />.
+ *          
+ *          The items are sorted by item ID and added to the cache and the browse hierarchy
+ *          all at once. Clients see either none or all of the added items. AddItem() is called
+ *          for each item if the server does not call OnDefineDaBulkCallbacks().
+ *
+ * @param           count               Number of items.
+ * @param [in]      items               Array [count] with the definitions of the items. The
+ *                                      InitValue of each item is cleared.
+ * @param [out]     deviceItemHandles   If non\-null, array [count] which returns the created
+ *                                      device items; null for items which are not added.
+ * @param [out]     errors              Array [count] with the result of each item:
+ *                                      E_INVALIDARG if the item ID is invalid, already exists or
+ *                                      occurs more than once in items (only the first one is added).
+ *
+ * @return  A HRESULT code with the result of the operation.
+ *          
+ *           Returns S_OK if all items were successfully added to the cache; S_FALSE if
+ *           errors contains one or more errors.
+ */
+
+HRESULT AddItems(int count, DaItemDefinition* items, void** deviceItemHandles, HRESULT* errors);
+
 /**
  * @brief    This function is called by the customization plugin and removes an item from the
  *             generic server cache. If
@@ -751,11 +812,68 @@ HRESULT AddProperty(int propertyId, LPWSTR description, LPVARIANT valueType);
  *
  * @return  A HRESULT code with the result of the operation.
  *          
- *           Returns S_OK if the value was successfully written into the cache.
+ *           Returns S_OK if the value was successfully written into the cache;
+ *           OPC_E_INVALIDHANDLE if the handle is null or OPC_E_BADTYPE if the value doesn't
+ *           match the canonical data type. SetItemValues() returns the same codes per item.
  */
 
 HRESULT SetItemValue(void* deviceItemHandle, LPVARIANT newValue, short quality, FILETIME timestamp);
 
+/**
+ * @fn  HRESULT SetItemValues(int count, void** deviceItemHandles, LPVARIANT newValues, short* qualities, FILETIME* timestamps, HRESULT* errors);
+ *
+ * @brief   Generic server callback method.
+ *          
+ *            Write the values of several items into the cache. Same as calling
+ *            <see cref="SetItemValue@void*@LPVARIANT@short@FILETIME" text="SetItemValue" />()
+ *            for each item but with less overhead per item. SetItemValue() is called for each
+ *            item if the server does not call OnDefineDaBulkCallbacks().
+ *
+ * @param           count               Number of items.
+ * @param [in]      deviceItemHandles   Array [count] of Device Items as defined in the AddItem
+ *                                      method call.
+ * @param [in]      newValues           Array [count] of new item values. The values must match the
+ *                                      canonical data type of the items. An element with VT_NULL
+ *                                      changes only the quality and timestamp of the item.
+ * @param [in]      qualities           Array [count] of new qualities.
+ * @param [in]      timestamps          Array [count] of new timestamps. null uses the current time
+ *                                      for all items.
+ * @param [out]     errors              Array [count] with the result of each item; the same codes
+ *                                      as returned by SetItemValue().
+ *
+ * @return  A HRESULT code with the result of the operation.
+ *          
+ *           Returns S_OK if all values were successfully written into the cache; S_FALSE if
+ *           errors contains one or more errors.
+ */
+
+HRESULT SetItemValues(int count, void** deviceItemHandles, LPVARIANT newValues, short* qualities, FILETIME* timestamps, HRESULT* errors);
+
+/**
+ * @fn  HRESULT SetItemQualities(int count, void** deviceItemHandles, short* qualities, FILETIME* timestamps, HRESULT* errors);
+ *
+ * @brief   Generic server callback method.
+ *          
+ *            Changes only the quality and timestamp of several items and let the item values
+ *            unchanged, e.g. if a device is no longer reachable.
+ *
+ * @param           count               Number of items.
+ * @param [in]      deviceItemHandles   Array [count] of Device Items as defined in the AddItem
+ *                                      method call.
+ * @param [in]      qualities           Array [count] of new qualities.
+ * @param [in]      timestamps          Array [count] of new timestamps. null uses the current time
+ *                                      for all items.
+ * @param [out]     errors              Array [count] with the result of each item:
+ *                                      OPC_E_INVALIDHANDLE if the handle is null.
+ *
+ * @return  A HRESULT code with the result of the operation.
+ *          
+ *           Returns S_OK if all qualities were successfully written into the cache; S_FALSE if
+ *           errors contains one or more errors.
+ */
+
+HRESULT SetItemQualities(int count, void** deviceItemHandles, short* qualities, FILETIME* timestamps, HRESULT* errors);
+
 /**
  * @fn  void SetServerState(ServerState serverState);
  *
@@ -1761,9 +1879,12 @@ DLLEXP HRESULT DLLCALL OnRequestItems(int numItems, LPWSTR *fullItemIds, VARTYPE
 // Type Definitions
 //----------------------------------------------------------------------------
 typedef HRESULT(DLLCALL * AddItemPtr)(LPWSTR, DaAccessRights, LPVARIANT, bool, DaEuType, double, double, void**);
+typedef HRESULT(DLLCALL * AddItemsPtr)(int, DaItemDefinition*, void**, HRESULT*);
 typedef HRESULT(DLLCALL * RemoveItemPtr)(void*);
 typedef HRESULT(DLLCALL * AddPropertyPtr)(int, LPWSTR, LPVARIANT);
 typedef HRESULT(DLLCALL * SetItemValuePtr)(void*, LPVARIANT, short, FILETIME);
+typedef HRESULT(DLLCALL * SetItemValuesPtr)(int, void**, LPVARIANT, short*, FILETIME*, HRESULT*);
+typedef HRESULT(DLLCALL * SetItemQualitiesPtr)(int, void**, short*, FILETIME*, HRESULT*);
 typedef void (DLLCALL * SetServerStatePtr)(ServerState);
 typedef void (DLLCALL * GetActiveItemsPtr)(int * dwNumItemHandles, void* ** ppItemHandles);
 
@@ -167,10 +167,10 @@ DataSimulation gDataSimulation;
 // Update Thread														 SAMPLE
 // -------------
 //    This thread calls the function UpdateServerClassInstances()
-//    to activate the client update threads.
-//    There is a thread for each connected client. These threads checks
-//    the refresh interval of the defined groups and executes an
-//    OnDataChange() callback if required.
+//    to activate the client updates.
+//    The groups of all connected clients which must be updated are
+//    queued to a pool of worker threads which executes the
+//    OnDataChange() callbacks if required.
 // 
 //    Typically this thread also refreshes the the input signal cache.
 //    The client update is so synchronized with the cache refresh.
@@ -282,6 +282,46 @@ namespace ServerPlugin
 
     };
 
+    /// <summary>Contains the definition of an item added with AddItems().</summary>
+    public struct DaItemDefinition
+    {
+        /// <summary>
+        /// Fully qualified item name.
+        /// </summary>
+        public string ItemId;
+
+        /// <summary>
+        /// Item access rights.
+        /// </summary>
+        public DaAccessRights AccessRights;
+
+        /// <summary>
+        /// Initial value which also defines the canonical data type.
+        /// </summary>
+        public object InitValue;
+
+        /// <summary>
+        /// Defines whether the cache for this item should be refreshed.
+        /// </summary>
+        public Boolean Active;
+
+        /// <summary>
+        /// Engineering unit type, DaEuType.NoEnum or DaEuType.Analog.
+        /// </summary>
+        public DaEuType EuType;
+
+        /// <summary>
+        /// Analog engineering unit, corresponding to the LOW EU range.
+        /// </summary>
+        public double MinValue;
+
+        /// <summary>
+        /// Analog engineering unit, corresponding to the HIGH EU range.
+        /// </summary>
+        public double MaxValue;
+
+    };
+
     /// <summary>
     /// Contains the value for a single item. passed in WriteItems()
     /// </summary>
@@ -1277,6 +1317,22 @@ namespace ServerPlugin
                                 out IntPtr deviceItemHandle
                             );
 
+    /// <summary>
+    /// Generic server callback to add several items to the server's address space with one call.
+    /// </summary>
+    /// <returns>A <see cref="StatusCodes"/> code with the result of the operation.
+    /// Returns StatusCodes.Good if all items were successfully added to the cache and
+    /// StatusCodes.Bad if errors contains one or more errors.</returns>
+    /// <param name="items">Definitions of the items.</param>
+    /// <param name="deviceItemHandles">null or receives the handles of the created items;
+    /// IntPtr.Zero for items which are not added.</param>
+    /// <param name="errors">Result of each item; StatusCodes.BadInvalidArgument if the item ID is
+    /// invalid, already exists or occurs more than once in items (only the first one is added).</param>
+    public delegate int AddItems(
+                                DaItemDefinition[] items,
+                                IntPtr[] deviceItemHandles,
+                                int[] errors);
+
     /// <summary>
     /// Generic server callback to change an item value.
     /// </summary>
@@ -1304,6 +1360,38 @@ namespace ServerPlugin
                                 short quality,
                                 DateTime timestamp);
 
+    /// <summary>
+    /// Generic server callback to change the values of several items with one call.
+    /// </summary>
+    /// <returns>A <see cref="StatusCodes"/> code with the result of the operation.
+    /// Returns StatusCodes.Good if all values were successfully written into the cache and
+    /// StatusCodes.Bad if errors contains one or more errors.</returns>
+    /// <param name="deviceItemHandles">Generic Server device item handles</param>
+    /// <param name="newValues">New item values; null changes only the quality and timestamp of the item.</param>
+    /// <param name="qualities">New qualities of the item values.</param>
+    /// <param name="timestamps">New timestamps of the item values; null uses the current time for all items.</param>
+    /// <param name="errors">Result of each item; the same codes as returned by <see cref="SetItemValue"/>.</param>
+    public delegate int SetItemValues(
+                                IntPtr[] deviceItemHandles,
+                                object[] newValues,
+                                short[] qualities,
+                                DateTime[] timestamps,
+                                int[] errors);
+
+    /// <summary>
+    /// Generic server callback to change only the qualities and timestamps of several items with one call.
+    /// </summary>
+    /// <returns>A <see cref="StatusCodes"/> code with the result of the operation.</returns>
+    /// <param name="deviceItemHandles">Generic Server device item handles</param>
+    /// <param name="qualities">New qualities of the item values.</param>
+    /// <param name="timestamps">New timestamps of the item values; null uses the current time for all items.</param>
+    /// <param name="errors">Result of each item.</param>
+    public delegate int SetItemQualities(
+                                IntPtr[] deviceItemHandles,
+                                short[] qualities,
+                                DateTime[] timestamps,
+                                int[] errors);
+
     /// <summary>
     /// Generic server callback to remove an item from the server's address space.
     /// </summary>
@@ -1703,7 +1791,10 @@ namespace ServerPlugin
         #region Data Access Callback methods
 
         private static AddItem addItemCallback_;
+        private static AddItems addItemsCallback_;
         private static SetItemValue setItemValueCallback_;
+        private static SetItemValues setItemValuesCallback_;
+        private static SetItemQualities setItemQualitiesCallback_;
         private static RemoveItem removeItemCallback_;
         private static AddProperty addPropertyCallback_;
         private static SetServerState setServerStateCallback_;
@@ -1999,6 +2090,57 @@ namespace ServerPlugin
             return StatusCodes.BadNotImplemented;
         }
 
+        /// <summary>
+        /// 	<para>
+        ///         This function is called by the customization plugin and adds several items to
+        ///         the generic server cache. Same as calling
+        ///         <see cref="AddItem">AddItem</see> for each item but much faster for a large
+        ///         number of items, e.g. if the whole address space is defined in
+        ///         OnCreateServerItems.
+        ///     </para>
+        /// 	<para>The items are sorted by item ID and added to the cache and the browse
+        ///     hierarchy all at once. Clients see either none or all of the added items.</para>
+        /// </summary>
+        /// <returns>
+        ///     A <see cref="StatusCodes">StatusCodes</see> code with the result of the operation.
+        ///     Returns StatusCodes.Good if all items were successfully added to the cache;
+        ///     otherwise errors contains the result of each item.
+        /// </returns>
+        /// <param name="items">Definitions of the items.</param>
+        /// <param name="deviceItemHandles">null or array with at least items.Length elements which
+        /// receives the handles of the created items; IntPtr.Zero for items which are not added.</param>
+        /// <param name="errors">Array with at least items.Length elements which receives the
+        /// result of each item.</param>
+        public static int AddItems(DaItemDefinition[] items, IntPtr[] deviceItemHandles, int[] errors)
+        {
+            if (addItemsCallback_ != null)
+            {
+                return addItemsCallback_(items, deviceItemHandles, errors);
+            }
+            if (addItemCallback_ == null)
+            {
+                return StatusCodes.BadNotImplemented;
+            }
+            // Generic server without bulk callbacks: add the items one by one
+            int rtc = StatusCodes.Good;
+            for (int i = 0; i < items.Length; i++)
+            {
+                IntPtr deviceItemHandle;
+                errors[i] = addItemCallback_(items[i].ItemId, items[i].AccessRights, items[i].InitValue, items[i].Active,
+                                             items[i].EuType, items[i].MinValue, items[i].MaxValue, out deviceItemHandle);
+                if (StatusCodes.Failed(errors[i]))
+                {
+                    rtc = StatusCodes.Bad;
+                    deviceItemHandle = IntPtr.Zero;
+                }
+                if (deviceItemHandles != null)
+                {
+                    deviceItemHandles[i] = deviceItemHandle;
+                }
+            }
+            return rtc;
+        }
+
         /// <summary>
         /// 	<para>
         ///         This function is called by the customization plugin and removes an item from
@@ -2093,6 +2235,96 @@ namespace ServerPlugin
             return rtc;
         }
 
+        /// <summary>
+        /// 	<para>Generic server callback method.</para>
+        /// 	<para>Write the values of several items into the cache. Same as calling
+        ///     <see cref="SetItemValue"/> for each item but with less overhead per item.</para>
+        /// </summary>
+        /// <returns>
+        /// 	<para>Returns StatusCodes.Good if all values were successfully written into the
+        ///     cache; otherwise errors contains the result of each item with the same codes as
+        ///     returned by <see cref="SetItemValue"/>.</para>
+        /// </returns>
+        /// <param name="deviceItemHandles">Item handles as returned in the AddItem method call.</param>
+        /// <param name="newValues">New item values with the canonical data type of the items; null
+        /// changes only the quality and timestamp of the item.</param>
+        /// <param name="qualities">New qualities of the item values.</param>
+        /// <param name="timestamps">New timestamps of the item values; null uses the current time
+        /// for all items.</param>
+        /// <param name="errors">Array with at least deviceItemHandles.Length elements which
+        /// receives the result of each item.</param>
+        public static int SetItemValues(IntPtr[] deviceItemHandles, object[] newValues, short[] qualities, DateTime[] timestamps, int[] errors)
+        {
+            int rtc;
+            mutexSetVal_.WaitOne();
+            try
+            {
+                if (setItemValuesCallback_ != null)
+                {
+                    rtc = setItemValuesCallback_(deviceItemHandles, newValues, qualities, timestamps, errors);
+                }
+                else if (setItemValueCallback_ == null)
+                {
+                    rtc = StatusCodes.BadNotImplemented;
+                }
+                else
+                {
+                    // Generic server without bulk callbacks: update the items one by one
+                    DateTime now = DateTime.Now;
+                    rtc = StatusCodes.Good;
+                    for (int i = 0; i < deviceItemHandles.Length; i++)
+                    {
+                        errors[i] = setItemValueCallback_(deviceItemHandles[i], newValues[i], qualities[i], timestamps != null ? timestamps[i] : now);
+                        if (StatusCodes.Failed(errors[i]))
+                        {
+                            rtc = StatusCodes.Bad;
+                        }
+                    }
+                }
+            }
+            catch
+            {
+                rtc = StatusCodes.BadException;
+            }
+            mutexSetVal_.ReleaseMutex();
+            return rtc;
+        }
+
+        /// <summary>
+        /// 	<para>Generic server callback method.</para>
+        /// 	<para>Changes only the quality and timestamp of several items and let the item
+        ///     values unchanged, e.g. if a device is no longer reachable.</para>
+        /// </summary>
+        /// <returns>
+        /// 	<para>Returns StatusCodes.Good if all qualities were successfully written into the
+        ///     cache; otherwise errors contains the result of each item.</para>
+        /// </returns>
+        /// <param name="deviceItemHandles">Item handles as returned in the AddItem method call.</param>
+        /// <param name="qualities">New qualities of the item values.</param>
+        /// <param name="timestamps">New timestamps of the item values; null uses the current time
+        /// for all items.</param>
+        /// <param name="errors">Array with at least deviceItemHandles.Length elements which
+        /// receives the result of each item.</param>
+        public static int SetItemQualities(IntPtr[] deviceItemHandles, short[] qualities, DateTime[] timestamps, int[] errors)
+        {
+            if (setItemQualitiesCallback_ == null)
+            {
+                return SetItemValues(deviceItemHandles, new object[deviceItemHandles.Length], qualities, timestamps, errors);
+            }
+            int rtc;
+            mutexSetVal_.WaitOne();
+            try
+            {
+                rtc = setItemQualitiesCallback_(deviceItemHandles, qualities, timestamps, errors);
+            }
+            catch
+            {
+                rtc = StatusCodes.BadException;
+            }
+            mutexSetVal_.ReleaseMutex();
+            return rtc;
+        }
+
         /// <summary>
         /// Generic server callback to get a list of items used at least by one client.
         /// </summary>
@@ -2212,6 +2444,24 @@ namespace ServerPlugin
             FireShutdownRequestCallback_ = fireShutdownRequest;
         }
 
+        /// <summary>
+        /// 	<para>This method is called from the generic server at startup after
+        ///  <see cref="OnDefineDaCallbacks"/>. It passes the callback methods used to update
+        ///  several items with one call.</para>
+        /// 	<para>The method need not be overloaded or changed. If it is not called (older
+        ///  generic server) SetItemValues and SetItemQualities call SetItemValue for each item and
+        ///  AddItems calls AddItem for each item.</para>
+        /// </summary>
+        /// <param name="setItemValues">Writes new values of several items into the server's cache</param>
+        /// <param name="setItemQualities">Writes new qualities of several items into the server's cache</param>
+        /// <param name="addItems">Adds several items to the server's cache</param>
+        public void OnDefineDaBulkCallbacks(SetItemValues setItemValues, SetItemQualities setItemQualities, AddItems addItems)
+        {
+            setItemValuesCallback_ = setItemValues;
+            setItemQualitiesCallback_ = setItemQualities;
+            addItemsCallback_ = addItems;
+        }
+
 
         /// <summary>
         /// 	<para>This method is called from the generic server at startup for normal operation or for registration. It provides server registry information for this
@@ -1464,10 +1464,15 @@ BOOL AeBaseServer::ExistSource(LPCWSTR szName)
     DWORD dwSize;
     BOOL  fSourceExist = FALSE;
 
+    CompiledPattern pattern;                    // Compiled once for all sources
+    if (FAILED(pattern.Compile(szName))) {
+        return FALSE;
+    }
+
     m_csSrcMap.Lock();
     dwSize = m_mapSources.GetSize();
     while (dwSize--) {
-        if (MatchPattern(m_mapSources.m_aVal[dwSize]->Name(), szName)) {
+        if (pattern.Match(m_mapSources.m_aVal[dwSize]->Name())) {
             fSourceExist = TRUE;
             break;
         }
@@ -26,6 +26,7 @@
  //-------------------------------------------------------------------------
 #include "stdafx.h"
 #include "UtilityDefs.h"
+#include "OpcClock.h"
 #include "AeEvent.h"
 #include "AeSource.h"
 #include "AeCategory.h"
@@ -151,8 +152,7 @@ HRESULT AeCondition::Enable(BOOL fEnable, AeEvent** ppEvent)
     HRESULT  hres = S_FALSE;
     FILETIME ftNow;
 
-    hres = CoFileTimeNow(&ftNow);
-    if (FAILED(hres)) return hres;
+    OpcClockCoarse(&ftNow);
 
     if (fEnable) {
         m_wNewState |= OPC_CONDITION_ENABLED;
@@ -244,8 +244,7 @@ HRESULT AeCondition::Acknowledge(LPCWSTR szAcknowledgerID, LPCWSTR szComment, FI
 
 
     if (useCurrentTime) {
-        hres = CoFileTimeNow(&m_ftTime);        // Time of the event occurence
-        if (FAILED(hres)) return hres;
+        OpcClockCoarse(&m_ftTime);              // Time of the event occurence
     }
     m_ftLastAckTime = m_ftTime;                 // Time of acknowledge
 
@@ -486,8 +485,7 @@ HRESULT AeCondition::ChangeState(AeConditionChangeStates& cs, AeEvent** ppEvent,
         m_ftTime = *cs.TimeStampPtr();            // Time of the condition state transition is already defined
     }
     else {
-        hres = CoFileTimeNow(&m_ftTime);        // Time of the condition state transition is now
-        if (FAILED(hres)) return hres;
+        OpcClockCoarse(&m_ftTime);              // Time of the condition state transition is now
     }
 
     m_wChangeMask = 0;                           // Reset the change mask
@@ -26,6 +26,7 @@
 //-----------------------------------------------------------------------
 #include "stdafx.h"
 #include "UtilityFuncs.h"
+#include "OpcClock.h"
 #include "AeSource.h"
 #include "AeCategory.h"
 #include "AeCondition.h"
@@ -126,8 +127,7 @@ HRESULT AeEvent::Create( AeCategory* pCat, AeSource *pSource,
          ftTime = *pft;
       }
       else {
-         hres = CoFileTimeNow( &ftTime );
-         if (FAILED( hres )) throw hres;
+         OpcClockCoarse( &ftTime );
       }
       szSource             = pSource->Name().Copy();
       szMessage            = WSTRClone( szParMessage );
@@ -67,6 +67,8 @@ using namespace IClassicBaseNodeManager;
 #endif
 
 
+class DeviceItem;
+
 HRESULT CreateOneItem(LPWSTR szItemID,
 	DWORD dwAccessRights,
 	LPVARIANT pvValue,
@@ -76,6 +78,16 @@ HRESULT CreateOneItem(LPWSTR szItemID,
 	void** deviceItem
 	);
 
+HRESULT CreateItemInstance(LPWSTR szItemID,
+	DWORD dwAccessRights,
+	LPVARIANT pvValue,
+	BOOL fActive,
+	OPCEUTYPE eEUType,
+	double minValue,
+	double maxValue,
+	DeviceItem** ppDItem
+	);
+
 #ifdef _OPC_NET
 typedef struct _tagSERVER_REGDEF1 {
 	WCHAR ClsidServer[256]; // CLSID of current Server
@@ -100,6 +112,8 @@ HRESULT DLLCALL AddItem(
 	void** deviceItemHandle
 	);
 
+HRESULT DLLCALL AddItems(int count, DaItemDefinition* items, void** deviceItemHandles, HRESULT* errors);
+
 HRESULT DLLCALL RemoveItem(void* deviceItem);
 
 HRESULT DLLCALL AddProperty(int propertyID, LPWSTR description, LPVARIANT valueType);
@@ -112,6 +126,9 @@ HRESULT DLLCALL SetItemValue(
 	FILETIME timestamp
 	);
 
+HRESULT DLLCALL SetItemValues(int count, void** deviceItems, LPVARIANT newValues, short* qualities, FILETIME* timestamps, HRESULT* errors);
+
+HRESULT DLLCALL SetItemQualities(int count, void** deviceItems, short* qualities, FILETIME* timestamps, HRESULT* errors);
 
 void DLLCALL SetServerState(ServerState serverState);
 
@@ -161,6 +178,7 @@ typedef DLLIMP ServerRegDefs * (DLLCALL * PFNONGETDASEERVERREGISTRYDEFINITION)(v
 typedef DLLIMP ServerRegDefs * (DLLCALL * PFNONGETAESEERVERREGISTRYDEFINITION)(void);
 typedef DLLIMP HRESULT(DLLCALL * PFNONGETDASERVERPARAMETERS) (int *, WCHAR *, int *);
 typedef DLLIMP HRESULT(DLLCALL * PFNONDEFINEDACALLBACKS) (AddItemPtr AddItem, RemoveItemPtr RemoveItem, AddPropertyPtr AddProperty, SetItemValuePtr SetItemValue, SetServerStatePtr SetServerState, GetActiveItemsPtr GetActiveItems, FireShutdownRequestPtr fireShutdownRequest, GetClientsPtr getClients, GetGroupsPtr getGroups, GetGroupStatePtr getGroupState, GetItemStatesPtr getItemStates);
+typedef DLLIMP HRESULT(DLLCALL * PFNONDEFINEDABULKCALLBACKS) (SetItemValuesPtr SetItemValues, SetItemQualitiesPtr SetItemQualities, AddItemsPtr AddItems);
 typedef DLLIMP HRESULT(DLLCALL * PFNONCREATESERVERITEMS) ();
 typedef DLLIMP HRESULT(DLLCALL * PFNONCLIENTCONNECT) (void);
 typedef DLLIMP HRESULT(DLLCALL * PFNONCLIENTDISCONNECT) (void);
@@ -198,6 +216,7 @@ extern PFNONGETDASEERVERREGISTRYDEFINITION pOnGetDaServerDefinition;
 extern PFNONGETAESEERVERREGISTRYDEFINITION pOnGetAeServerDefinition;
 extern PFNONGETDASERVERPARAMETERS pOnGetDaServerParameters;
 extern PFNONDEFINEDACALLBACKS pOnDefineDaCallbacks;
+extern PFNONDEFINEDABULKCALLBACKS pOnDefineDaBulkCallbacks;
 extern PFNONCREATESERVERITEMS pOnCreateServerItems;
 extern PFNONCLIENTCONNECT pOnClientConnect;
 extern PFNONCLIENTDISCONNECT pOnClientDisconnect;
@@ -323,6 +342,7 @@ public:
 	// Operations
 public:
 	HRESULT AddDeviceItem(DeviceItem* pDItem);
+	HRESULT AddDeviceItems(DWORD dwCount, DeviceItem** ppDItems, HRESULT* pErrors);
 	HRESULT RemoveDeviceItem(DeviceItem* pDItem);
 	void DeleteDeviceItem(DeviceItem* pDItem);
 
@@ -497,6 +517,10 @@ protected:
 	// Root of the hierarchical Server Address Space
 	DaBranch m_SASRoot;
 
+	// Index of the Device Items by fully qualified Item ID.
+	// Protected by m_ItemListLock.
+	CAtlMap<LPCWSTR, DaDeviceItem*, LPCWSTRRefElementTraits<LPCWSTR>> m_mapItemIDs;
+
 	BOOL m_fCreated;
 };
 
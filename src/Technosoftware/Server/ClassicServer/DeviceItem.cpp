@@ -45,6 +45,11 @@ DeviceItem::DeviceItem()
    //
    // TODO : Initialize here your own item specific data
    //
+
+   // This class does not override get_ItemValue(), set_ItemValue() or
+   // set_ItemQuality(), so the bulk reads and updates may access the
+   // value cache directly. Remove this line if you add such overrides.
+   m_fDirectValueAccess = TRUE;
 }
 
 
@@ -103,6 +103,7 @@ PFNONGETLOGPATH						   pOnGetLogPath;
 PFNONGETDASEERVERREGISTRYDEFINITION    pOnGetDaServerDefinition;
 PFNONGETDASERVERPARAMETERS             pOnGetDaServerParameters;
 PFNONDEFINEDACALLBACKS                 pOnDefineDaCallbacks;
+PFNONDEFINEDABULKCALLBACKS             pOnDefineDaBulkCallbacks;
 PFNONCREATESERVERITEMS                 pOnCreateServerItems;
 PFNONCLIENTCONNECT                     pOnClientConnect;
 PFNONCLIENTDISCONNECT                  pOnClientDisconnect;
@@ -269,6 +270,12 @@ HRESULT LoadAppDLL( LPCTSTR DLLName, BOOL & fErrMsgDisplayed )
 		hres = TYPE_E_DLLFUNCTIONNOTFOUND ;
 	}
 
+	pOnDefineDaBulkCallbacks = (PFNONDEFINEDABULKCALLBACKS)GetProcAddress( gDLLHandle, "OnDefineDaBulkCallbacks" );
+	/*
+	* OnDefineDaBulkCallbacks is optional and can be missed
+	*/
+	//if (pOnDefineDaBulkCallbacks == NULL)        hres = TYPE_E_DLLFUNCTIONNOTFOUND ;
+
 	pOnCreateServerItems = (PFNONCREATESERVERITEMS)GetProcAddress( gDLLHandle, "OnCreateServerItems" );
 	if (pOnCreateServerItems == nullptr)
 	{
@@ -27,6 +27,7 @@
 #include <process.h>
 #include <math.h>                               // for data simulation only
 #include "Logger.h"
+#include "OpcClock.h"
 
 //-----------------------------------------------------------------------------
 // CODE
@@ -42,24 +43,48 @@
 // Update Thread
 // -------------
 //    This thread calls the function UpdateServerClassInstances()
-//    to activate the client update threads.
-//    There is a thread for each connected client. These threads checks
-//    the refresh interval of the defined groups and executes an
-//    OnDataChange() callback if required.
+//    to activate the client updates.
+//    The groups of all connected clients which must be updated are
+//    queued to a pool of worker threads which executes the
+//    OnDataChange() callbacks. The number of worker threads can be
+//    set with DaBaseServer::SetUpdateThreadCount().
 // 
 //    Typically this thread also refreshes the the input signal cache.
 //    The client update is so synchronized with the cache refresh.
 // 
+//    The cost of each cycle is reported to ReportUpdateCycle(). If the
+//    worker threads cannot keep up with the client updates the update
+//    rates of the groups are stretched. If the cycles of this thread
+//    take longer than the base update rate the thread pauses a part of
+//    the base update rate instead of starting the next cycle immediately.
+// 
 //=============================================================================
+
+// Returns the time in ms between two file times
+static DWORD ElapsedMs( const FILETIME& ftStart, const FILETIME& ftEnd )
+{
+   LARGE_INTEGER     liStart, liEnd;
+
+   liStart.u.LowPart = ftStart.dwLowDateTime;
+   liStart.u.HighPart= ftStart.dwHighDateTime;
+   liEnd.u.LowPart   = ftEnd.dwLowDateTime; 
+   liEnd.u.HighPart  = ftEnd.dwHighDateTime;
+
+   if (liEnd.QuadPart <= liStart.QuadPart) {
+      return 0;                                 // system time changed
+   }
+   return (DWORD)((liEnd.QuadPart - liStart.QuadPart) / 10000);
+}
+
+
 unsigned __stdcall NotifyUpdateThread( LPVOID pAttr )
 {
       DaServer*  pDataServer = static_cast<DaServer *>(pAttr);
       _ASSERTE( pDataServer );                  // Must not be NULL.
 
-      FILETIME          ftStart, ftEnd;
-      LARGE_INTEGER     liStart, liEnd;
-      DWORD             dwDuration, dwBaseUpdateRate;
-      DWORD             dwCount = 0;
+      FILETIME          ftStart, ftRefreshed, ftEnd;
+      DWORD             dwRefreshDuration, dwUpdateDuration;
+      DWORD             dwBaseUpdateRate, dwWaitTime;
 
    // Writes the output signal states from the item cache to the hardware
    // Do this only one time to initialize the hardware.
@@ -69,49 +94,45 @@ unsigned __stdcall NotifyUpdateThread( LPVOID pAttr )
 
    for (;;) {                                   // Thread Loop
 
-      CoFileTimeNow( &ftStart );
+      OpcClockCoarse( &ftStart );
 
       // Reads the input devices and refreshs the chache
       pDataServer->OnRefreshInputCache( OPC_REFRESH_PERIODIC, 0, NULL, NULL );
 
-      // Activate the client update threads for data callbacks
+      OpcClockCoarse( &ftRefreshed );
+
+      // Activate the client updates for data callbacks
       if (FAILED( pDataServer->UpdateServerClassInstances() )) {
          //
          // TODO: Server specific error handling
          //
       }
 
-      CoFileTimeNow( &ftEnd );
-
-      // Calculate duration for the periodic cache update in ms
-      liStart.u.LowPart = ftStart.dwLowDateTime;
-      liStart.u.HighPart= ftStart.dwHighDateTime;
-      liEnd.u.LowPart   = ftEnd.dwLowDateTime; 
-      liEnd.u.HighPart  = ftEnd.dwHighDateTime;
+      OpcClockCoarse( &ftEnd );
 
-      dwDuration = (DWORD)((liEnd.QuadPart - liStart.QuadPart) / 10000);
+      // Calculate duration for the periodic cache update and for
+      // queueing the client updates in ms
+      dwRefreshDuration = ElapsedMs( ftStart, ftRefreshed );
+      dwUpdateDuration  = ElapsedMs( ftRefreshed, ftEnd );
 
       dwBaseUpdateRate = pDataServer->GetBaseUpdateRate();
 
-      pDataServer->m_dwBandWith = dwDuration * 100 / dwBaseUpdateRate;
+      pDataServer->m_dwBandWith = (dwRefreshDuration + dwUpdateDuration) * 100 / dwBaseUpdateRate;
 
-      if (dwDuration > dwBaseUpdateRate) {
+      // Adapts the group update rates if the update workers are overloaded
+      dwWaitTime = pDataServer->ReportUpdateCycle( dwRefreshDuration, dwUpdateDuration );
+
+      if (dwRefreshDuration + dwUpdateDuration >= dwBaseUpdateRate) {
          //
          // TODO: If AE Server is availabe then you can add
          //       here server specific overrun error handling.
          //
-
-         // Also check the terminate event if there is an overrrun error.
-         if (WaitForSingleObject( pDataServer->m_hTerminateThraedsEvent,
-                                  0 ) != WAIT_TIMEOUT) {
-            break;                              // Terminate Thread
-         }
       }
-      else {                                    // Sleep the base interval
-         if (WaitForSingleObject( pDataServer->m_hTerminateThraedsEvent,
-                                  dwBaseUpdateRate - dwDuration ) != WAIT_TIMEOUT) {
-            break;                              // Terminate Thread
-         }
+
+      // Sleep the base interval, also check the terminate event if there is an overrun
+      if (WaitForSingleObject( pDataServer->m_hTerminateThraedsEvent,
+                               dwWaitTime ) != WAIT_TIMEOUT) {
+         break;                                 // Terminate Thread
       }
    }                                            // Thread Loop
 
@@ -67,3 +67,71 @@ HRESULT		CreateOneItem(	LPWSTR						szItemID,
 	return hres;
 }
 
+
+
+//=============================================================================
+// CreateItemInstance
+// ------------------
+//    Creates the Device Item of one item without adding it to the server
+//    data structure. Used by AddItems() of the DLL and .NET wrappers which
+//    add all created items with DaServer::AddDeviceItems().
+//    For analog items the EU Info is built from minValue and maxValue.
+//    The created item is returned in ppDItem or NULL if failed.
+//=============================================================================
+HRESULT		CreateItemInstance(	LPWSTR				szItemID,
+								DWORD				dwAccessRights,
+								LPVARIANT			pvValue,
+								BOOL				fActive,
+								OPCEUTYPE			eEUType,
+								double				minValue,
+								double				maxValue,
+								DeviceItem**		ppDItem
+)
+{
+	HRESULT		hres;
+	VARIANT		varEUInfo;
+
+	*ppDItem = NULL;
+	VariantInit(&varEUInfo);
+	if (eEUType == OPC_ANALOG) {
+		// EU Info must contain exaclty two doubles
+		// corresponding to the LOW and HI EU range.
+		V_VT(&varEUInfo) = VT_ARRAY | VT_R8;
+
+		SAFEARRAYBOUND rgs;
+		rgs.cElements = 2;
+		rgs.lLbound = 0;
+
+		try {
+			CHECK_PTR(V_ARRAY(&varEUInfo) = SafeArrayCreate(VT_R8, 1, &rgs))
+			long     lElIndex = 0;                  // LOW EU range
+			CHECK_RESULT(SafeArrayPutElement(V_ARRAY(&varEUInfo), &lElIndex, &minValue))
+			lElIndex++;                             // HI  EU range
+			CHECK_RESULT(SafeArrayPutElement(V_ARRAY(&varEUInfo), &lElIndex, &maxValue))
+		}
+		catch (HRESULT hresEx) {                    // cleanup if failure
+			VariantClear(&varEUInfo);
+			return hresEx;
+		}
+	}
+	else if (eEUType != OPC_NOENUM) {
+		return E_INVALIDARG;                        // Enumerated items are not supported
+	}
+
+	DeviceItem* pItem = new DeviceItem;             // Allocate space for new server item.
+	if (pItem == NULL) {
+		hres = E_OUTOFMEMORY;
+	}
+	else {                                          // Initialize new Item instance
+		hres = pItem->Create(szItemID, dwAccessRights, pvValue, fActive, 0, NULL, NULL, eEUType,
+							(eEUType == OPC_ANALOG) ? &varEUInfo : NULL);
+		if (FAILED(hres)) {
+			delete pItem;
+		}
+		else {
+			*ppDItem = pItem;
+		}
+	}
+	VariantClear(&varEUInfo);
+	return hres;
+}
@@ -175,6 +175,77 @@ ref struct GenericServerCallbacks {
 	};
 
 
+	//=========================================================================
+	// This function is called by the customization plugin and adds several
+	// items to the generic server cache. Same as AddItem() for each item but
+	// all items are created first and then added with a single lock of the
+	// item list. errors gets the result of each item; deviceItemHandles is
+	// null or gets the created items (IntPtr.Zero if not added).
+	//=========================================================================
+	static Int32 AddItems(array<ServerPlugin::DaItemDefinition>^ items, array<IntPtr>^ deviceItemHandles, array<Int32>^ errors)
+	{
+		HRESULT			hres;
+		BOOL			fCreateFailed = FALSE;
+
+		if (items == nullptr || errors == nullptr) {
+			return E_INVALIDARG;
+		}
+		int count = items->Length;
+		if (errors->Length < count || (deviceItemHandles != nullptr && deviceItemHandles->Length < count)) {
+			return E_INVALIDARG;
+		}
+		if (count == 0) {
+			return S_OK;
+		}
+
+		DeviceItem** ppDItems = new DeviceItem*[count];
+		HRESULT* pErrors = new HRESULT[count];
+		if (ppDItems == NULL || pErrors == NULL) {
+			delete[] ppDItems;
+			delete[] pErrors;
+			return E_OUTOFMEMORY;
+		}
+
+		for (int i = 0; i < count; i++) {
+			VARIANT	varVal;
+			VariantInit( &varVal );
+			Marshal::GetNativeVariantForObject(items[i].InitValue, IntPtr(&varVal));
+			// The Item ID is copied by the Device Item
+			wchar_t* pwc = static_cast<wchar_t*>(Marshal::StringToHGlobalUni(items[i].ItemId).ToPointer());
+			pErrors[i] = CreateItemInstance(
+				pwc,								// ItemID
+				(DWORD)items[i].AccessRights,		// AccessRights
+				&varVal,							// Initial Value
+				items[i].Active,					// Active State
+				(OPCEUTYPE)items[i].EuType,			// EU Type
+				items[i].MinValue,					// LOW EU range
+				items[i].MaxValue,					// HI EU range
+				&ppDItems[i]
+				);
+			if (FAILED(pErrors[i])) {
+				fCreateFailed = TRUE;
+			}
+			Marshal::FreeHGlobal(IntPtr(pwc));
+			VariantClear( &varVal );
+		}
+
+		hres = gpDataServer->AddDeviceItems((DWORD)count, ppDItems, pErrors);
+		if (hres == S_OK && fCreateFailed) {
+			hres = S_FALSE;
+		}
+
+		for (int i = 0; i < count; i++) {
+			errors[i] = pErrors[i];
+			if (deviceItemHandles != nullptr) {
+				deviceItemHandles[i] = (IntPtr)ppDItems[i];	// IntPtr.Zero if not added
+			}
+		}
+		delete[] ppDItems;
+		delete[] pErrors;
+		return hres;
+	};
+
+
 	//=========================================================================
     // This function is called by the customization plugin and removes an item 
 	// from the generic server cache. If DaBrowseMode.Generic is set the item 
@@ -302,38 +373,106 @@ ref struct GenericServerCallbacks {
 		DeviceItem*  pItem = NULL;
 		_FILETIME 		ftimeStamp;
 
-		gpDataServer->readWriteLock_.BeginWriting();	// We are manipulating the DeviceItem make
-														// sure no one else gets access during update.
+		// No server wide lock: the cache of the item is protected by
+		// the item itself, so updates of different items run in parallel.
+		// Same error codes as SetItemValues()
 		pItem = (DeviceItem*)(void*)deviceItemHandle;
 		if (pItem == NULL) {
-			return(S_FALSE);
+			return(OPC_E_INVALIDHANDLE);
 		}
 
 		VariantInit( &varVal );
 		Marshal::GetNativeVariantForObject(NewValue, IntPtr(&varVal));
-		if (V_VT( &varVal ) != VT_NULL) {
-			__int64 fileTime = timestamp.ToFileTime();
-			DWORD test = (DWORD)fileTime;
-			ftimeStamp.dwLowDateTime = test;
-			test = (DWORD)(fileTime >> 32);
-			ftimeStamp.dwHighDateTime = test;
+		__int64 fileTime = timestamp.ToFileTime();
+		ftimeStamp.dwLowDateTime = (DWORD)fileTime;
+		ftimeStamp.dwHighDateTime = (DWORD)(fileTime >> 32);
 
-			if (V_VT( &varVal ) == VT_EMPTY) {
-				// Update only quality and time stamp
-				hres = pItem->set_ItemQuality( quality, &ftimeStamp );
+		if (V_VT( &varVal ) == VT_EMPTY || V_VT( &varVal ) == VT_NULL) {
+			// Update only quality and time stamp
+			hres = pItem->set_ItemQuality( quality, &ftimeStamp );
+		}
+		else {
+			hres = pItem->set_ItemValue( &varVal, quality, &ftimeStamp );
+			VariantClear( &varVal );
+		}
+		return hres;
+	};
+
+
+	//=========================================================================
+	// Write the values of several items into the cache. The items are
+	// updated in blocks with DaDeviceItem::SetItemValues(); errors gets the
+	// same codes as returned by SetItemValue(). newValues is null if only
+	// the qualities and time stamps are updated.
+	//=========================================================================
+	static Int32 SetItemValuesInBlocks(array<IntPtr>^ deviceItemHandles, array<Object^>^ newValues, array<Int16>^ qualities, array<DateTime>^ timestamps, array<Int32>^ errors)
+	{
+		const int		nBlock = 256;	// Number of items converted on the stack
+		DaDeviceItem*	apItems[nBlock];
+		VARIANT			avValues[nBlock];
+		WORD			awQualities[nBlock];
+		FILETIME		aftTimeStamps[nBlock];
+		HRESULT			ahErrors[nBlock];
+		HRESULT			hres = S_OK;
+
+		if (deviceItemHandles == nullptr || qualities == nullptr || errors == nullptr) {
+			return E_INVALIDARG;
+		}
+		int count = deviceItemHandles->Length;
+		if (qualities->Length < count || errors->Length < count ||
+			(newValues != nullptr && newValues->Length < count) ||
+			(timestamps != nullptr && timestamps->Length < count)) {
+			return E_INVALIDARG;
+		}
+
+		for (int i = 0; i < count; i += nBlock) {
+			int n = min(count - i, nBlock);
+			for (int b = 0; b < n; b++) {
+				apItems[b] = (DeviceItem*)(void*)deviceItemHandles[i + b];
+				awQualities[b] = (WORD)qualities[i + b];
+				VariantInit( &avValues[b] );
+				if (newValues != nullptr) {
+					Marshal::GetNativeVariantForObject(newValues[i + b], IntPtr(&avValues[b]));
+				}
+				if (timestamps != nullptr) {
+					__int64 fileTime = timestamps[i + b].ToFileTime();
+					aftTimeStamps[b].dwLowDateTime = (DWORD)fileTime;
+					aftTimeStamps[b].dwHighDateTime = (DWORD)(fileTime >> 32);
+				}
+			}
+			HRESULT hresBlock = DaDeviceItem::SetItemValues( n, apItems,
+															newValues != nullptr ? avValues : NULL,
+															awQualities,
+															timestamps != nullptr ? aftTimeStamps : NULL,
+															ahErrors );
+			for (int b = 0; b < n; b++) {
+				VariantClear( &avValues[b] );
+				errors[i + b] = FAILED( hresBlock ) ? hresBlock : ahErrors[b];
+			}
+			if (FAILED( hresBlock )) {
+				return hresBlock;
 			}
-			else {
-				hres = pItem->set_ItemValue( &varVal, quality, &ftimeStamp );
-				VariantClear( &varVal );
+			if (hresBlock == S_FALSE) {
+				hres = S_FALSE;
 			}
 		}
-		gpDataServer->readWriteLock_.EndWriting();     // UnLock DeviceItem
+		return hres;
+	};
 
-		if (FAILED( hres )) {
-			return( S_FALSE );
+	static Int32 SetItemValues(array<IntPtr>^ deviceItemHandles, array<Object^>^ newValues, array<Int16>^ qualities, array<DateTime>^ timestamps, array<Int32>^ errors)
+	{
+		if (newValues == nullptr) {
+			return E_INVALIDARG;
 		}
+		return SetItemValuesInBlocks(deviceItemHandles, newValues, qualities, timestamps, errors);
+	};
 
-		return S_OK;
+	//=========================================================================
+	// Changes only the quality and time stamp of several items.
+	//=========================================================================
+	static Int32 SetItemQualities(array<IntPtr>^ deviceItemHandles, array<Int16>^ qualities, array<DateTime>^ timestamps, array<Int32>^ errors)
+	{
+		return SetItemValuesInBlocks(deviceItemHandles, nullptr, qualities, timestamps, errors);
 	};
 
 	
@@ -1576,6 +1715,9 @@ public  ref class GenericServerAPI : public Object
 		ServerPlugin::RemoveItem ^ StaticRemoveItem = gcnew ServerPlugin::RemoveItem(&GenericServerCallbacks::RemoveItem);
 		ServerPlugin::AddProperty ^ StaticAddProperty = gcnew ServerPlugin::AddProperty(&GenericServerCallbacks::AddProperty);
 		ServerPlugin::SetItemValue ^ StaticSetItemValue = gcnew ServerPlugin::SetItemValue(&GenericServerCallbacks::SetItemValue);
+		ServerPlugin::SetItemValues ^ StaticSetItemValues = gcnew ServerPlugin::SetItemValues(&GenericServerCallbacks::SetItemValues);
+		ServerPlugin::SetItemQualities ^ StaticSetItemQualities = gcnew ServerPlugin::SetItemQualities(&GenericServerCallbacks::SetItemQualities);
+		ServerPlugin::AddItems ^ StaticAddItems = gcnew ServerPlugin::AddItems(&GenericServerCallbacks::AddItems);
 		ServerPlugin::SetServerState ^ StaticSetServerState = gcnew ServerPlugin::SetServerState(&GenericServerCallbacks::SetServerState);
 		ServerPlugin::GetActiveItems ^ StaticGetActiveItems = gcnew ServerPlugin::GetActiveItems(&GenericServerCallbacks::GetActiveItems);
         ServerPlugin::GetClients ^ StaticGetClients = gcnew ServerPlugin::GetClients(&GenericServerCallbacks::GetClients);
@@ -1605,6 +1747,7 @@ public  ref class GenericServerAPI : public Object
 			m_drv = gcnew ServerPlugin::ClassicNodeManager();
 		}
 		m_drv->OnDefineDaCallbacks(StaticAddItem, StaticRemoveItem, StaticAddProperty, StaticSetItemValue, StaticSetServerState, StaticGetActiveItems, StaticGetClients, StaticGetGroups, StaticGetGroupState, StaticGetItemState, StaticFireShutdownRequest);
+		m_drv->OnDefineDaBulkCallbacks(StaticSetItemValues, StaticSetItemQualities, StaticAddItems);
 
 		m_drv->OnDefineAeCallbacks(StaticAddSimpleEventCategory, StaticAddTrackingEventCategory, StaticAddConditionEventCategory, StaticAddEventAttribute, StaticAddSingleStateConditionDefinition, StaticAddMultiStateConditionDefinition, StaticAddSubConditionDefinition, StaticAddArea, StaticAddSource, StaticAddExistingSource, StaticAddCondition, StaticProcessSimpleEvent, StaticProcessTrackingEvent, StaticProcessConditionStateChanges, StaticAckCondition);
 
@@ -113,6 +113,72 @@ namespace IClassicBaseNodeManager
 		return hres;
 	}
 
+	//=========================================================================
+	// AddItems
+	// --------
+	//    Creates several items in the server data structure. All items are
+	//    created first and then added with a single lock of the item list.
+	//=========================================================================
+	HRESULT DLLCALL AddItems(
+		int					count,
+		DaItemDefinition*	items,
+		void**				deviceItemHandles,
+		HRESULT*			errors
+		)
+	{
+		HRESULT			hres;
+		BOOL			fCreateFailed = FALSE;
+
+		LOGFMTT("AddItems() called from plugin for %d items.", count);
+		if (count < 0 || (count > 0 && (items == NULL || errors == NULL))) {
+			LOGFMTE("AddItems() failed with hres = 0x%x.", E_INVALIDARG);
+			return E_INVALIDARG;
+		}
+		if (count == 0) {
+			return S_OK;
+		}
+
+		DeviceItem** ppDItems = new DeviceItem*[count];
+		if (ppDItems == NULL) {
+			for (int i = 0; i < count; i++) {
+				VariantClear(&items[i].InitValue);
+			}
+			LOGFMTE("AddItems() failed with hres = 0x%x.", E_OUTOFMEMORY);
+			return E_OUTOFMEMORY;
+		}
+
+		for (int i = 0; i < count; i++) {
+			errors[i] = CreateItemInstance(
+				items[i].ItemId,						// ItemId
+				(DWORD)items[i].AccessRights,			// DaAccessRights
+				&items[i].InitValue,					// Initial Value
+				items[i].Active,						// Active State
+				(OPCEUTYPE)items[i].EuType,				// EU Type
+				items[i].MinValue,						// LOW EU range
+				items[i].MaxValue,						// HI EU range
+				&ppDItems[i]
+				);
+			if (FAILED(errors[i])) {
+				fCreateFailed = TRUE;
+			}
+			VariantClear(&items[i].InitValue);
+		}
+
+		hres = gpDataServer->AddDeviceItems((DWORD)count, ppDItems, errors);
+		if (hres == S_OK && fCreateFailed) {
+			hres = S_FALSE;
+		}
+
+		if (deviceItemHandles != NULL) {
+			for (int i = 0; i < count; i++) {
+				deviceItemHandles[i] = ppDItems[i];	// NULL if not added
+			}
+		}
+		delete[] ppDItems;
+		LOGFMTT("AddItems() finished with hres = 0x%x.", hres);
+		return hres;
+	}
+
 	HRESULT DLLCALL RemoveItem(void* deviceItem)
 	{
 		HRESULT			hres = E_FAIL;
@@ -172,28 +238,109 @@ namespace IClassicBaseNodeManager
 		DeviceItem*  pItem = (DeviceItem*)deviceItem;
 
 		LOGFMTT("SetItemValue() called from plugin.");
-		gpDataServer->readWriteLock_.BeginWriting();	// We are manipulating the DeviceItem make
-		// sure no one else gets access during update.
+		// No server wide lock: the cache of the item is protected by
+		// the item itself, so updates of different items run in parallel.
+		// Same error codes as SetItemValues()
 		if (pItem == NULL) {
-			gpDataServer->readWriteLock_.EndWriting(); // UnLock DeviceItem
-			hres = S_FALSE;
-			LOGFMTE("AddProperty() failed with hres = 0x%x (deviceItem not found).", hres);
+			hres = OPC_E_INVALIDHANDLE;
+			LOGFMTE("SetItemValue() failed with hres = 0x%x (deviceItem not found).", hres);
 			return(hres);
 		}
 
-		if (newValue == NULL || V_VT(newValue) == VT_NULL) {
+		if (newValue == NULL || V_VT(newValue) == VT_EMPTY || V_VT(newValue) == VT_NULL) {
 			// Update only quality and time stamp
 			hres = pItem->set_ItemQuality(quality, &timestamp);
 		}
 		else {
 			hres = pItem->set_ItemValue(newValue, quality, &timestamp);
 		}
-		gpDataServer->readWriteLock_.EndWriting();     // UnLock DeviceItem
 
 		LOGFMTT("SetItemValue() finished with hres = 0x%x.", hres);
 		return hres;
 	}
 
+	// Number of handles converted to Device Items on the stack
+#define SETITEMVALUES_BLOCK 256
+
+	static HRESULT SetItemValuesInBlocks(
+		int				count,
+		void**			deviceItems,
+		LPVARIANT		newValues,
+		short*			qualities,
+		FILETIME*		timestamps,
+		HRESULT*		errors
+		)
+	{
+		DaDeviceItem*	apItems[SETITEMVALUES_BLOCK];
+		HRESULT			hres = S_OK;
+
+		if (count < 0 || (count > 0 && (deviceItems == NULL || qualities == NULL || errors == NULL))) {
+			return E_INVALIDARG;
+		}
+
+		for (int i = 0; i < count; i += SETITEMVALUES_BLOCK) {
+			DWORD dwBlock = (DWORD)min(count - i, SETITEMVALUES_BLOCK);
+			for (DWORD b = 0; b < dwBlock; b++) {
+				apItems[b] = (DeviceItem*)deviceItems[i + b];
+			}
+			// The data types are checked in one pass and the current time
+			// is determined once per block if no time stamps are specified.
+			HRESULT hresBlock = DaDeviceItem::SetItemValues(
+				dwBlock,
+				apItems,
+				newValues ? &newValues[i] : NULL,
+				(WORD*)&qualities[i],
+				timestamps ? &timestamps[i] : NULL,
+				&errors[i]);
+			if (FAILED(hresBlock)) {
+				return hresBlock;
+			}
+			if (hresBlock == S_FALSE) {
+				hres = S_FALSE;
+			}
+		}
+		return hres;
+	}
+
+	HRESULT DLLCALL SetItemValues(
+		int				count,
+		void**			deviceItems,
+		LPVARIANT		newValues,
+		short*			qualities,
+		FILETIME*		timestamps,
+		HRESULT*		errors
+		)
+	{
+		HRESULT			hres;
+
+		LOGFMTT("SetItemValues() called from plugin for %d items.", count);
+		if (count > 0 && newValues == NULL) {
+			hres = E_INVALIDARG;
+		}
+		else {
+			hres = SetItemValuesInBlocks(count, deviceItems, newValues, qualities, timestamps, errors);
+		}
+		LOGFMTT("SetItemValues() finished with hres = 0x%x.", hres);
+		return hres;
+	}
+
+	HRESULT DLLCALL SetItemQualities(
+		int				count,
+		void**			deviceItems,
+		short*			qualities,
+		FILETIME*		timestamps,
+		HRESULT*		errors
+		)
+	{
+		HRESULT			hres;
+
+		LOGFMTT("SetItemQualities() called from plugin for %d items.", count);
+		// Update only quality and time stamp
+		hres = SetItemValuesInBlocks(count, deviceItems, NULL, qualities, timestamps, errors);
+		LOGFMTT("SetItemQualities() finished with hres = 0x%x.", hres);
+		return hres;
+	}
+
 	void DLLCALL SetServerState(ServerState serverState)
 	{
 		LOGFMTT("SetServerState() called from plugin.");
@@ -36,6 +36,7 @@
 #include "OpcTextReader.h"
 #include "CoreGenericMain.h"
 #include "Logger.h"
+#include "OpcClock.h"
 
 #include <iostream>
 #include <string>
@@ -335,6 +336,10 @@ extern "C" int WINAPI _tWinMain(HINSTANCE hInstance,
         }
 #endif
 
+        // Time stamps of OpcClockCoarse() are read from the ticker
+        if (FAILED(OpcClockStartTicker())) {
+            LOGFMTW("Clock ticker not started, time stamps are read from the system time.");
+        }
         if (SUCCEEDED(hres)) {
             hres = core_generic_main.InitializeServer();
         }
@@ -349,6 +354,7 @@ extern "C" int WINAPI _tWinMain(HINSTANCE hInstance,
             ::OnTerminateServer();						// Call global OnTerminateServer
 #endif
         }
+        OpcClockStopTicker();
     }
     else
     {
@@ -28,109 +28,437 @@ inline int ConvertCase( int c, BOOL bCaseSensitive )
 	return bCaseSensitive ? c : toupper(c);
 }
 
+static size_t PatternLength( const MCHAR* Pattern )
+{
+	size_t nLen = 0;
+	while (Pattern[nLen]) {
+		nLen++;
+	}
+	return nLen;
+}
 
 
-//*************************************************************************          
-// return TRUE if String Matches Pattern -- 
-// -- uses Visual Basic LIKE operator syntax
-// CAUTION: Function is recursive
-//*************************************************************************          
-BOOL MatchPattern( const MCHAR *String, const MCHAR *Pattern, BOOL bCaseSensitive )
-{ 
-	if( !String )
+
+//-------------------------------------------------------------------------
+// CODE CompiledPattern
+//-------------------------------------------------------------------------
+
+//=========================================================================
+// Constructor
+//=========================================================================
+CompiledPattern::CompiledPattern()
+{
+	m_fCompiled = FALSE;
+	m_fMatchAll = FALSE;
+	m_fCaseSensitive = FALSE;
+	m_pElements = NULL;
+	m_pRanges = NULL;
+	m_pdwSegments = NULL;
+	m_dwSegments = 0;
+}
+
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+CompiledPattern::~CompiledPattern()
+{
+	Cleanup();
+}
+
+
+
+//=========================================================================
+// Cleanup
+//=========================================================================
+void CompiledPattern::Cleanup( void )
+{
+	delete [] m_pElements;
+	delete [] m_pRanges;
+	delete [] m_pdwSegments;
+	m_pElements = NULL;
+	m_pRanges = NULL;
+	m_pdwSegments = NULL;
+	m_dwSegments = 0;
+	m_fCompiled = FALSE;
+	m_fMatchAll = FALSE;
+}
+
+
+
+//=========================================================================
+// Compile
+// -------
+//    Translates the pattern into segments of elements. The syntax is
+//    interpreted exactly as by the former recursive implementation of
+//    MatchPattern():
+//
+//    - Each character of a character list is a member of the list; a
+//      '-' adds the range from the previous character (0 at the start
+//      of the list) to the next character.
+//    - A '-' followed by ']' or the end of the pattern is a syntax
+//      error. The list then contains only the characters in front of
+//      the error and a negated list ([!...]) matches no character.
+//    - A character list without ']' matches no character.
+//=========================================================================
+HRESULT CompiledPattern::Compile( const MCHAR* Pattern, BOOL bCaseSensitive )
+{
+	Cleanup();
+	m_fCaseSensitive = bCaseSensitive;
+
+	if (!Pattern) {
+		m_fMatchAll = TRUE;
+		m_fCompiled = TRUE;
+		return S_OK;
+	}
+
+	// Upper limits: one element and at most two ranges per character
+	// of the pattern, one segment per '*'.
+	size_t nLen = PatternLength( Pattern );
+	m_pElements = new ELEMENT[nLen + 1];
+	m_pRanges = new RANGE[2 * nLen + 1];
+	m_pdwSegments = new DWORD[nLen + 2];
+	if (!m_pElements || !m_pRanges || !m_pdwSegments) {
+		Cleanup();
+		return E_OUTOFMEMORY;
+	}
+
+	DWORD    dwElements = 0;
+	DWORD    dwRanges = 0;
+	MCHAR    p, l;
+
+	m_pdwSegments[m_dwSegments++] = 0;
+	while ((p = ConvertCase( *Pattern++, bCaseSensitive )) != 0) {
+
+		if (p == _M('*')) {                    // Starts a new segment
+			m_pdwSegments[m_dwSegments++] = dwElements;
+			continue;
+		}
+
+		ELEMENT* pElem = &m_pElements[dwElements++];
+		switch (p)
+		{
+		case _M('?'):
+			pElem->nType = ELEM_ANY;
+			break;
+
+		case _M('#'):
+			pElem->nType = ELEM_DIGIT;
+			break;
+
+		case _M('['):
+			pElem->nType = ELEM_LIST;
+			if (*Pattern == _M('!')) {          // match a char if NOT in list []
+				pElem->nType = ELEM_NOTLIST;
+				++Pattern;
+			}
+			pElem->dwFirstRange = dwRanges;
+			l = 0;
+			for (;;) {
+				p = ConvertCase( *Pattern, bCaseSensitive );
+				if (p == 0) {                    // not terminated
+					pElem->nType = ELEM_NONE;
+					break;
+				}
+				++Pattern;
+				if (p == _M(']')) {              // end of list
+					break;
+				}
+				if (p == _M('-')) {              // range of chars
+					p = ConvertCase( *Pattern, bCaseSensitive );   // get high limit of range
+					if (p == 0 || p == _M(']')) {
+						// Syntax error: a not terminated list or a
+						// negated list match no character.
+						if (p == 0 || pElem->nType == ELEM_NOTLIST) {
+							pElem->nType = ELEM_NONE;
+						}
+						if (p) {
+							++Pattern;
+						}
+						break;
+					}
+					m_pRanges[dwRanges].cLow = l;
+					m_pRanges[dwRanges].cHigh = p;
+					dwRanges++;
+				}
+				l = p;                           // the high limit of a range is
+				m_pRanges[dwRanges].cLow = p;    // also a member of the list
+				m_pRanges[dwRanges].cHigh = p;
+				dwRanges++;
+			}
+			pElem->dwRanges = dwRanges - pElem->dwFirstRange;
+			break;
+
+		default:
+			pElem->nType = ELEM_CHAR;
+			pElem->c = p;
+			break;
+		}
+	}
+	m_pdwSegments[m_dwSegments] = dwElements;  // end of the last segment
+
+	m_fCompiled = TRUE;
+	return S_OK;
+}
+
+
+
+//=========================================================================
+// Match
+// -----
+//    The first and the last segment are anchored at the start and the
+//    end of the string. Each segment in between is searched at the
+//    leftmost position behind the previous segment. Because all
+//    elements match exactly one character any other solution can be
+//    shifted to these positions, so no backtracking is required.
+//=========================================================================
+BOOL CompiledPattern::Match( const MCHAR* String ) const
+{
+	if (!String || !m_fCompiled) {
 		return FALSE;
-	if( !Pattern )
+	}
+	if (m_fMatchAll) {
 		return TRUE;
-	MCHAR   c, p, l;
-	for (; ;)
+	}
+
+	// The first segment is tested before the length of the string is
+	// known, most strings are rejected there.
+	size_t nFirst = SegmentLength( 0 );
+	for (size_t i = 0; i < nFirst; i++) {
+		if (String[i] == 0) {
+			return FALSE;                        // Shorter than the first segment
+		}
+	}
+	if (!MatchSegment( 0, String )) {
+		return FALSE;
+	}
+
+	DWORD  dwLast = m_dwSegments - 1;
+	if (dwLast == 1 && SegmentLength( dwLast ) == 0) {
+		return TRUE;                             // Only a '*' behind the first segment
+	}
+
+	size_t nLen = PatternLength( String );
+	if (m_dwSegments == 1) {                   // No '*'
+		return nLen == nFirst;
+	}
+
+	size_t nEnd = nLen - SegmentLength( dwLast );  // start of the last segment
+	if (nLen < nFirst + SegmentLength( dwLast ) ||
+		!MatchSegment( dwLast, &String[nEnd] )) {
+		return FALSE;
+	}
+
+	size_t nPos = nFirst;
+	for (DWORD dwSeg = 1; dwSeg < dwLast; dwSeg++) {
+		size_t nSeg = SegmentLength( dwSeg );
+		for (;;) {
+			if (nPos + nSeg > nEnd) {
+				return FALSE;                    // Not enough characters left
+			}
+			if (MatchSegment( dwSeg, &String[nPos] )) {
+				break;
+			}
+			nPos++;
+		}
+		nPos += nSeg;
+	}
+	return TRUE;
+}
+
+
+
+//=========================================================================
+// MatchSegment
+// ------------
+//    Tests if the elements of the segment match the characters at the
+//    specified position. The caller ensures that there are enough
+//    characters.
+//=========================================================================
+BOOL CompiledPattern::MatchSegment( DWORD dwSegment, const MCHAR* String ) const
+{
+	const ELEMENT* pElem = &m_pElements[m_pdwSegments[dwSegment]];
+	const ELEMENT* pEnd = &m_pElements[m_pdwSegments[dwSegment + 1]];
+
+	for (; pElem < pEnd; pElem++, String++) {
+		if (!MatchElement( pElem, *String )) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+
+
+//=========================================================================
+// MatchElement
+//=========================================================================
+BOOL CompiledPattern::MatchElement( const ELEMENT* pElem, MCHAR c ) const
+{
+	switch (pElem->nType)
 	{
-		switch (p = ConvertCase( *Pattern++, bCaseSensitive ) )
+	case ELEM_CHAR:
+		return (MCHAR)ConvertCase( c, m_fCaseSensitive ) == pElem->c;
+
+	case ELEM_ANY:
+		return TRUE;
+
+	case ELEM_DIGIT:
+		return _ismdigit( c ) ? TRUE : FALSE;
+
+	case ELEM_LIST:
+	case ELEM_NOTLIST:
 		{
-		case 0:                             // end of pattern
-			return *String ? FALSE : TRUE;  // if end of string TRUE
-
-		case _M('*'):
-			while (*String) 
-			{               // match zero or more char
-				if (MatchPattern (String++, Pattern, bCaseSensitive))
-					return TRUE; 
+			c = (MCHAR)ConvertCase( c, m_fCaseSensitive );
+			const RANGE* pRange = &m_pRanges[pElem->dwFirstRange];
+			for (DWORD i = 0; i < pElem->dwRanges; i++, pRange++) {
+				if (c >= pRange->cLow && c <= pRange->cHigh) {
+					return (pElem->nType == ELEM_LIST);
+				}
 			}
-			return MatchPattern (String, Pattern, bCaseSensitive );
+			return (pElem->nType == ELEM_NOTLIST);
+		}
 
-		case _M('?'):
-			if (*String++ == 0)             // match any one char 
-				return FALSE;                   // not end of string 
-			break; 
-
-		case _M('['): 
-			if ( (c = ConvertCase( *String++, bCaseSensitive) ) == 0)      // match char set 
-				return FALSE;                   // syntax 
-			l = 0; 
-			if( *Pattern == _M('!') )  // match a char if NOT in set []
-			{
-				++Pattern;
+	default:                                   // ELEM_NONE
+		return FALSE;
+	}
+}
 
-				while( (p = ConvertCase( *Pattern++, bCaseSensitive) ) != _M('\0') ) 
-				{
-					if (p == _M(']'))               // if end of char set, then 
-						break;           // no match found 
-
-					if (p == _M('-')) 
-					{            // check a range of chars? 
-						p = ConvertCase( *Pattern, bCaseSensitive );   // get high limit of range 
-						if (p == 0  ||  p == _M(']')) 
-							return FALSE;           // syntax 
-
-						if (c >= l  &&  c <= p) 
-							return FALSE;              // if in range, return FALSE 
-					} 
-					l = p;
-					if (c == p)                 // if char matches this element 
-						return FALSE;                  // return false 
-				} 
-			}
-			else	// match if char is in set []
-			{
-				while( (p = ConvertCase( *Pattern++, bCaseSensitive) ) != _M('\0') ) 
-				{
-					if (p == _M(']'))               // if end of char set, then 
-						return FALSE;           // no match found 
-
-					if (p == _M('-')) 
-					{            // check a range of chars? 
-						p = ConvertCase( *Pattern, bCaseSensitive );   // get high limit of range 
-						if (p == 0  ||  p == _M(']')) 
-							return FALSE;           // syntax 
-
-						if (c >= l  &&  c <= p) 
-							break;              // if in range, move on 
-					} 
-					l = p;
-					if (c == p)                 // if char matches this element 
-						break;                  // move on 
-				} 
-
-				while (p  &&  p != _M(']'))         // got a match in char set 
-					p = *Pattern++;             // skip to end of set 
-			}
 
-			break; 
 
-		case _M('#'):
-			c = *String++; 
-			if( !_ismdigit( c ) )
-				return FALSE;		// not a digit
+//-------------------------------------------------------------------------
+// CODE MatchPattern
+//-------------------------------------------------------------------------
 
-			break;
+               // Number of compiled patterns kept by MatchPattern()
+#define  MATCHPATTERN_CACHE_SIZE    16
+
+               // A compiled pattern in the cache
+typedef struct tagCACHEDPATTERN {
+	volatile LONG     lRefs;                  // one for the cache and one per user
+	BOOL              fCaseSensitive;
+	size_t            nSize;                  // size of the pattern in bytes
+	MCHAR*            pszPattern;
+	CompiledPattern   Program;
+} CACHEDPATTERN;
+
+
+/////////////////////////////////////////////////////////////////
+// Cache of the recently used patterns. The patterns are
+// replaced in the order they were added. A pattern is tested
+// without lock; the lock is only held to find an entry.
+/////////////////////////////////////////////////////////////////
+class PatternCache {
+
+public:
+	PatternCache()
+	{
+		InitializeCriticalSection( &m_CritSec );
+		memset( m_apEntries, 0, sizeof (m_apEntries) );
+		m_dwNext = 0;
+	}
+
+	~PatternCache()
+	{
+		for (DWORD i = 0; i < MATCHPATTERN_CACHE_SIZE; i++) {
+			Release( m_apEntries[i] );
+		}
+		DeleteCriticalSection( &m_CritSec );
+	}
+
+	CACHEDPATTERN* Get( const MCHAR* Pattern, BOOL bCaseSensitive );
+	static void Release( CACHEDPATTERN* pEntry );
+
+private:
+	CRITICAL_SECTION  m_CritSec;
+	CACHEDPATTERN*    m_apEntries[MATCHPATTERN_CACHE_SIZE];
+	DWORD             m_dwNext;               // entry replaced by the next new pattern
+};
+
+static PatternCache gPatternCache;
+
+
+
+//=========================================================================
+// PatternCache::Get
+// -----------------
+//    Returns the compiled pattern or NULL if out of memory. The
+//    returned entry must be released with Release().
+//=========================================================================
+CACHEDPATTERN* PatternCache::Get( const MCHAR* Pattern, BOOL bCaseSensitive )
+{
+	size_t nSize = (PatternLength( Pattern ) + 1) * sizeof (MCHAR);
+
+	EnterCriticalSection( &m_CritSec );
+	for (DWORD i = 0; i < MATCHPATTERN_CACHE_SIZE; i++) {
+		CACHEDPATTERN* pEntry = m_apEntries[i];
+		if (pEntry && pEntry->fCaseSensitive == bCaseSensitive && pEntry->nSize == nSize &&
+			memcmp( pEntry->pszPattern, Pattern, nSize ) == 0) {
+			InterlockedIncrement( &pEntry->lRefs );
+			LeaveCriticalSection( &m_CritSec );
+			return pEntry;
+		}
+	}
+	LeaveCriticalSection( &m_CritSec );
+
+	// Not found; compile without lock
+	CACHEDPATTERN* pEntry = new CACHEDPATTERN;
+	if (!pEntry) {
+		return NULL;
+	}
+	pEntry->lRefs = 2;                         // the cache and the caller
+	pEntry->fCaseSensitive = bCaseSensitive;
+	pEntry->nSize = nSize;
+	pEntry->pszPattern = new MCHAR[nSize / sizeof (MCHAR)];
+	if (!pEntry->pszPattern || FAILED( pEntry->Program.Compile( Pattern, bCaseSensitive ) )) {
+		delete [] pEntry->pszPattern;
+		delete pEntry;
+		return NULL;
+	}
+	memcpy( pEntry->pszPattern, Pattern, nSize );
+
+	EnterCriticalSection( &m_CritSec );
+	Release( m_apEntries[m_dwNext] );
+	m_apEntries[m_dwNext] = pEntry;
+	m_dwNext = (m_dwNext + 1) % MATCHPATTERN_CACHE_SIZE;
+	LeaveCriticalSection( &m_CritSec );
+	return pEntry;
+}
+
+
+
+//=========================================================================
+// PatternCache::Release
+//=========================================================================
+void PatternCache::Release( CACHEDPATTERN* pEntry )
+{
+	if (pEntry && InterlockedDecrement( &pEntry->lRefs ) == 0) {
+		delete [] pEntry->pszPattern;
+		delete pEntry;
+	}
+}
+
+
+
+//*************************************************************************          
+// return TRUE if String Matches Pattern -- 
+// -- uses Visual Basic LIKE operator syntax
+//*************************************************************************          
+BOOL MatchPattern( const MCHAR *String, const MCHAR *Pattern, BOOL bCaseSensitive )
+{ 
+	if( !String )
+		return FALSE;
+	if( !Pattern )
+		return TRUE;
 
-		default: 
-			c = ConvertCase( *String++, bCaseSensitive ); 
-			if( c != p )            // check for exact char 
-				return FALSE;                   // not a match 
+	CACHEDPATTERN* pEntry = gPatternCache.Get( Pattern, bCaseSensitive );
+	if (!pEntry)
+		return FALSE;                           // out of memory
 
-			break; 
-		} 
-	} 
+	BOOL fMatch = pEntry->Program.Match( String );
+	PatternCache::Release( pEntry );
+	return fMatch;
 } 
 
 //DOM-IGNORE-END
@@ -51,8 +51,85 @@
 
 
 
+         ///////////////////////////////////////////////////////////////
+         //  Returns TRUE if the string matches the pattern. Uses the
+         //  Visual Basic LIKE operator syntax. The pattern is compiled
+         //  once and kept in a small cache of recently used patterns.
+         ///////////////////////////////////////////////////////////////
 extern BOOL  MatchPattern( const MCHAR* String, const MCHAR * Pattern, BOOL bCaseSensitive = FALSE );
 
+
+
+/////////////////////////////////////////////////////////////////
+// Compiled Pattern
+// ----------------
+// A pattern of MatchPattern() translated into a program which
+// tests strings without recursion.
+//
+// The '*' wildcards split the pattern into segments of single
+// character elements (character, '?', '#' and character list).
+// The first segment must match the start of the string and the
+// last segment the end of the string; the segments in between are
+// searched from left to right, each at the leftmost position after
+// the previous one. No segment is tested twice at the same string
+// position, so the time is linear in the length of the string
+// (at most string length * segment length element tests).
+//
+// Use an instance to test many strings with the same pattern.
+/////////////////////////////////////////////////////////////////
+class CompiledPattern {
+
+   public:
+      CompiledPattern();
+      ~CompiledPattern();
+
+         ///////////////////////////////////////////////////////////////
+         //  Translates the pattern. A NULL pattern matches all
+         //  strings. Returns S_OK or E_OUTOFMEMORY; if it fails then
+         //  no string matches.
+         ///////////////////////////////////////////////////////////////
+      HRESULT Compile( const MCHAR* Pattern, BOOL bCaseSensitive = FALSE );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns TRUE if the string matches the pattern; same
+         //  result as MatchPattern(). A NULL string never matches.
+         ///////////////////////////////////////////////////////////////
+      BOOL Match( const MCHAR* String ) const;
+
+   private:
+               // Types of the elements
+      enum { ELEM_CHAR, ELEM_ANY, ELEM_DIGIT, ELEM_LIST, ELEM_NOTLIST, ELEM_NONE };
+
+               // Matches one character of the string
+      typedef struct tagELEMENT {
+         int            nType;
+         MCHAR          c;                // ELEM_CHAR: the character
+         DWORD          dwFirstRange;     // ELEM_LIST, ELEM_NOTLIST: the ranges
+         DWORD          dwRanges;         //    in m_pRanges
+      } ELEMENT;
+
+               // Characters of a character list; single characters
+               // have cLow == cHigh
+      typedef struct tagRANGE {
+         MCHAR          cLow;
+         MCHAR          cHigh;
+      } RANGE;
+
+      BOOL           m_fCompiled;
+      BOOL           m_fMatchAll;         // NULL pattern
+      BOOL           m_fCaseSensitive;
+      ELEMENT        *m_pElements;        // the elements of all segments
+      RANGE          *m_pRanges;
+      DWORD          *m_pdwSegments;      // index of the first element of each segment
+      DWORD          m_dwSegments;        // followed by the number of elements
+
+      void Cleanup( void );
+      BOOL MatchElement( const ELEMENT* pElem, MCHAR c ) const;
+      BOOL MatchSegment( DWORD dwSegment, const MCHAR* String ) const;
+      DWORD SegmentLength( DWORD dwSegment ) const
+               { return m_pdwSegments[dwSegment + 1] - m_pdwSegments[dwSegment]; }
+};
+
 //DOM-IGNORE-END
 
 #endif
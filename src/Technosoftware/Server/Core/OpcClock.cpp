@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+//DOM-IGNORE-BEGIN
+
+//-----------------------------------------------------------------------
+// INCLUDE
+//-----------------------------------------------------------------------
+#include "stdafx.h"
+#include <time.h>
+#include <process.h>
+#include "OpcClock.h"
+
+//-----------------------------------------------------------------------
+// DEFINES
+//-----------------------------------------------------------------------
+                                       // 100 ns intervals between 1601 and 1970
+#define  OPCCLOCK_EPOCH_DIFFERENCE  116444736000000000ULL
+
+typedef VOID (WINAPI *PFNGETSYSTEMTIME)( LPFILETIME );
+
+                                       // Resolved with the first call
+static PFNGETSYSTEMTIME gpfnPreciseTime = NULL;
+
+volatile LONGLONG gllOpcClockCached = 0;
+
+                                       // Ticker thread
+static HANDLE  ghTickerThread = NULL;
+static HANDLE  ghTickerStop   = NULL;
+static DWORD   gdwTickerInterval;
+
+                                       // Local time of the last converted second
+                                       // of the calling thread
+static __declspec(thread) time_t  gtLocalTimeSecond = (time_t)-1;
+static __declspec(thread) struct tm gLocalTime;
+
+//-----------------------------------------------------------------------
+// CODE
+//-----------------------------------------------------------------------
+
+//=========================================================================
+// OpcClockPrecise
+// ---------------
+//    GetSystemTimePreciseAsFileTime() is only available since Windows 8
+//    and is therefore loaded dynamically. Concurrent first calls resolve
+//    the same address.
+//=========================================================================
+void OpcClockPrecise( FILETIME* pft )
+{
+   PFNGETSYSTEMTIME pfn = gpfnPreciseTime;
+
+   if (pfn == NULL) {
+      HMODULE hKernel = GetModuleHandleW( L"kernel32.dll" );
+      if (hKernel) {
+         pfn = (PFNGETSYSTEMTIME)GetProcAddress( hKernel, "GetSystemTimePreciseAsFileTime" );
+      }
+      if (pfn == NULL) {
+         pfn = GetSystemTimeAsFileTime;
+      }
+      gpfnPreciseTime = pfn;
+   }
+   pfn( pft );
+}
+
+
+
+//=========================================================================
+// Ticker Thread
+// -------------
+//    Caches the system time until the stop event is signaled. The
+//    wait times out with the resolution of the system timer, so the
+//    cache is updated at least as often as the system time changes
+//    if the interval is not longer than the clock tick.
+//=========================================================================
+static unsigned __stdcall OpcClockTickerThread( void* )
+{
+   FILETIME ft;
+
+   do {
+      GetSystemTimeAsFileTime( &ft );
+      gllOpcClockCached = ((LONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+   } while (WaitForSingleObject( ghTickerStop, gdwTickerInterval ) == WAIT_TIMEOUT);
+
+   _endthreadex( 0 );
+   return 0;
+}
+
+
+
+//=========================================================================
+// OpcClockStartTicker
+// -------------------
+//    Not thread safe; called once at server startup.
+//=========================================================================
+HRESULT OpcClockStartTicker( DWORD dwIntervalMs /* = 1 */ )
+{
+#ifdef OPCCLOCK_TICKER
+   if (ghTickerThread) {
+      return S_FALSE;                           // Already running
+   }
+   ghTickerStop = CreateEvent( NULL, TRUE, FALSE, NULL );
+   if (ghTickerStop == NULL) {
+      return HRESULT_FROM_WIN32( GetLastError() );
+   }
+   gdwTickerInterval = dwIntervalMs;
+
+   FILETIME ft;                                 // Valid before the thread runs
+   GetSystemTimeAsFileTime( &ft );
+   gllOpcClockCached = ((LONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+
+   unsigned uThreadID;
+   ghTickerThread = (HANDLE)_beginthreadex( NULL, 0, OpcClockTickerThread, NULL, 0, &uThreadID );
+   if (ghTickerThread == NULL) {
+      gllOpcClockCached = 0;
+      CloseHandle( ghTickerStop );
+      ghTickerStop = NULL;
+      return E_FAIL;
+   }
+   return S_OK;
+#else
+   (void)dwIntervalMs;
+   return S_FALSE;                              // Not supported with 32 bit
+#endif
+}
+
+
+
+//=========================================================================
+// OpcClockStopTicker
+// ------------------
+//=========================================================================
+void OpcClockStopTicker( void )
+{
+   if (ghTickerThread == NULL) {
+      return;
+   }
+   SetEvent( ghTickerStop );
+   WaitForSingleObject( ghTickerThread, INFINITE );
+   gllOpcClockCached = 0;                       // The system time is read again
+   CloseHandle( ghTickerThread );
+   CloseHandle( ghTickerStop );
+   ghTickerThread = NULL;
+   ghTickerStop   = NULL;
+}
+
+
+
+//=========================================================================
+// OpcClockToLocalTime
+// -------------------
+//=========================================================================
+void OpcClockToLocalTime( const FILETIME* pft, struct tm* ptm, unsigned* pMilliseconds )
+{
+   ULONGLONG   ullTime;
+   time_t      tSecond;
+
+   ullTime = ((ULONGLONG)pft->dwHighDateTime << 32) | pft->dwLowDateTime;
+   ullTime = (ullTime - OPCCLOCK_EPOCH_DIFFERENCE) / 10000;    // ms since 1970
+   tSecond = (time_t)(ullTime / 1000);
+
+   if (tSecond != gtLocalTimeSecond) {          // Only once per second
+      struct tm tmNew = {};
+      localtime_s( &tmNew, &tSecond );
+      gLocalTime        = tmNew;
+      gtLocalTimeSecond = tSecond;
+   }
+   *ptm           = gLocalTime;
+   *pMilliseconds = (unsigned)(ullTime % 1000);
+}
+//DOM-IGNORE-END
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+#ifndef __OPCCLOCK_H_
+#define __OPCCLOCK_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+#include <windows.h>
+
+/////////////////////////////////////////////////////////////////
+// Clock
+// -----
+// Current time (UTC) for the whole server: item time stamps,
+// update times, event times and log records.
+//
+// OpcClockCoarse() returns the system time with the resolution of
+// the clock tick of the operating system (typically 1 - 15.6 ms).
+// While the clock ticker runs (see OpcClockStartTicker()) it only
+// reads the time which the ticker thread caches at each interval;
+// otherwise it reads the system time like CoFileTimeNow(). The
+// cached time lags by up to one interval of the ticker, which is
+// not more than the resolution of the system time itself.
+// It is the cheap choice for all time stamps which are taken per
+// value or per request.
+//
+// OpcClockPrecise() returns the system time with the resolution
+// of the performance counter (< 1 us) if the operating system
+// supports it (Windows 8 or later); otherwise it is the same as
+// OpcClockCoarse() without the ticker.
+/////////////////////////////////////////////////////////////////
+
+#if defined(_WIN64) || defined(__LP64__)
+#define OPCCLOCK_TICKER                // 64 bit reads are atomic
+#endif
+
+                                       // Time cached by the ticker thread
+                                       // in 100 ns intervals since 1601;
+                                       // 0 if the ticker is not running
+extern volatile LONGLONG gllOpcClockCached;
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the current time with the resolution of the
+         //  system clock tick.
+         ///////////////////////////////////////////////////////////////
+inline void OpcClockCoarse( FILETIME* pft )
+{
+#ifdef OPCCLOCK_TICKER
+   LONGLONG llCached = gllOpcClockCached;
+   if (llCached != 0) {
+      pft->dwLowDateTime  = (DWORD)llCached;
+      pft->dwHighDateTime = (DWORD)(llCached >> 32);
+      return;
+   }
+#endif
+   GetSystemTimeAsFileTime( pft );
+}
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the current time with the highest resolution
+         //  supported by the operating system.
+         ///////////////////////////////////////////////////////////////
+void OpcClockPrecise( FILETIME* pft );
+
+         ///////////////////////////////////////////////////////////////
+         //  Starts the thread which caches the system time for
+         //  OpcClockCoarse() every dwIntervalMs milliseconds.
+         //  Returns S_FALSE if the ticker already runs or is not
+         //  supported on this platform (32 bit).
+         ///////////////////////////////////////////////////////////////
+HRESULT OpcClockStartTicker( DWORD dwIntervalMs = 1 );
+
+         ///////////////////////////////////////////////////////////////
+         //  Stops the ticker thread; OpcClockCoarse() reads the
+         //  system time again.
+         ///////////////////////////////////////////////////////////////
+void OpcClockStopTicker( void );
+
+         ///////////////////////////////////////////////////////////////
+         //  Converts a time returned by the clock to the local time
+         //  in seconds (struct tm) and the milliseconds. The result
+         //  of the local time conversion is cached per thread, so
+         //  that only one conversion per second and thread is done.
+         ///////////////////////////////////////////////////////////////
+void OpcClockToLocalTime( const FILETIME* pft, struct tm* ptm, unsigned* pMilliseconds );
+
+//DOM-IGNORE-END
+
+
+#endif // __OPCCLOCK_H_
@@ -28,7 +28,7 @@
 #endif // _MSC_VER >= 1000
 
 #define WIN32_LEAN_AND_MEAN      // Exclude not used services from Windows headers.
-#define _WIN32_WINNT 0x0501
+#define _WIN32_WINNT 0x0600
 #define _ATL_APARTMENT_THREADED
 #define _ATL_STATIC_REGISTRY     // Forces static linking of the registar module.
 
@@ -25,6 +25,7 @@
 #include "stdafx.h"                             // Generic server part headers
 #include "MatchPattern.h"
 #include "DaDeviceItem.h"
+#include "DaStringArena.h"
 // Application specific definitions
 #include "DaAddressSpace.h"
 
@@ -35,6 +36,63 @@
 WCHAR DaBranch::m_szDelimiter[2] = L".";
 DaBranch* DaBranch::m_pRoot = NULL;
 
+// Pool with the interned names of all branches and leafs.
+static DaStringArena gNames;
+
+
+
+//=========================================================================
+// CompareName
+// -----------
+//    Compares a member name with a name specified by a pointer and a
+//    length, e.g. a segment of an ItemID. The result is the same as
+//    the one of wcscmp() with a copy of the segment.
+//=========================================================================
+static int CompareName( LPCWSTR szMemberName, LPCWSTR pName, size_t nLen )
+{
+	int iCmp = wcsncmp( szMemberName, pName, nLen );
+	if (iCmp == 0 && szMemberName[nLen] != 0) {
+		iCmp = 1;                                 // The member name is longer
+	}
+	return iCmp;
+}
+
+
+
+//=========================================================================
+// FindMember
+// ----------
+//    Binary search of a name in an array of branches or leafs sorted
+//    by name. The array must be locked by the caller.
+//
+// Return:
+//    TRUE if found and pIndex is the index of the member; otherwise
+//    FALSE and pIndex is the index at which the member is to be inserted.
+//=========================================================================
+template< class T >
+static BOOL FindMember( const CAtlArray<T*>& arMembers, LPCWSTR pName, size_t nLen, size_t* pIndex )
+{
+	size_t nLow = 0;
+	size_t nHigh = arMembers.GetCount();
+
+	while (nLow < nHigh) {
+		size_t nMid = nLow + (nHigh - nLow) / 2;
+		int iCmp = CompareName( arMembers[nMid]->Name(), pName, nLen );
+		if (iCmp == 0) {
+			*pIndex = nMid;
+			return TRUE;
+		}
+		if (iCmp < 0) {
+			nLow = nMid + 1;
+		}
+		else {
+			nHigh = nMid;
+		}
+	}
+	*pIndex = nLow;
+	return FALSE;
+}
+
 
 //-------------------------------------------------------------------------
 // CODE DaLeaf
@@ -45,6 +103,7 @@ DaBranch* DaBranch::m_pRoot = NULL;
 //=========================================================================
 DaLeaf::DaLeaf()
 {
+	m_szName = NULL;
 	m_pDItemRef = NULL;
 	m_fKillDeviceItemOnDestroy = FALSE;
 }
@@ -59,11 +118,11 @@ DaLeaf::DaLeaf()
 //=========================================================================
 HRESULT DaLeaf::Create( LPCWSTR szName, DaDeviceItem* pDItem )
 {
-	HRESULT hres = m_wsName.SetString( szName );
-	if (SUCCEEDED( hres )) {
-		m_pDItemRef = pDItem;
-	}
-	return hres;
+	m_szName = gNames.Intern( szName );
+	if (m_szName == NULL) return E_OUTOFMEMORY;
+
+	m_pDItemRef = pDItem;
+	return S_OK;
 }
 
 
@@ -153,6 +212,10 @@ HRESULT DaLeaf::IsDeviceItem( LPCWSTR szItemID )
 DaBranch::DaBranch()
 {
 	m_pParent   = NULL;
+	m_szName    = NULL;
+	// Without initialization the read/write locks do not lock.
+	m_csBranches.Initialize();
+	m_csLeafs.Initialize();
 }
 
 
@@ -168,9 +231,7 @@ HRESULT DaBranch::CreateAsRoot()
 	_ASSERTE( m_pRoot ==  NULL );                // Root object is already initialzed
 	if (m_pRoot) return E_FAIL;                  // Hint : InitializeAsRoot() call should be made only once!
 
-	HRESULT hres = m_wsName.SetString( L"" );
-	if (FAILED( hres )) return hres;
-
+	m_szName = L"";                              // The root has no name
 	m_pRoot = this;
 	return S_OK;
 }
@@ -188,6 +249,19 @@ DaBranch::~DaBranch()
 
 
 
+//=========================================================================
+// GetNameStatistics
+// -----------------
+//    Returns the counters of the pool with the interned names of all
+//    branches and leafs.
+//=========================================================================
+void DaBranch::GetNameStatistics( DASTRINGARENASTATS* pStats )
+{
+	gNames.GetStatistics( pStats );
+}
+
+
+
 //-------------------------------------------------------------------------
 // OPERATIONS
 //-------------------------------------------------------------------------
@@ -199,20 +273,10 @@ DaBranch::~DaBranch()
 //=========================================================================
 HRESULT DaBranch::AddBranch( LPCWSTR szBranchName, DaBranch** ppBranch )
 {
-	DaBranch* pDummyBranch;
-	HRESULT     hres;
-	// Check if the branch already exist
-	hres = ChangeBrowsePosition( OPC_BROWSE_DOWN, szBranchName, &pDummyBranch );
-	if (SUCCEEDED( hres )) return E_INVALIDARG;  // The branch already exist at this level.
-	if (hres != E_INVALIDARG) return hres;       // Other error.
-
-	*ppBranch = new DaBranch;                  // The branch does not yet exist. Create it.
-	if (*ppBranch == NULL) return E_OUTOFMEMORY;
-
-	hres = (*ppBranch)->Create( this, szBranchName );
-	if (FAILED( hres )) {
-		delete (*ppBranch);
+	HRESULT hres = InsertBranch( szBranchName, wcslen( szBranchName ), ppBranch );
+	if (hres == S_FALSE) {                       // The branch already exist at this level.
 		*ppBranch = NULL;
+		hres = E_INVALIDARG;
 	}
 	return hres;
 }
@@ -226,18 +290,20 @@ HRESULT DaBranch::AddBranch( LPCWSTR szBranchName, DaBranch** ppBranch )
 //=========================================================================
 HRESULT DaBranch::AddLeaf( LPCWSTR szLeafName, DaDeviceItem* pDItem )
 {
-	if (ExistLeaf( szLeafName )) {               // Check if the leaf already exist
-		return E_INVALIDARG;                      // The leaf already exist at this level.
-	}
-
-	DaLeaf* pLeaf = new DaLeaf;              // The leaf does not yet exist. Create it.
+	DaLeaf* pLeaf = new DaLeaf;
 	if (pLeaf == NULL) return E_OUTOFMEMORY;
 
 	HRESULT hres = pLeaf->Create( szLeafName, pDItem );
 	if (SUCCEEDED( hres )) {
 		m_csLeafs.BeginWriting();
 		try {
-			m_mapLeafs.SetAt( pLeaf->Name(), pLeaf );
+			size_t nIndex;
+			if (FindMember( m_arLeafs, szLeafName, wcslen( szLeafName ), &nIndex )) {
+				hres = E_INVALIDARG;              // The leaf already exist at this level.
+			}
+			else {
+				m_arLeafs.InsertAt( nIndex, pLeaf );
+			}
 		} catch (...) {
 			hres = E_OUTOFMEMORY;
 		}
@@ -277,68 +343,90 @@ HRESULT DaBranch::AddLeaf( LPCWSTR szLeafName, DaDeviceItem* pDItem )
 HRESULT DaBranch::AddDeviceItem( LPCWSTR szSASName, DaDeviceItem* pDItem )
 {
 	HRESULT     hres = S_OK;
-	LPWSTR      pLeafName = NULL;
-	DaBranch* pBranch = this;                  // Start at this level
-	WideString wsName;                          // Copy of the SASName parameter
-
-	hres = wsName.SetString( szSASName );        // Make a copy because the string
-	if (FAILED( hres )) return hres;             // is modified within this function.
+	DaBranch*   pBranch = this;                  // Start at this level
 
 	// Setup the pointer to the leaf name
-	pLeafName = wcsrchr( wsName, m_szDelimiter[0] );
+	LPCWSTR pLeafName = wcsrchr( szSASName, m_szDelimiter[0] );
 	if (!pLeafName) {
-		pLeafName = wsName;                       // Ther are no branches specified
+		pLeafName = szSASName;                    // Ther are no branches specified
 	}
 	else {                                       // There is at least one branch
-		*pLeafName = NULL;                        // Setup the pointer to the leaf and branch(es) name
+		if (!pLeafName[1]) return E_INVALIDARG;   // Invalid SASName format
+
+		// Goes to the specified position. Not existing branches are created.
+		hres = AddBranches( szSASName, pLeafName - szSASName, &pBranch );
+		if (FAILED( hres )) return hres;          // Brach creation failed.
 		pLeafName++;
-		if (!(*pLeafName)) return E_INVALIDARG;   // Invalid SASName format
+	}
+	// Add the leaf to the specified position.
+	return pBranch->AddLeaf( pLeafName, pDItem );
+}
 
-		LPWSTR   pBranchName = wsName;
-		WCHAR*   nextToken = NULL;
-		LPCWSTR  pName = NULL;
-		DaBranch* pNewBranch = NULL;
 
-		m_csBranches.BeginWriting();                      // Goes to the specified position.
-		try
-		{
-			// Not existing branches are created.
-			pName = wcstok_s( pBranchName, m_szDelimiter, &nextToken );
-			while (pName) {                           // Handle all defined branches.
-				// Move to next branch level
-				hres = pBranch->ChangeBrowsePosition( OPC_BROWSE_DOWN, pName, &pNewBranch );
-				if (FAILED( hres )) {
-					if (hres == E_INVALIDARG) {         // The Branch does not exist. Create it.
-						hres = pBranch->AddBranch( pName, &pNewBranch );
-						if (FAILED( hres )) {
-							break;                        // Brach creation failed.
-						}
-					}
-					else {
-						break;                           // Other error.
-					}
-				}
-				pBranch = pNewBranch;                  // Move to the new position.
-				// Get the name of the next branch.
-				pName = wcstok_s( NULL, m_szDelimiter, &nextToken ); 
+
+//=========================================================================
+// AddDeviceItems
+// --------------
+//    Adds several Device Items to the Server Address Space. Same as
+//    AddDeviceItem() for each item.
+//
+//    If the names are sorted then consecutive items of the same branch
+//    are added without walking down the hierarchy again and the leafs
+//    are appended to the end of the sorted leaf arrays.
+//
+// Parameters:
+//    IN
+//       dwCount                 Number of Device Items
+//       pszSASNames             Array with the Names in the Server
+//                               Address Space
+//       ppDItems                Array with the Device Items
+//    OUT
+//       pErrors                 Array with the result of each item
+//
+// Return:
+//    S_OK                       All items added
+//    S_FALSE                    At least one item failed, see pErrors
+//=========================================================================
+HRESULT DaBranch::AddDeviceItems( DWORD dwCount, LPCWSTR* pszSASNames, DaDeviceItem** ppDItems, HRESULT* pErrors )
+{
+	HRESULT     hresAll = S_OK;
+	DaBranch*   pBranch = NULL;                  // Branch of the previous item
+	LPCWSTR     szBranchName = NULL;             // Branch part of the name of the previous item
+	size_t      nBranchLen = 0;
+
+	for (DWORD i = 0; i < dwCount; i++) {
+		HRESULT hres = S_OK;
+		LPCWSTR szSASName = pszSASNames[i];
+		LPCWSTR pLeafName = wcsrchr( szSASName, m_szDelimiter[0] );
+		size_t  nLen = 0;                         // Length of the branch part of the name
+
+		if (!pLeafName) {
+			pLeafName = szSASName;                // Ther are no branches specified
+		}
+		else {
+			nLen = pLeafName - szSASName;
+			pLeafName++;
+		}
+		if (!(*pLeafName)) {
+			hres = E_INVALIDARG;                  // Invalid SASName format
+		}
+		// The branch is only searched if it differs from the one of the previous item
+		else if (pBranch == NULL || nLen != nBranchLen || wcsncmp( szSASName, szBranchName, nLen ) != 0) {
+			hres = AddBranches( szSASName, nLen, &pBranch );
+			if (SUCCEEDED( hres )) {
+				szBranchName = szSASName;
+				nBranchLen = nLen;
 			}
-		} 
-		catch (...) {
-			hres = E_FAIL;
 		}
-
-		m_csBranches.EndWriting();
-	}
-	// Add the leaf to the specified position.
-	if (SUCCEEDED( hres )) {
-		if (pBranch->ExistLeaf( pLeafName )) {    // Check if the leaf already exist.
-			hres = E_INVALIDARG;                   // The leaf already exist at this level.
+		if (SUCCEEDED( hres )) {
+			hres = pBranch->AddLeaf( pLeafName, ppDItems[i] );
 		}
-		else {                                    // The leaf does not exist at this level. Create it.
-			hres = pBranch->AddLeaf( pLeafName, pDItem );
+		pErrors[i] = hres;
+		if (FAILED( hres )) {
+			hresAll = S_FALSE;
 		}
 	}
-	return hres;
+	return hresAll;
 }
 
 
@@ -358,37 +446,30 @@ HRESULT DaBranch::AddDeviceItem( LPCWSTR szSASName, DaDeviceItem* pDItem )
 HRESULT DaBranch::FindDeviceItem( LPCWSTR szItemID, DaDeviceItem** ppDItem )
 {
 	HRESULT  hres = E_INVALIDARG;
-	POSITION pos;
 
 	*ppDItem = NULL;
 
-	DaBranch* pBranch;
-    m_csBranches.BeginReading();
-	try 
+	m_csBranches.BeginReading();
+	try
 	{
-		pos = m_mapBranches.GetStartPosition();
-		while (pos) {
-			pBranch = m_mapBranches.GetNextValue( pos );
-			hres = pBranch->FindDeviceItem( szItemID, ppDItem );
+		for (size_t i = 0; i < m_arBranches.GetCount(); i++) {
+			hres = m_arBranches[i]->FindDeviceItem( szItemID, ppDItem );
 			if (SUCCEEDED( hres )) {
 				break;
 			}
 		}
-	} 
+	}
 	catch (...) {
 		hres = E_FAIL;
 	}
 	m_csBranches.EndReading();
 
 	if (FAILED( hres )) {                        // Not found in branches
-		DaLeaf* pLeaf;
-
 		m_csLeafs.BeginReading();
 		try
 		{
-			pos = m_mapLeafs.GetStartPosition();
-			while (pos) {
-				pLeaf = m_mapLeafs.GetNextValue( pos );
+			for (size_t i = 0; i < m_arLeafs.GetCount(); i++) {
+				DaLeaf* pLeaf = m_arLeafs[i];
 				hres = pLeaf->IsDeviceItem( szItemID );
 				if (SUCCEEDED( hres )) {
 					*ppDItem = &pLeaf->DeviceItem();
@@ -445,13 +526,9 @@ HRESULT DaBranch::ChangeBrowsePosition( OPCBROWSEDIRECTION dwBrowseDirection, LP
 		  case OPC_BROWSE_DOWN:
 			  // ------------------------------------------------------------------
 			  {
-				  try {
-					  DaBranch* pBranch;
-					  if (m_mapBranches.Lookup( szPosition, pBranch )) {
-						  *ppNewPos = pBranch;
-					  }
-				  }
-				  catch (...) {
+				  size_t nIndex;
+				  if (szPosition && FindMember( m_arBranches, szPosition, wcslen( szPosition ), &nIndex )) {
+					  *ppNewPos = m_arBranches[nIndex];
 				  }
 				  if (*ppNewPos == NULL) {
 					  hres = E_INVALIDARG;             // Not found
@@ -461,7 +538,7 @@ HRESULT DaBranch::ChangeBrowsePosition( OPCBROWSEDIRECTION dwBrowseDirection, LP
 
 		  case OPC_BROWSE_TO:
 			  // ------------------------------------------------------------------
-			  hres = m_pRoot->ChangePositionDown( szPosition, ppNewPos );
+			  hres = m_pRoot->ChangePositionDown( szPosition, szPosition ? wcslen( szPosition ) : 0, ppNewPos );
 			  break;
 
 		  default:
@@ -511,22 +588,18 @@ HRESULT DaBranch::BrowseBranches( LPCWSTR szFilterCriteria, LPDWORD pdwNumOfBran
 
 	m_csBranches.BeginReading();
 	try {
-		DaBranch* pBranch;
-
-		DWORD dwSize = (DWORD)m_mapBranches.GetCount();
+		DWORD dwSize = (DWORD)m_arBranches.GetCount();
 		if (dwSize == 0) throw S_FALSE;           // There are no branches
 
 		*ppszBranches = new LPWSTR [ dwSize ];    // Max. number of names
 		if (*ppszBranches == NULL) throw E_OUTOFMEMORY;
 
-		POSITION pos = m_mapBranches.GetStartPosition();
-		while (pos) {
-			pBranch = m_mapBranches.GetNextValue( pos );
-			WideString& wsTmp = pBranch->m_wsName;
+		for (DWORD i = 0; i < dwSize; i++) {
+			LPCWSTR szTmp = m_arBranches[i]->m_szName;
 			// Filter the name
-			if (FilterName( wsTmp, szFilterCriteria, TRUE )) {
+			if (FilterName( szTmp, szFilterCriteria, TRUE )) {
 				// Name passes the filter
-				(*ppszBranches)[dwMatch] = wsTmp.CopyBSTR();
+				(*ppszBranches)[dwMatch] = SysAllocString( szTmp );
 				if ((*ppszBranches)[dwMatch] == NULL) {
 					throw E_OUTOFMEMORY;
 				}
@@ -638,12 +711,9 @@ HRESULT DaBranch::BrowseFlat( LPCWSTR szFilterCriteria, VARTYPE vtDataTypeFilter
 	try {
 		DWORD       dwNumOfSubLeafs;
 		BSTR*       pszLeafs;
-		DaBranch* pBranch;
 
-		POSITION pos = m_mapBranches.GetStartPosition();
-		while (pos) {
-			pBranch = m_mapBranches.GetNextValue( pos );
-			hres = pBranch->BrowseFlat(   szFilterCriteria, vtDataTypeFilter, dwAccessRightsFilter,
+		for (size_t i = 0; i < m_arBranches.GetCount(); i++) {
+			hres = m_arBranches[i]->BrowseFlat(   szFilterCriteria, vtDataTypeFilter, dwAccessRightsFilter,
 				&dwNumOfSubLeafs, &pszLeafs );
 			if (FAILED( hres )) throw hres;
 
@@ -738,21 +808,16 @@ HRESULT DaBranch::GetFullyQualifiedName( LPCWSTR szName, BSTR* pszFullyQualified
 		if (*szName) {                            // Return the fully qualified name of a branch or leaf member
 
 			DaBranch* pBranch;                   // First try if a branch name is specified
-			if (SUCCEEDED( ChangePositionDown( szName, &pBranch ) )) {
+			if (SUCCEEDED( ChangePositionDown( szName, wcslen( szName ), &pBranch ) )) {
 				hres = pBranch->GetFullyQualifiedName( pszFullyQualifiedName );
-				if (FAILED( hres )) throw hres;
+				throw hres;                         // It is a branch name
 			}
 			// It is not a branch name. Try if it is a leaf name.
 			// Check if szName specifies a leaf of this branch
 
-			WideString wsNameCopy;                // Make a copy because the string will be modified
-			HRESULT hresTmp = wsNameCopy.SetString( szName );
-			if (FAILED( hresTmp )) throw hresTmp;
-
-			WCHAR* pwc = wcsrchr( wsNameCopy, m_szDelimiter[0] );
-			if (pwc) {                             
-				*pwc = NULL;                        // szName includes a branch name
-				if (SUCCEEDED( ChangePositionDown( wsNameCopy, &pBranch ) )) {
+			LPCWSTR pwc = wcsrchr( szName, m_szDelimiter[0] );
+			if (pwc) {                             // szName includes a branch name
+				if (SUCCEEDED( ChangePositionDown( szName, pwc - szName, &pBranch ) )) {
 					pwc++;
 					if (*pwc) {
 						hres = pBranch->GetFullyQualifiedName( pwc, pszFullyQualifiedName );
@@ -761,12 +826,12 @@ HRESULT DaBranch::GetFullyQualifiedName( LPCWSTR szName, BSTR* pszFullyQualified
 				}
 			}
 			else {
-				DaLeaf* pLeaf;                    // szName specifies a leaf of this branch
+				size_t nIndex;                      // szName specifies a leaf of this branch
 
 				m_csLeafs.BeginReading();
 				try {
-					if (m_mapLeafs.Lookup( szName, pLeaf )) {
-						hres = pLeaf->GetFullyQualifiedName( pBranch, pszFullyQualifiedName );
+					if (FindMember( m_arLeafs, szName, wcslen( szName ), &nIndex )) {
+						hres = m_arLeafs[nIndex]->GetFullyQualifiedName( this, pszFullyQualifiedName );
 						if (FAILED( hres )) throw hres;
 					}
 				}
@@ -820,34 +885,29 @@ HRESULT DaBranch::GetFullyQualifiedName( LPCWSTR szName, BSTR* pszFullyQualified
 void DaBranch::RemoveAll( BOOL fKillDeviceItems /* = FALSE */ )
 {
 	// Remove all branches
-	DaBranch* pBranch;
-	POSITION pos;
-    m_csBranches.BeginWriting();
-    try
+	m_csBranches.BeginWriting();
+	try
 	{
-		pos = m_mapBranches.GetStartPosition();
-		while (pos) {
-			pBranch = m_mapBranches.GetNextValue( pos );
+		for (size_t i = 0; i < m_arBranches.GetCount(); i++) {
+			DaBranch* pBranch = m_arBranches[i];
 			pBranch->RemoveAll( fKillDeviceItems );
 			delete pBranch;
 		}
-		m_mapBranches.RemoveAll();
+		m_arBranches.RemoveAll();
 	} catch (...) {
 	}
 	m_csBranches.EndWriting();
 
 	// Remove all leafs
-	DaLeaf* pLeaf;
 	m_csLeafs.BeginWriting();
 	try
 	{
-		pos = m_mapLeafs.GetStartPosition();
-		while (pos) {
-			pLeaf = m_mapLeafs.GetNextValue( pos );
+		for (size_t i = 0; i < m_arLeafs.GetCount(); i++) {
+			DaLeaf* pLeaf = m_arLeafs[i];
 			pLeaf->m_fKillDeviceItemOnDestroy = fKillDeviceItems;
 			delete pLeaf;
 		}
-		m_mapLeafs.RemoveAll();
+		m_arLeafs.RemoveAll();
 	} catch (...) {
 	}
 	m_csLeafs.EndWriting();
@@ -865,16 +925,16 @@ void DaBranch::RemoveAll( BOOL fKillDeviceItems /* = FALSE */ )
 HRESULT DaBranch::RemoveLeaf( LPCWSTR szLeafName, BOOL fKillDeviceItem /* = FALSE */ )
 {
 	HRESULT hres = E_INVALIDARG;
-	DaLeaf* pLeaf;
+	size_t  nIndex;
 
 	m_csLeafs.BeginWriting();
 	try {
-		if (m_mapLeafs.Lookup( szLeafName, pLeaf )) {
-			if (m_mapLeafs.RemoveKey( szLeafName )) {
-				pLeaf->m_fKillDeviceItemOnDestroy = fKillDeviceItem;
-				delete pLeaf;
-				hres = S_OK;
-			}        
+		if (FindMember( m_arLeafs, szLeafName, wcslen( szLeafName ), &nIndex )) {
+			DaLeaf* pLeaf = m_arLeafs[nIndex];
+			m_arLeafs.RemoveAt( nIndex );
+			pLeaf->m_fKillDeviceItemOnDestroy = fKillDeviceItem;
+			delete pLeaf;
+			hres = S_OK;
 		}
 	}
 	catch (...) {
@@ -896,16 +956,16 @@ HRESULT DaBranch::RemoveLeaf( LPCWSTR szLeafName, BOOL fKillDeviceItem /* = FALS
 HRESULT DaBranch::RemoveBranch( LPCWSTR szBranchName, BOOL fKillDeviceItems /* = FALSE */ )
 {
 	HRESULT hres = E_INVALIDARG;
-	DaBranch* pBranch;
+	size_t  nIndex;
 
 	m_csBranches.BeginWriting();
 	try {
-		if (m_mapBranches.Lookup( szBranchName, pBranch )) {
-			if (m_mapBranches.RemoveKey( szBranchName )) {
-				pBranch->RemoveAll( fKillDeviceItems );
-				delete pBranch;
-				hres = S_OK;
-			}
+		if (FindMember( m_arBranches, szBranchName, wcslen( szBranchName ), &nIndex )) {
+			DaBranch* pBranch = m_arBranches[nIndex];
+			m_arBranches.RemoveAt( nIndex );
+			pBranch->RemoveAll( fKillDeviceItems );
+			delete pBranch;
+			hres = S_OK;
 		}
 	}
 	catch (...) {
@@ -929,16 +989,12 @@ HRESULT DaBranch::RemoveBranch( LPCWSTR szBranchName, BOOL fKillDeviceItems /* =
 HRESULT DaBranch::RemoveDeviceItemAssociatedLeaf( LPCWSTR szItemID, BOOL fKillDeviceItem /* = FALSE */  )
 {
 	HRESULT  hres = E_INVALIDARG;
-	POSITION pos;
 
-	DaBranch* pBranch;
 	m_csBranches.BeginWriting();
 	try
 	{
-		pos = m_mapBranches.GetStartPosition();
-		while (pos) {
-			pBranch = m_mapBranches.GetNextValue( pos );
-			hres = pBranch->RemoveDeviceItemAssociatedLeaf( szItemID, fKillDeviceItem );
+		for (size_t i = 0; i < m_arBranches.GetCount(); i++) {
+			hres = m_arBranches[i]->RemoveDeviceItemAssociatedLeaf( szItemID, fKillDeviceItem );
 			if (SUCCEEDED( hres )) {
 				break;
 			}
@@ -949,22 +1005,18 @@ HRESULT DaBranch::RemoveDeviceItemAssociatedLeaf( LPCWSTR szItemID, BOOL fKillDe
 	m_csBranches.EndWriting();
 
 	if (FAILED( hres )) {                        // Not found in branches
-		DaLeaf* pLeaf;
-
 		m_csLeafs.BeginWriting();
 		try
 		{
-			pos = m_mapLeafs.GetStartPosition();
-			while (pos) {
-				POSITION posDI = pos;
-				pLeaf = m_mapLeafs.GetNextValue( pos );
+			for (size_t i = 0; i < m_arLeafs.GetCount(); i++) {
+				DaLeaf* pLeaf = m_arLeafs[i];
 				hres = pLeaf->IsDeviceItem( szItemID );
 				if (SUCCEEDED( hres )) {
 					if (fKillDeviceItem) {
 						pLeaf->DeviceItem().Kill( TRUE );
 					}
 					delete pLeaf;
-					m_mapLeafs.RemoveAtPos( posDI );
+					m_arLeafs.RemoveAt( i );
 					break;
 				}
 			}
@@ -987,9 +1039,10 @@ HRESULT DaBranch::RemoveDeviceItemAssociatedLeaf( LPCWSTR szItemID, BOOL fKillDe
 // -----------
 //    Must be called after construction.
 //    This function must not be called for the root object.
-//    Initializes the new branch and add it to the parent branch.
+//    Initializes the new branch with the first nLen characters of
+//    szBranchName as name. The caller adds the branch to the parent.
 //=========================================================================
-HRESULT DaBranch::Create( DaBranch* pParent, LPCWSTR szBranchName )
+HRESULT DaBranch::Create( DaBranch* pParent, LPCWSTR szBranchName, size_t nLen )
 {
 	_ASSERTE( pParent != NULL );                 // A parent must be specified
 	// Use CreateAsRoot() if  there is no
@@ -1000,23 +1053,133 @@ HRESULT DaBranch::Create( DaBranch* pParent, LPCWSTR szBranchName )
 	_ASSERTE( m_pRoot !=  NULL );                // Root object must be initialzed
 	if (!m_pRoot) return E_FAIL;                 // Hint : InitializeAsRoot() not yet called !
 
-	HRESULT hres = m_wsName.SetString( szBranchName );
-	if (FAILED( hres )) return hres;
+	m_szName = gNames.Intern( szBranchName, nLen );
+	return (m_szName != NULL) ? S_OK : E_OUTOFMEMORY;
+}
+
+
+
+//=========================================================================
+// InsertBranch
+// ------------
+//    Returns the branch with the first nLen characters of szBranchName
+//    as name. The branch is created if it does not yet exist.
+//    The name needs not to be terminated after nLen characters so that
+//    a segment of an ItemID can be used without a copy.
+//
+// Return:
+//    S_OK                       The branch has been created.
+//    S_FALSE                    The branch already exist.
+//    E_xxx                      An error occured.
+//=========================================================================
+HRESULT DaBranch::InsertBranch( LPCWSTR szBranchName, size_t nLen, DaBranch** ppBranch )
+{
+	HRESULT     hres = S_OK;
+	size_t      nIndex;
+	DaBranch*   pBranch = NULL;
 
-	m_pParent->m_csBranches.BeginWriting();
+	*ppBranch = NULL;
+
+	m_csBranches.BeginWriting();
+	if (FindMember( m_arBranches, szBranchName, nLen, &nIndex )) {
+		// The branch already exist at this level. This is the common case
+		// when items are added, it is returned without throwing.
+		*ppBranch = m_arBranches[nIndex];
+		m_csBranches.EndWriting();
+		return S_FALSE;
+	}
 	try {
-		m_pParent->m_mapBranches.SetAt( m_wsName, (DaBranch*)this );
-		hres = S_OK;
+		pBranch = new DaBranch;                   // The branch does not yet exist. Create it.
+		if (pBranch == NULL) throw E_OUTOFMEMORY;
+
+		hres = pBranch->Create( this, szBranchName, nLen );
+		if (FAILED( hres )) throw hres;
+
+		m_arBranches.InsertAt( nIndex, pBranch );
+		*ppBranch = pBranch;
+		pBranch = NULL;
+	}
+	catch (HRESULT hresEx) {
+		hres = hresEx;
 	}
 	catch (...) {
 		hres = E_OUTOFMEMORY;
 	}
-	m_pParent->m_csBranches.EndWriting();
+	m_csBranches.EndWriting();
+
+	if (pBranch) {                               // Not added to this branch
+		delete pBranch;
+	}
 	return hres;
 }
 
 
 
+//=========================================================================
+// AddBranches
+// -----------
+//    Returns the branch at the specified position. Not existing
+//    branches are created. The position can specifiy more than one
+//    branch level and is used in place.
+//
+// Parameters:
+//    IN
+//       szPosition              The position relative to this branch.
+//       nLen                    The number of characters of szPosition
+//                               to use. szPosition needs not to be
+//                               terminated after these characters.
+//    OUT
+//       ppBranch                The branch at the specified position.
+//=========================================================================
+HRESULT DaBranch::AddBranches( LPCWSTR szPosition, size_t nLen, DaBranch** ppBranch )
+{
+	HRESULT     hres = S_OK;
+	LPCWSTR     pName = szPosition;
+	LPCWSTR     pLast = szPosition + nLen;     // End of the position
+	DaBranch*   pBranch = this;
+
+	*ppBranch = NULL;
+	while (pName < pLast) {                      // Handle all defined branches.
+		LPCWSTR pEnd = wmemchr( pName, m_szDelimiter[0], pLast - pName );
+		if (!pEnd) {
+			pEnd = pLast;                         // Last branch name
+		}
+		if (pEnd > pName) {                       // Empty names are skipped
+			hres = pBranch->InsertBranch( pName, pEnd - pName, &pBranch );
+			if (FAILED( hres )) {
+				return hres;                      // Brach creation failed.
+			}
+		}
+		pName = pEnd + 1;                         // Get the name of the next branch.
+	}
+	*ppBranch = pBranch;
+	return S_OK;
+}
+
+
+
+//=========================================================================
+// FindBranch
+// ----------
+//    Returns the branch member with the first nLen characters of
+//    szBranchName as name or NULL if there is no such branch.
+//=========================================================================
+DaBranch* DaBranch::FindBranch( LPCWSTR szBranchName, size_t nLen )
+{
+	DaBranch*   pBranch = NULL;
+	size_t      nIndex;
+
+	m_csBranches.BeginReading();
+	if (FindMember( m_arBranches, szBranchName, nLen, &nIndex )) {
+		pBranch = m_arBranches[nIndex];
+	}
+	m_csBranches.EndReading();
+
+	return pBranch;
+}
+
+
+
 //=========================================================================
 // BrowseLeafs
 // -----------
@@ -1061,15 +1224,14 @@ HRESULT DaBranch::BrowseLeafs( BOOL fReturnFullyQualifiedNames,
 		DWORD       dwAccessRights;
 		DaLeaf*   pLeaf;
 
-		DWORD dwSize = (DWORD)m_mapLeafs.GetCount();
+		DWORD dwSize = (DWORD)m_arLeafs.GetCount();
 		if (dwSize == 0) throw S_FALSE;           // There are no leafs
 
 		*ppszLeafs = new LPWSTR [ dwSize ];       // Max. number of names
 		if (*ppszLeafs == NULL) throw E_OUTOFMEMORY;
 
-		POSITION pos = m_mapLeafs.GetStartPosition();
-		while (pos) {
-			pLeaf = m_mapLeafs.GetNextValue( pos );
+		for (DWORD i = 0; i < dwSize; i++) {
+			pLeaf = m_arLeafs[i];
 			DaDeviceItem& DItem = pLeaf->DeviceItem();
 
 			if (dwAccessRightsFilter) {
@@ -1087,7 +1249,7 @@ HRESULT DaBranch::BrowseLeafs( BOOL fReturnFullyQualifiedNames,
 								pLeaf->GetFullyQualifiedName( this, &szTmp );
 							}
 							else {
-								szTmp = pLeaf->Name().CopyBSTR();
+								szTmp = SysAllocString( pLeaf->Name() );
 							}
 							if (!szTmp) throw E_OUTOFMEMORY;
 
@@ -1105,6 +1267,7 @@ HRESULT DaBranch::BrowseLeafs( BOOL fReturnFullyQualifiedNames,
 			throw S_FALSE;                         // No leafs matches the filter
 		}
 		*pdwNumOfLeafs = dwMatch;
+		hres = S_OK;                              // Also without access rights filter
 	}
 	catch (HRESULT hresEx) {
 		fCleanup = true;
@@ -1153,13 +1316,14 @@ HRESULT DaBranch::GetFullyQualifiedName( BSTR* pszFullyQualifiedName )
 		// the delimiter character               
 		hres = m_pParent->GetFullyQualifiedName( &bstrQualifiedParentName );
 		if (SUCCEEDED( hres )) {
-			unsigned int uLen = SysStringLen( bstrQualifiedParentName ) + (unsigned int)wcslen( m_wsName ) + 2;
-			// +2 for EOS and the delimiter character
-			*pszFullyQualifiedName = SysAllocStringLen( bstrQualifiedParentName, uLen );
+			unsigned int uLen = SysStringLen( bstrQualifiedParentName ) + (unsigned int)wcslen( m_szName ) + 2;
+			// +2 for EOS and the delimiter character. The string length
+			// excludes the EOS and the parent name is copied below.
+			*pszFullyQualifiedName = SysAllocStringLen( NULL, uLen - 1 );
 			if (*pszFullyQualifiedName != NULL) {
 				wcscpy_s( *pszFullyQualifiedName, uLen, bstrQualifiedParentName );
 				wcscat_s( *pszFullyQualifiedName, uLen, m_szDelimiter );
-				wcscat_s( *pszFullyQualifiedName, uLen, m_wsName );
+				wcscat_s( *pszFullyQualifiedName, uLen, m_szName );
 			}
 			else {
 				hres = E_OUTOFMEMORY;
@@ -1169,7 +1333,7 @@ HRESULT DaBranch::GetFullyQualifiedName( BSTR* pszFullyQualifiedName )
 		}
 	}                                         // First level branch
 	else {
-		*pszFullyQualifiedName = m_wsName.CopyBSTR();
+		*pszFullyQualifiedName = SysAllocString( m_szName );
 	}
 	if (*pszFullyQualifiedName == 0) {
 		hres = E_OUTOFMEMORY;
@@ -1184,54 +1348,44 @@ HRESULT DaBranch::GetFullyQualifiedName( BSTR* pszFullyQualifiedName )
 // ------------------
 //    Returns the branch at the specified position. The position can
 //    specifiy more than one branch level.
-//    This function assumes that m_mapBranches is already locked
-//    by the caller.
+//    The branch names are searched in place so no copy of the position
+//    is required.
 //
 // Parameters:
 //    IN
 //       szPosition              The position to return or a NULL-String
 //                               to return the root.
+//       nLen                    The number of characters of szPosition
+//                               to use. szPosition needs not to be
+//                               terminated after these characters.
 //    OUT
-//       pszFullyQualifiedName   The fully qualified name of this branch.
+//       ppNewPos                The branch at the specified position.
 //=========================================================================
-HRESULT DaBranch::ChangePositionDown( LPCWSTR szPosition, DaBranch** ppNewPos )
+HRESULT DaBranch::ChangePositionDown( LPCWSTR szPosition, size_t nLen, DaBranch** ppNewPos )
 {
-	HRESULT     hres = S_OK;
-	LPCWSTR     pName;
-	WCHAR*	   nextToken = NULL;
-	WideString wsNameCopy;
-	DaBranch* pBranch = this;
+	LPCWSTR     pName = szPosition;
+	LPCWSTR     pLast = szPosition + nLen;     // End of the position
+	DaBranch*   pBranch = this;
+	bool        fBranchName = false;
 
 	*ppNewPos = NULL;
-	try {
-		// Make a copy because wcstok() modifies the string
-		hres = wsNameCopy.SetString( szPosition );
-		if (FAILED( hres )) throw hres;
-		// Get first branch name
-		pName = wcstok_s( wsNameCopy, m_szDelimiter, &nextToken );
-		if (!pName) {                    // Move to the root if the string is empty
-			*ppNewPos = m_pRoot;
-			throw S_OK;
+	while (pName < pLast) {                      // Move to next branch level
+		LPCWSTR pEnd = wmemchr( pName, m_szDelimiter[0], pLast - pName );
+		if (!pEnd) {
+			pEnd = pLast;                         // Last branch name
 		}
-
-		while (pName) {                  // Move to next branch level
-			hres = pBranch->ChangeBrowsePosition( OPC_BROWSE_DOWN, pName, &pBranch );
-			if (FAILED( hres ))
-			{
-				return E_INVALIDARG;		// Invalid branch name
+		if (pEnd > pName) {                       // Empty names are skipped
+			pBranch = pBranch->FindBranch( pName, pEnd - pName );
+			if (!pBranch) {
+				return E_INVALIDARG;              // Invalid branch name
 			}
-			// Get next branch name
-			pName = wcstok_s( NULL, m_szDelimiter, &nextToken );
+			fBranchName = true;
 		}
-		*ppNewPos = pBranch;
-	}
-	catch (HRESULT hresEx) {
-		hres = hresEx;
-	}
-	catch (...) {
-		hres = E_FAIL;
+		pName = pEnd + 1;                         // Get next branch name
 	}
-	return hres;
+	// Move to the root if the string is empty
+	*ppNewPos = fBranchName ? pBranch : m_pRoot;
+	return S_OK;
 }
 
 
@@ -1267,36 +1421,6 @@ BOOL DaBranch::FilterName( LPCWSTR szName, LPCWSTR szFilterCriteria, BOOL fFilte
 
 
 
-//=========================================================================
-// ExistLeaf
-// ---------
-//    Checks if at this level a leaf with the specified name exist.
-//
-// Parameters:
-//    szLeafName                 The leaf name.
-//
-// Return:
-//    Returns TRUE if a leaf with the specified name
-//    exist; otherwise FALSE.
-//=========================================================================
-BOOL DaBranch::ExistLeaf( LPCWSTR szLeafName )
-{
-	DaLeaf*   pLeaf;
-	bool        fFound = false;
-
-	m_csLeafs.BeginReading();
-	try {
-		fFound = m_mapLeafs.Lookup( szLeafName, pLeaf );
-	}
-	catch (...) {
-	}
-	m_csLeafs.EndReading();
-
-	return fFound ? TRUE : FALSE;
-}
-
-
-
 //=========================================================================
 // new_realloc
 // -----------
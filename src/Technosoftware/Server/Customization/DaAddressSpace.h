@@ -30,6 +30,7 @@
 #include <atlcoll.h>
 
 #include "ReadWriteLock.h"
+#include "DaStringArena.h"
 
 class DaDeviceItem;
 class DaLeaf;
@@ -37,7 +38,7 @@ class DaLeaf;
 //-----------------------------------------------------------------------------
 // TEMPLATE LPCWSTRRefElementTraits
 //-----------------------------------------------------------------------------
-// Used by the ATL Maps for branches and leaves
+// Used by the ATL Map of the Item IDs of the server
 template< typename T >
 class LPCWSTRRefElementTraits : public CElementTraitsBase< T >
 {
@@ -75,6 +76,11 @@ public:
 //-----------------------------------------------------------------------------
 // CLASS DaBranch
 //-----------------------------------------------------------------------------
+// The names of the branches and leafs are interned in a pool shared by the
+// whole address space, so that a name used at many positions (e.g. 'Unit1' or
+// 'Value') is stored only once. The members of a branch are kept in arrays
+// sorted by name; a member is found with a binary search of a name segment
+// and moving to a position needs no copy of the position string.
 class DaBranch
 {
 // Construction / Destruction
@@ -83,6 +89,11 @@ public:
    HRESULT CreateAsRoot();
    ~DaBranch();
 
+// Attributes
+public:
+   inline LPCWSTR         Name() const         { return m_szName; }
+   static void            GetNameStatistics( DASTRINGARENASTATS* pStats );
+
 // Operations
 public:
    static void SetDelimiter( WCHAR wc ) {
@@ -91,6 +102,7 @@ public:
    HRESULT  AddBranch( LPCWSTR szBranchName, DaBranch** ppBranch );
    HRESULT  AddLeaf( LPCWSTR szLeafName, DaDeviceItem* pDItem );
    HRESULT  AddDeviceItem( LPCWSTR szSASName, DaDeviceItem* pDItem );
+   HRESULT  AddDeviceItems( DWORD dwCount, LPCWSTR* pszSASNames, DaDeviceItem** ppDItems, HRESULT* pErrors );
    HRESULT  FindDeviceItem( LPCWSTR szItemID, DaDeviceItem** ppDItem );
 
    HRESULT  ChangeBrowsePosition( OPCBROWSEDIRECTION dwBrowseDirection, LPCWSTR szPosition, DaBranch** ppNewPos );
@@ -110,16 +122,18 @@ public:
 
 // Implementation
 protected:
-   HRESULT  Create( DaBranch* pParent, LPCWSTR szBranchName );
+   HRESULT  Create( DaBranch* pParent, LPCWSTR szBranchName, size_t nLen );
+   HRESULT  InsertBranch( LPCWSTR szBranchName, size_t nLen, DaBranch** ppBranch );
+   HRESULT  AddBranches( LPCWSTR szPosition, size_t nLen, DaBranch** ppBranch );
+   DaBranch* FindBranch( LPCWSTR szBranchName, size_t nLen );
 
    HRESULT  BrowseLeafs( BOOL fReturnFullyQualifiedNames,
                          LPCWSTR szFilterCriteria, VARTYPE vtDataTypeFilter, DWORD dwAccessRightsFilter,
                          LPDWORD pdwNumOfLeafs, BSTR** ppszLeafs );
 
    HRESULT  GetFullyQualifiedName( BSTR* pszFullyQualifiedName );
-   HRESULT  ChangePositionDown( LPCWSTR szPosition, DaBranch** ppNewPos );
+   HRESULT  ChangePositionDown( LPCWSTR szPosition, size_t nLen, DaBranch** ppNewPos );
    BOOL     FilterName( LPCWSTR szName, LPCWSTR szFilterCriteria, BOOL fFilterBranch );
-   BOOL     ExistLeaf( LPCWSTR szLeafName );
    void*    new_realloc( void* memblock, size_t sizeOld, size_t sizeNew );
 
    static WCHAR m_szDelimiter[2];
@@ -128,18 +142,18 @@ protected:
    DaBranch*    m_pRoot;
 
    DaBranch*    m_pParent;
-   WideString    m_wsName;                     // The name of the branch
+   LPCWSTR       m_szName;                     // The interned name of the branch
 
-      // Map with the branch members of this branch
-   CAtlMap<LPCWSTR,DaBranch*,LPCWSTRRefElementTraits<LPCWSTR>>  m_mapBranches;
+      // The branch members of this branch, sorted by name
+   CAtlArray<DaBranch*>  m_arBranches;
 
-      // Map with the leaf members of this branch
-   CAtlMap<LPCWSTR,DaLeaf*,LPCWSTRRefElementTraits<LPCWSTR>>    m_mapLeafs;
+      // The leaf members of this branch, sorted by name
+   CAtlArray<DaLeaf*>    m_arLeafs;
 
-      // The critical section to lock/unlock the map of branch members
+      // The critical section to lock/unlock the array of branch members
    ReadWriteLock m_csBranches;
 
-      // The critical section to lock/unlock the map of leaf members
+      // The critical section to lock/unlock the array of leaf members
    ReadWriteLock m_csLeafs;
 };
 
@@ -157,7 +171,7 @@ public:
 
 // Attributes
 public:
-   inline WideString&     Name()               { return m_wsName; }
+   inline LPCWSTR         Name() const         { return m_szName; }
    inline DaDeviceItem&     DeviceItem() const   { return *m_pDItemRef; }
 
 // Operations
@@ -167,7 +181,7 @@ public:
 
 // Implementation
 protected:
-   WideString    m_wsName;                     // The name of the leaf
+   LPCWSTR       m_szName;                     // The interned name of the leaf
    DaDeviceItem*   m_pDItemRef;
 
    friend HRESULT DaBranch::RemoveLeaf( LPCWSTR, BOOL );
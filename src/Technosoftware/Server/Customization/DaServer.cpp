@@ -126,6 +126,13 @@ HRESULT DaServer::Create(DWORD   dwUpdateRate,
 			LOGFMTT("OnCreateServerItems() called...");
         CHECK_RESULT(OnCreateServerItems())
 
+        // Memory used by the items created by the customization part
+        DADEVICEITEMMEMSTATS memStats;
+        GetDeviceItemMemoryStatistics(&memStats);
+        LOGFMTI("%u device items created, %u bytes per item (item IDs %u KB, EU infos %u KB, values %u KB)",
+            memStats.dwItems, memStats.dwBytesPerItem, (DWORD)(memStats.ullStringBytes / 1024),
+            (DWORD)(memStats.ullEUInfoBytes / 1024), (DWORD)(memStats.ullValueBytes / 1024));
+
         CHECK_RESULT(CreateUpdateThread())
 
             // Only if the Server state wasn't changed by the customization part setting of the server state is allowed
@@ -1311,8 +1318,10 @@ HRESULT DaServer::DeleteServerItems()
 {
     m_ItemListLock.BeginWriting();               // protect item list access
     // we modify the item list
+    m_mapItemIDs.RemoveAll();
     m_SASRoot.RemoveAll();
     m_arServerItems.RemoveAll();
+    AddressSpaceChanged();                       // invalidates the browse snapshots
 
     m_ItemListLock.EndWriting();                 // release item list protection
     return S_OK;
@@ -1332,18 +1341,185 @@ HRESULT DaServer::AddDeviceItem(DeviceItem* pDItem)
     if (SUCCEEDED(hres)) {
         LPWSTR pwszItemID;
         hres = pDItem->get_ItemIDPtr(&pwszItemID);
+        if (SUCCEEDED(hres)) {
+            // The Item ID must be unique. Also checked by the SAS if the
+            // Item ID is the name in the SAS.
+            DaDeviceItem* pExisting;
+            if (m_mapItemIDs.Lookup(pwszItemID, pExisting)) {
+                hres = E_INVALIDARG;
+            }
+        }
         if (SUCCEEDED(hres)) {
             hres = m_SASRoot.AddDeviceItem(pwszItemID, pDItem);
+            if (SUCCEEDED(hres)) {
+                try {
+                    // The key is the Item ID of the Device Item,
+                    // valid until the item is removed from the map.
+                    m_mapItemIDs.SetAt(pwszItemID, pDItem);
+                }
+                catch (...) {
+                    m_SASRoot.RemoveDeviceItemAssociatedLeaf(pwszItemID);
+                    hres = E_OUTOFMEMORY;
+                }
+            }
         }
         if (FAILED(hres)) {
             m_arServerItems.Remove(pDItem);
         }
+        else {
+            AddressSpaceChanged();               // invalidates the browse snapshots
+        }
     }
 
     m_ItemListLock.EndWriting();                 // release item list protection
     return hres;
 }
 
+//=============================================================================
+// Adds several Device Items to the Server Address Space               INTERNAL
+// -----------------------------------------------------
+//    Same as AddDeviceItem() for each item but the items are sorted by
+//    Item ID (unless already sorted) and added with a single lock of the
+//    item list. A client searching an Item ID finds either none or all of
+//    the new items.
+//
+//    An item is not added (E_INVALIDARG) if its Item ID already exists or
+//    occurs more than once in the array; the first occurrence is added.
+//    NULL entries of ppDItems are skipped and their pErrors[] are not
+//    changed. Items which are not added are deleted and their entry of
+//    ppDItems is set to NULL.
+//
+// Return:
+//    S_OK                    All items added
+//    S_FALSE                 At least one item failed, see pErrors
+//    E_OUTOFMEMORY           No item added
+//=============================================================================
+
+// Item ID and array index of a Device Item passed to AddDeviceItems()
+typedef struct tagADDITEMENTRY {
+    LPCWSTR     szItemID;
+    DWORD       dwIndex;
+} ADDITEMENTRY;
+
+static int __cdecl CompareAddItemEntries(const void* pElem1, const void* pElem2)
+{
+    const ADDITEMENTRY* pEntry1 = static_cast<const ADDITEMENTRY*>(pElem1);
+    const ADDITEMENTRY* pEntry2 = static_cast<const ADDITEMENTRY*>(pElem2);
+
+    int iCmp = wcscmp(pEntry1->szItemID, pEntry2->szItemID);
+    if (iCmp == 0) {                             // Duplicates in the order of the array
+        iCmp = (pEntry1->dwIndex < pEntry2->dwIndex) ? -1 : 1;
+    }
+    return iCmp;
+}
+
+HRESULT DaServer::AddDeviceItems(DWORD dwCount, DeviceItem** ppDItems, HRESULT* pErrors)
+{
+    HRESULT         hres = S_OK;
+    DWORD           dwEntries = 0;
+    DWORD           dwAdd = 0;
+    BOOL            fSorted = TRUE;
+
+    ADDITEMENTRY*   pEntries = new ADDITEMENTRY[dwCount];
+    LPCWSTR*        pszItemIDs = new LPCWSTR[dwCount];
+    DaDeviceItem**  ppAddItems = new DaDeviceItem*[dwCount];
+    DWORD*          pdwAddIndex = new DWORD[dwCount];
+    HRESULT*        pAddErrors = new HRESULT[dwCount];
+
+    if (!pEntries || !pszItemIDs || !ppAddItems || !pdwAddIndex || !pAddErrors) {
+        hres = E_OUTOFMEMORY;
+    }
+    else {
+        for (DWORD i = 0; i < dwCount; i++) {
+            if (ppDItems[i] == NULL) {
+                continue;
+            }
+            LPWSTR pwszItemID;
+            pErrors[i] = ppDItems[i]->get_ItemIDPtr(&pwszItemID);
+            if (SUCCEEDED(pErrors[i])) {
+                if (fSorted && dwEntries > 0) {
+                    fSorted = (wcscmp(pEntries[dwEntries - 1].szItemID, pwszItemID) < 0);
+                }
+                pEntries[dwEntries].szItemID = pwszItemID;
+                pEntries[dwEntries].dwIndex = i;
+                dwEntries++;
+            }
+        }
+        // With sorted Item IDs the items of a branch are added in sequence
+        if (!fSorted) {
+            qsort(pEntries, dwEntries, sizeof(ADDITEMENTRY), CompareAddItemEntries);
+        }
+
+        m_ItemListLock.BeginWriting();           // protect item list access
+        // we modify the item list
+        for (DWORD e = 0; e < dwEntries; e++) {
+            DaDeviceItem* pExisting;
+            DWORD i = pEntries[e].dwIndex;
+            // The Item ID must be unique
+            if ((e > 0 && wcscmp(pEntries[e].szItemID, pEntries[e - 1].szItemID) == 0) ||
+                m_mapItemIDs.Lookup(pEntries[e].szItemID, pExisting)) {
+                pErrors[i] = E_INVALIDARG;
+            }
+            else {
+                try {
+                    // The key is the Item ID of the Device Item,
+                    // valid until the item is removed from the map.
+                    m_mapItemIDs.SetAt(pEntries[e].szItemID, ppDItems[i]);
+                }
+                catch (...) {
+                    pErrors[i] = E_OUTOFMEMORY;
+                    continue;
+                }
+                pszItemIDs[dwAdd] = pEntries[e].szItemID;
+                ppAddItems[dwAdd] = ppDItems[i];
+                pdwAddIndex[dwAdd] = i;
+                dwAdd++;
+            }
+        }
+
+        m_SASRoot.AddDeviceItems(dwAdd, pszItemIDs, ppAddItems, pAddErrors);
+
+        for (DWORD a = 0; a < dwAdd; a++) {
+            DWORD i = pdwAddIndex[a];
+            if (SUCCEEDED(pAddErrors[a]) && !m_arServerItems.Add(ppDItems[i])) {
+                m_SASRoot.RemoveDeviceItemAssociatedLeaf(pszItemIDs[a]);
+                pAddErrors[a] = E_OUTOFMEMORY;
+            }
+            if (FAILED(pAddErrors[a])) {
+                m_mapItemIDs.RemoveKey(pszItemIDs[a]);
+            }
+            pErrors[i] = pAddErrors[a];
+        }
+        if (dwAdd > 0) {
+            AddressSpaceChanged();               // invalidates the browse snapshots
+        }
+        m_ItemListLock.EndWriting();             // release item list protection
+    }
+
+    // Delete the items which are not added
+    for (DWORD i = 0; i < dwCount; i++) {
+        if (ppDItems[i] != NULL && (FAILED(hres) || FAILED(pErrors[i]))) {
+            if (SUCCEEDED(hres)) {
+                hres = S_FALSE;
+            }
+            else {
+                pErrors[i] = hres;
+            }
+            delete ppDItems[i];
+            ppDItems[i] = NULL;
+        }
+    }
+
+    delete[] pEntries;
+    delete[] pszItemIDs;
+    delete[] ppAddItems;
+    delete[] pdwAddIndex;
+    delete[] pAddErrors;
+
+    LOGFMTT("AddDeviceItems() for %u items finished with hres = 0x%x.", dwCount, hres);
+    return hres;
+}
+
 //=============================================================================
 // Removes a Device Item from the Server Address Space                 INTERNAL
 //=============================================================================
@@ -1358,6 +1534,8 @@ HRESULT DaServer::RemoveDeviceItem(DeviceItem* pDItem)
         hres = m_SASRoot.RemoveDeviceItemAssociatedLeaf(pwszItemID);
     }
     if (SUCCEEDED(hres)) {
+        AddressSpaceChanged();                   // invalidates the browse snapshots
+        m_mapItemIDs.RemoveKey(pwszItemID);
         pDItem->Kill(false);
         if (pDItem->get_RefCount() == 0) {
             DeleteDeviceItem(pDItem);
@@ -1414,14 +1592,18 @@ HRESULT DaServer::FindDeviceItem(LPCWSTR szItemID, DaDeviceItem** ppDItem)
 
 
     //
-    // Search the Item with the specified ID
+    // Search the Item with the specified ID in the index of the
+    // fully qualified Item IDs.
     //
 
     m_ItemListLock.BeginReading();               // Protect item list access
 
-    if (SUCCEEDED(m_SASRoot.FindDeviceItem(szItemID, ppDItem))) {
+    if (m_mapItemIDs.Lookup(szItemID, *ppDItem)) {
         (*ppDItem)->Attach();
     }
+    else {
+        *ppDItem = NULL;
+    }
 
     m_ItemListLock.EndReading();                 // Release item list protection
 
@@ -152,6 +152,7 @@ public:
 	// Operations
 public:
 	HRESULT AddDeviceItem(DeviceItem* pDItem);
+	HRESULT AddDeviceItems(DWORD dwCount, DeviceItem** ppDItems, HRESULT* pErrors);
 	HRESULT RemoveDeviceItem(DeviceItem* pDItem);
 	void DeleteDeviceItem(DeviceItem* pDItem);
 
@@ -326,6 +327,10 @@ protected:
       // Root of the hierarchical Server Address Space
    DaBranch           m_SASRoot;
 
+      // Index of the Device Items by fully qualified Item ID.
+      // Protected by m_ItemListLock.
+   CAtlMap<LPCWSTR,DaDeviceItem*,LPCWSTRRefElementTraits<LPCWSTR>>  m_mapItemIDs;
+
    BOOL                 m_fCreated;
 };
 
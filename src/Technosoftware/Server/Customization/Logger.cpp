@@ -41,6 +41,9 @@
 
 #include "OpcSdk.h"
 #include "Logger.h"
+#ifdef WIN32
+#include "OpcClock.h"
+#endif
 
 static const char *const LOG_STRING[]=
 {
@@ -1125,6 +1128,9 @@ LogData * LogerManager::makeLogData(LoggerId id, int level)
             pLog = new LogData();
         }
     }
+#ifdef WIN32
+    FILETIME ft;
+#endif
     //append precise time to log
     if (true)
     {
@@ -1134,8 +1140,7 @@ LogData * LogerManager::makeLogData(LoggerId id, int level)
         pLog->_typeval = 0;
         pLog->_contentLen = 0;
 #ifdef WIN32
-        FILETIME ft;
-        GetSystemTimeAsFileTime(&ft);
+        OpcClockCoarse(&ft);
         unsigned long long now = ft.dwHighDateTime;
         now <<= 32;
         now |= ft.dwLowDateTime;
@@ -1155,7 +1160,13 @@ LogData * LogerManager::makeLogData(LoggerId id, int level)
     //format log
     if (true)
     {
+#ifdef WIN32
+        // the local time is only converted once per second and thread
+        tm tt;
+        OpcClockToLocalTime(&ft, &tt, &pLog->_precise);
+#else
         tm tt = timeToTm(pLog->_time);
+#endif
 
         pLog->_contentLen = sprintf(pLog->_content, "%d-%02d-%02d %02d:%02d:%02d.%03u %s ",
             tt.tm_year + 1900, tt.tm_mon + 1, tt.tm_mday, tt.tm_hour, tt.tm_min, tt.tm_sec, pLog->_precise,
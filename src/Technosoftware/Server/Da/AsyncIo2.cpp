@@ -170,7 +170,7 @@ STDMETHODIMP DaGroup::Cancel2(
     hres = pGGroup->m_oaAsyncThread.GetElem(dwCancelID, (DaAsynchronousThread**)&pThreadToCancel);
     if (SUCCEEDED(hres)) {
         // OK, there is an outstanding transaction
-        hres = pThreadToCancel->CreateCancelThread();
+        hres = pThreadToCancel->RequestCancel();
     }
     else {
         LOGFMTI("   It is 'too late' to cancel the transaction");
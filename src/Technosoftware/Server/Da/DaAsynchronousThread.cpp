@@ -21,7 +21,6 @@
 //DOM-IGNORE-BEGIN
 
 #include "stdafx.h"
-#include <process.h>
 #include "UtilityFuncs.h"   
 #include "DaGenericGroup.h"
 
@@ -39,13 +38,11 @@ DaAsynchronousThread::DaAsynchronousThread( DaGenericGroup *pGGroup )
    m_pParent->Attach();
 
    m_ToCancel = FALSE ;
+   m_fAdmitted = FALSE;
 
             // Number of itmes to be handled
    m_NumItems = 0;
 
-            // set to invalid handle
-   m_ThreadHandle = 0;
-
             //
             // Pointer to memory areas.
             // Must be released in destructor.
@@ -142,14 +139,13 @@ DaAsynchronousThread::~DaAsynchronousThread( void )
       m_avpVQTsToWrite.Free();
    }
    
-   m_ThreadHandle = 0;
    m_NumItems = 0;
 }
 
 
 
 //=========================================================================
-// Init the class instance and start the handler thread for READ and
+// Init the class instance and queue the handler to the transaction pool for READ and
 // REFRESH through the CUSTOM interface
 //=========================================================================
 HRESULT DaAsynchronousThread::CreateCustomRead( 
@@ -163,9 +159,8 @@ HRESULT DaAsynchronousThread::CreateCustomRead(
                    // [out]
                    DWORD         *pdwTransactionID )
 {
-      unsigned    dwCreationFlags = 0 ;
+      HRESULT     hres;
 
-                                                      
    m_pfItemActiveState = pfItemActiveState;           // array with active state of all generic items
 
    m_pfPhyval     = pfPhyval;                         // array which marks items added with their physical value
@@ -179,32 +174,31 @@ HRESULT DaAsynchronousThread::CreateCustomRead(
       // Item States 
    m_pItemStates  = pItemStates;
 
+                                                      // reject the transaction if too many are outstanding
+   hres = m_pParent->m_pServerHandler->AdmitAsyncTransaction( m_pParent->m_pServer );
+   if (FAILED( hres )) {
+      DoDelete();
+      return hres;
+   }
+   m_fAdmitted = TRUE;
+
    sCurrentTransactionID++;
 
    *pdwTransactionID = m_TransactionID = sCurrentTransactionID;
 
-   m_ThreadHandle = _beginthreadex(
-                              NULL,                   // no thread security attributes
-                              0,                      // default stack size  
-                              Thread_Read_Handler,    // pointer to thread function 
-                              this,                   // pass class to new thread 
-                              dwCreationFlags,        // into ready state 
-                              &m_ThreadId  );         // pointer to returned thread identifier 
-
-   if (m_ThreadHandle == 0) {
-      DoDelete();                                     // Cannot create thread, delete advise class
-      return HRESULT_FROM_WIN32( GetLastError() );    // because not deleted by thread handler.
+                                                      // execute by the transaction pool
+   hres = m_pParent->m_pServerHandler->SubmitAsyncTransaction( Thread_Read_Handler, this );
 
-   }
-   else {
-      return S_OK;
-   }
+   if (FAILED( hres )) {
+      DoDelete();                                     // Cannot queue the transaction, delete advise class
+   }                                                  // because not deleted by the handler.
+   return hres;
 }
 
 
 
 //=========================================================================
-// Init the class instance and start the handler thread for READ, REFRESH
+// Init the class instance and queue the handler to the transaction pool for READ, REFRESH
 // through the AUTOMATION Interface
 //
 // Thread Type is ignored in this implementation!
@@ -218,6 +212,8 @@ HRESULT DaAsynchronousThread::CreateAutomationRead(
                    // [out]
                    long          *pdwTransactionID )
 {
+      HRESULT     hres;
+
    m_pfPhyval     = pfPhyval;                         // array which marks items added with their physical value
    m_DataSource   = Source ;
    m_NumItems     = NumItems ;
@@ -225,33 +221,32 @@ HRESULT DaAsynchronousThread::CreateAutomationRead(
    m_pItemStates  = pItemStates ;
    m_WithTime     = TRUE ;                
 
+                                                      // reject the transaction if too many are outstanding
+   hres = m_pParent->m_pServerHandler->AdmitAsyncTransaction( m_pParent->m_pServer );
+   if (FAILED( hres )) {
+      DoDelete();
+      return hres;
+   }
+   m_fAdmitted = TRUE;
+
    sCurrentTransactionID++;
 
    *pdwTransactionID = m_TransactionID = sCurrentTransactionID;
 
-   m_ThreadHandle = _beginthreadex(
-                              NULL,                   // no thread security attributes
-                              0,                      // default stack size  
-                              Thread_ReadAut_Handler, // pointer to thread function 
-                              this,                   // pass class to new thread 
-                              0,                      // into ready state 
-                              &m_ThreadId  );         // pointer to returned thread identifier 
-
-   if (m_ThreadHandle == 0) {
-      DoDelete();                                     // Cannot create thread, delete advise class
-      return HRESULT_FROM_WIN32( GetLastError() );    // because not deleted by thread handler.
+                                                      // execute by the transaction pool
+   hres = m_pParent->m_pServerHandler->SubmitAsyncTransaction( Thread_ReadAut_Handler, this );
 
-   }
-   else {
-      return S_OK;
-   }
+   if (FAILED( hres )) {
+      DoDelete();                                     // Cannot queue the transaction, delete advise class
+   }                                                  // because not deleted by the handler.
+   return hres;
 }
 
 
 
 
 //=========================================================================
-// Init the class instance and start the handler thread for WRITE
+// Init the class instance and queue the handler to the transaction pool for WRITE
 // through the CUSTOM Interface
 //=========================================================================
 HRESULT DaAsynchronousThread::CreateCustomWrite( 
@@ -281,22 +276,18 @@ HRESULT DaAsynchronousThread::CreateCustomWrite(
          _OPC_CHECK_HR( hr );
       }
 
+                                                // reject the transaction if too many are outstanding
+      hr = m_pParent->m_pServerHandler->AdmitAsyncTransaction( m_pParent->m_pServer );
+      _OPC_CHECK_HR( hr );
+      m_fAdmitted = TRUE;
+
       sCurrentTransactionID++;
 
       *pdwTransactionID = m_TransactionID = sCurrentTransactionID;
 
-      m_ThreadHandle = _beginthreadex(
-                        NULL,                   // no thread security attributes
-                        0,                      // default stack size  
-                        Thread_Write_Handler,   // pointer to thread function
-                        this,                   // pass class to new thread 
-                        0,                      // into ready state 
-                        &m_ThreadId  );         // pointer to returned thread identifier 
-
-      if (m_ThreadHandle == 0) {
-         hr = HRESULT_FROM_WIN32( GetLastError() );
-         throw hr;
-      }
+                                                // execute by the transaction pool
+      hr = m_pParent->m_pServerHandler->SubmitAsyncTransaction( Thread_Write_Handler, this );
+      _OPC_CHECK_HR( hr );
       hr = S_OK;
    }
    catch (HRESULT hrEx) { hr = hrEx; }
@@ -311,7 +302,7 @@ HRESULT DaAsynchronousThread::CreateCustomWrite(
 
 
 //=========================================================================
-// Init the class instance and start the handler thread for WRITE
+// Init the class instance and queue the handler to the transaction pool for WRITE
 // through the AUTOMATION Interface
 //=========================================================================
 HRESULT DaAsynchronousThread::CreateAutomationWrite( 
@@ -344,20 +335,20 @@ HRESULT DaAsynchronousThread::CreateAutomationWrite(
       m_avpVQTsToWrite[i].vDataValue = pItemValues[i];
    }
 
+                                                      // reject the transaction if too many are outstanding
+   hres = m_pParent->m_pServerHandler->AdmitAsyncTransaction( m_pParent->m_pServer );
+   if (FAILED( hres )) {
+      goto CreateAutoWriteExit1;
+   }
+   m_fAdmitted = TRUE;
+
    sCurrentTransactionID++;
 
    *pdwTransactionID = m_TransactionID = sCurrentTransactionID;
 
-   m_ThreadHandle = _beginthreadex(
-                              NULL,                   // no thread security attributes
-                              0,                      // default stack size  
-                              Thread_WriteAut_Handler,// pointer to thread function
-                              this,                   // pass class to new thread 
-                              0,                      // into ready state 
-                              &m_ThreadId  );         // pointer to returned thread identifier 
-
-   if (m_ThreadHandle == 0) { 
-      hres = HRESULT_FROM_WIN32( GetLastError() );
+                                                      // execute by the transaction pool
+   hres = m_pParent->m_pServerHandler->SubmitAsyncTransaction( Thread_WriteAut_Handler, this );
+   if (FAILED( hres )) {
       goto CreateAutoWriteExit1;
    }
    return S_OK;
@@ -371,23 +362,23 @@ CreateAutoWriteExit1:
 
     
 //=========================================================================
-// Kill this instance and the thread running over it
+// Kill this instance after the transaction has been handled.
+// The worker thread of the transaction pool continues with the next
+// transaction.
 //=========================================================================
 void DaAsynchronousThread::DoKill( void )
 {
                                  // remove from list in group so that no AsyncIO.Cancel
                                  // can be done on it.
    RemoveAdviseFromGroup();
-
-   HANDLE hThread = (HANDLE)m_ThreadHandle;
+                                 // release the admission while the group is attached
+   if (m_fAdmitted) {
+      m_pParent->m_pServerHandler->CompleteAsyncTransaction( m_pParent->m_pServer );
+      m_fAdmitted = FALSE;
+   }
 
    m_pParent->Detach();
    delete this;
-                                 // Version 1.3, AM
-   CloseHandle( hThread );       //    Thread handle must be closed explicitly
-                                 //    if _endthreadex() is used.
-
-   _endthreadex(0);              // thread kill requested
 }
 
 
@@ -402,6 +393,11 @@ void DaAsynchronousThread::DoDelete( void )
                                  // remove from list in group so that no AsyncIO.Cancel
                                  // can be done on it.
    RemoveAdviseFromGroup();
+                                 // release the admission while the group is attached
+   if (m_fAdmitted) {
+      m_pParent->m_pServerHandler->CompleteAsyncTransaction( m_pParent->m_pServer );
+      m_fAdmitted = FALSE;
+   }
    delete this;                  // All cleanup stuff is done by destructor.
 }
 
@@ -466,8 +462,8 @@ RemoveAdviseFromGroupExitWhile:
 //=========================================================================
 // Thread handling Async READ and Refresh throough CUSTOM Interface
 // ----------------------------------------------------------------
-// The thread handles a single request and then terminates.
-// This thread is also created from the permanent update thread
+// Executed by a worker thread of the transaction pool. Handles a single
+// request and deletes the transaction.
 //=========================================================================
 unsigned int __stdcall Thread_Read_Handler( void *Par ) 
 {
@@ -575,10 +571,9 @@ ThreadCustReadExit1:
 ThreadCustReadExit0:
       // release the read items!
 
-      // kill thread and object
+      // delete the transaction
    Adv->DoKill();
-      // should never get here
-   return 0; 
+   return 0;
 }
 
 
@@ -587,8 +582,8 @@ ThreadCustReadExit0:
 //=========================================================================
 // Thread handling Async READ and Refresh through AUTOMATION Interface
 // -------------------------------------------------------------------
-// The thread handles a single request and then terminates.
-// This thread is also created from the permanent update thread
+// Executed by a worker thread of the transaction pool. Handles a single
+// request and deletes the transaction.
 //=========================================================================
 unsigned int __stdcall Thread_ReadAut_Handler( void *Par ) 
 {
@@ -675,10 +670,9 @@ ThreadAutReadExit1:
    delete [] pErr;
 
 ThreadAutReadExit0:
-      // kill thread and object
+      // delete the transaction
    pAdv->DoKill();
-      // should never get here
-   return 0;                                                 // should never get here!
+   return 0;
 }
 
 
@@ -689,7 +683,8 @@ ThreadAutReadExit0:
 //=========================================================================
 // Thread handling Async WRITE requested through the CUSTOM Interface
 // ------------------------------------------------------------------
-// The thread handles a single request and then terminates.
+// Executed by a worker thread of the transaction pool. Handles a single
+// request and deletes the transaction.
 //=========================================================================
 unsigned int  __stdcall Thread_Write_Handler( void *Par ) 
 {
@@ -768,9 +763,9 @@ ThreadCustWriteExit1:
    delete [] pErr;
 
 ThreadCustWriteExit0:
-      // kill thread and object
+      // delete the transaction
    Adv->DoKill();
-   return 0;                                             // should never get here
+   return 0;
 }
 
 
@@ -778,7 +773,8 @@ ThreadCustWriteExit0:
 //=========================================================================
 // Thread handling Async WRITE requested through the AUTOMATION Interface
 // ----------------------------------------------------------------------
-// The thread handles a single request and then terminates.
+// Executed by a worker thread of the transaction pool. Handles a single
+// request and deletes the transaction.
 //
 // 
 //=========================================================================
@@ -861,10 +857,9 @@ ThreadAutoWriteExit1:
    delete [] pErr;
 
 ThreadAutoWriteExit0:
-      // kill thread and object
+      // delete the transaction
    pAdv->DoKill();
-      // should never get here
-   return 0;                                             
+   return 0;
 }
 
 
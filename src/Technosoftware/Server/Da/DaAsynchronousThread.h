@@ -49,9 +49,11 @@ public:
    //    The creator of the Thread Avice object must not use the created
    //    instance after CreateXXX calls because the object destroys itself.
    //    Also all by parameters provided arrays will be deleted.
+   //    The transactions are executed by the transaction pool of the
+   //    server class handler (see DaBaseServer::SubmitAsyncTransaction()).
    //
 
-   // Create thread for Read or Refresh through Custom Interface
+   // Queue transaction for Read or Refresh through Custom Interface
    HRESULT CreateCustomRead(  BOOL           WithTime,            // OLE connection key
                               OPCDATASOURCE  Source,              // CACHE or DEVICE
                               DWORD          NumItems,            // number of items to handle
@@ -63,7 +65,7 @@ public:
                               DWORD         *pdwTransactionID );
 
 
-   // Create thread for Read or Refresh through Automation Interface
+   // Queue transaction for Read or Refresh through Automation Interface
    HRESULT CreateAutomationRead(
                               OPCDATASOURCE  Source,              // CACHE or DEVICE
                               DWORD          NumItems,            // number of items to handle
@@ -74,7 +76,7 @@ public:
                               long          *pdwTransactionID );
 
 
-   // Create thread for Write through Custom Interface
+   // Queue transaction for Write through Custom Interface
    HRESULT CreateCustomWrite( DWORD          NumItems,            // number of items to handle
                               DaDeviceItem  **ppDItems,            // array with generic item ptrs  
                               OPCITEMHEADERWRITE *pItemHdr,       // result array with client handle
@@ -84,7 +86,7 @@ public:
                               DWORD         *pdwTransactionID );
 
      
-   // Create thread for Write through Automation Interface
+   // Queue transaction for Write through Automation Interface
    HRESULT CreateAutomationWrite(
                               DWORD          NumItems,            // number of items to handle
                               DaDeviceItem  **ppDItems,            // array with generic item ptrs  
@@ -107,20 +109,18 @@ protected:
    // Data members
    //
 
-            // Thread handle. Also used as transaction id.
-   uintptr_t      m_ThreadHandle;
-
             // Transaction id.
    DWORD          m_TransactionID;
 
             // used to synchronize access to this class instance
    BOOL           m_ToCancel;
 
+            // TRUE if admitted by DaBaseServer::AdmitAsyncTransaction()
+   BOOL           m_fAdmitted;
+
             // parent class
    DaGenericGroup *m_pParent;
 
-   unsigned       m_ThreadId;
-
             // defines stream format to client
    BOOL           m_WithTime;
 
@@ -26,6 +26,7 @@
 #include "DaBaseServer.h"
 #include "UtilityFuncs.h"
 #include "IClassicBaseNodeManager.h" 
+#include "Logger.h"
 
 //=========================================================================
 // Constructor
@@ -34,6 +35,22 @@ DaBaseServer::DaBaseServer(void)
 {
     created_ = FALSE;
     baseUpdateRate_ = 0;
+    updateThreadCount_ = 0;
+    asyncThreadCount_ = 0;
+    deliveryThreadCount_ = 0;
+    asyncClientLimit_ = DA_ASYNC_DEFAULT_CLIENT_LIMIT;
+    asyncServerLimit_ = DA_ASYNC_DEFAULT_SERVER_LIMIT;
+    asyncTransactions_ = 0;
+    asyncAdmitted_ = 0;
+    asyncRejectedClient_ = 0;
+    asyncRejectedServer_ = 0;
+    asyncRejectLogged_ = FALSE;
+    callbackQueueLimit_ = DA_CALLBACKQUEUE_DEFAULT_LIMIT;
+    memset(&updateCycleStats_, 0, sizeof(updateCycleStats_));
+    updateCycleStats_.dwStretch = 100;
+    updateStretch_ = 100;
+    updateLoadTick_ = 0;
+    addressSpaceVersion_ = 0;
     name_ = NULL;
     instanceIndex_ = 0;
     InitializeCriticalSection(&criticalSection_);
@@ -45,6 +62,13 @@ DaBaseServer::DaBaseServer(void)
 //=========================================================================
 DaBaseServer::~DaBaseServer()
 {
+    // no more updates to the clients
+    updatePool_.Stop();
+    // delivers the callbacks which are still queued
+    deliveryPool_.Stop();
+    // completes the outstanding asynchronous transactions
+    asyncPool_.Stop();
+
     if (name_) {
         WSTRFree(name_, NULL);
     }
@@ -94,6 +118,27 @@ HRESULT DaBaseServer::Create(int instanceIndex,
         return hres;
     }
 
+    // Start the threads which send the updates to the clients.
+    hres = updatePool_.Start(updateThreadCount_);
+    if (FAILED(hres)) {
+        return hres;
+    }
+
+    // Start the threads which deliver the callbacks to the clients.
+    hres = deliveryPool_.Start(deliveryThreadCount_);
+    if (FAILED(hres)) {
+        updatePool_.Stop();
+        return hres;
+    }
+
+    // Start the threads which execute the asynchronous transactions.
+    hres = asyncPool_.Start(asyncThreadCount_);
+    if (FAILED(hres)) {
+        updatePool_.Stop();
+        deliveryPool_.Stop();
+        return hres;
+    }
+
     created_ = TRUE;
     return S_OK;
 }
@@ -314,6 +359,41 @@ void DaBaseServer::GetItemStates(void * groupHandle, int * numDaItemStates, ICla
     delete[] ppDItems;
 }
 
+void DaBaseServer::GetGroupUpdateTiming(void * groupHandle, DWORD * effectiveUpdateRate, DWORD * updateLag)
+{
+    DaGenericGroup*    group = static_cast<DaGenericGroup*>(groupHandle);
+
+    EnterCriticalSection(&group->m_UpdateRateCritSec);
+    *effectiveUpdateRate = group->m_dwEffectiveUpdateRate;
+    *updateLag = group->m_dwUpdateLag;
+    LeaveCriticalSection(&group->m_UpdateRateCritSec);
+}
+
+void DaBaseServer::GetCallbackQueueStatistics(void * clientHandle, DACALLBACKQUEUESTATS * statistics)
+{
+    DaGenericServer*    pSrv = static_cast<DaGenericServer*>(clientHandle);
+
+    pSrv->m_CallbackQueue.GetStatistics(statistics);
+}
+
+DWORD DaBaseServer::GetClientAsyncTransactions(void * clientHandle)
+{
+    DaGenericServer*    pSrv = static_cast<DaGenericServer*>(clientHandle);
+
+    return (DWORD)max(pSrv->m_lAsyncTransactions, 0);
+}
+
+void DaBaseServer::GetItemSubscriberCount(void * deviceItemHandle, int * numSubscribers, int * numActiveSubscribers)
+{
+    DaDeviceItem*       pDItem = static_cast<DaDeviceItem*>(deviceItemHandle);
+    DWORD               dwCount;
+    DWORD               dwActiveCount;
+
+    pDItem->get_ChangeSubscriberCount(&dwCount, &dwActiveCount);
+    *numSubscribers = static_cast<int>(dwCount);
+    *numActiveSubscribers = static_cast<int>(dwActiveCount);
+}
+
 //=========================================================================
 // Standard Revise Update Rate
 // ---------------------------
@@ -357,17 +437,26 @@ HRESULT DaBaseServer::UpdateServerClassInstances()
 
     _ASSERTE(created_ == TRUE);
 
+    // take the load of the update workers since the previous cycle;
+    // groups which are still queued have not been handled in time
+    EnterCriticalSection(&criticalSection_);
+    ULONGLONG tick = GetTickCount64();
+    updatePool_.TakeLoad(&updateCycleStats_.dwUpdateDuration, &updateCycleStats_.dwBacklog);
+    updateCycleStats_.dwUpdateInterval = updateLoadTick_ ? (DWORD)min(tick - updateLoadTick_, MAXDWORD) : baseUpdateRate_;
+    updateLoadTick_ = tick;
+    LeaveCriticalSection(&criticalSection_);
+
     EnterCriticalSection(&serversCriticalSection_);
 
-    // inform all server threads to update
-    // their respective clients 
+    // queue the groups of all servers which have to
+    // update their respective clients to the worker pool
     res = servers_.First(&idx);
     while (SUCCEEDED(res)) {
         servers_.GetElem(idx, &serv);
 
         if (serv->Killed() == FALSE) {
             // inform only active servers (not zombies)
-            SetEvent(serv->m_hUpdateEvent);
+            serv->QueueExpiredGroups(&updatePool_);
         }
 
         res = servers_.Next(idx, &nidx);
@@ -381,6 +470,95 @@ HRESULT DaBaseServer::UpdateServerClassInstances()
 
 
 
+//=========================================================================
+// Report the Cost of an Update Cycle
+// ----------------------------------
+//    Overload policy: the load is the utilization of the update workers,
+//    their busy time in percent of the time all threads had during the
+//    last interval. A backlog of groups which were queued in a previous
+//    cycle and are still not handled counts as at least 125%. The load is
+//    smoothed over the last cycles. As long as it exceeds 100% the stretch
+//    factor of the group update rates grows proportionally to the
+//    overload; below 90% it's reduced by 1/8 per cycle until the groups
+//    run at their revised update rates again.
+//
+//    The refresh of the input cache is done by the update thread and not
+//    by the workers; its load is kept separately and doesn't stretch the
+//    group update rates.
+//=========================================================================
+DWORD DaBaseServer::ReportUpdateCycle(DWORD refreshDuration, DWORD updateDuration)
+{
+    DWORD       duration = refreshDuration + updateDuration;
+    DWORD       load, refreshLoad, stretch, waitTime;
+    ULONGLONG   capacity;
+
+    EnterCriticalSection(&criticalSection_);
+
+    _ASSERTE(baseUpdateRate_ > 0);
+
+    // the groups are handled by the calling thread if the pool isn't running
+    capacity = (ULONGLONG)max(updatePool_.GetThreadCount(), 1UL) * max(updateCycleStats_.dwUpdateInterval, 1UL);
+    load = (DWORD)min((ULONGLONG)updateCycleStats_.dwUpdateDuration * 100 / capacity, 10000);
+    if (updateCycleStats_.dwBacklog > 0) {
+        load = max(load, 125);
+    }
+    refreshLoad = (DWORD)min((ULONGLONG)refreshDuration * 100 / baseUpdateRate_, 10000);
+
+    if (updateCycleStats_.ullCycles == 0) {
+        updateCycleStats_.dwLoad = load;
+        updateCycleStats_.dwRefreshLoad = refreshLoad;
+    }
+    else {
+        updateCycleStats_.dwLoad = (updateCycleStats_.dwLoad * 3 + load) / 4;
+        updateCycleStats_.dwRefreshLoad = (updateCycleStats_.dwRefreshLoad * 3 + refreshLoad) / 4;
+    }
+
+    stretch = updateCycleStats_.dwStretch;
+    if (updateCycleStats_.dwLoad > 100) {
+        // proportional to the overload, at most doubled per cycle
+        stretch = stretch * min(updateCycleStats_.dwLoad, 200) / 100;
+        stretch = min(stretch, DA_UPDATE_MAX_STRETCH);
+    }
+    else if (updateCycleStats_.dwLoad < 90 && stretch > 100) {
+        stretch = max(stretch - max(stretch / 8, 1), 100);
+    }
+    updateCycleStats_.dwStretch = stretch;
+    InterlockedExchange(&updateStretch_, (LONG)stretch);
+
+    updateCycleStats_.dwRefreshDuration = refreshDuration;
+    updateCycleStats_.ullCycles++;
+
+    // the update thread itself overruns if refreshing the cache and
+    // queueing the groups take longer than the base update rate
+    if (duration >= baseUpdateRate_) {
+        updateCycleStats_.ullOverruns++;
+        // do not run the cycles back-to-back, the update workers
+        // must also get a share of the processor
+        waitTime = baseUpdateRate_ * DA_UPDATE_OVERRUN_PAUSE / 100;
+    }
+    else {
+        waitTime = baseUpdateRate_ - duration;
+    }
+
+    LeaveCriticalSection(&criticalSection_);
+    return waitTime;
+}
+
+
+//=========================================================================
+// GetUpdateCycleStatistics
+// ------------------------
+//=========================================================================
+void DaBaseServer::GetUpdateCycleStatistics(DAUPDATECYCLESTATS * statistics)
+{
+    EnterCriticalSection(&criticalSection_);
+    *statistics = updateCycleStats_;
+    LeaveCriticalSection(&criticalSection_);
+}
+
+
+
+
 //=========================================================================
 // Server object enters
 // --------------------
@@ -415,6 +593,10 @@ HRESULT DaBaseServer::AddServerToList(DaGenericServer *pServer)
 
     // get a free index in the open array
     idx = servers_.New();
+    if (idx == -1) {                            // maximum number of servers reached
+        LeaveCriticalSection(&serversCriticalSection_);
+        return E_OUTOFMEMORY;
+    }
 
     // insert the server inthe list
     res = servers_.PutElem(idx, pServer);
@@ -548,6 +730,218 @@ DWORD DaBaseServer::GetBaseUpdateRate(void)
 
 
 
+//=========================================================================
+// SetUpdateThreadCount
+// --------------------
+//    Sets the number of threads of the update worker pool.
+//    Must be called before Create().
+//=========================================================================
+HRESULT DaBaseServer::SetUpdateThreadCount(DWORD updateThreadCount)
+{
+    if (created_ == TRUE) {
+        return E_FAIL;                          // pool is already running
+    }
+    updateThreadCount_ = updateThreadCount;
+    return S_OK;
+}
+
+
+//=========================================================================
+// GetUpdateThreadCount
+// --------------------
+//=========================================================================
+DWORD DaBaseServer::GetUpdateThreadCount(void)
+{
+    if (created_ == TRUE) {
+        return updatePool_.GetThreadCount();
+    }
+    return updateThreadCount_;
+}
+
+
+//=========================================================================
+// SetDeliveryThreadCount
+// ----------------------
+//    Sets the number of threads of the callback delivery pool.
+//    Must be called before Create().
+//=========================================================================
+HRESULT DaBaseServer::SetDeliveryThreadCount(DWORD deliveryThreadCount)
+{
+    if (created_ == TRUE) {
+        return E_FAIL;                          // pool is already running
+    }
+    deliveryThreadCount_ = deliveryThreadCount;
+    return S_OK;
+}
+
+
+//=========================================================================
+// GetDeliveryThreadCount
+// ----------------------
+//=========================================================================
+DWORD DaBaseServer::GetDeliveryThreadCount(void)
+{
+    if (created_ == TRUE) {
+        return deliveryPool_.GetThreadCount();
+    }
+    return deliveryThreadCount_;
+}
+
+
+//=========================================================================
+// SetAsyncThreadCount
+// -------------------
+//    Sets the number of threads of the asynchronous transaction pool.
+//    Must be called before Create().
+//=========================================================================
+HRESULT DaBaseServer::SetAsyncThreadCount(DWORD asyncThreadCount)
+{
+    if (created_ == TRUE) {
+        return E_FAIL;                          // pool is already running
+    }
+    asyncThreadCount_ = asyncThreadCount;
+    return S_OK;
+}
+
+
+//=========================================================================
+// GetAsyncThreadCount
+// -------------------
+//=========================================================================
+DWORD DaBaseServer::GetAsyncThreadCount(void)
+{
+    if (created_ == TRUE) {
+        return asyncPool_.GetThreadCount();
+    }
+    return asyncThreadCount_;
+}
+
+
+//=========================================================================
+// AdmitAsyncTransaction
+// ---------------------
+//    Counts the transaction as outstanding unless a limit is exceeded.
+//    The counters are only modified with interlocked functions so that
+//    no lock is required.
+//
+//    Only the first rejection of an overload is logged, the number of
+//    rejections is returned by GetAsyncAdmissionStatistics(). The next
+//    admitted transaction ends the overload.
+//=========================================================================
+HRESULT DaBaseServer::AdmitAsyncTransaction(DaGenericServer * client)
+{
+    DWORD   dwServerLimit = asyncServerLimit_;
+    DWORD   dwClientLimit = asyncClientLimit_;
+
+    if ((DWORD)InterlockedIncrement(&asyncTransactions_) > dwServerLimit && dwServerLimit) {
+        InterlockedDecrement(&asyncTransactions_);
+        InterlockedIncrement64(&asyncRejectedServer_);
+        if (InterlockedExchange(&asyncRejectLogged_, TRUE) == FALSE) {
+            LOGFMTW("Asynchronous transactions rejected, %lu transactions of all clients outstanding", dwServerLimit);
+        }
+        return E_OUTOFMEMORY;
+    }
+    if ((DWORD)InterlockedIncrement(&client->m_lAsyncTransactions) > dwClientLimit && dwClientLimit) {
+        InterlockedDecrement(&client->m_lAsyncTransactions);
+        InterlockedDecrement(&asyncTransactions_);
+        InterlockedIncrement64(&asyncRejectedClient_);
+        if (InterlockedExchange(&client->m_lAsyncRejectLogged, TRUE) == FALSE) {
+            LOGFMTW("Asynchronous transactions of a client rejected, %lu transactions of the client outstanding", dwClientLimit);
+        }
+        return CONNECT_E_ADVISELIMIT;
+    }
+    InterlockedIncrement64(&asyncAdmitted_);
+    if (client->m_lAsyncRejectLogged) {
+        InterlockedExchange(&client->m_lAsyncRejectLogged, FALSE);
+    }
+    if (asyncRejectLogged_) {
+        InterlockedExchange(&asyncRejectLogged_, FALSE);
+    }
+    return S_OK;
+}
+
+
+//=========================================================================
+// CompleteAsyncTransaction
+// ------------------------
+//=========================================================================
+void DaBaseServer::CompleteAsyncTransaction(DaGenericServer * client)
+{
+    InterlockedDecrement(&client->m_lAsyncTransactions);
+    InterlockedDecrement(&asyncTransactions_);
+}
+
+
+//=========================================================================
+// SetAsyncTransactionLimits
+// -------------------------
+//=========================================================================
+void DaBaseServer::SetAsyncTransactionLimits(DWORD clientLimit, DWORD serverLimit)
+{
+    asyncClientLimit_ = clientLimit;
+    asyncServerLimit_ = serverLimit;
+}
+
+
+//=========================================================================
+// GetAsyncAdmissionStatistics
+// ---------------------------
+//=========================================================================
+void DaBaseServer::GetAsyncAdmissionStatistics(DAASYNCADMISSIONSTATS * statistics)
+{
+    DATASKPOOLSTATS PoolStats;
+
+    asyncPool_.GetStatistics(&PoolStats);
+
+    statistics->dwClientLimit = asyncClientLimit_;
+    statistics->dwServerLimit = asyncServerLimit_;
+    statistics->dwOutstanding = (DWORD)max(asyncTransactions_, 0);
+    statistics->dwQueued = PoolStats.dwQueuedTasks;
+    statistics->ullAdmitted = (ULONGLONG)InterlockedCompareExchange64(&asyncAdmitted_, 0, 0);
+    statistics->ullRejectedClient = (ULONGLONG)InterlockedCompareExchange64(&asyncRejectedClient_, 0, 0);
+    statistics->ullRejectedServer = (ULONGLONG)InterlockedCompareExchange64(&asyncRejectedServer_, 0, 0);
+}
+
+
+//=========================================================================
+// SetCallbackQueueLimit
+// ---------------------
+//    Sets the maximum number of item values queued for delivery to a
+//    client. Applies to the connected and to new clients.
+//=========================================================================
+void DaBaseServer::SetCallbackQueueLimit(DWORD callbackQueueLimit)
+{
+    long                idx;
+    HRESULT             res;
+    DaGenericServer    *serv;
+
+    EnterCriticalSection(&serversCriticalSection_);
+    callbackQueueLimit_ = callbackQueueLimit;
+
+    res = servers_.First(&idx);
+    while (SUCCEEDED(res)) {
+        servers_.GetElem(idx, &serv);
+        serv->m_CallbackQueue.SetLimit(callbackQueueLimit);
+        res = servers_.Next(idx, &idx);
+    }
+    LeaveCriticalSection(&serversCriticalSection_);
+}
+
+
+//=========================================================================
+// GetCallbackQueueLimit
+// ---------------------
+//=========================================================================
+DWORD DaBaseServer::GetCallbackQueueLimit(void)
+{
+    EnterCriticalSection(&serversCriticalSection_);
+    DWORD limit = callbackQueueLimit_;
+    LeaveCriticalSection(&serversCriticalSection_);
+    return limit;
+}
+
+
+
 //=========================================================================
 // Set the Name of the Server
 // --------------------------
@@ -28,6 +28,10 @@
 #include "DaItemProperty.h"
 #include "DaDeviceItem.h" 
 #include "IClassicBaseNodeManager.h" 
+#include "DaUpdatePool.h"
+#include "DaCallbackQueue.h"
+#include "DaTaskPool.h"
+#include "DaDeviceReadCoalescer.h"
 
 /**
  * @typedef enum tagOPC_REFRESH_REASON
@@ -53,6 +57,54 @@ typedef enum tagOPC_VALIDATE_REQUEST {
     OPC_VALIDATEREQ_DEVICEITEMS
 } OPC_VALIDATE_REQUEST;
 
+/** @brief  Maximum factor (in percent) by which the group update rates are stretched if overloaded. */
+#define DA_UPDATE_MAX_STRETCH       1000
+
+/** @brief  Part of the base update rate (in percent) the update thread waits after an overrun. */
+#define DA_UPDATE_OVERRUN_PAUSE     10
+
+/** @brief  Default maximum number of outstanding asynchronous transactions of a client. */
+#define DA_ASYNC_DEFAULT_CLIENT_LIMIT   1000
+
+/** @brief  Default maximum number of outstanding asynchronous transactions of all clients. */
+#define DA_ASYNC_DEFAULT_SERVER_LIMIT   10000
+
+/**
+ * @typedef struct tagDAASYNCADMISSIONSTATS
+ *
+ * @brief   Limits and counters of the admission control for asynchronous transactions (see
+ *          DaBaseServer::AdmitAsyncTransaction()).
+ */
+
+typedef struct tagDAASYNCADMISSIONSTATS {
+    DWORD       dwClientLimit;          // maximum number of outstanding transactions of a client, 0 if unlimited
+    DWORD       dwServerLimit;          // maximum number of outstanding transactions of all clients, 0 if unlimited
+    DWORD       dwOutstanding;          // admitted transactions which are not yet completed
+    DWORD       dwQueued;               // transactions waiting for a worker thread of the transaction pool
+    ULONGLONG   ullAdmitted;            // number of admitted transactions
+    ULONGLONG   ullRejectedClient;      // transactions rejected with CONNECT_E_ADVISELIMIT (client limit)
+    ULONGLONG   ullRejectedServer;      // transactions rejected with E_OUTOFMEMORY (server limit)
+} DAASYNCADMISSIONSTATS;
+
+/**
+ * @typedef struct tagDAUPDATECYCLESTATS
+ *
+ * @brief   Cost and overload state of the periodic update cycle (see
+ *          DaBaseServer::ReportUpdateCycle()).
+ */
+
+typedef struct tagDAUPDATECYCLESTATS {
+    DWORD       dwRefreshDuration;      // duration of the last input cache refresh in ms
+    DWORD       dwRefreshLoad;          // smoothed refresh duration in percent of the base update rate
+    DWORD       dwUpdateDuration;       // time in ms the update workers spent on client updates during the last interval
+    DWORD       dwUpdateInterval;       // length in ms of the last interval
+    DWORD       dwBacklog;              // groups still queued to the update workers when the last cycle started
+    DWORD       dwLoad;                 // smoothed update worker utilization in percent, drives dwStretch
+    DWORD       dwStretch;              // factor in percent by which the group update rates are stretched
+    ULONGLONG   ullCycles;              // number of update cycles
+    ULONGLONG   ullOverruns;            // number of cycles which exceeded the base update rate
+} DAUPDATECYCLESTATS;
+
 
 /////////////////////////////////////////////////////////////////////////////////
 //
@@ -299,6 +351,11 @@ public:
      * @brief   Use the members of this object to lock and unlock critical sections to allow the
      *          reading and writing of consistent data, avoiding interferences with some Refresh
      *          threads.
+     *
+     *          Single value updates (SetItemValue() of the plugin interface) don't use this lock;
+     *          the value cache of each Device Item is protected by the item itself. The lock only
+     *          makes the updates of a whole OnRefreshInputCache() / OnWriteItems() batch appear
+     *          atomic to the readers.
      */
 
     ReadWriteLock           readWriteLock_;
@@ -406,6 +463,111 @@ private:
 
     DWORD baseUpdateRate_;
 
+    /**
+     * @brief	number of worker threads of the update pool; 0 means one thread per processor.
+     */
+
+    DWORD updateThreadCount_;
+
+    /**
+     * @brief	maximum number of item values queued for delivery to a client.
+     */
+
+    DWORD callbackQueueLimit_;
+
+    /**
+     * @brief	cost of the update cycle and overload state, protected by criticalSection_.
+     */
+
+    DAUPDATECYCLESTATS updateCycleStats_;
+
+    /**
+     * @brief	factor in percent by which the group update rates are stretched; 100 if not
+     * 			overloaded. Read without lock by the update workers.
+     */
+
+    volatile LONG updateStretch_;
+
+    /**
+     * @brief	tick count when the load of the update pool was taken the last time; 0 before
+     * 			the first update cycle. Protected by criticalSection_.
+     */
+
+    ULONGLONG updateLoadTick_;
+
+    /**
+     * @brief	the worker threads shared by all server instances attached to this class handler
+     * 			which send the group updates to the clients. Started by Create().
+     */
+
+    DaUpdatePool updatePool_;
+
+    /**
+     * @brief	number of threads of the callback delivery pool; 0 means two threads per
+     * 			processor.
+     */
+
+    DWORD deliveryThreadCount_;
+
+    /**
+     * @brief	the threads shared by all server instances attached to this class handler which
+     * 			invoke the OnDataChange callbacks queued by the update workers. Started by
+     * 			Create().
+     */
+
+    DaTaskPool deliveryPool_;
+
+    /**
+     * @brief	number of worker threads of the asynchronous transaction pool; 0 means two
+     * 			threads per processor.
+     */
+
+    DWORD asyncThreadCount_;
+
+    /**
+     * @brief	the worker threads shared by all server instances attached to this class handler
+     * 			which execute the asynchronous read, write and refresh transactions. Started by
+     * 			Create().
+     */
+
+    DaTaskPool asyncPool_;
+
+    /**
+     * @brief	maximum number of outstanding asynchronous transactions of a client and of all
+     * 			clients; 0 if unlimited. Read without lock.
+     */
+
+    volatile DWORD asyncClientLimit_;
+    volatile DWORD asyncServerLimit_;
+
+    /** @brief	number of outstanding asynchronous transactions of all clients. */
+    volatile LONG asyncTransactions_;
+
+    /** @brief	admission counters, see DAASYNCADMISSIONSTATS. */
+    volatile LONGLONG asyncAdmitted_;
+    volatile LONGLONG asyncRejectedClient_;
+    volatile LONGLONG asyncRejectedServer_;
+
+    /**
+     * @brief	TRUE if a transaction rejected by the server limit has been logged; reset by the
+     * 			next admitted transaction.
+     */
+
+    volatile LONG asyncRejectLogged_;
+
+    /**
+     * @brief	merges the device reads of concurrent client requests for the same items.
+     */
+
+    DaDeviceReadCoalescer deviceReads_;
+
+    /**
+     * @brief	version of the address space, incremented by AddressSpaceChanged(). Read without
+     * 			lock.
+     */
+
+    volatile LONG addressSpaceVersion_;
+
     /** @brief	critical section for accessing members of this class. */
     CRITICAL_SECTION criticalSection_;
 
@@ -433,6 +595,291 @@ public:
 
     DWORD GetBaseUpdateRate(void);
 
+    /**
+     * @fn	HRESULT DaBaseServer::SetUpdateThreadCount(DWORD updateThreadCount);
+     *
+     * @brief	sets the number of worker threads which send the group updates to the clients of
+     * 			all server instances. The number of threads does not depend on the number of
+     * 			connected clients. Must be called before Create().
+     *
+     * @param	updateThreadCount	The number of threads; 0 means one thread per processor
+     * 								(default).
+     *
+     * @return	A hResult.
+     */
+
+    HRESULT SetUpdateThreadCount(DWORD updateThreadCount);
+
+    /**
+     * @fn	DWORD DaBaseServer::GetUpdateThreadCount(void);
+     *
+     * @brief	gets the number of worker threads which send the group updates to the clients.
+     *
+     * @return	The number of running threads or the configured number if the server class
+     * 			handler is not yet created.
+     */
+
+    DWORD GetUpdateThreadCount(void);
+
+    /**
+     * @fn	HRESULT DaBaseServer::SetDeliveryThreadCount(DWORD deliveryThreadCount);
+     *
+     * @brief	sets the number of threads which deliver the OnDataChange callbacks to the
+     * 			clients of all server instances. A client which doesn't return from a callback
+     * 			blocks one of these threads; the update workers are never blocked by a client.
+     * 			Must be called before Create().
+     *
+     * @param	deliveryThreadCount	The number of threads; 0 means two threads per processor
+     * 								but at least DA_TASKPOOL_MIN_THREADS (default).
+     *
+     * @return	A hResult.
+     */
+
+    HRESULT SetDeliveryThreadCount(DWORD deliveryThreadCount);
+
+    /**
+     * @fn	DWORD DaBaseServer::GetDeliveryThreadCount(void);
+     *
+     * @brief	gets the number of threads which deliver the OnDataChange callbacks.
+     *
+     * @return	The number of running threads or the configured number if the server class
+     * 			handler is not yet created.
+     */
+
+    DWORD GetDeliveryThreadCount(void);
+
+    /**
+     * @fn	HRESULT DaBaseServer::SubmitDelivery(DATASKPROC dispatcher, void* client);
+     *
+     * @brief	queues the dispatcher of the callback queue of a client to the delivery pool.
+     *
+     * @param	dispatcher  	The function which delivers the queued callbacks.
+     * @param [in]	client  	The client passed to the function.
+     *
+     * @return	S_OK if queued; otherwise the dispatcher is not executed.
+     */
+
+    HRESULT SubmitDelivery(DATASKPROC dispatcher, void* client) { return deliveryPool_.Submit(dispatcher, client); }
+
+    /**
+     * @fn	void DaBaseServer::GetDeliveryPoolStatistics(DATASKPOOLSTATS * statistics);
+     *
+     * @brief	gets the counters of the callback delivery pool.
+     *
+     * @param [out]	statistics	The statistics.
+     */
+
+    void GetDeliveryPoolStatistics(DATASKPOOLSTATS * statistics) { deliveryPool_.GetStatistics(statistics); }
+
+    /**
+     * @fn	HRESULT DaBaseServer::SetAsyncThreadCount(DWORD asyncThreadCount);
+     *
+     * @brief	sets the number of worker threads which execute the asynchronous read, write and
+     * 			refresh transactions of all server instances. The number of threads does not
+     * 			depend on the number of outstanding transactions. Must be called before
+     * 			Create().
+     *
+     * @param	asyncThreadCount	The number of threads; 0 means two threads per processor but
+     * 								at least DA_TASKPOOL_MIN_THREADS (default).
+     *
+     * @return	A hResult.
+     */
+
+    HRESULT SetAsyncThreadCount(DWORD asyncThreadCount);
+
+    /**
+     * @fn	DWORD DaBaseServer::GetAsyncThreadCount(void);
+     *
+     * @brief	gets the number of worker threads which execute the asynchronous transactions.
+     *
+     * @return	The number of running threads or the configured number if the server class
+     * 			handler is not yet created.
+     */
+
+    DWORD GetAsyncThreadCount(void);
+
+    /**
+     * @fn	HRESULT DaBaseServer::SubmitAsyncTransaction(DATASKPROC transactionHandler, void* transaction);
+     *
+     * @brief	queues an asynchronous transaction for execution by the transaction pool.
+     *
+     * @param	transactionHandler	The function which executes the transaction.
+     * @param [in]	transaction   	The transaction passed to the function.
+     *
+     * @return	S_OK if queued; otherwise the transaction is not executed.
+     */
+
+    HRESULT SubmitAsyncTransaction(DATASKPROC transactionHandler, void* transaction) { return asyncPool_.Submit(transactionHandler, transaction); }
+
+    /**
+     * @fn	void DaBaseServer::GetAsyncPoolStatistics(DATASKPOOLSTATS * statistics);
+     *
+     * @brief	gets the counters of the asynchronous transaction pool.
+     *
+     * @param [out]	statistics	The statistics.
+     */
+
+    void GetAsyncPoolStatistics(DATASKPOOLSTATS * statistics) { asyncPool_.GetStatistics(statistics); }
+
+    /**
+     * @fn	HRESULT DaBaseServer::AdmitAsyncTransaction(DaGenericServer * client);
+     *
+     * @brief	admits a new asynchronous transaction of a client. Must be called before the
+     * 			transaction is queued; each admitted transaction must be completed with
+     * 			CompleteAsyncTransaction().
+     *
+     * @param [in]	client	The client which requests the transaction.
+     *
+     * @return	S_OK if admitted; CONNECT_E_ADVISELIMIT if the client has reached its limit of
+     * 			outstanding transactions; E_OUTOFMEMORY if the limit of all clients is reached.
+     */
+
+    HRESULT AdmitAsyncTransaction(DaGenericServer * client);
+
+    /**
+     * @fn	void DaBaseServer::CompleteAsyncTransaction(DaGenericServer * client);
+     *
+     * @brief	releases the admission of a completed, canceled or discarded transaction.
+     *
+     * @param [in]	client	The client of the transaction.
+     */
+
+    void CompleteAsyncTransaction(DaGenericServer * client);
+
+    /**
+     * @fn	void DaBaseServer::SetAsyncTransactionLimits(DWORD clientLimit, DWORD serverLimit);
+     *
+     * @brief	sets the maximum number of outstanding asynchronous transactions (read, write,
+     * 			refresh). Further requests are rejected until transactions are completed.
+     * 			Applies to new requests of all clients.
+     *
+     * @param	clientLimit	The maximum per client; 0 if unlimited. The default is
+     * 						DA_ASYNC_DEFAULT_CLIENT_LIMIT.
+     * @param	serverLimit	The maximum of all clients; 0 if unlimited. The default is
+     * 						DA_ASYNC_DEFAULT_SERVER_LIMIT.
+     */
+
+    void SetAsyncTransactionLimits(DWORD clientLimit, DWORD serverLimit);
+
+    /**
+     * @fn	void DaBaseServer::GetAsyncAdmissionStatistics(DAASYNCADMISSIONSTATS * statistics);
+     *
+     * @brief	gets the limits, the outstanding and queued transactions and the rejection
+     * 			counters of the asynchronous transactions.
+     *
+     * @param [out]	statistics	The statistics.
+     */
+
+    void GetAsyncAdmissionStatistics(DAASYNCADMISSIONSTATS * statistics);
+
+    /**
+     * @fn	HRESULT DaBaseServer::RefreshInputCacheCoalesced(DWORD numItems, DaDeviceItem ** deviceItems, HRESULT * errors);
+     *
+     * @brief	refreshes the cache of the specified items from the device for a client request
+     * 			(OnRefreshInputCache() with OPC_REFRESH_CLIENT). An item which is already being
+     * 			read for another request is not read again; the request waits for that read.
+     * 			The other items of requests arriving within the coalescing window are read
+     * 			with a single OnRefreshInputCache() call.
+     *
+     * @param	numItems			The number of items.
+     * @param [in]	deviceItems	The items; may contain NULL pointers.
+     * @param [in,out]	errors 	The errors; only set for failed items.
+     *
+     * @return	S_OK or S_FALSE if there are one or more errors in errors.
+     */
+
+    HRESULT RefreshInputCacheCoalesced(DWORD numItems, DaDeviceItem ** deviceItems, HRESULT * errors) { return deviceReads_.Refresh(this, numItems, deviceItems, errors); }
+
+    /**
+     * @fn	void DaBaseServer::SetDeviceReadCoalescingWindow(DWORD coalescingWindow);
+     *
+     * @brief	sets the time a device read for a client request waits for other requests whose
+     * 			items are read together. A longer window saves device accesses but delays the
+     * 			reads: the window is a Sleep() on the thread of the client request which opens
+     * 			the read.
+     *
+     * @param	coalescingWindow	The time in ms, at most DA_DEVICEREAD_MAX_WINDOW; 0 merges
+     * 								only requests for items which are already being read
+     * 								(default).
+     */
+
+    void SetDeviceReadCoalescingWindow(DWORD coalescingWindow) { deviceReads_.SetWindow(coalescingWindow); }
+
+    /**
+     * @fn	DWORD DaBaseServer::GetDeviceReadCoalescingWindow(void);
+     *
+     * @brief	gets the coalescing window of the device reads in ms.
+     *
+     * @return	The coalescing window.
+     */
+
+    DWORD GetDeviceReadCoalescingWindow(void) { return deviceReads_.GetWindow(); }
+
+    /**
+     * @fn	void DaBaseServer::GetDeviceReadStatistics(DADEVICEREADSTATS * statistics);
+     *
+     * @brief	gets the counters of the device reads for client requests.
+     *
+     * @param [out]	statistics	The statistics.
+     */
+
+    void GetDeviceReadStatistics(DADEVICEREADSTATS * statistics) { deviceReads_.GetStatistics(statistics); }
+
+    /**
+     * @fn	void DaBaseServer::GetDeviceItemMemoryStatistics(DADEVICEITEMMEMSTATS * statistics);
+     *
+     * @brief	gets the memory used by the device items, including the average number of bytes
+     * 			per item.
+     *
+     * @param [out]	statistics	The statistics.
+     */
+
+    void GetDeviceItemMemoryStatistics(DADEVICEITEMMEMSTATS * statistics) { DaDeviceItem::GetMemoryStatistics(statistics); }
+
+    /**
+     * @fn	void DaBaseServer::AddressSpaceChanged(void);
+     *
+     * @brief	must be called by the server-specific part after branches or items were added to
+     * 			or removed from the browse hierarchy. The elements kept for the continuation
+     * 			points of IOPCBrowse::Browse are then browsed again.
+     */
+
+    void AddressSpaceChanged(void) { InterlockedIncrement(&addressSpaceVersion_); }
+
+    /**
+     * @fn	LONG DaBaseServer::GetAddressSpaceVersion(void);
+     *
+     * @brief	gets the version of the address space which changes with each
+     * 			AddressSpaceChanged() call.
+     *
+     * @return	The version.
+     */
+
+    LONG GetAddressSpaceVersion(void) { return addressSpaceVersion_; }
+
+    /**
+     * @fn	void DaBaseServer::SetCallbackQueueLimit(DWORD callbackQueueLimit);
+     *
+     * @brief	sets the maximum number of item values queued for delivery to a client. The
+     * 			OnDataChange callbacks are queued per client; a newer value of a queued item
+     * 			replaces the older one. If the limit is reached further values are dropped and
+     * 			sent with a later update. Applies to the connected and to new clients.
+     *
+     * @param	callbackQueueLimit	The maximum number of queued item values per client.
+     */
+
+    void SetCallbackQueueLimit(DWORD callbackQueueLimit);
+
+    /**
+     * @fn	DWORD DaBaseServer::GetCallbackQueueLimit(void);
+     *
+     * @brief	gets the maximum number of item values queued for delivery to a client.
+     *
+     * @return	The maximum number of queued item values per client.
+     */
+
+    DWORD GetCallbackQueueLimit(void);
+
     /**
      * @fn	virtual HRESULT DaBaseServer::ReviseUpdateRate( DWORD requestedUpdateRate, DWORD *revisedUpdateRate);
      *
@@ -454,7 +901,9 @@ public:
      * @fn	HRESULT DaBaseServer::UpdateServerClassInstances();
      *
      * @brief	this method should be called each  baseUpdateRate_  millisec to trigger the advise
-     * 			mechanism to the clients;
+     * 			mechanism to the clients; the groups which are due are queued to the update
+     * 			worker pool and this method doesn't wait until the updates are sent; the
+     * 			load of the pool since the previous call is taken for ReportUpdateCycle();
      * 			it's not virtual because only methods of this class can access the list of server
      * 			attached to this handler (servers_), application specific derivations won't have
      * 			access to it and cannot therefore update the clients.
@@ -464,6 +913,51 @@ public:
 
     HRESULT UpdateServerClassInstances();
 
+    /**
+     * @fn	DWORD DaBaseServer::ReportUpdateCycle(DWORD refreshDuration, DWORD updateDuration);
+     *
+     * @brief	reports the cost of an update cycle and applies the overload policy. Should be
+     * 			called by the update thread after each cycle of RefreshInputCache() and
+     * 			UpdateServerClassInstances().
+     * 			
+     * 			The overload is measured where the client updates are done: the busy time and
+     * 			the backlog of the update worker pool taken by UpdateServerClassInstances().
+     * 			If the smoothed utilization of the workers exceeds 100% the effective update
+     * 			rates of all groups are stretched proportionally (up to DA_UPDATE_MAX_STRETCH);
+     * 			if the load drops the rates are recovered step by step. The refresh duration
+     * 			is reported separately in the statistics and doesn't stretch the rates.
+     *
+     * @param	refreshDuration	The duration of the input cache refresh in ms.
+     * @param	updateDuration 	The duration of UpdateServerClassInstances() in ms, i.e. the
+     * 							time to queue the due groups to the update workers.
+     *
+     * @return	The time in ms to wait until the next cycle should be started. After an
+     * 			overrun of the update thread the update workers get DA_UPDATE_OVERRUN_PAUSE
+     * 			percent of the base update rate.
+     */
+
+    DWORD ReportUpdateCycle(DWORD refreshDuration, DWORD updateDuration);
+
+    /**
+     * @fn	DWORD DaBaseServer::GetUpdateStretch(void);
+     *
+     * @brief	gets the factor by which the group update rates are stretched.
+     *
+     * @return	The factor in percent; 100 if the server is not overloaded.
+     */
+
+    DWORD GetUpdateStretch(void) { return (DWORD)updateStretch_; }
+
+    /**
+     * @fn	void DaBaseServer::GetUpdateCycleStatistics(DAUPDATECYCLESTATS * statistics);
+     *
+     * @brief	gets the cost of the update cycle and the overload state.
+     *
+     * @param [out]	statistics	The statistics.
+     */
+
+    void GetUpdateCycleStatistics(DAUPDATECYCLESTATS * statistics);
+
 
     /**
     * @fn	HRESULT DaBaseServer::QueryInterfaceOnServerFromList( SRVINSTHANDLE server, BOOL & serverExist, REFIID refId, LPVOID * unkown)
@@ -499,7 +993,11 @@ public:
     inline
         HRESULT AddItemProperty(DaItemProperty* pProp)
     {
-        return itemProperties_.PutElem(itemProperties_.New(), pProp);
+        long idx = itemProperties_.New();
+        if (idx == -1) {                        // maximum number of properties reached
+            return E_OUTOFMEMORY;
+        }
+        return itemProperties_.PutElem(idx, pProp);
     }
 
     // Fires a 'Shutdown Request' to all subscribed clients
@@ -513,6 +1011,18 @@ public:
 
 	void GetItemStates(void * groupHandle, int * numDaItemStates, IClassicBaseNodeManager::DaItemState* * daItemStates);
 
+    // Returns the effective update rate of a group and how far the last update was behind schedule (in ms).
+    void GetGroupUpdateTiming(void * groupHandle, DWORD * effectiveUpdateRate, DWORD * updateLag);
+
+    // Returns the counters of the callback queue of a client (delivered, conflated and dropped updates).
+    void GetCallbackQueueStatistics(void * clientHandle, DACALLBACKQUEUESTATS * statistics);
+
+    // Returns the number of outstanding asynchronous transactions of a client.
+    DWORD GetClientAsyncTransactions(void * clientHandle);
+
+    // Returns the number of generic items subscribed to a device item and the number of active ones.
+    void GetItemSubscriberCount(void * deviceItemHandle, int * numSubscribers, int * numActiveSubscribers);
+
 private:
     /** @brief	Index of the Server Instance. */
     int   instanceIndex_;
@@ -415,10 +415,6 @@ STDMETHODIMP DaBrowse::BrowseAccessPaths(
 //////////////////////////// IOPCBrowse ///////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////
 
-// Tokens to generate unique Continuation Points
-#define BRANCHTOKENSTRING  L"BRANCH#{81aac52d-b4bb-42d1-94e4-3eca1fd3c45b}#"
-#define ITEMTOKENSTRING    L"ITEM#{2f6b782d-50a8-434c-95bf-5d5854a00259}#"
-
 //=========================================================================
 // IOPCBrowse::GetProperties                                      INTERFACE
 // -------------------------
@@ -602,6 +598,14 @@ STDMETHODIMP DaBrowse::GetProperties(
 // ------------------
 //    Browses a single branch of the Server Address Spacend returns zero
 //    ore more elements of structure OPCBROWSEELEMENT.
+//
+//    If not all elements can be returned then the elements are kept in
+//    a snapshot and the Continuation Point is a cursor in the snapshot.
+//    A following call with this Continuation Point resumes at the cursor
+//    without browsing the address space again. If the snapshot is no
+//    longer valid (other parameters, address space changed, snapshot
+//    replaced by another browse) then the elements are browsed again and
+//    the call resumes at the element with the name stored in the cursor.
 //=========================================================================
 STDMETHODIMP DaBrowse::Browse(
 	/* [string][in] */            LPWSTR               szItemID,
@@ -622,6 +626,10 @@ STDMETHODIMP DaBrowse::Browse(
 	DWORD    dwNumOfBranchIDs = 0;
 	BSTR*    pItemIDs = NULL;
 	BSTR*    pBranchIDs = NULL;
+	BOOL     fSnapshot = FALSE;                  // The Element IDs are owned by the snapshot
+	BOOL     fMoreElements = FALSE;              // Not all elements are returned
+	DWORD    dwFirst = 0;                        // Index of the first returned element
+	DWORD    dwNumOfElements = 0;
 	HRESULT  hr = S_OK;
 
 	LOGFMTI("IOPCBrowse::Browse");
@@ -631,6 +639,8 @@ STDMETHODIMP DaBrowse::Browse(
 	*ppBrowseElements = NULL;
 
 	OPCBROWSEELEMENT* pElements = NULL;
+
+	EnterCriticalSection(&m_csSnapshot);
 	try {
 		// Check Parameters
 		if ((dwBrowseFilter != OPC_BROWSE_FILTER_ALL) &&
@@ -650,116 +660,114 @@ STDMETHODIMP DaBrowse::Browse(
 
 
 		//
-		// Change current position to the specified position
+		// Resume at the cursor if the Continuation Point refers to the snapshot
 		//
-		{
-			// Use current position as initial position.
-			BSTR bstrNewPosition = m_pBrowseData->m_bstrServerBrowsePosition3;
+		LPCWSTR szElementCP = *pszContinuationPoint;
+		if (**pszContinuationPoint != L'\0') {
+			fSnapshot = m_Snapshot.Find(*pszContinuationPoint, m_pServerHandler->GetAddressSpaceVersion(),
+				dwBrowseFilter, m_pBrowseData->m_bstrServerBrowsePosition3, szElementNameFilter, szVendorFilter,
+				&dwFirst, &szElementCP);
+		}
 
-			if (**pszContinuationPoint == L'\0') {
-				// There is no Continuation Point specified
+		// Version of the browsed elements; read before browsing to detect changes in the meantime
+		LONG lVersion = m_pServerHandler->GetAddressSpaceVersion();
 
-// Change current position to the specified position
-				hr = m_pServerHandler->OnBrowseChangeAddressSpacePosition(
-					OPC_BROWSE_TO,
-					szItemID,
-					&bstrNewPosition,
-					&m_pBrowseData->m_pCustomData);
-				if (FAILED(hr)) {
-					if (hr != E_OUTOFMEMORY) throw OPC_E_UNKNOWNITEMID;
-					throw hr;
-				}
-
-				// Store the new position
-				SysFreeString(m_pBrowseData->m_bstrServerBrowsePosition3);
-				m_pBrowseData->m_bstrServerBrowsePosition3 = bstrNewPosition;
-			}
+		if (fSnapshot) {
+			dwNumOfBranchIDs = m_Snapshot.GetNumOfBranchIDs();
+			pBranchIDs = m_Snapshot.GetBranchIDs();
+			dwNumOfItemIDs = m_Snapshot.GetNumOfItemIDs();
+			pItemIDs = m_Snapshot.GetItemIDs();
 		}
+		else {
+			//
+			// Change current position to the specified position
+			//
+			{
+				// Use current position as initial position.
+				BSTR bstrNewPosition = m_pBrowseData->m_bstrServerBrowsePosition3;
 
+				if (**pszContinuationPoint == L'\0') {
+					// There is no Continuation Point specified
 
-		//
-		// Read the requested Elements from the current position
-		//
+// Change current position to the specified position
+					hr = m_pServerHandler->OnBrowseChangeAddressSpacePosition(
+						OPC_BROWSE_TO,
+						szItemID,
+						&bstrNewPosition,
+						&m_pBrowseData->m_pCustomData);
+					if (FAILED(hr)) {
+						if (hr != E_OUTOFMEMORY) throw OPC_E_UNKNOWNITEMID;
+						throw hr;
+					}
 
-		if (dwBrowseFilter == OPC_BROWSE_FILTER_ALL || dwBrowseFilter == OPC_BROWSE_FILTER_BRANCHES) {
+					// Store the new position
+					SysFreeString(m_pBrowseData->m_bstrServerBrowsePosition3);
+					m_pBrowseData->m_bstrServerBrowsePosition3 = bstrNewPosition;
+				}
+			}
 
-			hr = m_pServerHandler->OnBrowseItemIdentifiers(
-				m_pBrowseData->m_bstrServerBrowsePosition3,
-				OPC_BRANCH,
-				szVendorFilter,
-				VT_EMPTY,   // Data Type Filter off
-				0,          // Access Rights Filter off
-				&dwNumOfBranchIDs,
-				&pBranchIDs,
-				&m_pBrowseData->m_pCustomData);
 
-			_OPC_CHECK_HR(hr);                 // Cannot build a snapshot
-		}
+			//
+			// Read the requested Elements from the current position
+			//
 
-		if (dwBrowseFilter == OPC_BROWSE_FILTER_ALL || dwBrowseFilter == OPC_BROWSE_FILTER_ITEMS) {
+			if (dwBrowseFilter == OPC_BROWSE_FILTER_ALL || dwBrowseFilter == OPC_BROWSE_FILTER_BRANCHES) {
 
-			hr = m_pServerHandler->OnBrowseItemIdentifiers(
-				m_pBrowseData->m_bstrServerBrowsePosition3,
-				OPC_LEAF,
-				szVendorFilter,
-				VT_EMPTY,   // Data Type Filter off
-				0,          // Access Rights Filter off
-				&dwNumOfItemIDs,
-				&pItemIDs,
-				&m_pBrowseData->m_pCustomData);
+				hr = m_pServerHandler->OnBrowseItemIdentifiers(
+					m_pBrowseData->m_bstrServerBrowsePosition3,
+					OPC_BRANCH,
+					szVendorFilter,
+					VT_EMPTY,   // Data Type Filter off
+					0,          // Access Rights Filter off
+					&dwNumOfBranchIDs,
+					&pBranchIDs,
+					&m_pBrowseData->m_pCustomData);
 
-			_OPC_CHECK_HR(hr);                 // Cannot build a snapshot
-		}
+				_OPC_CHECK_HR(hr);                 // Cannot build a snapshot
+			}
 
-		//
-		// Continuation Point Handling
-		//
-		// Discards all Elements in front of the specified Continuation Point
-		if (**pszContinuationPoint != L'\0') {
-			// A Continuation Point is specified
-// Check if the CP is a Branch-Element
-			if (wcsncmp(*pszContinuationPoint, BRANCHTOKENSTRING, wcslen(BRANCHTOKENSTRING)) == 0) {
+			if (dwBrowseFilter == OPC_BROWSE_FILTER_ALL || dwBrowseFilter == OPC_BROWSE_FILTER_ITEMS) {
 
-				LPCWSTR pBranch = &(*pszContinuationPoint)[wcslen(BRANCHTOKENSTRING)];
-				dwNumOfBranchIDs = RemoveElementsInFrontOfContinuationPoint(pBranch, dwNumOfBranchIDs, pBranchIDs);
+				hr = m_pServerHandler->OnBrowseItemIdentifiers(
+					m_pBrowseData->m_bstrServerBrowsePosition3,
+					OPC_LEAF,
+					szVendorFilter,
+					VT_EMPTY,   // Data Type Filter off
+					0,          // Access Rights Filter off
+					&dwNumOfItemIDs,
+					&pItemIDs,
+					&m_pBrowseData->m_pCustomData);
 
-				if (dwNumOfBranchIDs == 0)          // At least the CP should exist as Element if valid
-					hr = OPC_E_INVALIDCONTINUATIONPOINT;
+				_OPC_CHECK_HR(hr);                 // Cannot build a snapshot
 			}
-			// Check if the CP is a Leaf-Element
-			else if (wcsncmp(*pszContinuationPoint, ITEMTOKENSTRING, wcslen(ITEMTOKENSTRING)) == 0) {
-
-				LPCWSTR pItem = &(*pszContinuationPoint)[wcslen(ITEMTOKENSTRING)];
-				dwNumOfItemIDs = RemoveElementsInFrontOfContinuationPoint(pItem, dwNumOfItemIDs, pItemIDs);
 
-				if (dwNumOfItemIDs == 0)            // At least the CP should exist as Element if valid
-					hr = OPC_E_INVALIDCONTINUATIONPOINT;
-			}
-			else {                                 // Invalid CP sytnax
-				hr = OPC_E_INVALIDCONTINUATIONPOINT;
+			//
+			// Continuation Point Handling
+			//
+			// Discards all Elements in front of the specified Continuation Point
+			if (*szElementCP != L'\0') {
+				// A Continuation Point is specified
+				hr = DaBrowseSnapshot::ResumeAtElement(szElementCP,
+					&dwNumOfBranchIDs, pBranchIDs, &dwNumOfItemIDs, pItemIDs);
+				_OPC_CHECK_HR(hr);
 			}
 
-			_OPC_CHECK_HR(hr);
-
-			ComFreeString(*pszContinuationPoint);
-			*pszContinuationPoint = ComAllOPCtring(L"");
-			_OPC_CHECK_PTR(*pszContinuationPoint);
-		}
-
 
-		//
-		// Standard Filtering
-		//
-		if (*szElementNameFilter) {
-			dwNumOfBranchIDs = FilterElements(szElementNameFilter, dwNumOfBranchIDs, pBranchIDs);
-			dwNumOfItemIDs = FilterElements(szElementNameFilter, dwNumOfItemIDs, pItemIDs);
+			//
+			// Standard Filtering
+			//
+			if (*szElementNameFilter) {
+				dwNumOfBranchIDs = FilterElements(szElementNameFilter, dwNumOfBranchIDs, pBranchIDs);
+				dwNumOfItemIDs = FilterElements(szElementNameFilter, dwNumOfItemIDs, pItemIDs);
+			}
 		}
 
 
 		//
 		// Result Limitation
 		//
-		DWORD dwNumOfElements = dwNumOfBranchIDs + dwNumOfItemIDs;
+		DWORD dwNumOfAllElements = dwNumOfBranchIDs + dwNumOfItemIDs;
+		dwNumOfElements = dwNumOfAllElements - dwFirst;
 
 		if (dwMaxElementsReturned) {
 			if (dwNumOfElements > dwMaxElementsReturned) {
@@ -768,36 +776,62 @@ STDMETHODIMP DaBrowse::Browse(
 		}
 
 
+		//
+		// New Continuation Point
+		//
+		DWORD dwNext = dwFirst + dwNumOfElements;
+		fMoreElements = (dwNext < dwNumOfAllElements);
+		if (fMoreElements) {
+			// Keep the elements for the following calls. Without snapshot
+			// the Continuation Point is the name of the next element.
+			BOOL fCursor = TRUE;
+			if (!fSnapshot) {
+				fCursor = SUCCEEDED(m_Snapshot.Save(lVersion, dwBrowseFilter,
+					m_pBrowseData->m_bstrServerBrowsePosition3, szElementNameFilter, szVendorFilter,
+					dwNumOfBranchIDs, pBranchIDs, dwNumOfItemIDs, pItemIDs));
+				fSnapshot = fCursor;
+			}
+			hr = m_Snapshot.SetContinuationPoint(fCursor, dwNext, dwNumOfBranchIDs, pBranchIDs, pItemIDs, pszContinuationPoint);
+			_OPC_CHECK_HR(hr);
+		}
+		else if (**pszContinuationPoint != L'\0') {
+			ComFreeString(*pszContinuationPoint);
+			*pszContinuationPoint = ComAllOPCtring(L"");
+			_OPC_CHECK_PTR(*pszContinuationPoint);
+		}
+
+
 		//
 		// Initialize Result Buffer
 		//
-		OPCBROWSEELEMENT* pElements = ComAlloc<OPCBROWSEELEMENT>(dwNumOfElements);
+		pElements = ComAlloc<OPCBROWSEELEMENT>(dwNumOfElements);
 		_OPC_CHECK_PTR(pElements)
 
 			memset(pElements, 0, dwNumOfElements * sizeof(OPCBROWSEELEMENT));
 
 
 		DWORD dwBrowseElementCount = 0;
-		hr = MoveElementIDsToBrowseElements(
-			OPC_BROWSE_HASCHILDREN,
-			dwNumOfBranchIDs,
-			pBranchIDs,
-			dwNumOfElements,
-			&dwBrowseElementCount,
-			pElements,
-			pszContinuationPoint,
-			// We have no Properties for Branches
-			FALSE, FALSE, 0, NULL);
-		_OPC_CHECK_HR(hr);
+		if (dwFirst < dwNumOfBranchIDs) {
+			hr = MoveElementIDsToBrowseElements(
+				OPC_BROWSE_HASCHILDREN,
+				dwNumOfBranchIDs - dwFirst,
+				&pBranchIDs[dwFirst],
+				dwNumOfElements,
+				&dwBrowseElementCount,
+				pElements,
+				// We have no Properties for Branches
+				FALSE, FALSE, 0, NULL);
+			_OPC_CHECK_HR(hr);
+		}
 
+		DWORD dwFirstItem = (dwFirst > dwNumOfBranchIDs) ? dwFirst - dwNumOfBranchIDs : 0;
 		hr = MoveElementIDsToBrowseElements(
 			OPC_BROWSE_ISITEM,
-			dwNumOfItemIDs,
-			pItemIDs,
+			dwNumOfItemIDs - dwFirstItem,
+			pItemIDs + dwFirstItem,
 			dwNumOfElements,
 			&dwBrowseElementCount,
 			pElements,
-			pszContinuationPoint,
 			// Properties Handling
 			bReturnAllProperties,
 			bReturnPropertyValues,
@@ -824,12 +858,14 @@ STDMETHODIMP DaBrowse::Browse(
 	}
 
 	// Release temporary used resources
-	if (pBranchIDs != NULL) {
-		delete[] pBranchIDs;            // Note: Elements are already released
+	if (!fSnapshot) {
+		DaBrowseSnapshot::ReleaseElementIDs(dwNumOfBranchIDs, pBranchIDs);
+		DaBrowseSnapshot::ReleaseElementIDs(dwNumOfItemIDs, pItemIDs);
 	}
-	if (pItemIDs != NULL) {
-		delete[] pItemIDs;
+	else if (!fMoreElements && SUCCEEDED(hr)) {
+		m_Snapshot.Release();                    // All elements returned
 	}
+	LeaveCriticalSection(&m_csSnapshot);
 
 	return hr;
 }
@@ -987,21 +1023,20 @@ HRESULT DaBrowse::GetRevisedPropertyIDs(
 //    specified Element IDs as source.
 //
 //    - The number of elements to be copied can be specified.
-//    - All specified Element IDs are released (in any case)
+//    - The specified Element IDs are not released.
 //    - If something goes wrong then all OPCBROWSEELEMENTS are released
 //       (also the OPCBROWSEELEMENTS initialized by previous calls)
 //    - Only elements are removed from the arrays and not the
 //       arrays itself.
 //
 // Parameters:
-//    dwElementType           The type of the Element IDs specified in 
-//                            pElementIDs. Valid values are 
+//    dwElementType           The type of the Element IDs specified in
+//                            pElementIDs. Valid values are
 //                            OPC_BROWSE_HASCHILDREN and OPC_BROWSE_ISITEM.
 //    dwNumOfElementIDs       The number of Element IDs in pElementIDs.
 //    pElementIDs             The Element IDs, Branch or Item Names
 //                            from the Server Address Space.
-//                            All strings are released.
-//    dwNumOfElements         The number of OPCBROWSEELEMENTS in 
+//    dwNumOfElements         The number of OPCBROWSEELEMENTS in
 //                            pElements (array size, counts initialized
 //                            and free elements). Ensure that the buffer
 //                            is initialized with 0 before first usage.
@@ -1012,9 +1047,6 @@ HRESULT DaBrowse::GetRevisedPropertyIDs(
 //    pElements               Array with the OPCBROWSEELEMENTS to be
 //                            initialized. Are all released if something
 //                            goes wrong.
-//    pszContinuationPoint    If not all specified Element IDs can be
-//                            'moved' then a 'Continuation Point' will
-//                            be set.
 //    Property Related Parameters
 //                            Identicall with parameters of
 //                            method GetProerties()
@@ -1029,7 +1061,6 @@ HRESULT DaBrowse::MoveElementIDsToBrowseElements(
 	/* [in] */                    const DWORD          dwNumOfElements,
 	/* [in,out] */                DWORD             *  pdwElementCount,
 	/* [in(dwNumOfElements)] */   OPCBROWSEELEMENT  *  pElements,
-	/* [in,out] */                LPWSTR            *  pszContinuationPoint,
 	// Property Related Parameters
 	/* [in] */                    const BOOL           bReturnAllProperties,
 	/* [in] */                    const BOOL           bReturnPropertyValues,
@@ -1045,87 +1076,67 @@ HRESULT DaBrowse::MoveElementIDsToBrowseElements(
 
 	try {
 
-		for (i = 0; i < dwNumOfElementIDs; i++) {
+		for (i = 0; i < dwNumOfElementIDs && *pdwElementCount < dwNumOfElements; i++) {
+
+			OPCBROWSEELEMENT* pEl = &pElements[*pdwElementCount];
+
+			pEl->szName = ComAllOPCtring(pElementIDs[i]);
+			_OPC_CHECK_PTR(pEl->szName);
 
-			if (*pdwElementCount < dwNumOfElements) {
+			BSTR bstrTmp = NULL;
+			hr = m_pServerHandler->OnBrowseGetFullItemIdentifier(
+				m_pBrowseData->m_bstrServerBrowsePosition3,
+				pElementIDs[i], &bstrTmp,
+				&m_pBrowseData->m_pCustomData);
+			_OPC_CHECK_HR(hr);
 
-				OPCBROWSEELEMENT* pEl = &pElements[*pdwElementCount];
+			pEl->szItemID = ComAllOPCtring(bstrTmp);
+			SysFreeString(bstrTmp);
+			_OPC_CHECK_PTR(pEl->szItemID);
 
-				pEl->szName = ComAllOPCtring(pElementIDs[i]);
-				_OPC_CHECK_PTR(pEl->szName);
+			pEl->dwFlagValue = dwElementType;
+			pEl->dwReserved = 0;
+
+			//
+			// Handle Properties
+			//
+			if (bReturnAllProperties || dwPropertyCount > 0) {
+
+				BSTR bstrFullyQualifiedItemID = NULL;
 
-				BSTR bstrTmp = NULL;
 				hr = m_pServerHandler->OnBrowseGetFullItemIdentifier(
 					m_pBrowseData->m_bstrServerBrowsePosition3,
-					pElementIDs[i], &bstrTmp,
+					pElementIDs[i],
+					&bstrFullyQualifiedItemID,
 					&m_pBrowseData->m_pCustomData);
 				_OPC_CHECK_HR(hr);
 
-				pEl->szItemID = ComAllOPCtring(bstrTmp);
-				SysFreeString(bstrTmp);
-				_OPC_CHECK_PTR(pEl->szItemID);
-
-				pEl->dwFlagValue = dwElementType;
-				pEl->dwReserved = 0;
+				OPCITEMPROPERTIES* pItemProperties = NULL;
 
-				//
-				// Handle Properties
-				//
-				if (bReturnAllProperties || dwPropertyCount > 0) {
+				hr = GetProperties(1,
+					&bstrFullyQualifiedItemID,
+					bReturnPropertyValues,
+					dwPropertyCount,
+					pdwPropertyIDs,
+					&pItemProperties);
 
-					BSTR bstrFullyQualifiedItemID = NULL;
-
-					hr = m_pServerHandler->OnBrowseGetFullItemIdentifier(
-						m_pBrowseData->m_bstrServerBrowsePosition3,
-						pElementIDs[i],
-						&bstrFullyQualifiedItemID,
-						&m_pBrowseData->m_pCustomData);
-					_OPC_CHECK_HR(hr);
-
-					OPCITEMPROPERTIES* pItemProperties = NULL;
-
-					hr = GetProperties(1,
-						&bstrFullyQualifiedItemID,
-						bReturnPropertyValues,
-						dwPropertyCount,
-						pdwPropertyIDs,
-						&pItemProperties);
-
-					SysFreeString(bstrFullyQualifiedItemID);
-					_OPC_CHECK_HR(hr);
-					if (hr == S_FALSE)
-					{
-						hrReturn = S_FALSE;
-					}
-
-					pEl->ItemProperties = *pItemProperties;
-					ComFree(pItemProperties);
-				}
-				else {
-					pEl->ItemProperties.dwNumProperties = 0;
-					pEl->ItemProperties.pItemProperties = ComAlloc<OPCITEMPROPERTY>(0);
-					_OPC_CHECK_PTR(pEl->ItemProperties.pItemProperties);
+				SysFreeString(bstrFullyQualifiedItemID);
+				_OPC_CHECK_HR(hr);
+				if (hr == S_FALSE)
+				{
+					hrReturn = S_FALSE;
 				}
 
-				(*pdwElementCount)++;
+				pEl->ItemProperties = *pItemProperties;
+				ComFree(pItemProperties);
 			}
-			else if (**pszContinuationPoint == L'\0') {
-				WideString wsTemp;                 // Continuation Point is not yet set
-
-				LPCWSTR pToken;
-				if (dwElementType == OPC_BROWSE_HASCHILDREN)
-					pToken = BRANCHTOKENSTRING;
-				else
-					pToken = ITEMTOKENSTRING;
-
-				_OPC_CHECK_HRFUNC(wsTemp.SetString(pToken));
-				_OPC_CHECK_HRFUNC(wsTemp.AppendString(pElementIDs[i]))
-					ComFreeString(*pszContinuationPoint);
-				*pszContinuationPoint = wsTemp.CopyCOM();
-				_OPC_CHECK_PTR(*pszContinuationPoint);
+			else {
+				pEl->ItemProperties.dwNumProperties = 0;
+				pEl->ItemProperties.pItemProperties = ComAlloc<OPCITEMPROPERTY>(0);
+				_OPC_CHECK_PTR(pEl->ItemProperties.pItemProperties);
 			}
 
-			SysFreeString(pElementIDs[i]);
+			(*pdwElementCount)++;
 		}
 	}
 	catch (HRESULT hrEx) {
@@ -1152,12 +1163,7 @@ HRESULT DaBrowse::MoveElementIDsToBrowseElements(
 				ComFree(pEl->ItemProperties.pItemProperties);
 			}
 		}
-	}
-
-	// Release not yet releases Element IDs
-	while (i < dwNumOfElementIDs) {
-		SysFreeString(pElementIDs[i]);
-		i++;
+		return hr;
 	}
 	return hrReturn;
 }
@@ -1175,9 +1181,12 @@ DWORD DaBrowse::FilterElements(LPCWSTR     szElementNameFilter,
 	DWORD       dwNumOfElements,
 	BSTR     *  pElements)
 {
+	CompiledPattern filter;                    // Compiled once for all elements
+	filter.Compile(szElementNameFilter);
+
 	DWORD dwNumOfPassedElements = 0;
 	for (DWORD i = 0; i < dwNumOfElements; i++) {
-		if (::MatchPattern(pElements[i], szElementNameFilter)) {
+		if (filter.Match(pElements[i])) {
 			pElements[dwNumOfPassedElements] = pElements[i];
 			dwNumOfPassedElements++;
 		}
@@ -1190,34 +1199,6 @@ DWORD DaBrowse::FilterElements(LPCWSTR     szElementNameFilter,
 
 
 
-//=========================================================================
-// RemoveElementsInFrontOfContinuationPoint                        INTERNAL
-// ----------------------------------------
-//    Removes all Elements in front of the specified
-//    'Continuation Point' - Element.
-//    The Elements are shifted so there isn't any gap between the Elements.
-//    This method returns the number of remained Elements.
-//=========================================================================
-DWORD DaBrowse::RemoveElementsInFrontOfContinuationPoint(
-	LPCWSTR     szContinuationPoint,
-	DWORD       dwNumOfElements,
-	BSTR     *  pElements)
-{
-	DWORD i;
-	for (i = 0; i < dwNumOfElements; i++) {
-		if (wcscmp(pElements[i], szContinuationPoint) == 0) {
-			break;
-		}
-		SysFreeString(pElements[i]);
-	}
-
-	DWORD dwNumOfPassedElements = dwNumOfElements - i;
-	memcpy(pElements, &pElements[i], dwNumOfPassedElements * sizeof(BSTR*));
-	return dwNumOfPassedElements;
-}
-
-
-
 //=========================================================================
 // InitArrayOfOPCITEMPROPERTY                                      INTERNAL
 //=========================================================================
@@ -27,6 +27,8 @@
 #pragma once
 #endif // _MSC_VER >= 1000
 
+#include "DaBrowseSnapshot.h"
+
 
 /////////////////////////////////////////////////////////////////////////////
 // Forward declarations
@@ -82,6 +84,7 @@ public:
    {
       m_pBrowseData     = NULL;
       m_pServerHandler  = NULL;
+      InitializeCriticalSection( &m_csSnapshot );
    }
 
    HRESULT Create( PBROWSEDATA pBrowseData, DaBaseServer* pServerHandler )
@@ -94,6 +97,7 @@ public:
 // Destruction
    DaBrowse::~DaBrowse()
    {
+      DeleteCriticalSection( &m_csSnapshot );
    }
 
 // Operations
@@ -176,6 +180,11 @@ protected:
    PBROWSEDATA          m_pBrowseData;
    DaBaseServer* m_pServerHandler;
 
+      // Elements of the last IOPCBrowse::Browse() call which returned
+      // a Continuation Point.
+   DaBrowseSnapshot     m_Snapshot;
+   CRITICAL_SECTION     m_csSnapshot;           // Serializes IOPCBrowse::Browse()
+
    HRESULT GetRevisedPropertyIDs(
                   /* [in] */                    const LPWSTR         szItemID,
                   /* [in] */                    const DWORD          dwPropertyCount,
@@ -196,7 +205,6 @@ protected:
                   /* [in] */                    const DWORD          dwNumOfElements,
                   /* [in,out] */                DWORD             *  pdwElementCount,
                   /* [in(dwNumOfElements)] */   OPCBROWSEELEMENT  *  pElements,
-                  /* [in,out] */                LPWSTR            *  pszContinuationPoint,
                   // Property Related Parameters
                   /* [in] */                    const BOOL           bReturnAllProperties,
                   /* [in] */                    const BOOL           bReturnPropertyValues,
@@ -205,7 +213,6 @@ protected:
 
    // Small Utility Functions
    DWORD FilterElements( LPCWSTR szElementNameFilter, DWORD dwNumOfElements, BSTR* pElements );
-   DWORD RemoveElementsInFrontOfContinuationPoint( LPCWSTR szContinuationPoint, DWORD dwNumOfElements, BSTR* pElements );
    void  InitArrayOfOPCITEMPROPERTY( DWORD dwNumOfProp, OPCITEMPROPERTY* pProperties );
    void  ReleaseArrayOfOPCITEMPROPERTY( DWORD dwNumOfProp, OPCITEMPROPERTY* pProperties );
    void  ReleaseOPCITEMPROPERTY( OPCITEMPROPERTY* pProperty );
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include "UtilityDefs.h"
+#include "UtilityFuncs.h"
+#include "WideString.h"
+#include "DaBrowseSnapshot.h"
+
+// Source of the snapshot IDs
+static volatile LONG glSnapshotID = 0;
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaBrowseSnapshot::DaBrowseSnapshot()
+{
+	m_dwID = 0;
+	m_lVersion = 0;
+	m_dwBrowseFilter = OPC_BROWSE_FILTER_ALL;
+	m_bstrPosition = NULL;
+	m_bstrElementNameFilter = NULL;
+	m_bstrVendorFilter = NULL;
+	m_dwNumOfBranchIDs = 0;
+	m_pBranchIDs = NULL;
+	m_dwNumOfItemIDs = 0;
+	m_pItemIDs = NULL;
+}
+
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+DaBrowseSnapshot::~DaBrowseSnapshot()
+{
+	Release();
+}
+
+
+
+//=========================================================================
+// Find
+// ----
+//    Checks if the Continuation Point is a cursor in this snapshot and
+//    if the snapshot is still valid for the specified parameters.
+//=========================================================================
+BOOL DaBrowseSnapshot::Find(
+	LPCWSTR           szContinuationPoint,
+	LONG              lVersion,
+	OPCBROWSEFILTER   dwBrowseFilter,
+	LPCWSTR           szPosition,
+	LPCWSTR           szElementNameFilter,
+	LPCWSTR           szVendorFilter,
+	DWORD          *  pdwIndex,
+	LPCWSTR        *  pszElementCP)
+{
+	*pszElementCP = szContinuationPoint;
+
+	size_t nTokenLen = wcslen(CURSORTOKENSTRING);
+	if (wcsncmp(szContinuationPoint, CURSORTOKENSTRING, nTokenLen) != 0) {
+		return FALSE;                            // Not a cursor
+	}
+
+	// Snapshot ID, Address Space Version and Index
+	DWORD    adwFields[3];
+	LPCWSTR  pField = &szContinuationPoint[nTokenLen];
+	for (int i = 0; i < 3; i++) {
+		LPWSTR pEnd;
+		adwFields[i] = (DWORD)wcstoul(pField, &pEnd, 10);
+		if (pEnd == pField || *pEnd != ((i < 2) ? L'.' : L'#')) {
+			return FALSE;                        // Invalid CP syntax
+		}
+		pField = pEnd + 1;
+	}
+	*pszElementCP = pField;
+
+	if (m_dwID == 0 || m_dwID != adwFields[0]) {
+		return FALSE;                            // Snapshot released or replaced
+	}
+	if ((DWORD)m_lVersion != adwFields[1] || m_lVersion != lVersion) {
+		return FALSE;                            // Address space changed
+	}
+	if (m_dwBrowseFilter != dwBrowseFilter ||
+		wcscmp(m_bstrPosition, szPosition) != 0 ||
+		wcscmp(m_bstrElementNameFilter, szElementNameFilter) != 0 ||
+		wcscmp(m_bstrVendorFilter, szVendorFilter) != 0) {
+		return FALSE;                            // Other elements requested
+	}
+	if (adwFields[2] >= m_dwNumOfBranchIDs + m_dwNumOfItemIDs) {
+		return FALSE;
+	}
+
+	*pdwIndex = adwFields[2];
+	return TRUE;
+}
+
+
+
+//=========================================================================
+// Save
+// ----
+//    Replaces the snapshot with the specified elements.
+//=========================================================================
+HRESULT DaBrowseSnapshot::Save(
+	LONG              lVersion,
+	OPCBROWSEFILTER   dwBrowseFilter,
+	LPCWSTR           szPosition,
+	LPCWSTR           szElementNameFilter,
+	LPCWSTR           szVendorFilter,
+	DWORD             dwNumOfBranchIDs,
+	BSTR           *  pBranchIDs,
+	DWORD             dwNumOfItemIDs,
+	BSTR           *  pItemIDs)
+{
+	Release();
+
+	m_bstrPosition = SysAllocString(szPosition);
+	m_bstrElementNameFilter = SysAllocString(szElementNameFilter);
+	m_bstrVendorFilter = SysAllocString(szVendorFilter);
+	if (!m_bstrPosition || !m_bstrElementNameFilter || !m_bstrVendorFilter) {
+		Release();
+		return E_OUTOFMEMORY;
+	}
+
+	do {                                         // 0 is used for 'no snapshot'
+		m_dwID = (DWORD)InterlockedIncrement(&glSnapshotID);
+	} while (m_dwID == 0);
+
+	m_lVersion = lVersion;
+	m_dwBrowseFilter = dwBrowseFilter;
+	m_dwNumOfBranchIDs = dwNumOfBranchIDs;
+	m_pBranchIDs = pBranchIDs;
+	m_dwNumOfItemIDs = dwNumOfItemIDs;
+	m_pItemIDs = pItemIDs;
+	return S_OK;
+}
+
+
+
+//=========================================================================
+// Release
+//=========================================================================
+void DaBrowseSnapshot::Release()
+{
+	SysFreeString(m_bstrPosition);
+	SysFreeString(m_bstrElementNameFilter);
+	SysFreeString(m_bstrVendorFilter);
+	ReleaseElementIDs(m_dwNumOfBranchIDs, m_pBranchIDs);
+	ReleaseElementIDs(m_dwNumOfItemIDs, m_pItemIDs);
+
+	m_dwID = 0;
+	m_bstrPosition = NULL;
+	m_bstrElementNameFilter = NULL;
+	m_bstrVendorFilter = NULL;
+	m_dwNumOfBranchIDs = 0;
+	m_pBranchIDs = NULL;
+	m_dwNumOfItemIDs = 0;
+	m_pItemIDs = NULL;
+}
+
+
+
+//=========================================================================
+// SetContinuationPoint
+// --------------------
+//    Returns the Continuation Point of the element with the specified
+//    index, as cursor in this snapshot or as name of the element.
+//=========================================================================
+HRESULT DaBrowseSnapshot::SetContinuationPoint(
+	BOOL              fCursor,
+	DWORD             dwIndex,
+	DWORD             dwNumOfBranchIDs,
+	BSTR           *  pBranchIDs,
+	BSTR           *  pItemIDs,
+	LPWSTR         *  pszContinuationPoint)
+{
+	try {
+		WideString  wsTemp;
+		LPCWSTR     pToken;
+		LPCWSTR     pName;
+
+		if (dwIndex < dwNumOfBranchIDs) {
+			pToken = BRANCHTOKENSTRING;
+			pName = pBranchIDs[dwIndex];
+		}
+		else {
+			pToken = ITEMTOKENSTRING;
+			pName = pItemIDs[dwIndex - dwNumOfBranchIDs];
+		}
+
+		if (fCursor) {
+			WCHAR szCursor[40];
+			swprintf_s(szCursor, L"%lu.%lu.%lu#", (unsigned long)m_dwID, (unsigned long)(DWORD)m_lVersion,
+				(unsigned long)dwIndex);
+			_OPC_CHECK_HRFUNC(wsTemp.SetString(CURSORTOKENSTRING));
+			_OPC_CHECK_HRFUNC(wsTemp.AppendString(szCursor));
+			_OPC_CHECK_HRFUNC(wsTemp.AppendString(pToken));
+		}
+		else {
+			_OPC_CHECK_HRFUNC(wsTemp.SetString(pToken));
+		}
+		_OPC_CHECK_HRFUNC(wsTemp.AppendString(pName));
+
+		ComFreeString(*pszContinuationPoint);
+		*pszContinuationPoint = wsTemp.CopyCOM();
+		_OPC_CHECK_PTR(*pszContinuationPoint);
+	}
+	catch (HRESULT hrEx) {
+		return hrEx;
+	}
+	return S_OK;
+}
+
+
+
+//=========================================================================
+// ResumeAtElement
+// ---------------
+//    Discards all Elements in front of the specified Continuation Point.
+//    The branches are in front of the items, so all branches are
+//    discarded if the Continuation Point is an item.
+//=========================================================================
+HRESULT DaBrowseSnapshot::ResumeAtElement(
+	LPCWSTR           szElementCP,
+	DWORD          *  pdwNumOfBranchIDs,
+	BSTR           *  pBranchIDs,
+	DWORD          *  pdwNumOfItemIDs,
+	BSTR           *  pItemIDs)
+{
+	size_t nBranchTokenLen = wcslen(BRANCHTOKENSTRING);
+	size_t nItemTokenLen = wcslen(ITEMTOKENSTRING);
+
+	// Check if the CP is a Branch-Element
+	if (wcsncmp(szElementCP, BRANCHTOKENSTRING, nBranchTokenLen) == 0) {
+		*pdwNumOfBranchIDs = RemoveElementsInFrontOf(&szElementCP[nBranchTokenLen], *pdwNumOfBranchIDs, pBranchIDs);
+		if (*pdwNumOfBranchIDs == 0) {           // At least the CP should exist as Element if valid
+			return OPC_E_INVALIDCONTINUATIONPOINT;
+		}
+	}
+	// Check if the CP is a Leaf-Element
+	else if (wcsncmp(szElementCP, ITEMTOKENSTRING, nItemTokenLen) == 0) {
+		for (DWORD i = 0; i < *pdwNumOfBranchIDs; i++) {
+			SysFreeString(pBranchIDs[i]);        // All branches are already returned
+		}
+		*pdwNumOfBranchIDs = 0;
+		*pdwNumOfItemIDs = RemoveElementsInFrontOf(&szElementCP[nItemTokenLen], *pdwNumOfItemIDs, pItemIDs);
+		if (*pdwNumOfItemIDs == 0) {             // At least the CP should exist as Element if valid
+			return OPC_E_INVALIDCONTINUATIONPOINT;
+		}
+	}
+	else {                                       // Invalid CP syntax
+		return OPC_E_INVALIDCONTINUATIONPOINT;
+	}
+	return S_OK;
+}
+
+
+
+//=========================================================================
+// ReleaseElementIDs
+//=========================================================================
+void DaBrowseSnapshot::ReleaseElementIDs(DWORD dwNumOfElements, BSTR* pElements)
+{
+	if (pElements != NULL) {
+		for (DWORD i = 0; i < dwNumOfElements; i++) {
+			SysFreeString(pElements[i]);
+		}
+		delete[] pElements;
+	}
+}
+
+
+
+//=========================================================================
+// RemoveElementsInFrontOf
+// -----------------------
+//    Removes all Elements in front of the Element with the specified
+//    name, all Elements if the name is not found. The Elements are
+//    shifted so there isn't any gap between the Elements.
+//    This method returns the number of remained Elements.
+//=========================================================================
+DWORD DaBrowseSnapshot::RemoveElementsInFrontOf(
+	LPCWSTR     szName,
+	DWORD       dwNumOfElements,
+	BSTR     *  pElements)
+{
+	DWORD i;
+	for (i = 0; i < dwNumOfElements; i++) {
+		if (wcscmp(pElements[i], szName) == 0) {
+			break;
+		}
+		SysFreeString(pElements[i]);
+	}
+
+	DWORD dwNumOfPassedElements = dwNumOfElements - i;
+	memmove(pElements, &pElements[i], dwNumOfPassedElements * sizeof(BSTR));
+	return dwNumOfPassedElements;
+}
+//DOM-IGNORE-END
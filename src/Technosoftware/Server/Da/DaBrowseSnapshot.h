@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __BROWSESNAPSHOT_H_
+#define __BROWSESNAPSHOT_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+               // Tokens to generate unique Continuation Points. The
+               // token is followed by the name of the element.
+#define  BRANCHTOKENSTRING    L"BRANCH#{81aac52d-b4bb-42d1-94e4-3eca1fd3c45b}#"
+#define  ITEMTOKENSTRING      L"ITEM#{2f6b782d-50a8-434c-95bf-5d5854a00259}#"
+               // A cursor in the snapshot has the format
+               //    CURSORTOKENSTRING <Snapshot ID>.<Address Space Version>.<Index>#
+               // followed by the Continuation Point of the element at the index.
+#define  CURSORTOKENSTRING    L"CURSOR#{49cf52b0-30b5-4aba-bc6a-caba1500a849}#"
+
+
+/////////////////////////////////////////////////////////////////
+// Browse Snapshot
+// ---------------
+// Elements of the last IOPCBrowse::Browse() call of a client
+// which returned a Continuation Point. The Continuation Point is
+// then a cursor in the snapshot and the following calls with the
+// cursor resume without browsing the address space again.
+//
+// A cursor is only valid for the snapshot which returned it, with
+// the same Browse() parameters and the same address space
+// version. Otherwise the caller browses the elements again and
+// resumes at the name of the element stored in the cursor.
+//
+// The snapshot is not thread safe, DaBrowse serializes the calls.
+/////////////////////////////////////////////////////////////////
+class DaBrowseSnapshot {
+
+   public:
+      DaBrowseSnapshot();
+      ~DaBrowseSnapshot();
+
+         ///////////////////////////////////////////////////////////////
+         //  Checks if the Continuation Point is a cursor in this
+         //  snapshot and if the snapshot is valid for the specified
+         //  address space version, browse position and parameters.
+         //
+         //  Returns TRUE and the index of the cursor in pdwIndex if
+         //  the call can resume with the snapshot.
+         //
+         //  pszElementCP returns the Continuation Point of the element
+         //  at the cursor, which is used if the snapshot is not valid.
+         //  This is szContinuationPoint if it is not a cursor.
+         ///////////////////////////////////////////////////////////////
+      BOOL Find( LPCWSTR szContinuationPoint, LONG lVersion, OPCBROWSEFILTER dwBrowseFilter,
+                 LPCWSTR szPosition, LPCWSTR szElementNameFilter, LPCWSTR szVendorFilter,
+                 DWORD* pdwIndex, LPCWSTR* pszElementCP );
+
+         ///////////////////////////////////////////////////////////////
+         //  Replaces the snapshot with the specified elements browsed
+         //  at the address space version lVersion. If the function
+         //  succeeds then the snapshot owns the Element IDs and the
+         //  arrays, which are released with ReleaseElementIDs().
+         ///////////////////////////////////////////////////////////////
+      HRESULT Save( LONG lVersion, OPCBROWSEFILTER dwBrowseFilter,
+                    LPCWSTR szPosition, LPCWSTR szElementNameFilter, LPCWSTR szVendorFilter,
+                    DWORD dwNumOfBranchIDs, BSTR* pBranchIDs,
+                    DWORD dwNumOfItemIDs, BSTR* pItemIDs );
+
+         ///////////////////////////////////////////////////////////////
+         //  Releases the elements; following cursors are not found.
+         ///////////////////////////////////////////////////////////////
+      void Release();
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the Continuation Point of the element with the
+         //  specified index, the branches are in front of the items.
+         //  If fCursor is TRUE then the Continuation Point is a cursor
+         //  in this snapshot and the elements must be those of the
+         //  snapshot. *pszContinuationPoint is released with
+         //  ComFreeString() and replaced.
+         ///////////////////////////////////////////////////////////////
+      HRESULT SetContinuationPoint( BOOL fCursor, DWORD dwIndex,
+                                    DWORD dwNumOfBranchIDs, BSTR* pBranchIDs, BSTR* pItemIDs,
+                                    LPWSTR* pszContinuationPoint );
+
+         ///////////////////////////////////////////////////////////////
+         //  Removes all elements in front of the element with the
+         //  name-based Continuation Point szElementCP, e.g. returned
+         //  by Find(). Returns OPC_E_INVALIDCONTINUATIONPOINT if the
+         //  syntax is invalid or the element no longer exists.
+         ///////////////////////////////////////////////////////////////
+      static HRESULT ResumeAtElement( LPCWSTR szElementCP,
+                                      DWORD* pdwNumOfBranchIDs, BSTR* pBranchIDs,
+                                      DWORD* pdwNumOfItemIDs, BSTR* pItemIDs );
+
+         ///////////////////////////////////////////////////////////////
+         //  Releases the Element IDs and the array returned by
+         //  DaBaseServer::OnBrowseItemIdentifiers().
+         ///////////////////////////////////////////////////////////////
+      static void ReleaseElementIDs( DWORD dwNumOfElements, BSTR* pElements );
+
+      DWORD GetNumOfBranchIDs() const  { return m_dwNumOfBranchIDs; }
+      BSTR* GetBranchIDs() const       { return m_pBranchIDs; }
+      DWORD GetNumOfItemIDs() const    { return m_dwNumOfItemIDs; }
+      BSTR* GetItemIDs() const         { return m_pItemIDs; }
+
+   private:
+      DWORD             m_dwID;                 // identifies the snapshot in the cursor; 0 if none
+      LONG              m_lVersion;             // address space version of the elements
+      OPCBROWSEFILTER   m_dwBrowseFilter;       // Browse() parameters of the elements
+      BSTR              m_bstrPosition;
+      BSTR              m_bstrElementNameFilter;
+      BSTR              m_bstrVendorFilter;
+      DWORD             m_dwNumOfBranchIDs;     // the filtered elements
+      BSTR           *  m_pBranchIDs;
+      DWORD             m_dwNumOfItemIDs;
+      BSTR           *  m_pItemIDs;
+
+      static DWORD RemoveElementsInFrontOf( LPCWSTR szName, DWORD dwNumOfElements, BSTR* pElements );
+};
+//DOM-IGNORE-END
+
+
+#endif // __BROWSESNAPSHOT_H_
@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+ //DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include "DaCallbackQueue.h"
+#include "openarray.h"
+#include "DaGenericServer.h"
+#include "DaGenericItem.h"
+#include "DaComServer.h"
+#include "OpcClock.h"
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaCallbackQueue::DaCallbackQueue()
+{
+    m_ppGroups = nullptr;
+    m_lGroupsAlloc = 0;
+    m_hFirst = 0;
+    m_hLast = 0;
+
+    memset(&m_Delivery, 0, sizeof(m_Delivery));
+    m_lDelivering = FALSE;
+
+    m_dwQueuedItems = 0;
+    m_dwMaxItems = DA_CALLBACKQUEUE_DEFAULT_LIMIT;
+    m_ullDelivered = 0;
+    m_ullConflated = 0;
+    m_ullDropped = 0;
+
+    InitializeCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+DaCallbackQueue::~DaCallbackQueue()
+{
+    for (long h = 0; h < m_lGroupsAlloc; h++) {
+        if (m_ppGroups[h]) {
+            FreeGroup(m_ppGroups[h]);
+            delete m_ppGroups[h];
+        }
+    }
+    if (m_ppGroups) {
+        delete[] m_ppGroups;
+    }
+    FreeGroup(&m_Delivery);
+    DeleteCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// SetLimit
+//=========================================================================
+void DaCallbackQueue::SetLimit(DWORD dwMaxItems)
+{
+    EnterCriticalSection(&m_CritSec);
+    m_dwMaxItems = dwMaxItems;
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=================================================================================
+// Queue the changed Values of a Group
+// -----------------------------------
+// A value of an item which is already queued replaces the queued value.
+// Values of other items are appended or dropped if the queue is full.
+//=================================================================================
+DWORD DaCallbackQueue::Enqueue(long hServerGroup, DWORD dwCount, DaGenericItem** ppGItems,
+                               OPCITEMSTATE* pItemStates, HRESULT* pErrors)
+{
+    QUEUEDGROUP*    pGroup;
+    OPCHANDLE       hItem;
+    DWORD           i, dwDropped = 0;
+    long            lPos;
+
+    EnterCriticalSection(&m_CritSec);
+
+    pGroup = GetGroup(hServerGroup);
+    if (pGroup == nullptr || FAILED(ReserveValues(pGroup, dwCount))) {
+        for (i = 0; i < dwCount; i++) {         // out of memory, drop all values
+            pErrors[i] = E_OUTOFMEMORY;
+        }
+        m_ullDropped += dwCount;
+        LeaveCriticalSection(&m_CritSec);
+        return dwCount;
+    }
+
+    for (i = 0; i < dwCount; i++) {
+        hItem = ppGItems[i]->get_ServerHandle();
+
+        lPos = (DaHandleIndex(hItem) < (long)pGroup->dwPosAlloc) ? pGroup->plPos[DaHandleIndex(hItem)] : -1;
+        if (lPos >= 0) {
+            // the item is already queued, replace the older value.
+            // The queued value may belong to a removed item whose
+            // slot has been reused.
+            pGroup->phServer[lPos] = hItem;
+            VariantClear(&pGroup->pItemStates[lPos].vDataValue);
+            pGroup->pItemStates[lPos] = pItemStates[i];
+            pGroup->pErrors[lPos] = pErrors[i];
+            VariantInit(&pItemStates[i].vDataValue);
+            m_ullConflated++;
+            continue;
+        }
+
+        if (m_dwQueuedItems >= m_dwMaxItems || FAILED(ReservePos(pGroup, hItem))) {
+            pErrors[i] = E_OUTOFMEMORY;         // queue is full
+            dwDropped++;
+            continue;
+        }
+
+        lPos = pGroup->dwCount++;
+        pGroup->phServer[lPos] = hItem;
+        pGroup->pItemStates[lPos] = pItemStates[i];
+        pGroup->pErrors[lPos] = pErrors[i];
+        pGroup->plPos[DaHandleIndex(hItem)] = lPos;
+        VariantInit(&pItemStates[i].vDataValue);
+        m_dwQueuedItems++;
+    }
+
+    if (pGroup->dwCount) {
+        Append(hServerGroup, pGroup);
+    }
+    m_ullDropped += dwDropped;
+
+    LeaveCriticalSection(&m_CritSec);
+    return dwDropped;
+}
+
+
+//=================================================================================
+// Queue a Keep-Alive Callback of a Group
+// --------------------------------------
+//=================================================================================
+void DaCallbackQueue::EnqueueKeepAlive(long hServerGroup)
+{
+    EnterCriticalSection(&m_CritSec);
+
+    QUEUEDGROUP* pGroup = GetGroup(hServerGroup);
+    if (pGroup) {
+        pGroup->fKeepAlive = TRUE;
+        Append(hServerGroup, pGroup);
+    }
+
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=================================================================================
+// Discard the queued Callbacks of a removed Group
+// -----------------------------------------------
+// Called before the server group handle is reused.
+//=================================================================================
+void DaCallbackQueue::RemoveGroup(long hServerGroup)
+{
+    QUEUEDGROUP* pGroup = nullptr;
+
+    EnterCriticalSection(&m_CritSec);
+
+    long lIndex = DaHandleIndex(hServerGroup);
+    if (hServerGroup > 0 && lIndex < m_lGroupsAlloc && m_ppGroups[lIndex]) {
+        pGroup = m_ppGroups[lIndex];
+        m_ppGroups[lIndex] = nullptr;
+
+        if (pGroup->fQueued) {                  // unlink from the list of queued groups
+            long hPrev = 0;
+            long h = m_hFirst;
+            while (h != hServerGroup) {
+                hPrev = h;
+                h = m_ppGroups[DaHandleIndex(h)]->hNext;
+            }
+            if (hPrev) {
+                m_ppGroups[DaHandleIndex(hPrev)]->hNext = pGroup->hNext;
+            }
+            else {
+                m_hFirst = pGroup->hNext;
+            }
+            if (m_hLast == hServerGroup) {
+                m_hLast = hPrev;
+            }
+        }
+        m_dwQueuedItems -= pGroup->dwCount;
+    }
+
+    LeaveCriticalSection(&m_CritSec);
+
+    if (pGroup) {                               // release the values outside of the lock
+        FreeGroup(pGroup);
+        delete pGroup;
+    }
+}
+
+
+//=================================================================================
+// Deliver the queued Callbacks
+// ----------------------------
+// Submits the dispatcher of this queue to the delivery pool. The server
+// remains attached until the dispatcher has emptied the queue.
+//=================================================================================
+void DaCallbackQueue::Deliver(DaGenericServer* pServer)
+{
+    EnterCriticalSection(&m_CritSec);
+    BOOL fEmpty = (m_hFirst == 0);
+    LeaveCriticalSection(&m_CritSec);
+    if (fEmpty) {
+        return;                                 // nothing queued by the caller
+    }
+
+    if (InterlockedCompareExchange(&m_lDelivering, TRUE, FALSE) != FALSE) {
+        return;                                 // the dispatcher is scheduled or running
+    }
+
+    pServer->Attach();
+    if (FAILED(pServer->m_pServerHandler->SubmitDelivery(DispatchTask, pServer))) {
+        DispatchTask(pServer);                  // the delivery pool is not running
+    }
+}
+
+
+//=================================================================================
+// Dispatcher Task
+// ---------------
+// Executed by a thread of the delivery pool.
+//=================================================================================
+unsigned __stdcall DaCallbackQueue::DispatchTask(void* pContext)
+{
+    DaGenericServer* pServer = static_cast<DaGenericServer*>(pContext);
+
+    pServer->m_CallbackQueue.Dispatch(pServer);
+    pServer->Detach();
+    return 0;
+}
+
+
+//=================================================================================
+// Dispatch the queued Callbacks
+// -----------------------------
+// Delivers the queued callbacks until the queue is empty. The COM group is
+// looked up within m_CritSec so a group which is removed meanwhile is never
+// confused with a new group with the same handle; the callback itself is
+// invoked without any lock.
+//=================================================================================
+void DaCallbackQueue::Dispatch(DaGenericServer* pServer)
+{
+    long                    hServerGroup;
+    BOOL                    fTaken, fDelivered;
+    CComObject<DaGroup>*    pCOMGroup;
+
+    _ASSERTE(m_lDelivering == TRUE);
+
+    for (;;) {
+        pCOMGroup = nullptr;
+
+        EnterCriticalSection(&m_CritSec);
+        fTaken = TakeNext(&hServerGroup);
+        if (fTaken) {
+            pServer->CriticalSectionCOMGroupList.BeginReading();
+            if (SUCCEEDED(pServer->m_COMGroupList.GetElem(hServerGroup, &pCOMGroup)) && pCOMGroup) {
+                pCOMGroup->AddRef();
+            }
+            else {
+                pCOMGroup = nullptr;
+            }
+            pServer->CriticalSectionCOMGroupList.EndReading();
+        }
+        else {
+            // the queue is empty; cleared within the lock so that a thread
+            // which queues a callback afterwards becomes the next dispatcher
+            InterlockedExchange(&m_lDelivering, FALSE);
+        }
+        LeaveCriticalSection(&m_CritSec);
+
+        if (!fTaken) {
+            break;
+        }
+
+        if (pCOMGroup) {
+            fDelivered = FALSE;
+            if (m_Delivery.dwCount) {
+                if (SUCCEEDED(pCOMGroup->FireOnDataChange(m_Delivery.dwCount, m_Delivery.pItemStates, m_Delivery.pErrors))) {
+                    OpcClockCoarse(&pServer->m_LastUpdateTime);
+                    fDelivered = TRUE;
+                }
+            }
+            else if (m_Delivery.fKeepAlive && *pCOMGroup->m_vec.begin()) {
+                HRESULT hrErr = S_OK;             // Enabled Callback exist
+                fDelivered = SUCCEEDED(pCOMGroup->FireOnDataChange(0, nullptr, &hrErr));
+            }
+            pCOMGroup->Release();
+
+            if (fDelivered) {
+                EnterCriticalSection(&m_CritSec);
+                m_ullDelivered++;
+                LeaveCriticalSection(&m_CritSec);
+            }
+        }
+        ClearValues(&m_Delivery);
+    }
+}
+
+
+//=========================================================================
+// GetStatistics
+//=========================================================================
+void DaCallbackQueue::GetStatistics(DACALLBACKQUEUESTATS* pStats)
+{
+    EnterCriticalSection(&m_CritSec);
+    pStats->dwQueuedItems = m_dwQueuedItems;
+    pStats->dwMaxItems = m_dwMaxItems;
+    pStats->ullDelivered = m_ullDelivered;
+    pStats->ullConflated = m_ullConflated;
+    pStats->ullDropped = m_ullDropped;
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=================================================================================
+// Get the queue entry of a Group
+// ------------------------------
+// Creates the entry if required. Must be called within m_CritSec.
+//=================================================================================
+DaCallbackQueue::QUEUEDGROUP* DaCallbackQueue::GetGroup(long hServerGroup)
+{
+    _ASSERTE(hServerGroup > 0);
+
+    long lIndex = DaHandleIndex(hServerGroup);
+    if (lIndex >= m_lGroupsAlloc) {
+        long lNewAlloc = m_lGroupsAlloc ? m_lGroupsAlloc : 16;
+        while (lIndex >= lNewAlloc) {
+            lNewAlloc *= 2;
+        }
+        QUEUEDGROUP** ppNew = new QUEUEDGROUP*[lNewAlloc];
+        if (ppNew == nullptr) {
+            return nullptr;
+        }
+        memset(ppNew, 0, lNewAlloc * sizeof(QUEUEDGROUP*));
+        if (m_ppGroups) {
+            memcpy(ppNew, m_ppGroups, m_lGroupsAlloc * sizeof(QUEUEDGROUP*));
+            delete[] m_ppGroups;
+        }
+        m_ppGroups = ppNew;
+        m_lGroupsAlloc = lNewAlloc;
+    }
+
+    if (m_ppGroups[lIndex] == nullptr) {
+        QUEUEDGROUP* pGroup = new QUEUEDGROUP;
+        if (pGroup == nullptr) {
+            return nullptr;
+        }
+        memset(pGroup, 0, sizeof(QUEUEDGROUP));
+        m_ppGroups[lIndex] = pGroup;
+    }
+    return m_ppGroups[lIndex];
+}
+
+
+//=================================================================================
+// Ensure that dwCount more values can be stored
+// ---------------------------------------------
+//=================================================================================
+HRESULT DaCallbackQueue::ReserveValues(QUEUEDGROUP* pGroup, DWORD dwCount)
+{
+    DWORD dwNeeded = pGroup->dwCount + dwCount;
+    if (dwNeeded <= pGroup->dwAlloc) {
+        return S_OK;
+    }
+
+    DWORD dwNewAlloc = pGroup->dwAlloc ? pGroup->dwAlloc : 16;
+    while (dwNewAlloc < dwNeeded) {
+        dwNewAlloc *= 2;
+    }
+
+    OPCHANDLE*      phServer = new OPCHANDLE[dwNewAlloc];
+    OPCITEMSTATE*   pItemStates = new OPCITEMSTATE[dwNewAlloc];
+    HRESULT*        pErrors = new HRESULT[dwNewAlloc];
+    if (phServer == nullptr || pItemStates == nullptr || pErrors == nullptr) {
+        delete[] phServer;
+        delete[] pItemStates;
+        delete[] pErrors;
+        return E_OUTOFMEMORY;
+    }
+    if (pGroup->dwCount) {                      // the values are moved bitwise
+        memcpy(phServer, pGroup->phServer, pGroup->dwCount * sizeof(OPCHANDLE));
+        memcpy(pItemStates, pGroup->pItemStates, pGroup->dwCount * sizeof(OPCITEMSTATE));
+        memcpy(pErrors, pGroup->pErrors, pGroup->dwCount * sizeof(HRESULT));
+    }
+    delete[] pGroup->phServer;
+    delete[] pGroup->pItemStates;
+    delete[] pGroup->pErrors;
+
+    pGroup->phServer = phServer;
+    pGroup->pItemStates = pItemStates;
+    pGroup->pErrors = pErrors;
+    pGroup->dwAlloc = dwNewAlloc;
+    return S_OK;
+}
+
+
+//=================================================================================
+// Ensure that the position of an item handle can be stored
+// --------------------------------------------------------
+//=================================================================================
+HRESULT DaCallbackQueue::ReservePos(QUEUEDGROUP* pGroup, OPCHANDLE hItem)
+{
+    DWORD dwIndex = DaHandleIndex(hItem);
+    if (dwIndex < pGroup->dwPosAlloc) {
+        return S_OK;
+    }
+
+    DWORD dwNewAlloc = pGroup->dwPosAlloc ? pGroup->dwPosAlloc : 16;
+    while (dwIndex >= dwNewAlloc) {
+        dwNewAlloc *= 2;
+    }
+    long* plPos = new long[dwNewAlloc];
+    if (plPos == nullptr) {
+        return E_OUTOFMEMORY;
+    }
+    memset(plPos, 0xFF, dwNewAlloc * sizeof(long));   // all -1
+    if (pGroup->plPos) {
+        memcpy(plPos, pGroup->plPos, pGroup->dwPosAlloc * sizeof(long));
+        delete[] pGroup->plPos;
+    }
+    pGroup->plPos = plPos;
+    pGroup->dwPosAlloc = dwNewAlloc;
+    return S_OK;
+}
+
+
+//=================================================================================
+// Append a Group to the list of queued Groups
+// -------------------------------------------
+// Must be called within m_CritSec.
+//=================================================================================
+void DaCallbackQueue::Append(long hServerGroup, QUEUEDGROUP* pGroup)
+{
+    if (pGroup->fQueued) {
+        return;
+    }
+    pGroup->fQueued = TRUE;
+    pGroup->hNext = 0;
+    if (m_hLast) {
+        m_ppGroups[DaHandleIndex(m_hLast)]->hNext = hServerGroup;
+    }
+    else {
+        m_hFirst = hServerGroup;
+    }
+    m_hLast = hServerGroup;
+}
+
+
+//=================================================================================
+// Take the next queued Group
+// --------------------------
+// Moves the queued callback of the first group to m_Delivery. The arrays
+// are swapped, so the allocated memory of both is reused.
+// Must be called within m_CritSec by the dispatcher.
+//=================================================================================
+BOOL DaCallbackQueue::TakeNext(long* phServerGroup)
+{
+    if (m_hFirst == 0) {
+        return FALSE;
+    }
+
+    long            hServerGroup = m_hFirst;
+    QUEUEDGROUP*    pGroup = m_ppGroups[DaHandleIndex(hServerGroup)];
+    DWORD           i;
+
+    m_hFirst = pGroup->hNext;
+    if (m_hFirst == 0) {
+        m_hLast = 0;
+    }
+    pGroup->fQueued = FALSE;
+    pGroup->hNext = 0;
+
+    for (i = 0; i < pGroup->dwCount; i++) {
+        pGroup->plPos[DaHandleIndex(pGroup->phServer[i])] = -1;
+    }
+    m_dwQueuedItems -= pGroup->dwCount;
+
+    _ASSERTE(m_Delivery.dwCount == 0);
+
+    QUEUEDGROUP Tmp = m_Delivery;
+    m_Delivery.dwCount = pGroup->dwCount;
+    m_Delivery.dwAlloc = pGroup->dwAlloc;
+    m_Delivery.phServer = pGroup->phServer;
+    m_Delivery.pItemStates = pGroup->pItemStates;
+    m_Delivery.pErrors = pGroup->pErrors;
+    m_Delivery.fKeepAlive = pGroup->fKeepAlive;
+
+    pGroup->dwCount = 0;
+    pGroup->dwAlloc = Tmp.dwAlloc;
+    pGroup->phServer = Tmp.phServer;
+    pGroup->pItemStates = Tmp.pItemStates;
+    pGroup->pErrors = Tmp.pErrors;
+    pGroup->fKeepAlive = FALSE;
+
+    *phServerGroup = hServerGroup;
+    return TRUE;
+}
+
+
+//=================================================================================
+// Release the queued Values
+// -------------------------
+//=================================================================================
+void DaCallbackQueue::ClearValues(QUEUEDGROUP* pGroup)
+{
+    for (DWORD i = 0; i < pGroup->dwCount; i++) {
+        VariantClear(&pGroup->pItemStates[i].vDataValue);
+    }
+    pGroup->dwCount = 0;
+    pGroup->fKeepAlive = FALSE;
+}
+
+
+//=================================================================================
+// Release the Values and Arrays of a queue entry
+// ----------------------------------------------
+//=================================================================================
+void DaCallbackQueue::FreeGroup(QUEUEDGROUP* pGroup)
+{
+    ClearValues(pGroup);
+    delete[] pGroup->phServer;
+    delete[] pGroup->pItemStates;
+    delete[] pGroup->pErrors;
+    delete[] pGroup->plPos;
+    pGroup->phServer = nullptr;
+    pGroup->pItemStates = nullptr;
+    pGroup->pErrors = nullptr;
+    pGroup->plPos = nullptr;
+    pGroup->dwAlloc = 0;
+    pGroup->dwPosAlloc = 0;
+}
+//DOM-IGNORE-END
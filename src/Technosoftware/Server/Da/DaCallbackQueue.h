@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __CALLBACKQUEUE_H_
+#define __CALLBACKQUEUE_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+               // Default maximum number of item values queued for a client
+#define  DA_CALLBACKQUEUE_DEFAULT_LIMIT   100000
+
+class DaGenericServer;
+class DaGenericItem;
+
+
+               // Counters of the callback queue of a client
+typedef struct tagDACALLBACKQUEUESTATS {
+   DWORD       dwQueuedItems;          // item values waiting for delivery
+   DWORD       dwMaxItems;             // maximum number of queued item values
+   ULONGLONG   ullDelivered;           // OnDataChange callbacks delivered
+   ULONGLONG   ullConflated;           // queued values replaced by a newer value of the same item
+   ULONGLONG   ullDropped;             // values not queued because the queue was full
+} DACALLBACKQUEUESTATS;
+
+
+/////////////////////////////////////////////////////////////////
+// Callback Queue
+// --------------
+// Bounded queue of the IOPCDataCallback::OnDataChange callbacks
+// of a client (server instance).
+//
+// The update workers queue the changed values of a group and
+// return; the values are delivered by a dispatcher without owning
+// CriticalSectionCOMGroupList. There is at most one dispatcher per
+// client. Deliver() submits the dispatcher to the delivery pool of
+// the server class handler if no dispatcher is scheduled, so the
+// update workers never invoke a callback. A slow or hung client
+// stalls at most one thread of the delivery pool; the other
+// delivery threads take the dispatchers of the other clients.
+//
+// While a callback is in flight, newer values of an item which is
+// still queued replace the older value (conflation). If the queue
+// is full the values of items which are not queued yet are dropped;
+// the caller must force these items to be sent with a later update.
+/////////////////////////////////////////////////////////////////
+class DaCallbackQueue {
+
+   public:
+      DaCallbackQueue();
+      ~DaCallbackQueue();
+
+         ///////////////////////////////////////////////////////////////
+         //  Sets the maximum number of queued item values.
+         ///////////////////////////////////////////////////////////////
+      void SetLimit( DWORD dwMaxItems );
+
+         ///////////////////////////////////////////////////////////////
+         //  Queues the changed values of a group. The values are moved
+         //  from pItemStates[].vDataValue (the source is left empty).
+         //  Returns the number of dropped values; pErrors[] of these
+         //  items is set to E_OUTOFMEMORY and their value is not moved.
+         ///////////////////////////////////////////////////////////////
+      DWORD Enqueue( long hServerGroup, DWORD dwCount, DaGenericItem** ppGItems,
+                     OPCITEMSTATE* pItemStates, HRESULT* pErrors );
+
+         ///////////////////////////////////////////////////////////////
+         //  Queues a keep-alive callback of a group. Not required if
+         //  values of the group are queued.
+         ///////////////////////////////////////////////////////////////
+      void EnqueueKeepAlive( long hServerGroup );
+
+         ///////////////////////////////////////////////////////////////
+         //  Discards the queued callbacks of a removed group.
+         ///////////////////////////////////////////////////////////////
+      void RemoveGroup( long hServerGroup );
+
+         ///////////////////////////////////////////////////////////////
+         //  Schedules the delivery of the queued callbacks by a thread
+         //  of the delivery pool and returns. Does nothing if the
+         //  delivery is already scheduled. The callbacks are delivered
+         //  by the calling thread only if the pool is not running.
+         //  The server must be attached by the caller.
+         ///////////////////////////////////////////////////////////////
+      void Deliver( DaGenericServer* pServer );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the counters of the queue.
+         ///////////////////////////////////////////////////////////////
+      void GetStatistics( DACALLBACKQUEUESTATS* pStats );
+
+   private:
+               // Queued callback of a group. The item values are stored
+               // in the order they were queued.
+      typedef struct tagQUEUEDGROUP {
+         DWORD          dwCount;          // number of queued values
+         DWORD          dwAlloc;          // allocated entries of the arrays below
+         OPCHANDLE      *phServer;        // server item handles
+         OPCITEMSTATE   *pItemStates;
+         HRESULT        *pErrors;
+         long           *plPos;           // position by DaHandleIndex() of the item handle, -1 if not queued
+         DWORD          dwPosAlloc;       // allocated entries of plPos
+         BOOL           fKeepAlive;       // keep-alive callback is due
+         BOOL           fQueued;          // the group is in the list of queued groups
+         long           hNext;            // next queued group, 0 if last
+      } QUEUEDGROUP;
+
+      QUEUEDGROUP    **m_ppGroups;        // indexed by DaHandleIndex() of the server group handle
+      long           m_lGroupsAlloc;      // allocated entries of m_ppGroups
+      long           m_hFirst;            // first queued group, 0 if none
+      long           m_hLast;             // last queued group, 0 if none
+
+      QUEUEDGROUP    m_Delivery;          // callback in flight, only used by the dispatcher
+      volatile LONG  m_lDelivering;       // TRUE while a dispatcher is scheduled or running
+
+      DWORD          m_dwQueuedItems;
+      DWORD          m_dwMaxItems;
+      ULONGLONG      m_ullDelivered;
+      ULONGLONG      m_ullConflated;
+      ULONGLONG      m_ullDropped;
+
+               // protects all members except m_Delivery. The only other
+               // lock entered while owning this critical section is
+               // DaGenericServer::CriticalSectionCOMGroupList (reading).
+      CRITICAL_SECTION m_CritSec;
+
+      QUEUEDGROUP* GetGroup( long hServerGroup );
+      HRESULT ReserveValues( QUEUEDGROUP* pGroup, DWORD dwCount );
+      HRESULT ReservePos( QUEUEDGROUP* pGroup, OPCHANDLE hItem );
+      void Append( long hServerGroup, QUEUEDGROUP* pGroup );
+      BOOL TakeNext( long* phServerGroup );
+      void Dispatch( DaGenericServer* pServer );
+      static unsigned __stdcall DispatchTask( void* pContext );
+      static void ClearValues( QUEUEDGROUP* pGroup );
+      static void FreeGroup( QUEUEDGROUP* pGroup );
+};
+//DOM-IGNORE-END
+
+
+#endif // __CALLBACKQUEUE_H_
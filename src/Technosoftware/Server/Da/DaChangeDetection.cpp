@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+ //DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include <math.h>
+#include <float.h>
+#include <limits>
+#include "DaChangeDetection.h"
+#include "DaGenericItem.h"
+#include "DaDeviceItem.h"
+#include "openarray.h"
+
+
+//=========================================================================
+// DaNewChangeVersion
+// ------------------
+//    Returns a new process wide unique version number.
+//=========================================================================
+LONGLONG DaNewChangeVersion( void )
+{
+   static volatile LONGLONG llLastVersion = 0;
+
+   return InterlockedIncrement64( &llLastVersion );
+}
+
+
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaChangeColumns::DaChangeColumns()
+{
+   m_pdLastValue        = NULL;
+   m_pwLastQuality      = NULL;
+   m_pvtLastValue       = NULL;
+   m_pllVersion         = NULL;
+   m_pdThreshold        = NULL;
+   m_pllDeadbandVersion = NULL;
+   m_pfltDeadband       = NULL;
+   m_dwHandles          = 0;
+
+   m_pdwBatchIndex      = NULL;
+   m_pdBatchLast        = NULL;
+   m_pdBatchNew         = NULL;
+   m_pdBatchThreshold   = NULL;
+   m_pdwBatchChanged    = NULL;
+   m_dwBatchSize        = 0;
+
+   m_pdwDecided         = NULL;
+   m_pdwChanged         = NULL;
+   m_dwMaskSize         = 0;
+}
+
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+DaChangeColumns::~DaChangeColumns()
+{
+   delete [] m_pdLastValue;
+   delete [] m_pwLastQuality;
+   delete [] m_pvtLastValue;
+   delete [] m_pllVersion;
+   delete [] m_pdThreshold;
+   delete [] m_pllDeadbandVersion;
+   delete [] m_pfltDeadband;
+
+   delete [] m_pdwBatchIndex;
+   delete [] m_pdBatchLast;
+   delete [] m_pdBatchNew;
+   delete [] m_pdBatchThreshold;
+   delete [] m_pdwBatchChanged;
+
+   delete [] m_pdwDecided;
+   delete [] m_pdwChanged;
+}
+
+
+
+//=========================================================================
+// Compare
+// -------
+//    Compares the read values of the update with the last values sent.
+//    The items are handled in three steps:
+//       1. Items without a valid column entry are left undecided.
+//          They must be compared with DaGenericItem::CompareLastRead().
+//       2. Items with a changed quality are changed.
+//       3. The values of all other items are gathered and compared
+//          by the batch kernel.
+//
+//    Returns E_OUTOFMEMORY if the batch arrays cannot be allocated;
+//    all items are undecided in this case.
+//=========================================================================
+HRESULT DaChangeColumns::Compare( float fltGroupDeadband, DWORD dwCount,
+                                  DaGenericItem** ppGItems, DaDeviceItem** ppDItems,
+                                  const OPCITEMSTATE* pItemStates, const HRESULT* pErrors,
+                                  const DWORD** ppdwDecided, const DWORD** ppdwChanged )
+{
+   DWORD       i, dwBatch;
+   OPCHANDLE   hItem;
+   VARTYPE     vt;
+   LONGLONG    llDeadbandVersion;
+
+   HRESULT hres = ReserveBatch( dwCount );
+   if (FAILED( hres )) {
+      return hres;
+   }
+   memset( m_pdwDecided, 0, ((dwCount + 31) / 32) * sizeof (DWORD) );
+   memset( m_pdwChanged, 0, ((dwCount + 31) / 32) * sizeof (DWORD) );
+
+   dwBatch = 0;
+   for (i = 0; i < dwCount; i++) {
+
+      if (FAILED( pErrors[i] )) {
+         continue;
+      }
+      vt = V_VT( &pItemStates[i].vDataValue );
+      if (!IsBatchType( vt )) {
+         continue;
+      }
+      hItem = DaHandleIndex( ppGItems[i]->get_ServerHandle() );
+      if (hItem >= m_dwHandles ||
+          m_pllVersion[ hItem ] == 0 ||
+          m_pvtLastValue[ hItem ] != vt ||
+          m_pllVersion[ hItem ] != ppGItems[i]->get_LastReadVersion()) {
+         continue;                              // last value sent is unknown
+      }
+
+                                                // The version must be read before the
+                                                // deadband so a concurrent change is
+                                                // detected with the next update.
+      llDeadbandVersion = ppDItems[i]->get_DeadbandVersion();
+      if (m_pllDeadbandVersion[ hItem ] != llDeadbandVersion ||
+          m_pfltDeadband[ hItem ] != fltGroupDeadband) {
+         m_pdThreshold[ hItem ]        = CalcThreshold( ppDItems[i], fltGroupDeadband );
+         m_pllDeadbandVersion[ hItem ] = llDeadbandVersion;
+         m_pfltDeadband[ hItem ]       = fltGroupDeadband;
+      }
+      if (_isnan( m_pdThreshold[ hItem ] )) {
+         continue;                              // cannot be handled by the kernel
+      }
+
+      DaSetBit( m_pdwDecided, i );
+      if (m_pwLastQuality[ hItem ] != pItemStates[i].wQuality) {
+         DaSetBit( m_pdwChanged, i );
+         continue;
+      }
+
+      m_pdwBatchIndex[ dwBatch ]    = i;
+      m_pdBatchLast[ dwBatch ]      = m_pdLastValue[ hItem ];
+      m_pdBatchNew[ dwBatch ]       = ToDouble( pItemStates[i].vDataValue );
+      m_pdBatchThreshold[ dwBatch ] = m_pdThreshold[ hItem ];
+      dwBatch++;
+   }
+
+   if (dwBatch) {
+      DaDetectChanges( dwBatch, m_pdBatchLast, m_pdBatchNew, m_pdBatchThreshold, m_pdwBatchChanged );
+      for (i = 0; i < dwBatch; i++) {           // scatter the results
+         if (DaIsBitSet( m_pdwBatchChanged, i )) {
+            DaSetBit( m_pdwChanged, m_pdwBatchIndex[i] );
+         }
+      }
+   }
+
+   *ppdwDecided = m_pdwDecided;
+   *ppdwChanged = m_pdwChanged;
+   return S_OK;
+}
+
+
+
+//=========================================================================
+// SetLastSent
+// -----------
+//    Stores the value sent to the client. If the value cannot be handled
+//    by the batch change detection then the entry is invalidated.
+//=========================================================================
+void DaChangeColumns::SetLastSent( OPCHANDLE hServer, const VARIANT& vValue, WORD wQuality, LONGLONG llVersion )
+{
+   OPCHANDLE hItem = DaHandleIndex( hServer );
+
+   if (FAILED( ReserveHandles( hItem + 1 ) )) {
+      return;                                   // the item is compared by the slow path
+   }
+   if (!IsBatchType( V_VT( &vValue ) )) {
+      m_pllVersion[ hItem ] = 0;
+      return;
+   }
+   m_pdLastValue[ hItem ]   = ToDouble( vValue );
+   m_pwLastQuality[ hItem ] = wQuality;
+   m_pvtLastValue[ hItem ]  = V_VT( &vValue );
+   m_pllVersion[ hItem ]    = llVersion;
+}
+
+
+
+//=========================================================================
+// ReserveHandles
+// --------------
+//    Ensures that the columns have at least dwHandles entries.
+//    New entries are zero (unknown).
+//=========================================================================
+HRESULT DaChangeColumns::ReserveHandles( DWORD dwHandles )
+{
+   if (dwHandles <= m_dwHandles) {
+      return S_OK;
+   }
+
+   DWORD dwNewSize = m_dwHandles ? m_dwHandles : 16;
+   while (dwNewSize < dwHandles) {
+      dwNewSize *= 2;
+   }
+
+   double*     pdLastValue        = new double[ dwNewSize ];
+   WORD*       pwLastQuality      = new WORD[ dwNewSize ];
+   VARTYPE*    pvtLastValue       = new VARTYPE[ dwNewSize ];
+   LONGLONG*   pllVersion         = new LONGLONG[ dwNewSize ];
+   double*     pdThreshold        = new double[ dwNewSize ];
+   LONGLONG*   pllDeadbandVersion = new LONGLONG[ dwNewSize ];
+   float*      pfltDeadband       = new float[ dwNewSize ];
+
+   if (!pdLastValue || !pwLastQuality || !pvtLastValue || !pllVersion ||
+       !pdThreshold || !pllDeadbandVersion || !pfltDeadband) {
+      delete [] pdLastValue;
+      delete [] pwLastQuality;
+      delete [] pvtLastValue;
+      delete [] pllVersion;
+      delete [] pdThreshold;
+      delete [] pllDeadbandVersion;
+      delete [] pfltDeadband;
+      return E_OUTOFMEMORY;
+   }
+
+   memset( pdLastValue,        0, dwNewSize * sizeof (double) );
+   memset( pwLastQuality,      0, dwNewSize * sizeof (WORD) );
+   memset( pvtLastValue,       0, dwNewSize * sizeof (VARTYPE) );
+   memset( pllVersion,         0, dwNewSize * sizeof (LONGLONG) );
+   memset( pdThreshold,        0, dwNewSize * sizeof (double) );
+   memset( pllDeadbandVersion, 0, dwNewSize * sizeof (LONGLONG) );
+   memset( pfltDeadband,       0, dwNewSize * sizeof (float) );
+
+   if (m_dwHandles) {
+      memcpy( pdLastValue,        m_pdLastValue,        m_dwHandles * sizeof (double) );
+      memcpy( pwLastQuality,      m_pwLastQuality,      m_dwHandles * sizeof (WORD) );
+      memcpy( pvtLastValue,       m_pvtLastValue,       m_dwHandles * sizeof (VARTYPE) );
+      memcpy( pllVersion,         m_pllVersion,         m_dwHandles * sizeof (LONGLONG) );
+      memcpy( pdThreshold,        m_pdThreshold,        m_dwHandles * sizeof (double) );
+      memcpy( pllDeadbandVersion, m_pllDeadbandVersion, m_dwHandles * sizeof (LONGLONG) );
+      memcpy( pfltDeadband,       m_pfltDeadband,       m_dwHandles * sizeof (float) );
+   }
+
+   delete [] m_pdLastValue;
+   delete [] m_pwLastQuality;
+   delete [] m_pvtLastValue;
+   delete [] m_pllVersion;
+   delete [] m_pdThreshold;
+   delete [] m_pllDeadbandVersion;
+   delete [] m_pfltDeadband;
+
+   m_pdLastValue        = pdLastValue;
+   m_pwLastQuality      = pwLastQuality;
+   m_pvtLastValue       = pvtLastValue;
+   m_pllVersion         = pllVersion;
+   m_pdThreshold        = pdThreshold;
+   m_pllDeadbandVersion = pllDeadbandVersion;
+   m_pfltDeadband       = pfltDeadband;
+   m_dwHandles          = dwNewSize;
+   return S_OK;
+}
+
+
+
+//=========================================================================
+// ReserveBatch
+// ------------
+//    Ensures that the batch arrays and bit masks can hold dwCount items.
+//    The contents are not preserved.
+//=========================================================================
+HRESULT DaChangeColumns::ReserveBatch( DWORD dwCount )
+{
+   if (dwCount <= m_dwBatchSize) {
+      return S_OK;
+   }
+
+   DWORD dwNewSize = m_dwBatchSize ? m_dwBatchSize : 16;
+   while (dwNewSize < dwCount) {
+      dwNewSize *= 2;
+   }
+   DWORD dwMaskSize = (dwNewSize + 31) / 32;
+
+   delete [] m_pdwBatchIndex;
+   delete [] m_pdBatchLast;
+   delete [] m_pdBatchNew;
+   delete [] m_pdBatchThreshold;
+   delete [] m_pdwBatchChanged;
+   delete [] m_pdwDecided;
+   delete [] m_pdwChanged;
+
+   m_pdwBatchIndex    = new DWORD[ dwNewSize ];
+   m_pdBatchLast      = new double[ dwNewSize ];
+   m_pdBatchNew       = new double[ dwNewSize ];
+   m_pdBatchThreshold = new double[ dwNewSize ];
+   m_pdwBatchChanged  = new DWORD[ dwMaskSize ];
+   m_pdwDecided       = new DWORD[ dwMaskSize ];
+   m_pdwChanged       = new DWORD[ dwMaskSize ];
+
+   if (!m_pdwBatchIndex || !m_pdBatchLast || !m_pdBatchNew || !m_pdBatchThreshold ||
+       !m_pdwBatchChanged || !m_pdwDecided || !m_pdwChanged) {
+      delete [] m_pdwBatchIndex;    m_pdwBatchIndex    = NULL;
+      delete [] m_pdBatchLast;      m_pdBatchLast      = NULL;
+      delete [] m_pdBatchNew;       m_pdBatchNew       = NULL;
+      delete [] m_pdBatchThreshold; m_pdBatchThreshold = NULL;
+      delete [] m_pdwBatchChanged;  m_pdwBatchChanged  = NULL;
+      delete [] m_pdwDecided;       m_pdwDecided       = NULL;
+      delete [] m_pdwChanged;       m_pdwChanged       = NULL;
+      m_dwBatchSize = 0;
+      m_dwMaskSize  = 0;
+      return E_OUTOFMEMORY;
+   }
+   m_dwBatchSize = dwNewSize;
+   m_dwMaskSize  = dwMaskSize;
+   return S_OK;
+}
+
+
+
+//=========================================================================
+// CalcThreshold
+// -------------
+//    Calculates the deadband threshold of an item in the same way as
+//    CompareVariant():
+//       < 0   : the values must be equal (no analog EU info)
+//       >= 0  : maximum absolute difference of unchanged values
+//       NaN   : the item cannot be handled by the batch kernel
+//=========================================================================
+double DaChangeColumns::CalcThreshold( DaDeviceItem* pDItem, float fltGroupDeadband )
+{
+   float       fltPercentDeadband = fltGroupDeadband;
+   FLOAT       fltItemDeadband;
+   OPCEUTYPE   EUType;
+   double      dAnalogEURange;
+
+   if (SUCCEEDED( pDItem->GetItemDeadband( &fltItemDeadband ) )) {
+      fltPercentDeadband = fltItemDeadband;     // the item deadband overrides the group deadband
+   }
+   pDItem->get_DeadbandEUInfo( &EUType, &dAnalogEURange );
+
+   if (EUType != OPC_ANALOG) {
+      return -1.0;
+   }
+   if (fltPercentDeadband == (float)100.0) {
+      return HUGE_VAL;                          // 100% deadband means do not report value changes
+   }
+
+   double dDeadbandRange = (fltPercentDeadband/100) * ( dAnalogEURange );
+   if (_isnan( dDeadbandRange ) || dDeadbandRange < 0) {
+      return std::numeric_limits<double>::quiet_NaN();
+   }
+   return dDeadbandRange;
+}
+
+
+
+//=========================================================================
+// ToDouble
+// --------
+//    Returns the value of a variant with a batch type as double.
+//    The conversion is exact for all batch types.
+//=========================================================================
+double DaChangeColumns::ToDouble( const VARIANT& vValue )
+{
+   switch (V_VT( &vValue )) {
+      case VT_R8: return V_R8( &vValue );
+      case VT_R4: return (double)V_R4( &vValue );
+      case VT_I4: return (double)V_I4( &vValue );
+   }
+   _ASSERTE( FALSE );
+   return 0;
+}
+//DOM-IGNORE-END
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __CHANGEDETECTION_H_
+#define __CHANGEDETECTION_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+#include "DaChangeKernels.h"
+
+class DaGenericItem;
+class DaDeviceItem;
+
+
+//-----------------------------------------------------------------------
+// Change Versions
+//    Process wide unique version numbers. A version number is never
+//    assigned twice, so a cached version identifies the state of an
+//    object even if the object has been deleted and a new object has
+//    been created at the same address or with the same handle.
+//    0 is never returned and may be used as 'unknown'.
+//-----------------------------------------------------------------------
+LONGLONG DaNewChangeVersion( void );
+
+inline LONGLONG DaReadChangeVersion( volatile LONGLONG* pllVersion )
+{
+   return InterlockedCompareExchange64( pllVersion, 0, 0 );
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Change Columns
+// --------------
+// Last values sent to the client of the scalar numeric items of
+// a group, stored in columns indexed by the slot of the server item
+// handle (DaHandleIndex()).
+//
+// With each update Compare() decides for all items whose last sent
+// value is known in the columns whether the value has changed.
+// The deadband check of all these items is done by the batch
+// kernel without entering the critical sections of the Generic
+// Items or Device Items. The other items must be compared with
+// DaGenericItem::CompareLastRead().
+//
+// A column entry is only used if it has the same last read version
+// as the Generic Item (see DaGenericItem::get_LastReadVersion()).
+// The deadband threshold is recalculated if the deadband version of
+// the Device Item or the percent deadband of the group changes.
+//
+// Only used by DaGenericGroup::UpdateToClient(), which is never
+// executed concurrently for the same group. Not thread safe.
+/////////////////////////////////////////////////////////////////
+class DaChangeColumns {
+
+   public:
+      DaChangeColumns();
+      ~DaChangeColumns();
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns TRUE if values of the specified type are handled
+         //  by the batch change detection.
+         ///////////////////////////////////////////////////////////////
+      static BOOL IsBatchType( VARTYPE vt )
+      {
+         return (vt == VT_R8) || (vt == VT_R4) || (vt == VT_I4);
+      }
+
+         ///////////////////////////////////////////////////////////////
+         //  Compares the read values with the last values sent.
+         //  Bit i of *ppdwDecided is set if the result for item i is
+         //  available in bit i of *ppdwChanged. The returned bit masks
+         //  are valid until the next call.
+         //  Returns E_OUTOFMEMORY if no result is available.
+         ///////////////////////////////////////////////////////////////
+      HRESULT Compare( float fltGroupDeadband, DWORD dwCount,
+                       DaGenericItem** ppGItems, DaDeviceItem** ppDItems,
+                       const OPCITEMSTATE* pItemStates, const HRESULT* pErrors,
+                       const DWORD** ppdwDecided, const DWORD** ppdwChanged );
+
+         ///////////////////////////////////////////////////////////////
+         //  Stores the value sent to the client and the last read
+         //  version returned by DaGenericItem::UpdateLastRead().
+         ///////////////////////////////////////////////////////////////
+      void SetLastSent( OPCHANDLE hServer, const VARIANT& vValue, WORD wQuality, LONGLONG llVersion );
+
+   private:
+                  // Columns indexed by DaHandleIndex() of the server item handle
+      double      *m_pdLastValue;         // last value sent
+      WORD        *m_pwLastQuality;       // last quality sent
+      VARTYPE     *m_pvtLastValue;        // data type of the last value sent
+      LONGLONG    *m_pllVersion;          // last read version of the item, 0 if unknown
+      double      *m_pdThreshold;         // deadband threshold, < 0 if values must be equal
+      LONGLONG    *m_pllDeadbandVersion;  // deadband version of the device item
+      float       *m_pfltDeadband;        // percent deadband of the group
+      DWORD       m_dwHandles;            // allocated entries of the columns
+
+                  // Batch arrays indexed by the batch position
+      DWORD       *m_pdwBatchIndex;       // index of the item in the update arrays
+      double      *m_pdBatchLast;
+      double      *m_pdBatchNew;
+      double      *m_pdBatchThreshold;
+      DWORD       *m_pdwBatchChanged;     // result of the kernel
+      DWORD       m_dwBatchSize;          // allocated entries of the batch arrays
+
+                  // Bit masks indexed by the update array position
+      DWORD       *m_pdwDecided;
+      DWORD       *m_pdwChanged;
+      DWORD       m_dwMaskSize;           // allocated DWORDs of the bit masks
+
+      HRESULT ReserveHandles( DWORD dwHandles );
+      HRESULT ReserveBatch( DWORD dwCount );
+      static double CalcThreshold( DaDeviceItem* pDItem, float fltGroupDeadband );
+      static double ToDouble( const VARIANT& vValue );
+};
+//DOM-IGNORE-END
+
+
+#endif // __CHANGEDETECTION_H_
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+ //DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include <math.h>
+#include <string.h>
+#include "DaChangeKernels.h"
+#ifdef DA_CHANGEKERNELS_SIMD
+#include <intrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+
+//=========================================================================
+// DaDetectChangesScalar
+// ---------------------
+//    Portable implementation of the batch change detection kernel.
+//=========================================================================
+void DaDetectChangesScalar( DWORD dwCount, const double* pdLast, const double* pdNew,
+                            const double* pdThreshold, DWORD* pdwChanged )
+{
+   DWORD i;
+
+   memset( pdwChanged, 0, ((dwCount + 31) / 32) * sizeof (DWORD) );
+
+   for (i = 0; i < dwCount; i++) {
+      BOOL fChanged;
+      if (pdThreshold[i] < 0) {
+         fChanged = pdNew[i] != pdLast[i];
+      }
+      else {
+         fChanged = fabs( pdNew[i] - pdLast[i] ) > pdThreshold[i];
+      }
+      if (fChanged) {
+         DaSetBit( pdwChanged, i );
+      }
+   }
+}
+
+
+
+#ifdef DA_CHANGEKERNELS_SIMD
+
+//=========================================================================
+// DaDetectChangesSSE2
+// -------------------
+//    Two elements per iteration. The comparisons have the same results
+//    as the C operators used by DaDetectChangesScalar(), also for NaN.
+//=========================================================================
+void DaDetectChangesSSE2( DWORD dwCount, const double* pdLast, const double* pdNew,
+                          const double* pdThreshold, DWORD* pdwChanged )
+{
+   const __m128d  SignMask = _mm_set1_pd( -0.0 );
+   const __m128d  Zero     = _mm_setzero_pd();
+   DWORD          i;
+
+   memset( pdwChanged, 0, ((dwCount + 31) / 32) * sizeof (DWORD) );
+
+   for (i = 0; i + 2 <= dwCount; i += 2) {
+      __m128d Last      = _mm_loadu_pd( pdLast + i );
+      __m128d New       = _mm_loadu_pd( pdNew + i );
+      __m128d Threshold = _mm_loadu_pd( pdThreshold + i );
+
+      __m128d Diff      = _mm_andnot_pd( SignMask, _mm_sub_pd( New, Last ) );
+      __m128d Exact     = _mm_cmplt_pd( Threshold, Zero );
+      __m128d Changed   = _mm_or_pd( _mm_and_pd( Exact, _mm_cmpneq_pd( New, Last ) ),
+                                     _mm_andnot_pd( Exact, _mm_cmpgt_pd( Diff, Threshold ) ) );
+
+      pdwChanged[ i >> 5 ] |= (DWORD)_mm_movemask_pd( Changed ) << (i & 31);
+   }
+
+   if (i < dwCount) {                           // remaining element
+      DWORD dwTail;
+      DaDetectChangesScalar( dwCount - i, pdLast + i, pdNew + i, pdThreshold + i, &dwTail );
+      pdwChanged[ i >> 5 ] |= dwTail << (i & 31);
+   }
+}
+
+
+
+//=========================================================================
+// DaDetectChangesAVX
+// ------------------
+//    Four elements per iteration. Only called if the processor and the
+//    operating system support AVX.
+//=========================================================================
+void DaDetectChangesAVX( DWORD dwCount, const double* pdLast, const double* pdNew,
+                         const double* pdThreshold, DWORD* pdwChanged )
+{
+   const __m256d  SignMask = _mm256_set1_pd( -0.0 );
+   const __m256d  Zero     = _mm256_setzero_pd();
+   DWORD          i;
+
+   memset( pdwChanged, 0, ((dwCount + 31) / 32) * sizeof (DWORD) );
+
+   for (i = 0; i + 4 <= dwCount; i += 4) {
+      __m256d Last      = _mm256_loadu_pd( pdLast + i );
+      __m256d New       = _mm256_loadu_pd( pdNew + i );
+      __m256d Threshold = _mm256_loadu_pd( pdThreshold + i );
+
+      __m256d Diff      = _mm256_andnot_pd( SignMask, _mm256_sub_pd( New, Last ) );
+      __m256d Exact     = _mm256_cmp_pd( Threshold, Zero, _CMP_LT_OQ );
+      __m256d Changed   = _mm256_or_pd( _mm256_and_pd( Exact, _mm256_cmp_pd( New, Last, _CMP_NEQ_UQ ) ),
+                                        _mm256_andnot_pd( Exact, _mm256_cmp_pd( Diff, Threshold, _CMP_GT_OQ ) ) );
+
+      pdwChanged[ i >> 5 ] |= (DWORD)_mm256_movemask_pd( Changed ) << (i & 31);
+   }
+   _mm256_zeroupper();
+
+   if (i < dwCount) {                           // remaining elements
+      DWORD dwTail;
+      DaDetectChangesScalar( dwCount - i, pdLast + i, pdNew + i, pdThreshold + i, &dwTail );
+      pdwChanged[ i >> 5 ] |= dwTail << (i & 31);
+   }
+}
+
+
+
+//=========================================================================
+// DaIsAVXSupported
+// ----------------
+//    Returns TRUE if the processor supports AVX and the operating system
+//    saves the AVX registers.
+//=========================================================================
+BOOL DaIsAVXSupported( void )
+{
+   static volatile LONG lAVX = -1;              // -1 : not yet checked
+
+   if (lAVX < 0) {
+      int   CPUInfo[4];
+      LONG  lSupported = 0;
+
+      __cpuid( CPUInfo, 1 );
+      if ((CPUInfo[2] & (1 << 27)) &&           // OSXSAVE
+          (CPUInfo[2] & (1 << 28))) {           // AVX
+         if ((_xgetbv( 0 ) & 0x6) == 0x6) {     // XMM and YMM state enabled
+            lSupported = 1;
+         }
+      }
+      InterlockedExchange( &lAVX, lSupported );
+   }
+   return lAVX ? TRUE : FALSE;
+}
+
+#endif // DA_CHANGEKERNELS_SIMD
+
+
+
+//=========================================================================
+// DaDetectChanges
+// ---------------
+//    Batch change detection kernel. Uses the widest instruction set
+//    available.
+//=========================================================================
+void DaDetectChanges( DWORD dwCount, const double* pdLast, const double* pdNew,
+                      const double* pdThreshold, DWORD* pdwChanged )
+{
+#ifdef DA_CHANGEKERNELS_SIMD
+   if (DaIsAVXSupported()) {
+      DaDetectChangesAVX( dwCount, pdLast, pdNew, pdThreshold, pdwChanged );
+   }
+   else {
+      DaDetectChangesSSE2( dwCount, pdLast, pdNew, pdThreshold, pdwChanged );
+   }
+#else
+   DaDetectChangesScalar( dwCount, pdLast, pdNew, pdThreshold, pdwChanged );
+#endif
+}
+
+
+
+//DOM-IGNORE-END
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+#ifndef __CHANGEKERNELS_H_
+#define __CHANGEKERNELS_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+#if defined(_M_X64) || defined(_M_IX86)
+#define DA_CHANGEKERNELS_SIMD
+#endif
+
+
+//-----------------------------------------------------------------------
+// Batch Change Detection Kernel
+//    For each element i the bit i of pdwChanged is set if
+//       pdThreshold[i] <  0 :  pdNew[i] != pdLast[i]
+//       pdThreshold[i] >= 0 :  fabs( pdNew[i] - pdLast[i] ) > pdThreshold[i]
+//    and cleared otherwise. pdwChanged must hold (dwCount + 31) / 32
+//    DWORDs.
+//
+//    DaDetectChanges() uses AVX or SSE2 instructions if available.
+//    DaDetectChangesScalar() is the portable implementation and
+//    returns identical results.
+//
+//    The kernels do not depend on the other server classes and are
+//    also built by the unit test in Tests/ChangeDetection.
+//-----------------------------------------------------------------------
+void DaDetectChanges( DWORD dwCount, const double* pdLast, const double* pdNew,
+                      const double* pdThreshold, DWORD* pdwChanged );
+
+void DaDetectChangesScalar( DWORD dwCount, const double* pdLast, const double* pdNew,
+                            const double* pdThreshold, DWORD* pdwChanged );
+
+#ifdef DA_CHANGEKERNELS_SIMD
+void DaDetectChangesSSE2( DWORD dwCount, const double* pdLast, const double* pdNew,
+                          const double* pdThreshold, DWORD* pdwChanged );
+
+                  // Must only be called if DaIsAVXSupported() returns TRUE.
+void DaDetectChangesAVX( DWORD dwCount, const double* pdLast, const double* pdNew,
+                         const double* pdThreshold, DWORD* pdwChanged );
+
+BOOL DaIsAVXSupported( void );
+#endif
+
+
+inline BOOL DaIsBitSet( const DWORD* pdwBits, DWORD i )
+{
+   return (pdwBits[ i >> 5 ] & (1UL << (i & 31))) ? TRUE : FALSE;
+}
+
+inline void DaSetBit( DWORD* pdwBits, DWORD i )
+{
+   pdwBits[ i >> 5 ] |= (1UL << (i & 31));
+}
+//DOM-IGNORE-END
+
+
+#endif // __CHANGEKERNELS_H_
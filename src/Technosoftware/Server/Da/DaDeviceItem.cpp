@@ -23,9 +23,81 @@
 #include "stdafx.h"
 #include <comdef.h>                             // for _variant_t
 #include "DaDeviceItem.h"
+#include "DaGenericItem.h"
+#include "DaGenericGroup.h"
 #include "UtilityFuncs.h"
 #include "variantconversion.h"
+#include "VariantCompare.h"
 #include "DaBaseServer.h"
+#include "DaStringArena.h"
+#include "DaValueStore.h"
+#include "OpcClock.h"
+
+               // Number of critical sections shared by the items to
+               // protect all item attributes (power of 2)
+#define  DA_DEVICEITEM_ATTRLOCKS       64
+
+               // Item IDs and Access Paths of all items
+static DaStringArena gItemStrings;
+
+               // Values, qualities and time stamps of all items
+static DaValueStore gItemValues;
+
+               // Number of items read with one pass over the value store
+#define  DA_DEVICEITEM_READ_BLOCK      256
+
+               // Number of items updated by SetItemValues() while owning
+               // the value locks of the block. Readers of values in the
+               // side table wait until the block is written.
+#define  DA_DEVICEITEM_WRITE_BLOCK     1024
+
+               // Number of changed Generic Items collected by
+               // SetItemValues() before they are queued to their groups
+#define  DA_DEVICEITEM_DIRTY_BLOCK     512
+
+               // Critical sections returned by get_AllAttrsCritSec() and
+               // get_ValueCritSec()
+static struct tagATTRLOCKS {
+   CRITICAL_SECTION  aCritSec[ DA_DEVICEITEM_ATTRLOCKS ];
+
+   tagATTRLOCKS() {
+      for (int i = 0; i < DA_DEVICEITEM_ATTRLOCKS; i++) {
+         InitializeCriticalSection( &aCritSec[i] );
+      }
+   }
+   ~tagATTRLOCKS() {
+      for (int i = 0; i < DA_DEVICEITEM_ATTRLOCKS; i++) {
+         DeleteCriticalSection( &aCritSec[i] );
+      }
+   }
+} gAttrLocks, gValueLocks;
+
+               // Index of the shared critical sections of an item
+static inline DWORD LockIndex( const DaDeviceItem* pDItem )
+{
+   ULONG_PTR uIndex = ((ULONG_PTR)pDItem >> 6) ^ ((ULONG_PTR)pDItem >> 12);
+   return (DWORD)(uIndex & (DA_DEVICEITEM_ATTRLOCKS - 1));
+}
+
+               // Counters returned by GetMemoryStatistics()
+static volatile LONG       glDeviceItems     = 0;
+static volatile LONGLONG   gllEUInfoBytes    = 0;
+
+               // Memory of an EU info: the variant and the array data
+               // (without the strings of enumerated EU infos)
+static LONGLONG EUInfoBytes( VARIANT* pEUInfo )
+{
+   LONGLONG llBytes = sizeof (VARIANT);
+
+   if ((V_VT( pEUInfo ) & VT_ARRAY) && V_ARRAY( pEUInfo )) {
+      SAFEARRAY* psa = V_ARRAY( pEUInfo );
+      llBytes += sizeof (SAFEARRAY);
+      if (psa->cDims == 1) {
+         llBytes += (LONGLONG)psa->rgsabound[0].cElements * psa->cbElements;
+      }
+   }
+   return llBytes;
+}
 
 //=========================================================================
 // Constructor
@@ -38,21 +110,33 @@ DaDeviceItem::DaDeviceItem( void )
    m_ToKill             = FALSE;
    m_RefCount           = 0;
    m_AccessRights       = OPC_READABLE; 
-   m_Quality            = OPC_QUALITY_BAD;   // init to BAD
    m_BlobSize           = 0;
    m_pBlob              = NULL;
    m_EUType             = OPC_NOENUM;
    m_dwActiveCount      = 0;
    m_dAnalogEURange     = 0;
    m_fltPercentDeadband = -1;
+   m_lChangeVersion     = 0;
+   m_llDeadbandVersion  = DaNewChangeVersion();
+   m_nActiveChangeSubscribers = 0;
+   m_pSharedSubscriptions  = NULL;
+   m_dwSharedSubscriptions = 0;
+   m_pPendingRead       = NULL;
+   m_dwPendingReadIndex = 0;
+   m_dwOrdinal          = gItemValues.Allocate();   // value VT_EMPTY, quality BAD
+   m_fDirectValueAccess = FALSE;
+
+   m_pEUInfo            = NULL;
+
+   if (m_dwOrdinal != DA_VALUESTORE_NO_ORDINAL) {
+      FILETIME ftNow;
+      OpcClockCoarse( &ftNow );        // now
+      gItemValues.SetQuality( m_dwOrdinal, OPC_QUALITY_BAD, &ftNow );
+   }
 
-   VariantInit( &m_EUInfo );
-   VariantInit( &m_Value  );
-
-   CoFileTimeNow( &m_TimeStamp );      // now
-
-   InitializeCriticalSection( &m_CritSecAllAttrs );
-   InitializeCriticalSection( &m_CritSec );
+                                       // No debug info: saves a heap block per item
+   InitializeCriticalSectionEx( &m_CritSec, 0, CRITICAL_SECTION_NO_DEBUG_INFO );
+   InterlockedIncrement( &glDeviceItems );
 }
 
 
@@ -87,6 +171,10 @@ HRESULT DaDeviceItem::Create(  LPWSTR                  szItemID,
 
    HRESULT hres;
 
+   if (m_dwOrdinal == DA_VALUESTORE_NO_ORDINAL) {
+      return E_OUTOFMEMORY;                     // No space in the value store
+   }
+
    hres = set_ItemID( szItemID );
    if (FAILED( hres )) {
       return hres;
@@ -103,7 +191,13 @@ HRESULT DaDeviceItem::Create(  LPWSTR                  szItemID,
       _variant_t vEUDummy;
       hres = set_EUData( eEUType, &vEUDummy );
    }
-   hres = VariantCopy( &m_Value, pvValue );
+   WORD     wQuality;
+   FILETIME ftTimeStamp;
+
+   EnterCriticalSection( get_ValueCritSec() );
+   gItemValues.ReadQuality( m_dwOrdinal, &wQuality, &ftTimeStamp );
+   hres = gItemValues.SetValue( m_dwOrdinal, pvValue, wQuality, &ftTimeStamp );
+   LeaveCriticalSection( get_ValueCritSec() );
 
    if (FAILED( hres )) {
       return hres;
@@ -118,16 +212,20 @@ HRESULT DaDeviceItem::Create(  LPWSTR                  szItemID,
 //=========================================================================
 DaDeviceItem::~DaDeviceItem()
 {
-   if (m_ItemID) {
-      delete m_ItemID;
+   _ASSERTE( m_arChangeSubscribers.GetSize() == 0 );  // All Generic Items must be detached
+
+   FreeSharedSubscriptions();
+   gItemStrings.Free( m_ItemID );           // m_AccessPath is interned
+   if (m_dwOrdinal != DA_VALUESTORE_NO_ORDINAL) {
+      gItemValues.Release( m_dwOrdinal );
    }
-   if (m_AccessPath) {
-      delete m_AccessPath;
+   if (m_pEUInfo) {
+      InterlockedAdd64( &gllEUInfoBytes, -EUInfoBytes( m_pEUInfo ) );
+      VariantClear( m_pEUInfo );
+      delete m_pEUInfo;
    }
-   VariantClear( &m_Value );
-   VariantClear( &m_EUInfo );
    DeleteCriticalSection( &m_CritSec );
-   DeleteCriticalSection( &m_CritSecAllAttrs );
+   InterlockedDecrement( &glDeviceItems );
 }
 
 
@@ -199,12 +297,12 @@ HRESULT DaDeviceItem::set_ItemID( LPWSTR ItemID )
    EnterCriticalSection( &m_CritSec );
 
    if ( m_ItemID != NULL ) {
-      delete m_ItemID;
+      gItemStrings.Free( m_ItemID );
       m_ItemID = NULL;
    }
 
    if ( ItemID != NULL ) {
-      m_ItemID = WSTRClone( ItemID, NULL );
+      m_ItemID = gItemStrings.Alloc( ItemID );
       if ( m_ItemID == NULL ) {
          LeaveCriticalSection( &m_CritSec );
          return E_OUTOFMEMORY;
@@ -314,6 +412,334 @@ BOOL DaDeviceItem::Killed( void )
 
 
 
+//=========================================================================
+// get_AllAttrsCritSec
+// -------------------
+//    Returns the critical section which protects all item attributes.
+//    Items are distributed over the shared critical sections by their
+//    address.
+//=========================================================================
+LPCRITICAL_SECTION DaDeviceItem::get_AllAttrsCritSec( void )
+{
+   return &gAttrLocks.aCritSec[ LockIndex( this ) ];
+}
+
+
+
+//=========================================================================
+// get_ValueCritSec                                              PROTECTED
+// ----------------
+//    Returns the critical section which serializes the writers of the
+//    cache of the item. Distributed like get_AllAttrsCritSec(); the
+//    index is the same so that SetItemValues() can sort the items by it.
+//=========================================================================
+LPCRITICAL_SECTION DaDeviceItem::get_ValueCritSec( void )
+{
+   return &gValueLocks.aCritSec[ LockIndex( this ) ];
+}
+
+
+
+//=========================================================================
+// GetMemoryStatistics                                              STATIC
+// -------------------
+//=========================================================================
+void DaDeviceItem::GetMemoryStatistics( DADEVICEITEMMEMSTATS* pStats )
+{
+   DASTRINGARENASTATS StringStats;
+   DAVALUESTORESTATS  ValueStats;
+   ULONGLONG          ullTotal;
+
+   gItemStrings.GetStatistics( &StringStats );
+   gItemValues.GetStatistics( &ValueStats );
+
+   pStats->dwItems         = (DWORD)max( glDeviceItems, 0 );
+   pStats->dwItemSize      = sizeof (DaDeviceItem);
+   pStats->ullStringBytes  = StringStats.ullReservedBytes;
+   pStats->ullEUInfoBytes  = (ULONGLONG)max( InterlockedCompareExchange64( &gllEUInfoBytes, 0, 0 ), 0 );
+   pStats->ullValueBytes   = ValueStats.ullBytes;
+
+   ullTotal = (ULONGLONG)pStats->dwItems * pStats->dwItemSize
+              + pStats->ullStringBytes + pStats->ullEUInfoBytes + pStats->ullValueBytes;
+   pStats->dwBytesPerItem  = pStats->dwItems ? (DWORD)(ullTotal / pStats->dwItems) : 0;
+}
+
+
+
+//=========================================================================
+// ReadItemValues                                                   STATIC
+// --------------
+//    Reads the items in blocks: first the columns of all items of the
+//    block, then the values which are not scalar with get_ItemValue().
+//    The virtual get_ItemValue() is also called for all items without
+//    m_fDirectValueAccess.
+//=========================================================================
+HRESULT DaDeviceItem::ReadItemValues( DWORD dwCount, DaDeviceItem** ppDItems,
+                                      OPCITEMSTATE* pItemStates, HRESULT* pErrors )
+{
+   DWORD          adwIndex[ DA_DEVICEITEM_READ_BLOCK ];     // index in the arrays of the caller
+   DWORD          adwOrdinal[ DA_DEVICEITEM_READ_BLOCK ];
+   DASCALARVQT    aVQT[ DA_DEVICEITEM_READ_BLOCK ];
+   DWORD          dwBlock, i, b;
+   VARIANT        vValue;
+   VARIANT        *pvValue;
+   HRESULT        hres, hresReturn = S_OK;
+
+   for (i = 0; i < dwCount; ) {
+                                                // Collect the next block
+      for (dwBlock = 0; i < dwCount && dwBlock < DA_DEVICEITEM_READ_BLOCK; i++) {
+         if (ppDItems[i] == NULL || FAILED( pErrors[i] )) {
+            continue;
+         }
+         adwIndex[ dwBlock ]     = i;
+         adwOrdinal[ dwBlock ]   = ppDItems[i]->m_dwOrdinal;
+         dwBlock++;
+      }
+                                                // One pass over the columns
+      gItemValues.ReadScalars( dwBlock, adwOrdinal, aVQT );
+
+      for (b = 0; b < dwBlock; b++) {
+         DWORD          n = adwIndex[b];
+         OPCITEMSTATE*  pState = &pItemStates[n];
+
+         pvValue = &pState->vDataValue;
+         if (V_VT( pvValue ) == VT_EMPTY) {     // Use the canonical data type
+            V_VT( pvValue ) = aVQT[b].vt;
+         }
+
+         if (DaValueStore::IsScalarType( aVQT[b].vt ) && ppDItems[n]->m_fDirectValueAccess) {
+            V_VT( &vValue ) = aVQT[b].vt;
+            vValue.llVal = aVQT[b].llValue;
+            VARTYPE vtRequested = V_VT( pvValue );
+            VariantInit( pvValue );
+            hres = VariantFromVariant( pvValue, vtRequested, &vValue );
+            if (SUCCEEDED( hres )) {
+               pState->wQuality     = aVQT[b].wQuality;
+               pState->ftTimeStamp  = aVQT[b].ftTimeStamp;
+            }
+         }
+         else {                                 // Value with allocated memory or
+                                                // read by the derived class
+            hres = ppDItems[n]->get_ItemValue( pvValue, &pState->wQuality, &pState->ftTimeStamp );
+         }
+
+         pState->wReserved = 0;
+         if (FAILED( hres )) {
+            pErrors[n] = hres;
+            VariantClear( pvValue );
+            hresReturn = S_FALSE;
+         }
+      }
+   }
+   return hresReturn;
+}
+
+
+
+//=========================================================================
+// QueueDirtyItems
+// ---------------
+//    Adds the Generic Items marked dirty by SetItemValues() to the dirty
+//    lists of their groups, with one call per group. ppGroups and
+//    phServerItems are the groups and server handles of the items. If a
+//    group cannot add the items they are marked clean again. Clears
+//    ppGroups.
+//=========================================================================
+static void QueueDirtyItems( DWORD dwCount, DaGenericItem** ppGItems, DaGenericGroup** ppGroups,
+                             const OPCHANDLE* phServerItems )
+{
+   OPCHANDLE      ahServerItems[ DA_DEVICEITEM_DIRTY_BLOCK ];
+   DaGenericGroup *pGroup;
+   DWORD          i, j, dwGroupCount;
+   HRESULT        hres;
+
+   _ASSERTE( dwCount <= DA_DEVICEITEM_DIRTY_BLOCK );
+
+   for (i = 0; i < dwCount; i++) {
+      if ((pGroup = ppGroups[i]) == NULL) {
+         continue;                              // Already queued with its group
+      }
+      dwGroupCount = 0;
+      for (j = i; j < dwCount; j++) {           // Collect the items of the group
+         if (ppGroups[j] == pGroup) {
+            ahServerItems[ dwGroupCount++ ] = phServerItems[j];
+         }
+      }
+      hres = pGroup->AddDirtyItems( dwGroupCount, ahServerItems );
+      for (j = i; j < dwCount; j++) {
+         if (ppGroups[j] == pGroup) {
+            if (FAILED( hres )) {
+               ppGItems[j]->ClearDirty();       // Marked again by the next change
+            }
+            ppGroups[j] = NULL;
+         }
+      }
+   }
+}
+
+
+
+//=========================================================================
+// SetItemValues                                                    STATIC
+// -------------
+//    Checks the handles and data types of all items first; the data
+//    type is read from the value store without lock. Items without
+//    m_fDirectValueAccess are updated by the virtual set_ItemValue()
+//    and set_ItemQuality() of the derived class.
+//
+//    The other items are updated in blocks of DA_DEVICEITEM_WRITE_BLOCK
+//    items sorted by their value lock. Each lock used by the block is
+//    entered once, in ascending order. The changed Generic Items are
+//    queued to their groups before the locks are left because they may
+//    be unsubscribed and deleted afterwards.
+//=========================================================================
+HRESULT DaDeviceItem::SetItemValues( DWORD dwCount, DaDeviceItem** ppDItems, const VARIANT* pvValues,
+                                     const WORD* pwQualities, const FILETIME* pftTimeStamps,
+                                     HRESULT* pErrors )
+{
+   _ASSERTE( ppDItems );                        // Must not be NULL
+   _ASSERTE( pwQualities );                     // Must not be NULL
+   _ASSERTE( pErrors );                         // Must not be NULL
+
+   DWORD          adwBlock[ DA_DEVICEITEM_WRITE_BLOCK ];
+   DWORD          adwSorted[ DA_DEVICEITEM_WRITE_BLOCK ];
+   DWORD          adwLockStart[ DA_DEVICEITEM_ATTRLOCKS + 1 ];
+   DaGenericItem  *apGItems[ DA_DEVICEITEM_DIRTY_BLOCK ];
+   DaGenericGroup *apGroups[ DA_DEVICEITEM_DIRTY_BLOCK ];
+   OPCHANDLE      ahServerItems[ DA_DEVICEITEM_DIRTY_BLOCK ];
+   DaGenericItem  *pGItem;
+   DWORD          dwGItems;
+   FILETIME       ftNow;
+   const FILETIME *pftTimeStamp;
+   const VARIANT  *pvValue;
+   DaDeviceItem   *pDItem;
+   DWORD          i, j, dwBlock, dwNext, dwLock;
+   int            k;
+   HRESULT        hres, hresReturn = S_OK;
+
+   if (pftTimeStamps == NULL) {                 // Same time stamp for all items
+      OpcClockCoarse( &ftNow );
+   }
+                                                // Check all items
+   for (i = 0; i < dwCount; i++) {
+      pDItem = ppDItems[i];
+      if (pDItem == NULL) {
+         pErrors[i] = OPC_E_INVALIDHANDLE;
+         hresReturn = S_FALSE;
+         continue;
+      }
+      pErrors[i] = S_OK;
+      if (pvValues) {
+         VARTYPE vt = V_VT( &pvValues[i] );
+         if (vt != VT_EMPTY && vt != VT_NULL &&
+             vt != gItemValues.GetDataType( pDItem->m_dwOrdinal )) {
+            pErrors[i] = OPC_E_BADTYPE;
+            hresReturn = S_FALSE;
+         }
+      }
+   }
+                                                // Update the items with overrides
+   for (i = 0; i < dwCount; i++) {
+      if (pErrors[i] != S_OK || ppDItems[i]->m_fDirectValueAccess) {
+         continue;
+      }
+      pDItem         = ppDItems[i];
+      pvValue        = pvValues ? &pvValues[i] : NULL;
+      pftTimeStamp   = pftTimeStamps ? &pftTimeStamps[i] : &ftNow;
+
+      if (pvValue && V_VT( pvValue ) != VT_EMPTY && V_VT( pvValue ) != VT_NULL) {
+         hres = pDItem->set_ItemValue( const_cast<LPVARIANT>( pvValue ), pwQualities[i],
+                                       const_cast<LPFILETIME>( pftTimeStamp ) );
+      }
+      else {
+         hres = pDItem->set_ItemQuality( pwQualities[i], const_cast<LPFILETIME>( pftTimeStamp ) );
+      }
+      if (FAILED( hres )) {
+         pErrors[i] = hres;
+         hresReturn = S_FALSE;
+      }
+   }
+                                                // Update the other items block by block
+   for (i = 0; i < dwCount; ) {
+                                                // Collect the items of the block
+      dwBlock = 0;
+      for (; i < dwCount && dwBlock < DA_DEVICEITEM_WRITE_BLOCK; i++) {
+         if (pErrors[i] == S_OK && ppDItems[i]->m_fDirectValueAccess) {
+            adwBlock[ dwBlock++ ] = i;
+         }
+      }
+      if (dwBlock == 0) {
+         continue;
+      }
+                                                // Sort the items by their lock
+      memset( adwLockStart, 0, sizeof (adwLockStart) );
+      for (j = 0; j < dwBlock; j++) {
+         adwLockStart[ LockIndex( ppDItems[ adwBlock[j] ] ) + 1 ]++;
+      }
+      for (dwLock = 0; dwLock < DA_DEVICEITEM_ATTRLOCKS; dwLock++) {
+         adwLockStart[ dwLock + 1 ] += adwLockStart[ dwLock ];
+      }
+      for (j = 0; j < dwBlock; j++) {
+         dwLock = LockIndex( ppDItems[ adwBlock[j] ] );
+         adwSorted[ adwLockStart[ dwLock ]++ ] = adwBlock[j];
+      }                                         // adwLockStart[n] is now the end of lock n
+
+                                                // Enter the used locks in ascending order
+      for (dwLock = 0; dwLock < DA_DEVICEITEM_ATTRLOCKS; dwLock++) {
+         if (adwLockStart[ dwLock ] != (dwLock ? adwLockStart[ dwLock - 1 ] : 0)) {
+            EnterCriticalSection( &gValueLocks.aCritSec[ dwLock ] );
+         }
+      }
+
+      dwGItems = 0;
+      for (j = 0; j < dwBlock; j++) {
+         dwNext         = adwSorted[j];
+         pDItem         = ppDItems[ dwNext ];
+         pvValue        = pvValues ? &pvValues[ dwNext ] : NULL;
+         pftTimeStamp   = pftTimeStamps ? &pftTimeStamps[ dwNext ] : &ftNow;
+
+         if (pvValue && V_VT( pvValue ) != VT_EMPTY && V_VT( pvValue ) != VT_NULL) {
+            hres = gItemValues.SetValue( pDItem->m_dwOrdinal, pvValue, pwQualities[ dwNext ], pftTimeStamp );
+         }
+         else {
+            gItemValues.SetQuality( pDItem->m_dwOrdinal, pwQualities[ dwNext ], pftTimeStamp );
+            hres = S_OK;
+         }
+         if (FAILED( hres )) {
+            pErrors[ dwNext ] = hres;
+            hresReturn = S_FALSE;
+            continue;
+         }
+                                                // Same as NotifyChange() but the
+                                                // groups are called once per block
+         InterlockedIncrement( &pDItem->m_lChangeVersion );
+         for (k = 0; k < pDItem->m_nActiveChangeSubscribers; k++) {
+            pGItem = pDItem->m_arChangeSubscribers[k];
+            if (pGItem->SetDirty()) {
+               if (dwGItems == DA_DEVICEITEM_DIRTY_BLOCK) {
+                  QueueDirtyItems( dwGItems, apGItems, apGroups, ahServerItems );
+                  dwGItems = 0;
+               }
+               apGItems[ dwGItems ]       = pGItem;
+               apGroups[ dwGItems ]       = pGItem->get_Group();
+               ahServerItems[ dwGItems ]  = pGItem->get_ServerHandle();
+               dwGItems++;
+            }
+         }
+      }
+      QueueDirtyItems( dwGItems, apGItems, apGroups, ahServerItems );
+                                                // Leave the locks in descending order
+      for (dwLock = DA_DEVICEITEM_ATTRLOCKS; dwLock-- > 0; ) {
+         if (adwLockStart[ dwLock ] != (dwLock ? adwLockStart[ dwLock - 1 ] : 0)) {
+            LeaveCriticalSection( &gValueLocks.aCritSec[ dwLock ] );
+         }
+      }
+   }
+   return hresReturn;
+}
+
+
+
 //=========================================================================
 // get_Active
 //=========================================================================
@@ -414,7 +840,7 @@ HRESULT DaDeviceItem::get_EUData( OPCEUTYPE *pEUType, VARIANT *pEUInfo )
 
    *pEUType = m_EUType;                   // returns the currently set info
    VariantInit( pEUInfo );                // AM, 11-may-98
-   HRESULT hres = VariantCopy( pEUInfo, &m_EUInfo );
+   HRESULT hres = m_pEUInfo ? VariantCopy( pEUInfo, m_pEUInfo ) : S_OK;
 
    LeaveCriticalSection( &m_CritSec );
 
@@ -440,8 +866,10 @@ HRESULT DaDeviceItem::get_EUData( OPCEUTYPE *pEUType, VARIANT *pEUInfo )
 //=========================================================================
 HRESULT DaDeviceItem::set_EUData( OPCEUTYPE EUType, VARIANT *pEUInfo )
 {
-   HRESULT  hres;
-   VARIANT  varOld;
+   HRESULT  hres = S_OK;
+   VARIANT* pNewEUInfo = NULL;
+   VARIANT* pOldEUInfo;
+   double   dAnalogEURange = 0;
 
 
    #ifdef _DEBUG     // Plausibility checks
@@ -455,56 +883,57 @@ HRESULT DaDeviceItem::set_EUData( OPCEUTYPE EUType, VARIANT *pEUInfo )
 
    #endif            // Plausibility checks
 
-   VariantInit( &varOld );
-   EnterCriticalSection( &m_CritSec );
-
-                                       // First save the current value so we can restore it
-                                       // if the new value cannot be set.
-   hres = VariantCopy( &varOld, &m_EUInfo );
-
-   if (SUCCEEDED( hres )) {
-                                       // Clear current value
-      hres = VariantClear( &m_EUInfo );
-   }
-   if (SUCCEEDED( hres )) {
-                                       // Set new value
-      hres = VariantCopy( &m_EUInfo, pEUInfo );
-      if (FAILED( hres )) {
-                                       // Restore to old value if new value cannot be set.
-                                       // Keep result returned by copy function.
-         VariantCopy( &m_EUInfo, &varOld );
+   if (EUType != OPC_NOENUM) {         // Items without EU info don't use memory for it
+      pNewEUInfo = new VARIANT;
+      if (pNewEUInfo == NULL) {
+         return E_OUTOFMEMORY;
       }
-      else {
-         m_EUType = EUType;            // stores the passed EUInfo
+      VariantInit( pNewEUInfo );
+      hres = VariantCopy( pNewEUInfo, pEUInfo );
 
-         if (EUType == OPC_ANALOG) {   // store specified range into 'm_dAnalogRange'.
+      if (SUCCEEDED( hres ) && EUType == OPC_ANALOG) {
+                                       // store specified range into 'm_dAnalogRange'.
                                        // For this reason the range must not be calcuated at
                                        // every update cycle.
-            double   dLow = 0;
-            double   dHi  = 0;
-            long     lElIndex = 0;
+         double   dLow = 0;
+         double   dHi  = 0;
+         long     lElIndex = 0;
+
+         hres = SafeArrayGetElement( V_ARRAY( pEUInfo ), &lElIndex, &dLow );     // LOW EU range
+         if (SUCCEEDED( hres )) {
+            lElIndex++;
+            hres = SafeArrayGetElement( V_ARRAY( pEUInfo ), &lElIndex, &dHi );   // HI  EU range
+         }
+         if (SUCCEEDED( hres )) {
+            dAnalogEURange = dHi - dLow;
+         }
+      } // EU Type is Analog
 
-            hres = SafeArrayGetElement( V_ARRAY( pEUInfo ), &lElIndex, &dLow );     // LOW EU range
-            if (SUCCEEDED( hres )) {
-               lElIndex++;
-               hres = SafeArrayGetElement( V_ARRAY( pEUInfo ), &lElIndex, &dHi );   // HI  EU range
-            }
-            if (SUCCEEDED( hres )) {
-               m_dAnalogEURange = dHi - dLow;
-            }
-            else {
-                                       // Restore to old value if EU info cannotbe read.
-                                       // Keep result returned by EU access function.
-               VariantCopy( &m_EUInfo, &varOld );
-            }
-         } // EU Type is Analog
+      if (FAILED( hres )) {            // Keep the current value if the new value cannot be set
+         VariantClear( pNewEUInfo );
+         delete pNewEUInfo;
+         return hres;
       }
+      InterlockedAdd64( &gllEUInfoBytes, EUInfoBytes( pNewEUInfo ) );
    }
 
+   EnterCriticalSection( &m_CritSec );
+
+   pOldEUInfo       = m_pEUInfo;
+   m_pEUInfo        = pNewEUInfo;      // stores the passed EUInfo
+   m_EUType         = EUType;
+   m_dAnalogEURange = dAnalogEURange;
+   InterlockedExchange64( &m_llDeadbandVersion, DaNewChangeVersion() );
+   NotifyChange();                     // The deadband calculation depends on the EU info
+
    LeaveCriticalSection( &m_CritSec );
-   VariantClear( &varOld );            // Clear temporary variant
 
-   return hres;
+   if (pOldEUInfo) {
+      InterlockedAdd64( &gllEUInfoBytes, -EUInfoBytes( pOldEUInfo ) );
+      VariantClear( pOldEUInfo );
+      delete pOldEUInfo;
+   }
+   return S_OK;
 }
 
 
@@ -536,6 +965,23 @@ HRESULT DaDeviceItem::get_AnalogEURange( double* pdAnalogEURange )
 
 
 
+//=========================================================================
+// get_DeadbandEUInfo
+// ------------------
+//    Returns the EU type and the analog EU range (0 if the EU type is
+//    not analog) without copying the EU info. Used by the deadband
+//    handling with every update.
+//=========================================================================
+void DaDeviceItem::get_DeadbandEUInfo( OPCEUTYPE* pEUType, double* pdAnalogEURange )
+{
+   EnterCriticalSection( &m_CritSec );
+   *pEUType          = m_EUType;
+   *pdAnalogEURange  = m_dAnalogEURange;
+   LeaveCriticalSection( &m_CritSec );
+}
+
+
+
 //=========================================================================
 // Get the Item's CanonicalDataType
 // --------------------------------
@@ -545,7 +991,7 @@ HRESULT DaDeviceItem::get_AnalogEURange( double* pdAnalogEURange )
 //=========================================================================
 VARTYPE DaDeviceItem::get_CanonicalDataType( void )
 {
-   return V_VT(&m_Value);       // return the current VARIANT type
+   return gItemValues.GetDataType( m_dwOrdinal );  // return the current VARIANT type
 }
 
 
@@ -587,7 +1033,10 @@ HRESULT DaDeviceItem::get_AccessRights( DWORD *pAccessRights )
 //=========================================================================
 HRESULT DaDeviceItem::set_AccessRights( DWORD DaAccessRights )
 {
+   EnterCriticalSection( &m_CritSec );
    m_AccessRights = DaAccessRights;
+   NotifyChange();                              // Item may become readable
+   LeaveCriticalSection( &m_CritSec );
    return S_OK;
 }
 
@@ -604,11 +1053,11 @@ HRESULT DaDeviceItem::get_OPCITEMRESULT( BOOL blobUpdate, OPCITEMRESULT* pItemRe
 {
    HRESULT hres = S_OK;
 
-   EnterCriticalSection( &m_CritSecAllAttrs );
+   EnterCriticalSection( get_AllAttrsCritSec() );
    EnterCriticalSection( &m_CritSec );
 
    pItemResult->hServer             = 0;
-   pItemResult->vtCanonicalDataType = V_VT( &m_Value );
+   pItemResult->vtCanonicalDataType = get_CanonicalDataType();
    pItemResult->wReserved           = 0;
    pItemResult->dwAccessRights      = m_AccessRights;
 
@@ -621,7 +1070,7 @@ HRESULT DaDeviceItem::get_OPCITEMRESULT( BOOL blobUpdate, OPCITEMRESULT* pItemRe
    }
 
    LeaveCriticalSection( &m_CritSec );
-   LeaveCriticalSection( &m_CritSecAllAttrs );
+   LeaveCriticalSection( get_AllAttrsCritSec() );
 
    if (FAILED( hres )) {
       pItemResult->hServer             = 0;
@@ -668,16 +1117,16 @@ HRESULT DaDeviceItem::get_ItemValue( LPVARIANT   pvValue,
 
    VariantInit( pvValue );                      // Initialze the destination variant. Only the
                                                 // 'vt' data member with requested data type was valid.
-   EnterCriticalSection( &m_CritSec );
-
-   hr = VariantFromVariant(   pvValue,
-                              vtRequestedDataType, &m_Value );
-
-   if (SUCCEEDED( hr )) {
-      *pwQuality     = m_Quality;
-      *pftTimeStamp  = m_TimeStamp;
+                                                // Scalar values are read without lock
+   if (gItemValues.ReadScalar( m_dwOrdinal, vtRequestedDataType, pvValue,
+                               pwQuality, pftTimeStamp, &hr )) {
+      return hr;
    }
-   LeaveCriticalSection( &m_CritSec );
+
+   EnterCriticalSection( get_ValueCritSec() );
+   hr = gItemValues.ReadValue( m_dwOrdinal, vtRequestedDataType, pvValue,
+                               pwQuality, pftTimeStamp );
+   LeaveCriticalSection( get_ValueCritSec() );
    return hr;
 }
 
@@ -693,39 +1142,38 @@ HRESULT DaDeviceItem::get_ItemValue( LPVARIANT   pvValue,
 // Depending on the application this method may need to force it.
 //
 // This function requires a value with the canonical data type.
+// Returns the same error codes as SetItemValues() for a single item:
+// OPC_E_BADTYPE if the value has not the canonical data type.
 //=========================================================================
 HRESULT DaDeviceItem::set_ItemValue( LPVARIANT   pvValue,
                                     WORD        wQuality,      /* = OPC_QUALITY_GOOD | OPC_LIMIT_OK */
                                     LPFILETIME  pftTimeStamp   /* = NULL */ )
 {
-   //_ASSERTE( pvValue );                         // Must not be NULL
-   //_ASSERTE( get_CanonicalDataType() == V_VT( pvValue ) );
-
-   if (pvValue == NULL || get_CanonicalDataType() != V_VT(pvValue))
-   {
-	   return S_FALSE;
+   if (pvValue == NULL) {
+      return E_INVALIDARG;
+   }
+   if (get_CanonicalDataType() != V_VT( pvValue )) {
+      return OPC_E_BADTYPE;
    }
 
    FILETIME ftTimeStamp;
    HRESULT  hres;
 
    if (!pftTimeStamp) {
-      hres = CoFileTimeNow( &ftTimeStamp );
-      if (FAILED( hres )) return hres;
+      OpcClockCoarse( &ftTimeStamp );
    }
    else {
       ftTimeStamp = *pftTimeStamp;
    }
 
-   EnterCriticalSection( &m_CritSec );
-                                                // Note : VariantCopy() frees the destination variant if all succeeded.
-   hres = VariantCopy( &m_Value, pvValue );     // Set the new value
+   EnterCriticalSection( get_ValueCritSec() );
+                                                // Set the new value
+   hres = gItemValues.SetValue( m_dwOrdinal, pvValue, wQuality, &ftTimeStamp );
    if (SUCCEEDED( hres )) {
-      m_Quality   = wQuality;
-      m_TimeStamp = ftTimeStamp;
+      NotifyChange();
    }
 
-   LeaveCriticalSection( &m_CritSec );
+   LeaveCriticalSection( get_ValueCritSec() );
    return hres;
 }
 
@@ -743,19 +1191,18 @@ HRESULT DaDeviceItem::set_ItemQuality(  WORD        wQuality,
    if (!pftTimeStamp) {
       FILETIME ftTimeStamp;
                                                 // Get current time
-      HRESULT hres = CoFileTimeNow( &ftTimeStamp );
-      if (FAILED( hres )) return hres;
+      OpcClockCoarse( &ftTimeStamp );
 
-      EnterCriticalSection( &m_CritSec );
-      m_Quality   = wQuality;
-      m_TimeStamp = ftTimeStamp;
-      LeaveCriticalSection( &m_CritSec );
+      EnterCriticalSection( get_ValueCritSec() );
+      gItemValues.SetQuality( m_dwOrdinal, wQuality, &ftTimeStamp );
+      NotifyChange();
+      LeaveCriticalSection( get_ValueCritSec() );
    }
    else {
-      EnterCriticalSection( &m_CritSec );
-      m_Quality   = wQuality;
-      m_TimeStamp = *pftTimeStamp;
-      LeaveCriticalSection( &m_CritSec );
+      EnterCriticalSection( get_ValueCritSec() );
+      gItemValues.SetQuality( m_dwOrdinal, wQuality, pftTimeStamp );
+      NotifyChange();
+      LeaveCriticalSection( get_ValueCritSec() );
    }
    return S_OK;
 }
@@ -790,8 +1237,7 @@ HRESULT DaDeviceItem::set_ItemVQT( OPCITEMVQT* pItemVQT )
    if (pItemVQT->bTimeStampSpecified)
       ftTimeStamp = pItemVQT->ftTimeStamp;
    else {
-      hr = CoFileTimeNow( &ftTimeStamp );
-      if (FAILED( hr )) return hr;
+      OpcClockCoarse( &ftTimeStamp );
    }
 
    if (pItemVQT->bQualitySpecified)
@@ -800,22 +1246,20 @@ HRESULT DaDeviceItem::set_ItemVQT( OPCITEMVQT* pItemVQT )
       wQuality = OPC_QUALITY_GOOD | OPC_LIMIT_OK;
   
    if (V_VT( &pItemVQT->vDataValue ) == VT_EMPTY) {
-      EnterCriticalSection( &m_CritSec );
-      m_Quality   = wQuality;
-      m_TimeStamp = ftTimeStamp;
-      LeaveCriticalSection( &m_CritSec );
+      EnterCriticalSection( get_ValueCritSec() );
+      gItemValues.SetQuality( m_dwOrdinal, wQuality, &ftTimeStamp );
+      NotifyChange();
+      LeaveCriticalSection( get_ValueCritSec() );
    }
    else {
       _ASSERTE( get_CanonicalDataType() == V_VT( &pItemVQT->vDataValue ) );
-      EnterCriticalSection( &m_CritSec );
-                                                // Note : VariantCopy() frees the destination variant if all succeeded.
+      EnterCriticalSection( get_ValueCritSec() );
                                                 // Set the new value
-      hr = VariantCopy( &m_Value, &pItemVQT->vDataValue );     
+      hr = gItemValues.SetValue( m_dwOrdinal, &pItemVQT->vDataValue, wQuality, &ftTimeStamp );
       if (SUCCEEDED( hr )) {
-         m_Quality   = wQuality;
-         m_TimeStamp = ftTimeStamp;
+         NotifyChange();
       }
-      LeaveCriticalSection( &m_CritSec );
+      LeaveCriticalSection( get_ValueCritSec() );
    }
    return hr;   
 }
@@ -859,9 +1303,11 @@ BOOL DaDeviceItem::IsTimeStampOlderThan( LPFILETIME pftTimeStamp )
 {
    _ASSERTE( pftTimeStamp );                    // Must not be NULL
    
-   EnterCriticalSection( &m_CritSec );
-   LONG lRes = CompareFileTime( &m_TimeStamp, pftTimeStamp );
-   LeaveCriticalSection( &m_CritSec );
+   WORD     wQuality;
+   FILETIME ftTimeStamp;
+                                                // The time stamp is always read without lock
+   gItemValues.ReadQuality( m_dwOrdinal, &wQuality, &ftTimeStamp );
+   LONG lRes = CompareFileTime( &ftTimeStamp, pftTimeStamp );
 
    return (lRes == -1) ? TRUE : FALSE;
 }
@@ -896,7 +1342,7 @@ HRESULT DaDeviceItem::get_PropertyValue( DaBaseServer* const pServerHandler,
       case OPC_PROPERTY_DATATYPE :              // Canonical Data Type
          EnterCriticalSection( &m_CritSec );    // 22-jan-2002 MT
          V_VT( pvPropData ) = VT_I2;
-         V_I2( pvPropData ) = V_VT( &m_Value );
+         V_I2( pvPropData ) = get_CanonicalDataType();
          LeaveCriticalSection( &m_CritSec );    // 22-jan-2002 MT
          break;
 
@@ -906,26 +1352,32 @@ HRESULT DaDeviceItem::get_PropertyValue( DaBaseServer* const pServerHandler,
          {
                                                 // Refresh Cache from Device
             DaDeviceItem* pDevItem = this;
-            pServerHandler->OnRefreshInputCache( OPC_REFRESH_CLIENT, 1, &pDevItem, &hres );
+            pServerHandler->RefreshInputCacheCoalesced( 1, &pDevItem, &hres );
             if (SUCCEEDED( hres )) {            // Use the individual item error as return code
                                                 // Cache refresh succeeded
 
+               WORD     wQuality;
+               FILETIME ftTimeStamp;
+
                pServerHandler->readWriteLock_.BeginReading();
-               EnterCriticalSection( &m_CritSec ); // 22-jan-2002 MT
+               EnterCriticalSection( get_ValueCritSec() );
                switch (dwPropID) {
 
                   case OPC_PROPERTY_VALUE :
-                     hres = VariantCopy( pvPropData, &m_Value );
+                     hres = gItemValues.ReadValue( m_dwOrdinal, VT_EMPTY, pvPropData,
+                                                   &wQuality, &ftTimeStamp );
                      break;
 
                   case OPC_PROPERTY_QUALITY :
+                     gItemValues.ReadQuality( m_dwOrdinal, &wQuality, &ftTimeStamp );
                      V_VT( pvPropData ) = VT_I2;
-                     V_I2( pvPropData ) = m_Quality;
+                     V_I2( pvPropData ) = wQuality;
                      break;
 
                   case OPC_PROPERTY_TIMESTAMP :
+                     gItemValues.ReadQuality( m_dwOrdinal, &wQuality, &ftTimeStamp );
                      V_VT( pvPropData ) = VT_DATE;
-                     hres = FileTimeToDATE( &m_TimeStamp, V_DATE( pvPropData ) );
+                     hres = FileTimeToDATE( &ftTimeStamp, V_DATE( pvPropData ) );
                      break;
 
                   default :
@@ -933,7 +1385,7 @@ HRESULT DaDeviceItem::get_PropertyValue( DaBaseServer* const pServerHandler,
                      break;
                }
                                                 
-               LeaveCriticalSection( &m_CritSec ); // 22-jan-2002 MT
+               LeaveCriticalSection( get_ValueCritSec() );
                pServerHandler->readWriteLock_.EndReading();
             }
          }
@@ -972,10 +1424,10 @@ HRESULT DaDeviceItem::get_PropertyValue( DaBaseServer* const pServerHandler,
       case OPC_PROPERTY_HIGH_EU :
       case OPC_PROPERTY_LOW_EU :
          EnterCriticalSection( &m_CritSec );    // 22-jan-2002 MT
-         if (m_EUType == OPC_ANALOG) {
+         if (m_EUType == OPC_ANALOG && m_pEUInfo) {
             long lElIndex = (dwPropID == OPC_PROPERTY_HIGH_EU) ? 1 : 0;
             V_VT( pvPropData ) = VT_R8;
-            hres = SafeArrayGetElement( V_ARRAY( &m_EUInfo ), &lElIndex, &V_R8( pvPropData )  );
+            hres = SafeArrayGetElement( V_ARRAY( m_pEUInfo ), &lElIndex, &V_R8( pvPropData )  );
          }
          LeaveCriticalSection( &m_CritSec );    // 22-jan-2002 MT
          break;
@@ -1056,14 +1508,11 @@ HRESULT DaDeviceItem::set_AccessPath( LPWSTR AccessPath )
 
    EnterCriticalSection( &m_CritSec );
 
-   if( m_AccessPath != NULL ) {        // already a path defined
-      delete m_AccessPath;
-   }
-
    if( AccessPath == NULL) {           // no path definition
       m_AccessPath = NULL;             // clear member variable
    } else {                              // Path definition passed
-      m_AccessPath = WSTRClone( AccessPath, NULL );
+                                       // Items share equal paths
+      m_AccessPath = gItemStrings.Intern( AccessPath );
       if ( m_AccessPath == NULL ) {
          LeaveCriticalSection( &m_CritSec );
          return E_OUTOFMEMORY;         // error
@@ -1135,6 +1584,8 @@ HRESULT DaDeviceItem::SetItemDeadband( FLOAT fltPercentDeadband )
    }
    else {
       m_fltPercentDeadband = fltPercentDeadband;
+      InterlockedExchange64( &m_llDeadbandVersion, DaNewChangeVersion() );
+      NotifyChange();
    }
 
    LeaveCriticalSection( &m_CritSec );
@@ -1185,10 +1636,329 @@ HRESULT DaDeviceItem::ClearItemDeadband()
    }
    else {
       m_fltPercentDeadband = -1;
+      InterlockedExchange64( &m_llDeadbandVersion, DaNewChangeVersion() );
+      NotifyChange();
    }
    
    LeaveCriticalSection( &m_CritSec );
    return hr;
 }
 
+
+
+//=========================================================================
+// Registers a Generic Item which must be marked dirty if this item
+// changes. The Generic Item is added as inactive subscriber.
+//=========================================================================
+HRESULT DaDeviceItem::AddChangeSubscriber( DaGenericItem* pGItem )
+{
+   _ASSERTE( pGItem );                          // Must not be NULL
+   _ASSERTE( pGItem->m_iSubscriberIndex == -1 );// Must not be subscribed
+
+   EnterCriticalSection( &m_CritSec );
+   EnterCriticalSection( get_ValueCritSec() );
+   BOOL fAdded = m_arChangeSubscribers.Add( pGItem );
+   if (fAdded) {
+      pGItem->m_iSubscriberIndex = m_arChangeSubscribers.GetSize() - 1;
+   }
+   LeaveCriticalSection( get_ValueCritSec() );
+   LeaveCriticalSection( &m_CritSec );
+
+   return fAdded ? S_OK : E_OUTOFMEMORY;
+}
+
+
+
+//=========================================================================
+// Unregisters a Generic Item. After this function returns the Generic
+// Item is no longer accessed by this Device Item.
+//=========================================================================
+HRESULT DaDeviceItem::RemoveChangeSubscriber( DaGenericItem* pGItem )
+{
+   HRESULT hr = E_INVALIDARG;
+
+   EnterCriticalSection( &m_CritSec );
+   EnterCriticalSection( get_ValueCritSec() );
+
+   int i = pGItem->m_iSubscriberIndex;
+   if (i >= 0 && i < m_arChangeSubscribers.GetSize() && m_arChangeSubscribers[i] == pGItem) {
+      if (i < m_nActiveChangeSubscribers) {     // Move to the end of the active items
+         m_nActiveChangeSubscribers--;
+         SwapChangeSubscribers( i, m_nActiveChangeSubscribers );
+         i = m_nActiveChangeSubscribers;
+      }
+                                                // Move to the end of the list
+      SwapChangeSubscribers( i, m_arChangeSubscribers.GetSize() - 1 );
+      m_arChangeSubscribers.RemoveAt( m_arChangeSubscribers.GetSize() - 1 );
+      pGItem->m_iSubscriberIndex = -1;
+      hr = S_OK;
+   }
+   LeaveCriticalSection( get_ValueCritSec() );
+   if (m_nActiveChangeSubscribers < 2) {
+      FreeSharedSubscriptions();                // Nothing to share
+   }
+
+   LeaveCriticalSection( &m_CritSec );
+   return hr;
+}
+
+
+
+//=========================================================================
+// Changes the active state of a subscribed Generic Item. Only active
+// subscribers are marked dirty if this item changes.
+//=========================================================================
+void DaDeviceItem::SetChangeSubscriberActive( DaGenericItem* pGItem, BOOL fActive )
+{
+   EnterCriticalSection( &m_CritSec );
+   EnterCriticalSection( get_ValueCritSec() );
+
+   int i = pGItem->m_iSubscriberIndex;
+   if (i >= 0 && i < m_arChangeSubscribers.GetSize() && m_arChangeSubscribers[i] == pGItem) {
+      if (fActive && i >= m_nActiveChangeSubscribers) {
+         SwapChangeSubscribers( i, m_nActiveChangeSubscribers );
+         m_nActiveChangeSubscribers++;
+      }
+      else if (!fActive && i < m_nActiveChangeSubscribers) {
+         m_nActiveChangeSubscribers--;
+         SwapChangeSubscribers( i, m_nActiveChangeSubscribers );
+      }
+   }
+   LeaveCriticalSection( get_ValueCritSec() );
+   if (m_nActiveChangeSubscribers < 2) {
+      FreeSharedSubscriptions();                // Nothing to share
+   }
+
+   LeaveCriticalSection( &m_CritSec );
+}
+
+
+
+//=========================================================================
+// Returns the number of subscribed Generic Items. Used for diagnostics.
+// No handles of the groups are returned because the groups cannot be
+// attached within m_CritSec.
+//=========================================================================
+void DaDeviceItem::get_ChangeSubscriberCount( DWORD* pdwCount, DWORD* pdwActiveCount )
+{
+   _ASSERTE( pdwCount && pdwActiveCount );
+
+   EnterCriticalSection( &m_CritSec );
+   *pdwCount = m_arChangeSubscribers.GetSize();
+   *pdwActiveCount = m_nActiveChangeSubscribers;
+   LeaveCriticalSection( &m_CritSec );
+}
+
+
+
+//=========================================================================
+// SwapChangeSubscribers                                           PRIVATE
+// ---------------------
+//    Exchanges two subscribers and updates their positions.
+//    Must be called within m_CritSec and get_ValueCritSec().
+//=========================================================================
+void DaDeviceItem::SwapChangeSubscribers( int i, int j )
+{
+   if (i != j) {
+      DaGenericItem* pGItem = m_arChangeSubscribers[i];
+      m_arChangeSubscribers[i] = m_arChangeSubscribers[j];
+      m_arChangeSubscribers[j] = pGItem;
+      m_arChangeSubscribers[i]->m_iSubscriberIndex = i;
+      m_arChangeSubscribers[j]->m_iSubscriberIndex = j;
+   }
+}
+
+
+
+//=========================================================================
+// NotifyChange                                                  PROTECTED
+// ------------
+//    Increments the change version and marks all active subscribed
+//    Generic Items as dirty. Must be called within m_CritSec or
+//    get_ValueCritSec().
+//=========================================================================
+void DaDeviceItem::NotifyChange( void )
+{
+   InterlockedIncrement( &m_lChangeVersion );
+
+   for (int i = 0; i < m_nActiveChangeSubscribers; i++) {
+      m_arChangeSubscribers[i]->MarkDirty();
+   }
+}
+
+
+
+//=========================================================================
+// ReadShared
+// ----------
+//    Returns the value of the item converted to the requested data type
+//    and the tokens of the shared subscription of the calling group.
+//    The subscription is evaluated by the first group which reads the
+//    item after it has changed; the other groups get a copy of the
+//    result. See the class declaration for the use of the tokens.
+//
+//    Returns S_FALSE if the value is not shared.
+//=========================================================================
+HRESULT DaDeviceItem::ReadShared( VARTYPE vtRequested, DWORD dwUpdateRate, float fltGroupDeadband,
+                                  OPCITEMSTATE* pItemState, DASHAREDREAD* pShared )
+{
+   _ASSERTE( pItemState );                      // Must not be NULL
+   _ASSERTE( pShared );                         // Must not be NULL
+
+   SHAREDSUBSCRIPTION   *pSub, *pFound, **ppLink;
+   ULONGLONG            ullNow, ullExpiry;
+   HRESULT              hres;
+
+   EnterCriticalSection( &m_CritSec );
+
+   if (m_nActiveChangeSubscribers < 2) {
+      LeaveCriticalSection( &m_CritSec );
+      return S_FALSE;                           // Only one group reads this item
+   }
+
+   if (vtRequested == VT_EMPTY) {
+      vtRequested = get_CanonicalDataType();
+   }
+
+   // Find the subscription and remove the subscriptions no longer used
+   ullNow = GetTickCount64();
+   pFound = NULL;
+   ppLink = &m_pSharedSubscriptions;
+   while ((pSub = *ppLink) != NULL) {
+      if (pSub->vtRequested  == vtRequested  &&
+          pSub->dwUpdateRate == dwUpdateRate &&
+          pSub->fltDeadband  == fltGroupDeadband) {
+         pFound = pSub;
+      }
+      else {
+         ullExpiry = max( (ULONGLONG)DA_SHAREDSUBSCRIPTION_EXPIRY, 2 * (ULONGLONG)pSub->dwUpdateRate );
+         if (ullNow - pSub->ullLastUsed > ullExpiry) {
+            *ppLink = pSub->pNext;
+            VariantClear( &pSub->vValue );
+            VariantClear( &pSub->vLastSent );
+            delete pSub;
+            m_dwSharedSubscriptions--;
+            continue;
+         }
+      }
+      ppLink = &pSub->pNext;
+   }
+
+   if (pFound == NULL) {
+      if (m_dwSharedSubscriptions >= DA_SHAREDSUBSCRIPTION_MAX) {
+         LeaveCriticalSection( &m_CritSec );
+         return S_FALSE;                        // Too many different subscriptions
+      }
+      pFound = new SHAREDSUBSCRIPTION;
+      if (pFound == NULL) {
+         LeaveCriticalSection( &m_CritSec );
+         return S_FALSE;
+      }
+      pFound->vtRequested      = vtRequested;
+      pFound->dwUpdateRate     = dwUpdateRate;
+      pFound->fltDeadband      = fltGroupDeadband;
+      pFound->lChangeVersion   = 0;
+      pFound->fEvaluated       = FALSE;
+      pFound->hrRead           = E_FAIL;
+      VariantInit( &pFound->vValue );
+      pFound->wQuality         = OPC_QUALITY_BAD;
+      VariantInit( &pFound->vLastSent );
+      pFound->wLastSentQuality = OPC_QUALITY_BAD;
+      pFound->llToken          = 0;
+      pFound->llPrevToken      = 0;
+      pFound->pNext            = m_pSharedSubscriptions;
+      m_pSharedSubscriptions   = pFound;
+      m_dwSharedSubscriptions++;
+   }
+   pFound->ullLastUsed = ullNow;
+
+   if (!pFound->fEvaluated || pFound->lChangeVersion != m_lChangeVersion) {
+      EvaluateSharedSubscription( pFound );
+   }
+
+   hres = pFound->hrRead;
+   if (SUCCEEDED( hres )) {
+      VariantInit( &pItemState->vDataValue );
+      hres = VariantCopy( &pItemState->vDataValue, &pFound->vValue );
+      pItemState->wQuality    = pFound->wQuality;
+      pItemState->ftTimeStamp = pFound->ftTimeStamp;
+      pItemState->wReserved   = 0;
+   }
+   pShared->llToken     = pFound->llToken;
+   pShared->llPrevToken = pFound->llPrevToken;
+
+   LeaveCriticalSection( &m_CritSec );
+   return FAILED( hres ) ? hres : S_OK;
+}
+
+
+
+//=========================================================================
+// EvaluateSharedSubscription                                    PROTECTED
+// --------------------------
+//    Reads the current value and compares it with the last value sent
+//    of the subscription. If the value has changed it becomes the last
+//    value sent with a new token. If the values cannot be compared no
+//    token is valid; all groups must compare the items themselves.
+//    Must be called within m_CritSec.
+//=========================================================================
+void DaDeviceItem::EvaluateSharedSubscription( SHAREDSUBSCRIPTION* pSub )
+{
+   BOOL     fChanged;
+   FLOAT    fltDeadband;
+   HRESULT  hres;
+
+   pSub->fEvaluated     = TRUE;
+   pSub->lChangeVersion = m_lChangeVersion;
+   pSub->llPrevToken    = pSub->llToken;
+
+   VariantClear( &pSub->vValue );
+   V_VT( &pSub->vValue ) = pSub->vtRequested;
+   pSub->hrRead = get_ItemValue( &pSub->vValue, &pSub->wQuality, &pSub->ftTimeStamp );
+   if (FAILED( pSub->hrRead )) {
+      return;                                   // The last value sent is unchanged
+   }
+
+   fChanged = TRUE;
+   if (pSub->llToken != 0 && pSub->wLastSentQuality == pSub->wQuality) {
+      // Same deadband handling as DaGenericItem::CompareLastRead()
+      fltDeadband = pSub->fltDeadband;
+      GetItemDeadband( &fltDeadband );
+      hres = CompareVariant( *this, fltDeadband, pSub->vLastSent, pSub->vValue, fChanged );
+      if (FAILED( hres )) {
+         pSub->llToken = pSub->llPrevToken = 0;
+         return;
+      }
+   }
+
+   if (fChanged) {
+      if (FAILED( VariantCopy( &pSub->vLastSent, &pSub->vValue ) )) {
+         pSub->llToken = pSub->llPrevToken = 0;
+         return;
+      }
+      pSub->wLastSentQuality = pSub->wQuality;
+      pSub->llToken = DaNewChangeVersion();
+   }
+}
+
+
+
+//=========================================================================
+// FreeSharedSubscriptions                                       PROTECTED
+// -----------------------
+//    Must be called within m_CritSec.
+//=========================================================================
+void DaDeviceItem::FreeSharedSubscriptions( void )
+{
+   SHAREDSUBSCRIPTION* pSub;
+
+   while ((pSub = m_pSharedSubscriptions) != NULL) {
+      m_pSharedSubscriptions = pSub->pNext;
+      VariantClear( &pSub->vValue );
+      VariantClear( &pSub->vLastSent );
+      delete pSub;
+   }
+   m_dwSharedSubscriptions = 0;
+}
+
 //DOM-IGNORE-END
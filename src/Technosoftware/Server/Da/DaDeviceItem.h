@@ -26,10 +26,39 @@
 #pragma once
 #endif // _MSC_VER >= 1000
 
+#include "DaChangeDetection.h"
+
 class DaBaseServer;
+class DaGenericItem;
+class DaGenericGroup;
+
+               // Maximum number of shared subscriptions of a Device Item
+#define  DA_SHAREDSUBSCRIPTION_MAX        8
+               // Minimum time in ms a shared subscription is kept if unused
+#define  DA_SHAREDSUBSCRIPTION_EXPIRY     60000
+
+
+               // Memory used by the Device Items, see DaDeviceItem::GetMemoryStatistics()
+typedef struct tagDADEVICEITEMMEMSTATS {
+   DWORD       dwItems;                   // existing Device Items
+   DWORD       dwItemSize;                // sizeof(DaDeviceItem), without members of derived classes
+   ULONGLONG   ullStringBytes;            // memory reserved for Item IDs and Access Paths
+   ULONGLONG   ullEUInfoBytes;            // memory of the EU infos
+   ULONGLONG   ullValueBytes;             // memory of the value store
+   DWORD       dwBytesPerItem;            // average memory per item
+} DADEVICEITEMMEMSTATS;
+
+
+               // Result of DaDeviceItem::ReadShared(). The tokens identify
+               // the last value sent of a shared subscription.
+typedef struct tagDASHAREDREAD {
+   LONGLONG    llToken;                   // last value sent after this update
+   LONGLONG    llPrevToken;               // last value sent before this update
+} DASHAREDREAD;
 
 
 class DaDeviceItem  {
+   friend class DaDeviceReadCoalescer;
 public:
       //--------------------------------------------------------------
       // constructor
@@ -106,10 +135,15 @@ public:
    virtual HRESULT get_EUData( OPCEUTYPE *pEUType, VARIANT *pEUInfo );
    virtual HRESULT set_EUData( OPCEUTYPE EUType, VARIANT *pEUInfo );
    virtual HRESULT get_AnalogEURange( double* pdAnalogEURange );
+   void            get_DeadbandEUInfo( OPCEUTYPE* pEUType, double* pdAnalogEURange );
+                   // Returns a new version whenever the EU data or the item deadband changes
+   LONGLONG        get_DeadbandVersion( void ) { return DaReadChangeVersion( &m_llDeadbandVersion ); }
    virtual HRESULT get_OPCITEMRESULT( BOOL blobUpdate, OPCITEMRESULT* pItemResult );
 
       //--------------------------------------------------------------
       // Write current value, quality and time stamp
+      // set_ItemValue() returns OPC_E_BADTYPE if the value has not the
+      // canonical data type, like SetItemValues() does per item.
       //--------------------------------------------------------------
    virtual HRESULT set_ItemValue(   LPVARIANT pvValue,
                                     WORD wQuality = OPC_QUALITY_GOOD | OPC_LIMIT_OK,
@@ -157,6 +191,91 @@ public:
    virtual HRESULT GetItemDeadband( FLOAT* pfltPercentDeadband );
    virtual HRESULT ClearItemDeadband();
 
+      //--------------------------------------------------------------
+      // Change Tracking
+      //    Every modification of the cache (value, quality,
+      //    time stamp) or of attributes used by the change detection
+      //    (EU info, deadband) increments the change version and
+      //    marks all active Generic Items subscribed to this Device
+      //    Item as dirty. The update threads only handle dirty items.
+      //
+      //    A Generic Item is subscribed as long as it exists and is
+      //    active if the item and its group are active (the same
+      //    condition as for the Active Count). Inactive subscribers
+      //    are marked dirty when they are activated.
+      //--------------------------------------------------------------
+   LONG            get_ChangeVersion( void ) const { return m_lChangeVersion; }
+   HRESULT         AddChangeSubscriber( DaGenericItem* pGItem );
+   HRESULT         RemoveChangeSubscriber( DaGenericItem* pGItem );
+   void            SetChangeSubscriberActive( DaGenericItem* pGItem, BOOL fActive );
+
+                  // Returns the number of subscribed Generic Items and
+                  // the number of active ones (diagnostics).
+   void            get_ChangeSubscriberCount( DWORD* pdwCount, DWORD* pdwActiveCount );
+
+      //--------------------------------------------------------------
+      // Shared Subscriptions
+      //    If more than one active Generic Item is subscribed, the
+      //    groups with the same requested data type, update rate and
+      //    percent deadband share the evaluation of an update: the
+      //    value is read and converted once per change of the item
+      //    and compared once with the last value sent of the shared
+      //    subscription. If the value has changed a new token is
+      //    assigned to the last value sent.
+      //
+      //    A Generic Item whose last read value is the last value
+      //    sent with llPrevToken has changed if llToken differs; if
+      //    its last read value is the one sent with llToken it has
+      //    not changed. Otherwise the item must be compared with
+      //    DaGenericItem::CompareLastRead().
+      //
+      //    Returns S_FALSE if the value is not shared; the caller must
+      //    read it with get_ItemValue(). Must be called within
+      //    DaBaseServer::readWriteLock_ (reading).
+      //--------------------------------------------------------------
+   HRESULT         ReadShared( VARTYPE vtRequested, DWORD dwUpdateRate, float fltGroupDeadband,
+                               OPCITEMSTATE* pItemState, DASHAREDREAD* pShared );
+
+      //--------------------------------------------------------------
+      // Returns the memory used by all Device Items: the items, the
+      // Item IDs and Access Paths, the EU infos and the value store.
+      //--------------------------------------------------------------
+   static void     GetMemoryStatistics( DADEVICEITEMMEMSTATS* pStats );
+
+      //--------------------------------------------------------------
+      // Reads the cache of several items like get_ItemValue(). The
+      // scalar values of all items are read in one pass over the
+      // value store; the other values are read item by item.
+      // pItemStates[i].vDataValue.vt contains the requested data
+      // type on input. ppDItems may contain NULL values; these items
+      // and items with failed pErrors[i] are skipped.
+      // The scalar values of items with m_fDirectValueAccess set are
+      // read from the store; get_ItemValue() is called for the others.
+      // Returns S_OK if succeeded for all items; otherwise S_FALSE.
+      //--------------------------------------------------------------
+   static HRESULT  ReadItemValues( DWORD dwCount, DaDeviceItem** ppDItems,
+                                   OPCITEMSTATE* pItemStates, HRESULT* pErrors );
+
+      //--------------------------------------------------------------
+      // Updates the cache of several items like set_ItemValue() and
+      // set_ItemQuality(). The data types of all values are checked
+      // first, then the valid items are updated.
+      // Only quality and time stamp are updated for items whose value
+      // is VT_EMPTY or VT_NULL and for all items if pvValues is NULL.
+      // If pftTimeStamps is NULL the current time is used for all
+      // items. pErrors[i] is OPC_E_INVALIDHANDLE for NULL items and
+      // OPC_E_BADTYPE if the value has not the canonical data type.
+      // Items without m_fDirectValueAccess are updated by the virtual
+      // set_ItemValue() and set_ItemQuality(). The other items are
+      // updated in blocks; each value lock is entered once
+      // per block and the changed Generic Items are queued with one
+      // call per group.
+      // Returns S_OK if succeeded for all items; otherwise S_FALSE.
+      //--------------------------------------------------------------
+   static HRESULT  SetItemValues( DWORD dwCount, DaDeviceItem** ppDItems, const VARIANT* pvValues,
+                                  const WORD* pwQualities, const FILETIME* pftTimeStamps,
+                                  HRESULT* pErrors );
+
 public:
       //--------------------------------------------------------------
       // to protect members of this class from multi thread access
@@ -174,17 +293,31 @@ public:
       //    ICallrItemConfig::GetCallrItemDefs     (Call-R)
       //    ICallrItemConfig::ChangeCallrItemDefs  (Call-R)
       //
+      // The critical section is shared by several items (striped)
+      // so that the items do not need a second critical section.
+      // Must not be entered for more than one item at a time.
       //--------------------------------------------------------------
-   CRITICAL_SECTION  m_CritSecAllAttrs;
+   LPCRITICAL_SECTION get_AllAttrsCritSec( void );
 
 protected:
+      //--------------------------------------------------------------
+      // Serializes the writers of the cache of this item and protects
+      // the values in the side table of the value store and the list
+      // of change subscribers. Striped like get_AllAttrsCritSec() but
+      // entered within m_CritSec, never the other way round. Only
+      // SetItemValues() owns several of them, in ascending order.
+      //--------------------------------------------------------------
+   LPCRITICAL_SECTION get_ValueCritSec( void );
+
                // zero terminated string that uniquely
                // identifies the item (UNICODE!) 
+               // Allocated from the string arena of the items.
    LPWSTR      m_ItemID;
 
                // recommandation to the server on 'how to get the data' 
                //    ex. through which COM port 
-   LPWSTR      m_AccessPath;
+               // Interned by the string arena of the items, not freed.
+   LPCWSTR     m_AccessPath;
 
                // tells whether the cache for this item should be refreshed.
                // Group specific handling is controlled by the Active Flag
@@ -205,9 +338,19 @@ protected:
    DWORD       m_AccessRights; 
 
                // Item Value Cache
-   VARIANT     m_Value ;                  // data type and current value
-   WORD        m_Quality ;                // OPC quality flag
-   FILETIME    m_TimeStamp ;              // time when the item cache was written
+               // Value, quality and time stamp are stored in the value
+               // store of all items (see DaValueStore) at this ordinal.
+               // Written within get_ValueCritSec(); scalar values, qualities
+               // and time stamps are read without lock.
+   DWORD       m_dwOrdinal;
+
+               // May be set to TRUE by the constructor of derived classes
+               // which do not override get_ItemValue(), set_ItemValue()
+               // or set_ItemQuality(). ReadItemValues() and SetItemValues()
+               // then access the value store directly instead of calling
+               // these functions item by item (see there). FALSE by default
+               // so that existing overrides are always called.
+   BOOL        m_fDirectValueAccess;
 
                // the blob is a (zero terminated?) string 
                //    provided by the client or by the server 
@@ -219,15 +362,81 @@ protected:
    BYTE      * m_pBlob;
 
                // EUInfo (optional)
+               // Only allocated if the EU type is not OPC_NOENUM.
    OPCEUTYPE   m_EUType;
-   VARIANT     m_EUInfo;
-               // Contains the range of the EU Info if EU Type is Analog. For this reason
-               // the range must not be calcuated at every update cycle.
+   VARIANT*    m_pEUInfo;
+               // Contains the range of the EU Info if EU Type is Analog, otherwise 0.
+               // For this reason the range must not be calcuated at every update cycle.
+               // m_EUType and m_dAnalogEURange are updated together by set_EUData()
+               // and used by the deadband handling without copying m_pEUInfo.
    double      m_dAnalogEURange;
 
                // The PercentDeadband value of this item
    FLOAT       m_fltPercentDeadband;
 
+               // Version of the EU data and the PercentDeadband (see DaNewChangeVersion()).
+               // Renewed within m_CritSec after the values used by the deadband
+               // handling are modified.
+   volatile LONGLONG m_llDeadbandVersion;
+
+               // Must be called within m_CritSec or get_ValueCritSec() after
+               // the cache or an attribute used by the change detection was
+               // modified.
+   void        NotifyChange( void );
+
+               // Incremented with every change of the item
+   volatile LONG                    m_lChangeVersion;
+
+               // Generic Items to be marked dirty if the item changes.
+               // The first m_nActiveChangeSubscribers entries are the
+               // active items. Each item knows its position in the list
+               // (DaGenericItem::m_iSubscriberIndex) so that it can be
+               // removed or moved without a search.
+               // Modified within m_CritSec and get_ValueCritSec(), read
+               // within one of them.
+   CSimpleArray<DaGenericItem*>     m_arChangeSubscribers;
+   int                              m_nActiveChangeSubscribers;
+
+               // Exchanges two entries of m_arChangeSubscribers.
+               // Must be called within m_CritSec and get_ValueCritSec().
+   void        SwapChangeSubscribers( int i, int j );
+
+               // Shared subscriptions, see ReadShared().
+               // Protected by m_CritSec.
+   typedef struct tagSHAREDSUBSCRIPTION {
+      VARTYPE     vtRequested;            // key: requested data type
+      DWORD       dwUpdateRate;           // key: revised update rate of the groups
+      float       fltDeadband;            // key: percent deadband of the groups
+      LONG        lChangeVersion;         // change version of the evaluated value
+      BOOL        fEvaluated;
+      HRESULT     hrRead;                 // result of get_ItemValue()
+      VARIANT     vValue;                 // converted value, quality and time stamp
+      WORD        wQuality;
+      FILETIME    ftTimeStamp;
+      VARIANT     vLastSent;              // last value and quality sent
+      WORD        wLastSentQuality;
+      LONGLONG    llToken;                // token of vLastSent, 0 if none
+      LONGLONG    llPrevToken;            // token before the last evaluation
+      ULONGLONG   ullLastUsed;            // GetTickCount64() of the last use
+      struct tagSHAREDSUBSCRIPTION* pNext;
+   } SHAREDSUBSCRIPTION;
+
+   SHAREDSUBSCRIPTION*              m_pSharedSubscriptions;
+   DWORD                            m_dwSharedSubscriptions;
+
+               // Pending device read of the item and the index of the item
+               // in the read (see DaDeviceReadCoalescer), NULL if none.
+               // Protected by the critical section of the coalescer.
+   void*                            m_pPendingRead;
+   DWORD                            m_dwPendingReadIndex;
+
+               // Releases all shared subscriptions.
+               // Must be called within m_CritSec.
+   void        FreeSharedSubscriptions( void );
+               // Reads, converts and compares the value of a shared subscription.
+               // Must be called within m_CritSec.
+   void        EvaluateSharedSubscription( SHAREDSUBSCRIPTION* pSub );
+
       //--------------------------------------------------------------
       // Active Count Handling.
       //    Counts how many GenericItems with active state of an
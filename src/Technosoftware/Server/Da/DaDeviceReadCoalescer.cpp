@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include "DaBaseServer.h"
+#include "DaDeviceReadCoalescer.h"
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaDeviceReadCoalescer::DaDeviceReadCoalescer()
+{
+    m_pCollecting = nullptr;
+    m_dwWindow = 0;
+    m_ullRequestedItems = 0;
+    m_ullDeviceReads = 0;
+    m_ullReadItems = 0;
+    m_ullJoinedItems = 0;
+
+    InitializeCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+DaDeviceReadCoalescer::~DaDeviceReadCoalescer()
+{
+    _ASSERTE(m_pCollecting == nullptr);          // No request may be pending
+    DeleteCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// SetWindow
+// ---------
+//=========================================================================
+void DaDeviceReadCoalescer::SetWindow(DWORD dwWindow)
+{
+    EnterCriticalSection(&m_CritSec);
+    m_dwWindow = min(dwWindow, DA_DEVICEREAD_MAX_WINDOW);
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=================================================================================
+// Refresh the Cache of the specified Items
+// ----------------------------------------
+//=================================================================================
+HRESULT DaDeviceReadCoalescer::Refresh(
+    DaBaseServer*   pServerHandler,
+    DWORD           dwNumItems,
+    DaDeviceItem**  ppDItems,
+    HRESULT*        pErrors)
+{
+    BATCH**     ppBatches;                      // batch of each item
+    DWORD*      pdwIndex;                       // index of each item in its batch
+    BATCH*      pOwnBatch = nullptr;            // batch opened by this request
+    BATCH*      pBatch;
+    DWORD       dwWindow;
+    HRESULT     hrRet = S_OK;
+    HRESULT     hres;
+    DWORD       i;
+
+    ppBatches = new BATCH*[dwNumItems];
+    pdwIndex = new DWORD[dwNumItems];
+    if (ppBatches == nullptr || pdwIndex == nullptr) {
+        if (ppBatches) {
+            delete[] ppBatches;
+        }
+        if (pdwIndex) {
+            delete[] pdwIndex;
+        }
+        // read without coalescing
+        return pServerHandler->OnRefreshInputCache(OPC_REFRESH_CLIENT, dwNumItems, ppDItems, pErrors);
+    }
+
+    //
+    // Join the pending reads and collect the other items in the open batch
+    //
+    EnterCriticalSection(&m_CritSec);
+    dwWindow = m_dwWindow;
+    for (i = 0; i < dwNumItems; i++) {
+
+        ppBatches[i] = nullptr;
+        DaDeviceItem* pDItem = ppDItems[i];
+        if (pDItem == nullptr) {
+            continue;
+        }
+        m_ullRequestedItems++;
+
+        pBatch = static_cast<BATCH*>(pDItem->m_pPendingRead);
+        if (pBatch) {                           // Item is already being read
+            pdwIndex[i] = pDItem->m_dwPendingReadIndex;
+        }
+        else {
+            if (m_pCollecting == nullptr) {     // Open a new batch
+                m_pCollecting = NewBatch();
+                pOwnBatch = m_pCollecting;
+            }
+            pBatch = m_pCollecting;
+            hres = pBatch ? AddItem(pBatch, pDItem, &pdwIndex[i]) : E_OUTOFMEMORY;
+            if (FAILED(hres)) {
+                pErrors[i] = hres;
+                hrRet = S_FALSE;
+                continue;
+            }
+        }
+        if (pBatch != pOwnBatch) {
+            m_ullJoinedItems++;
+        }
+        pBatch->lRefs++;
+        ppBatches[i] = pBatch;
+    }
+    LeaveCriticalSection(&m_CritSec);
+
+    //
+    // Read the items of the own batch
+    //
+    if (pOwnBatch) {
+        if (dwWindow) {
+            Sleep(dwWindow);                    // Give other requests a chance to add their items
+        }
+        EnterCriticalSection(&m_CritSec);
+        if (m_pCollecting == pOwnBatch) {       // Close the batch
+            m_pCollecting = nullptr;
+        }
+        m_ullDeviceReads++;
+        m_ullReadItems += pOwnBatch->dwCount;
+        LeaveCriticalSection(&m_CritSec);
+
+        ReadBatch(pServerHandler, pOwnBatch);
+    }
+
+    //
+    // Wait for the reads of the other requests and get the results
+    //
+    for (i = 0; i < dwNumItems; i++) {
+        pBatch = ppBatches[i];
+        if (pBatch) {
+            if (pBatch != pOwnBatch) {
+                WaitForSingleObject(pBatch->hDone, INFINITE);
+            }
+            hres = pBatch->pErrors[pdwIndex[i]];
+            if (FAILED(hres)) {
+                pErrors[i] = hres;
+                hrRet = S_FALSE;
+            }
+        }
+    }
+
+    EnterCriticalSection(&m_CritSec);
+    for (i = 0; i < dwNumItems; i++) {
+        if (ppBatches[i]) {
+            ReleaseBatch(ppBatches[i]);
+        }
+    }
+    if (pOwnBatch) {
+        ReleaseBatch(pOwnBatch);
+    }
+    LeaveCriticalSection(&m_CritSec);
+
+    delete[] ppBatches;
+    delete[] pdwIndex;
+    return hrRet;
+}
+
+
+//=================================================================================
+// GetStatistics
+// -------------
+//=================================================================================
+void DaDeviceReadCoalescer::GetStatistics(DADEVICEREADSTATS* pStats)
+{
+    EnterCriticalSection(&m_CritSec);
+    pStats->dwWindow = m_dwWindow;
+    pStats->ullRequestedItems = m_ullRequestedItems;
+    pStats->ullDeviceReads = m_ullDeviceReads;
+    pStats->ullReadItems = m_ullReadItems;
+    pStats->ullJoinedItems = m_ullJoinedItems;
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=================================================================================
+// Create a Batch
+// --------------
+// The batch is referenced by the creating request.
+//=================================================================================
+DaDeviceReadCoalescer::BATCH* DaDeviceReadCoalescer::NewBatch(void)
+{
+    BATCH* pBatch = new BATCH;
+    if (pBatch == nullptr) {
+        return nullptr;
+    }
+    pBatch->lRefs = 1;
+    pBatch->dwCount = 0;
+    pBatch->dwAlloc = 0;
+    pBatch->ppItems = nullptr;
+    pBatch->pErrors = nullptr;
+    pBatch->hDone = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (pBatch->hDone == nullptr) {
+        delete pBatch;
+        return nullptr;
+    }
+    return pBatch;
+}
+
+
+//=================================================================================
+// Add an Item to a Batch
+// ----------------------
+// Must be called within m_CritSec.
+//=================================================================================
+HRESULT DaDeviceReadCoalescer::AddItem(BATCH* pBatch, DaDeviceItem* pDItem, DWORD* pdwIndex)
+{
+    if (pBatch->dwCount == pBatch->dwAlloc) {
+        DWORD dwNewAlloc = pBatch->dwAlloc ? pBatch->dwAlloc * 2 : 32;
+        DaDeviceItem** ppNewItems = new DaDeviceItem*[dwNewAlloc];
+        HRESULT* pNewErrors = new HRESULT[dwNewAlloc];
+        if (ppNewItems == nullptr || pNewErrors == nullptr) {
+            if (ppNewItems) {
+                delete[] ppNewItems;
+            }
+            if (pNewErrors) {
+                delete[] pNewErrors;
+            }
+            return E_OUTOFMEMORY;
+        }
+        if (pBatch->dwCount) {
+            memcpy(ppNewItems, pBatch->ppItems, pBatch->dwCount * sizeof(DaDeviceItem*));
+            memcpy(pNewErrors, pBatch->pErrors, pBatch->dwCount * sizeof(HRESULT));
+        }
+        if (pBatch->ppItems) {
+            delete[] pBatch->ppItems;
+        }
+        if (pBatch->pErrors) {
+            delete[] pBatch->pErrors;
+        }
+        pBatch->ppItems = ppNewItems;
+        pBatch->pErrors = pNewErrors;
+        pBatch->dwAlloc = dwNewAlloc;
+    }
+
+    *pdwIndex = pBatch->dwCount;
+    pBatch->ppItems[pBatch->dwCount] = pDItem;
+    pBatch->pErrors[pBatch->dwCount] = S_OK;
+    pBatch->dwCount++;
+
+    pDItem->m_pPendingRead = pBatch;
+    pDItem->m_dwPendingReadIndex = *pdwIndex;
+    return S_OK;
+}
+
+
+//=================================================================================
+// Read the Items of a closed Batch
+// --------------------------------
+// The arrays of a closed batch are no longer modified by other requests.
+//=================================================================================
+void DaDeviceReadCoalescer::ReadBatch(DaBaseServer* pServerHandler, BATCH* pBatch)
+{
+    DWORD i;
+
+    if (pBatch->dwCount) {
+        HRESULT hrRefresh = pServerHandler->OnRefreshInputCache(
+            OPC_REFRESH_CLIENT,
+            pBatch->dwCount,
+            pBatch->ppItems,
+            pBatch->pErrors);
+
+        _ASSERTE(SUCCEEDED(hrRefresh));         // Must return S_OK or S_FALSE
+    }
+
+    // New requests read the items again
+    EnterCriticalSection(&m_CritSec);
+    for (i = 0; i < pBatch->dwCount; i++) {
+        pBatch->ppItems[i]->m_pPendingRead = nullptr;
+    }
+    LeaveCriticalSection(&m_CritSec);
+
+    SetEvent(pBatch->hDone);                    // Results are available
+}
+
+
+//=================================================================================
+// Release a Batch
+// ---------------
+// Must be called within m_CritSec.
+//=================================================================================
+void DaDeviceReadCoalescer::ReleaseBatch(BATCH* pBatch)
+{
+    if (--pBatch->lRefs == 0) {
+        CloseHandle(pBatch->hDone);
+        if (pBatch->ppItems) {
+            delete[] pBatch->ppItems;
+        }
+        if (pBatch->pErrors) {
+            delete[] pBatch->pErrors;
+        }
+        delete pBatch;
+    }
+}
+//DOM-IGNORE-END
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __DEVICEREADCOALESCER_H_
+#define __DEVICEREADCOALESCER_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+               // Maximum coalescing window in ms
+#define  DA_DEVICEREAD_MAX_WINDOW   1000
+
+class DaBaseServer;
+class DaDeviceItem;
+
+
+               // Counters of the device reads of a server class handler
+typedef struct tagDADEVICEREADSTATS {
+   DWORD       dwWindow;               // coalescing window in ms
+   ULONGLONG   ullRequestedItems;      // items requested to be read from the device
+   ULONGLONG   ullDeviceReads;         // OnRefreshInputCache() calls
+   ULONGLONG   ullReadItems;           // items passed to OnRefreshInputCache()
+   ULONGLONG   ullJoinedItems;         // items served by a read of another request
+} DADEVICEREADSTATS;
+
+
+/////////////////////////////////////////////////////////////////
+// Device Read Coalescer
+// ---------------------
+// Merges the device reads (OPC_REFRESH_CLIENT) of concurrent
+// requests so that the cache of an item is refreshed only once.
+//
+// An item which is already being read is not read again; the
+// request waits for the pending read and uses its result. The
+// other items are collected in a batch. The request which opens
+// the batch waits for the coalescing window, then reads all items
+// collected by the requests arriving in the meantime with a single
+// OnRefreshInputCache() call.
+//
+// Each pending item refers to its batch (DaDeviceItem::
+// m_pPendingRead). Items are not attached by the batch; each item
+// is referenced by a request waiting for the batch.
+/////////////////////////////////////////////////////////////////
+class DaDeviceReadCoalescer {
+
+   public:
+      DaDeviceReadCoalescer();
+      ~DaDeviceReadCoalescer();
+
+         ///////////////////////////////////////////////////////////////
+         //  Sets the time in ms a read waits for other requests to be
+         //  merged. 0 merges only requests for items which are
+         //  already being read. The request which opens a batch
+         //  sleeps for the window on the thread of the client.
+         ///////////////////////////////////////////////////////////////
+      void SetWindow( DWORD dwWindow );
+      DWORD GetWindow( void ) { return m_dwWindow; }
+
+         ///////////////////////////////////////////////////////////////
+         //  Refreshes the cache of the specified items. Has the same
+         //  parameters and results as DaBaseServer::OnRefreshInputCache()
+         //  with reason OPC_REFRESH_CLIENT. ppDItems may contain NULL
+         //  values; pErrors[] is only set for failed items.
+         //  Returns S_OK or S_FALSE.
+         ///////////////////////////////////////////////////////////////
+      HRESULT Refresh( DaBaseServer* pServerHandler, DWORD dwNumItems,
+                       DaDeviceItem** ppDItems, HRESULT* pErrors );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the counters of the device reads.
+         ///////////////////////////////////////////////////////////////
+      void GetStatistics( DADEVICEREADSTATS* pStats );
+
+   private:
+               // Items read with a single OnRefreshInputCache() call
+      typedef struct tagBATCH {
+         long           lRefs;            // references of the requests using the batch
+         HANDLE         hDone;            // signaled after the read
+         DWORD          dwCount;          // number of items
+         DWORD          dwAlloc;          // allocated entries of the arrays below
+         DaDeviceItem   **ppItems;
+         HRESULT        *pErrors;
+      } BATCH;
+
+      BATCH          *m_pCollecting;      // open batch, NULL if none
+      DWORD          m_dwWindow;
+
+      ULONGLONG      m_ullRequestedItems;
+      ULONGLONG      m_ullDeviceReads;
+      ULONGLONG      m_ullReadItems;
+      ULONGLONG      m_ullJoinedItems;
+
+               // protects all members, the open batch and
+               // DaDeviceItem::m_pPendingRead. No other critical
+               // section is entered while owning this critical section.
+      CRITICAL_SECTION m_CritSec;
+
+      BATCH* NewBatch( void );
+      HRESULT AddItem( BATCH* pBatch, DaDeviceItem* pDItem, DWORD* pdwIndex );
+      void ReadBatch( DaBaseServer* pServerHandler, BATCH* pBatch );
+      static void ReleaseBatch( BATCH* pBatch );
+};
+//DOM-IGNORE-END
+
+
+#endif // __DEVICEREADCOALESCER_H_
@@ -59,7 +59,25 @@ DaGenericGroup::DaGenericGroup( void )
 	m_StreamWrite     = 0;
 
 	m_dwKeepAliveTime = 0;
-	m_dwKeepAliveCount= 0;
+	m_ullLastUpdateTick = 0;
+	m_dwEffectiveUpdateRate = 0;
+	m_dwUpdateLag = 0;
+	m_ullNextUpdateDue = 0;
+	m_lPendingTimers = 0;
+
+	m_phDirtyItems    = NULL;
+	m_dwNumDirtyItems = 0;
+	m_dwMaxDirtyItems = 0;
+
+	m_phUpdateItems       = NULL;
+	m_dwMaxUpdateItems    = 0;
+	m_ppUpdateGItems      = NULL;
+	m_ppUpdateDItems      = NULL;
+	m_pUpdateErrors       = NULL;
+	m_pUpdateItemStates   = NULL;
+	m_ppUpdateReadDItems  = NULL;
+	m_pUpdateShared       = NULL;
+	m_dwUpdateScratchSize = 0;
 
 	// for access to members of this group (mostly m_RefCount and m_ToKill)
 	InitializeCriticalSection( &m_CritSec );
@@ -77,6 +95,9 @@ DaGenericGroup::DaGenericGroup( void )
 
 	//
 	InitializeCriticalSection( &m_UpdateRateCritSec );
+
+	// for access to the list of changed items
+	InitializeCriticalSection( &m_DirtyItemsCritSec );
 }
 
 //=====================================================================================
@@ -140,7 +161,6 @@ HRESULT DaGenericGroup::Create( DaGenericServer *pServer,
 
 	// initialized tick information for client update
 	m_Ticks = 1;
-	m_TickCount = 1;
 
 	m_Name = WSTRClone( Name, NULL);
 	if ( m_Name == NULL ) {
@@ -302,6 +322,10 @@ HRESULT DaGenericGroup::Create( DaGenericServer *pServer,
 	EnterCriticalSection( &(m_pServer->m_GroupsCritSec) );
 
 	m_hServerGroupHandle = m_pServer->m_GroupList.New();
+	if (m_hServerGroupHandle == -1) {         // maximum number of groups reached
+		res = E_OUTOFMEMORY;
+		goto CreateExit1;
+	}
 
 	// insert in the server GroupList
 	res = m_pServer->m_GroupList.PutElem( m_hServerGroupHandle , this);
@@ -424,7 +448,6 @@ HRESULT DaGenericGroup::Create(
 
 	// initialized tick information for client update
 	m_Ticks = 1;
-	m_TickCount = 1;
 
 	// Clone to private!
 	m_bPublicGroup = FALSE;
@@ -489,6 +512,10 @@ HRESULT DaGenericGroup::Create(
 	EnterCriticalSection( &(m_pServer->m_GroupsCritSec) );
 
 	m_hServerGroupHandle = m_pServer->m_GroupList.New();
+	if (m_hServerGroupHandle == -1) {         // maximum number of groups reached
+		res = E_OUTOFMEMORY;
+		goto CreateCloneExit2;
+	}
 
 	// insert in the GroupList
 	res = m_pServer->m_GroupList.PutElem( m_hServerGroupHandle, this );
@@ -569,6 +596,8 @@ DaGenericGroup::~DaGenericGroup()
 		// delete from server list
 		EnterCriticalSection( &m_pServer->m_GroupsCritSec );
 		m_pServer->m_GroupList.PutElem( m_hServerGroupHandle, NULL );
+		m_pServer->m_Scheduler.CancelTimers( m_hServerGroupHandle );
+		m_pServer->m_CallbackQueue.RemoveGroup( m_hServerGroupHandle );
 		LeaveCriticalSection( &m_pServer->m_GroupsCritSec );
 
 		m_pServer->Detach();
@@ -585,6 +614,33 @@ DaGenericGroup::~DaGenericGroup()
 	DeleteCriticalSection( &m_AsyncThreadsCritSec );
 	DeleteCriticalSection( &m_CallbackCritSec );
 	DeleteCriticalSection( &m_UpdateRateCritSec );
+
+	if (m_phDirtyItems) {
+		delete [] m_phDirtyItems;
+	}
+	DeleteCriticalSection( &m_DirtyItemsCritSec );
+
+	if (m_phUpdateItems) {
+		delete [] m_phUpdateItems;
+	}
+	if (m_ppUpdateGItems) {
+		delete [] m_ppUpdateGItems;
+	}
+	if (m_ppUpdateDItems) {
+		delete [] m_ppUpdateDItems;
+	}
+	if (m_pUpdateErrors) {
+		delete [] m_pUpdateErrors;
+	}
+	if (m_pUpdateItemStates) {
+		delete [] m_pUpdateItemStates;
+	}
+	if (m_ppUpdateReadDItems) {
+		delete [] m_ppUpdateReadDItems;
+	}
+	if (m_pUpdateShared) {
+		delete [] m_pUpdateShared;
+	}
 }
 
 
@@ -852,7 +908,7 @@ HRESULT DaGenericGroup::GetCOMItem(
 	}
 
 	// Insert the COM Object in the groups list
-	hres = m_oaCOMItems.PutElem( hServerHandle, *COMItem );
+	hres = m_oaCOMItems.PutElemAt( hServerHandle, *COMItem );
 	if ( FAILED( hres ) ) {
 		goto GetCOMItemBadExit1;
 	}
@@ -897,52 +953,23 @@ HRESULT DaGenericGroup::InternalRead(
 									HRESULT        *  errors,
 									BOOL           *  pfPhyval /* = NULL */ )
 {
-	DWORD       i;
-	VARIANT     *pvValue;
-	DaDeviceItem *pDItem;
 	HRESULT     hresReturn, hres;
 
 	hresReturn = S_OK;
 
 	if (dwSource == OPC_DS_DEVICE) {             // Refresh the chache for the requested items
-		hresReturn = m_pServerHandler->OnRefreshInputCache( OPC_REFRESH_CLIENT, numItems, ppItems, errors );
+		hresReturn = m_pServerHandler->RefreshInputCacheCoalesced( numItems, ppItems, errors );
 		_ASSERTE( SUCCEEDED( hresReturn ) );      // Must return S_OK or S_FALSE
 	}
 	// handle read/write locking
 	// Note : get_ItemValue() reads from cache.
 	m_pServerHandler->readWriteLock_.BeginReading();
 
-	for (i=0 ; i<numItems; i++) {
-
-		pDItem = ppItems[i];
-
-		if (pDItem == NULL) {                     // No refresh requested for this item
-			continue;
-		}
-		if (FAILED( errors[i] )) {
-			continue;                              // Cache refresh from device for this item failed
-		}
-
-		pvValue = &pItemValues[i].vDataValue;
-		// Use the canonical data type if requested data
-		// type is VT_EMPTY.
-		if (V_VT( pvValue ) == VT_EMPTY) {
-			V_VT( pvValue ) = pDItem->get_CanonicalDataType();
-		}
-
-		// Read from cache
-		hres = pDItem->get_ItemValue(
-			pvValue,                      // Value
-			&pItemValues[i].wQuality,     // Quality
-			&pItemValues[i].ftTimeStamp );// Timestamp
-
-		pItemValues[i].wReserved = 0;             // initialize reserve field, Version 1.3
-
-		if (FAILED( hres )) {
-			errors[i] = hres;
-			VariantClear( pvValue );
-			hresReturn = S_FALSE;
-		}
+	// Read from cache. The scalar values of all items are read
+	// in one pass over the value store.
+	hres = DaDeviceItem::ReadItemValues( numItems, ppItems, pItemValues, errors );
+	if (hres == S_FALSE) {
+		hresReturn = S_FALSE;
 	}
 	// handle read/write locking
 	m_pServerHandler->readWriteLock_.EndReading();
@@ -1049,7 +1076,6 @@ HRESULT DaGenericGroup::SetActiveState( BOOL NewState )
 				if (NewState) {                     // Group state changed to active state.
 					pGItem->AttachActiveCountOfDeviceItem();
 					pGItem->ResetLastRead();         // Force a subscription callback
-					m_TickCount = 1;                 // by next cycle.
 				}
 				else {
 					pGItem->DetachActiveCountOfDeviceItem();
@@ -1058,6 +1084,15 @@ HRESULT DaGenericGroup::SetActiveState( BOOL NewState )
 		}
 		hres = m_oaItems.Next( idx, &idx );
 	}
+
+	if (NewState) {                              // Update by next cycle
+		m_ullNextUpdateDue = 0;                   // no lag while inactive
+		m_pServer->m_Scheduler.SetTimer( m_hServerGroupHandle, DA_TIMER_UPDATE,
+		                                 m_pServer->m_Scheduler.GetCurrentTick() + 1 );
+	}
+	else {                                       // Inactive groups are not updated
+		m_pServer->m_Scheduler.CancelTimers( m_hServerGroupHandle );
+	}
 	LeaveCriticalSection( &m_UpdateRateCritSec );
 	LeaveCriticalSection( &m_ItemsCritSec );
 	LeaveCriticalSection( &m_CritSec );
@@ -1103,8 +1138,9 @@ BOOL DaGenericGroup::GetPublicInfo( long *pPGHandle )
 // This function modifies the following data members:
 //    m_RequestedUpdateRate:  The requested Update Rate
 //    updateRate_:    The revised Update Rate
-//    m_TickCount:            Number of required update cycles until next update
 //    m_Ticks:                Number of required update cycles between two updates
+//
+// The update timer of the group is moved accordingly.
 //=====================================================================================
 HRESULT DaGenericGroup::ReviseUpdateRate(
 										long RequestedUpdateRate
@@ -1129,17 +1165,22 @@ HRESULT DaGenericGroup::ReviseUpdateRate(
 
 		if (dwNewTicks == m_Ticks) throw S_OK;
 
-		DWORD dwTicksSinceLastUpdate = m_Ticks - m_TickCount;
+		ULONGLONG ullTick = m_pServer->m_Scheduler.GetCurrentTick();
+		ULONGLONG ullDueTick;
 
-		if (dwNewTicks <= dwTicksSinceLastUpdate) {
-			m_TickCount = 1;                    // Force an update by next cycle
+		if (dwNewTicks <= ullTick - m_ullLastUpdateTick) {
+			ullDueTick = ullTick + 1;           // Force an update by next cycle
 		}
 		else {
-			m_TickCount = dwNewTicks - dwTicksSinceLastUpdate;
+			ullDueTick = m_ullLastUpdateTick + dwNewTicks;
 		}
 
 		m_Ticks = dwNewTicks;
 
+		if (GetActiveState()) {
+			m_pServer->m_Scheduler.SetTimer( m_hServerGroupHandle, DA_TIMER_UPDATE, ullDueTick );
+		}
+
 	}
 	catch (HRESULT hrEx) { hr = hrEx; }
 	catch (...) { hr = E_FAIL; }
@@ -1218,7 +1259,7 @@ HRESULT DaGenericGroup::SetKeepAlive(
 		m_dwKeepAliveTime = 0;                    // Inactivate keep-alive callbacks
 	}
 	*pdwRevisedKeepAliveTime = m_dwKeepAliveTime;
-	m_dwKeepAliveCount = m_dwKeepAliveTime / GetActualBaseUpdateRate();
+	ResetKeepAliveCounter();
 
 	m_csKeepAlive.Unlock();
 	if (FAILED( hr )) return hr;
@@ -1230,11 +1271,24 @@ HRESULT DaGenericGroup::SetKeepAlive(
 
 //=====================================================================================
 // ResetKeepAliveCounter
+// ---------------------
+//    Restarts the keep-alive timer of this group. Called after each
+//    callback to the client.
 //=====================================================================================
 void DaGenericGroup::ResetKeepAliveCounter()
 {
 	m_csKeepAlive.Lock();
-	m_dwKeepAliveCount = m_dwKeepAliveTime / GetActualBaseUpdateRate();
+	if (m_dwKeepAliveTime && GetActiveState()) {
+		DWORD dwTicks = m_dwKeepAliveTime / GetActualBaseUpdateRate();
+		if (dwTicks == 0) {
+			dwTicks = 1;
+		}
+		m_pServer->m_Scheduler.SetTimer( m_hServerGroupHandle, DA_TIMER_KEEPALIVE,
+		                                 m_pServer->m_Scheduler.GetCurrentTick() + dwTicks );
+	}
+	else {
+		m_pServer->m_Scheduler.CancelTimer( m_hServerGroupHandle, DA_TIMER_KEEPALIVE );
+	}
 	m_csKeepAlive.Unlock();
 }
 
@@ -1266,6 +1320,160 @@ void DaGenericGroup::ResetLastReadOfAllGenericItems( void )
 
 
 
+//=====================================================================================
+// Adds the specified item to the list of items which have changed since the last
+// update. Must only be called by DaGenericItem::MarkDirty().
+//=====================================================================================
+HRESULT DaGenericGroup::AddDirtyItem( OPCHANDLE hServerItem )
+{
+	return AddDirtyItems( 1, &hServerItem );
+}
+
+
+
+//=====================================================================================
+// Adds the specified items to the list of items which have changed since the last
+// update. The dirty flags of the items must have been set by DaGenericItem::SetDirty().
+// Either all or none of the items are added.
+//=====================================================================================
+HRESULT DaGenericGroup::AddDirtyItems( DWORD dwCount, const OPCHANDLE* phServerItems )
+{
+	HRESULT hres = S_OK;
+
+	EnterCriticalSection( &m_DirtyItemsCritSec );
+
+	if (m_dwMaxDirtyItems - m_dwNumDirtyItems < dwCount) {
+		DWORD dwNewMax = m_dwMaxDirtyItems ? m_dwMaxDirtyItems * 2 : 16;
+		while (dwNewMax - m_dwNumDirtyItems < dwCount) {
+			dwNewMax *= 2;
+		}
+		OPCHANDLE* phNew = new OPCHANDLE[ dwNewMax ];
+		if (phNew == NULL) {
+			hres = E_OUTOFMEMORY;
+		}
+		else {
+			if (m_phDirtyItems) {
+				memcpy( phNew, m_phDirtyItems, m_dwNumDirtyItems * sizeof (OPCHANDLE) );
+				delete [] m_phDirtyItems;
+			}
+			m_phDirtyItems    = phNew;
+			m_dwMaxDirtyItems = dwNewMax;
+		}
+	}
+	if (SUCCEEDED( hres )) {
+		memcpy( &m_phDirtyItems[ m_dwNumDirtyItems ], phServerItems, dwCount * sizeof (OPCHANDLE) );
+		m_dwNumDirtyItems += dwCount;
+	}
+
+	LeaveCriticalSection( &m_DirtyItemsCritSec );
+	return hres;
+}
+
+
+
+//=====================================================================================
+// Removes all handles from the dirty item list.
+// The dirty item list is swapped with the list of the previous update so that
+// no memory is allocated once both lists are large enough.
+//=====================================================================================
+void DaGenericGroup::TakeDirtyItems( OPCHANDLE** pphServerItems, DWORD* pdwCount )
+{
+	EnterCriticalSection( &m_DirtyItemsCritSec );
+
+	*pdwCount = m_dwNumDirtyItems;
+	if (m_dwNumDirtyItems) {
+		OPCHANDLE*  phPrevItems    = m_phUpdateItems;
+		DWORD       dwMaxPrevItems = m_dwMaxUpdateItems;
+
+		m_phUpdateItems    = m_phDirtyItems;
+		m_dwMaxUpdateItems = m_dwMaxDirtyItems;
+		m_phDirtyItems     = phPrevItems;
+		m_dwMaxDirtyItems  = dwMaxPrevItems;
+		m_dwNumDirtyItems  = 0;
+	}
+	*pphServerItems = m_phUpdateItems;
+
+	LeaveCriticalSection( &m_DirtyItemsCritSec );
+}
+
+
+
+//=====================================================================================
+// Ensures that the scratch arrays of UpdateToClient() can hold at least dwCount
+// entries. The arrays only grow; the content is not preserved.
+//=====================================================================================
+HRESULT DaGenericGroup::ReserveUpdateScratch( DWORD dwCount )
+{
+	if (dwCount <= m_dwUpdateScratchSize) {
+		return S_OK;
+	}
+
+	DWORD dwNewSize = m_dwUpdateScratchSize ? m_dwUpdateScratchSize : 16;
+	while (dwNewSize < dwCount) {
+		dwNewSize *= 2;
+	}
+
+	DaGenericItem** ppGItems    = new DaGenericItem*[ dwNewSize ];
+	DaDeviceItem**  ppDItems    = new DaDeviceItem*[ dwNewSize ];
+	HRESULT*        pErrors     = new HRESULT[ dwNewSize ];
+	OPCITEMSTATE*   pItemStates = new OPCITEMSTATE[ dwNewSize ];
+	DaDeviceItem**  ppReadDItems = new DaDeviceItem*[ dwNewSize ];
+	DASHAREDREAD*   pShared     = new DASHAREDREAD[ dwNewSize ];
+
+	if (!ppGItems || !ppDItems || !pErrors || !pItemStates || !ppReadDItems || !pShared) {
+		delete [] ppGItems;
+		delete [] ppDItems;
+		delete [] pErrors;
+		delete [] pItemStates;
+		delete [] ppReadDItems;
+		delete [] pShared;
+		return E_OUTOFMEMORY;
+	}
+
+	delete [] m_ppUpdateGItems;
+	delete [] m_ppUpdateDItems;
+	delete [] m_pUpdateErrors;
+	delete [] m_pUpdateItemStates;
+	delete [] m_ppUpdateReadDItems;
+	delete [] m_pUpdateShared;
+
+	m_ppUpdateGItems      = ppGItems;
+	m_ppUpdateDItems      = ppDItems;
+	m_pUpdateErrors       = pErrors;
+	m_pUpdateItemStates   = pItemStates;
+	m_ppUpdateReadDItems  = ppReadDItems;
+	m_pUpdateShared       = pShared;
+	m_dwUpdateScratchSize = dwNewSize;
+	return S_OK;
+}
+
+
+
+//=====================================================================================
+// Marks all Generic Items of the Group as dirty. 
+//=====================================================================================
+void DaGenericGroup::MarkAllItemsDirty( void )
+{
+	HRESULT        hres;
+	DaGenericItem*  pGItem;
+	long           i;
+
+	EnterCriticalSection( &m_ItemsCritSec );
+
+	hres = m_oaItems.First( &i );
+	while (SUCCEEDED( hres )) {
+		m_oaItems.GetElem( i, &pGItem ) ;
+		if (pGItem) {
+			pGItem->MarkDirty();
+		}
+		hres = m_oaItems.Next( i, &i );
+	}
+
+	LeaveCriticalSection( &m_ItemsCritSec );
+}
+
+
+
 //=========================================================================
 // GetDItemsAndStates                                             PROTECTED
 // ------------------
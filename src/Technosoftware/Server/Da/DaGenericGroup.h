@@ -183,6 +183,39 @@ public:
                // arrays of COM and generic items!
    CRITICAL_SECTION m_ItemsCritSec;
 
+private:
+               // Server handles of the generic items which have changed
+               // since the last update of the client. The items add
+               // themself if the attached device item changes
+               // (see DaGenericItem::MarkDirty()).
+               // A handle may be stale if the item was removed meanwhile.
+   OPCHANDLE      * m_phDirtyItems;
+   DWORD            m_dwNumDirtyItems;
+   DWORD            m_dwMaxDirtyItems;
+
+               // protects the dirty item list. No other critical section
+               // must be entered while owning this critical section.
+   CRITICAL_SECTION m_DirtyItemsCritSec;
+
+               // Scratch arrays of UpdateToClient(). They are reused
+               // with every update and only grow, so that an update
+               // cycle doesn't allocate memory.
+               // UpdateToClient() is never executed concurrently for the
+               // same group (see DaUpdatePool), no lock is required.
+   OPCHANDLE      * m_phUpdateItems;        // dirty items of the current update,
+   DWORD            m_dwMaxUpdateItems;     // swapped with m_phDirtyItems
+   DaGenericItem ** m_ppUpdateGItems;
+   DaDeviceItem  ** m_ppUpdateDItems;
+   HRESULT        * m_pUpdateErrors;
+   OPCITEMSTATE   * m_pUpdateItemStates;
+   DaDeviceItem  ** m_ppUpdateReadDItems;   // items not read with a shared subscription
+   DASHAREDREAD   * m_pUpdateShared;        // tokens of the shared subscriptions
+   DWORD            m_dwUpdateScratchSize;  // allocated entries of the arrays above
+
+               // Last values sent of the scalar numeric items, used by
+               // UpdateToClient() for the batch change detection.
+   DaChangeColumns  m_ChangeColumns;
+
 private:
 
                // tells whether this is the client view 
@@ -228,20 +261,36 @@ public:
 
                // information used to decide when to send
                // an update to the client depending on the
-               // BaseUpdateRate
-               // protected by m_UpdateRateCritSec !!!???
-   DWORD m_TickCount;
-   DWORD m_Ticks;
-
-               // protects m_ActualBaseUpdateRate, m_Ticks  and  m_TickCount
+               // BaseUpdateRate. The next update is scheduled
+               // as timer in m_pServer->m_Scheduler.
+               // protected by m_UpdateRateCritSec
+   ULONGLONG m_ullLastUpdateTick;      // base update tick of the last update
+   DWORD m_Ticks;                      // base update ticks between two updates
+
+               // the update rate actually applied, m_Ticks stretched
+               // if the server is overloaded (see DaBaseServer::ReportUpdateCycle)
+   DWORD m_dwEffectiveUpdateRate;
+               // how far the last update was behind the revised update rate (in ms)
+   DWORD m_dwUpdateLag;
+   ULONGLONG m_ullNextUpdateDue;       // GetTickCount64() when the next update is due, 0 if unknown
+
+               // protects m_ActualBaseUpdateRate, m_Ticks, m_ullLastUpdateTick
+               // and the update timing above
    CRITICAL_SECTION m_UpdateRateCritSec;
 
                // Keep Alive
+               // The next keep-alive callback is scheduled
+               // as timer in m_pServer->m_Scheduler.
    DWORD m_dwKeepAliveTime;
-   DWORD m_dwKeepAliveCount;
-               // protects m_dwKeepAliveTime and m_dwKeepAliveCount
+               // protects m_dwKeepAliveTime
    CComAutoCriticalSection m_csKeepAlive;
 
+               // Timer kinds which have expired but are not yet handled
+               // (bit 1 << kind) and DA_TIMER_QUEUED while the group is
+               // queued or handled by the update worker pool.
+               // See DaUpdatePool::QueueGroup().
+   volatile LONG m_lPendingTimers;
+
 
                // Array of pointers to the thread handling objects for the group's 
                // async read, write and refresh requests
@@ -504,6 +553,17 @@ public:
 
    void ResetLastReadOfAllGenericItems( void );
 
+      //--------------------------------------------------------------
+      // Dirty item list handling.
+      // AddDirtyItem() is called by DaGenericItem::MarkDirty(),
+      // AddDirtyItems() by DaDeviceItem::SetItemValues().
+      // MarkAllItemsDirty() forces a comparison of all items with
+      // the next update, e.g. if the Percent Deadband was changed.
+      //--------------------------------------------------------------
+   HRESULT AddDirtyItem( OPCHANDLE hServerItem );
+   HRESULT AddDirtyItems( DWORD dwCount, const OPCHANDLE* phServerItems );
+   void    MarkAllItemsDirty( void );
+
       //--------------------------------------------------------------
       // utility method
       //--------------------------------------------------------------
@@ -534,6 +594,18 @@ private:
       //--------------------------------------------------------------
    HRESULT UpdateToClient( BOOL custom, BOOL WithTime, BOOL DataCallbackOnly );
 
+      //--------------------------------------------------------------
+      // Removes all handles from the dirty item list. The returned
+      // array is owned by the group and valid until the next call.
+      //--------------------------------------------------------------
+   void TakeDirtyItems( OPCHANDLE** pphServerItems, DWORD* pdwCount );
+
+      //--------------------------------------------------------------
+      // Ensures that the scratch arrays of UpdateToClient() can hold
+      // at least dwCount entries.
+      //--------------------------------------------------------------
+   HRESULT ReserveUpdateScratch( DWORD dwCount );
+
   };
 //DOM-IGNORE-END
 
@@ -45,6 +45,11 @@ DaGenericItem::DaGenericItem( )
    m_pGroup             = NULL;
    m_DeviceItem         = NULL;
    m_LastReadQuality    = OPC_QUALITY_BAD;
+   m_lDirty             = FALSE;
+   m_iSubscriberIndex   = -1;
+   m_llLastReadVersion  = DaNewChangeVersion();
+   m_llSharedToken      = 0;
+   m_llSharedLastReadVersion = 0;
 
    memset( &m_ExtItemDef, 0, sizeof (ITEMDEFEXT) );
 
@@ -97,7 +102,10 @@ HRESULT DaGenericItem::Create( BOOL            Active,
    EnterCriticalSection( &m_pGroup->m_ItemsCritSec );
       // get new handle
    m_ServerHandle = m_pGroup->m_oaItems.New();
-      
+   if (m_ServerHandle == (OPCHANDLE)-1) {    // maximum number of items reached
+      res = E_OUTOFMEMORY;
+      goto CreateExit1;
+   }
    res = m_pGroup->m_oaItems.PutElem( m_ServerHandle, this );
    if ( FAILED( res ) ) {
       goto CreateExit1;
@@ -106,11 +114,15 @@ HRESULT DaGenericItem::Create( BOOL            Active,
    *pServerHandle = m_ServerHandle;
 
    m_Created = TRUE;
+                              // Get notified about changes of the DeviceItem
+   m_DeviceItem->AddChangeSubscriber( this );
                               // Notify the attached DeviceItem if there
                               // is a new active item.
    if (m_Active && pGroup->GetActiveState()) {
       AttachActiveCountOfDeviceItem();
    }
+                              // Force the initial update.
+   MarkDirty();
    return S_OK;
 
 CreateExit1:
@@ -164,6 +176,10 @@ HRESULT DaGenericItem::Create(
                               // add item to group 
    EnterCriticalSection( &m_pGroup->m_ItemsCritSec );
    m_ServerHandle = m_pGroup->m_oaItems.New();
+   if (m_ServerHandle == (OPCHANDLE)-1) {    // maximum number of items reached
+      res = E_OUTOFMEMORY;
+      goto CreateCloneExit1;
+   }
    res = m_pGroup->m_oaItems.PutElem( m_ServerHandle, this );
    if ( FAILED( res ) ) {
       goto CreateCloneExit1;
@@ -173,11 +189,15 @@ HRESULT DaGenericItem::Create(
 
    m_Created = TRUE;
 
+                              // Get notified about changes of the DeviceItem
+   m_DeviceItem->AddChangeSubscriber( this );
                               // Notify the attached DeviceItem if there
                               // is a new active item.
    if (m_Active && pGroup->GetActiveState()) {
       AttachActiveCountOfDeviceItem();
    }
+                              // Force the initial update.
+   MarkDirty();
       return S_OK;
 
 CreateCloneExit1:
@@ -203,6 +223,8 @@ DaGenericItem::~DaGenericItem()
       if (m_Active && m_pGroup->GetActiveState()) {
          DetachActiveCountOfDeviceItem();
       }
+         // no more change notifications from the DeviceItem
+      m_DeviceItem->RemoveChangeSubscriber( this );
          
          // detach from group
       EnterCriticalSection( &m_pGroup->m_ItemsCritSec );
@@ -489,9 +511,10 @@ HRESULT DaGenericItem::CompareLastRead( float fltPercentDeadband,
 
 
 //=====================================================================================
-// Assigns new values to the members m_LastReadValue and m_LastReadQuality
+// Assigns new values to the members m_LastReadValue and m_LastReadQuality.
+// If pllVersion is not NULL it returns the new version of the members.
 //=====================================================================================
-HRESULT DaGenericItem::UpdateLastRead( VARIANT vValue, WORD wQuality )
+HRESULT DaGenericItem::UpdateLastRead( VARIANT vValue, WORD wQuality, LONGLONG* pllVersion /* = NULL */ )
 {
    _ASSERTE( m_Created );
 
@@ -504,7 +527,12 @@ HRESULT DaGenericItem::UpdateLastRead( VARIANT vValue, WORD wQuality )
    if (SUCCEEDED( hres )) {
       m_LastReadQuality = wQuality;
    }
+   LONGLONG llVersion = DaNewChangeVersion(); // also renewed if failed, the value may be cleared
+   InterlockedExchange64( &m_llLastReadVersion, llVersion );
    LeaveCriticalSection( &m_CritSec );
+   if (pllVersion) {
+      *pllVersion = SUCCEEDED( hres ) ? llVersion : 0;
+   }
    return hres;
 }
 
@@ -520,7 +548,49 @@ void DaGenericItem::ResetLastRead( void )
    EnterCriticalSection( &m_CritSec );
    VariantClear( &m_LastReadValue );
    m_LastReadQuality = OPC_QUALITY_BAD;
+   InterlockedExchange64( &m_llLastReadVersion, DaNewChangeVersion() );
    LeaveCriticalSection( &m_CritSec );
+   MarkDirty();                                 // Must be compared with the next update
+}
+
+
+
+//=====================================================================================
+// Queues the item in the dirty list of the group if not already done.
+// Called by the attached DeviceItem if the item changes. Do not enter any
+// other critical section of the item because the DeviceItem calls this
+// function while owning its critical section.
+//=====================================================================================
+void DaGenericItem::MarkDirty( void )
+{
+   if (SetDirty()) {
+      if (FAILED( m_pGroup->AddDirtyItem( m_ServerHandle ) )) {
+         InterlockedExchange( &m_lDirty, FALSE );  // Try again with the next change
+      }
+   }
+}
+
+
+
+//=====================================================================================
+// Sets the dirty flag. Returns TRUE if the item was not dirty; then the caller must
+// queue the item in the dirty list of the group or clear the flag again.
+//=====================================================================================
+BOOL DaGenericItem::SetDirty( void )
+{
+   _ASSERTE( m_Created );
+
+   return InterlockedExchange( &m_lDirty, TRUE ) == FALSE;
+}
+
+
+
+//=====================================================================================
+// Clears the dirty flag. Returns TRUE if the item was dirty.
+//=====================================================================================
+BOOL DaGenericItem::ClearDirty( void )
+{
+   return InterlockedExchange( &m_lDirty, FALSE ) ? TRUE : FALSE;
 }
 
 
@@ -598,6 +668,7 @@ HRESULT DaGenericItem::set_RequestedDataType( VARTYPE RequestedDataType )
    }
    if (SUCCEEDED( hres )) {
       m_RequestedDataType = RequestedDataType;  // Accepted data type
+      MarkDirty();                              // Compare with the new data type
    }
    LeaveCriticalSection( &m_CritSec );
    return hres;
@@ -909,7 +980,7 @@ HRESULT DaGenericItem::get_EUData( OPCEUTYPE *EUType, VARIANT *EUInfo )
 HRESULT DaGenericItem::get_Attr( OPCITEMATTRIBUTES * pAttr, OPCHANDLE hServer )
 {
                                        // Protect all item attributes (for CALL-R)
-   EnterCriticalSection( &m_DeviceItem->m_CritSecAllAttrs );
+   EnterCriticalSection( m_DeviceItem->get_AllAttrsCritSec() );
 
    get_AccessPath( &pAttr->szAccessPath );
    get_ItemIDCopy( &pAttr->szItemID );
@@ -923,7 +994,7 @@ HRESULT DaGenericItem::get_Attr( OPCITEMATTRIBUTES * pAttr, OPCHANDLE hServer )
    get_EUData( &pAttr->dwEUType, &pAttr->vEUInfo );
 
                                        // Release item attributes protection (for CALL-R)
-   LeaveCriticalSection( &m_DeviceItem->m_CritSecAllAttrs );
+   LeaveCriticalSection( m_DeviceItem->get_AllAttrsCritSec() );
    return S_OK;
 }
 
@@ -941,6 +1012,8 @@ HRESULT DaGenericItem::AttachActiveCountOfDeviceItem( void )
    if (Killed()) {
       return E_FAIL ;
    }
+                                                // Receive change notifications from now on
+   m_DeviceItem->SetChangeSubscriberActive( this, TRUE );
    return m_DeviceItem->AttachActiveCount();
 }
 
@@ -958,6 +1031,8 @@ HRESULT DaGenericItem::DetachActiveCountOfDeviceItem( void )
    if (Killed()) {
       return E_FAIL ;
    }
+                                                // No change notifications while inactive
+   m_DeviceItem->SetChangeSubscriberActive( this, FALSE );
    return m_DeviceItem->DetachActiveCount();
 }
 //DOM-IGNORE-END
@@ -44,6 +44,9 @@ typedef struct tagITEMDEFEXT {
 class DaGenericGroup;
 
 class DaGenericItem {
+                  // maintains the subscriber index m_iSubscriberIndex
+   friend class DaDeviceItem;
+
 public:
 
       // ===============================================================
@@ -180,9 +183,38 @@ public:
    HRESULT  CompareLastRead( float fltPercentDeadband,
                              const VARIANT& vCompValue, WORD wCompQuality,
                              BOOL& fChanged );
-   HRESULT  UpdateLastRead( VARIANT vValue, WORD wQuality );
+   HRESULT  UpdateLastRead( VARIANT vValue, WORD wQuality, LONGLONG* pllVersion = NULL );
    void     ResetLastRead( void );
 
+                  // Returns the version of m_LastReadValue and m_LastReadQuality.
+                  // A new unique version is assigned with each modification.
+   LONGLONG get_LastReadVersion( void ) { return DaReadChangeVersion( &m_llLastReadVersion ); }
+
+                  // Token of the shared subscription value which is the last read value
+                  // (see DaDeviceItem::ReadShared()), 0 if unknown. The token is only valid
+                  // as long as the last read value is not modified by other functions.
+                  // Only used by the update of the group, no lock is required.
+   LONGLONG get_SharedToken( void )
+               { return (m_llSharedToken && m_llSharedLastReadVersion == get_LastReadVersion()) ? m_llSharedToken : 0; }
+   void     set_SharedToken( LONGLONG llToken, LONGLONG llLastReadVersion )
+               { m_llSharedToken = llToken; m_llSharedLastReadVersion = llLastReadVersion; }
+
+                  // Change tracking. MarkDirty() is called by the attached DeviceItem
+                  // if the item changes and queues the item in the dirty list of the group.
+                  // SetDirty() only sets the flag and returns TRUE if the item was not
+                  // dirty; the caller must then queue the item with
+                  // DaGenericGroup::AddDirtyItems() (see DaDeviceItem::SetItemValues()).
+                  // ClearDirty() returns TRUE if the item was dirty.
+   void     MarkDirty( void );
+   BOOL     SetDirty( void );
+   BOOL     ClearDirty( void );
+
+                  // the group owning the generic item
+   DaGenericGroup* get_Group( void ) const { return m_pGroup; }
+
+                  // the server handle assigned to the item in the group
+   OPCHANDLE get_ServerHandle( void ) const { return m_ServerHandle; }
+
 
 //=============================  Member Variables  ==================================
 protected:
@@ -200,6 +232,19 @@ protected:
    VARIANT        m_LastReadValue;
    WORD           m_LastReadQuality;
 
+                  // Version of m_LastReadValue and m_LastReadQuality
+                  // (see DaNewChangeVersion()). Modified within m_CritSec.
+   volatile LONGLONG m_llLastReadVersion;
+
+                  // Token of the shared subscription and the version of the
+                  // last read value it was assigned to (see get_SharedToken())
+   LONGLONG       m_llSharedToken;
+   LONGLONG       m_llSharedLastReadVersion;
+
+                  // TRUE if the item is queued in the dirty list of the group.
+                  // Modified with interlocked functions only.
+   volatile LONG  m_lDirty;
+
                   // the group owning the generic item
    DaGenericGroup  *m_pGroup;
 
@@ -234,6 +279,10 @@ protected:
    CRITICAL_SECTION m_CritSec;
 
 private:
+                  // Position in the subscriber list of the attached DeviceItem
+                  // or -1 if not subscribed. Protected like the subscriber list
+                  // (see DaDeviceItem::m_arChangeSubscribers).
+   int            m_iSubscriberIndex;
 };
 //DOM-IGNORE-END
 
@@ -39,7 +39,8 @@ DaGenericServer::DaGenericServer()
     ;
     m_pCOpcSrv = nullptr;
     m_FilterCriteria = nullptr;
-    m_hUpdateThread = nullptr;
+    m_lAsyncTransactions = 0;
+    m_lAsyncRejectLogged = FALSE;
 
     try
     {
@@ -91,6 +92,9 @@ HRESULT DaGenericServer::Create(DaBaseServer* pServerClassHandler, DaComBaseServ
     // from which the groups 'tick count'  information will be calculated
     m_ActualBaseUpdateRate = pServerClassHandler->GetBaseUpdateRate();
 
+    // maximum number of item values queued for delivery to the client
+    m_CallbackQueue.SetLimit(pServerClassHandler->GetCallbackQueueLimit());
+
     m_ToKill = FALSE;
     m_RefCount = 0;
 
@@ -113,49 +117,23 @@ HRESULT DaGenericServer::Create(DaBaseServer* pServerClassHandler, DaComBaseServ
     m_DataTypeFilter = VT_EMPTY;
     m_AccessRightsFilter = 0;
 
-    // Create the update event
-    TCHAR szEventName[30];                       // Name must be unique
-    _stprintf_s(szEventName,  30, _T("UpdateEvent_0x%X"), this);
-
-    m_hUpdateEvent = CreateEvent(nullptr,          // Cannot inherit handle.
-                                 FALSE,         // Automatically reset.
-                                 FALSE,         // Nonsignaled initial state.
-                                 szEventName);
-
-    if (m_hUpdateEvent == nullptr) {
-        res = E_FAIL;                             // Cannot create an event.
-        goto CreateExit2;
-    }
-
-    res = CreateWaitForUpdateThread();
-    if (FAILED(res)) {
-        goto CreateExit3;
-    }
-
     res = m_BrowseData.Create(pServerClassHandler);
     if (FAILED(res)) {
-        goto CreateExit4;
+        goto CreateExit1;
     }
 
     m_Created = TRUE;
 
     res = m_pServerHandler->AddServerToList(this);
     if (FAILED(res)) {
-        goto CreateExit4;
+        m_Created = FALSE;
+        goto CreateExit1;
     }
 
     Attach();                                     // Now generic Server is used
     return S_OK;
 
-CreateExit4:
-    m_Created = FALSE;
-    KillWaitForUpdateThread();
-
-CreateExit3:
-    CloseHandle(m_hUpdateEvent);
-    m_hUpdateEvent = nullptr;
-
-CreateExit2:
+CreateExit1:
     SysFreeString(m_FilterCriteria);
     m_FilterCriteria = nullptr;
 
@@ -171,9 +149,6 @@ DaGenericServer::~DaGenericServer(void)
     if (m_Created == TRUE) {
 
         m_pServerHandler->RemoveServerFromList(this);
-
-        CloseHandle(m_hUpdateEvent);
-        m_hUpdateEvent = nullptr;
     }
 
     if (m_FilterCriteria) {
@@ -197,6 +172,7 @@ int  DaGenericServer::Attach(void)
 
     EnterCriticalSection(&m_CritSec);
     if (m_ToKill) {
+        LeaveCriticalSection(&m_CritSec);
         return -1;
     }
     i = m_RefCount++;
@@ -245,8 +221,6 @@ int  DaGenericServer::Kill(BOOL WithDetach)
     HRESULT        res;
     DaGenericGroup* theGroup;
 
-    KillWaitForUpdateThread();
-
     EnterCriticalSection(&m_CritSec);
 
     // kill the groups of this server
@@ -419,23 +393,23 @@ HRESULT DaGenericServer::SearchGroup(
     DaGenericGroup  **theGroup,
     long           *sgh)
 {
-    long           i, size;
+    long           i;
     long           pgh;
     DaGenericGroup  *group;
     HRESULT        res;
 
     if (theName != nullptr) {
-        size = m_GroupList.Size();
-        for (i = 0; i < size; i++) {
-            res = m_GroupList.GetElem(i, &group);
-            if ((SUCCEEDED(res))
-                && (group->Killed() == FALSE)
+        res = m_GroupList.First(&i);
+        while (SUCCEEDED(res)) {
+            m_GroupList.GetElem(i, &group);
+            if ((group->Killed() == FALSE)
                 && (group->GetPublicInfo(&pgh) == Public)
                 && (wcscmp(theName, group->m_Name) == 0)) {
                 *sgh = i;
                 *theGroup = group;
                 return S_OK;
             }
+            res = m_GroupList.Next(i, &i);
         }
     }
     *theGroup = nullptr;
@@ -543,7 +517,7 @@ HRESULT DaGenericServer::GetCOMGroup(
             goto GetCOMGroupExit1;
         }
         // store the created COM group in the list
-        hr = m_COMGroupList.PutElem(pGGroup->m_hServerGroupHandle, pCOMGroup);
+        hr = m_COMGroupList.PutElemAt(pGGroup->m_hServerGroupHandle, pCOMGroup);
         if (FAILED(hr)) {                       // probably out of memory
             pCOMGroup->Release();                  // release interface and destroy object
             goto GetCOMGroupExit1;
@@ -891,164 +865,151 @@ HRESULT DaGenericServer::GetGroupUniqueName(long ServerGroupHandle, WCHAR **theN
 
 
 //=================================================================================
-// Thread waiting for Update Event from server class handler
-// ---------------------------------------------------------
+// Queue the Groups with expired Timers
+// ------------------------------------
+// Called by the server class handler with each base update tick.
+// The groups are handled by the worker threads of the update pool.
 //=================================================================================
-unsigned __stdcall WaitForUpdateThread(void* pArg)
+void DaGenericServer::QueueExpiredGroups(DaUpdatePool *pPool)
 {
-    DaGenericServer* serv = static_cast<DaGenericServer *>(pArg);
-    _ASSERTE(serv != NULL);
-
     long              idx;
-    HRESULT           res;
+    DWORD             dwKind;
     DaGenericGroup    *group;
 
-    while (serv->m_UpdateThreadToKill == FALSE) {
-        // wait ServerClassHandler sends me update event
-        WaitForSingleObject(serv->m_hUpdateEvent, INFINITE);
+    // check if base update rate has changend
+    // and if so recalc tick counts of groups
+    if (CheckBaseUpdateRateChanged()) {
+        RecalcTicksOfAllGroups();
+    }
 
-        // check if base update rate has changend
-        // and if so recalc tick counts of groups
-        serv->CheckBaseUpdateRateChanged();
+    // queue only the groups with an expired update or keep-alive timer
+    m_Scheduler.NextTick();
+    while (m_Scheduler.PopExpired(&idx, &dwKind)) {
 
-        // update all groups belonging to this server instance
-        // all access to the group list is protected by crit sec
-        EnterCriticalSection(&serv->m_GroupsCritSec);
-        res = serv->m_GroupList.First(&idx);
+        // get and nail the group
+        if (SUCCEEDED(GetGenericGroup(idx, &group))) {
+            if (Attach() < 0) {                   // server is being killed
+                ReleaseGenericGroup(idx);
+                break;
+            }
+            // the pool unnails the group and
+            // detaches the server when done
+            pPool->QueueGroup(this, group, dwKind);
+        }
+    }
+}
 
-        while (SUCCEEDED(res)) {
-            // get and nail the group
-            res = serv->GetGenericGroup(idx, &group);
 
-            LeaveCriticalSection(&serv->m_GroupsCritSec);
+//=================================================================================
+// Handle an expired Group Timer
+// -----------------------------
+// Called by a worker thread of the update pool with a nailed group.
+//=================================================================================
+void DaGenericServer::HandleGroupTimer(DaGenericGroup *group, DWORD dwKind, ULONGLONG ullTick)
+{
+    if (group->GetActiveState() == FALSE) {
+        // only active groups enter into account for update,
+        // the timers are set again if the group is activated
+        return;
+    }
 
-            if (SUCCEEDED(res)) {
+    if (dwKind == DA_TIMER_UPDATE) {
+        DWORD       dwTicks, dwStretch;
+        ULONGLONG   ullNow;
 
-                if (group->GetActiveState() == TRUE) {
-                    // only active groups enter into account for update
-                    EnterCriticalSection(&group->m_UpdateRateCritSec);
-                    // recalc ticks if base update rate changed
-                    serv->RecalcTicks(group);
-                    // update only active groups
-                    group->m_TickCount--;
+        EnterCriticalSection(&group->m_UpdateRateCritSec);
+        // recalc ticks if base update rate changed
+        RecalcTicks(group);
 
-                    if (group->m_TickCount == 0) {
-                        // restart tick counter
-                        group->m_TickCount = group->m_Ticks;
-                        LeaveCriticalSection(&group->m_UpdateRateCritSec);
+        // stretch the update rate if the server is overloaded
+        dwTicks = group->m_Ticks;
+        dwStretch = m_pServerHandler->GetUpdateStretch();
+        if (dwStretch > 100) {
+            dwTicks = (dwTicks * dwStretch + 99) / 100;
+        }
+        group->m_dwEffectiveUpdateRate = dwTicks * group->m_ActualBaseUpdateRate;
 
-                        // it's group turn to update
-                        res = group->UpdateNotify();
+        ullNow = GetTickCount64();
+        if (group->m_ullNextUpdateDue != 0 && ullNow > group->m_ullNextUpdateDue) {
+            group->m_dwUpdateLag = (DWORD)min(ullNow - group->m_ullNextUpdateDue, MAXDWORD);
+        }
+        else {
+            group->m_dwUpdateLag = 0;
+        }
+        group->m_ullNextUpdateDue = ullNow + group->m_RevisedUpdateRate;
 
-                    }
-                    else {
-                        LeaveCriticalSection(&group->m_UpdateRateCritSec);
-                    }
+        // restart update timer
+        group->m_ullLastUpdateTick = ullTick;
+        m_Scheduler.SetTimer(group->m_hServerGroupHandle, DA_TIMER_UPDATE, ullTick + dwTicks);
+        LeaveCriticalSection(&group->m_UpdateRateCritSec);
 
-                    //
-                    // Keep Alive
-                    //
-                    if (group->m_fCallbackEnable) {
-
-                        group->m_csKeepAlive.Lock();
-                        if (group->KeepAliveTime()) {    // Activated keep-alive callbacks
-
-                            CComObject<DaGroup>* pCOMGroup = nullptr;
-                            IUnknown** ppCallback = nullptr;
-
-                            serv->CriticalSectionCOMGroupList.BeginReading();   // lock reading
-                            if (SUCCEEDED(serv->m_COMGroupList.GetElem(group->m_hServerGroupHandle, &pCOMGroup))) {
-                                ppCallback = pCOMGroup->m_vec.begin(); // Check if there is a registered callback function
-
-                                if (*ppCallback) {            // Enabled Callback exist
-
-                                    group->m_dwKeepAliveCount--;
-                                    if (group->m_dwKeepAliveCount == 0) {
-                                        group->ResetKeepAliveCounter();
-                                        HRESULT hrErr = S_OK;
-                                        pCOMGroup->FireOnDataChange(0, nullptr, &hrErr);
-                                    }
-                                }
-                            }
-                            serv->CriticalSectionCOMGroupList.EndReading(); // unlock reading
-                        }
-                        group->m_csKeepAlive.Unlock();
-                    }
-                    //
-                    // Keep Alive
-                    //
-                }
+        // it's group turn to update
+        group->UpdateNotify();
+        return;
+    }
 
-                // unnail the group
-                serv->ReleaseGenericGroup(idx);
-            }
+    //
+    // Keep Alive
+    //
+    _ASSERTE(dwKind == DA_TIMER_KEEPALIVE);
 
-            // get the index of the next group in the list
-            EnterCriticalSection(&serv->m_GroupsCritSec);
-            res = serv->m_GroupList.Next(idx, &idx);
-        }
-        LeaveCriticalSection(&serv->m_GroupsCritSec);
+    group->m_csKeepAlive.Lock();
+    if (group->KeepAliveTime()) {                 // Activated keep-alive callbacks
 
-    }
+        // restart keep-alive timer
+        group->ResetKeepAliveCounter();
 
-    _endthreadex(0);
-    return 0;
+        if (group->m_fCallbackEnable) {
+            // delivered by the callback queue if there is a registered callback
+            m_CallbackQueue.EnqueueKeepAlive(group->m_hServerGroupHandle);
+        }
+    }
+    group->m_csKeepAlive.Unlock();
 
-} // WaitForUpdateThread
+    m_CallbackQueue.Deliver(this);
+}
 
 
 //=================================================================================
-// Create Update Thread
-// --------------------
+// Recalculate Tick Count information for all groups
+// -------------------------------------------------
+// Called with the base update tick if the base update rate has changed.
 //=================================================================================
-HRESULT DaGenericServer::CreateWaitForUpdateThread(void)
+void DaGenericServer::RecalcTicksOfAllGroups(void)
 {
-    unsigned uThreadID;                       // Thread identifier
-
-    m_UpdateThreadToKill = FALSE;
-
-    m_hUpdateThread = (HANDLE)_beginthreadex(
-        nullptr,                // No thread security attributes
-        0,                   // Default stack size  
-        WaitForUpdateThread, // Pointer to thread function 
-        this,                // Pass class to new thread for access to the AppHandler
-        0,                   // Run thread immediately
-        &uThreadID);        // Thread identifier
-
-
-    if (m_hUpdateThread == nullptr) {                  // Cannot create the thread
-        return HRESULT_FROM_WIN32(GetLastError());
-    }
-    return S_OK;
-}
+    long            idx;
+    HRESULT         res;
+    DaGenericGroup  *group;
 
+    EnterCriticalSection(&m_GroupsCritSec);
+    res = m_GroupList.First(&idx);
 
+    while (SUCCEEDED(res)) {
+        // get and nail the group
+        res = GetGenericGroup(idx, &group);
 
-//=================================================================================
-// Kill Update Thread
-// ------------------
-//=================================================================================
-HRESULT DaGenericServer::KillWaitForUpdateThread(void)
-{
-    if (m_hUpdateThread) {
+        LeaveCriticalSection(&m_GroupsCritSec);
 
-        m_UpdateThreadToKill = TRUE;
+        if (SUCCEEDED(res)) {
+            EnterCriticalSection(&group->m_UpdateRateCritSec);
+            RecalcTicks(group);
+            LeaveCriticalSection(&group->m_UpdateRateCritSec);
 
-        // give a chance to exit if the thread is waiting
-        SetEvent(m_hUpdateEvent);
+            // the keep-alive ticks depend also on the base update rate
+            group->ResetKeepAliveCounter();
 
-        // Wait max 60 secs until the update thread has terminated.
-        if (WaitForSingleObject(m_hUpdateThread, 60000) == WAIT_TIMEOUT) {
-            TerminateThread(m_hUpdateThread, 1);
+            // unnail the group
+            ReleaseGenericGroup(idx);
         }
-        CloseHandle(m_hUpdateThread);
-        m_hUpdateThread = nullptr;
+
+        // get the index of the next group in the list
+        EnterCriticalSection(&m_GroupsCritSec);
+        res = m_GroupList.Next(idx, &idx);
     }
-    return S_OK;
+    LeaveCriticalSection(&m_GroupsCritSec);
 }
 
 
-
 //=================================================================================
 // Check Base Update Rate
 // ----------------------
@@ -1258,10 +1219,10 @@ HRESULT DaGenericServer::InternalReadMaxAge(
 
     //
     // Read from the Device for those Items which it's required.
+    // Concurrent requests for the same items share the device read.
     //
     if (dwNumOfItemsToReadFromDevice) {
-        HRESULT hrRefresh = m_pServerHandler->OnRefreshInputCache(
-            OPC_REFRESH_CLIENT,
+        HRESULT hrRefresh = m_pServerHandler->RefreshInputCacheCoalesced(
             dwNumOfItems,
             pDItemsToReadFromDevice,
             errors);
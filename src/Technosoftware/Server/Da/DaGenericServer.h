@@ -29,6 +29,9 @@
 #include "DaGenericGroup.h"
 #include "DaBrowse.h"
 #include "ReadWriteLock.h"
+#include "DaUpdateScheduler.h"
+#include "DaUpdatePool.h"
+#include "DaCallbackQueue.h"
 
 #define  OPC_GROUPNAME_ENUM   1     // an enumerator which iterates over group names (Default).
 #define  OPC_GROUP_ENUM       2     // an enumerator which iterates over group objects
@@ -39,11 +42,9 @@ class DaBaseServer;
 class DaComBaseServer;
 
 class DaGenericServer {
-    // this is the thread associated to each instance of this
-    // class and therefore virtually a member of it:
-    // virtually because the operating system doesn't allow
-    // class methods to be passed to CreateThread
-    friend unsigned __stdcall WaitForUpdateThread(void* pArg);
+    // the worker threads of the update pool send the
+    // group updates of all instances of this class
+    friend class DaUpdatePool;
     friend class DaBrowseData;
 
 public:
@@ -138,6 +139,14 @@ public:
     // the last time the server sent values to the client
     FILETIME m_LastUpdateTime;
 
+    // number of admitted asynchronous transactions of this client which
+    // are not yet completed (see DaBaseServer::AdmitAsyncTransaction())
+    volatile LONG m_lAsyncTransactions;
+
+    // TRUE if a rejected transaction of this client has been logged; reset
+    // by the next admitted transaction so that each overload is logged once
+    volatile LONG m_lAsyncRejectLogged;
+
     // Enumerator type settings for automation interface
     OPCENUMSCOPE  m_Enum_Scope; // Indicates the class of groups to be enumerated
                             // OPC_ENUM_PRIVATE_CONNECTIONS  enumerates the private groups the client is connected to (Default).
@@ -255,10 +264,19 @@ public:
     // Update notification  //
     //////////////////////////
 public:
-    // this member is used by the server class handler
-    // associated with this class ( daBaseServer_ )
-    // to inform to send group update to the clients
-    HANDLE      m_hUpdateEvent;
+    // this method is called by the server class handler
+    // associated with this class ( daBaseServer_ ) with
+    // each base update tick to queue the groups which have
+    // to send updates to the client to the update pool
+    void QueueExpiredGroups(DaUpdatePool *pPool);
+
+    // update and keep-alive timers of the groups
+    // keyed on the base update tick at which they are due
+    DaUpdateScheduler m_Scheduler;
+
+    // OnDataChange callbacks of all groups waiting for delivery to
+    // the client; delivered without owning CriticalSectionCOMGroupList
+    DaCallbackQueue m_CallbackQueue;
 
 private:
     // the update rate for which the ticks count limits
@@ -269,23 +287,6 @@ private:
     // protects access to  m_ActualBaseUpdateRate
     CRITICAL_SECTION m_UpdateRateCritSec;
 
-    // handle of the refresh thread
-    // associated with this class which has to send
-    // updates to clients through IAdviseSink (custom)
-    // or some Callback interface (automation)
-    HANDLE      m_hUpdateThread;
-
-    // tells whether the thread has to stop
-    // or go on updating
-    BOOL        m_UpdateThreadToKill;
-
-    // creates the thread waiting for the  m_hUpdateEvent
-    // and sending update callbacks to the clients
-    HRESULT CreateWaitForUpdateThread(void);
-
-    // destroys the thread waiting for the  m_hUpdateEvent
-    HRESULT KillWaitForUpdateThread(void);
-
     // checks if update rate of server class handler has changed
     // and sets it to the new rate
     BOOL CheckBaseUpdateRateChanged(void);
@@ -293,6 +294,12 @@ private:
     // recalculates tick count information for a group
     HRESULT RecalcTicks(DaGenericGroup *group);
 
+    // recalculates tick count information for all groups
+    void RecalcTicksOfAllGroups(void);
+
+    // handles an expired update or keep-alive timer of a group
+    void HandleGroupTimer(DaGenericGroup *group, DWORD dwKind, ULONGLONG ullTick);
+
 };
 //DOM-IGNORE-END
 
@@ -237,6 +237,7 @@ HRESULT STDMETHODCALLTYPE DaGroup::SetState(
 		LOGFMTI( "   Percent Deadband: %f%%", *pPercentDeadband );
 		// use specified Percent Deadband
 		group->m_PercentDeadband = *pPercentDeadband; 
+		group->MarkAllItemsDirty();                 // compare all items with the new deadband
 	}
 
 	if (pRequestedUpdateRate) {
@@ -1094,7 +1095,12 @@ if (pAdv == NULL) {
 // add read advise thread to the list of the group
 EnterCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 th = group->m_oaAsyncThread.New();
-res = group->m_oaAsyncThread.PutElem( th, pAdv );
+if (th == -1) {                              // maximum number of transactions reached
+	res = E_OUTOFMEMORY;
+}
+else {
+	res = group->m_oaAsyncThread.PutElem( th, pAdv );
+}
 LeaveCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 
 if (FAILED( res )) {
@@ -1275,7 +1281,12 @@ if( pAdv == NULL ) {
 // add write advise thread to the list of the group
 EnterCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 th = group->m_oaAsyncThread.New();
-res = group->m_oaAsyncThread.PutElem( th, pAdv );
+if (th == -1) {                              // maximum number of transactions reached
+	res = E_OUTOFMEMORY;
+}
+else {
+	res = group->m_oaAsyncThread.PutElem( th, pAdv );
+}
 LeaveCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 if( FAILED(res) ) {
 	goto ASIOWriteExit5;
@@ -1473,7 +1484,12 @@ HRESULT STDMETHODCALLTYPE DaGroup::Refresh(
 	// add async read advise thread to the thread list of the group
 	EnterCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	th = group->m_oaAsyncThread.New();
-	res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	if (th == -1) {                           // maximum number of transactions reached
+		res = E_OUTOFMEMORY;
+	}
+	else {
+		res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	}
 	LeaveCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	if( FAILED(res) ) {
 		// could not add to Thread list
@@ -1840,6 +1840,7 @@ HRESULT STDMETHODCALLTYPE DaGroup::put_PercentDeadBand(
 	}
 	else {
 		group->m_PercentDeadband = PercentDeadBand;
+		group->MarkAllItemsDirty();                 // compare all items with the new deadband
 		res = S_OK;
 	}
 	ReleaseGenericGroup();
@@ -2640,7 +2641,12 @@ HRESULT STDMETHODCALLTYPE DaGroup::OPCRead(
 	// add async read advise thread to the thread list of the group
 	EnterCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	th = group->m_oaAsyncThread.New();
-	res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	if (th == -1) {                           // maximum number of transactions reached
+		res = E_OUTOFMEMORY;
+	}
+	else {
+		res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	}
 	LeaveCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	if( FAILED(res) ) {
 		// could not add to Thread list
@@ -2865,7 +2871,12 @@ HRESULT STDMETHODCALLTYPE DaGroup::OPCWrite(
 	// add async read advise thread to the thread list of the group
 	EnterCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	th = group->m_oaAsyncThread.New();
-	res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	if (th == -1) {                           // maximum number of transactions reached
+		res = E_OUTOFMEMORY;
+	}
+	else {
+		res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	}
 	LeaveCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	if( FAILED(res) ) {
 		// could not add to Thread list
@@ -3048,7 +3059,12 @@ HRESULT STDMETHODCALLTYPE DaGroup::Refresh(
 	// add async refresh advise thread to the thread list of the group
 	EnterCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	th = group->m_oaAsyncThread.New();
-	res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	if (th == -1) {                           // maximum number of transactions reached
+		res = E_OUTOFMEMORY;
+	}
+	else {
+		res = group->m_oaAsyncThread.PutElem( th, pAdv );
+	}
 	LeaveCriticalSection( &( group->m_AsyncThreadsCritSec ) );
 	if( FAILED(res) ) {
 		// could not add to Thread list
@@ -40,7 +40,7 @@ DaPublicGroupManager::DaPublicGroupManager( )
 //====================================================================
 DaPublicGroupManager::~DaPublicGroupManager() 
 {
-      long           i, ni;
+      long           i;
       HRESULT        res;
       DaPublicGroup   *pg;
 
@@ -50,14 +50,13 @@ DaPublicGroupManager::~DaPublicGroupManager()
       // when the module is unloading
    EnterCriticalSection(&m_CritSec);
 
-   ni = m_array.Size();
-   i = 0;
-   while ( i < ni ) {
-      res = m_array.GetElem( i, &pg );
-      if ( (SUCCEEDED(res)) && (pg != NULL) ) {
+   res = m_array.First( &i );
+   while ( SUCCEEDED(res) ) {
+      m_array.GetElem( i, &pg );
+      if ( pg != NULL ) {
          delete pg;
       }
-      i ++;
+      res = m_array.Next( i, &i );
    }         
 
    LeaveCriticalSection(&m_CritSec);
@@ -91,6 +90,10 @@ HRESULT DaPublicGroupManager::AddGroup( DaPublicGroup *pGroup, long *hPGHandle )
    }
 
    *hPGHandle = m_array.New();
+   if (*hPGHandle == -1) {                   // maximum number of groups reached
+      res = E_OUTOFMEMORY;
+      goto PGHAddGroupExit0;
+   }
    res = m_array.PutElem( *hPGHandle, pGroup);
    if ( FAILED(res) ) {
          // cannot add the group
@@ -214,21 +217,19 @@ HRESULT DaPublicGroupManager::FindGroupNoLock( BSTR Name, long *hPGHandle )
 {
       long           res;
       DaPublicGroup   *pg;
-      long           i, ni;
+      long           i;
 
       // search all the m_array
-   ni = m_array.Size();
-   i = 0;
-   while ( i < ni ) {
-      res = m_array.GetElem( i, &pg );
-      if( (SUCCEEDED(res)) 
-            &&  ( pg->Killed() == FALSE ) 
+   res = m_array.First( &i );
+   while ( SUCCEEDED(res) ) {
+      m_array.GetElem( i, &pg );
+      if(     ( pg->Killed() == FALSE ) 
             &&  ( wcscmp( pg->m_Name, Name) == 0 ) ) {
          *hPGHandle = i;
          res = S_OK;
          goto PGHFindGroupExit0;
       }
-      i ++;
+      res = m_array.Next( i, &i );
    }         
 
    res = E_FAIL;
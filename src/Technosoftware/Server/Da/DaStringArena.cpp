@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+
+//DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include "DaStringArena.h"
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaStringArena::DaStringArena()
+{
+    m_pCurrent = nullptr;
+    m_ppBuckets = nullptr;
+    m_dwBuckets = 0;
+    m_dwChunks = 0;
+    m_dwStrings = 0;
+    m_dwInterned = 0;
+    m_ullHeapBytes = 0;
+    m_ullUsedBytes = 0;
+
+    InitializeCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// Destructor
+// ----------
+//    Releases the interned strings. Strings allocated with Alloc() must
+//    be freed before.
+//=========================================================================
+DaStringArena::~DaStringArena()
+{
+    for (DWORD i = 0; i < m_dwBuckets; i++) {
+        INTERNED* pEntry = m_ppBuckets[i];
+        while (pEntry) {
+            INTERNED* pNext = pEntry->pNext;
+            Free((LPWSTR)pEntry->szString);
+            delete pEntry;
+            pEntry = pNext;
+        }
+    }
+    delete[] m_ppBuckets;
+    if (m_pCurrent && m_pCurrent->lStrings == 0) {
+        VirtualFree(m_pCurrent, 0, MEM_RELEASE);
+    }
+    DeleteCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// Alloc
+// -----
+//=========================================================================
+LPWSTR DaStringArena::Alloc(LPCWSTR szString)
+{
+    _ASSERTE(szString);
+
+    size_t nLen = wcslen(szString);
+    LPWSTR szCopy;
+
+    EnterCriticalSection(&m_CritSec);
+    szCopy = AllocLocked(szString, nLen);
+    LeaveCriticalSection(&m_CritSec);
+    return szCopy;
+}
+
+
+//=========================================================================
+// AllocLocked
+// -----------
+//    Copies the first nLen characters of the string into the current
+//    chunk and terminates the copy. Must be called within m_CritSec.
+//=========================================================================
+LPWSTR DaStringArena::AllocLocked(LPCWSTR szString, size_t nLen)
+{
+    DWORD   dwSize = (DWORD)((nLen + 1) * sizeof(WCHAR));
+    LPWSTR  szCopy;
+
+    if (nLen >= DA_STRINGARENA_MAX_LENGTH) {      // Long strings are not stored in the arena
+        szCopy = new WCHAR[nLen + 1];
+        if (szCopy == nullptr) {
+            return nullptr;
+        }
+        m_ullHeapBytes += dwSize;
+    }
+    else {
+        if (m_pCurrent == nullptr || m_pCurrent->dwUsed + dwSize > DA_STRINGARENA_CHUNK_SIZE) {
+            CHUNK* pChunk = (CHUNK*)VirtualAlloc(nullptr, DA_STRINGARENA_CHUNK_SIZE,
+                                                 MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            if (pChunk == nullptr) {
+                return nullptr;
+            }
+            _ASSERTE(((ULONG_PTR)pChunk & (DA_STRINGARENA_CHUNK_SIZE - 1)) == 0);
+            pChunk->lStrings = 0;
+            pChunk->dwUsed = sizeof(CHUNK);
+                                                  // The previous chunk is released with its last string
+            if (m_pCurrent && m_pCurrent->lStrings == 0) {
+                VirtualFree(m_pCurrent, 0, MEM_RELEASE);
+                m_dwChunks--;
+            }
+            m_pCurrent = pChunk;
+            m_dwChunks++;
+        }
+        szCopy = (LPWSTR)((BYTE*)m_pCurrent + m_pCurrent->dwUsed);
+        m_pCurrent->dwUsed += dwSize;
+        m_pCurrent->lStrings++;
+    }
+    memcpy(szCopy, szString, nLen * sizeof(WCHAR));
+    szCopy[nLen] = 0;
+    m_dwStrings++;
+    m_ullUsedBytes += dwSize;
+    return szCopy;
+}
+
+
+//=========================================================================
+// Free
+// ----
+//=========================================================================
+void DaStringArena::Free(LPWSTR szString)
+{
+    if (szString == nullptr) {
+        return;
+    }
+
+    size_t  nLen = wcslen(szString);
+    DWORD   dwSize = (DWORD)((nLen + 1) * sizeof(WCHAR));
+
+    EnterCriticalSection(&m_CritSec);
+    if (nLen >= DA_STRINGARENA_MAX_LENGTH) {
+        delete[] szString;
+        m_ullHeapBytes -= dwSize;
+    }
+    else {                                        // Chunks are aligned to their size
+        CHUNK* pChunk = (CHUNK*)((ULONG_PTR)szString & ~((ULONG_PTR)DA_STRINGARENA_CHUNK_SIZE - 1));
+        _ASSERTE(pChunk->lStrings > 0);
+        if (--pChunk->lStrings == 0 && pChunk != m_pCurrent) {
+            VirtualFree(pChunk, 0, MEM_RELEASE);
+            m_dwChunks--;
+        }
+    }
+    m_dwStrings--;
+    m_ullUsedBytes -= dwSize;
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// Intern
+// ------
+//=========================================================================
+LPCWSTR DaStringArena::Intern(LPCWSTR szString)
+{
+    _ASSERTE(szString);
+
+    return Intern(szString, wcslen(szString));
+}
+
+
+//=========================================================================
+// Intern
+// ------
+//=========================================================================
+LPCWSTR DaStringArena::Intern(LPCWSTR szString, size_t nLen)
+{
+    _ASSERTE(szString);
+
+    DWORD   dwHash = 2166136261;                  // FNV-1a
+    LPCWSTR szInterned = nullptr;
+
+    for (size_t i = 0; i < nLen; i++) {
+        dwHash = (dwHash ^ szString[i]) * 16777619;
+    }
+
+    EnterCriticalSection(&m_CritSec);
+    if (m_ppBuckets == nullptr && !GrowBuckets()) {
+        LeaveCriticalSection(&m_CritSec);
+        return nullptr;
+    }
+
+    INTERNED** ppBucket = &m_ppBuckets[dwHash % m_dwBuckets];
+    for (INTERNED* pEntry = *ppBucket; pEntry; pEntry = pEntry->pNext) {
+        if (pEntry->dwHash == dwHash &&
+            wcsncmp(pEntry->szString, szString, nLen) == 0 && pEntry->szString[nLen] == 0) {
+            szInterned = pEntry->szString;
+            break;
+        }
+    }
+    if (szInterned == nullptr) {                  // New string
+        INTERNED* pEntry = new INTERNED;
+        if (pEntry) {
+            pEntry->szString = AllocLocked(szString, nLen);
+            if (pEntry->szString) {
+                pEntry->dwHash = dwHash;
+                pEntry->pNext = *ppBucket;
+                *ppBucket = pEntry;
+                m_dwInterned++;
+                szInterned = pEntry->szString;
+                if (m_dwInterned > 2 * m_dwBuckets) {
+                    GrowBuckets();                // Keeps the current table if out of memory
+                }
+            }
+            else {
+                delete pEntry;
+            }
+        }
+    }
+    LeaveCriticalSection(&m_CritSec);
+    return szInterned;
+}
+
+
+//=========================================================================
+// GrowBuckets
+// -----------
+//    Creates the hash table of the interned strings or doubles its size.
+//    Must be called within m_CritSec.
+//=========================================================================
+BOOL DaStringArena::GrowBuckets(void)
+{
+    DWORD       dwBuckets = m_dwBuckets ? 2 * m_dwBuckets : DA_STRINGARENA_BUCKETS;
+    INTERNED**  ppBuckets = new INTERNED*[dwBuckets];
+
+    if (ppBuckets == nullptr) {
+        return FALSE;
+    }
+    memset(ppBuckets, 0, dwBuckets * sizeof(INTERNED*));
+
+    for (DWORD i = 0; i < m_dwBuckets; i++) {
+        INTERNED* pEntry = m_ppBuckets[i];
+        while (pEntry) {
+            INTERNED* pNext = pEntry->pNext;
+            INTERNED** ppBucket = &ppBuckets[pEntry->dwHash % dwBuckets];
+            pEntry->pNext = *ppBucket;
+            *ppBucket = pEntry;
+            pEntry = pNext;
+        }
+    }
+    delete[] m_ppBuckets;
+    m_ppBuckets = ppBuckets;
+    m_dwBuckets = dwBuckets;
+    return TRUE;
+}
+
+
+//=========================================================================
+// GetStatistics
+// -------------
+//=========================================================================
+void DaStringArena::GetStatistics(DASTRINGARENASTATS* pStats)
+{
+    EnterCriticalSection(&m_CritSec);
+    pStats->dwChunks = m_dwChunks;
+    pStats->dwStrings = m_dwStrings;
+    pStats->dwInterned = m_dwInterned;
+    pStats->ullReservedBytes = (ULONGLONG)m_dwChunks * DA_STRINGARENA_CHUNK_SIZE + m_ullHeapBytes;
+    pStats->ullUsedBytes = m_ullUsedBytes;
+    LeaveCriticalSection(&m_CritSec);
+}
+//DOM-IGNORE-END
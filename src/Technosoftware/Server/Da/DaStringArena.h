@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+#ifndef __STRINGARENA_H_
+#define __STRINGARENA_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+               // Size of a chunk of the arena; must be the allocation
+               // granularity of VirtualAlloc() so that the chunk of a
+               // string can be calculated from its address
+#define  DA_STRINGARENA_CHUNK_SIZE     0x10000
+               // Strings with this or more characters are allocated
+               // from the heap
+#define  DA_STRINGARENA_MAX_LENGTH     1024
+               // Initial number of hash buckets of the interned strings.
+               // The number is doubled if there are more than two
+               // interned strings per bucket.
+#define  DA_STRINGARENA_BUCKETS        256
+
+
+               // Counters of a string arena
+typedef struct tagDASTRINGARENASTATS {
+   DWORD       dwChunks;               // allocated chunks
+   DWORD       dwStrings;              // strings allocated and not yet freed, incl. interned strings
+   DWORD       dwInterned;             // interned strings
+   ULONGLONG   ullReservedBytes;       // memory of the chunks and of the strings allocated from the heap
+   ULONGLONG   ullUsedBytes;           // memory of the strings not yet freed
+} DASTRINGARENASTATS;
+
+
+/////////////////////////////////////////////////////////////////
+// String Arena
+// ------------
+// Stores the Item IDs and Access Paths of the Device Items in
+// contiguous chunks instead of separate heap blocks.
+//
+// Strings are appended to the current chunk. The memory of a
+// freed string is not reused; a chunk is released if all of its
+// strings are freed. This fits address spaces which are mostly
+// built once; items removed and added later only use new space
+// until their chunk is empty.
+//
+// Interned strings are stored once and never freed. They are
+// used for values shared by many items like Access Paths and
+// for the branch and leaf names of the address space.
+/////////////////////////////////////////////////////////////////
+class DaStringArena {
+
+   public:
+      DaStringArena();
+      ~DaStringArena();
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns a copy of the string or NULL if out of memory.
+         //  The copy must be released with Free().
+         ///////////////////////////////////////////////////////////////
+      LPWSTR Alloc( LPCWSTR szString );
+
+         ///////////////////////////////////////////////////////////////
+         //  Releases a string returned by Alloc(). NULL is ignored.
+         ///////////////////////////////////////////////////////////////
+      void Free( LPWSTR szString );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the interned copy of the string or NULL if out of
+         //  memory. Equal strings return the same pointer. The copy
+         //  must not be freed and is valid as long as the arena.
+         ///////////////////////////////////////////////////////////////
+      LPCWSTR Intern( LPCWSTR szString );
+
+         ///////////////////////////////////////////////////////////////
+         //  Same as above for the first nLen characters of szString,
+         //  e.g. a segment of an Item ID. szString needs not to be
+         //  terminated after these characters.
+         ///////////////////////////////////////////////////////////////
+      LPCWSTR Intern( LPCWSTR szString, size_t nLen );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the counters of the arena.
+         ///////////////////////////////////////////////////////////////
+      void GetStatistics( DASTRINGARENASTATS* pStats );
+
+   private:
+      typedef struct tagCHUNK {
+         long           lStrings;         // strings not yet freed
+         DWORD          dwUsed;           // used bytes incl. this header
+      } CHUNK;
+
+      typedef struct tagINTERNED {
+         LPCWSTR        szString;
+         DWORD          dwHash;
+         struct tagINTERNED* pNext;
+      } INTERNED;
+
+      CHUNK          *m_pCurrent;         // chunk to which new strings are appended
+      INTERNED       **m_ppBuckets;       // hash table of the interned strings
+      DWORD          m_dwBuckets;
+
+      DWORD          m_dwChunks;
+      DWORD          m_dwStrings;
+      DWORD          m_dwInterned;
+      ULONGLONG      m_ullHeapBytes;      // strings allocated from the heap
+      ULONGLONG      m_ullUsedBytes;
+
+               // protects all members and the chunks
+      CRITICAL_SECTION m_CritSec;
+
+      LPWSTR AllocLocked( LPCWSTR szString, size_t nLen );
+      BOOL GrowBuckets( void );
+};
+//DOM-IGNORE-END
+
+
+#endif // __STRINGARENA_H_
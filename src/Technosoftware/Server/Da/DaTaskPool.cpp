@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+//DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include <process.h>
+#include "DaTaskPool.h"
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaTaskPool::DaTaskPool()
+{
+    m_pWorkers = nullptr;
+    m_dwWorkers = 0;
+    m_dwThreadCount = 0;
+    m_hWorkSemaphore = nullptr;
+    m_lStop = FALSE;
+    m_lNextWorker = 0;
+    m_lQueuedTasks = 0;
+    m_llExecuted = 0;
+    m_llStolen = 0;
+    m_dwTlsIndex = TlsAlloc();
+}
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+DaTaskPool::~DaTaskPool()
+{
+    Stop();
+    FreeWorkers();
+    if (m_dwTlsIndex != TLS_OUT_OF_INDEXES) {
+        TlsFree(m_dwTlsIndex);
+    }
+}
+
+
+//=================================================================================
+// Start the Worker Threads
+// ------------------------
+//=================================================================================
+HRESULT DaTaskPool::Start(DWORD dwThreadCount)
+{
+    unsigned uThreadID;                           // Thread identifier
+    DWORD    i;
+
+    _ASSERTE(m_dwThreadCount == 0);               // Already started
+
+    FreeWorkers();                                // Queues of a stopped pool
+    if (m_dwTlsIndex == TLS_OUT_OF_INDEXES) {
+        return E_FAIL;
+    }
+
+    if (dwThreadCount == 0) {                     // Two threads per processor
+        SYSTEM_INFO SysInfo;
+        GetSystemInfo(&SysInfo);
+        dwThreadCount = max(SysInfo.dwNumberOfProcessors * 2, DA_TASKPOOL_MIN_THREADS);
+    }
+
+    m_hWorkSemaphore = CreateSemaphore(nullptr, 0, LONG_MAX, nullptr);
+    if (m_hWorkSemaphore == nullptr) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_pWorkers = new WORKER[dwThreadCount];
+    if (m_pWorkers == nullptr) {
+        FreeWorkers();
+        return E_OUTOFMEMORY;
+    }
+    for (i = 0; i < dwThreadCount; i++) {
+        m_pWorkers[i].pPool = this;
+        m_pWorkers[i].dwIndex = i;
+        m_pWorkers[i].hThread = nullptr;
+        m_pWorkers[i].pQueue = nullptr;
+        m_pWorkers[i].lHead = 0;
+        m_pWorkers[i].lCount = 0;
+        m_pWorkers[i].lAlloc = 0;
+        m_pWorkers[i].fClosed = FALSE;
+        InitializeCriticalSection(&m_pWorkers[i].CritSec);
+    }
+
+    // the queues exist also if not all threads can be started
+    m_dwWorkers = dwThreadCount;
+    InterlockedExchange(&m_lStop, FALSE);
+    m_dwThreadCount = dwThreadCount;
+    for (i = 0; i < dwThreadCount; i++) {
+        m_pWorkers[i].hThread = (HANDLE)_beginthreadex(
+            nullptr,                // No thread security attributes
+            0,                      // Default stack size
+            WorkerThread,           // Pointer to thread function
+            &m_pWorkers[i],         // Pass worker to new thread
+            0,                      // Run thread immediately
+            &uThreadID);            // Thread identifier
+
+        if (m_pWorkers[i].hThread == nullptr) {   // Cannot create the thread
+            HRESULT hres = HRESULT_FROM_WIN32(GetLastError());
+            Stop();
+            return hres;
+        }
+    }
+    return S_OK;
+}
+
+
+//=================================================================================
+// Stop the Worker Threads
+// -----------------------
+//=================================================================================
+void DaTaskPool::Stop(void)
+{
+    DWORD   i;
+    TASK    Task;
+
+    if (m_pWorkers) {
+        InterlockedExchange(&m_lStop, TRUE);
+
+        // give a chance to exit to all waiting threads
+        ReleaseSemaphore(m_hWorkSemaphore, m_dwWorkers, nullptr);
+
+        for (i = 0; i < m_dwWorkers; i++) {
+            if (m_pWorkers[i].hThread == nullptr) {
+                continue;                         // Not started or already stopped
+            }
+            // Wait max 60 secs until the worker thread has terminated.
+            if (WaitForSingleObject(m_pWorkers[i].hThread, 60000) == WAIT_TIMEOUT) {
+                TerminateThread(m_pWorkers[i].hThread, 1);
+            }
+            CloseHandle(m_pWorkers[i].hThread);
+            m_pWorkers[i].hThread = nullptr;
+        }
+        m_dwThreadCount = 0;
+
+        // a Submit() which has passed the check of m_lStop fails once
+        // the queue is closed. The queued tasks own resources (e.g.
+        // attached groups) which are released only if the task is
+        // executed.
+        for (i = 0; i < m_dwWorkers; i++) {
+            EnterCriticalSection(&m_pWorkers[i].CritSec);
+            m_pWorkers[i].fClosed = TRUE;
+            LeaveCriticalSection(&m_pWorkers[i].CritSec);
+
+            while (PopFront(&m_pWorkers[i], &Task)) {
+                InterlockedDecrement(&m_lQueuedTasks);
+                Execute(Task);
+            }
+        }
+    }
+}
+
+
+//=================================================================================
+// Release the Queues
+// ------------------
+// The queues and the semaphore of a stopped pool.
+//=================================================================================
+void DaTaskPool::FreeWorkers(void)
+{
+    if (m_pWorkers) {
+        for (DWORD i = 0; i < m_dwWorkers; i++) {
+            if (m_pWorkers[i].pQueue) {
+                delete[] m_pWorkers[i].pQueue;
+            }
+            DeleteCriticalSection(&m_pWorkers[i].CritSec);
+        }
+        delete[] m_pWorkers;
+        m_pWorkers = nullptr;
+        m_dwWorkers = 0;
+    }
+
+    if (m_hWorkSemaphore) {
+        CloseHandle(m_hWorkSemaphore);
+        m_hWorkSemaphore = nullptr;
+    }
+}
+
+
+//=================================================================================
+// Queue a Task
+// ------------
+//=================================================================================
+HRESULT DaTaskPool::Submit(DATASKPROC pfnTask, void* pContext)
+{
+    _ASSERTE(pfnTask);
+
+    WORKER*     pWorker;
+    TASK        Task;
+    HRESULT     hres;
+
+    Task.pfnTask = pfnTask;
+    Task.pContext = pContext;
+
+    // without a pool wide lock; PushBack() fails if Stop() has
+    // closed the queue in the meantime
+    if (InterlockedCompareExchange(&m_lStop, FALSE, FALSE) || m_pWorkers == nullptr) {
+        return E_FAIL;
+    }
+
+    // a task queued by a worker is handled by the same worker
+    // unless it's stolen by an idle worker
+    pWorker = static_cast<WORKER*>(TlsGetValue(m_dwTlsIndex));
+    if (pWorker == nullptr || pWorker->pPool != this) {
+        pWorker = &m_pWorkers[(DWORD)InterlockedIncrement(&m_lNextWorker) % m_dwWorkers];
+    }
+    hres = PushBack(pWorker, Task);
+
+    if (SUCCEEDED(hres)) {
+        InterlockedIncrement(&m_lQueuedTasks);
+        ReleaseSemaphore(m_hWorkSemaphore, 1, nullptr);
+    }
+    return hres;
+}
+
+
+//=================================================================================
+// GetStatistics
+// -------------
+//=================================================================================
+void DaTaskPool::GetStatistics(DATASKPOOLSTATS* pStats)
+{
+    pStats->dwThreadCount = m_dwThreadCount;
+    pStats->dwQueuedTasks = (DWORD)max(m_lQueuedTasks, 0);
+    pStats->ullExecuted = (ULONGLONG)InterlockedCompareExchange64(&m_llExecuted, 0, 0);
+    pStats->ullStolen = (ULONGLONG)InterlockedCompareExchange64(&m_llStolen, 0, 0);
+}
+
+
+//=================================================================================
+// Worker Thread
+// -------------
+//=================================================================================
+unsigned __stdcall DaTaskPool::WorkerThread(void* pArg)
+{
+    WORKER* pSelf = static_cast<WORKER *>(pArg);
+    _ASSERTE(pSelf != NULL);
+
+    DaTaskPool* pPool = pSelf->pPool;
+    TASK        Task;
+    BOOL        fTaken;
+
+    TlsSetValue(pPool->m_dwTlsIndex, pSelf);
+
+    for (;;) {
+        WaitForSingleObject(pPool->m_hWorkSemaphore, INFINITE);
+
+        if (pPool->m_lStop) {
+            break;
+        }
+        // each signal belongs to a queued task, but the task may be
+        // in a queue which was already scanned while it was queued
+        fTaken = FALSE;
+        while (!pPool->m_lStop && !(fTaken = pPool->Take(pSelf, &Task))) {
+            SwitchToThread();
+        }
+        if (!fTaken) {
+            break;                                // left for Stop()
+        }
+        pPool->Execute(Task);
+    }
+
+    TlsSetValue(pPool->m_dwTlsIndex, nullptr);
+    _endthreadex(0);
+    return 0;
+
+} // WorkerThread
+
+
+//=================================================================================
+// Take the next Task
+// ------------------
+// Takes the oldest task of the own queue or steals the newest task of
+// another queue.
+//=================================================================================
+BOOL DaTaskPool::Take(WORKER* pSelf, TASK* pTask)
+{
+    DWORD   i;
+
+    if (PopFront(pSelf, pTask)) {
+        InterlockedDecrement(&m_lQueuedTasks);
+        return TRUE;
+    }
+    for (i = 1; i < m_dwThreadCount; i++) {
+        if (PopBack(&m_pWorkers[(pSelf->dwIndex + i) % m_dwThreadCount], pTask)) {
+            InterlockedDecrement(&m_lQueuedTasks);
+            InterlockedIncrement64(&m_llStolen);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+
+//=================================================================================
+// Execute a Task
+// --------------
+//=================================================================================
+void DaTaskPool::Execute(const TASK& Task)
+{
+    Task.pfnTask(Task.pContext);
+    InterlockedIncrement64(&m_llExecuted);
+}
+
+
+//=================================================================================
+// Insert a Task at the End of a Queue
+// -----------------------------------
+//=================================================================================
+HRESULT DaTaskPool::PushBack(WORKER* pWorker, const TASK& Task)
+{
+    HRESULT hres = S_OK;
+
+    EnterCriticalSection(&pWorker->CritSec);
+    if (pWorker->fClosed) {
+        hres = E_FAIL;                            // Pool stopped
+    }
+    else if (pWorker->lCount == pWorker->lAlloc) {
+        long lNewAlloc = pWorker->lAlloc ? pWorker->lAlloc * 2 : 64;
+        TASK* pNew = new TASK[lNewAlloc];
+        if (pNew == nullptr) {
+            hres = E_OUTOFMEMORY;
+        }
+        else {
+            for (long i = 0; i < pWorker->lCount; i++) {     // unwrap the ring buffer
+                pNew[i] = pWorker->pQueue[(pWorker->lHead + i) % pWorker->lAlloc];
+            }
+            if (pWorker->pQueue) {
+                delete[] pWorker->pQueue;
+            }
+            pWorker->pQueue = pNew;
+            pWorker->lAlloc = lNewAlloc;
+            pWorker->lHead = 0;
+        }
+    }
+    if (SUCCEEDED(hres)) {
+        pWorker->pQueue[(pWorker->lHead + pWorker->lCount) % pWorker->lAlloc] = Task;
+        pWorker->lCount++;
+    }
+    LeaveCriticalSection(&pWorker->CritSec);
+    return hres;
+}
+
+
+//=================================================================================
+// Remove the oldest Task of a Queue
+// ---------------------------------
+//=================================================================================
+BOOL DaTaskPool::PopFront(WORKER* pWorker, TASK* pTask)
+{
+    BOOL fTaken = FALSE;
+
+    EnterCriticalSection(&pWorker->CritSec);
+    if (pWorker->lCount > 0) {
+        *pTask = pWorker->pQueue[pWorker->lHead];
+        pWorker->lHead = (pWorker->lHead + 1) % pWorker->lAlloc;
+        pWorker->lCount--;
+        fTaken = TRUE;
+    }
+    LeaveCriticalSection(&pWorker->CritSec);
+    return fTaken;
+}
+
+
+//=================================================================================
+// Remove the newest Task of a Queue
+// ---------------------------------
+//=================================================================================
+BOOL DaTaskPool::PopBack(WORKER* pWorker, TASK* pTask)
+{
+    BOOL fTaken = FALSE;
+
+    EnterCriticalSection(&pWorker->CritSec);
+    if (pWorker->lCount > 0) {
+        pWorker->lCount--;
+        *pTask = pWorker->pQueue[(pWorker->lHead + pWorker->lCount) % pWorker->lAlloc];
+        fTaken = TRUE;
+    }
+    LeaveCriticalSection(&pWorker->CritSec);
+    return fTaken;
+}
+//DOM-IGNORE-END
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __TASKPOOL_H_
+#define __TASKPOOL_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+               // Minimum number of worker threads if the number of
+               // threads is calculated from the number of processors
+#define  DA_TASKPOOL_MIN_THREADS    4
+
+               // Task procedure, same signature as a thread procedure.
+               // The return value is ignored.
+typedef unsigned (__stdcall *DATASKPROC)( void* pContext );
+
+
+               // Counters of a task pool
+typedef struct tagDATASKPOOLSTATS {
+   DWORD       dwThreadCount;          // number of worker threads
+   DWORD       dwQueuedTasks;          // tasks waiting for a worker thread
+   ULONGLONG   ullExecuted;            // executed tasks
+   ULONGLONG   ullStolen;              // tasks executed by another worker than the queuing one
+} DATASKPOOLSTATS;
+
+
+/////////////////////////////////////////////////////////////////
+// Task Pool
+// ---------
+// Bounded number of worker threads which execute the asynchronous
+// transactions (read, write, refresh) of all server instances
+// (clients) of a server class handler.
+//
+// Each worker has its own queue. Tasks submitted by a client
+// thread are distributed round robin to the queues; tasks
+// submitted by a worker are queued to its own queue. A worker
+// handles the tasks of its own queue in submission order and
+// steals the most recently queued task of another queue if its
+// own queue is empty, so that a worker blocked by a slow device
+// or client doesn't delay the tasks queued behind it.
+//
+// A queued task cannot be removed. If all workers are blocked the
+// queued tasks wait, also canceled transactions (see
+// DataCallbackThread::CheckCancelRequestAndKillFlag()).
+//
+// Submit() locks only the queue of the target worker, so client
+// threads don't serialize on a pool wide lock.
+/////////////////////////////////////////////////////////////////
+class DaTaskPool {
+
+   public:
+         ///////////////////////////////////////////////////////////////
+         //   Constructor / Destructor
+         ///////////////////////////////////////////////////////////////
+      DaTaskPool();
+      ~DaTaskPool();
+
+         ///////////////////////////////////////////////////////////////
+         //  Starts the worker threads.
+         //  If dwThreadCount is 0 then two threads per processor but
+         //  at least DA_TASKPOOL_MIN_THREADS are started.
+         ///////////////////////////////////////////////////////////////
+      HRESULT Start( DWORD dwThreadCount );
+
+         ///////////////////////////////////////////////////////////////
+         //  Stops the worker threads. The tasks which are still queued
+         //  are executed by the calling thread. The queues are kept
+         //  until the pool is started again or destroyed, so that a
+         //  concurrent Submit() fails instead of accessing them.
+         ///////////////////////////////////////////////////////////////
+      void Stop( void );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the number of running worker threads.
+         ///////////////////////////////////////////////////////////////
+      DWORD GetThreadCount( void ) { return m_dwThreadCount; }
+
+         ///////////////////////////////////////////////////////////////
+         //  Queues a task. Returns E_FAIL if the pool is not running
+         //  or E_OUTOFMEMORY; in this case the task is not executed.
+         ///////////////////////////////////////////////////////////////
+      HRESULT Submit( DATASKPROC pfnTask, void* pContext );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the counters of the pool.
+         ///////////////////////////////////////////////////////////////
+      void GetStatistics( DATASKPOOLSTATS* pStats );
+
+   private:
+      typedef struct tagTASK {
+         DATASKPROC     pfnTask;
+         void*          pContext;
+      } TASK;
+
+      typedef struct tagWORKER {
+         DaTaskPool*    pPool;
+         DWORD          dwIndex;
+         HANDLE         hThread;
+         TASK           *pQueue;          // ring buffer of the queued tasks
+         long           lHead;            // index of the next task to handle
+         long           lCount;           // number of queued tasks
+         long           lAlloc;           // allocated entries of the ring buffer
+         BOOL           fClosed;          // set by Stop(), no more tasks are queued
+               // protects the queue. No other critical section
+               // is entered while owning this critical section.
+         CRITICAL_SECTION CritSec;
+      } WORKER;
+
+      WORKER         *m_pWorkers;
+      DWORD          m_dwWorkers;         // number of queues in m_pWorkers
+      DWORD          m_dwThreadCount;     // number of running worker threads
+
+      HANDLE         m_hWorkSemaphore;    // signaled once for each queued task
+      volatile LONG  m_lStop;             // TRUE tells the worker threads to terminate
+      volatile LONG  m_lNextWorker;       // round robin index for tasks of client threads
+      volatile LONG  m_lQueuedTasks;
+      volatile LONGLONG m_llExecuted;
+      volatile LONGLONG m_llStolen;
+
+      DWORD          m_dwTlsIndex;        // WORKER of the current worker thread
+
+      static unsigned __stdcall WorkerThread( void* pArg );
+
+      void FreeWorkers( void );
+
+      BOOL Take( WORKER* pSelf, TASK* pTask );
+      void Execute( const TASK& Task );
+      static HRESULT PushBack( WORKER* pWorker, const TASK& Task );
+      static BOOL PopFront( WORKER* pWorker, TASK* pTask );
+      static BOOL PopBack( WORKER* pWorker, TASK* pTask );
+};
+//DOM-IGNORE-END
+
+
+#endif // __TASKPOOL_H_
@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+ //DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include <process.h>
+#include "DaUpdatePool.h"
+#include "DaGenericServer.h"
+#include "DaGenericGroup.h"
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaUpdatePool::DaUpdatePool()
+{
+    m_pQueue = nullptr;
+    m_lHead = 0;
+    m_lCount = 0;
+    m_lAlloc = 0;
+
+    m_phThreads = nullptr;
+    m_dwThreadCount = 0;
+    m_hWorkSemaphore = nullptr;
+    m_fStop = FALSE;
+
+    LARGE_INTEGER liFrequency;
+    QueryPerformanceFrequency(&liFrequency);
+    m_llFrequency = liFrequency.QuadPart ? liFrequency.QuadPart : 1;
+    m_llBusyCounts = 0;
+
+    InitializeCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+DaUpdatePool::~DaUpdatePool()
+{
+    Stop();
+    DeleteCriticalSection(&m_CritSec);
+}
+
+
+//=================================================================================
+// Start the Worker Threads
+// ------------------------
+//=================================================================================
+HRESULT DaUpdatePool::Start(DWORD dwThreadCount)
+{
+    unsigned uThreadID;                           // Thread identifier
+
+    _ASSERTE(m_phThreads == nullptr);             // Already started
+
+    if (dwThreadCount == 0) {                     // One thread per processor
+        SYSTEM_INFO SysInfo;
+        GetSystemInfo(&SysInfo);
+        dwThreadCount = SysInfo.dwNumberOfProcessors ? SysInfo.dwNumberOfProcessors : 1;
+    }
+
+    m_hWorkSemaphore = CreateSemaphore(nullptr, 0, LONG_MAX, nullptr);
+    if (m_hWorkSemaphore == nullptr) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_phThreads = new HANDLE[dwThreadCount];
+    if (m_phThreads == nullptr) {
+        Stop();
+        return E_OUTOFMEMORY;
+    }
+
+    m_fStop = FALSE;
+    for (m_dwThreadCount = 0; m_dwThreadCount < dwThreadCount; m_dwThreadCount++) {
+        m_phThreads[m_dwThreadCount] = (HANDLE)_beginthreadex(
+            nullptr,                // No thread security attributes
+            0,                      // Default stack size
+            WorkerThread,           // Pointer to thread function
+            this,                   // Pass class to new thread
+            0,                      // Run thread immediately
+            &uThreadID);            // Thread identifier
+
+        if (m_phThreads[m_dwThreadCount] == nullptr) {    // Cannot create the thread
+            HRESULT hres = HRESULT_FROM_WIN32(GetLastError());
+            Stop();
+            return hres;
+        }
+    }
+    return S_OK;
+}
+
+
+//=================================================================================
+// Stop the Worker Threads
+// -----------------------
+//=================================================================================
+void DaUpdatePool::Stop(void)
+{
+    DWORD       i;
+    WORKITEM    Work;
+
+    if (m_phThreads) {
+        EnterCriticalSection(&m_CritSec);
+        m_fStop = TRUE;
+        LeaveCriticalSection(&m_CritSec);
+
+        // give a chance to exit to all waiting threads
+        ReleaseSemaphore(m_hWorkSemaphore, m_dwThreadCount, nullptr);
+
+        for (i = 0; i < m_dwThreadCount; i++) {
+            // Wait max 60 secs until the worker thread has terminated.
+            if (WaitForSingleObject(m_phThreads[i], 60000) == WAIT_TIMEOUT) {
+                TerminateThread(m_phThreads[i], 1);
+            }
+            CloseHandle(m_phThreads[i]);
+        }
+        delete[] m_phThreads;
+        m_phThreads = nullptr;
+        m_dwThreadCount = 0;
+    }
+
+    // release the groups which have not been handled
+    while (Pop(&Work)) {
+        InterlockedExchange(&Work.pGroup->m_lPendingTimers, 0);
+        ReleaseGroup(Work);
+    }
+
+    if (m_pQueue) {
+        delete[] m_pQueue;
+        m_pQueue = nullptr;
+        m_lAlloc = 0;
+    }
+    if (m_hWorkSemaphore) {
+        CloseHandle(m_hWorkSemaphore);
+        m_hWorkSemaphore = nullptr;
+    }
+}
+
+
+//=================================================================================
+// Queue a Group with an expired Timer
+// -----------------------------------
+//=================================================================================
+void DaUpdatePool::QueueGroup(DaGenericServer* pServer, DaGenericGroup* pGroup, DWORD dwKind)
+{
+    _ASSERTE(dwKind < DA_TIMER_KINDS);
+
+    WORKITEM    Work;
+    LONG        lOld;
+    HRESULT     hres;
+
+    Work.pServer = pServer;
+    Work.pGroup = pGroup;
+
+    lOld = InterlockedOr(&pGroup->m_lPendingTimers, (1L << dwKind) | DA_TIMER_QUEUED);
+    if (lOld & DA_TIMER_QUEUED) {
+        // the group is already queued or handled by a worker thread
+        // which also handles the new timer
+        ReleaseGroup(Work);
+        return;
+    }
+
+    EnterCriticalSection(&m_CritSec);
+    hres = m_fStop || m_phThreads == nullptr ? E_FAIL : Push(Work);
+    LeaveCriticalSection(&m_CritSec);
+
+    if (SUCCEEDED(hres)) {
+        ReleaseSemaphore(m_hWorkSemaphore, 1, nullptr);
+    }
+    else {
+        // do not lose the timer, the group would never be updated again
+        HandleGroup(Work);
+    }
+}
+
+
+//=================================================================================
+// Worker Thread
+// -------------
+//=================================================================================
+unsigned __stdcall DaUpdatePool::WorkerThread(void* pArg)
+{
+    DaUpdatePool* pPool = static_cast<DaUpdatePool *>(pArg);
+    _ASSERTE(pPool != NULL);
+
+    WORKITEM    Work;
+    BOOL        fWork;
+
+    for (;;) {
+        WaitForSingleObject(pPool->m_hWorkSemaphore, INFINITE);
+
+        EnterCriticalSection(&pPool->m_CritSec);
+        if (pPool->m_fStop) {
+            LeaveCriticalSection(&pPool->m_CritSec);
+            break;
+        }
+        fWork = pPool->Pop(&Work);
+        LeaveCriticalSection(&pPool->m_CritSec);
+
+        if (fWork) {
+            pPool->HandleGroup(Work);
+        }
+    }
+
+    _endthreadex(0);
+    return 0;
+
+} // WorkerThread
+
+
+//=================================================================================
+// Load of the Worker Threads
+// --------------------------
+//=================================================================================
+void DaUpdatePool::TakeLoad(DWORD* pdwBusyTime, DWORD* pdwBacklog)
+{
+    LONGLONG llBusy = InterlockedExchange64(&m_llBusyCounts, 0);
+    *pdwBusyTime = (DWORD)min(llBusy * 1000 / m_llFrequency, (LONGLONG)MAXDWORD);
+
+    EnterCriticalSection(&m_CritSec);
+    *pdwBacklog = (DWORD)m_lCount;
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=================================================================================
+// Handle a queued Group
+// ---------------------
+// Handles the due timers of the group until no more timers are pending.
+// The time spent is added to the busy time of the pool.
+//=================================================================================
+void DaUpdatePool::HandleGroup(const WORKITEM& Work)
+{
+    LONG            lPending;
+    DWORD           dwKind;
+    ULONGLONG       ullTick;
+    LARGE_INTEGER   liStart, liEnd;
+
+    QueryPerformanceCounter(&liStart);
+    for (;;) {
+        // take the due timers, the group remains marked as queued
+        lPending = InterlockedAnd(&Work.pGroup->m_lPendingTimers, DA_TIMER_QUEUED);
+
+        if ((Work.pServer->Killed() == FALSE) && (Work.pGroup->Killed() == FALSE)) {
+            ullTick = Work.pServer->m_Scheduler.GetCurrentTick();
+            for (dwKind = 0; dwKind < DA_TIMER_KINDS; dwKind++) {
+                if (lPending & (1L << dwKind)) {
+                    Work.pServer->HandleGroupTimer(Work.pGroup, dwKind, ullTick);
+                }
+            }
+        }
+
+        // done if no timer has expired meanwhile
+        if (InterlockedCompareExchange(&Work.pGroup->m_lPendingTimers, 0, DA_TIMER_QUEUED) == DA_TIMER_QUEUED) {
+            break;
+        }
+    }
+    ReleaseGroup(Work);
+
+    QueryPerformanceCounter(&liEnd);
+    InterlockedExchangeAdd64(&m_llBusyCounts, liEnd.QuadPart - liStart.QuadPart);
+}
+
+
+//=================================================================================
+// Release a queued Group
+// ----------------------
+// Unnails the group and detaches the server.
+//=================================================================================
+void DaUpdatePool::ReleaseGroup(const WORKITEM& Work)
+{
+    Work.pServer->ReleaseGenericGroup(Work.pGroup->m_hServerGroupHandle);
+    Work.pServer->Detach();
+}
+
+
+//=================================================================================
+// Insert a Group into the Queue
+// -----------------------------
+// Must be called within m_CritSec.
+//=================================================================================
+HRESULT DaUpdatePool::Push(const WORKITEM& Work)
+{
+    if (m_lCount == m_lAlloc) {
+        long lNewAlloc = m_lAlloc ? m_lAlloc * 2 : 64;
+        WORKITEM* pNew = new WORKITEM[lNewAlloc];
+        if (pNew == nullptr) {
+            return E_OUTOFMEMORY;
+        }
+        for (long i = 0; i < m_lCount; i++) {     // unwrap the ring buffer
+            pNew[i] = m_pQueue[(m_lHead + i) % m_lAlloc];
+        }
+        if (m_pQueue) {
+            delete[] m_pQueue;
+        }
+        m_pQueue = pNew;
+        m_lAlloc = lNewAlloc;
+        m_lHead = 0;
+    }
+    m_pQueue[(m_lHead + m_lCount) % m_lAlloc] = Work;
+    m_lCount++;
+    return S_OK;
+}
+
+
+//=================================================================================
+// Remove the next Group from the Queue
+// ------------------------------------
+// Must be called within m_CritSec or if no worker thread is running.
+//=================================================================================
+BOOL DaUpdatePool::Pop(WORKITEM* pWork)
+{
+    if (m_lCount == 0) {
+        return FALSE;
+    }
+    *pWork = m_pQueue[m_lHead];
+    m_lHead = (m_lHead + 1) % m_lAlloc;
+    m_lCount--;
+    return TRUE;
+}
+//DOM-IGNORE-END
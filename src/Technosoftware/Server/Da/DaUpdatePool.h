@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __UPDATEPOOL_H_
+#define __UPDATEPOOL_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+#include "DaUpdateScheduler.h"
+
+               // Flag in DaGenericGroup::m_lPendingTimers which is set
+               // while the group is queued or handled by a worker thread.
+               // The other bits are the due timer kinds (1 << kind).
+#define  DA_TIMER_QUEUED      0x00000100L
+
+class DaGenericServer;
+class DaGenericGroup;
+
+
+/////////////////////////////////////////////////////////////////
+// Update Worker Pool
+// ------------------
+// Fixed number of worker threads shared by all server instances
+// (clients) of a server class handler. The server class handler
+// queues the groups with an expired update or keep-alive timer
+// with each base update tick and the workers send the callbacks
+// to the clients.
+//
+// The number of threads does not depend on the number of
+// connected clients. A group is never handled by more than one
+// worker at a time; timers which expire while the group is
+// queued or handled are merged and handled by the same worker
+// after the current ones.
+/////////////////////////////////////////////////////////////////
+class DaUpdatePool {
+
+   public:
+         ///////////////////////////////////////////////////////////////
+         //   Constructor / Destructor
+         ///////////////////////////////////////////////////////////////
+      DaUpdatePool();
+      ~DaUpdatePool();
+
+         ///////////////////////////////////////////////////////////////
+         //  Starts the worker threads.
+         //  If dwThreadCount is 0 then one thread per processor
+         //  is started.
+         ///////////////////////////////////////////////////////////////
+      HRESULT Start( DWORD dwThreadCount );
+
+         ///////////////////////////////////////////////////////////////
+         //  Stops the worker threads and releases the groups which
+         //  are still queued.
+         ///////////////////////////////////////////////////////////////
+      void Stop( void );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the number of running worker threads.
+         ///////////////////////////////////////////////////////////////
+      DWORD GetThreadCount( void ) { return m_dwThreadCount; }
+
+         ///////////////////////////////////////////////////////////////
+         //  Queues a group with an expired timer of the specified kind.
+         //  The group must be nailed and the server attached by the
+         //  caller. The pool unnails the group and detaches the server
+         //  when the group has been handled.
+         //  If the group cannot be queued it's handled by the
+         //  calling thread.
+         ///////////////////////////////////////////////////////////////
+      void QueueGroup( DaGenericServer* pServer, DaGenericGroup* pGroup, DWORD dwKind );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the time in ms the worker threads spent handling
+         //  groups since the previous call (sum of all threads) and
+         //  the number of groups which are queued but not yet handled.
+         ///////////////////////////////////////////////////////////////
+      void TakeLoad( DWORD* pdwBusyTime, DWORD* pdwBacklog );
+
+   private:
+      typedef struct tagWORKITEM {
+         DaGenericServer*  pServer;
+         DaGenericGroup*   pGroup;
+      } WORKITEM;
+
+      WORKITEM       *m_pQueue;           // ring buffer of the queued groups
+      long           m_lHead;             // index of the next group to handle
+      long           m_lCount;            // number of queued groups
+      long           m_lAlloc;            // allocated entries of the ring buffer
+
+      HANDLE         *m_phThreads;        // handles of the worker threads
+      DWORD          m_dwThreadCount;     // number of worker threads
+
+      HANDLE         m_hWorkSemaphore;    // signaled once for each queued group
+      BOOL           m_fStop;             // tells the worker threads to terminate
+
+      volatile LONGLONG m_llBusyCounts;   // performance counter ticks spent handling groups
+      LONGLONG       m_llFrequency;       // performance counter ticks per second
+
+               // protects the queue and m_fStop. No other critical section
+               // is entered while owning this critical section.
+      CRITICAL_SECTION m_CritSec;
+
+      static unsigned __stdcall WorkerThread( void* pArg );
+
+      HRESULT Push( const WORKITEM& Work );
+      BOOL Pop( WORKITEM* pWork );
+      void HandleGroup( const WORKITEM& Work );
+      void ReleaseGroup( const WORKITEM& Work );
+};
+//DOM-IGNORE-END
+
+
+#endif // __UPDATEPOOL_H_
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __UPDATESCHEDULER_H_
+#define __UPDATESCHEDULER_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+#include "openarray.h"
+
+               // Timer kinds of a group
+#define  DA_TIMER_UPDATE      0     // data change callback is due
+#define  DA_TIMER_KEEPALIVE   1     // keep-alive callback is due
+#define  DA_TIMER_KINDS       2
+
+
+/////////////////////////////////////////////////////////////////
+// Update Scheduler
+// ----------------
+// Min-heap of group timers keyed on the base update tick at which
+// they are due. The update thread only handles the groups which are
+// actually due instead of walking all groups with every tick.
+//
+// Each group (identified by its server group handle) has at most
+// one timer of each kind. The timer states and heap entries refer
+// to the slot of the handle (DaHandleIndex()); the handle of the
+// group which set the timer is returned when it expires. A timer
+// is a one-shot timer and must be set again after it has expired.
+//
+// Moving a timer to a later tick does not touch the heap; the entry
+// is re-inserted with the new tick when the old tick is reached.
+// Moving a timer to an earlier tick inserts a new entry and the old
+// entry is ignored when it reaches the top of the heap.
+//
+// All functions are thread safe. No other critical section is
+// entered while the internal critical section is owned.
+/////////////////////////////////////////////////////////////////
+class DaUpdateScheduler {
+
+   private:
+      typedef struct tagHEAPENTRY {
+         ULONGLONG   ullDueTick;
+         long        lIndex;              // slot of the group handle
+         DWORD       dwKind;
+      } HEAPENTRY;
+
+      typedef struct tagTIMERSTATE {
+         long        hGroup;                           // group which set the last timer
+         ULONGLONG   ullDueTick[ DA_TIMER_KINDS ];     // 0 if the timer is not set
+         ULONGLONG   ullQueuedTick[ DA_TIMER_KINDS ];  // tick of the valid heap entry, 0 if none
+      } TIMERSTATE;
+
+      HEAPENTRY      *m_pHeap;            // the heap with the earliest tick on top
+      long           m_lHeapSize;         // number of entries in the heap
+      long           m_lHeapAlloc;        // allocated heap entries
+
+      TIMERSTATE     *m_pTimers;          // timer states indexed by the slot of the group handle
+      long           m_lTimersAlloc;      // allocated timer states
+
+      ULONGLONG      m_ullCurrentTick;    // number of base update ticks handled so far
+
+      CRITICAL_SECTION m_CritSec;
+
+   public:
+
+         ///////////////////////////////////////////////////////////////
+         //   Constructor
+         ///////////////////////////////////////////////////////////////
+      DaUpdateScheduler() {
+         m_pHeap           = NULL;
+         m_lHeapSize       = 0;
+         m_lHeapAlloc      = 0;
+         m_pTimers         = NULL;
+         m_lTimersAlloc    = 0;
+         m_ullCurrentTick  = 0;
+         InitializeCriticalSection( &m_CritSec );
+      }
+
+         ///////////////////////////////////////////////////////////////
+         //   Destructor
+         ///////////////////////////////////////////////////////////////
+      ~DaUpdateScheduler() {
+         if (m_pHeap) {
+            delete [] m_pHeap;
+         }
+         if (m_pTimers) {
+            delete [] m_pTimers;
+         }
+         DeleteCriticalSection( &m_CritSec );
+      }
+
+
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the number of base update ticks handled so far.
+         ///////////////////////////////////////////////////////////////
+      ULONGLONG GetCurrentTick( void )
+      {
+         EnterCriticalSection( &m_CritSec );
+         ULONGLONG ullTick = m_ullCurrentTick;
+         LeaveCriticalSection( &m_CritSec );
+         return ullTick;
+      }
+
+
+
+         ///////////////////////////////////////////////////////////////
+         //  Starts the next base update tick and returns it.
+         ///////////////////////////////////////////////////////////////
+      ULONGLONG NextTick( void )
+      {
+         EnterCriticalSection( &m_CritSec );
+         ULONGLONG ullTick = ++m_ullCurrentTick;
+         LeaveCriticalSection( &m_CritSec );
+         return ullTick;
+      }
+
+
+
+         ///////////////////////////////////////////////////////////////
+         //  Sets the timer of the specified kind for a group.
+         //  A timer which is already set is replaced.
+         ///////////////////////////////////////////////////////////////
+      HRESULT SetTimer( long hGroup, DWORD dwKind, ULONGLONG ullDueTick )
+      {
+         _ASSERTE( hGroup > 0 );
+         _ASSERTE( dwKind < DA_TIMER_KINDS );
+         _ASSERTE( ullDueTick > 0 );
+
+         HRESULT hr = S_OK;
+         long    lIndex = DaHandleIndex( hGroup );
+
+         EnterCriticalSection( &m_CritSec );
+
+         if (lIndex >= m_lTimersAlloc) {
+            hr = GrowTimers( lIndex );
+         }
+         if (SUCCEEDED( hr )) {
+            TIMERSTATE& Timer = m_pTimers[ lIndex ];
+            Timer.hGroup = hGroup;
+            Timer.ullDueTick[ dwKind ] = ullDueTick;
+
+            if (Timer.ullQueuedTick[ dwKind ] == 0 ||
+                Timer.ullQueuedTick[ dwKind ] > ullDueTick) {
+                                                // There is no heap entry or the entry
+                                                // is too late; insert a new entry.
+               hr = Push( ullDueTick, lIndex, dwKind );
+               if (SUCCEEDED( hr )) {
+                  Timer.ullQueuedTick[ dwKind ] = ullDueTick;
+               }
+            }
+         }
+
+         LeaveCriticalSection( &m_CritSec );
+         return hr;
+      }
+
+
+
+         ///////////////////////////////////////////////////////////////
+         //  Cancels the timer of the specified kind for a group.
+         ///////////////////////////////////////////////////////////////
+      void CancelTimer( long hGroup, DWORD dwKind )
+      {
+         _ASSERTE( dwKind < DA_TIMER_KINDS );
+
+         long lIndex = DaHandleIndex( hGroup );
+
+         EnterCriticalSection( &m_CritSec );
+         if (hGroup > 0 && lIndex < m_lTimersAlloc && m_pTimers[ lIndex ].hGroup == hGroup) {
+            m_pTimers[ lIndex ].ullDueTick[ dwKind ] = 0;
+         }
+         LeaveCriticalSection( &m_CritSec );
+      }
+
+
+
+         ///////////////////////////////////////////////////////////////
+         //  Cancels all timers of a group.
+         ///////////////////////////////////////////////////////////////
+      void CancelTimers( long hGroup )
+      {
+         for (DWORD dwKind = 0; dwKind < DA_TIMER_KINDS; dwKind++) {
+            CancelTimer( hGroup, dwKind );
+         }
+      }
+
+
+
+         ///////////////////////////////////////////////////////////////
+         //  Removes the next expired timer.
+         //  Returns FALSE if there is no timer due at the current tick.
+         ///////////////////////////////////////////////////////////////
+      BOOL PopExpired( long* phGroup, DWORD* pdwKind )
+      {
+         BOOL fExpired = FALSE;
+
+         EnterCriticalSection( &m_CritSec );
+
+         while (m_lHeapSize > 0 && m_pHeap[0].ullDueTick <= m_ullCurrentTick) {
+
+            HEAPENTRY   Entry = m_pHeap[0];
+            Pop();
+
+            TIMERSTATE& Timer = m_pTimers[ Entry.lIndex ];
+            if (Timer.ullQueuedTick[ Entry.dwKind ] != Entry.ullDueTick) {
+               continue;                        // replaced by an earlier entry
+            }
+            Timer.ullQueuedTick[ Entry.dwKind ] = 0;
+
+            ULONGLONG ullDueTick = Timer.ullDueTick[ Entry.dwKind ];
+            if (ullDueTick == 0) {
+               continue;                        // cancelled
+            }
+            if (ullDueTick > m_ullCurrentTick) {
+                                                // moved to a later tick
+               if (SUCCEEDED( Push( ullDueTick, Entry.lIndex, Entry.dwKind ) )) {
+                  Timer.ullQueuedTick[ Entry.dwKind ] = ullDueTick;
+                  continue;
+               }
+                                                // cannot re-insert, fire now
+            }
+            Timer.ullDueTick[ Entry.dwKind ] = 0;   // one-shot timer
+            *phGroup = Timer.hGroup;
+            *pdwKind = Entry.dwKind;
+            fExpired = TRUE;
+            break;
+         }
+
+         LeaveCriticalSection( &m_CritSec );
+         return fExpired;
+      }
+
+   private:
+
+         ///////////////////////////////////////////////////////////////
+         //  Enlarges the timer state array so that lIndex is valid.
+         ///////////////////////////////////////////////////////////////
+      HRESULT GrowTimers( long lIndex )
+      {
+         long lNewAlloc = m_lTimersAlloc ? m_lTimersAlloc : 16;
+         while (lIndex >= lNewAlloc) {
+            lNewAlloc *= 2;
+         }
+         TIMERSTATE* pNew = new TIMERSTATE[ lNewAlloc ];
+         if (pNew == NULL) {
+            return E_OUTOFMEMORY;
+         }
+         memset( pNew, 0, lNewAlloc * sizeof (TIMERSTATE) );
+         if (m_pTimers) {
+            memcpy( pNew, m_pTimers, m_lTimersAlloc * sizeof (TIMERSTATE) );
+            delete [] m_pTimers;
+         }
+         m_pTimers      = pNew;
+         m_lTimersAlloc = lNewAlloc;
+         return S_OK;
+      }
+
+         ///////////////////////////////////////////////////////////////
+         //  Inserts an entry into the heap.
+         ///////////////////////////////////////////////////////////////
+      HRESULT Push( ULONGLONG ullDueTick, long lIndex, DWORD dwKind )
+      {
+         if (m_lHeapSize == m_lHeapAlloc) {
+            long lNewAlloc = m_lHeapAlloc ? m_lHeapAlloc * 2 : 16;
+            HEAPENTRY* pNew = new HEAPENTRY[ lNewAlloc ];
+            if (pNew == NULL) {
+               return E_OUTOFMEMORY;
+            }
+            if (m_pHeap) {
+               memcpy( pNew, m_pHeap, m_lHeapSize * sizeof (HEAPENTRY) );
+               delete [] m_pHeap;
+            }
+            m_pHeap      = pNew;
+            m_lHeapAlloc = lNewAlloc;
+         }
+
+         long i = m_lHeapSize++;                // sift up
+         while (i > 0) {
+            long lParent = (i - 1) / 2;
+            if (m_pHeap[ lParent ].ullDueTick <= ullDueTick) {
+               break;
+            }
+            m_pHeap[i] = m_pHeap[ lParent ];
+            i = lParent;
+         }
+         m_pHeap[i].ullDueTick = ullDueTick;
+         m_pHeap[i].lIndex     = lIndex;
+         m_pHeap[i].dwKind     = dwKind;
+         return S_OK;
+      }
+
+         ///////////////////////////////////////////////////////////////
+         //  Removes the top entry from the heap.
+         ///////////////////////////////////////////////////////////////
+      void Pop( void )
+      {
+         _ASSERTE( m_lHeapSize > 0 );
+
+         HEAPENTRY Last = m_pHeap[ --m_lHeapSize ];
+         long i = 0;                            // sift down
+         for (;;) {
+            long lChild = 2 * i + 1;
+            if (lChild >= m_lHeapSize) {
+               break;
+            }
+            if (lChild + 1 < m_lHeapSize &&
+                m_pHeap[ lChild + 1 ].ullDueTick < m_pHeap[ lChild ].ullDueTick) {
+               lChild++;
+            }
+            if (Last.ullDueTick <= m_pHeap[ lChild ].ullDueTick) {
+               break;
+            }
+            m_pHeap[i] = m_pHeap[ lChild ];
+            i = lChild;
+         }
+         if (m_lHeapSize > 0) {
+            m_pHeap[i] = Last;
+         }
+      }
+};
+//DOM-IGNORE-END
+
+
+#endif // __UPDATESCHEDULER_H_
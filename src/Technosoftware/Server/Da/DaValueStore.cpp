@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+
+//DOM-IGNORE-BEGIN
+
+#include "stdafx.h"
+#include "DaValueStore.h"
+#include "VariantConversion.h"
+
+// The time stamps are stored as 64-bit values. A FILETIME is only 32-bit
+// aligned, so it is converted by its parts.
+static inline LONGLONG TicksFromFileTime(const FILETIME* pft)
+{
+    ULARGE_INTEGER uliTicks;
+    uliTicks.u.LowPart = pft->dwLowDateTime;
+    uliTicks.u.HighPart = pft->dwHighDateTime;
+    return (LONGLONG)uliTicks.QuadPart;
+}
+
+static inline void FileTimeFromTicks(LONGLONG llTicks, FILETIME* pft)
+{
+    ULARGE_INTEGER uliTicks;
+    uliTicks.QuadPart = (ULONGLONG)llTicks;
+    pft->dwLowDateTime = uliTicks.u.LowPart;
+    pft->dwHighDateTime = uliTicks.u.HighPart;
+}
+
+//=========================================================================
+// Constructor
+//=========================================================================
+DaValueStore::DaValueStore()
+{
+    memset(m_apPages, 0, sizeof(m_apPages));
+    m_dwPages = 0;
+    m_dwNext = 0;
+    m_dwFree = DA_VALUESTORE_NO_ORDINAL;
+    m_dwOrdinals = 0;
+    m_lSideValues = 0;
+
+    InitializeCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// Destructor
+//=========================================================================
+DaValueStore::~DaValueStore()
+{
+    for (DWORD p = 0; p < m_dwPages; p++) {
+        for (DWORD s = 0; s < DA_VALUESTORE_PAGE_SIZE; s++) {
+            if (m_apPages[p]->apSide[s]) {
+                VariantClear(m_apPages[p]->apSide[s]);
+                delete m_apPages[p]->apSide[s];
+            }
+        }
+        delete m_apPages[p];
+    }
+    DeleteCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// IsScalarType                                                    STATIC
+// ------------
+//=========================================================================
+BOOL DaValueStore::IsScalarType(VARTYPE vt)
+{
+    switch (vt) {
+        case VT_EMPTY:  case VT_NULL:
+        case VT_I1:     case VT_UI1:    case VT_I2:     case VT_UI2:
+        case VT_I4:     case VT_UI4:    case VT_I8:     case VT_UI8:
+        case VT_INT:    case VT_UINT:   case VT_R4:     case VT_R8:
+        case VT_CY:     case VT_DATE:   case VT_BOOL:   case VT_ERROR:
+            return TRUE;
+        default:                                  // BSTR, arrays and other types with allocated memory
+            return FALSE;
+    }
+}
+
+
+//=========================================================================
+// Allocate
+// --------
+//    Reuses the released ordinals first so that the ordinals stay dense.
+//=========================================================================
+DWORD DaValueStore::Allocate(void)
+{
+    DWORD   dwOrdinal;
+    PAGE*   pPage;
+
+    EnterCriticalSection(&m_CritSec);
+
+    if (m_dwFree != DA_VALUESTORE_NO_ORDINAL) {   // Released ordinal
+        dwOrdinal = m_dwFree;
+        pPage = Page(dwOrdinal);
+        m_dwFree = (DWORD)pPage->allValue[Slot(dwOrdinal)];
+    }
+    else {                                        // New ordinal
+        dwOrdinal = m_dwNext;
+        if ((dwOrdinal >> DA_VALUESTORE_PAGE_BITS) >= DA_VALUESTORE_MAX_PAGES) {
+            LeaveCriticalSection(&m_CritSec);
+            return DA_VALUESTORE_NO_ORDINAL;
+        }
+        if (Slot(dwOrdinal) == 0) {               // First ordinal of a new page
+            pPage = new PAGE;
+            if (pPage == nullptr) {
+                LeaveCriticalSection(&m_CritSec);
+                return DA_VALUESTORE_NO_ORDINAL;
+            }
+            memset(pPage, 0, sizeof(PAGE));
+            m_apPages[m_dwPages++] = pPage;
+        }
+        pPage = Page(dwOrdinal);
+        m_dwNext++;
+    }
+
+    DWORD dwSlot = Slot(dwOrdinal);
+    pPage->avt[dwSlot] = VT_EMPTY;                // Not yet visible to readers
+    pPage->awQuality[dwSlot] = OPC_QUALITY_BAD;
+    pPage->allValue[dwSlot] = 0;
+    pPage->allTimeStamp[dwSlot] = 0;
+    pPage->apSide[dwSlot] = nullptr;
+    m_dwOrdinals++;
+
+    LeaveCriticalSection(&m_CritSec);
+    return dwOrdinal;
+}
+
+
+//=========================================================================
+// Release
+// -------
+//=========================================================================
+void DaValueStore::Release(DWORD dwOrdinal)
+{
+    _ASSERTE(dwOrdinal < m_dwNext);
+
+    PAGE*   pPage = Page(dwOrdinal);
+    DWORD   dwSlot = Slot(dwOrdinal);
+
+    if (pPage->apSide[dwSlot]) {
+        VariantClear(pPage->apSide[dwSlot]);
+        delete pPage->apSide[dwSlot];
+        pPage->apSide[dwSlot] = nullptr;
+        InterlockedDecrement(&m_lSideValues);
+    }
+
+    EnterCriticalSection(&m_CritSec);
+    pPage->avt[dwSlot] = VT_EMPTY;
+    pPage->allValue[dwSlot] = m_dwFree;           // Link of the free list
+    m_dwFree = dwOrdinal;
+    m_dwOrdinals--;
+    LeaveCriticalSection(&m_CritSec);
+}
+
+
+//=========================================================================
+// SetValue
+// --------
+//    The side table variant is copied before the sequence counter is
+//    incremented; it is only read within the lock of the writers.
+//=========================================================================
+HRESULT DaValueStore::SetValue(DWORD dwOrdinal, const VARIANT* pvValue, WORD wQuality,
+                               const FILETIME* pftTimeStamp)
+{
+    _ASSERTE(dwOrdinal < m_dwNext);
+
+    PAGE*       pPage = Page(dwOrdinal);
+    DWORD       dwSlot = Slot(dwOrdinal);
+    VARIANT*    pSide = pPage->apSide[dwSlot];
+    VARTYPE     vt = V_VT(pvValue);
+    BOOL        fScalar = IsScalarType(vt);
+
+    if (!fScalar) {                               // Value with allocated memory
+        BOOL fNewSide = FALSE;
+        if (pSide == nullptr) {
+            pSide = new VARIANT;
+            if (pSide == nullptr) {
+                return E_OUTOFMEMORY;
+            }
+            VariantInit(pSide);
+            fNewSide = TRUE;
+        }
+        HRESULT hr = VariantCopy(pSide, pvValue); // Frees the previous value
+        if (FAILED(hr)) {
+            if (fNewSide) {
+                delete pSide;
+            }
+            return hr;
+        }
+        if (fNewSide) {
+            InterlockedIncrement(&m_lSideValues);
+        }
+    }
+
+    InterlockedIncrement(&pPage->alSequence[dwSlot]);
+    pPage->avt[dwSlot] = vt;
+    pPage->allValue[dwSlot] = fScalar ? pvValue->llVal : 0;
+    pPage->awQuality[dwSlot] = wQuality;
+    pPage->allTimeStamp[dwSlot] = TicksFromFileTime(pftTimeStamp);
+    pPage->apSide[dwSlot] = fScalar ? nullptr : pSide;
+    InterlockedIncrement(&pPage->alSequence[dwSlot]);
+
+    if (fScalar && pSide) {                       // The type has changed
+        VariantClear(pSide);
+        delete pSide;
+        InterlockedDecrement(&m_lSideValues);
+    }
+    return S_OK;
+}
+
+
+//=========================================================================
+// SetQuality
+// ----------
+//=========================================================================
+void DaValueStore::SetQuality(DWORD dwOrdinal, WORD wQuality, const FILETIME* pftTimeStamp)
+{
+    _ASSERTE(dwOrdinal < m_dwNext);
+
+    PAGE*   pPage = Page(dwOrdinal);
+    DWORD   dwSlot = Slot(dwOrdinal);
+
+    InterlockedIncrement(&pPage->alSequence[dwSlot]);
+    pPage->awQuality[dwSlot] = wQuality;
+    pPage->allTimeStamp[dwSlot] = TicksFromFileTime(pftTimeStamp);
+    InterlockedIncrement(&pPage->alSequence[dwSlot]);
+}
+
+
+//=========================================================================
+// GetDataType
+// -----------
+//=========================================================================
+VARTYPE DaValueStore::GetDataType(DWORD dwOrdinal)
+{
+    _ASSERTE(dwOrdinal < m_dwNext);
+    return Page(dwOrdinal)->avt[Slot(dwOrdinal)];
+}
+
+
+//=========================================================================
+// ReadSlot
+// --------
+//    Reads a consistent snapshot of the columns of an ordinal. Retries
+//    if the ordinal was written while it was read. Writers update only
+//    a few columns, so the retry loop is short.
+//=========================================================================
+void DaValueStore::ReadSlot(PAGE* pPage, DWORD dwSlot, DASCALARVQT* pVQT)
+{
+    LONG lSequence;
+
+    for (;;) {
+        lSequence = pPage->alSequence[dwSlot];
+        if (lSequence & 1) {                      // Write in progress
+            YieldProcessor();
+            continue;
+        }
+        pVQT->vt = pPage->avt[dwSlot];
+        pVQT->wQuality = pPage->awQuality[dwSlot];
+        pVQT->llValue = pPage->allValue[dwSlot];
+        FileTimeFromTicks(pPage->allTimeStamp[dwSlot], &pVQT->ftTimeStamp);
+        if (pPage->alSequence[dwSlot] == lSequence) {
+            break;                                // Consistent snapshot
+        }
+    }
+}
+
+
+//=========================================================================
+// ReadQuality
+// -----------
+//=========================================================================
+void DaValueStore::ReadQuality(DWORD dwOrdinal, WORD* pwQuality, FILETIME* pftTimeStamp)
+{
+    _ASSERTE(dwOrdinal < m_dwNext);
+
+    DASCALARVQT VQT;
+
+    ReadSlot(Page(dwOrdinal), Slot(dwOrdinal), &VQT);
+    *pwQuality = VQT.wQuality;
+    *pftTimeStamp = VQT.ftTimeStamp;
+}
+
+
+//=========================================================================
+// ReadScalar
+// ----------
+//=========================================================================
+BOOL DaValueStore::ReadScalar(DWORD dwOrdinal, VARTYPE vtRequested, VARIANT* pvValue,
+                              WORD* pwQuality, FILETIME* pftTimeStamp, HRESULT* phr)
+{
+    _ASSERTE(dwOrdinal < m_dwNext);
+
+    DASCALARVQT VQT;
+    VARIANT     vValue;
+
+    ReadSlot(Page(dwOrdinal), Slot(dwOrdinal), &VQT);
+    if (!IsScalarType(VQT.vt)) {
+        return FALSE;                             // Must be read from the side table
+    }
+
+    V_VT(&vValue) = VQT.vt;
+    vValue.llVal = VQT.llValue;
+    *phr = VariantFromVariant(pvValue, (vtRequested == VT_EMPTY) ? VQT.vt : vtRequested, &vValue);
+    if (SUCCEEDED(*phr)) {
+        *pwQuality = VQT.wQuality;
+        *pftTimeStamp = VQT.ftTimeStamp;
+    }
+    return TRUE;
+}
+
+
+//=========================================================================
+// ReadValue
+// ---------
+//=========================================================================
+HRESULT DaValueStore::ReadValue(DWORD dwOrdinal, VARTYPE vtRequested, VARIANT* pvValue,
+                                WORD* pwQuality, FILETIME* pftTimeStamp)
+{
+    _ASSERTE(dwOrdinal < m_dwNext);
+
+    PAGE*   pPage = Page(dwOrdinal);
+    DWORD   dwSlot = Slot(dwOrdinal);
+    HRESULT hr;
+
+    if (pPage->apSide[dwSlot] == nullptr) {       // Scalar value
+        ReadScalar(dwOrdinal, vtRequested, pvValue, pwQuality, pftTimeStamp, &hr);
+        return hr;
+    }
+                                                  // No concurrent writers
+    VARIANT* pSide = pPage->apSide[dwSlot];
+    hr = VariantFromVariant(pvValue, (vtRequested == VT_EMPTY) ? V_VT(pSide) : vtRequested, pSide);
+    if (SUCCEEDED(hr)) {
+        *pwQuality = pPage->awQuality[dwSlot];
+        FileTimeFromTicks(pPage->allTimeStamp[dwSlot], pftTimeStamp);
+    }
+    return hr;
+}
+
+
+//=========================================================================
+// ReadScalars
+// -----------
+//=========================================================================
+void DaValueStore::ReadScalars(DWORD dwCount, const DWORD* pdwOrdinals, DASCALARVQT* pVQTs)
+{
+    for (DWORD i = 0; i < dwCount; i++) {
+        _ASSERTE(pdwOrdinals[i] < m_dwNext);
+        ReadSlot(Page(pdwOrdinals[i]), Slot(pdwOrdinals[i]), &pVQTs[i]);
+    }
+}
+
+
+//=========================================================================
+// GetStatistics
+// -------------
+//=========================================================================
+void DaValueStore::GetStatistics(DAVALUESTORESTATS* pStats)
+{
+    EnterCriticalSection(&m_CritSec);
+    pStats->dwOrdinals = m_dwOrdinals;
+    pStats->dwPages = m_dwPages;
+    LeaveCriticalSection(&m_CritSec);
+
+    pStats->dwSideValues = (DWORD)max(m_lSideValues, 0);
+    pStats->ullBytes = (ULONGLONG)pStats->dwPages * sizeof(PAGE)
+                       + (ULONGLONG)pStats->dwSideValues * sizeof(VARIANT);
+}
+//DOM-IGNORE-END
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+
+#ifndef __VALUESTORE_H_
+#define __VALUESTORE_H_
+
+//DOM-IGNORE-BEGIN
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+               // Number of ordinals per page (power of 2)
+#define  DA_VALUESTORE_PAGE_BITS       12
+#define  DA_VALUESTORE_PAGE_SIZE       (1 << DA_VALUESTORE_PAGE_BITS)
+               // Maximum number of pages, limits the number of values
+               // to DA_VALUESTORE_PAGE_SIZE * DA_VALUESTORE_MAX_PAGES
+#define  DA_VALUESTORE_MAX_PAGES       4096
+               // Returned by Allocate() if out of memory
+#define  DA_VALUESTORE_NO_ORDINAL      0xFFFFFFFF
+
+
+               // Value, quality and time stamp of a scalar value
+               // as stored in the columns, see ReadScalars()
+typedef struct tagDASCALARVQT {
+   VARTYPE     vt;                     // data type, llValue is only valid if IsScalarType( vt )
+   WORD        wQuality;
+   LONGLONG    llValue;                // value bits (VARIANT::llVal)
+   FILETIME    ftTimeStamp;
+} DASCALARVQT;
+
+
+               // Counters of a value store
+typedef struct tagDAVALUESTORESTATS {
+   DWORD       dwOrdinals;             // allocated ordinals
+   DWORD       dwPages;                // allocated pages
+   DWORD       dwSideValues;           // values stored in the side table
+   ULONGLONG   ullBytes;               // memory of the pages and of the side table variants
+} DAVALUESTORESTATS;
+
+
+/////////////////////////////////////////////////////////////////
+// Value Store
+// -----------
+// Cache values (value, quality and time stamp) of the Device
+// Items, stored in columns indexed by a dense ordinal per item.
+//
+// The ordinals are grouped in pages. Each page holds one column
+// per attribute so that operations over many items (bulk read)
+// access contiguous memory instead of the item objects. Pages are
+// never moved or released while the store exists, so the columns
+// are read without lock.
+//
+// The value of scalar types without allocated memory is stored in
+// the value column as VARIANT::llVal. Values of other types (BSTR,
+// arrays) are VARIANTs in the side table.
+//
+// Writers of the same ordinal must be serialized by the caller
+// (DaDeviceItem::get_ValueCritSec()). Scalar values, qualities and time
+// stamps are read lock-free with a sequence counter (seqlock):
+// the counter is odd while a write is in progress and readers
+// retry if it has changed. Side table values must be read within
+// the lock of the writers. Relies on the acquire/release semantics
+// of volatile accesses of the x86/x64 compilers (/volatile:ms).
+/////////////////////////////////////////////////////////////////
+class DaValueStore {
+
+   public:
+      DaValueStore();
+      ~DaValueStore();
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns a new ordinal with an empty value, bad quality and
+         //  time stamp 0 or DA_VALUESTORE_NO_ORDINAL if out of memory.
+         ///////////////////////////////////////////////////////////////
+      DWORD Allocate( void );
+
+         ///////////////////////////////////////////////////////////////
+         //  Clears the value and releases the ordinal for reuse.
+         ///////////////////////////////////////////////////////////////
+      void Release( DWORD dwOrdinal );
+
+         ///////////////////////////////////////////////////////////////
+         //  Sets value, quality and time stamp. Returns the result of
+         //  VariantCopy(); the stored values are unchanged if failed.
+         ///////////////////////////////////////////////////////////////
+      HRESULT SetValue( DWORD dwOrdinal, const VARIANT* pvValue, WORD wQuality,
+                        const FILETIME* pftTimeStamp );
+
+         ///////////////////////////////////////////////////////////////
+         //  Sets quality and time stamp, the value is unchanged.
+         ///////////////////////////////////////////////////////////////
+      void SetQuality( DWORD dwOrdinal, WORD wQuality, const FILETIME* pftTimeStamp );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the data type of the value.
+         ///////////////////////////////////////////////////////////////
+      VARTYPE GetDataType( DWORD dwOrdinal );
+
+         ///////////////////////////////////////////////////////////////
+         //  Reads quality and time stamp. Lock-free.
+         ///////////////////////////////////////////////////////////////
+      void ReadQuality( DWORD dwOrdinal, WORD* pwQuality, FILETIME* pftTimeStamp );
+
+         ///////////////////////////////////////////////////////////////
+         //  Reads value, quality and time stamp of a scalar value
+         //  converted to the requested data type (VT_EMPTY for the
+         //  stored type). Lock-free. *phr is the conversion result.
+         //  Returns FALSE if the value is stored in the side table;
+         //  in this case nothing is read.
+         ///////////////////////////////////////////////////////////////
+      BOOL ReadScalar( DWORD dwOrdinal, VARTYPE vtRequested, VARIANT* pvValue,
+                       WORD* pwQuality, FILETIME* pftTimeStamp, HRESULT* phr );
+
+         ///////////////////////////////////////////////////////////////
+         //  Reads value, quality and time stamp of any value converted
+         //  to the requested data type (VT_EMPTY for the stored type).
+         //  Must be called within the lock of the writers.
+         ///////////////////////////////////////////////////////////////
+      HRESULT ReadValue( DWORD dwOrdinal, VARTYPE vtRequested, VARIANT* pvValue,
+                         WORD* pwQuality, FILETIME* pftTimeStamp );
+
+         ///////////////////////////////////////////////////////////////
+         //  Reads the values of several ordinals without conversion.
+         //  Lock-free. The value of pVQTs[i] is only valid if
+         //  IsScalarType( pVQTs[i].vt ); other values must be read
+         //  with ReadValue().
+         ///////////////////////////////////////////////////////////////
+      void ReadScalars( DWORD dwCount, const DWORD* pdwOrdinals, DASCALARVQT* pVQTs );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns the counters of the store.
+         ///////////////////////////////////////////////////////////////
+      void GetStatistics( DAVALUESTORESTATS* pStats );
+
+         ///////////////////////////////////////////////////////////////
+         //  Returns TRUE if values of the specified type are stored in
+         //  the value column (types without allocated memory).
+         ///////////////////////////////////////////////////////////////
+      static BOOL IsScalarType( VARTYPE vt );
+
+   private:
+      typedef struct tagPAGE {
+         volatile LONG     alSequence[ DA_VALUESTORE_PAGE_SIZE ];    // odd while written
+         volatile VARTYPE  avt[ DA_VALUESTORE_PAGE_SIZE ];           // data type of the value
+         volatile WORD     awQuality[ DA_VALUESTORE_PAGE_SIZE ];
+         volatile LONGLONG allValue[ DA_VALUESTORE_PAGE_SIZE ];      // scalar value; next free ordinal if released
+         volatile LONGLONG allTimeStamp[ DA_VALUESTORE_PAGE_SIZE ];
+         VARIANT*          apSide[ DA_VALUESTORE_PAGE_SIZE ];        // side table, NULL for scalar values
+      } PAGE;
+
+      PAGE           *m_apPages[ DA_VALUESTORE_MAX_PAGES ];
+      DWORD          m_dwPages;
+      DWORD          m_dwNext;            // lowest ordinal never allocated
+      DWORD          m_dwFree;            // first released ordinal, DA_VALUESTORE_NO_ORDINAL if none
+      DWORD          m_dwOrdinals;
+      volatile LONG  m_lSideValues;
+
+               // protects the allocation of ordinals and pages
+      CRITICAL_SECTION m_CritSec;
+
+      inline PAGE* Page( DWORD dwOrdinal ) { return m_apPages[ dwOrdinal >> DA_VALUESTORE_PAGE_BITS ]; }
+      static inline DWORD Slot( DWORD dwOrdinal ) { return dwOrdinal & (DA_VALUESTORE_PAGE_SIZE - 1); }
+
+      void ReadSlot( PAGE* pPage, DWORD dwSlot, DASCALARVQT* pVQT );
+};
+//DOM-IGNORE-END
+
+
+#endif // __VALUESTORE_H_
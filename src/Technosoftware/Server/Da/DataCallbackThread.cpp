@@ -24,9 +24,9 @@
  // INLCUDE
  //-----------------------------------------------------------------------
 #include "stdafx.h"
-#include <process.h>
 #include "DataCallbackThread.h"
 #include "Logger.h"
+#include "OpcClock.h"
 
 //-----------------------------------------------------------------------
 // CODE
@@ -47,7 +47,6 @@ DataCallbackThread::DataCallbackThread(DaGenericGroup* pParent)
     _ASSERTE(m_pGServer);
 
     // Initialize members with default values
-    m_hThread = 0;
     m_dwCount = 0;                    // Number of items
     m_dwTransactionID = 0;                    // Transaction ID
     m_dwSource = OPC_DS_DEVICE;        // Default data source
@@ -61,7 +60,8 @@ DataCallbackThread::DataCallbackThread(DaGenericGroup* pParent)
     m_ppTmpBufferForItemsToReadFromDevice = NULL;// Array with temporary used Device Item pointers
 
     m_pParent = pParent;              // A generic group
-    m_pCancelThread = NULL;
+    m_fCancelRequested = FALSE;
+    m_fAdmitted = FALSE;
 }
 
 
@@ -111,6 +111,9 @@ DataCallbackThread::~DataCallbackThread()
     m_fxaTStamps.Cleanup();
     m_fxaErrors.Cleanup();
 
+    if (m_fAdmitted) {                            // Release the admission of the transaction
+        m_pParent->m_pServerHandler->CompleteAsyncTransaction(m_pGServer);
+    }
     m_pParent->Detach();                          // Now it possible to delete the parent
 }
 
@@ -121,15 +124,12 @@ DataCallbackThread::~DataCallbackThread()
 //-----------------------------------------------------------------------
 
 //=========================================================================
-// Creates a thread to cancel an asynchronous transaction
+// Requests to cancel an asynchronous transaction
 //=========================================================================
-HRESULT DataCallbackThread::CreateCancelThread()
+HRESULT DataCallbackThread::RequestCancel()
 {
-    m_pCancelThread = new CCancelThread;
-    if (m_pCancelThread == NULL) {
-        return E_OUTOFMEMORY;
-    }
-    return m_pCancelThread->Create(this);
+    m_fCancelRequested = TRUE;
+    return S_OK;
 }
 
 
@@ -155,8 +155,14 @@ HRESULT DataCallbackThread::CreateCustomReadOrRefresh(
 
     HRESULT  hr = S_OK;
     BOOL     fLocked = FALSE;
+    long     lCancelID;
 
     try {
+        // Reject the transaction if too many are outstanding
+        hr = m_pParent->m_pServerHandler->AdmitAsyncTransaction(m_pGServer);
+        _OPC_CHECK_HR(hr);
+        m_fAdmitted = TRUE;
+
         // Initialze all arrays passed via the registered callback to the client
         m_fxaHandles.Init(dwCount, &m_phClientItems);
         m_fxaVal.Init(dwCount, &m_pvValues);
@@ -175,8 +181,7 @@ HRESULT DataCallbackThread::CreateCustomReadOrRefresh(
             m_ppTmpBufferForItemsToReadFromDevice = new DaDeviceItem*[dwCount];
             _OPC_CHECK_PTR(m_ppTmpBufferForItemsToReadFromDevice);
 
-            HRESULT hr = CoFileTimeNow(&m_ftNow);
-            _OPC_CHECK_HR(hr);
+            OpcClockCoarse(&m_ftNow);
         }
         // Lock the list before create the thread.
         // This way remove requests are prevented
@@ -184,28 +189,22 @@ HRESULT DataCallbackThread::CreateCustomReadOrRefresh(
         EnterCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
         fLocked = TRUE;
         // The array index also used as cancel ID.
-        m_dwCancelID = *pdwCancelID = m_pParent->m_oaAsyncThread.New();
+        lCancelID = m_pParent->m_oaAsyncThread.New();
+        if (lCancelID == -1) {                    // maximum number of transactions reached
+            throw E_OUTOFMEMORY;
+        }
+        m_dwCancelID = *pdwCancelID = lCancelID;
 
         hr = m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, (DaAsynchronousThread *)this);
         _OPC_CHECK_HR(hr);
 
-        unsigned uCreationFlags = 0;
-        unsigned uThreadAddr;
-
-        m_hThread = (HANDLE)_beginthreadex(
-            NULL,                // No thread security attributes
-            0,                   // Default stack size  
-                                 // Pointer to thread function 
-            DataCallbackReadThreadHandler,
-            this,                // Pass class to new thread 
-            uCreationFlags,      // Into ready state 
-            &uThreadAddr);      // Address of the thread
+        // Executed by the transaction pool
+        hr = m_pParent->m_pServerHandler->SubmitAsyncTransaction(DataCallbackReadThreadHandler, this);
 
-
-        if (m_hThread == 0) {                     // Cannot create the thread
+        if (FAILED(hr)) {                         // Cannot queue the transaction
                                                   // Remove from list                        
             m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, NULL);
-            throw (HRESULT)HRESULT_FROM_WIN32(GetLastError());
+            throw hr;
         }
     }
     catch (HRESULT hrEx) {
@@ -244,6 +243,13 @@ HRESULT DataCallbackThread::CreateCustomWriteVQT(
     _ASSERTE(pdwCancelID);
     // Note : pfPhyval may be NULL
 
+    // Reject the transaction if too many are outstanding
+    HRESULT hr = m_pParent->m_pServerHandler->AdmitAsyncTransaction(m_pGServer);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    m_fAdmitted = TRUE;
+
     // Initialze all arrays passed via the registered callback to the client
     try {
         m_fxaHandles.Init(dwCount, &m_phClientItems);
@@ -260,41 +266,35 @@ HRESULT DataCallbackThread::CreateCustomWriteVQT(
     m_pfPhyval = pfPhyval;             // Array which marks items added with their physical value
     m_pVQTsToWrite = pItemVQTs;            // Values, Qualities and TimeStamps to write
 
-    unsigned uCreationFlags = 0;
-    unsigned uThreadAddr;
-
+    long lCancelID;
     EnterCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
     // Lock the list before create the thread.
     // This way remove requests are prevented
     // before the thread was added to the list.
 
-    m_dwCancelID = *pdwCancelID = m_pParent->m_oaAsyncThread.New();
+    lCancelID = m_pParent->m_oaAsyncThread.New();
+    if (lCancelID == -1) {                       // maximum number of transactions reached
+        LeaveCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
+        return E_OUTOFMEMORY;
+    }
+    m_dwCancelID = *pdwCancelID = lCancelID;
     // Array index also used as cancel ID
-    HRESULT hr = m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, (DaAsynchronousThread *)this);
+    hr = m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, (DaAsynchronousThread *)this);
     if (FAILED(hr)) {
         LeaveCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
         return hr;
     }
 
-    m_hThread = (HANDLE)_beginthreadex(
-        NULL,                // No thread security attributes
-        0,                   // Default stack size  
-                             // Pointer to thread function 
-        DataCallbackWriteThreadHandler,
-        this,                // Pass class to new thread 
-        uCreationFlags,      // Into ready state 
-        &uThreadAddr);      // Address of the thread
-
+    // Executed by the transaction pool
+    hr = m_pParent->m_pServerHandler->SubmitAsyncTransaction(DataCallbackWriteThreadHandler, this);
 
-    if (m_hThread == 0) {                        // Cannot create the thread
+    if (FAILED(hr)) {                            // Cannot queue the transaction
                                                  // Reove from list                        
         m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, NULL);
         m_ppDItems = NULL;                    // Prevents cleanup in destructor
         m_pItemStates = NULL;
         m_pfPhyval = NULL;
         m_pVQTsToWrite = NULL;
-
-        hr = HRESULT_FROM_WIN32(GetLastError());
     }
     LeaveCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
     return hr;
@@ -356,60 +356,63 @@ void DataCallbackThread::SetCallbackResultsFromItemStates(
 //-----------------------------------------------------------------------
 
 //=========================================================================
-// Kill this instance and the thread running over it
+// Kill this instance after the transaction has been handled or canceled.
+// The worker thread of the transaction pool continues with the next
+// transaction.
 //=========================================================================
 void DataCallbackThread::DoKill(void)
 {
-    CloseHandle(m_hThread);                    // Thread handle must be closed explicitly
-                                                 // if _endthreadex() is used.
     delete this;                                 // Kill the class object
-    _endthreadex(0);                             // Kill the thread
 }
 
 
 
 //=========================================================================
 // Checks if the cancel flag is set.
-// If the flag is set then the instance and the thread running over it
-// are killed -> the function never returns.
+// If the flag is set or the group is removed then the instance is
+// killed and the function returns TRUE. The caller must not access the
+// instance in this case.
 //
 // Parameters:
 //    fPreventCancel    If this flag is TRUE then the transaction can be
 //                      no longer canceled after executed this function.
-//                      (The thread will be removed from the array
+//                      (The transaction will be removed from the array
 //                      of callback threads).
+//
+// The cancel latency depends on the transaction pool: a cancel request
+// is only handled when a worker thread executes the transaction and
+// reaches one of these check points. A queued transaction is not
+// removed from the pool, so Cancel2 returns immediately but the
+// OnCancelComplete callback is sent only after a worker thread is free.
 //=========================================================================
-void DataCallbackThread::CheckCancelRequestAndKillFlag(BOOL fPreventCancel /* = FALSE */)
+BOOL DataCallbackThread::CheckCancelRequestAndKillFlag(BOOL fPreventCancel /* = FALSE */)
 {
     EnterCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
-    // Prevents installation of a Cancel Thread
-// Check if the group has the kill flag set
+    // Prevents new cancel requests
+    // Check if the group has the kill flag set
     if (m_pParent->Killed()) {
-        // Remove the thread from the array
+        // Remove the transaction from the array
         // of data callback threads
         m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, NULL);
         LeaveCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
-        DoKill();                                 // Kill the thread and and the class
-        _ASSERTE(0);                            // Should never get here
+        DoKill();                                 // Kill the class
+        return TRUE;
     }
     // Check if there is a cancel request
-    if (m_pCancelThread) {
+    if (m_fCancelRequested) {
         m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, NULL);
         LeaveCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
         // There is a cancel request for the current transaction
-        m_pCancelThread->InvokeCancelCallback();  // Invoke the registered cancel complete callback
-
-                                                  // Wait until the cancel thread has terminated
-        WaitForSingleObject(m_pCancelThread->m_hThread, INFINITE);
-
-        DoKill();                                 // Kill the thread and and the class
-        _ASSERTE(0);                            // Should never get here
+        InvokeCancelCallback();                   // Invoke the registered cancel complete callback
+        DoKill();                                 // Kill the class
+        return TRUE;
     }
     else if (fPreventCancel) {
         // After this it is no longer possible to cancel the transaction.
         m_pParent->m_oaAsyncThread.PutElem(m_dwCancelID, NULL);
     }
     LeaveCriticalSection(&m_pParent->m_AsyncThreadsCritSec);
+    return FALSE;
 }
 
 
@@ -418,9 +421,10 @@ void DataCallbackThread::CheckCancelRequestAndKillFlag(BOOL fPreventCancel /* =
 //-----------------------------------------------------------------------
 
 //=========================================================================
-// Thread handling asynchronous Read and Refresh transactions
-// ----------------------------------------------------------
-//    The thread handles a single request and then terminates.
+// Handler of asynchronous Read and Refresh transactions
+// -----------------------------------------------------
+//    Executed by a worker thread of the transaction pool. Handles a
+//    single request and then deletes the transaction.
 //=========================================================================
 unsigned __stdcall DataCallbackReadThreadHandler(void* pCreator)
 {
@@ -452,7 +456,9 @@ unsigned __stdcall DataCallbackReadThreadHandler(void* pCreator)
             pThrd->m_pErrors,
             pThrd->m_pfPhyval);
 
-        pThrd->CheckCancelRequestAndKillFlag();   // Maybe never returns from this function      
+        if (pThrd->CheckCancelRequestAndKillFlag()) {
+            return 0;                             // Canceled or group removed
+        }
 
                                                   // Initialize the Client Handle array and the Master Quality
         for (i = 0; i < pThrd->m_dwCount; i++) {
@@ -475,7 +481,9 @@ unsigned __stdcall DataCallbackReadThreadHandler(void* pCreator)
             pThrd->m_pErrors,
             pThrd->m_pfPhyval);
 
-        pThrd->CheckCancelRequestAndKillFlag();   // Maybe never returns from this function
+        if (pThrd->CheckCancelRequestAndKillFlag()) {
+            return 0;                             // Canceled or group removed
+        }
 
         // Initialize the result arrays with the values from the OPC item states
         pThrd->SetCallbackResultsFromItemStates(
@@ -495,9 +503,10 @@ unsigned __stdcall DataCallbackReadThreadHandler(void* pCreator)
             pThrd->m_pftTimeStamps);
     }
 
-    pThrd->CheckCancelRequestAndKillFlag(TRUE);// The last check of the cancel flag.
+    if (pThrd->CheckCancelRequestAndKillFlag(TRUE)) {
+        return 0;                                // Canceled or group removed
+    }                                            // The last check of the cancel flag.
                                                  // After that it is no longer possible to cancel the transaction.
-                                                 // Maybe never returns from this function.
 
     // Get the COM object
     CComObject<DaGroup>* pCOMGroup = NULL;
@@ -560,25 +569,27 @@ unsigned __stdcall DataCallbackReadThreadHandler(void* pCreator)
 
     pThrd->m_pGServer->CriticalSectionCOMGroupList.EndReading();   // Unlock reading COM list
 
-    pThrd->DoKill();                             // Kill the thread and and the class
-    return 0;                                    // Should never get here
+    pThrd->DoKill();                             // Kill the class
+    return 0;
 }
 
 
 
 //=========================================================================
-// Thread handling asynchronous Write transactions
-// -----------------------------------------------
-//    The thread handles a single request and then terminates.
+// Handler of asynchronous Write transactions
+// ------------------------------------------
+//    Executed by a worker thread of the transaction pool. Handles a
+//    single request and then deletes the transaction.
 //=========================================================================
 unsigned __stdcall DataCallbackWriteThreadHandler(void* pCreator)
 {
     DataCallbackThread* pThrd = static_cast<DataCallbackThread *>(pCreator);
     _ASSERTE(pThrd);
 
-    pThrd->CheckCancelRequestAndKillFlag(TRUE);// Check of the cancel flag.
+    if (pThrd->CheckCancelRequestAndKillFlag(TRUE)) {
+        return 0;                                // Canceled or group removed
+    }                                            // Check of the cancel flag.
                                                  // After that it is no longer possible to cancel the transaction.
-                                                 // Maybe never returns from this function.
 
     // Write the data to the device
     HRESULT hrMasterError = pThrd->m_pParent->InternalWriteVQT(
@@ -639,112 +650,29 @@ unsigned __stdcall DataCallbackWriteThreadHandler(void* pCreator)
 
     pThrd->m_pGServer->CriticalSectionCOMGroupList.EndReading();   // Unlock reading COM list
 
-    pThrd->DoKill();                             // Kill the thread and and the class
-    return 0;                                    // Should never get here
+    pThrd->DoKill();                             // Kill the class
+    return 0;
 }
 
 
 
-///////////////////////////////////////////////////////////////////////////
-// DataCallbackThread::CCancelThread
-///////////////////////////////////////////////////////////////////////////
-
-///////////////////////////////////////////////////////////////////////////
 //=========================================================================
-// Constructor
+// Invokes the cancel complete callback
+// ------------------------------------
+//    Called if the transaction has been successfully canceled.
 //=========================================================================
-DataCallbackThread::CCancelThread::CCancelThread()
+void DataCallbackThread::InvokeCancelCallback(void)
 {
-    m_pThreadToCancel = NULL;                // The owner
-    m_hOperationCanceledEvent = NULL;
-}
-
-
-
-//=========================================================================
-// Destructor
-//=========================================================================
-DataCallbackThread::CCancelThread::~CCancelThread()
-{
-    if (m_hOperationCanceledEvent) {
-        CloseHandle(m_hOperationCanceledEvent);
-    }
-}
-
-
-
-//=========================================================================
-// Initialization
-// --------------
-//    Creates the Cancel Thread.
-//=========================================================================
-HRESULT DataCallbackThread::CCancelThread::Create(DataCallbackThread* pThreadToCancel)
-{
-    _ASSERTE(pThreadToCancel);
-
-    m_pThreadToCancel = pThreadToCancel;
-
-    m_hOperationCanceledEvent = CreateEvent(
-        NULL,                // Handle cannot be inherited
-        TRUE,                // Manually reset requested
-        FALSE,               // Initial state is nonsignaled
-        NULL);              // No event object name 
-
-    if (m_hOperationCanceledEvent == NULL) {
-        return E_FAIL;                            // Cannot create event
-    }
-
-    unsigned uCreationFlags = 0;
-    unsigned uThreadAddr;
-
-    m_hThread = (HANDLE)_beginthreadex(
-        NULL,                // No thread security attributes
-        0,                   // Default stack size  
-        CancelThreadHandler, // Pointer to thread function 
-        this,                // Pass class to new thread
-        uCreationFlags,      // Into ready state 
-        &uThreadAddr);      // Address of the thread
-
-    if (m_hThread == 0) {                        // Cannot create the thread
-        return HRESULT_FROM_WIN32(GetLastError());
-    }
-    return S_OK;
-}
-
-
-
-//=========================================================================
-// Cancel Thread Handler
-// ---------------------
-//    Waits until the thread of the transaction has terminated or
-//    successfully canceled.
-//    If the transaction successfully canceled then the registered 
-//    cancel callback will be invoked.
-//    After that the thread terminates and deletes the class.
-//=========================================================================
-unsigned __stdcall CancelThreadHandler(void* pCreator)
-{
-    DataCallbackThread::CCancelThread* pThrd = static_cast<DataCallbackThread::CCancelThread *>(pCreator);
-    _ASSERTE(pThrd);
-
-    const DataCallbackThread* pThreadToCancel = pThrd->m_pThreadToCancel;
-    _ASSERTE(pThreadToCancel);
-
-    // Waits until the thread of the transaction has successfully canceled.
-    WaitForSingleObject(pThrd->m_hOperationCanceledEvent, INFINITE);
-
-
-    // Invoke the cancel complete callback
     LOGFMTI("Transaction successfully canceled");
 
     // Get the COM object
     CComObject<DaGroup>* pCOMGroup = NULL;
 
     // Lock reading COM list
-    pThreadToCancel->m_pGServer->CriticalSectionCOMGroupList.BeginReading();
+    m_pGServer->CriticalSectionCOMGroupList.BeginReading();
 
-    HRESULT hres = pThreadToCancel->m_pGServer->m_COMGroupList.GetElem(
-        pThreadToCancel->m_pParent->m_hServerGroupHandle,
+    HRESULT hres = m_pGServer->m_COMGroupList.GetElem(
+        m_pParent->m_hServerGroupHandle,
         &pCOMGroup);
 
     if (SUCCEEDED(hres)) {
@@ -757,10 +685,8 @@ unsigned __stdcall CancelThreadHandler(void* pCreator)
         if (SUCCEEDED(hres)) {
 
             pCallback->OnCancelComplete(
-                // Transaction ID
-                pThreadToCancel->m_dwTransactionID,
-                // Group Handle
-                pThreadToCancel->m_pParent->m_hClientGroupHandle);
+                m_dwTransactionID,        // Transaction ID
+                m_pParent->m_hClientGroupHandle);   // Group Handle
 
             pCallback->Release();         // All is done with this interface
         }
@@ -768,13 +694,6 @@ unsigned __stdcall CancelThreadHandler(void* pCreator)
         pCOMGroup->Unlock();             // Unlock the connection point list
     }
     // Unlock reading COM list
-    pThreadToCancel->m_pGServer->CriticalSectionCOMGroupList.EndReading();
-
-    // Kill the thread and and the class
-    CloseHandle(pThrd->m_hThread);             // Thread handle must be closed explicitly
-                                                 // if _endthreadex() is used.
-    delete pThrd;                                // Kill the class object
-    _endthreadex(0);                             // Kill the thread
-    return 0;                                    // Should never get here
+    m_pGServer->CriticalSectionCOMGroupList.EndReading();
 }
 //DOM-IGNORE-END
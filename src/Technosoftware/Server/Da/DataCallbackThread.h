@@ -30,6 +30,10 @@
 #include "DaGenericGroup.h"
 #include "FixOutArray.h"
 
+                                             // Transaction handlers, executed by the transaction pool
+unsigned __stdcall DataCallbackReadThreadHandler( void* pCreator );
+unsigned __stdcall DataCallbackWriteThreadHandler( void* pCreator );
+
 //-----------------------------------------------------------------------
 // CLASS
 //-----------------------------------------------------------------------
@@ -37,7 +41,6 @@ class DataCallbackThread
 {
    friend unsigned __stdcall DataCallbackReadThreadHandler( void* pCreator );
    friend unsigned __stdcall DataCallbackWriteThreadHandler( void* pCreator );
-   friend unsigned __stdcall CancelThreadHandler( void* pCreator );
 
 public:
    DataCallbackThread( DaGenericGroup* pParent );
@@ -50,6 +53,8 @@ public:
    //    The creator of the Data Callback Thread object must not use the created
    //    instance after CreateXXX calls because the object destroys itself.
    //    Also all by parameters provided arrays will be deleted.
+   //    The transactions are executed by the transaction pool of the
+   //    server class handler (see DaBaseServer::SubmitAsyncTransaction()).
    //
 
    inline HRESULT CreateCustomRead(
@@ -126,7 +131,14 @@ public:
                // [out]
                DWORD*         pdwCancelID );
 
-   HRESULT CreateCancelThread();
+   // Requests to cancel the transaction. Must be called within
+   // DaGenericGroup::m_AsyncThreadsCritSec while the transaction is in the
+   // list of outstanding transactions. The cancel complete callback is
+   // invoked by the transaction handler, i.e. not before a worker thread
+   // of the transaction pool takes the transaction. If all worker threads
+   // are blocked (e.g. by a slow device) then OnCancelComplete is delayed
+   // until a worker thread becomes free.
+   HRESULT RequestCancel();
                                                 
    static void SetCallbackResultsFromItemStates(// Sets the values in the arrays with the  
                                                 // values from pItemStates
@@ -157,46 +169,17 @@ protected:
                // [out]       
                DWORD*         pdwCancelID );
 
-   class CCancelThread
-   {
-      friend unsigned __stdcall CancelThreadHandler( void* pCreator );
-   
-   // Construction
-   public:
-      CCancelThread();
-      virtual ~CCancelThread();
-   
-      HRESULT  Create( DataCallbackThread* pThreadToCancel );
-   
-   // Attributes
-   public:
-      HANDLE               m_hThread;              // Thread handle
-
-   // Operations
-   public:
-      inline void InvokeCancelCallback( void ) {
-         _ASSERTE( m_hOperationCanceledEvent );
-         SetEvent( m_hOperationCanceledEvent );
-      }
-   
-   // Implementation
-   protected:
-      HANDLE               m_hOperationCanceledEvent;
-      DataCallbackThread* m_pThreadToCancel;      // The onwer
-   
-   };
-
    //
    // Data members
    //
    DaGenericGroup*    m_pParent;                 // A generic group
    DaGenericServer*   m_pGServer;                // A generic server
-   CCancelThread*    m_pCancelThread;           // Pointer to cancel thread if cancel request
+   BOOL              m_fCancelRequested;        // TRUE if there is a cancel request
+   BOOL              m_fAdmitted;               // TRUE if admitted by DaBaseServer::AdmitAsyncTransaction()
    DWORD             m_dwCount;                 // Number of items
    DWORD             m_dwTransactionID;         // Transaction ID
    OPCDATASOURCE     m_dwSource;                // Data source
    BOOL              m_fReadTransaction;        // The activated transaction type (read or refresh)
-   HANDLE            m_hThread;                 // Thread handle
    DWORD             m_dwCancelID;              // The cancel ID is the index in the
                                                 // arry of data callback threads.
    FILETIME          m_ftNow;                   // Used by functions with Max Age parameters
@@ -237,7 +220,8 @@ protected:
    // Function members
    //
    void DoKill( void );
-   void CheckCancelRequestAndKillFlag( BOOL fPreventCancel = FALSE );
+   BOOL CheckCancelRequestAndKillFlag( BOOL fPreventCancel = FALSE );
+   void InvokeCancelCallback( void );
 };
 //DOM-IGNORE-END
 
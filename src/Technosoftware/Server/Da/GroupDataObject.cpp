@@ -22,6 +22,7 @@
 
 #include "stdafx.h"
 #include "UtilityFuncs.h"
+#include "OpcClock.h"
 #include "VariantPack.h"
 #include "DaGenericGroup.h"
 
@@ -686,42 +687,51 @@ SendWriteDispExit2:
 //=========================================================================
 HRESULT DaGenericGroup::UpdateToClient(BOOL custom, BOOL WithTime, BOOL DataCallbackOnly)
 {
-    long           i, TotGroupItems;
+    long           i;
     long           TotItemsToRead, TotItemsToTransmit;
     DaDeviceItem   **ppDItems, *pDItem;
     DaGenericItem  **ppGItems, *pGItem;
     HRESULT        *pErr, res;
     OPCITEMSTATE   *pItemStates;
+    DASHAREDREAD   *pShared;
+    DaDeviceItem   **ppReadDItems;
     DWORD          AccessRight;
+    OPCHANDLE      *phDirtyItems;
+    DWORD          dwNumDirtyItems, d;
 
-    // while building arrays don't allow add and delete of items to group
-    EnterCriticalSection(&m_ItemsCritSec);
-
-    // number of items in the group
+    // Only the items which have changed since the last update must be handled
     res = S_OK;
-    TotGroupItems = m_oaItems.TotElem();
-    if (TotGroupItems == 0) {
-        LeaveCriticalSection(&m_ItemsCritSec);
-        goto UpdateToClient0;
-    }
-    res = E_OUTOFMEMORY;
-    ppGItems = new DaGenericItem*[TotGroupItems];// create generic item array object
-    if (!ppGItems) {
-        LeaveCriticalSection(&m_ItemsCritSec);
+    TakeDirtyItems(&phDirtyItems, &dwNumDirtyItems);
+    if (dwNumDirtyItems == 0) {
         goto UpdateToClient0;
     }
 
-    ppDItems = new DaDeviceItem*[TotGroupItems]; // create device item array object
-    if (!ppDItems) {
+    // while building arrays don't allow add and delete of items to group
+    EnterCriticalSection(&m_ItemsCritSec);
+
+    // the scratch arrays of the group are reused with every update
+    if (FAILED(ReserveUpdateScratch(dwNumDirtyItems))) {
+        // Keep the dirty items for the next update
+        for (d = 0; d < dwNumDirtyItems; d++) {
+            m_oaItems.GetElem(phDirtyItems[d], &pGItem);
+            if (pGItem && pGItem->ClearDirty()) {
+                pGItem->MarkDirty();
+            }
+        }
         LeaveCriticalSection(&m_ItemsCritSec);
-        goto UpdateToClient1;
+        res = E_OUTOFMEMORY;
+        goto UpdateToClient0;
     }
+    ppGItems = m_ppUpdateGItems;
+    ppDItems = m_ppUpdateDItems;
 
     // Initialize the arrays for generic and Device Items
     TotItemsToRead = 0;
-    res = m_oaItems.First(&i);
-    while (SUCCEEDED(res)) {
-        m_oaItems.GetElem(i, &pGItem);
+    for (d = 0; d < dwNumDirtyItems; d++) {
+        m_oaItems.GetElem(phDirtyItems[d], &pGItem);
+        if (pGItem && !pGItem->ClearDirty()) {
+            pGItem = NULL;                        // already handled or stale handle
+        }
         if (pGItem && pGItem->get_Active()) {     // item must be existent and active
 
             if (pGItem->AttachDeviceItem(&pDItem) >= 0) {
@@ -742,23 +752,19 @@ HRESULT DaGenericGroup::UpdateToClient(BOOL custom, BOOL WithTime, BOOL DataCall
                 }
             }
         } // item is existent and active
-
-        res = m_oaItems.Next(i, &i);
     }
     LeaveCriticalSection(&m_ItemsCritSec);     // finished building item arrays
 
     if (TotItemsToRead == 0) {
         res = S_FALSE;                            // There are no Device Items to read
-        goto UpdateToClient2;
+        goto UpdateToClient1;
     }
 
-    res = E_OUTOFMEMORY;                         // New default error code
-    // Generate all required arrays with size TotItemsToRead
-    pErr = (HRESULT *)pIMalloc->Alloc(TotItemsToRead * sizeof(HRESULT));
-    if (!pErr)        goto UpdateToClient2;
-
-    pItemStates = (OPCITEMSTATE *)pIMalloc->Alloc(TotItemsToRead * sizeof(OPCITEMSTATE));
-    if (!pItemStates) goto UpdateToClient3;
+    // The arrays are large enough for all dirty items
+    pErr = m_pUpdateErrors;
+    pItemStates = m_pUpdateItemStates;
+    pShared = m_pUpdateShared;
+    ppReadDItems = m_ppUpdateReadDItems;
 
     for (i = 0; i < TotItemsToRead; i++) {
         pErr[i] = S_OK;
@@ -766,13 +772,33 @@ HRESULT DaGenericGroup::UpdateToClient(BOOL custom, BOOL WithTime, BOOL DataCall
         pItemStates[i].hClient = pGItem->get_ClientHandle();
         VariantInit(&pItemStates[i].vDataValue);
         V_VT(&pItemStates[i].vDataValue) = pGItem->get_RequestedDataType();
+        pShared[i].llToken = pShared[i].llPrevToken = 0;
+        ppReadDItems[i] = ppDItems[i];
+    }
 
+    // Items also read by groups of other clients with the same data type,
+    // update rate and deadband are converted and compared only once
+    // per change (see DaDeviceItem::ReadShared()).
+    m_pServerHandler->readWriteLock_.BeginReading();
+    for (i = 0; i < TotItemsToRead; i++) {
+        res = ppDItems[i]->ReadShared(V_VT(&pItemStates[i].vDataValue),
+            (DWORD)m_RevisedUpdateRate, m_PercentDeadband,
+            &pItemStates[i], &pShared[i]);
+        if (res == S_FALSE) {
+            continue;                             // not shared, read below
+        }
+        ppReadDItems[i] = NULL;
+        if (FAILED(res)) {
+            pErr[i] = res;
+            VariantInit(&pItemStates[i].vDataValue);
+        }
     }
+    m_pServerHandler->readWriteLock_.EndReading();
 
-    // read current values of the items to be handled
+    // read current values of the other items
     res = InternalRead(OPC_DS_CACHE,           // perform the read
         TotItemsToRead,
-        ppDItems,
+        ppReadDItems,
         pItemStates,
         pErr
     );
@@ -780,49 +806,87 @@ HRESULT DaGenericGroup::UpdateToClient(BOOL custom, BOOL WithTime, BOOL DataCall
 
     if (Killed() == TRUE) {
         res = S_OK;                               // update aborted due to group being deleted
-        goto UpdateToClient5;
+        goto UpdateToClient2;
     }
 
     //
     //
     // Transfer only value of changed items to the client
     //
+    // The scalar numeric items are compared in one batch with the last
+    // values sent. The other items are compared one by one.
+    const DWORD *pdwDecided, *pdwChanged;
+    if (FAILED(m_ChangeColumns.Compare(m_PercentDeadband, TotItemsToRead,
+                                       ppGItems, ppDItems, pItemStates, pErr,
+                                       &pdwDecided, &pdwChanged))) {
+        pdwDecided = pdwChanged = NULL;           // compare all items one by one
+    }
+
     BOOL fItemValueChanged;
+    LONGLONG llLastReadVersion, llSharedToken;
     TotItemsToTransmit = 0;
     for (i = 0; i < TotItemsToRead; i++) {
 
         if (FAILED(pErr[i])) {
+            ppGItems[i]->MarkDirty();             // try again with the next update
             continue;
         }
 
         fItemValueChanged = FALSE;
+        llSharedToken = ppGItems[i]->get_SharedToken();
 
-        res = ppGItems[i]->CompareLastRead(m_PercentDeadband,
-            pItemStates[i].vDataValue,    // The New Value
-            pItemStates[i].wQuality,      // The New Quality
-            fItemValueChanged);          // The Result we want
+        if (llSharedToken != 0 && llSharedToken == pShared[i].llToken) {
+            fItemValueChanged = FALSE;            // already sent by this group
+        }
+        else if (llSharedToken != 0 && llSharedToken == pShared[i].llPrevToken) {
+            fItemValueChanged = TRUE;             // changed since sent by this group
+        }
+        else if (pdwDecided && DaIsBitSet(pdwDecided, i)) {
+            fItemValueChanged = DaIsBitSet(pdwChanged, i);
+        }
+        else {
+            res = ppGItems[i]->CompareLastRead(m_PercentDeadband,
+                pItemStates[i].vDataValue,    // The New Value
+                pItemStates[i].wQuality,      // The New Quality
+                fItemValueChanged);          // The Result we want
 
-        if (FAILED(res)) {
-            continue;
+            if (FAILED(res)) {
+                ppGItems[i]->MarkDirty();             // try again with the next update
+                continue;
+            }
         }
 
         if (fItemValueChanged) {                  // Item Value has changed
 
               // Copy new value/quality to last read value/quality (even if sending doesn't work)
-            res = ppGItems[i]->UpdateLastRead(pItemStates[i].vDataValue, pItemStates[i].wQuality);
+            res = ppGItems[i]->UpdateLastRead(pItemStates[i].vDataValue, pItemStates[i].wQuality, &llLastReadVersion);
             if (FAILED(res)) {
+                ppGItems[i]->MarkDirty();         // try again with the next update
                 continue;
             }
+            m_ChangeColumns.SetLastSent(ppGItems[i]->get_ServerHandle(),
+                pItemStates[i].vDataValue, pItemStates[i].wQuality, llLastReadVersion);
+            // The value is the last value sent of the shared subscription
+            // if the subscription has changed with this update
+            ppGItems[i]->set_SharedToken(
+                (pShared[i].llToken != pShared[i].llPrevToken) ? pShared[i].llToken : 0,
+                llLastReadVersion);
             // Only items to transmit are stored in the array.
-            // Move the item data in the array.
+            // Move the item data in the array. The value is moved
+            // (not copied), the source is left empty. The items are
+            // swapped so that all items are still released below.
             if (TotItemsToTransmit != i) {
-                pItemStates[TotItemsToTransmit].hClient = pItemStates[i].hClient;
-                pItemStates[TotItemsToTransmit].ftTimeStamp = pItemStates[i].ftTimeStamp;
-                pItemStates[TotItemsToTransmit].wQuality = pItemStates[i].wQuality;
-                pItemStates[TotItemsToTransmit].wReserved = pItemStates[i].wReserved;
                 VariantClear(&pItemStates[TotItemsToTransmit].vDataValue);
-                VariantCopy(&(pItemStates[TotItemsToTransmit].vDataValue), &(pItemStates[i].vDataValue));
+                pItemStates[TotItemsToTransmit] = pItemStates[i];
+                VariantInit(&pItemStates[i].vDataValue);
                 pErr[TotItemsToTransmit] = pErr[i];
+
+                pGItem = ppGItems[TotItemsToTransmit];
+                ppGItems[TotItemsToTransmit] = ppGItems[i];
+                ppGItems[i] = pGItem;
+                pDItem = ppDItems[TotItemsToTransmit];
+                ppDItems[TotItemsToTransmit] = ppDItems[i];
+                ppDItems[i] = pDItem;
             }
             TotItemsToTransmit++;                  // keep this item
 
@@ -831,19 +895,6 @@ HRESULT DaGenericGroup::UpdateToClient(BOOL custom, BOOL WithTime, BOOL DataCall
 
     if (TotItemsToTransmit) {                   // There are items with changed values -> Transmit.
 
-        if (m_fCallbackEnable) {
-            CComObject<DaGroup>*  pCOMGroup;
-
-            m_pServer->CriticalSectionCOMGroupList.BeginReading();       // lock reading
-
-            res = m_pServer->m_COMGroupList.GetElem(m_hServerGroupHandle, &pCOMGroup);
-            if (SUCCEEDED(res)) {
-                res = pCOMGroup->FireOnDataChange(TotItemsToTransmit, pItemStates, pErr);
-            }
-
-            m_pServer->CriticalSectionCOMGroupList.EndReading();     // unlock reading
-
-        }
         if (DataCallbackOnly == FALSE) {          // Also handle IAdviseSink callbacks.
 
             if (custom) {
@@ -859,34 +910,44 @@ HRESULT DaGenericGroup::UpdateToClient(BOOL custom, BOOL WithTime, BOOL DataCall
                     pItemStates,
                     0);           // Transaction Id
             }
+            // At least sent one value successfully
+            if (SUCCEEDED(res)) {
+                OpcClockCoarse(&m_pServer->m_LastUpdateTime);
+            }
         }
-        // At least sent one value successfully
-        if (SUCCEEDED(res)) {
-            res = CoFileTimeNow(&m_pServer->m_LastUpdateTime);
+
+        if (m_fCallbackEnable) {
+            // The values are moved to the callback queue of the client and
+            // delivered by a thread of the delivery pool without owning
+            // CriticalSectionCOMGroupList. This worker doesn't wait until
+            // the client has received the callback.
+            if (m_pServer->m_CallbackQueue.Enqueue(m_hServerGroupHandle, TotItemsToTransmit,
+                                                   ppGItems, pItemStates, pErr) > 0) {
+                for (i = 0; i < TotItemsToTransmit; i++) {
+                    if (pErr[i] == E_OUTOFMEMORY) {
+                        // queue is full, send with the next update
+                        ppGItems[i]->ResetLastRead();
+                        ppGItems[i]->MarkDirty();
+                    }
+                }
+            }
+            m_pServer->m_CallbackQueue.Deliver(m_pServer);
+            res = S_OK;
         }
     }
 
-UpdateToClient5:
+UpdateToClient2:
     for (i = 0; i < TotItemsToRead; i++) {           // release the item values
         VariantClear(&pItemStates[i].vDataValue);
     }
 
-    pIMalloc->Free(pItemStates);
-
-UpdateToClient3:
-    pIMalloc->Free(pErr);                      // release error array
-
-UpdateToClient2:
+UpdateToClient1:
     for (i = 0; i < TotItemsToRead; i++) {           // release the attached items
         _ASSERTE(ppGItems[i]);
         _ASSERTE(ppDItems[i]);
         ppGItems[i]->Detach();
         ppDItems[i]->Detach();
     }
-    delete[] ppDItems;                          // free the device item array
-
-UpdateToClient1:
-    delete[] ppGItems;                          // free the generic item array
 
 UpdateToClient0:
     return res;
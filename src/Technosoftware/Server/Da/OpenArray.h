@@ -27,14 +27,166 @@
 #pragma once
 #endif // _MSC_VER >= 1000
 
+               // A handle consists of the index of the slot (low bits)
+               // and the generation of the slot (high bits). The
+               // generation is incremented if the slot is freed so
+               // that handles of removed elements are rejected.
+#define  DA_HANDLE_INDEX_BITS       20
+#define  DA_HANDLE_INDEX_MASK       ((1L << DA_HANDLE_INDEX_BITS) - 1)
+#define  DA_HANDLE_GENERATION_MASK  ((1L << (31 - DA_HANDLE_INDEX_BITS)) - 1)
+
+               // Returns the slot index of a handle. Can be used to
+               // index arrays which are associated with the handles.
+inline long DaHandleIndex( long handle )
+{
+   return handle & DA_HANDLE_INDEX_MASK;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Open Array
+// ----------
+// Slot map which assigns handles to the elements (pointers).
+//
+// New(), PutElem() and GetElem() are O(1): free slots are kept in
+// a doubly linked list which is used in FIFO order so that a slot
+// is reused as late as possible. The used slots are kept in a
+// dense array so that First() and Next() don't visit free slots.
+//
+// A handle of a removed element is stale: GetElem() fails and
+// PutElem() neither modifies a new element stored in the same slot
+// nor inserts an element into the freed slot. PutElemAt() stores
+// an element with the handle of an element of another array; the
+// free slot takes the generation of the handle.
+//
+// The current element can be removed while iterating with
+// First() / Next(). The iteration order is not the handle order.
+/////////////////////////////////////////////////////////////////
 template <class T>
 class OpenArray {
 
    private:
-      long     size;         // highest used index          
-      long     totElem;      // number of non NULL elements
-      long     allOPCize;    // allocated memory (number of elements, not bytes)
-      T       *array;        // the array of elements of class T
+      typedef struct tagSLOT {
+         T        elem;          // the element, NULL if the slot is free
+         long     generation;    // generation of the slot
+         BOOL     used;          // TRUE if the slot held an element
+         long     pos;           // index in dense (last index if free)
+         long     nextFree;      // next free slot, 0 if last
+         long     prevFree;      // previous free slot, 0 if first
+      } SLOT;
+
+      long     size;             // number of initialized slots (highest used index + 1)
+      long     totElem;          // number of non NULL elements
+      long     allOPCize;        // allocated slots
+      SLOT    *slots;            // the slots, indexed by DaHandleIndex()
+      long    *dense;            // indexes of the used slots [0, totElem)
+      long     firstFree;        // free list, slot 0 is never in the list
+      long     lastFree;
+
+         ///////////////////////////////////////////////////////////////
+         //  Builds the handle of a slot
+         ///////////////////////////////////////////////////////////////
+      long Handle( long i ) {
+         return (slots[i].generation << DA_HANDLE_INDEX_BITS) | i;
+      }
+
+         ///////////////////////////////////////////////////////////////
+         //  Free list handling
+         ///////////////////////////////////////////////////////////////
+      void LinkFree( long i ) {
+         if (i == 0) {
+            return;                                // element 0 is never used
+         }
+         slots[i].nextFree = 0;
+         slots[i].prevFree = lastFree;
+         if (lastFree) {
+            slots[lastFree].nextFree = i;
+         }
+         else {
+            firstFree = i;
+         }
+         lastFree = i;
+      }
+
+      void UnlinkFree( long i ) {
+         if (i == 0) {
+            return;
+         }
+         if (slots[i].prevFree) {
+            slots[slots[i].prevFree].nextFree = slots[i].nextFree;
+         }
+         else {
+            firstFree = slots[i].nextFree;
+         }
+         if (slots[i].nextFree) {
+            slots[slots[i].nextFree].prevFree = slots[i].prevFree;
+         }
+         else {
+            lastFree = slots[i].prevFree;
+         }
+         slots[i].nextFree = slots[i].prevFree = 0;
+      }
+
+         ///////////////////////////////////////////////////////////////
+         //  Enlarges the allocated slots so that slot idx exists
+         ///////////////////////////////////////////////////////////////
+      int Reserve( long idx ) {
+            long newallOPCize;
+            SLOT *newslots;
+            long *newdense;
+            long i;
+
+         if (idx < allOPCize) {
+            return S_OK;
+         }
+         if (allOPCize == 0) {                     // first allocation
+            newallOPCize = 4;
+         } else {
+            newallOPCize = allOPCize*2;            // standard enlargement
+         }
+         while (idx >= newallOPCize) {
+            newallOPCize *= 2;
+         }
+         if (newallOPCize > DA_HANDLE_INDEX_MASK + 1) {
+            newallOPCize = DA_HANDLE_INDEX_MASK + 1;
+         }
+
+         newslots = new SLOT[newallOPCize];
+         if (newslots == NULL) {
+            return E_OUTOFMEMORY;
+         }
+         newdense = new long[newallOPCize];
+         if (newdense == NULL) {
+            delete [] newslots;
+            return E_OUTOFMEMORY;
+         }
+         for (i = 0; i < size; i++) {              // copy old slots to new array
+            newslots[i] = slots[i];
+         }
+         for (i = 0; i < totElem; i++) {
+            newdense[i] = dense[i];
+         }
+         if (slots) {
+            delete [] slots;
+            delete [] dense;
+         }
+         slots = newslots;
+         dense = newdense;
+         allOPCize = newallOPCize;
+         return S_OK;
+      }
+
+         ///////////////////////////////////////////////////////////////
+         //  Stores an element in the free slot i
+         ///////////////////////////////////////////////////////////////
+      void Insert( long i, long idx, T elem ) {
+         UnlinkFree( i );
+         slots[i].elem = elem;
+         slots[i].generation = (idx >> DA_HANDLE_INDEX_BITS) & DA_HANDLE_GENERATION_MASK;
+         slots[i].used = TRUE;
+         slots[i].pos = totElem;
+         dense[totElem++] = i;
+      }
 
    public:
       //!temp!//const static int E_OK;
@@ -46,19 +198,24 @@ class OpenArray {
          //   Constructor
          ///////////////////////////////////////////////////////////////
      OpenArray() {
-         array       = NULL;
+         slots       = NULL;
+         dense       = NULL;
          allOPCize   = 0;
          size        = 0;
          totElem     = 0;
+         firstFree   = 0;
+         lastFree    = 0;
       }
 
          ///////////////////////////////////////////////////////////////
          //   Desstructor
          ///////////////////////////////////////////////////////////////
       ~OpenArray() {
-         if (array != NULL) {
-            delete [] array;
-			array = NULL;
+         if (slots != NULL) {
+            delete [] slots;
+            slots = NULL;
+            delete [] dense;
+            dense = NULL;
          }
 
       }
@@ -66,7 +223,7 @@ class OpenArray {
 
 
          ///////////////////////////////////////////////////////////////
-         // Get the highest allocated element index
+         // Get the highest allocated element index + 1
          ///////////////////////////////////////////////////////////////
       long Size() {
          return size;
@@ -75,19 +232,23 @@ class OpenArray {
 
 
          ///////////////////////////////////////////////////////////////
-         //  Returns the 1st free index.
-         //  If new element is free then size+1 is returned.
+         //  Returns the handle of the 1st free slot.
+         //  If there is no free slot then the handle of a new slot is
+         //  returned. Returns -1 if the maximum number of slots is
+         //  reached.
          ///////////////////////////////////////////////////////////////
       long New( void )
       {
-            long i;
-
-         for( i=1 ; i < allOPCize ; ++i ) {        // search from 1 because element 0 is never used.
-            if( array[i] == NULL ) {               // is free
-               return i;
-            }
+         if (firstFree) {
+            return Handle( firstFree );
+         }
+         if (size == 0) {
+            return 1;                              // element 0 is never used
          }
-         return allOPCize;
+         if (size > DA_HANDLE_INDEX_MASK) {
+            return -1;
+         }
+         return size;
       }
 
 
@@ -107,86 +268,110 @@ class OpenArray {
 
 
          ///////////////////////////////////////////////////////////////
-         //  Get the element at the given index
+         //  Get the element with the given handle
          ///////////////////////////////////////////////////////////////
       int GetElem( long idx, T *elem ) {
+            long i;
+
          if( idx < 0 ) {
             *elem = NULL;                          
             return E_INVALIDARG;
          }
-         if( idx >= size ) {
+         i = DaHandleIndex( idx );
+         if( i >= size ||
+             slots[i].elem == NULL ||
+             Handle( i ) != idx ) {                // free or stale handle
             *elem = NULL;
             return E_FAIL;   
          }
-         *elem = array[idx];
-         if( *elem )          return S_OK;         
-         else                 return E_FAIL;       // NULL element is error
+         *elem = slots[i].elem;
+         return S_OK;
       }
 
 
 
          ///////////////////////////////////////////////////////////////
-         //  Store the given element at the given index.
-         //  NULL as the element frees the specified index.
-         //  If the given element index is above the allocated array
-         //  sie, then the array size is increased.
+         //  Store the given element with the given handle.
+         //  NULL as the element frees the specified handle.
+         //  If the given handle is above the allocated array
+         //  size, then the array size is increased.
          ///////////////////////////////////////////////////////////////
-      int PutElem( long idx,     // element index
+      int PutElem( long idx,     // element handle
                    T    elem ) { // NULL deletes the entry
       
-            long newallOPCize;
-            T *newarray;
-            long i;
+            long i, j;
+            HRESULT hres;
       
-         if( idx < 0 ) {                           // illegal index
+         if( idx < 0 ) {                           // illegal handle
             return E_INVALIDARG;
          }
-         if( idx >= allOPCize ) {                  // above current size
-      
-            if (allOPCize == 0) {                  // first allocation
-               newallOPCize = 4;
-            } else {
-               newallOPCize = allOPCize*2;         // standard enlargement
+         i = DaHandleIndex( idx );
+
+         if( i >= size ) {                         // slot not yet initialized
+            hres = Reserve( i );
+            if (FAILED( hres )) {
+               return hres;
             }
-      
-                  // Heuristic: new size = new allOPCize * 2
-            while( idx >= newallOPCize ) {           
-               newallOPCize *= 2;
+            for (j = size; j <= i; j++) {         // new slots are free
+               slots[j].elem = NULL;
+               slots[j].generation = 0;
+               slots[j].used = FALSE;
+               slots[j].pos = 0;
+               LinkFree( j );
             }
-      
-               // Must allocate a new array filling the undefined elements with NULLs
-            newarray = new T[newallOPCize];
-            if( newarray == NULL ) {
-               return E_OUTOFMEMORY;               // error
-            }
-      
-            for( i = allOPCize ; i < newallOPCize ; i++ ) {
-               newarray[i] = NULL;                 // zero the allocated array
+            size = i + 1;
+         }
+                                     // now handle the element
+         if( slots[i].elem != NULL ) {
+            if (Handle( i ) != idx) {              // stale handle
+               return E_INVALIDARG;
             }
-            if( allOPCize > 0 ) {                  // copy old elements to new array
-                                                   // this could be done with memcpy
-               for( i = 0 ; i < allOPCize ; i++ ) {
-                  newarray[i] = array[i];
-               }
-               delete [] array;                    // free old array
+            if (elem != NULL) {                    // replacing a element
+               slots[i].elem = elem;
+               return S_OK;
             }
-            array = newarray;                      // switch to the new array
-            allOPCize = newallOPCize;
+                                                   // deleting a element
+            j = dense[--totElem];                  // move the last used slot
+            dense[slots[i].pos] = j;
+            slots[j].pos = slots[i].pos;
+
+            slots[i].elem = NULL;
+            slots[i].generation = (slots[i].generation + 1) & DA_HANDLE_GENERATION_MASK;
+            LinkFree( i );
+            return S_OK;
          }
-                                     // now handle the element
-         if( array[idx] != NULL ) {               // deleting a element
-            totElem --;
+
+         if( elem != NULL ) {                     // inserting a element
+            if (slots[i].used && Handle( i ) != idx) {
+               return E_INVALIDARG;                // stale handle
+            }
+            Insert( i, idx, elem );
          }
+         return S_OK;
+      }
 
-         array[idx] = elem; 
 
-         if( elem != NULL ) {                     // inserting a element
-            totElem ++;
+
+         ///////////////////////////////////////////////////////////////
+         //  Store the given element with the handle of an element of
+         //  another array, so that both arrays can be accessed with the
+         //  same handle. The slot must be free; it takes the generation
+         //  of the handle.
+         ///////////////////////////////////////////////////////////////
+      int PutElemAt( long idx, T elem ) {
+            long i;
+
+         if( idx < 0 || elem == NULL ) {
+            return E_INVALIDARG;
          }
-         if( idx >= size ) {                      // adapt highest used index
-            size = idx+1;
+         i = DaHandleIndex( idx );
+         if( i >= size ) {                         // the slot is free
+            return PutElem( idx, elem );
          }
-
+         if( slots[i].elem != NULL ) {
+            return E_INVALIDARG;
+         }
+         Insert( i, idx, elem );
          return S_OK;
       }
 
@@ -202,17 +387,13 @@ class OpenArray {
 
 
          ///////////////////////////////////////////////////////////////
-         //  Returns the index of the 1st used item
+         //  Returns the handle of the 1st used item
          ///////////////////////////////////////////////////////////////
       int First( long *idx )
       {
-            long i;
-
-         for( i=0 ; i < size ; ++i ) {
-            if( array[i] != NULL ) {         // in use
-               *idx = i;
-               return S_OK;
-            }
+         if (totElem > 0) {
+            *idx = Handle( dense[0] );
+            return S_OK;
          }
          *idx = 0;
          return E_FAIL;
@@ -221,19 +402,24 @@ class OpenArray {
 
 
          ///////////////////////////////////////////////////////////////
-         //  Returns the index of the next used item
+         //  Returns the handle of the next used item.
+         //  If the element of idxFrom has been removed then the
+         //  element which took its place is returned.
          ///////////////////////////////////////////////////////////////
       int Next( long idxFrom, long *idxNext )
       {
-            long i;
+            long i, pos;
 
-         i = idxFrom + 1;
-         while ( i < size ) {
-            if ( array[i] != NULL ) {
-               *idxNext = i;
+         i = DaHandleIndex( idxFrom );
+         if ( idxFrom >= 0 && i < size ) {
+            pos = slots[i].pos;
+            if ( slots[i].elem != NULL && Handle( i ) == idxFrom ) {
+               pos++;                              // still used
+            }
+            if ( pos < totElem ) {
+               *idxNext = Handle( dense[pos] );
                return S_OK;
             }
-            i++;
          }
 
          *idxNext = 0;
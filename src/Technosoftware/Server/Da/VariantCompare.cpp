@@ -172,8 +172,11 @@ _variant_t operator-( const VARIANT Minuend, const VARIANT Subtrahend )
 // --------------------
 //    Compares two simple variants and checks if the values are identical.
 //    Also Percent Deadband range check is supported.
+//    EUType and dAnalogEURange are the cached EU data of the Device Item
+//    (see DaDeviceItem::get_DeadbandEUInfo()).
 //=================================================================================
 static HRESULT CompareSimpleVariant( DaDeviceItem& DItem,
+									OPCEUTYPE EUType, double dAnalogEURange,
 									float fltPercentDeadband,
 									const VARIANT& varLast, const VARIANT& varNew, BOOL& fItemValueChanged )
 {
@@ -183,14 +186,6 @@ static HRESULT CompareSimpleVariant( DaDeviceItem& DItem,
 
 	fItemValueChanged = FALSE;
 
-	OPCEUTYPE   EUType;
-	_variant_t  vEUInfo;
-
-	HRESULT hres = DItem.get_EUData( &EUType, &vEUInfo );
-	if (FAILED( hres )) {
-		return hres;
-	}
-
 	try {
 
 		if (EUType == OPC_ANALOG) {
@@ -211,13 +206,27 @@ static HRESULT CompareSimpleVariant( DaDeviceItem& DItem,
 				return S_OK;
 		 }
 
-			double dAnalogEURange;
-			hres = DItem.get_AnalogEURange( &dAnalogEURange );
-			if (FAILED( hres )) {
-				return hres;
-		 }
-
 			double      dDeadbandRange = (fltPercentDeadband/100) * ( dAnalogEURange );
+
+			// Fast path for the most common data types. The difference is
+			// calculated directly without _variant_t arithmetic.
+			switch (V_VT( &varNew )) {
+			case VT_R8:
+				fItemValueChanged = fabs( V_R8( &varLast ) - V_R8( &varNew ) ) > dDeadbandRange;
+				return S_OK;
+
+			case VT_R4:
+				fItemValueChanged = fabs( (double)V_R4( &varLast ) - (double)V_R4( &varNew ) ) > dDeadbandRange;
+				return S_OK;
+
+			case VT_I4:
+				fItemValueChanged = fabs( (double)V_I4( &varLast ) - (double)V_I4( &varNew ) ) > dDeadbandRange;
+				return S_OK;
+
+			default:                         // calculate the difference below
+				break;
+			}
+
 			_variant_t  varDiff;
 			// Note :
 			//    varNew and varLast are values in the requested data type format.
@@ -227,10 +236,7 @@ static HRESULT CompareSimpleVariant( DaDeviceItem& DItem,
 
 			switch (V_VT( &varNew )) {
 			case VT_I2:                      // values already in a data type format which is valid
-			case VT_I4:                      // for Items with Analog EU Info. No conversion is required.
-			case VT_R4:
-			case VT_R8:
-				varDiff = varLast - varNew;
+				varDiff = varLast - varNew;      // for Items with Analog EU Info. No conversion is required.
 				break;
 
 			case VT_UI1:                     // usnigned value, only the absolute difference is required
@@ -333,13 +339,16 @@ static HRESULT CompareSimpleVariant( DaDeviceItem& DItem,
 
 
 //=================================================================================
-// CompareVariant
-// --------------
+// CompareVariantEU
+// ----------------
 //    Compares two variants (incl. SAFEARRAYs) and checks if the values
 //    are identical. Also Percent Deadband range check is supported.
+//    EUType and dAnalogEURange are the cached EU data of the Device Item.
 //=================================================================================
-HRESULT CompareVariant( DaDeviceItem& DItem, float fltPercentDeadband,
-					   const VARIANT& varLast, const VARIANT& varNew, BOOL& fItemValueChanged )
+static HRESULT CompareVariantEU( DaDeviceItem& DItem,
+								OPCEUTYPE EUType, double dAnalogEURange,
+								float fltPercentDeadband,
+								const VARIANT& varLast, const VARIANT& varNew, BOOL& fItemValueChanged )
 {
 	if (V_VT( &varNew ) != V_VT( &varLast )) {
 		fItemValueChanged = TRUE;                 // Not identical if type changed.
@@ -409,7 +418,7 @@ HRESULT CompareVariant( DaDeviceItem& DItem, float fltPercentDeadband,
 			case VT_VARIANT   :                 // compare single VARIANTs
 				// ------------------------------------------------------------------
 				for (i=lLowerBoundNew; i<=lUpperBoundNew; i++) {
-					hres = CompareVariant( DItem, fltPercentDeadband, ((VARIANT *)saLast.pvData)[i], ((VARIANT *)saNew.pvData)[i], fItemValueChanged );
+					hres = CompareVariantEU( DItem, EUType, dAnalogEURange, fltPercentDeadband, ((VARIANT *)saLast.pvData)[i], ((VARIANT *)saNew.pvData)[i], fItemValueChanged );
 					if (fItemValueChanged || FAILED( hres )) {
 						break;
 					}
@@ -502,7 +511,7 @@ HRESULT CompareVariant( DaDeviceItem& DItem, float fltPercentDeadband,
 						break;
 					}
 					// Compare the extracted variant value.
-					hres = CompareVariant( DItem, fltPercentDeadband, varLastElem, varNewElem, fItemValueChanged );
+					hres = CompareVariantEU( DItem, EUType, dAnalogEURange, fltPercentDeadband, varLastElem, varNewElem, fItemValueChanged );
 					if (fItemValueChanged || FAILED( hres )) {
 						break;
 					}
@@ -530,11 +539,33 @@ HRESULT CompareVariant( DaDeviceItem& DItem, float fltPercentDeadband,
 		// 
 		// Item Value is not an ARRAY
 		//
-		return CompareSimpleVariant( DItem, fltPercentDeadband, varLast, varNew, fItemValueChanged );
+		return CompareSimpleVariant( DItem, EUType, dAnalogEURange, fltPercentDeadband, varLast, varNew, fItemValueChanged );
 	}
 
 	return S_OK;
 
+} // CompareVariantEU
+
+
+
+//=================================================================================
+// CompareVariant
+// --------------
+//    Compares two variants (incl. SAFEARRAYs) and checks if the values
+//    are identical. Also Percent Deadband range check is supported.
+//    The EU data of the Device Item is read only once for all elements.
+//=================================================================================
+HRESULT CompareVariant( DaDeviceItem& DItem, float fltPercentDeadband,
+					   const VARIANT& varLast, const VARIANT& varNew, BOOL& fItemValueChanged )
+{
+	OPCEUTYPE   EUType;
+	double      dAnalogEURange;
+
+	DItem.get_DeadbandEUInfo( &EUType, &dAnalogEURange );
+
+	return CompareVariantEU( DItem, EUType, dAnalogEURange, fltPercentDeadband,
+							 varLast, varNew, fItemValueChanged );
+
 } // CompareVariant     
 
 //DOM-IGNORE-END
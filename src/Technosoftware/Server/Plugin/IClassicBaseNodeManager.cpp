@@ -100,6 +100,76 @@ HRESULT CreateOneItem(
     return hres;
 }
 
+// Initializes the EU Info of an analog item. The EU Info must contain
+// exactly two doubles corresponding to the LOW and HI EU range.
+// Throws an HRESULT on failure.
+static void InitAnalogEUInfo(double minValue, double maxValue, LPVARIANT euInformation)
+{
+    VariantInit(euInformation);
+    V_VT(euInformation) = VT_ARRAY | VT_R8;
+
+    SAFEARRAYBOUND rgs;
+    rgs.cElements = 2;
+    rgs.lLbound = 0;
+
+    try {
+        CHECK_PTR(V_ARRAY(euInformation) = SafeArrayCreate(VT_R8, 1, &rgs))
+        // put initialized variant into array
+        double dLow = minValue;
+        double dHi = maxValue;
+        long lElIndex;
+
+        lElIndex = 0;                               // LOW EU range
+        CHECK_RESULT(SafeArrayPutElement(V_ARRAY(euInformation), &lElIndex, &dLow))
+        lElIndex++;                                 // HI EU range
+        CHECK_RESULT(SafeArrayPutElement(V_ARRAY(euInformation), &lElIndex, &dHi))
+    }
+    catch (HRESULT) {                               // cleanup if failure
+        VariantClear(euInformation);
+        throw;
+    }
+}
+
+// Creates the Device Item of an item definition without adding it to the
+// item list. The created item is returned in deviceItem or nullptr if failed.
+static HRESULT CreateItemInstance(DaItemDefinition* item, DeviceItem** deviceItem)
+{
+    HRESULT     hres;
+    OPCEUTYPE   euType = static_cast<OPCEUTYPE>(item->EuType);
+    VARIANT     varEUInfo;
+
+    *deviceItem = nullptr;
+    VariantInit(&varEUInfo);
+    if (euType == OPC_ANALOG) {
+        try {
+            InitAnalogEUInfo(item->MinValue, item->MaxValue, &varEUInfo);
+        }
+        catch (HRESULT hresEx) {
+            return hresEx;
+        }
+    }
+    else if (euType != OPC_NOENUM) {
+        return E_INVALIDARG;                        // Enumerated items are not supported
+    }
+
+    DeviceItem* pDItem = new DeviceItem;            // Allocate space for new server item.
+    if (pDItem == nullptr) {
+        hres = E_OUTOFMEMORY;
+    }
+    else {                                          // Initialize new Item instance
+        hres = pDItem->Create(item->ItemId, static_cast<DWORD>(item->AccessRights), &item->InitValue, item->Active,
+                              0, nullptr, nullptr, euType, (euType == OPC_ANALOG) ? &varEUInfo : nullptr);
+        if (FAILED(hres)) {
+            delete pDItem;
+        }
+        else {
+            *deviceItem = pDItem;
+        }
+    }
+    VariantClear(&varEUInfo);
+    return hres;
+}
+
 HRESULT DLLCALL AddItem(LPWSTR itemId, DaAccessRights accessRights, LPVARIANT initValue, bool active, DaEuType euType, double minValue, double maxValue, void** deviceItem)
 {
     HRESULT hres = S_OK;
@@ -123,32 +193,8 @@ HRESULT DLLCALL AddItem(LPWSTR itemId, DaAccessRights accessRights, LPVARIANT in
     {
         if (static_cast<OPCEUTYPE>(euType) == OPC_ANALOG)
         {
-            // EU Info must contain exaclty two doubles
-            // corresponding to the LOW and HI EU range.
             VARIANT varEUInfo;
-            VariantInit(&varEUInfo);
-            V_VT(&varEUInfo) = VT_ARRAY | VT_R8;
-
-            SAFEARRAYBOUND rgs;
-            rgs.cElements = 2;
-            rgs.lLbound = 0;
-
-            try {
-                CHECK_PTR(V_ARRAY(&varEUInfo) = SafeArrayCreate(VT_R8, 1, &rgs))
-                    // put initialized variant into array
-                    double dLow = minValue;
-                double dHi = maxValue;
-                long lElIndex;
-
-                lElIndex = 0;                       // LOW EU range
-                CHECK_RESULT(SafeArrayPutElement(V_ARRAY(&varEUInfo), &lElIndex, &dLow))
-                    lElIndex++;                     // HI EU range
-                CHECK_RESULT(SafeArrayPutElement(V_ARRAY(&varEUInfo), &lElIndex, &dHi))
-            }
-            catch (HRESULT) {                       // cleanup if failure
-                VariantClear(&varEUInfo);
-                throw;
-            }
+            InitAnalogEUInfo(minValue, maxValue, &varEUInfo);
             hres = CreateOneItem(
                 itemId,                             // ItemId
                 static_cast<DWORD>(accessRights),   // DaAccessRights
@@ -180,6 +226,49 @@ HRESULT DLLCALL AddAnalogItem(LPWSTR itemId, DaAccessRights accessRights, LPVARI
     return AddItem(itemId, accessRights, initValue, true, Analog, minValue, maxValue, deviceItem);
 }
 
+HRESULT DLLCALL AddItems(int count, DaItemDefinition* items, void** deviceItemHandles, HRESULT* errors)
+{
+    HRESULT hres;
+
+    if (count < 0 || (count > 0 && (items == nullptr || errors == nullptr))) {
+        return E_INVALIDARG;
+    }
+    if (count == 0) {
+        return S_OK;
+    }
+
+    DeviceItem** ppDItems = new DeviceItem*[count];
+    if (ppDItems == nullptr) {
+        for (int i = 0; i < count; i++) {
+            VariantClear(&items[i].InitValue);
+        }
+        return E_OUTOFMEMORY;
+    }
+
+    // Create all instances first; the item list is then locked only once.
+    BOOL fCreateFailed = FALSE;
+    for (int i = 0; i < count; i++) {
+        errors[i] = CreateItemInstance(&items[i], &ppDItems[i]);
+        if (FAILED(errors[i])) {
+            fCreateFailed = TRUE;
+        }
+        VariantClear(&items[i].InitValue);
+    }
+
+    hres = gpDataServer->AddDeviceItems(static_cast<DWORD>(count), ppDItems, errors);
+    if (hres == S_OK && fCreateFailed) {
+        hres = S_FALSE;
+    }
+
+    if (deviceItemHandles != nullptr) {
+        for (int i = 0; i < count; i++) {
+            deviceItemHandles[i] = ppDItems[i];     // nullptr if not added
+        }
+    }
+    delete[] ppDItems;
+    return hres;
+}
+
 HRESULT DLLCALL RemoveItem(void* deviceItem)
 {
     HRESULT hres;
@@ -239,26 +328,95 @@ HRESULT DLLCALL SetItemValue(
     HRESULT hres;
     DeviceItem* pItem = static_cast<DeviceItem*>(deviceItemHandle);
 
-    gpDataServer->readWriteLock_.BeginWriting(); // We are manipulating the DeviceItem make
-    // sure no one else gets access during update.
+    // No server wide lock: the cache of the item is protected by
+    // the item itself, so updates of different items run in parallel.
+    // Same error codes as SetItemValues()
     if (pItem == nullptr) {
-        gpDataServer->readWriteLock_.EndWriting(); // UnLock DeviceItem
-        hres = S_FALSE;
+        hres = OPC_E_INVALIDHANDLE;
         return(hres);
     }
 
-    if (newValue == nullptr || V_VT(newValue) == VT_NULL) {
+    if (newValue == nullptr || V_VT(newValue) == VT_EMPTY || V_VT(newValue) == VT_NULL) {
         // Update only quality and time stamp
         hres = pItem->set_ItemQuality(quality, &timestamp);
     }
     else {
         hres = pItem->set_ItemValue(newValue, quality, &timestamp);
     }
-    gpDataServer->readWriteLock_.EndWriting(); // UnLock DeviceItem
 
     return hres;
 }
 
+// Number of handles converted to Device Items on the stack
+#define SETITEMVALUES_BLOCK 256
+
+static HRESULT SetItemValuesInBlocks(
+    int count,
+    void** deviceItemHandles,
+    LPVARIANT newValues,
+    short* qualities,
+    FILETIME* timestamps,
+    HRESULT* errors
+    )
+{
+    DaDeviceItem* apItems[SETITEMVALUES_BLOCK];
+    HRESULT hres = S_OK;
+
+    if (count < 0 || (count > 0 && (deviceItemHandles == nullptr || qualities == nullptr || errors == nullptr))) {
+        return E_INVALIDARG;
+    }
+
+    for (int i = 0; i < count; i += SETITEMVALUES_BLOCK) {
+        DWORD dwBlock = static_cast<DWORD>(min(count - i, SETITEMVALUES_BLOCK));
+        for (DWORD b = 0; b < dwBlock; b++) {
+            apItems[b] = static_cast<DeviceItem*>(deviceItemHandles[i + b]);
+        }
+        // The data types are checked in one pass and the current time
+        // is determined once per block if no time stamps are specified.
+        HRESULT hresBlock = DaDeviceItem::SetItemValues(
+            dwBlock,
+            apItems,
+            newValues ? &newValues[i] : nullptr,
+            reinterpret_cast<WORD*>(&qualities[i]),
+            timestamps ? &timestamps[i] : nullptr,
+            &errors[i]);
+        if (FAILED(hresBlock)) {
+            return hresBlock;
+        }
+        if (hresBlock == S_FALSE) {
+            hres = S_FALSE;
+        }
+    }
+    return hres;
+}
+
+HRESULT DLLCALL SetItemValues(
+    int count,
+    void** deviceItemHandles,
+    LPVARIANT newValues,
+    short* qualities,
+    FILETIME* timestamps,
+    HRESULT* errors
+    )
+{
+    if (count > 0 && newValues == nullptr) {
+        return E_INVALIDARG;
+    }
+    return SetItemValuesInBlocks(count, deviceItemHandles, newValues, qualities, timestamps, errors);
+}
+
+HRESULT DLLCALL SetItemQualities(
+    int count,
+    void** deviceItemHandles,
+    short* qualities,
+    FILETIME* timestamps,
+    HRESULT* errors
+    )
+{
+    // Update only quality and time stamp
+    return SetItemValuesInBlocks(count, deviceItemHandles, nullptr, qualities, timestamps, errors);
+}
+
 void DLLCALL SetServerState(ServerState serverState)
 {
     gpDataServer->SetServerState(static_cast<OPCSERVERSTATE>(serverState));
@@ -308,6 +466,113 @@ void GetGroupState(void * groupHandle, DaGroupState * groupState)
     gpDataServer->GetGroupState(groupHandle, groupState);
 }
 
+void DLLCALL GetGroupUpdateTiming(void * groupHandle, DWORD * effectiveUpdateRate, DWORD * updateLag)
+{
+    gpDataServer->GetGroupUpdateTiming(groupHandle, effectiveUpdateRate, updateLag);
+}
+
+void DLLCALL GetUpdateCycleStatistics(DaUpdateCycleStatistics * statistics)
+{
+    DAUPDATECYCLESTATS stats;
+
+    gpDataServer->GetUpdateCycleStatistics(&stats);
+    statistics->RefreshDuration = stats.dwRefreshDuration;
+    statistics->RefreshLoad = stats.dwRefreshLoad;
+    statistics->UpdateDuration = stats.dwUpdateDuration;
+    statistics->UpdateInterval = stats.dwUpdateInterval;
+    statistics->Backlog = stats.dwBacklog;
+    statistics->Load = stats.dwLoad;
+    statistics->Stretch = stats.dwStretch;
+    statistics->Cycles = stats.ullCycles;
+    statistics->Overruns = stats.ullOverruns;
+}
+
+void DLLCALL GetItemSubscriberCount(void * deviceItemHandle, int * numSubscribers, int * numActiveSubscribers)
+{
+    gpDataServer->GetItemSubscriberCount(deviceItemHandle, numSubscribers, numActiveSubscribers);
+}
+
+void DLLCALL SetCallbackQueueLimit(DWORD callbackQueueLimit)
+{
+    gpDataServer->SetCallbackQueueLimit(callbackQueueLimit);
+}
+
+DWORD DLLCALL GetCallbackQueueLimit()
+{
+    return gpDataServer->GetCallbackQueueLimit();
+}
+
+void DLLCALL GetCallbackQueueStatistics(void * clientHandle, DaCallbackQueueStatistics * statistics)
+{
+    DACALLBACKQUEUESTATS stats;
+
+    gpDataServer->GetCallbackQueueStatistics(clientHandle, &stats);
+    statistics->QueuedItems = stats.dwQueuedItems;
+    statistics->MaxItems = stats.dwMaxItems;
+    statistics->Delivered = stats.ullDelivered;
+    statistics->Conflated = stats.ullConflated;
+    statistics->Dropped = stats.ullDropped;
+}
+
+void DLLCALL SetDeviceReadCoalescingWindow(DWORD coalescingWindow)
+{
+    gpDataServer->SetDeviceReadCoalescingWindow(coalescingWindow);
+}
+
+DWORD DLLCALL GetDeviceReadCoalescingWindow()
+{
+    return gpDataServer->GetDeviceReadCoalescingWindow();
+}
+
+void DLLCALL GetDeviceReadStatistics(DaDeviceReadStatistics * statistics)
+{
+    DADEVICEREADSTATS stats;
+
+    gpDataServer->GetDeviceReadStatistics(&stats);
+    statistics->CoalescingWindow = stats.dwWindow;
+    statistics->RequestedItems = stats.ullRequestedItems;
+    statistics->DeviceReads = stats.ullDeviceReads;
+    statistics->ReadItems = stats.ullReadItems;
+    statistics->JoinedItems = stats.ullJoinedItems;
+}
+
+void DLLCALL SetAsyncTransactionLimits(DWORD clientLimit, DWORD serverLimit)
+{
+    gpDataServer->SetAsyncTransactionLimits(clientLimit, serverLimit);
+}
+
+void DLLCALL GetAsyncAdmissionStatistics(DaAsyncAdmissionStatistics * statistics)
+{
+    DAASYNCADMISSIONSTATS stats;
+
+    gpDataServer->GetAsyncAdmissionStatistics(&stats);
+    statistics->ClientLimit = stats.dwClientLimit;
+    statistics->ServerLimit = stats.dwServerLimit;
+    statistics->Outstanding = stats.dwOutstanding;
+    statistics->Queued = stats.dwQueued;
+    statistics->Admitted = stats.ullAdmitted;
+    statistics->RejectedClient = stats.ullRejectedClient;
+    statistics->RejectedServer = stats.ullRejectedServer;
+}
+
+DWORD DLLCALL GetClientAsyncTransactions(void * clientHandle)
+{
+    return gpDataServer->GetClientAsyncTransactions(clientHandle);
+}
+
+void DLLCALL GetDeviceItemMemoryStatistics(DaDeviceItemMemoryStatistics * statistics)
+{
+    DADEVICEITEMMEMSTATS stats;
+
+    gpDataServer->GetDeviceItemMemoryStatistics(&stats);
+    statistics->Items = stats.dwItems;
+    statistics->ItemSize = stats.dwItemSize;
+    statistics->StringBytes = stats.ullStringBytes;
+    statistics->EUInfoBytes = stats.ullEUInfoBytes;
+    statistics->ValueBytes = stats.ullValueBytes;
+    statistics->BytesPerItem = stats.dwBytesPerItem;
+}
+
 void DLLCALL FireShutdownRequest(LPCWSTR reason)
 {
     gpDataServer->FireShutdownRequest(reason);
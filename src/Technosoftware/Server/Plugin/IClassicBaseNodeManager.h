@@ -269,6 +269,36 @@ struct DaQuality
 
 };
 
+/**
+ * @struct    DaItemDefinition
+ *
+ * @brief    Contains the definition of an item added with AddItems.
+ */
+
+struct DaItemDefinition
+{
+    /// Fully qualified item name.
+    LPWSTR ItemId;
+
+    /// Access rights of the item.
+    DaAccessRights AccessRights;
+
+    /// Initial value which also defines the canonical data type.
+    VARIANT InitValue;
+
+    /// true to set the item in active state.
+    bool Active;
+
+    /// Type of the Engineering Unit, NoEnum or Analog.
+    DaEuType EuType;
+
+    /// Analog engineering unit, corresponding to the LOW EU range.
+    double MinValue;
+
+    /// Analog engineering unit, corresponding to the HIGH EU range.
+    double MaxValue;
+};
+
 /**
  * @enum    DaBrowseMode
  *
@@ -531,6 +561,263 @@ public:
     void*   DeviceItemHandle;
 };
 
+/**
+ * @class   DaCallbackQueueStatistics
+ *
+ * @brief   The counters of the queue of the IOPCDataCallback::OnDataChange callbacks of a
+ *          client.
+ */
+
+class DaCallbackQueueStatistics
+{
+    // Attributes
+public:
+    /**
+     * @brief   Number of item values waiting for delivery.
+     */
+
+    DWORD       QueuedItems;
+
+    /**
+     * @brief   Maximum number of item values which can be queued (see SetCallbackQueueLimit).
+     */
+
+    DWORD       MaxItems;
+
+    /**
+     * @brief   Number of OnDataChange callbacks delivered.
+     */
+
+    ULONGLONG   Delivered;
+
+    /**
+     * @brief   Number of queued values replaced by a newer value of the same item.
+     */
+
+    ULONGLONG   Conflated;
+
+    /**
+     * @brief   Number of values not queued because the queue was full. These items are sent
+     *          with a later update.
+     */
+
+    ULONGLONG   Dropped;
+};
+
+/**
+ * @class   DaUpdateCycleStatistics
+ *
+ * @brief   The cost and the overload state of the periodic update cycle of the server.
+ *          
+ *          If the update workers are overloaded the update rates of all groups are stretched
+ *          by the factor Stretch and recovered step by step if the load drops.
+ */
+
+class DaUpdateCycleStatistics
+{
+    // Attributes
+public:
+    /**
+     * @brief   Duration of the last input cache refresh in ms.
+     */
+
+    DWORD       RefreshDuration;
+
+    /**
+     * @brief   Smoothed refresh duration in percent of the base update rate.
+     */
+
+    DWORD       RefreshLoad;
+
+    /**
+     * @brief   Time in ms the update workers spent on client updates during the last interval.
+     */
+
+    DWORD       UpdateDuration;
+
+    /**
+     * @brief   Length of the last interval in ms.
+     */
+
+    DWORD       UpdateInterval;
+
+    /**
+     * @brief   Number of groups still queued to the update workers when the last cycle started.
+     */
+
+    DWORD       Backlog;
+
+    /**
+     * @brief   Smoothed utilization of the update workers in percent.
+     */
+
+    DWORD       Load;
+
+    /**
+     * @brief   Factor in percent by which the group update rates are stretched; 100 if the
+     *          server is not overloaded.
+     */
+
+    DWORD       Stretch;
+
+    /**
+     * @brief   Number of update cycles.
+     */
+
+    ULONGLONG   Cycles;
+
+    /**
+     * @brief   Number of update cycles which exceeded the base update rate.
+     */
+
+    ULONGLONG   Overruns;
+};
+
+/**
+ * @class   DaDeviceReadStatistics
+ *
+ * @brief   The counters of the device reads (OnRefreshItems) done for client reads from the
+ *          device.
+ */
+
+class DaDeviceReadStatistics
+{
+    // Attributes
+public:
+    /**
+     * @brief   The coalescing window in ms (see SetDeviceReadCoalescingWindow).
+     */
+
+    DWORD       CoalescingWindow;
+
+    /**
+     * @brief   Number of items requested by the clients to be read from the device.
+     */
+
+    ULONGLONG   RequestedItems;
+
+    /**
+     * @brief   Number of OnRefreshItems calls.
+     */
+
+    ULONGLONG   DeviceReads;
+
+    /**
+     * @brief   Number of items passed to OnRefreshItems.
+     */
+
+    ULONGLONG   ReadItems;
+
+    /**
+     * @brief   Number of requested items served by the read of another request.
+     */
+
+    ULONGLONG   JoinedItems;
+};
+
+/**
+ * @class   DaAsyncAdmissionStatistics
+ *
+ * @brief   The limits and counters of the admission control for the asynchronous transactions
+ *          (read, write, refresh) of the clients.
+ */
+
+class DaAsyncAdmissionStatistics
+{
+    // Attributes
+public:
+    /**
+     * @brief   Maximum number of outstanding transactions of a client; 0 if unlimited.
+     */
+
+    DWORD       ClientLimit;
+
+    /**
+     * @brief   Maximum number of outstanding transactions of all clients; 0 if unlimited.
+     */
+
+    DWORD       ServerLimit;
+
+    /**
+     * @brief   Number of admitted transactions which are not yet completed.
+     */
+
+    DWORD       Outstanding;
+
+    /**
+     * @brief   Number of transactions waiting for a worker thread.
+     */
+
+    DWORD       Queued;
+
+    /**
+     * @brief   Number of admitted transactions.
+     */
+
+    ULONGLONG   Admitted;
+
+    /**
+     * @brief   Number of transactions rejected with CONNECT_E_ADVISELIMIT because the client
+     *          limit was reached.
+     */
+
+    ULONGLONG   RejectedClient;
+
+    /**
+     * @brief   Number of transactions rejected with E_OUTOFMEMORY because the server limit was
+     *          reached.
+     */
+
+    ULONGLONG   RejectedServer;
+};
+
+/**
+ * @class   DaDeviceItemMemoryStatistics
+ *
+ * @brief   The memory used by the items of the server.
+ */
+
+class DaDeviceItemMemoryStatistics
+{
+    // Attributes
+public:
+    /**
+     * @brief   Number of existing items.
+     */
+
+    DWORD       Items;
+
+    /**
+     * @brief   Size of an item object in bytes.
+     */
+
+    DWORD       ItemSize;
+
+    /**
+     * @brief   Bytes reserved for the item IDs and access paths.
+     */
+
+    ULONGLONG   StringBytes;
+
+    /**
+     * @brief   Bytes used by the EU informations.
+     */
+
+    ULONGLONG   EUInfoBytes;
+
+    /**
+     * @brief   Bytes used by the values, qualities and timestamps.
+     */
+
+    ULONGLONG   ValueBytes;
+
+    /**
+     * @brief   Average number of bytes per item.
+     */
+
+    DWORD       BytesPerItem;
+};
+
 /**
  * @}
  */
@@ -680,6 +967,36 @@ HRESULT AddItem(LPWSTR itemId, DaAccessRights accessRights, LPVARIANT initValue,
 
 HRESULT AddAnalogItem(LPWSTR itemId, DaAccessRights accessRights, LPVARIANT initValue, double minValue, double maxValue, void** deviceItemHandle = nullptr);
 
+/**
+ * @fn  HRESULT AddItems(int count, DaItemDefinition* items, void** deviceItemHandles, HRESULT* errors);
+ *
+ * @brief   This function is called by the customization plugin and adds several items to the
+ *          generic server cache. Same as calling
+ *          <see cref="AddItem" text="AddItem" />
+ *          for each item but much faster for a large number of items, e.g. if the whole
+ *          address space is defined in
+ *          <see cref="OnCreateServerItems" text="OnCreateServerItems" />.
+ *          
+ *          The items are sorted by item ID and added to the cache and the browse hierarchy
+ *          all at once. Clients see either none or all of the added items.
+ *
+ * @param           count               Number of items.
+ * @param [in]      items               Array [count] with the definitions of the items. The
+ *                                      InitValue of each item is cleared.
+ * @param [out]     deviceItemHandles   If non\-null, array [count] which returns the created
+ *                                      device items; null for items which are not added.
+ * @param [out]     errors              Array [count] with the result of each item:
+ *                                      E_INVALIDARG if the item ID is invalid, already exists or
+ *                                      occurs more than once in items (only the first one is added).
+ *
+ * @return  A HRESULT code with the result of the operation.
+ *          
+ *           Returns S_OK if all items were successfully added to the cache; S_FALSE if
+ *           errors contains one or more errors.
+ */
+
+HRESULT AddItems(int count, DaItemDefinition* items, void** deviceItemHandles, HRESULT* errors);
+
 /**
  * @brief    This function is called by the customization plugin and removes an item from the
  *             generic server cache. If
@@ -751,11 +1068,67 @@ HRESULT AddProperty(int propertyId, LPWSTR description, LPVARIANT valueType);
  *
  * @return  A HRESULT code with the result of the operation.
  *          
- *           Returns S_OK if the value was successfully written into the cache.
+ *           Returns S_OK if the value was successfully written into the cache;
+ *           OPC_E_INVALIDHANDLE if the handle is null or OPC_E_BADTYPE if the value doesn't
+ *           match the canonical data type. SetItemValues() returns the same codes per item.
  */
 
 HRESULT SetItemValue(void* deviceItemHandle, LPVARIANT newValue, short quality, FILETIME timestamp);
 
+/**
+ * @fn  HRESULT SetItemValues(int count, void** deviceItemHandles, LPVARIANT newValues, short* qualities, FILETIME* timestamps, HRESULT* errors);
+ *
+ * @brief   Generic server callback method.
+ *          
+ *            Write the values of several items into the cache. Same as calling
+ *            <see cref="SetItemValue@void*@LPVARIANT@short@FILETIME" text="SetItemValue" />()
+ *            for each item but with less overhead per item.
+ *
+ * @param           count               Number of items.
+ * @param [in]      deviceItemHandles   Array [count] of Device Items as defined in the AddItem
+ *                                      method call.
+ * @param [in]      newValues           Array [count] of new item values. The values must match the
+ *                                      canonical data type of the items. An element with VT_NULL
+ *                                      changes only the quality and timestamp of the item.
+ * @param [in]      qualities           Array [count] of new qualities.
+ * @param [in]      timestamps          Array [count] of new timestamps. null uses the current time
+ *                                      for all items.
+ * @param [out]     errors              Array [count] with the result of each item; the same codes
+ *                                      as returned by SetItemValue().
+ *
+ * @return  A HRESULT code with the result of the operation.
+ *          
+ *           Returns S_OK if all values were successfully written into the cache; S_FALSE if
+ *           errors contains one or more errors.
+ */
+
+HRESULT SetItemValues(int count, void** deviceItemHandles, LPVARIANT newValues, short* qualities, FILETIME* timestamps, HRESULT* errors);
+
+/**
+ * @fn  HRESULT SetItemQualities(int count, void** deviceItemHandles, short* qualities, FILETIME* timestamps, HRESULT* errors);
+ *
+ * @brief   Generic server callback method.
+ *          
+ *            Changes only the quality and timestamp of several items and let the item values
+ *            unchanged, e.g. if a device is no longer reachable.
+ *
+ * @param           count               Number of items.
+ * @param [in]      deviceItemHandles   Array [count] of Device Items as defined in the AddItem
+ *                                      method call.
+ * @param [in]      qualities           Array [count] of new qualities.
+ * @param [in]      timestamps          Array [count] of new timestamps. null uses the current time
+ *                                      for all items.
+ * @param [out]     errors              Array [count] with the result of each item:
+ *                                      OPC_E_INVALIDHANDLE if the handle is null.
+ *
+ * @return  A HRESULT code with the result of the operation.
+ *          
+ *           Returns S_OK if all qualities were successfully written into the cache; S_FALSE if
+ *           errors contains one or more errors.
+ */
+
+HRESULT SetItemQualities(int count, void** deviceItemHandles, short* qualities, FILETIME* timestamps, HRESULT* errors);
+
 /**
  * @fn  void SetServerState(ServerState serverState);
  *
@@ -836,6 +1209,168 @@ void GetGroupState(void * groupHandle, DaGroupState * groupState);
 
 void GetItemStates(void * groupHandle, int * numDaItemStates, DaItemState* * daItemStates);
 
+/**
+ * @fn  void GetGroupUpdateTiming(void * groupHandle, DWORD * effectiveUpdateRate, DWORD * updateLag);
+ *
+ * @brief   Gets the update rate of the specified group as currently used by the server.
+ *          
+ *          The effective update rate is greater than the revised update rate of the group if
+ *          the update rates are stretched because the server is overloaded (see
+ *          GetUpdateCycleStatistics).
+ *
+ * @param [in]      groupHandle             Handle of the group as returned by GetGroups.
+ * @param [out]     effectiveUpdateRate     The effective update rate in ms.
+ * @param [out]     updateLag               How far the last update of the group was behind
+ *                                          schedule in ms.
+ */
+
+void GetGroupUpdateTiming(void * groupHandle, DWORD * effectiveUpdateRate, DWORD * updateLag);
+
+/**
+ * @fn  void GetUpdateCycleStatistics(DaUpdateCycleStatistics * statistics);
+ *
+ * @brief   Gets the cost and the overload state of the update cycle of the server.
+ *
+ * @param [out]     statistics  The statistics of the update cycle.
+ */
+
+void GetUpdateCycleStatistics(DaUpdateCycleStatistics * statistics);
+
+/**
+ * @fn  void GetItemSubscriberCount(void * deviceItemHandle, int * numSubscribers, int * numActiveSubscribers);
+ *
+ * @brief   Gets the number of client items (in all groups of all clients) which reference the
+ *          specified item.
+ *
+ * @param [in]      deviceItemHandle        Handle of the item as returned by AddItem.
+ * @param [out]     numSubscribers          Number of client items referencing the item.
+ * @param [out]     numActiveSubscribers    Number of these client items which are active.
+ */
+
+void GetItemSubscriberCount(void * deviceItemHandle, int * numSubscribers, int * numActiveSubscribers);
+
+/**
+ * @fn  void SetCallbackQueueLimit(DWORD callbackQueueLimit);
+ *
+ * @brief   Sets the maximum number of item values queued for delivery to a client.
+ *          
+ *          The OnDataChange callbacks are queued per client; a newer value of a queued item
+ *          replaces the older one. If the limit is reached further values are dropped and
+ *          sent with a later update. Applies to the connected and to new clients. The default
+ *          is 100000.
+ *
+ * @param   callbackQueueLimit  The maximum number of queued item values per client.
+ */
+
+void SetCallbackQueueLimit(DWORD callbackQueueLimit);
+
+/**
+ * @fn  DWORD GetCallbackQueueLimit();
+ *
+ * @brief   Gets the maximum number of item values queued for delivery to a client.
+ *
+ * @return  The maximum number of queued item values per client.
+ */
+
+DWORD GetCallbackQueueLimit();
+
+/**
+ * @fn  void GetCallbackQueueStatistics(void * clientHandle, DaCallbackQueueStatistics * statistics);
+
+/**
+ * @fn  void SetDeviceReadCoalescingWindow(DWORD coalescingWindow);
+ *
+ * @brief   Sets the time a device read for a client request waits for other requests whose
+ *          items are read with the same OnRefreshItems call.
+ *          
+ *          The window is a Sleep() on the thread of the client request which opens the read,
+ *          so each read from the device of a client is delayed by the window. Use it only if
+ *          a device access costs more than the delay. The default is 0; then only requests
+ *          for items which are already being read are merged.
+ *
+ * @param   coalescingWindow    The time in ms, at most 1000.
+ */
+
+void SetDeviceReadCoalescingWindow(DWORD coalescingWindow);
+
+/**
+ * @fn  DWORD GetDeviceReadCoalescingWindow();
+ *
+ * @brief   Gets the coalescing window of the device reads for client requests.
+ *
+ * @return  The coalescing window in ms.
+ */
+
+DWORD GetDeviceReadCoalescingWindow();
+
+/**
+ * @fn  void GetDeviceReadStatistics(DaDeviceReadStatistics * statistics);
+
+/**
+ * @fn  void SetAsyncTransactionLimits(DWORD clientLimit, DWORD serverLimit);
+ *
+ * @brief   Sets the maximum number of outstanding asynchronous transactions (read, write,
+ *          refresh).
+ *          
+ *          A request of a client which has reached its limit is rejected with
+ *          CONNECT_E_ADVISELIMIT; a request which exceeds the limit of all clients is rejected
+ *          with E_OUTOFMEMORY. Applies to new requests of all clients.
+ *
+ * @param   clientLimit     The maximum per client; 0 if unlimited. The default is 1000.
+ * @param   serverLimit     The maximum of all clients; 0 if unlimited. The default is 10000.
+ */
+
+void SetAsyncTransactionLimits(DWORD clientLimit, DWORD serverLimit);
+
+/**
+ * @fn  void GetAsyncAdmissionStatistics(DaAsyncAdmissionStatistics * statistics);
+ *
+ * @brief   Gets the limits, the outstanding and queued transactions and the rejection counters
+ *          of the asynchronous transactions.
+ *
+ * @param [out]     statistics      The limits and counters.
+ */
+
+void GetAsyncAdmissionStatistics(DaAsyncAdmissionStatistics * statistics);
+
+/**
+ * @fn  DWORD GetClientAsyncTransactions(void * clientHandle);
+
+/**
+ * @fn  void GetDeviceItemMemoryStatistics(DaDeviceItemMemoryStatistics * statistics);
+ *
+ * @brief   Gets the memory used by the items, including the average number of bytes per item.
+ *          The values after OnCreateServerItems are also written to the log file.
+ *
+ * @param [out]     statistics      The memory statistics.
+ */
+
+void GetDeviceItemMemoryStatistics(DaDeviceItemMemoryStatistics * statistics);
+ *
+ * @brief   Gets the number of outstanding asynchronous transactions of a client.
+ *
+ * @param [in]      clientHandle    Handle of the client as returned by GetClients.
+ *
+ * @return  The number of outstanding transactions.
+ */
+
+DWORD GetClientAsyncTransactions(void * clientHandle);
+ *
+ * @brief   Gets the counters of the device reads for client requests.
+ *
+ * @param [out]     statistics      The counters of the device reads.
+ */
+
+void GetDeviceReadStatistics(DaDeviceReadStatistics * statistics);
+ *
+ * @brief   Gets the counters of the callback queue of a client.
+ *
+ * @param [in]      clientHandle    Handle of the client as returned by GetClients.
+ * @param [out]     statistics      The counters of the queue.
+ */
+
+void GetCallbackQueueStatistics(void * clientHandle, DaCallbackQueueStatistics * statistics);
+
 /**
  * @fn  void FireShutdownRequest(LPCWSTR reason);
  *
@@ -0,0 +1,873 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the Server Address Space: DaBranch and DaLeaf of the
+// ClassicServer or of the Customization server, depending on the
+// directory of DaAddressSpace.h, with the map of the Item IDs which the
+// servers use to find a Device Item (DaServer::AddDeviceItem() and
+// DaServer::FindDeviceItem()).
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the latency of adding an item and of
+// finding an item is measured while the address space grows from 1'000
+// to 1'000'000 items; adding with and without the map of the Item IDs,
+// finding with the map and with a search of the whole address space
+// (DaBranch::FindDeviceItem()), as the servers did before. Then the
+// memory and the browse latency of the address space are compared with
+// the reference implementation (DaAddressSpaceReference.cpp), which
+// stored the names in each branch and leaf. The startup benchmark
+// compares adding items one by one with DaServer::AddDeviceItems().
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include "DaDeviceItem.h"
+#include "DaAddressSpace.h"
+#include "DaAddressSpaceReference.h"
+#include <cstddef>
+
+template <class F>
+static double NsPerCall( F Call )
+{
+   DWORD    dwCalls = 0;
+   double   dStart = NowSeconds(), dSeconds;
+   do {
+      Call();
+      dwCalls++;
+   } while ((dSeconds = NowSeconds() - dStart) < 0.2);
+   return dSeconds * 1e9 / dwCalls;
+}
+
+
+//=========================================================================
+// Heap memory: operator new and delete count the bytes requested and
+// the blocks which are not yet freed.
+//=========================================================================
+static std::atomic<long long> gllHeapBytes( 0 );
+static std::atomic<long long> gllHeapBlocks( 0 );
+
+               // Prefix of each block with the requested size. It is as
+               // large as max_align_t, so the block keeps the alignment.
+               // operator delete finds it by the address, the compiler
+               // would take the pointer arithmetic for an access in
+               // front of the deleted object.
+union HeapHeader {
+   size_t            cb;
+   std::max_align_t  Align;
+};
+
+void* operator new( size_t cb )
+{
+   char* p = (char*)malloc( sizeof (HeapHeader) + cb );
+   if (p == NULL) throw std::bad_alloc();
+   ((HeapHeader*)p)->cb = cb;
+   gllHeapBytes += cb;
+   gllHeapBlocks++;
+   return p + sizeof (HeapHeader);
+}
+
+void operator delete( void* pv ) noexcept
+{
+   if (pv) {
+      HeapHeader* p = (HeapHeader*)((uintptr_t)pv - sizeof (HeapHeader));
+      gllHeapBytes -= p->cb;
+      gllHeapBlocks--;
+      free( p );
+   }
+}
+
+void* operator new[]( size_t cb )                  { return operator new( cb ); }
+void  operator delete[]( void* pv ) noexcept       { operator delete( pv ); }
+void  operator delete( void* pv, size_t ) noexcept { operator delete( pv ); }
+void  operator delete[]( void* pv, size_t ) noexcept { operator delete( pv ); }
+
+
+//=========================================================================
+// Address space with the map of the Item IDs, as kept by DaServer
+//=========================================================================
+typedef CAtlMap<LPCWSTR,DaDeviceItem*,LPCWSTRRefElementTraits<LPCWSTR>> ItemIDMap;
+
+   // There is only one root per process (DaBranch::CreateAsRoot())
+static DaBranch gRoot;
+static DaBranchReference gRefRoot;
+
+struct AddressSpace {
+   std::vector<DaDeviceItem*> Items;            // DaServer::m_arServerItems
+   ItemIDMap                  mapItemIDs;       // DaServer::m_mapItemIDs
+
+   ~AddressSpace() { RemoveAll(); }
+
+   // Same steps as DaServer::AddDeviceItem(). Without the map only the
+   // address space checks that the name is unique, as before.
+   HRESULT AddDeviceItem( DaDeviceItem* pDItem, BOOL fMap = TRUE )
+   {
+      LPWSTR   pwszItemID;
+      HRESULT  hres;
+
+      Items.push_back( pDItem );
+      hres = pDItem->get_ItemIDPtr( &pwszItemID );
+      if (SUCCEEDED( hres ) && fMap) {
+         DaDeviceItem* pExisting;
+         if (mapItemIDs.Lookup( pwszItemID, pExisting )) {
+            hres = E_INVALIDARG;
+         }
+      }
+      if (SUCCEEDED( hres )) {
+         hres = gRoot.AddDeviceItem( pwszItemID, pDItem );
+         if (SUCCEEDED( hres ) && fMap) {
+            mapItemIDs.SetAt( pwszItemID, pDItem );
+         }
+      }
+      if (FAILED( hres )) {
+         Items.pop_back();
+      }
+      return hres;
+   }
+
+   // Same steps as DaServer::AddDeviceItems(): sorted by Item ID unless
+   // already sorted, the duplicates and existing Item IDs are rejected
+   // while the others are entered in the map, then one call of
+   // DaBranch::AddDeviceItems(). Items which are not added are deleted.
+   HRESULT AddDeviceItems( DWORD dwCount, DaDeviceItem** ppDItems, HRESULT* pErrors )
+   {
+      std::vector<std::pair<LPCWSTR,DWORD>> Entries;
+      std::vector<LPCWSTR>                  ItemIDs;
+      std::vector<DaDeviceItem*>            AddItems;
+      std::vector<DWORD>                    AddIndex;
+      BOOL                                  fSorted = TRUE;
+      HRESULT                               hres = S_OK;
+
+      for (DWORD i = 0; i < dwCount; i++) {
+         LPWSTR pwszItemID;
+         pErrors[i] = ppDItems[i]->get_ItemIDPtr( &pwszItemID );
+         if (SUCCEEDED( pErrors[i] )) {
+            if (fSorted && !Entries.empty()) {
+               fSorted = (wcscmp( Entries.back().first, pwszItemID ) < 0);
+            }
+            Entries.push_back( std::make_pair( (LPCWSTR)pwszItemID, i ) );
+         }
+      }
+      if (!fSorted) {
+         std::sort( Entries.begin(), Entries.end(),
+                    []( const std::pair<LPCWSTR,DWORD>& e1, const std::pair<LPCWSTR,DWORD>& e2 ) {
+                       int iCmp = wcscmp( e1.first, e2.first );
+                       return (iCmp == 0) ? (e1.second < e2.second) : (iCmp < 0);
+                    } );
+      }
+      for (size_t e = 0; e < Entries.size(); e++) {
+         DaDeviceItem* pExisting;
+         if ((e > 0 && wcscmp( Entries[e].first, Entries[e - 1].first ) == 0) ||
+             mapItemIDs.Lookup( Entries[e].first, pExisting )) {
+            pErrors[ Entries[e].second ] = E_INVALIDARG;
+         }
+         else {
+            mapItemIDs.SetAt( Entries[e].first, ppDItems[ Entries[e].second ] );
+            ItemIDs.push_back( Entries[e].first );
+            AddItems.push_back( ppDItems[ Entries[e].second ] );
+            AddIndex.push_back( Entries[e].second );
+         }
+      }
+
+      std::vector<HRESULT> AddErrors( AddItems.size() + 1 );
+      gRoot.AddDeviceItems( (DWORD)AddItems.size(), ItemIDs.data(), AddItems.data(), AddErrors.data() );
+      for (size_t a = 0; a < AddItems.size(); a++) {
+         if (SUCCEEDED( AddErrors[a] )) {
+            Items.push_back( AddItems[a] );
+         }
+         else {
+            mapItemIDs.RemoveKey( ItemIDs[a] );
+         }
+         pErrors[ AddIndex[a] ] = AddErrors[a];
+      }
+
+      for (DWORD i = 0; i < dwCount; i++) {
+         if (FAILED( pErrors[i] )) {
+            delete ppDItems[i];
+            ppDItems[i] = NULL;
+            hres = S_FALSE;
+         }
+      }
+      return hres;
+   }
+
+   // Same as DaServer::FindDeviceItem()
+   DaDeviceItem* FindDeviceItem( LPCWSTR szItemID )
+   {
+      DaDeviceItem* pDItem;
+      return mapItemIDs.Lookup( szItemID, pDItem ) ? pDItem : NULL;
+   }
+
+   HRESULT RemoveDeviceItem( DaDeviceItem* pDItem )
+   {
+      LPWSTR pwszItemID;
+      pDItem->get_ItemIDPtr( &pwszItemID );
+      HRESULT hres = gRoot.RemoveDeviceItemAssociatedLeaf( pwszItemID );
+      if (SUCCEEDED( hres )) {
+         mapItemIDs.RemoveKey( pwszItemID );
+         Items.erase( std::find( Items.begin(), Items.end(), pDItem ) );
+         delete pDItem;
+      }
+      return hres;
+   }
+
+   void RemoveAll( void )
+   {
+      gRoot.RemoveAll();
+      mapItemIDs.RemoveAll();
+      for (size_t i = 0; i < Items.size(); i++) {
+         delete Items[i];
+      }
+      Items.clear();
+   }
+};
+
+   // Item ID of item i, 100 items per unit and 100 units per plant. The
+   // leaf names are repeated in each unit or unique, numbered from
+   // dwFirstTag.
+static void ItemID( DWORD i, WCHAR* szItemID, BOOL fUniqueLeafs = FALSE, DWORD dwFirstTag = 0 )
+{
+   if (fUniqueLeafs) {
+      swprintf( szItemID, 64, L"Plant%u.Unit%02u.Tag%07u", i / 10000, (i / 100) % 100, dwFirstTag + i );
+   }
+   else {
+      swprintf( szItemID, 64, L"Plant%u.Unit%02u.Item%02u", i / 10000, (i / 100) % 100, i % 100 );
+   }
+}
+
+static DaDeviceItem* NewItem( DWORD i, BOOL fUniqueLeafs = FALSE, DWORD dwFirstTag = 0 )
+{
+   WCHAR szItemID[64];
+   ItemID( i, szItemID, fUniqueLeafs, dwFirstTag );
+   return new DaDeviceItem( szItemID, (i & 1) ? VT_R8 : VT_I4, (i % 3) ? OPC_READABLE : OPC_READABLE | OPC_WRITEABLE );
+}
+
+static LPCWSTR ItemIDPtr( DaDeviceItem* pDItem )
+{
+   LPWSTR szItemID;
+   pDItem->get_ItemIDPtr( &szItemID );
+   return szItemID;
+}
+
+static void FreeNames( DWORD dwCount, BSTR* pszNames )
+{
+   for (DWORD i = 0; i < dwCount; i++) {
+      SysFreeString( pszNames[i] );
+   }
+   delete [] pszNames;
+}
+
+
+//=========================================================================
+// Adding, finding and removing items
+//=========================================================================
+static void TestAddAndFind()
+{
+   const DWORD    dwItems = 2 * 10000 + 3 * 100;
+   AddressSpace   Space;
+   DaDeviceItem*  pDItem;
+   WCHAR          szItemID[64];
+   DWORD          i;
+   BOOL           fOk;
+
+   for (fOk = TRUE, i = 0; i < dwItems; i++) {
+      fOk &= (Space.AddDeviceItem( NewItem( i ) ) == S_OK);
+   }
+   Check( fOk, "AddDeviceItem() of new items" );
+   Check( Space.mapItemIDs.GetCount() == dwItems, "all Item IDs in the map" );
+
+   pDItem = NewItem( 10005 );
+   Check( Space.AddDeviceItem( pDItem ) == E_INVALIDARG, "AddDeviceItem() of an existing Item ID" );
+   Check( gRoot.AddDeviceItem( L"Plant1.Unit00.Item05", pDItem ) == E_INVALIDARG,
+          "address space rejects an existing name" );
+   Check( Space.AddDeviceItem( pDItem, FALSE ) == E_INVALIDARG, "existing name without the map" );
+   delete pDItem;
+   Check( Space.Items.size() == dwItems, "failed adds are not kept" );
+
+   for (fOk = TRUE, i = 0; i < dwItems; i += 97) {
+      ItemID( i, szItemID );
+      DaDeviceItem* pFound = Space.FindDeviceItem( szItemID );
+      fOk &= (pFound == Space.Items[i]);
+      fOk &= SUCCEEDED( gRoot.FindDeviceItem( szItemID, &pDItem ) ) && (pDItem == pFound);
+   }
+   Check( fOk, "map and address space find the same items" );
+
+   Check( Space.FindDeviceItem( L"Plant1.Unit00" ) == NULL, "branch is not an item" );
+   Check( Space.FindDeviceItem( L"Plant1.Unit00.Item100" ) == NULL, "unknown item" );
+   Check( Space.FindDeviceItem( L"plant1.Unit00.Item05" ) == NULL, "Item IDs are case sensitive" );
+   Check( FAILED( gRoot.FindDeviceItem( L"Plant1.Unit00.Item100", &pDItem ) ) && pDItem == NULL,
+          "unknown item in the address space" );
+
+   pDItem = Space.Items[10005];
+   Check( Space.RemoveDeviceItem( pDItem ) == S_OK, "RemoveDeviceItemAssociatedLeaf()" );
+   Check( Space.FindDeviceItem( L"Plant1.Unit00.Item05" ) == NULL, "removed item is not in the map" );
+   Check( FAILED( gRoot.FindDeviceItem( L"Plant1.Unit00.Item05", &pDItem ) ), "removed item is not found" );
+   Check( Space.AddDeviceItem( NewItem( 10005 ) ) == S_OK, "removed Item ID can be added again" );
+   Check( Space.FindDeviceItem( L"Plant1.Unit00.Item05" ) == Space.Items.back(), "added again" );
+
+   pDItem = new DaDeviceItem( L"Plant1.", VT_I4, OPC_READABLE );
+   Check( Space.AddDeviceItem( pDItem ) == E_INVALIDARG, "empty leaf name" );
+   delete pDItem;
+   Check( Space.mapItemIDs.GetCount() == dwItems, "invalid names are not in the map" );
+}
+
+
+//=========================================================================
+// Browse positions and fully qualified names
+//=========================================================================
+static void TestBrowsePosition()
+{
+   AddressSpace   Space;
+   DaBranch*      pPos;
+   DaBranch*      pUp;
+   BSTR           szName;
+   DWORD          i;
+
+   for (i = 0; i < 2 * 10000; i += 50) {
+      Space.AddDeviceItem( NewItem( i ) );
+   }
+
+   Check( gRoot.ChangeBrowsePosition( OPC_BROWSE_DOWN, L"Plant1", &pPos ) == S_OK && pPos != NULL,
+          "browse down" );
+   Check( pPos->ChangeBrowsePosition( OPC_BROWSE_UP, NULL, &pUp ) == S_OK && pUp == &gRoot, "browse up" );
+   Check( FAILED( gRoot.ChangeBrowsePosition( OPC_BROWSE_UP, NULL, &pUp ) ), "browse up from the root" );
+   Check( FAILED( gRoot.ChangeBrowsePosition( OPC_BROWSE_DOWN, L"Plant2", &pUp ) ), "browse down to unknown" );
+   Check( FAILED( gRoot.ChangeBrowsePosition( OPC_BROWSE_DOWN, L"Plant", &pUp ) ), "browse down to a prefix" );
+
+   Check( pPos->ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant0.Unit03", &pPos ) == S_OK, "browse to" );
+   Check( pPos->GetFullyQualifiedName( L"Item50", &szName ) == S_OK &&
+          wcscmp( szName, L"Plant0.Unit03.Item50" ) == 0, "fully qualified name of a leaf" );
+   SysFreeString( szName );
+   Check( FAILED( pPos->ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant0.Unit03.Item50", &pUp ) ),
+          "browse to a leaf" );
+   Check( gRoot.GetFullyQualifiedName( L"Plant1.Unit99", &szName ) == S_OK &&
+          wcscmp( szName, L"Plant1.Unit99" ) == 0, "fully qualified name of a branch" );
+   Check( SysStringLen( szName ) == wcslen( L"Plant1.Unit99" ), "length of the fully qualified name" );
+   SysFreeString( szName );
+   Check( gRoot.GetFullyQualifiedName( L"Plant0.Unit03.Item50", &szName ) == S_OK &&
+          wcscmp( szName, L"Plant0.Unit03.Item50" ) == 0, "fully qualified name of a leaf with branches" );
+   SysFreeString( szName );
+   Check( FAILED( gRoot.GetFullyQualifiedName( L"Plant0.Unit03.Item51", &szName ) ) && szName == NULL,
+          "fully qualified name of an unknown leaf" );
+}
+
+
+//=========================================================================
+// Browse results
+// --------------
+//    The members are returned in name order, independent of the order
+//    in which the items are added. The reference implementation returns
+//    the same names in the order of its hash maps. It needs an access
+//    rights filter, which DaServer always sets, to return the leafs.
+//=========================================================================
+static BOOL IsSorted( DWORD dwCount, BSTR* pszNames )
+{
+   for (DWORD i = 1; i < dwCount; i++) {
+      if (wcscmp( pszNames[i - 1], pszNames[i] ) >= 0) return FALSE;
+   }
+   return TRUE;
+}
+
+static void TestBrowseOrder()
+{
+   AddressSpace         Space;
+   std::vector<DWORD>   Order;
+   DaBranch*            pPos;
+   DaBranchReference*   pRefPos;
+   DWORD                dwCount, dwRefCount, dwExpected, i;
+   BSTR*                pszNames;
+   BSTR*                pszRefNames;
+   BOOL                 fOk;
+
+   for (i = 0; i < 3 * 10000; i += 7) {
+      Order.push_back( i );
+   }
+   std::shuffle( Order.begin(), Order.end(), std::mt19937( 1 ) );
+   for (i = 0; i < Order.size(); i++) {
+      Space.AddDeviceItem( NewItem( Order[i] ) );
+      gRefRoot.AddDeviceItem( ItemIDPtr( Space.Items.back() ), Space.Items.back() );
+   }
+
+   Check( gRoot.BrowseBranches( L"", &dwCount, &pszNames ) == S_OK && dwCount == 3 &&
+          IsSorted( dwCount, pszNames ) && wcscmp( pszNames[0], L"Plant0" ) == 0, "branches in name order" );
+   FreeNames( dwCount, pszNames );
+
+   gRoot.ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant1", &pPos );
+   Check( pPos->BrowseBranches( L"", &dwCount, &pszNames ) == S_OK && dwCount == 100 &&
+          IsSorted( dwCount, pszNames ), "100 branches in name order" );
+   FreeNames( dwCount, pszNames );
+   Check( pPos->BrowseBranches( L"Unit9?", &dwCount, &pszNames ) == S_OK && dwCount == 10 &&
+          IsSorted( dwCount, pszNames ) && wcscmp( pszNames[9], L"Unit99" ) == 0, "filtered branches" );
+   FreeNames( dwCount, pszNames );
+   Check( pPos->BrowseBranches( L"Item*", &dwCount, &pszNames ) == S_FALSE && dwCount == 0 && pszNames == NULL,
+          "no branch matches the filter" );
+
+   gRoot.ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant1.Unit07", &pPos );
+   for (dwExpected = 0, i = 10700; i < 10800; i++) {
+      dwExpected += (i % 7 == 0);
+   }
+   Check( pPos->BrowseLeafs( L"", VT_EMPTY, 0, &dwCount, &pszNames ) == S_OK && dwCount == dwExpected &&
+          IsSorted( dwCount, pszNames ), "leafs in name order" );
+   FreeNames( dwCount, pszNames );
+
+   for (dwExpected = 0, i = 10700; i < 10800; i++) {
+      dwExpected += (i % 7 == 0 && (i & 1));
+   }
+   Check( pPos->BrowseLeafs( L"", VT_R8, 0, &dwCount, &pszNames ) == S_OK && dwCount == dwExpected &&
+          IsSorted( dwCount, pszNames ), "leafs filtered by data type" );
+   FreeNames( dwCount, pszNames );
+
+   for (dwExpected = 0, i = 10700; i < 10800; i++) {
+      dwExpected += (i % 7 == 0 && i % 3 == 0);
+   }
+   Check( pPos->BrowseLeafs( L"", VT_EMPTY, OPC_WRITEABLE, &dwCount, &pszNames ) == S_OK &&
+          dwCount == dwExpected && IsSorted( dwCount, pszNames ), "leafs filtered by access rights" );
+   FreeNames( dwCount, pszNames );
+
+   for (dwExpected = 0, i = 10740; i < 10750; i++) {
+      dwExpected += (i % 7 == 0);
+   }
+   Check( pPos->BrowseLeafs( L"Item4*", VT_EMPTY, 0, &dwCount, &pszNames ) == S_OK && dwCount == dwExpected &&
+          IsSorted( dwCount, pszNames ), "leafs filtered by name" );
+   FreeNames( dwCount, pszNames );
+
+   // The same fully qualified names as the reference, in name order
+   Check( gRoot.BrowseFlat( L"", VT_EMPTY, 0, &dwCount, &pszNames ) == S_OK && dwCount == Order.size() &&
+          IsSorted( dwCount, pszNames ), "flat browse in name order" );
+   Check( gRefRoot.BrowseFlat( L"", VT_EMPTY, OPC_READABLE | OPC_WRITEABLE, &dwRefCount, &pszRefNames ) == S_OK &&
+          dwRefCount == dwCount,
+          "flat browse of the reference" );
+   std::sort( pszRefNames, pszRefNames + dwRefCount,
+              []( BSTR sz1, BSTR sz2 ) { return wcscmp( sz1, sz2 ) < 0; } );
+   for (fOk = (dwRefCount == dwCount), i = 0; fOk && i < dwCount; i++) {
+      fOk = (wcscmp( pszNames[i], pszRefNames[i] ) == 0);
+   }
+   Check( fOk, "flat browse returns the names of the reference" );
+   FreeNames( dwCount, pszNames );
+   FreeNames( dwRefCount, pszRefNames );
+
+   gRefRoot.ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant2.Unit99", &pRefPos );
+   gRoot.ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant2.Unit99", &pPos );
+   pRefPos->BrowseLeafs( L"*1", VT_EMPTY, OPC_READABLE | OPC_WRITEABLE, &dwRefCount, &pszRefNames );
+   Check( pPos->BrowseLeafs( L"*1", VT_EMPTY, 0, &dwCount, &pszNames ) == S_OK && dwCount == dwRefCount,
+          "filtered leafs of the reference" );
+   FreeNames( dwCount, pszNames );
+   FreeNames( dwRefCount, pszRefNames );
+
+   gRefRoot.RemoveAll();
+}
+
+
+//=========================================================================
+// Adding several items with one call
+//=========================================================================
+static void TestAddItems()
+{
+   const DWORD                dwItems = 3 * 10000 + 50 * 100;
+   AddressSpace               Space;
+   std::vector<DaDeviceItem*> NewItems;
+   std::vector<HRESULT>       Errors;
+   DaDeviceItem*              pDItem;
+   WCHAR                      szItemID[64];
+   DWORD                      i;
+   DWORD                      dwRejected;
+   BOOL                       fOk;
+
+   Check( Space.AddDeviceItem( NewItem( 20007 ) ) == S_OK, "AddDeviceItem() before AddDeviceItems()" );
+
+   for (i = 0; i < dwItems; i++) {
+      NewItems.push_back( NewItem( i ) );
+   }
+   std::shuffle( NewItems.begin(), NewItems.end(), std::mt19937( 11 ) );
+   NewItems.push_back( NewItem( 10005 ) );               // duplicate in the array
+   NewItems.push_back( new DaDeviceItem( L"Plant1.", VT_I4, OPC_READABLE ) );
+   const DWORD dwCount = (DWORD)NewItems.size();
+   std::vector<DaDeviceItem*> Passed( NewItems );
+
+   Errors.resize( dwCount );
+   Check( Space.AddDeviceItems( dwCount, NewItems.data(), Errors.data() ) == S_FALSE,
+          "AddDeviceItems() returns S_FALSE if an item failed" );
+   for (fOk = TRUE, dwRejected = 0, i = 0; i < dwCount; i++) {
+      if (i >= dwItems) {
+         fOk &= (Errors[i] == E_INVALIDARG) && (NewItems[i] == NULL);
+      }
+      else if (NewItems[i] == NULL) {
+         fOk &= (Errors[i] == E_INVALIDARG);
+         dwRejected++;                                    // the existing Plant2.Unit00.Item07
+      }
+      else {
+         fOk &= (Errors[i] == S_OK);
+      }
+   }
+   Check( fOk && dwRejected == 1, "errors of the duplicate, the existing and the invalid Item ID" );
+   Check( Space.mapItemIDs.GetCount() == dwItems, "all Item IDs in the map once" );
+   Check( Space.Items.size() == dwItems, "rejected items are not kept" );
+
+   for (fOk = TRUE, i = 0; i < dwItems; i += 89) {
+      ItemID( i, szItemID );
+      DaDeviceItem* pFound = Space.FindDeviceItem( szItemID );
+      fOk &= (pFound != NULL) && (wcscmp( ItemIDPtr( pFound ), szItemID ) == 0);
+      fOk &= SUCCEEDED( gRoot.FindDeviceItem( szItemID, &pDItem ) ) && (pDItem == pFound);
+   }
+   Check( fOk, "map and address space find the items added in bulk" );
+   pDItem = Space.FindDeviceItem( L"Plant1.Unit00.Item05" );
+   Check( pDItem != NULL && std::find( Passed.begin(), Passed.begin() + dwItems, pDItem ) != Passed.begin() + dwItems,
+          "the first of the duplicates is added" );
+
+   DaBranch* pUnit = NULL;
+   DWORD     dwCountLeafs = 0;
+   BSTR*     pszLeafs = NULL;
+   Check( SUCCEEDED( gRoot.ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant3.Unit49", &pUnit ) ) &&
+          pUnit->BrowseLeafs( L"", VT_EMPTY, 0, &dwCountLeafs, &pszLeafs ) == S_OK &&
+          dwCountLeafs == 100 && IsSorted( dwCountLeafs, pszLeafs ),
+          "leafs added in bulk are sorted" );
+   FreeNames( dwCountLeafs, pszLeafs );
+}
+
+
+//=========================================================================
+// Benchmark
+// ---------
+//    Latency of adding an item and of finding an item while the address
+//    space grows to 1'000'000 items with 100 items per branch:
+//       add                 : the steps of DaServer::AddDeviceItem()
+//       add without map     : the address space only, as before
+//       find                : DaServer::FindDeviceItem() with the map
+//       find without map    : DaBranch::FindDeviceItem(), as before
+//    The latencies are the average of the last 1'000 items added before
+//    the size is reached and of finds of random items of that size.
+//=========================================================================
+static void Benchmark()
+{
+   const DWORD                aSizes[] = { 1000, 10000, 100000, 1000000 };
+   const DWORD                dwSizes = sizeof aSizes / sizeof aSizes[0];
+   const DWORD                dwMax = aSizes[ dwSizes - 1 ];
+   const DWORD                dwLast = 1000;
+   double                     adAdd[2][ dwSizes ], adFind[2][ dwSizes ];
+   std::vector<WCHAR>         ItemIDs( dwMax * 64 );
+   std::mt19937               Random( 4711 );
+   DaDeviceItem*              pDItem;
+   DWORD                      i, s, dwFinds, dwFound;
+   double                     dStart;
+
+   for (i = 0; i < dwMax; i++) {
+      ItemID( i, &ItemIDs[ i * 64 ] );
+   }
+
+   for (int nMap = 1; nMap >= 0; nMap--) {
+      AddressSpace Space;
+      for (i = 0, s = 0; s < dwSizes; s++) {
+         // Creates the items outside of the measurement
+         std::vector<DaDeviceItem*> NewItems;
+         for (DWORD k = i; k < aSizes[s]; k++) {
+            NewItems.push_back( NewItem( k ) );
+         }
+         for (DWORD k = 0; i < aSizes[s] - dwLast; i++, k++) {
+            Space.AddDeviceItem( NewItems[k], nMap );
+         }
+         dStart = NowSeconds();
+         for (DWORD k = NewItems.size() - dwLast; i < aSizes[s]; i++, k++) {
+            Space.AddDeviceItem( NewItems[k], nMap );
+         }
+         adAdd[nMap][s] = (NowSeconds() - dStart) * 1e9 / dwLast;
+         if (Space.Items.size() != aSizes[s]) {
+            printf( "FAILED: not all items added\n" );
+         }
+
+         // Each search of the address space visits half of the items
+         dwFinds = nMap ? 100000 : max( 10u, 20000000u / aSizes[s] );
+         dwFound = 0;
+         dStart = NowSeconds();
+         for (DWORD k = 0; k < dwFinds; k++) {
+            LPCWSTR szItemID = &ItemIDs[ Random() % aSizes[s] * 64 ];
+            if (nMap) {
+               pDItem = Space.FindDeviceItem( szItemID );
+            }
+            else {
+               gRoot.FindDeviceItem( szItemID, &pDItem );
+            }
+            dwFound += (pDItem != NULL);
+         }
+         adFind[nMap][s] = (NowSeconds() - dStart) * 1e9 / dwFinds;
+         if (dwFound != dwFinds) {
+            printf( "FAILED: not all items found\n" );
+         }
+      }
+   }
+
+   printf( "\nitems in the          ns per add            ns per find\n" );
+   printf( "address space   map   without map      map   without map\n" );
+   for (s = 0; s < dwSizes; s++) {
+      printf( "%13u   %7.0f   %11.0f   %6.0f   %11.0f\n", aSizes[s],
+              adAdd[1][s], adAdd[0][s], adFind[1][s], adFind[0][s] );
+   }
+}
+
+
+//=========================================================================
+// Benchmark of the startup
+// ------------------------
+//    Time to build an address space at startup, by one call of
+//    DaServer::AddDeviceItem() for each item or by one call of
+//    DaServer::AddDeviceItems() for all items, with the items in random
+//    order or sorted by Item ID. The names are interned before the
+//    measurement so that each run finds the same names in the arena.
+//=========================================================================
+static void BenchmarkStartup()
+{
+   const DWORD    aSizes[] = { 100000, 800000 };
+   const char*    aszOrder[] = { "random", "sorted" };
+   double         adNs[2][2];
+
+   printf( "\n               ns per item (AddItem)        ns per item (AddItems)\n" );
+   printf( "items     order       one call per item           one call            speedup\n" );
+   for (DWORD s = 0; s < sizeof aSizes / sizeof aSizes[0]; s++) {
+      const DWORD dwItems = aSizes[s];
+      {
+         AddressSpace Space;                       // interns the names
+         for (DWORD i = 0; i < dwItems; i++) {
+            Space.AddDeviceItem( NewItem( i ) );
+         }
+      }
+      for (int nOrder = 0; nOrder < 2; nOrder++) {
+         for (int nBulk = 0; nBulk < 2; nBulk++) {
+            AddressSpace               Space;
+            std::vector<DaDeviceItem*> NewItems;
+            std::vector<HRESULT>       Errors( dwItems );
+            DWORD                      dwAdded = 0;
+
+            for (DWORD i = 0; i < dwItems; i++) {
+               NewItems.push_back( NewItem( i ) );
+            }
+            if (nOrder == 0) {
+               std::shuffle( NewItems.begin(), NewItems.end(), std::mt19937( 4711 ) );
+            }
+            double dStart = NowSeconds();
+            if (nBulk) {
+               Space.AddDeviceItems( dwItems, NewItems.data(), Errors.data() );
+            }
+            else {
+               for (DWORD i = 0; i < dwItems; i++) {
+                  Errors[i] = Space.AddDeviceItem( NewItems[i] );
+               }
+            }
+            adNs[nOrder][nBulk] = (NowSeconds() - dStart) * 1e9 / dwItems;
+            for (DWORD i = 0; i < dwItems; i++) {
+               dwAdded += SUCCEEDED( Errors[i] );
+            }
+            if (dwAdded != dwItems) {
+               printf( "FAILED: not all items added\n" );
+            }
+         }
+         printf( "%7u   %-6s   %16.0f   %20.0f   %16.2f\n", dwItems, aszOrder[nOrder],
+                 adNs[nOrder][0], adNs[nOrder][1], adNs[nOrder][0] / adNs[nOrder][1] );
+      }
+   }
+}
+
+
+//=========================================================================
+// Benchmark of the memory
+// -----------------------
+//    Memory of the address space with 10'000 - 1'000'000 items and 100
+//    items per branch, without the Device Items:
+//       interned    : DaBranch, the names interned in the DaStringArena
+//                     and the members in sorted arrays
+//       reference   : DaBranchReference, a copy of the name in each
+//                     branch and leaf and hash maps of the members
+//    The leaf names are repeated in each branch (Item00 - Item99) or
+//    unique (TagNNNNNNN, new names for each size, as the interned names
+//    are never freed). The heap memory is the number of bytes requested
+//    from operator new, without the overhead of the heap for each block.
+//    For the interned names the bytes used in the chunks of the
+//    DaStringArena are added; the names columns compare them with the
+//    copies of the names of the reference. WCHAR has 4 bytes on Linux
+//    and 2 bytes on Windows.
+//    The map of the Item IDs of the server is the same for both.
+//=========================================================================
+static void BenchmarkMemory()
+{
+   const DWORD          aSizes[] = { 10000, 100000, 1000000 };
+   DASTRINGARENASTATS   Stats0, Stats1;
+   long long            llBytes0, llBlocks0;
+   DWORD                i, s;
+
+   printf( "                    bytes per item     blocks per item      names: KB         new      map\n" );
+   printf( "leafs       items   interned    ref   interned    ref   interned    ref   interned   bytes/item\n" );
+
+   for (int nUnique = 0; nUnique < 2; nUnique++) {
+      DWORD dwFirstTag = 0;
+      for (s = 0; s < sizeof aSizes / sizeof aSizes[0]; s++) {
+         const DWORD                dwItems = aSizes[s];
+         std::vector<DaDeviceItem*> Items;
+         ULONGLONG                  ullRefNameBytes = 0;
+         double                     adBytes[2], adBlocks[2], dMapBytes;
+
+         for (i = 0; i < dwItems; i++) {
+            Items.push_back( NewItem( i, nUnique, dwFirstTag ) );
+         }
+         dwFirstTag += dwItems;
+
+         DaBranch::GetNameStatistics( &Stats0 );
+         llBytes0 = gllHeapBytes;
+         llBlocks0 = gllHeapBlocks;
+         for (i = 0; i < dwItems; i++) {
+            gRoot.AddDeviceItem( ItemIDPtr( Items[i] ), Items[i] );
+         }
+         DaBranch::GetNameStatistics( &Stats1 );
+         adBytes[0] = (double)(gllHeapBytes - llBytes0 + Stats1.ullUsedBytes - Stats0.ullUsedBytes) / dwItems;
+         adBlocks[0] = (double)(gllHeapBlocks - llBlocks0) / dwItems;
+
+         llBytes0 = gllHeapBytes;
+         llBlocks0 = gllHeapBlocks;
+         for (i = 0; i < dwItems; i++) {
+            LPCWSTR szItemID = ItemIDPtr( Items[i] );
+            gRefRoot.AddDeviceItem( szItemID, Items[i] );
+            // Names of the leaf and of the new unit and plant branches
+            ullRefNameBytes += (wcslen( wcsrchr( szItemID, L'.' ) ) + (i % 100 == 0 ? 7 : 0) +
+                                (i % 10000 == 0 ? wcschr( szItemID, L'.' ) - szItemID + 1 : 0)) * sizeof (WCHAR);
+         }
+         adBytes[1] = (double)(gllHeapBytes - llBytes0) / dwItems;
+         adBlocks[1] = (double)(gllHeapBlocks - llBlocks0) / dwItems;
+
+         {
+            ItemIDMap mapItemIDs;
+            llBytes0 = gllHeapBytes;
+            for (i = 0; i < dwItems; i++) {
+               mapItemIDs.SetAt( ItemIDPtr( Items[i] ), Items[i] );
+            }
+            dMapBytes = (double)(gllHeapBytes - llBytes0) / dwItems;
+         }
+
+         printf( "%-7s %9u   %8.1f %6.1f   %8.2f %6.2f   %8.0f %6.0f   %8u   %10.1f\n",
+                 nUnique ? "unique" : "repeated", dwItems, adBytes[0], adBytes[1], adBlocks[0], adBlocks[1],
+                 (Stats1.ullUsedBytes - Stats0.ullUsedBytes) / 1024.0, ullRefNameBytes / 1024.0,
+                 Stats1.dwInterned - Stats0.dwInterned, dMapBytes );
+
+         gRoot.RemoveAll();
+         gRefRoot.RemoveAll();
+         for (i = 0; i < dwItems; i++) {
+            delete Items[i];
+         }
+      }
+   }
+}
+
+
+//=========================================================================
+// Benchmark of the browsing
+// -------------------------
+//    Latency of the browse functions with 100'000 items, 10 plants with
+//    100 units each and 100 items per unit, for DaBranch and for the
+//    reference implementation. The leafs are browsed with the access
+//    rights filter set by DaServer.
+//=========================================================================
+template <class B>
+static void BrowseLatency( B& Root, double* adNs )
+{
+   const DWORD dwAccessRights = OPC_READABLE | OPC_WRITEABLE;     // as set by DaServer
+   B*          pPlant;
+   B*          pUnit;
+   B*          pPos;
+   DWORD       dwCount;
+   BSTR*       pszNames;
+   BSTR        szName;
+
+   Root.ChangeBrowsePosition( OPC_BROWSE_DOWN, L"Plant5", &pPlant );
+   pPlant->ChangeBrowsePosition( OPC_BROWSE_DOWN, L"Unit42", &pUnit );
+
+   adNs[0] = NsPerCall( [&]() { Root.ChangeBrowsePosition( OPC_BROWSE_TO, L"Plant5.Unit42", &pPos ); } );
+   adNs[1] = NsPerCall( [&]() { pPlant->ChangeBrowsePosition( OPC_BROWSE_DOWN, L"Unit42", &pPos ); } );
+   adNs[2] = NsPerCall( [&]() {
+      pPlant->BrowseBranches( L"", &dwCount, &pszNames );
+      FreeNames( dwCount, pszNames );
+   } );
+   adNs[3] = NsPerCall( [&]() {
+      pUnit->BrowseLeafs( L"", VT_EMPTY, dwAccessRights, &dwCount, &pszNames );
+      FreeNames( dwCount, pszNames );
+   } );
+   adNs[4] = NsPerCall( [&]() {
+      pUnit->BrowseLeafs( L"Item4*", VT_EMPTY, dwAccessRights, &dwCount, &pszNames );
+      FreeNames( dwCount, pszNames );
+   } );
+   adNs[5] = NsPerCall( [&]() {
+      pUnit->GetFullyQualifiedName( L"Item42", &szName );
+      SysFreeString( szName );
+   } );
+   adNs[6] = NsPerCall( [&]() {
+      pPlant->BrowseFlat( L"", VT_EMPTY, dwAccessRights, &dwCount, &pszNames );
+      FreeNames( dwCount, pszNames );
+   } );
+}
+
+static void BenchmarkBrowse()
+{
+   static const char* apszOperations[] = {
+      "browse to Plant5.Unit42", "browse down to Unit42", "BrowseBranches, 100 names",
+      "BrowseLeafs, 100 names", "BrowseLeafs Item4*, 10 names", "fully qualified leaf name",
+      "BrowseFlat, 10'000 names"
+   };
+   const DWORD                dwItems = 100000;
+   const DWORD                dwOperations = sizeof apszOperations / sizeof apszOperations[0];
+   std::vector<DaDeviceItem*> Items;
+   double                     adNs[2][ dwOperations ];
+   DWORD                      i;
+
+   for (i = 0; i < dwItems; i++) {
+      Items.push_back( NewItem( i ) );
+      gRoot.AddDeviceItem( ItemIDPtr( Items[i] ), Items[i] );
+      gRefRoot.AddDeviceItem( ItemIDPtr( Items[i] ), Items[i] );
+   }
+   BrowseLatency( gRoot, adNs[0] );
+   BrowseLatency( gRefRoot, adNs[1] );
+
+   printf( "\n%u items                      ns per call: interned    reference   speedup\n", dwItems );
+   for (i = 0; i < dwOperations; i++) {
+      printf( "%-30s %20.0f %12.0f %9.2f\n", apszOperations[i], adNs[0][i], adNs[1][i], adNs[1][i] / adNs[0][i] );
+   }
+
+   gRoot.RemoveAll();
+   gRefRoot.RemoveAll();
+   for (i = 0; i < dwItems; i++) {
+      delete Items[i];
+   }
+}
+
+
+int main( int argc, char* argv[] )
+{
+   gRoot.CreateAsRoot();
+   gRefRoot.CreateAsRoot();
+
+   if (IsBenchmark( argc, argv )) {
+      BenchmarkMemory();                        // first, before names are interned
+      Benchmark();
+      BenchmarkStartup();
+      BenchmarkBrowse();
+      return 0;
+   }
+
+   TestAddAndFind();
+   TestBrowsePosition();
+   TestBrowseOrder();
+   TestAddItems();
+
+   return TestResult();
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Reference implementation for the benchmark: the address space with the
+// names stored in each branch and leaf and the members in hash maps,
+// which was replaced by interned names and sorted arrays. Kept unchanged
+// except for the names of the classes and the fixes of the fully
+// qualified names, so that both can be used in the same test.
+//-------------------------------------------------------------------------
+
+#ifndef __DAADDRESSSPACEREFERENCE_H
+#define __DAADDRESSSPACEREFERENCE_H
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif // _MSC_VER >= 1000
+
+#include "WideString.h"
+#include "UtilityDefs.h"
+#include <atlcoll.h>
+#include "DaAddressSpace.h"                     // LPCWSTRRefElementTraits
+
+
+class DaDeviceItem;
+class DaLeafReference;
+
+//-----------------------------------------------------------------------------
+// CLASS DaBranchReference
+//-----------------------------------------------------------------------------
+class DaBranchReference
+{
+// Construction / Destruction
+public:
+   DaBranchReference();
+   HRESULT CreateAsRoot();
+   ~DaBranchReference();
+
+// Operations
+public:
+   static void SetDelimiter( WCHAR wc ) {
+      m_szDelimiter[0] = wc;
+   }
+   HRESULT  AddBranch( LPCWSTR szBranchName, DaBranchReference** ppBranch );
+   HRESULT  AddLeaf( LPCWSTR szLeafName, DaDeviceItem* pDItem );
+   HRESULT  AddDeviceItem( LPCWSTR szSASName, DaDeviceItem* pDItem );
+   HRESULT  FindDeviceItem( LPCWSTR szItemID, DaDeviceItem** ppDItem );
+
+   HRESULT  ChangeBrowsePosition( OPCBROWSEDIRECTION dwBrowseDirection, LPCWSTR szPosition, DaBranchReference** ppNewPos );
+   HRESULT  BrowseBranches( LPCWSTR szFilterCriteria, LPDWORD pdwNumOfBranches, BSTR** ppszBranches );
+
+   HRESULT  BrowseLeafs( LPCWSTR szFilterCriteria, VARTYPE vtDataTypeFilter, DWORD dwAccessRightsFilter,
+                         LPDWORD pdwNumOfLeafs, BSTR** ppszLeafs );
+
+   HRESULT  BrowseFlat( LPCWSTR szFilterCriteria, VARTYPE vtDataTypeFilter, DWORD dwAccessRightsFilter,
+                        LPDWORD pdwNumOfLeafs, BSTR** ppszLeafs );
+
+   HRESULT  GetFullyQualifiedName( LPCWSTR szName, BSTR* pszFullyQualifiedName );
+   void     RemoveAll( BOOL fKillDeviceItems = FALSE );
+   HRESULT  RemoveLeaf( LPCWSTR szLeafName, BOOL fKillDeviceItem = FALSE );
+   HRESULT  RemoveBranch( LPCWSTR szBranchName, BOOL fKillDeviceItems = FALSE );
+   HRESULT  RemoveDeviceItemAssociatedLeaf( LPCWSTR szItemID, BOOL fKillDeviceItem = FALSE );
+
+// Implementation
+protected:
+   HRESULT  Create( DaBranchReference* pParent, LPCWSTR szBranchName );
+
+   HRESULT  BrowseLeafs( BOOL fReturnFullyQualifiedNames,
+                         LPCWSTR szFilterCriteria, VARTYPE vtDataTypeFilter, DWORD dwAccessRightsFilter,
+                         LPDWORD pdwNumOfLeafs, BSTR** ppszLeafs );
+
+   HRESULT  GetFullyQualifiedName( BSTR* pszFullyQualifiedName );
+   HRESULT  ChangePositionDown( LPCWSTR szPosition, DaBranchReference** ppNewPos );
+   BOOL     FilterName( LPCWSTR szName, LPCWSTR szFilterCriteria, BOOL fFilterBranch );
+   BOOL     ExistLeaf( LPCWSTR szLeafName );
+   void*    new_realloc( void* memblock, size_t sizeOld, size_t sizeNew );
+
+   static WCHAR m_szDelimiter[2];
+
+      static
+   DaBranchReference*    m_pRoot;
+
+   DaBranchReference*    m_pParent;
+   WideString    m_wsName;                     // The name of the branch
+
+      // Map with the branch members of this branch
+   CAtlMap<LPCWSTR,DaBranchReference*,LPCWSTRRefElementTraits<LPCWSTR>>  m_mapBranches;
+
+      // Map with the leaf members of this branch
+   CAtlMap<LPCWSTR,DaLeafReference*,LPCWSTRRefElementTraits<LPCWSTR>>    m_mapLeafs;
+
+      // The critical section to lock/unlock the map of branch members
+   CComAutoCriticalSection m_csBranches;
+
+      // The critical section to lock/unlock the map of leaf members
+   CComAutoCriticalSection m_csLeafs;
+};
+
+
+//-----------------------------------------------------------------------------
+// CLASS DaBranchReference
+//-----------------------------------------------------------------------------
+class DaLeafReference
+{
+// Construction / Destruction
+public:
+   DaLeafReference();
+   HRESULT Create( LPCWSTR szName, DaDeviceItem* pDItem );
+   ~DaLeafReference();
+
+// Attributes
+public:
+   inline WideString&     Name()               { return m_wsName; }
+   inline DaDeviceItem&     DeviceItem() const   { return *m_pDItemRef; }
+
+// Operations
+public:
+   HRESULT  GetFullyQualifiedName( DaBranchReference* pParent, BSTR* pszFullyQualifiedName );
+   HRESULT  IsDeviceItem( LPCWSTR szItemID );
+
+// Implementation
+protected:
+   WideString    m_wsName;                     // The name of the leaf
+   DaDeviceItem*   m_pDItemRef;
+
+   friend HRESULT DaBranchReference::RemoveLeaf( LPCWSTR, BOOL );
+   friend void    DaBranchReference::RemoveAll( BOOL );
+   BOOL           m_fKillDeviceItemOnDestroy;
+};
+
+#endif // __DAADDRESSSPACEREFERENCE_H
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of Da/DaDeviceItem.h for the address space test. Provides
+// the members used by the branches and leafs.
+//-------------------------------------------------------------------------
+#ifndef __Tests_DaDeviceItem_H
+#define __Tests_DaDeviceItem_H
+
+class DaDeviceItem {
+public:
+   DaDeviceItem( LPCWSTR szItemID, VARTYPE vtCanonical, DWORD dwAccessRights )
+      : m_szItemID( SysAllocString( szItemID ) ), m_vtCanonical( vtCanonical ),
+        m_dwAccessRights( dwAccessRights ), m_fKilled( FALSE ) {}
+   ~DaDeviceItem() { SysFreeString( m_szItemID ); }
+
+   int      Kill( BOOL )                           { m_fKilled = TRUE; return 0; }
+   BOOL     Killed( void ) const                   { return m_fKilled; }
+   VARTYPE  get_CanonicalDataType( void )          { return m_vtCanonical; }
+   HRESULT  get_ItemIDPtr( LPWSTR* ItemID )        { *ItemID = m_szItemID; return S_OK; }
+   HRESULT  get_AccessRights( DWORD* pAccessRights ) { *pAccessRights = m_dwAccessRights; return S_OK; }
+
+private:
+   BSTR     m_szItemID;
+   VARTYPE  m_vtCanonical;
+   DWORD    m_dwAccessRights;
+   BOOL     m_fKilled;
+};
+
+#endif // __Tests_DaDeviceItem_H
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of ATL atlcoll.h for the address space test on systems
+// without ATL. Only the members used by the address space, by its
+// reference implementation and by the map of the Item IDs of the server.
+//
+// CAtlMap is a chained hash table which is rehashed like the one of ATL:
+// if the number of elements exceeds 2.25 times the number of bins, the
+// bins are grown so that the load is 0.75 again.
+//-------------------------------------------------------------------------
+#ifndef __Tests_atlcoll_H
+#define __Tests_atlcoll_H
+
+template< typename T >
+class CElementTraitsBase
+{
+public:
+   typedef const T& INARGTYPE;
+   typedef T& OUTARGTYPE;
+};
+
+   // The traits of the Item IDs (DaAddressSpace.h) use INARGTYPE of the
+   // dependent base class without qualification, which only MSVC accepts.
+   // They are only used for LPCWSTR.
+typedef CElementTraitsBase< LPCWSTR >::INARGTYPE INARGTYPE;
+
+struct __POSITION {};
+typedef __POSITION* POSITION;
+
+#define ATLENSURE( expr )  do { if (!(expr)) throw E_FAIL; } while (0)
+
+
+//-------------------------------------------------------------------------
+// CAtlArray
+//-------------------------------------------------------------------------
+template< typename E >
+class CAtlArray
+{
+public:
+   size_t   GetCount( void ) const                 { return m_Data.size(); }
+   size_t   Add( const E& element )                { m_Data.push_back( element ); return m_Data.size() - 1; }
+   void     InsertAt( size_t iElement, const E& element ) { m_Data.insert( m_Data.begin() + iElement, element ); }
+   void     RemoveAt( size_t iElement, size_t nCount = 1 )
+               { m_Data.erase( m_Data.begin() + iElement, m_Data.begin() + iElement + nCount ); }
+   void     RemoveAll( void )                      { std::vector<E>().swap( m_Data ); }
+   E&       operator[]( size_t iElement )          { return m_Data[ iElement ]; }
+   const E& operator[]( size_t iElement ) const    { return m_Data[ iElement ]; }
+
+private:
+   std::vector<E> m_Data;
+};
+
+
+//-------------------------------------------------------------------------
+// CAtlMap
+//-------------------------------------------------------------------------
+template< typename K, typename V, class KTraits = CElementTraitsBase< K > >
+class CAtlMap
+{
+public:
+   CAtlMap() : m_ppBins( NULL ), m_nBins( 17 ), m_nCount( 0 ) {}
+   ~CAtlMap() { RemoveAll(); }
+
+   size_t   GetCount( void ) const  { return m_nCount; }
+
+   bool Lookup( typename KTraits::INARGTYPE key, V& value ) const
+      {
+         CNode* pNode = Find( key );
+         if (pNode == NULL) return false;
+         value = pNode->m_value;
+         return true;
+      }
+
+   void SetAt( typename KTraits::INARGTYPE key, const V& value )
+      {
+         CNode* pNode = Find( key );
+         if (pNode == NULL) {
+            if (m_ppBins == NULL) {
+               m_ppBins = new CNode*[ m_nBins ]();
+            }
+            ULONG nHash = KTraits::Hash( key );
+            pNode = new CNode( key, nHash, m_ppBins[ nHash % m_nBins ] );
+            m_ppBins[ nHash % m_nBins ] = pNode;
+            if (++m_nCount > m_nBins * 9 / 4) {
+               Rehash( m_nCount * 4 / 3 );
+            }
+         }
+         pNode->m_value = value;
+      }
+
+   bool RemoveKey( typename KTraits::INARGTYPE key )
+      {
+         if (m_ppBins == NULL) return false;
+         CNode** ppNode = &m_ppBins[ KTraits::Hash( key ) % m_nBins ];
+         for (; *ppNode; ppNode = &(*ppNode)->m_pNext) {
+            if (KTraits::CompareElements( (*ppNode)->m_key, key )) {
+               CNode* pNode = *ppNode;
+               *ppNode = pNode->m_pNext;
+               delete pNode;
+               m_nCount--;
+               return true;
+            }
+         }
+         return false;
+      }
+
+   POSITION GetStartPosition( void ) const
+      {
+         return (POSITION)FirstNode( 0 );
+      }
+
+   V& GetNextValue( POSITION& pos )
+      {
+         CNode* pNode = (CNode*)pos;
+         pos = (POSITION)(pNode->m_pNext ? pNode->m_pNext : FirstNode( pNode->m_nHash % m_nBins + 1 ));
+         return pNode->m_value;
+      }
+
+   void RemoveAtPos( POSITION pos )
+      {
+         CNode* pNode = (CNode*)pos;
+         CNode** ppNode = &m_ppBins[ pNode->m_nHash % m_nBins ];
+         while (*ppNode != pNode) {
+            ppNode = &(*ppNode)->m_pNext;
+         }
+         *ppNode = pNode->m_pNext;
+         delete pNode;
+         m_nCount--;
+      }
+
+   void RemoveAll( void )
+      {
+         if (m_ppBins) {
+            for (size_t i = 0; i < m_nBins; i++) {
+               while (m_ppBins[i]) {
+                  CNode* pNode = m_ppBins[i];
+                  m_ppBins[i] = pNode->m_pNext;
+                  delete pNode;
+               }
+            }
+            delete [] m_ppBins;
+            m_ppBins = NULL;
+         }
+         m_nBins = 17;
+         m_nCount = 0;
+      }
+
+private:
+   struct CNode {
+      CNode( const K& key, ULONG nHash, CNode* pNext ) : m_key( key ), m_value(), m_nHash( nHash ), m_pNext( pNext ) {}
+      K        m_key;
+      V        m_value;
+      ULONG    m_nHash;
+      CNode*   m_pNext;
+   };
+
+   CNode* Find( typename KTraits::INARGTYPE key ) const
+      {
+         if (m_ppBins == NULL) return NULL;
+         ULONG nHash = KTraits::Hash( key );
+         for (CNode* pNode = m_ppBins[ nHash % m_nBins ]; pNode; pNode = pNode->m_pNext) {
+            if (pNode->m_nHash == nHash && KTraits::CompareElements( pNode->m_key, key )) {
+               return pNode;
+            }
+         }
+         return NULL;
+      }
+
+   CNode* FirstNode( size_t iBin ) const
+      {
+         for (; m_ppBins && iBin < m_nBins; iBin++) {
+            if (m_ppBins[ iBin ]) return m_ppBins[ iBin ];
+         }
+         return NULL;
+      }
+
+   void Rehash( size_t nBins )
+      {
+         CNode** ppBins = new CNode*[ nBins ]();
+         for (size_t i = 0; i < m_nBins; i++) {
+            while (m_ppBins[i]) {
+               CNode* pNode = m_ppBins[i];
+               m_ppBins[i] = pNode->m_pNext;
+               pNode->m_pNext = ppBins[ pNode->m_nHash % nBins ];
+               ppBins[ pNode->m_nHash % nBins ] = pNode;
+            }
+         }
+         delete [] m_ppBins;
+         m_ppBins = ppBins;
+         m_nBins = nBins;
+      }
+
+   CNode**  m_ppBins;
+   size_t   m_nBins;
+   size_t   m_nCount;
+
+   CAtlMap( const CAtlMap& );
+   CAtlMap& operator=( const CAtlMap& );
+};
+
+#endif // __Tests_atlcoll_H
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// OPC and ATL definitions used by DaAddressSpace.h. Force-included into
+// the address space tests after Common/stdafx.h; on Windows the headers
+// of the OPC Foundation and ATL are used.
+//-------------------------------------------------------------------------
+#ifndef __Tests_OpcDaTypes_H
+#define __Tests_OpcDaTypes_H
+
+#ifdef _WIN32
+
+#include <atlbase.h>
+#include "opcda.h"
+
+#else
+
+typedef enum tagOPCBROWSEDIRECTION {
+   OPC_BROWSE_UP     = 1,
+   OPC_BROWSE_DOWN   = 2,
+   OPC_BROWSE_TO     = 3
+} OPCBROWSEDIRECTION;
+
+#define OPC_READABLE    1
+#define OPC_WRITEABLE   2
+
+
+//-------------------------------------------------------------------------
+// ATL CComAutoCriticalSection
+//-------------------------------------------------------------------------
+class CComAutoCriticalSection {
+public:
+   CComAutoCriticalSection()  { InitializeCriticalSection( &m_sec ); }
+   ~CComAutoCriticalSection() { DeleteCriticalSection( &m_sec ); }
+
+   HRESULT Lock( void )    { EnterCriticalSection( &m_sec ); return S_OK; }
+   HRESULT Unlock( void )  { LeaveCriticalSection( &m_sec ); return S_OK; }
+
+private:
+   CRITICAL_SECTION m_sec;
+};
+
+#endif // _WIN32
+
+#endif // __Tests_OpcDaTypes_H
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of Core/UtilityDefs.h for the address space test, which
+// requires the COM memory allocator. ComAlloc() is used by WideString
+// but not by the address space.
+//-------------------------------------------------------------------------
+#ifndef __Tests_UtilityDefs_H
+#define __Tests_UtilityDefs_H
+
+template <class T> T* ComAlloc( DWORD dwNum = 1 ) { return (T*)malloc( sizeof (T) * dwNum ); }
+
+#endif // __Tests_UtilityDefs_H
@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the snapshot and the cursors of the IOPCBrowse::Browse()
+// Continuation Points: the cursor format, the fallback to the name of
+// the element if the address space version, the Browse() parameters or
+// the position of the cursor do not match, and paged browsing with the
+// steps of DaBrowse::Browse(). Returns 0 if all cases pass.
+//
+// With the argument --benchmark a full paged browse with cursors in the
+// snapshot is compared with the name-based resume, which browses the
+// level again for each page.
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include <string>
+#include "UtilityDefs.h"
+#include "UtilityFuncs.h"
+#include "DaBrowseSnapshot.h"
+
+               // A level of the address space at the browse position
+               // L"Plant1.Unit01", as returned by OnBrowseItemIdentifiers()
+struct Level {
+   std::vector<std::wstring>  Branches;
+   std::vector<std::wstring>  Items;
+   LONG                       lVersion;         // DaBaseServer::GetAddressSpaceVersion()
+
+   Level( DWORD dwBranches, DWORD dwItems )
+   {
+      WCHAR szName[32];
+      for (DWORD i = 0; i < dwBranches; i++) {
+         swprintf_s( szName, L"Branch%04u", i );
+         Branches.push_back( szName );
+      }
+      for (DWORD i = 0; i < dwItems; i++) {
+         swprintf_s( szName, L"Tag%07u", i );
+         Items.push_back( szName );
+      }
+      lVersion = 1;
+   }
+};
+
+#define  POSITION    L"Plant1.Unit01"
+
+static BSTR* NewElementIDs( const std::vector<std::wstring>& Names )
+{
+   BSTR* pIDs = new BSTR[ Names.size() + 1 ];
+   for (size_t i = 0; i < Names.size(); i++) {
+      pIDs[i] = SysAllocString( Names[i].c_str() );
+   }
+   return pIDs;
+}
+
+static std::wstring ElementCP( LPCWSTR szToken, const std::wstring& Name )
+{
+   return std::wstring( szToken ) + Name;
+}
+
+static std::wstring Cursor( DWORD dwID, DWORD dwVersion, DWORD dwIndex, const std::wstring& ElementCP )
+{
+   WCHAR szFields[40];
+   swprintf_s( szFields, L"%u.%u.%u#", dwID, dwVersion, dwIndex );
+   return std::wstring( CURSORTOKENSTRING ) + szFields + ElementCP;
+}
+
+static BOOL ParseCursor( LPCWSTR szCursor, DWORD* pdwID, DWORD* pdwVersion, DWORD* pdwIndex )
+{
+   size_t nTokenLen = wcslen( CURSORTOKENSTRING );
+   if (wcsncmp( szCursor, CURSORTOKENSTRING, nTokenLen ) != 0) {
+      return FALSE;
+   }
+   return swscanf( szCursor + nTokenLen, L"%u.%u.%u#", pdwID, pdwVersion, pdwIndex ) == 3;
+}
+
+               // The snapshot of the level with all Browse() parameters
+               // at their defaults
+static void SaveLevel( DaBrowseSnapshot& Snapshot, const Level& L )
+{
+   BSTR* pBranchIDs = NewElementIDs( L.Branches );
+   BSTR* pItemIDs = NewElementIDs( L.Items );
+   if (FAILED( Snapshot.Save( L.lVersion, OPC_BROWSE_FILTER_ALL, POSITION, L"", L"",
+                              (DWORD)L.Branches.size(), pBranchIDs, (DWORD)L.Items.size(), pItemIDs ) )) {
+      DaBrowseSnapshot::ReleaseElementIDs( (DWORD)L.Branches.size(), pBranchIDs );
+      DaBrowseSnapshot::ReleaseElementIDs( (DWORD)L.Items.size(), pItemIDs );
+   }
+}
+
+               // The Continuation Point of the element at dwIndex
+static std::wstring GetCP( DaBrowseSnapshot& Snapshot, BOOL fCursor, DWORD dwIndex )
+{
+   LPWSTR   szCP = NULL;
+   HRESULT  hres = Snapshot.SetContinuationPoint( fCursor, dwIndex,
+                                                  Snapshot.GetNumOfBranchIDs(), Snapshot.GetBranchIDs(),
+                                                  Snapshot.GetItemIDs(), &szCP );
+   std::wstring CP( SUCCEEDED( hres ) ? szCP : L"" );
+   ComFreeString( szCP );
+   return CP;
+}
+
+static BOOL Find( DaBrowseSnapshot& Snapshot, const std::wstring& CP, LONG lVersion,
+                  DWORD* pdwIndex, std::wstring* pElementCP,
+                  OPCBROWSEFILTER dwBrowseFilter = OPC_BROWSE_FILTER_ALL, LPCWSTR szPosition = POSITION,
+                  LPCWSTR szElementNameFilter = L"", LPCWSTR szVendorFilter = L"" )
+{
+   LPCWSTR szElementCP = NULL;
+   BOOL fFound = Snapshot.Find( CP.c_str(), lVersion, dwBrowseFilter, szPosition,
+                                szElementNameFilter, szVendorFilter, pdwIndex, &szElementCP );
+   *pElementCP = szElementCP;
+   return fFound;
+}
+
+
+//=========================================================================
+// Cursor format and Find() of a valid cursor
+//=========================================================================
+static void TestCursor()
+{
+   Level             L( 3, 20 );
+   DaBrowseSnapshot  Snapshot;
+   DWORD             dwIndex = 0, dwID, dwVersion, dwCursorIndex;
+   std::wstring      ElemCP;
+
+   Check( Snapshot.GetNumOfBranchIDs() == 0 && Snapshot.GetItemIDs() == NULL, "no elements before Save()" );
+   SaveLevel( Snapshot, L );
+   Check( Snapshot.GetNumOfBranchIDs() == 3 && Snapshot.GetNumOfItemIDs() == 20, "Save() keeps the elements" );
+
+   Check( GetCP( Snapshot, FALSE, 1 ) == ElementCP( BRANCHTOKENSTRING, L"Branch0001" ),
+          "name-based Continuation Point of a branch" );
+   Check( GetCP( Snapshot, FALSE, 5 ) == ElementCP( ITEMTOKENSTRING, L"Tag0000002" ),
+          "name-based Continuation Point of an item behind the branches" );
+
+   std::wstring CP = GetCP( Snapshot, TRUE, 5 );
+   Check( ParseCursor( CP.c_str(), &dwID, &dwVersion, &dwCursorIndex ), "cursor syntax" );
+   Check( dwID != 0 && dwVersion == 1 && dwCursorIndex == 5, "cursor fields" );
+   Check( CP.compare( CP.size() - wcslen( ITEMTOKENSTRING ) - 10, std::wstring::npos,
+                      ElementCP( ITEMTOKENSTRING, L"Tag0000002" ) ) == 0,
+          "cursor ends with the name-based Continuation Point" );
+
+   Check( Find( Snapshot, CP, 1, &dwIndex, &ElemCP ) && dwIndex == 5, "Find() of a valid cursor" );
+   Check( ElemCP == ElementCP( ITEMTOKENSTRING, L"Tag0000002" ), "Find() returns the element Continuation Point" );
+
+   CP = GetCP( Snapshot, TRUE, 0 );
+   Check( Find( Snapshot, CP, 1, &dwIndex, &ElemCP ) && dwIndex == 0, "Find() of a cursor at the first element" );
+   CP = GetCP( Snapshot, TRUE, 22 );
+   Check( Find( Snapshot, CP, 1, &dwIndex, &ElemCP ) && dwIndex == 22, "Find() of a cursor at the last element" );
+
+   std::wstring NameCP = ElementCP( BRANCHTOKENSTRING, L"Branch0001" );
+   Check( !Find( Snapshot, NameCP, 1, &dwIndex, &ElemCP ) && ElemCP == NameCP,
+          "a name-based Continuation Point is returned unchanged" );
+}
+
+
+//=========================================================================
+// Fallback if the address space version does not match
+//=========================================================================
+static void TestFallbackVersion()
+{
+   Level             L( 3, 20 );
+   DaBrowseSnapshot  Snapshot;
+   DWORD             dwIndex = 99, dwID, dwVersion, dwCursorIndex;
+   std::wstring      ElemCP;
+
+   SaveLevel( Snapshot, L );
+   std::wstring CP = GetCP( Snapshot, TRUE, 10 );
+   ParseCursor( CP.c_str(), &dwID, &dwVersion, &dwCursorIndex );
+   std::wstring NameCP = ElementCP( ITEMTOKENSTRING, L"Tag0000007" );
+
+   Check( !Find( Snapshot, CP, 2, &dwIndex, &ElemCP ) && dwIndex == 99,
+          "cursor not found after the address space changed" );
+   Check( ElemCP == NameCP, "fallback to the name after the address space changed" );
+
+   Check( !Find( Snapshot, Cursor( dwID, 2, 10, NameCP ), 1, &dwIndex, &ElemCP ),
+          "cursor with another version not found" );
+   Check( ElemCP == NameCP, "fallback to the name with another version in the cursor" );
+   Check( !Find( Snapshot, Cursor( dwID, 2, 10, NameCP ), 2, &dwIndex, &ElemCP ),
+          "cursor of a newer version not found in the older snapshot" );
+
+               // The snapshot of the new version replaces the old one
+   L.lVersion = 2;
+   SaveLevel( Snapshot, L );
+   Check( !Find( Snapshot, CP, 2, &dwIndex, &ElemCP ) && ElemCP == NameCP,
+          "cursor of a replaced snapshot not found" );
+   std::wstring NewCP = GetCP( Snapshot, TRUE, 10 );
+   Check( Find( Snapshot, NewCP, 2, &dwIndex, &ElemCP ) && dwIndex == 10, "cursor of the new snapshot found" );
+
+   Snapshot.Release();
+   Check( !Find( Snapshot, NewCP, 2, &dwIndex, &ElemCP ) && ElemCP == NameCP,
+          "cursor of a released snapshot not found" );
+}
+
+
+//=========================================================================
+// Fallback if the Browse() parameters do not match
+//=========================================================================
+static void TestFallbackParameters()
+{
+   Level             L( 3, 20 );
+   DaBrowseSnapshot  Snapshot;
+   DWORD             dwIndex = 99;
+   std::wstring      ElemCP;
+
+   SaveLevel( Snapshot, L );
+   std::wstring CP = GetCP( Snapshot, TRUE, 2 );
+   std::wstring NameCP = ElementCP( BRANCHTOKENSTRING, L"Branch0002" );
+
+   Check( !Find( Snapshot, CP, 1, &dwIndex, &ElemCP, OPC_BROWSE_FILTER_BRANCHES ) && ElemCP == NameCP,
+          "fallback with another browse filter" );
+   Check( !Find( Snapshot, CP, 1, &dwIndex, &ElemCP, OPC_BROWSE_FILTER_ALL, L"Plant1.Unit02" ) && ElemCP == NameCP,
+          "fallback at another browse position" );
+   Check( !Find( Snapshot, CP, 1, &dwIndex, &ElemCP, OPC_BROWSE_FILTER_ALL, POSITION, L"Tag*" ) && ElemCP == NameCP,
+          "fallback with another element name filter" );
+   Check( !Find( Snapshot, CP, 1, &dwIndex, &ElemCP, OPC_BROWSE_FILTER_ALL, POSITION, L"", L"Vendor" ) && ElemCP == NameCP,
+          "fallback with another vendor filter" );
+   Check( dwIndex == 99, "no index returned on fallback" );
+   Check( Find( Snapshot, CP, 1, &dwIndex, &ElemCP ) && dwIndex == 2, "same parameters resume at the cursor" );
+}
+
+
+//=========================================================================
+// Fallback if the position of the cursor does not match or the cursor
+// is invalid
+//=========================================================================
+static void TestFallbackPosition()
+{
+   Level             L( 3, 20 );
+   DaBrowseSnapshot  Snapshot;
+   DWORD             dwIndex = 99, dwID, dwVersion, dwCursorIndex;
+   std::wstring      ElemCP;
+
+   SaveLevel( Snapshot, L );
+   std::wstring CP = GetCP( Snapshot, TRUE, 4 );
+   ParseCursor( CP.c_str(), &dwID, &dwVersion, &dwCursorIndex );
+   std::wstring NameCP = ElementCP( ITEMTOKENSTRING, L"Tag0000001" );
+
+   Check( !Find( Snapshot, Cursor( dwID, dwVersion, 23, NameCP ), 1, &dwIndex, &ElemCP ) && ElemCP == NameCP,
+          "fallback with the index behind the last element" );
+   Check( !Find( Snapshot, Cursor( dwID, dwVersion, 0xFFFFFFFF, NameCP ), 1, &dwIndex, &ElemCP ) && ElemCP == NameCP,
+          "fallback with the maximal index" );
+   Check( !Find( Snapshot, Cursor( dwID + 1, dwVersion, 4, NameCP ), 1, &dwIndex, &ElemCP ) && ElemCP == NameCP,
+          "fallback with the ID of another snapshot" );
+   Check( !Find( Snapshot, Cursor( 0, dwVersion, 4, NameCP ), 1, &dwIndex, &ElemCP ),
+          "fallback with snapshot ID 0" );
+   Check( dwIndex == 99, "no index returned on fallback" );
+
+   std::wstring Token( CURSORTOKENSTRING );
+   Check( !Find( Snapshot, Token + L"1.1#" + NameCP, 1, &dwIndex, &ElemCP ), "cursor with two fields" );
+   Check( !Find( Snapshot, Token + L"1.x.4#" + NameCP, 1, &dwIndex, &ElemCP ), "cursor with a field which is not a number" );
+   Check( !Find( Snapshot, Token + L"1.1.4" + NameCP, 1, &dwIndex, &ElemCP ), "cursor without terminating #" );
+   Check( !Find( Snapshot, Token, 1, &dwIndex, &ElemCP ), "cursor token only" );
+   Check( dwIndex == 99, "no index returned for invalid cursors" );
+}
+
+
+//=========================================================================
+// ResumeAtElement(), the name-based resume
+//=========================================================================
+static void TestResumeAtElement()
+{
+   Level    L( 3, 20 );
+   DWORD    dwBranches, dwItems;
+   BSTR*    pBranchIDs;
+   BSTR*    pItemIDs;
+   HRESULT  hres;
+
+   auto Browse = [&]() {
+      dwBranches = (DWORD)L.Branches.size();
+      dwItems = (DWORD)L.Items.size();
+      pBranchIDs = NewElementIDs( L.Branches );
+      pItemIDs = NewElementIDs( L.Items );
+   };
+   auto Release = [&]() {
+      DaBrowseSnapshot::ReleaseElementIDs( dwBranches, pBranchIDs );
+      DaBrowseSnapshot::ReleaseElementIDs( dwItems, pItemIDs );
+   };
+
+   Browse();
+   hres = DaBrowseSnapshot::ResumeAtElement( ElementCP( BRANCHTOKENSTRING, L"Branch0001" ).c_str(),
+                                             &dwBranches, pBranchIDs, &dwItems, pItemIDs );
+   Check( hres == S_OK && dwBranches == 2 && dwItems == 20 && wcscmp( pBranchIDs[0], L"Branch0001" ) == 0,
+          "resume at a branch" );
+   Release();
+
+   Browse();
+   hres = DaBrowseSnapshot::ResumeAtElement( ElementCP( ITEMTOKENSTRING, L"Tag0000005" ).c_str(),
+                                             &dwBranches, pBranchIDs, &dwItems, pItemIDs );
+   Check( hres == S_OK && dwBranches == 0 && dwItems == 15 && wcscmp( pItemIDs[0], L"Tag0000005" ) == 0,
+          "resume at an item skips all branches" );
+   Release();
+
+   Browse();
+   hres = DaBrowseSnapshot::ResumeAtElement( ElementCP( ITEMTOKENSTRING, L"Tag9999999" ).c_str(),
+                                             &dwBranches, pBranchIDs, &dwItems, pItemIDs );
+   Check( hres == OPC_E_INVALIDCONTINUATIONPOINT, "resume at a removed item fails" );
+   Release();
+
+   Browse();
+   hres = DaBrowseSnapshot::ResumeAtElement( ElementCP( BRANCHTOKENSTRING, L"Branch9999" ).c_str(),
+                                             &dwBranches, pBranchIDs, &dwItems, pItemIDs );
+   Check( hres == OPC_E_INVALIDCONTINUATIONPOINT, "resume at a removed branch fails" );
+   Release();
+
+   Browse();
+   hres = DaBrowseSnapshot::ResumeAtElement( L"Tag0000005", &dwBranches, pBranchIDs, &dwItems, pItemIDs );
+   Check( hres == OPC_E_INVALIDCONTINUATIONPOINT, "resume without token fails" );
+   Release();
+}
+
+
+//=========================================================================
+// Paged browsing with the steps of DaBrowse::Browse()
+//=========================================================================
+
+               // One call of DaBrowse::Browse() with dwMaxElementsReturned
+               // dwMax. The names of the returned elements are appended to
+               // pNames. Without fUseSnapshot the Continuation Points are
+               // name-based as before the snapshot.
+static HRESULT BrowsePage( DaBrowseSnapshot& Snapshot, const Level& L, BOOL fUseSnapshot,
+                           LPWSTR* pszCP, DWORD dwMax, std::vector<std::wstring>* pNames, BOOL* pfMore )
+{
+   DWORD    dwNumOfBranchIDs = 0, dwNumOfItemIDs = 0;
+   BSTR*    pBranchIDs = NULL;
+   BSTR*    pItemIDs = NULL;
+   BOOL     fSnapshot = FALSE;
+   DWORD    dwFirst = 0;
+   HRESULT  hr = S_OK;
+
+   *pfMore = FALSE;
+   LPCWSTR szElementCP = *pszCP;
+   if (**pszCP != L'\0' && fUseSnapshot) {
+      fSnapshot = Snapshot.Find( *pszCP, L.lVersion, OPC_BROWSE_FILTER_ALL, POSITION, L"", L"",
+                                 &dwFirst, &szElementCP );
+   }
+
+   if (fSnapshot) {
+      dwNumOfBranchIDs = Snapshot.GetNumOfBranchIDs();
+      pBranchIDs = Snapshot.GetBranchIDs();
+      dwNumOfItemIDs = Snapshot.GetNumOfItemIDs();
+      pItemIDs = Snapshot.GetItemIDs();
+   }
+   else {
+      dwNumOfBranchIDs = (DWORD)L.Branches.size();
+      pBranchIDs = NewElementIDs( L.Branches );
+      dwNumOfItemIDs = (DWORD)L.Items.size();
+      pItemIDs = NewElementIDs( L.Items );
+      if (*szElementCP != L'\0') {
+         hr = DaBrowseSnapshot::ResumeAtElement( szElementCP, &dwNumOfBranchIDs, pBranchIDs,
+                                                 &dwNumOfItemIDs, pItemIDs );
+      }
+   }
+
+   if (SUCCEEDED( hr )) {
+      DWORD dwNumOfAllElements = dwNumOfBranchIDs + dwNumOfItemIDs;
+      DWORD dwNext = min( dwFirst + dwMax, dwNumOfAllElements );
+      for (DWORD i = dwFirst; i < dwNext; i++) {
+         pNames->push_back( (i < dwNumOfBranchIDs) ? pBranchIDs[i] : pItemIDs[i - dwNumOfBranchIDs] );
+      }
+
+      *pfMore = (dwNext < dwNumOfAllElements);
+      if (*pfMore) {
+         BOOL fCursor = TRUE;
+         if (!fSnapshot) {
+            fCursor = fUseSnapshot &&
+                      SUCCEEDED( Snapshot.Save( L.lVersion, OPC_BROWSE_FILTER_ALL, POSITION, L"", L"",
+                                                dwNumOfBranchIDs, pBranchIDs, dwNumOfItemIDs, pItemIDs ) );
+            fSnapshot = fCursor;
+         }
+         hr = Snapshot.SetContinuationPoint( fCursor, dwNext, dwNumOfBranchIDs, pBranchIDs, pItemIDs, pszCP );
+      }
+      else {
+         **pszCP = L'\0';
+      }
+   }
+
+   if (!fSnapshot) {
+      DaBrowseSnapshot::ReleaseElementIDs( dwNumOfBranchIDs, pBranchIDs );
+      DaBrowseSnapshot::ReleaseElementIDs( dwNumOfItemIDs, pItemIDs );
+   }
+   else if (!*pfMore && SUCCEEDED( hr )) {
+      Snapshot.Release();
+   }
+   return hr;
+}
+
+static LPWSTR EmptyCP( void )
+{
+   LPWSTR szCP = ComAlloc<WCHAR>( 1 );
+   *szCP = L'\0';
+   return szCP;
+}
+
+               // Browses all pages; the callback can change the level
+               // before each page
+template <class F>
+static HRESULT BrowseAll( DaBrowseSnapshot& Snapshot, Level& L, BOOL fUseSnapshot, DWORD dwMax,
+                          std::vector<std::wstring>* pNames, F BeforePage )
+{
+   LPWSTR   szCP = EmptyCP();
+   BOOL     fMore = TRUE;
+   HRESULT  hr = S_OK;
+   DWORD    dwPage = 0;
+
+   while (fMore && SUCCEEDED( hr )) {
+      BeforePage( dwPage++, szCP );
+      hr = BrowsePage( Snapshot, L, fUseSnapshot, &szCP, dwMax, pNames, &fMore );
+   }
+   ComFreeString( szCP );
+   return hr;
+}
+
+static std::vector<std::wstring> AllNames( const Level& L )
+{
+   std::vector<std::wstring> Names( L.Branches );
+   Names.insert( Names.end(), L.Items.begin(), L.Items.end() );
+   return Names;
+}
+
+static void TestPagedBrowse()
+{
+   for (int iSnapshot = 1; iSnapshot >= 0; iSnapshot--) {
+      BOOL              fUseSnapshot = (BOOL)iSnapshot;
+      Level             L( 3, 250 );
+      DaBrowseSnapshot  Snapshot;
+      std::vector<std::wstring> Names;
+      HRESULT           hr;
+
+      hr = BrowseAll( Snapshot, L, fUseSnapshot, 7, &Names, []( DWORD, LPCWSTR ) {} );
+      Check( hr == S_OK && Names == AllNames( L ),
+             fUseSnapshot ? "paged browse returns all elements once" :
+                            "name-based paged browse returns all elements once" );
+      Check( Snapshot.GetNumOfItemIDs() == 0, "snapshot released after the last page" );
+
+               // Items are added at the end while browsing
+      Names.clear();
+      hr = BrowseAll( Snapshot, L, fUseSnapshot, 7, &Names, [&L]( DWORD dwPage, LPCWSTR ) {
+         if (dwPage == 10 || dwPage == 20) {
+            WCHAR szName[32];
+            swprintf_s( szName, L"Tag%07u", 1000 + dwPage );
+            L.Items.push_back( szName );
+            L.lVersion++;
+         }
+      } );
+      Check( hr == S_OK && Names == AllNames( L ),
+             fUseSnapshot ? "paged browse after the address space changed returns the new elements" :
+                            "name-based paged browse returns the new elements" );
+
+               // The next element is removed while browsing
+      Names.clear();
+      BOOL fRemoved = FALSE;
+      hr = BrowseAll( Snapshot, L, fUseSnapshot, 7, &Names, [&L, &fRemoved]( DWORD dwPage, LPCWSTR szCP ) {
+         if (dwPage == 5) {
+            std::wstring CP( szCP );
+            size_t nPos = CP.find( ITEMTOKENSTRING );
+            std::wstring Next = CP.substr( nPos + wcslen( ITEMTOKENSTRING ) );
+            L.Items.erase( std::find( L.Items.begin(), L.Items.end(), Next ) );
+            L.lVersion++;
+            fRemoved = TRUE;
+         }
+      } );
+      Check( fRemoved && hr == OPC_E_INVALIDCONTINUATIONPOINT && Names.size() == 35,
+             fUseSnapshot ? "paged browse fails if the next element was removed" :
+                            "name-based paged browse fails if the next element was removed" );
+      Snapshot.Release();
+
+               // Two clients alternately browsing with one snapshot each
+      if (fUseSnapshot) {
+         DaBrowseSnapshot  Snapshot2;
+         LPWSTR            szCP1 = EmptyCP();
+         LPWSTR            szCP2 = EmptyCP();
+         std::vector<std::wstring> Names1, Names2;
+         BOOL              fMore1 = TRUE, fMore2 = TRUE;
+         hr = S_OK;
+         while ((fMore1 || fMore2) && SUCCEEDED( hr )) {
+            if (fMore1) hr = BrowsePage( Snapshot, L, TRUE, &szCP1, 11, &Names1, &fMore1 );
+            if (fMore2 && SUCCEEDED( hr )) hr = BrowsePage( Snapshot2, L, TRUE, &szCP2, 13, &Names2, &fMore2 );
+         }
+         Check( hr == S_OK && Names1 == AllNames( L ) && Names2 == AllNames( L ),
+                "interleaved paged browses with two snapshots" );
+         ComFreeString( szCP1 );
+         ComFreeString( szCP2 );
+      }
+   }
+}
+
+
+//=========================================================================
+// Benchmark
+//=========================================================================
+static double BenchmarkBrowse( DWORD dwItems, DWORD dwPage, BOOL fUseSnapshot, size_t* pnReturned )
+{
+   Level             L( 0, dwItems );
+   DaBrowseSnapshot  Snapshot;
+   std::vector<std::wstring> Names;
+   Names.reserve( dwItems );
+
+   double dStart = NowSeconds();
+   BrowseAll( Snapshot, L, fUseSnapshot, dwPage, &Names, []( DWORD, LPCWSTR ) {} );
+   double dTime = NowSeconds() - dStart;
+   *pnReturned = Names.size();
+   return dTime;
+}
+
+static void Benchmark()
+{
+   static const DWORD adwItems[] = { 1000, 10000, 50000 };
+   const DWORD dwPage = 100;
+
+   printf( "full paged browse of a branch, %u elements per page\n", dwPage );
+   printf( "elements   pages         ns per element: cursor    name-based   speedup\n" );
+   for (size_t n = 0; n < sizeof (adwItems) / sizeof (adwItems[0]); n++) {
+      size_t nCursor, nName;
+      double dCursor = BenchmarkBrowse( adwItems[n], dwPage, TRUE, &nCursor );
+      double dName = BenchmarkBrowse( adwItems[n], dwPage, FALSE, &nName );
+      printf( "%8u  %6u  %29.0f  %12.0f  %8.1f%s\n", adwItems[n], adwItems[n] / dwPage,
+              dCursor * 1e9 / adwItems[n], dName * 1e9 / adwItems[n], dName / dCursor,
+              (nCursor == adwItems[n] && nName == adwItems[n]) ? "" : "  (elements missing)" );
+   }
+}
+
+
+int main( int argc, char* argv[] )
+{
+   if (IsBenchmark( argc, argv )) {
+      Benchmark();
+      return 0;
+   }
+
+   TestCursor();
+   TestFallbackVersion();
+   TestFallbackParameters();
+   TestFallbackPosition();
+   TestResumeAtElement();
+   TestPagedBrowse();
+
+   return TestResult();
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// OPC definitions used by Da/DaBrowseSnapshot.h. Force-included into the
+// browse snapshot test after Common/stdafx.h; on Windows the headers of
+// the OPC Foundation are used.
+//-------------------------------------------------------------------------
+#ifndef __Tests_OpcDaTypes_H
+#define __Tests_OpcDaTypes_H
+
+#ifdef _WIN32
+
+#include "opcda.h"
+#include "opcerror.h"
+
+#else
+
+typedef enum tagOPCBROWSEFILTER {
+   OPC_BROWSE_FILTER_ALL         = 1,
+   OPC_BROWSE_FILTER_BRANCHES    = 2,
+   OPC_BROWSE_FILTER_ITEMS       = 3
+} OPCBROWSEFILTER;
+
+#define OPC_E_INVALIDCONTINUATIONPOINT ((HRESULT)0xC0040403L)
+
+#endif // _WIN32
+
+#endif // __Tests_OpcDaTypes_H
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the batch change detection kernels. The scalar, SSE2 and
+// AVX kernels are run over random VT_R8, VT_R4 and VT_I4 columns with
+// deadbands, NaN, infinity and signed zeros; the bit masks of all
+// kernels must be identical and must match the per-item comparison of
+// CompareVariant() (Da/VariantCompare.cpp).
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the batch change detection of 100000
+// items is compared with the per-item comparison instead.
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include "DaChangeKernels.h"
+#include <string>
+
+typedef void (*KERNEL)( DWORD dwCount, const double* pdLast, const double* pdNew,
+                        const double* pdThreshold, DWORD* pdwChanged );
+
+static struct {
+   const char* pszName;
+   KERNEL      pfnKernel;
+} gKernels[] = {
+   { "scalar", DaDetectChangesScalar },
+#ifdef DA_CHANGEKERNELS_SIMD
+   { "SSE2",   DaDetectChangesSSE2 },
+   { "AVX",    DaDetectChangesAVX },
+#endif
+   { "auto",   DaDetectChanges },
+};
+static const int gnKernels = sizeof (gKernels) / sizeof (gKernels[0]);
+
+
+//=========================================================================
+// Columns of one data type with the values as stored by the server and
+// converted to double as done by DaChangeColumns::ToDouble().
+//=========================================================================
+struct Columns {
+   std::vector<VARIANT>    vLast, vNew;
+   std::vector<double>     dLast, dNew, dThreshold;
+
+   void Add( const VARIANT& Last, const VARIANT& New, double dThresh )
+   {
+      vLast.push_back( Last );
+      vNew.push_back( New );
+      dLast.push_back( ToDouble( Last ) );
+      dNew.push_back( ToDouble( New ) );
+      dThreshold.push_back( dThresh );
+   }
+
+   static double ToDouble( const VARIANT& v )
+   {
+      switch (V_VT( &v )) {
+         case VT_R8: return V_R8( &v );
+         case VT_R4: return (double)V_R4( &v );
+         case VT_I4: return (double)V_I4( &v );
+      }
+      return 0;
+   }
+};
+
+
+//=========================================================================
+// Per-item comparison of a value with the last value sent, same as
+// CompareVariant() with the threshold calculated by
+// DaChangeColumns::CalcThreshold():
+//    < 0  : no analog EU info, values must be equal
+//    >= 0 : percent deadband range of the item
+//=========================================================================
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static BOOL CompareItem( const VARIANT& Last, const VARIANT& New, double dThreshold )
+{
+   if (dThreshold < 0) {
+      switch (V_VT( &New )) {
+         case VT_I4: return V_I4( &New ) != V_I4( &Last );
+         case VT_R4: return V_R4( &New ) != V_R4( &Last );
+         case VT_R8: return V_R8( &New ) != V_R8( &Last );
+      }
+   }
+   else {
+      switch (V_VT( &New )) {
+         case VT_R8: return fabs( V_R8( &Last ) - V_R8( &New ) ) > dThreshold;
+         case VT_R4: return fabs( (double)V_R4( &Last ) - (double)V_R4( &New ) ) > dThreshold;
+         case VT_I4: return fabs( (double)V_I4( &Last ) - (double)V_I4( &New ) ) > dThreshold;
+      }
+   }
+   return TRUE;
+}
+
+
+//=========================================================================
+// Random values of a data type with a high rate of special values and of
+// values close to each other.
+//=========================================================================
+class ValueGenerator {
+   public:
+      ValueGenerator() : m_Random( 42 ) {}      // reproducible
+
+      unsigned Next( unsigned n ) { return (unsigned)(m_Random() % n); }
+
+      double Threshold( void )
+      {
+         switch (Next( 8 )) {
+            case 0:  return -1.0;                  // no analog EU info
+            case 1:  return -1.0;
+            case 2:  return 0.0;
+            case 3:  return HUGE_VAL;              // 100% deadband
+            case 4:  return 1e-300;
+            default: return std::uniform_real_distribution<double>( 0, 10 )( m_Random );
+         }
+      }
+
+      VARIANT Value( VARTYPE vt )
+      {
+         VARIANT v;
+         VariantInit( &v );
+         V_VT( &v ) = vt;
+         if (vt == VT_I4) {
+            static const LONG Special[] = { 0, 1, -1, INT_MAX, INT_MIN, INT_MAX - 1, INT_MIN + 1 };
+            V_I4( &v ) = Next( 4 ) == 0 ? Special[ Next( 7 ) ] : (LONG)Next( 21 ) - 10;
+         }
+         else {
+            static const double Special[] = {
+               0.0, -0.0, 1.0, -1.0,
+               std::numeric_limits<double>::quiet_NaN(),
+               -std::numeric_limits<double>::quiet_NaN(),
+               HUGE_VAL, -HUGE_VAL,
+               std::numeric_limits<double>::denorm_min(),
+               -std::numeric_limits<double>::denorm_min(),
+               (std::numeric_limits<double>::max)(),
+               -(std::numeric_limits<double>::max)(),
+               1e-300 };
+            double d = Next( 3 ) == 0 ? Special[ Next( 13 ) ]
+                                      : std::uniform_real_distribution<double>( -20, 20 )( m_Random );
+            if (vt == VT_R4) {
+               V_R4( &v ) = (float)d;
+            }
+            else {
+               V_R8( &v ) = d;
+            }
+         }
+         return v;
+      }
+
+      VARIANT Near( const VARIANT& Base )
+      {
+         VARIANT v = Base;
+         switch (V_VT( &v )) {
+            case VT_I4:
+               if (V_I4( &v ) > INT_MIN + 2 && V_I4( &v ) < INT_MAX - 2) {
+                  V_I4( &v ) += (LONG)Next( 5 ) - 2;
+               }
+               break;
+            case VT_R4: V_R4( &v ) += (float)Next( 5 ) - 2.0f; break;
+            case VT_R8: V_R8( &v ) += (double)Next( 5 ) - 2.0; break;
+         }
+         return v;
+      }
+
+   private:
+      std::mt19937 m_Random;
+};
+
+
+//=========================================================================
+// Runs all kernels over the elements [dwFirst, dwFirst + dwCount) of the
+// columns and checks the results.
+//=========================================================================
+static void CheckKernels( const char* pszType, const Columns& Col, DWORD dwFirst, DWORD dwCount )
+{
+   DWORD                dwMask = (dwCount + 31) / 32;
+   std::vector<DWORD>   Expected( dwMask + 1, 0 );
+   DWORD                i;
+
+   for (i = 0; i < dwCount; i++) {
+      if (CompareItem( Col.vLast[ dwFirst + i ], Col.vNew[ dwFirst + i ], Col.dThreshold[ dwFirst + i ] )) {
+         DaSetBit( &Expected[0], i );
+      }
+   }
+
+   for (int k = 0; k < gnKernels; k++) {
+      std::vector<DWORD> Changed( dwMask + 1, 0xDEADBEEF );   // guard behind the mask
+
+      gKernels[k].pfnKernel( dwCount, &Col.dLast[ dwFirst ], &Col.dNew[ dwFirst ],
+                             &Col.dThreshold[ dwFirst ], &Changed[0] );
+      glCases++;
+      if (Changed[ dwMask ] != 0xDEADBEEF ||
+          memcmp( &Changed[0], &Expected[0], dwMask * sizeof (DWORD) ) != 0) {
+         if (glFailures++ < 20) {
+            printf( "FAILED: %s kernel, %s, elements %u..%u\n",
+                    gKernels[k].pszName, pszType, dwFirst, dwFirst + dwCount );
+            for (i = 0; i < dwCount; i++) {
+               if (DaIsBitSet( &Changed[0], i ) != DaIsBitSet( &Expected[0], i )) {
+                  printf( "   element %u: last %g new %g threshold %g: expected %d\n",
+                          dwFirst + i, Col.dLast[ dwFirst + i ], Col.dNew[ dwFirst + i ],
+                          Col.dThreshold[ dwFirst + i ], DaIsBitSet( &Expected[0], i ) );
+                  break;
+               }
+            }
+         }
+      }
+   }
+}
+
+
+//=========================================================================
+// Hand-written cases with known results
+//=========================================================================
+static void TestKnownCases()
+{
+   const double NaN = std::numeric_limits<double>::quiet_NaN();
+   static const struct {
+      double   dLast, dNew, dThreshold;
+      BOOL     fChanged;
+   } Cases[] = {
+      { 1.0,      1.0,      -1.0,     FALSE },
+      { 1.0,      2.0,      -1.0,     TRUE },
+      { 0.0,      -0.0,     -1.0,     FALSE },    // +0 and -0 are equal
+      { -0.0,     0.0,      0.0,      FALSE },
+      { NaN,      NaN,      -1.0,     TRUE },     // NaN is never equal
+      { 1.0,      NaN,      -1.0,     TRUE },
+      { NaN,      1.0,      0.0,      FALSE },    // NaN is never outside a deadband
+      { 1.0,      NaN,      HUGE_VAL, FALSE },
+      { 1.0,      1.5,      0.5,      FALSE },    // the deadband is inclusive
+      { 1.0,      1.5,      0.25,     TRUE },
+      { 1.0,      -1.0,     1.0,      TRUE },
+      { HUGE_VAL, HUGE_VAL, -1.0,     FALSE },
+      { HUGE_VAL, HUGE_VAL, 0.0,      FALSE },    // inf - inf is NaN
+      { -HUGE_VAL, 1.0,     1e300,    TRUE },
+      { 5.0,      1e300,    HUGE_VAL, FALSE },    // 100% deadband
+   };
+   const DWORD dwCases = sizeof (Cases) / sizeof (Cases[0]);
+
+   double   dLast[ dwCases ], dNew[ dwCases ], dThreshold[ dwCases ];
+   DWORD    i;
+
+   for (i = 0; i < dwCases; i++) {
+      dLast[i] = Cases[i].dLast;
+      dNew[i] = Cases[i].dNew;
+      dThreshold[i] = Cases[i].dThreshold;
+   }
+   for (int k = 0; k < gnKernels; k++) {
+      DWORD dwChanged = 0;
+      gKernels[k].pfnKernel( dwCases, dLast, dNew, dThreshold, &dwChanged );
+      for (i = 0; i < dwCases; i++) {
+         glCases++;
+         if (DaIsBitSet( &dwChanged, i ) != Cases[i].fChanged) {
+            if (glFailures++ < 20) {
+               printf( "FAILED: %s kernel, case %u: last %g new %g threshold %g: expected %d\n",
+                       gKernels[k].pszName, i, Cases[i].dLast, Cases[i].dNew,
+                       Cases[i].dThreshold, Cases[i].fChanged );
+            }
+         }
+      }
+   }
+}
+
+
+//=========================================================================
+// Random columns of each data type. The kernels are run over all short
+// lengths and start positions to check the remaining elements which
+// are handled by the scalar code, and over the whole column.
+//=========================================================================
+static void TestRandomColumns()
+{
+   static const VARTYPE aVT[] = { VT_R8, VT_R4, VT_I4 };
+   static const char*   apszVT[] = { "VT_R8", "VT_R4", "VT_I4" };
+   const DWORD          dwItems = 10007;    // not a multiple of the vector size
+
+   ValueGenerator Gen;
+
+   for (int t = 0; t < 3; t++) {
+      Columns Col;
+      for (DWORD i = 0; i < dwItems; i++) {
+         VARIANT Last = Gen.Value( aVT[t] );
+         VARIANT New = Gen.Next( 2 ) ? Gen.Near( Last ) : Gen.Value( aVT[t] );
+         Col.Add( Last, New, Gen.Threshold() );
+      }
+      for (DWORD dwCount = 0; dwCount <= 70; dwCount++) {
+         for (DWORD dwFirst = 0; dwFirst < 4; dwFirst++) {
+            CheckKernels( apszVT[t], Col, dwFirst, dwCount );
+         }
+      }
+      CheckKernels( apszVT[t], Col, 0, dwItems );
+      CheckKernels( apszVT[t], Col, 3, dwItems - 3 );
+   }
+}
+
+
+//=========================================================================
+// Benchmark
+// ---------
+//    Change detection of 100000 items of mixed data types, 10% of the
+//    values changed:
+//       per-item : CompareItem() for each item as done by
+//                  DaGenericItem::CompareLastRead()
+//       batch    : gather the values into the double columns and run
+//                  the kernel as done by DaChangeColumns::Compare()
+//       kernel   : only the kernel
+//=========================================================================
+static double NowNs( void )
+{
+   return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static void Benchmark()
+{
+   static const VARTYPE aVT[] = { VT_R8, VT_R4, VT_I4 };
+   const DWORD          dwItems = 100000;
+   const int            nRounds = 200;
+
+   ValueGenerator       Gen;
+   Columns              Col;
+   std::vector<DWORD>   Changed( (dwItems + 31) / 32 );
+   std::vector<double>  dNew( dwItems );
+   DWORD                i, dwSum = 0;
+   int                  r;
+
+   for (i = 0; i < dwItems; i++) {
+      VARIANT Last;
+      VariantInit( &Last );
+      V_VT( &Last ) = aVT[ i % 3 ];
+      switch (V_VT( &Last )) {
+         case VT_R8: V_R8( &Last ) = (double)Gen.Next( 1000 ); break;
+         case VT_R4: V_R4( &Last ) = (float)Gen.Next( 1000 ); break;
+         case VT_I4: V_I4( &Last ) = (LONG)Gen.Next( 1000 ); break;
+      }
+      VARIANT New = Gen.Next( 10 ) == 0 ? Gen.Near( Last ) : Last;
+      Col.Add( Last, New, Gen.Next( 2 ) ? -1.0 : 1.0 );
+   }
+
+   double dStart = NowNs();
+   for (r = 0; r < nRounds; r++) {
+      for (i = 0; i < dwItems; i++) {
+         dwSum += CompareItem( Col.vLast[i], Col.vNew[i], Col.dThreshold[i] );
+      }
+   }
+   double dPerItem = (NowNs() - dStart) / ((double)nRounds * dwItems);
+
+   dStart = NowNs();
+   for (r = 0; r < nRounds; r++) {
+      for (i = 0; i < dwItems; i++) {
+         dNew[i] = Columns::ToDouble( Col.vNew[i] );
+      }
+      DaDetectChanges( dwItems, &Col.dLast[0], &dNew[0], &Col.dThreshold[0], &Changed[0] );
+      dwSum += Changed[0];
+   }
+   double dBatch = (NowNs() - dStart) / ((double)nRounds * dwItems);
+
+   printf( "%u items, %d rounds (checksum %u)\n", dwItems, nRounds, dwSum );
+   printf( "   %-22s %6.2f ns/item\n", "per-item compare", dPerItem );
+   printf( "   %-22s %6.2f ns/item\n", "gather + batch kernel", dBatch );
+
+   for (int k = 0; k < gnKernels; k++) {
+      dStart = NowNs();
+      for (r = 0; r < nRounds; r++) {
+         gKernels[k].pfnKernel( dwItems, &Col.dLast[0], &Col.dNew[0], &Col.dThreshold[0], &Changed[0] );
+      }
+      printf( "   %-22s %6.2f ns/item\n",
+              (std::string( gKernels[k].pszName ) + " kernel only").c_str(),
+              (NowNs() - dStart) / ((double)nRounds * dwItems) );
+   }
+}
+
+
+int main( int argc, char* argv[] )
+{
+#ifdef DA_CHANGEKERNELS_SIMD
+   if (!DaIsAVXSupported()) {
+      printf( "AVX not supported, the AVX kernel is not tested\n" );
+      // the AVX kernel is always the third entry
+      gKernels[2].pfnKernel = DaDetectChangesSSE2;
+   }
+#endif
+
+   if (IsBenchmark( argc, argv )) {
+      Benchmark();
+      return 0;
+   }
+
+   TestKnownCases();
+   TestRandomColumns();
+
+   return TestResult();
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the clock: OpcClockCoarse() with and without the ticker
+// thread, OpcClockPrecise() and OpcClockToLocalTime(). The time cached
+// by the ticker must never go back and must not lag by more than the
+// interval of the ticker and the scheduling delay.
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the time per call of OpcClockCoarse()
+// with and without the ticker and of OpcClockPrecise() is measured
+// with 1 - 8 threads reading the clock.
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include "OpcClock.h"
+
+static LONGLONG Ticks( const FILETIME& ft )
+{
+   return ((LONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+                  // Allowed scheduling delay of the ticker thread (100 ns)
+#define SCHEDULING_DELAY   (200 * 10000)
+
+
+//=========================================================================
+// Without the ticker
+//=========================================================================
+static void TestSystemTime()
+{
+   FILETIME ftCoarse, ftPrecise;
+
+   Check( gllOpcClockCached == 0, "no cached time without the ticker" );
+   OpcClockPrecise( &ftPrecise );
+   OpcClockCoarse( &ftCoarse );
+   Check( Ticks( ftCoarse ) > 0, "OpcClockCoarse" );
+   Check( llabs( Ticks( ftCoarse ) - Ticks( ftPrecise ) ) < SCHEDULING_DELAY,
+          "OpcClockCoarse and OpcClockPrecise return the same time" );
+}
+
+
+//=========================================================================
+// Ticker
+//=========================================================================
+static void TestTicker()
+{
+   const DWORD dwInterval = 1;
+   FILETIME    ft, ftPrecise;
+   LONGLONG    llLast = 0;
+   BOOL        fMonotonic = TRUE, fLag = TRUE;
+   DWORD       dwChanges = 0;
+
+   Check( OpcClockStartTicker( dwInterval ) == S_OK, "OpcClockStartTicker" );
+   Check( OpcClockStartTicker( dwInterval ) == S_FALSE, "OpcClockStartTicker if already running" );
+   Check( gllOpcClockCached != 0, "cached time is valid when the ticker is started" );
+
+   ULONGLONG ullEnd = GetTickCount64() + 200;
+   while (GetTickCount64() < ullEnd) {
+      OpcClockCoarse( &ft );
+      OpcClockPrecise( &ftPrecise );
+      if (Ticks( ft ) < llLast) {
+         fMonotonic = FALSE;
+      }
+      if (Ticks( ftPrecise ) - Ticks( ft ) > dwInterval * 10000 + SCHEDULING_DELAY) {
+         fLag = FALSE;
+      }
+      if (Ticks( ft ) != llLast) {
+         dwChanges++;
+      }
+      llLast = Ticks( ft );
+   }
+   Check( fMonotonic, "cached time never goes back" );
+   Check( fLag, "cached time lags by at most the interval" );
+   Check( dwChanges > 10, "cached time is updated by the ticker" );
+
+   OpcClockStopTicker();
+   Check( gllOpcClockCached == 0, "OpcClockStopTicker clears the cached time" );
+   OpcClockStopTicker();                        // not running
+   OpcClockCoarse( &ft );
+   OpcClockPrecise( &ftPrecise );
+   Check( llabs( Ticks( ft ) - Ticks( ftPrecise ) ) < SCHEDULING_DELAY,
+          "OpcClockCoarse reads the system time after the ticker is stopped" );
+
+   Check( OpcClockStartTicker( dwInterval ) == S_OK, "OpcClockStartTicker after stop" );
+   OpcClockStopTicker();
+}
+
+
+//=========================================================================
+// Local time conversion
+//=========================================================================
+static void TestLocalTime()
+{
+   FILETIME    ft;
+   struct tm   tmClock, tmExpected;
+   unsigned    uMilliseconds;
+
+   OpcClockPrecise( &ft );
+   OpcClockToLocalTime( &ft, &tmClock, &uMilliseconds );
+   time_t t = (time_t)((Ticks( ft ) - 116444736000000000LL) / 10000000);
+   localtime_s( &tmExpected, &t );
+   Check( tmClock.tm_sec == tmExpected.tm_sec && tmClock.tm_min == tmExpected.tm_min &&
+          tmClock.tm_hour == tmExpected.tm_hour && tmClock.tm_mday == tmExpected.tm_mday,
+          "OpcClockToLocalTime" );
+   Check( uMilliseconds == (unsigned)((Ticks( ft ) / 10000) % 1000), "OpcClockToLocalTime milliseconds" );
+
+   ft.dwLowDateTime += 10000;                   // same second, cached conversion
+   OpcClockToLocalTime( &ft, &tmClock, &uMilliseconds );
+   Check( tmClock.tm_hour == tmExpected.tm_hour, "OpcClockToLocalTime with the cached second" );
+}
+
+
+//=========================================================================
+// Benchmark
+// ---------
+//    Time per call with 1 - 8 threads reading the clock of
+//       system time : OpcClockCoarse() without the ticker, as before
+//       ticker      : OpcClockCoarse() reading the cached time
+//       precise     : OpcClockPrecise()
+//=========================================================================
+static void BenchmarkReader( int nClock, std::atomic<bool>* pfStop, std::atomic<ULONGLONG>* pullCalls )
+{
+   FILETIME    ft;
+   LONGLONG    llSum = 0;
+   ULONGLONG   ullCalls = 0;
+
+   while (!*pfStop) {
+      for (int i = 0; i < 1000; i++) {
+         if (nClock == 2) {
+            OpcClockPrecise( &ft );
+         }
+         else {
+            OpcClockCoarse( &ft );
+         }
+         llSum += ft.dwLowDateTime;
+      }
+      ullCalls += 1000;
+   }
+   *pullCalls += ullCalls + (llSum == 1);       // llSum keeps the calls
+}
+
+static void Benchmark()
+{
+   const double   dDuration = 0.5;
+
+   printf( "threads   ns per call:  system time   ticker   precise\n" );
+   for (DWORD dwThreads = 1; dwThreads <= 8; dwThreads *= 2) {
+      double adNs[3];
+      for (int nClock = 0; nClock < 3; nClock++) {
+         std::vector<std::thread>   Threads;
+         std::atomic<bool>          fStop( false );
+         std::atomic<ULONGLONG>     ullCalls( 0 );
+
+         if (nClock == 1) {
+            OpcClockStartTicker();
+         }
+         double dStart = NowSeconds();
+         for (DWORD i = 0; i < dwThreads; i++) {
+            Threads.push_back( std::thread( BenchmarkReader, nClock, &fStop, &ullCalls ) );
+         }
+         Sleep( (DWORD)(dDuration * 1000) );
+         fStop = true;
+         for (DWORD i = 0; i < dwThreads; i++) {
+            Threads[i].join();
+         }
+         double dSeconds = NowSeconds() - dStart;
+         if (nClock == 1) {
+            OpcClockStopTicker();
+         }
+                                                // per thread and call
+         adNs[nClock] = dSeconds * dwThreads * 1e9 / ullCalls;
+      }
+      printf( "%7u   %24.1f %8.1f %9.1f\n", dwThreads, adNs[0], adNs[1], adNs[2] );
+   }
+}
+
+
+int main( int argc, char* argv[] )
+{
+   if (IsBenchmark( argc, argv )) {
+      Benchmark();
+      return 0;
+   }
+
+   TestSystemTime();
+   TestTicker();
+   TestLocalTime();
+
+   return TestResult();
+}
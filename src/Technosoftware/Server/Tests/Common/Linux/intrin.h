@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of the Visual C++ header intrin.h for GCC and Clang. Only
+// the functions used by the tested classes are provided.
+//-------------------------------------------------------------------------
+
+#ifndef __Tests_intrin_H
+#define __Tests_intrin_H
+
+#include <cpuid.h>
+#include <x86intrin.h>
+
+#undef __cpuid
+
+inline void __cpuid( int CPUInfo[4], int InfoType )
+{
+   unsigned int a, b, c, d;
+   __cpuid_count( InfoType, 0, a, b, c, d );
+   CPUInfo[0] = (int)a;
+   CPUInfo[1] = (int)b;
+   CPUInfo[2] = (int)c;
+   CPUInfo[3] = (int)d;
+}
+
+                  // _xgetbv() of x86intrin.h requires -mxsave
+inline unsigned long long TestXGetBV( unsigned int uIndex )
+{
+   unsigned int uLow, uHigh;
+   __asm__ __volatile__ ( "xgetbv" : "=a" (uLow), "=d" (uHigh) : "c" (uIndex) );
+   return ((unsigned long long)uHigh << 32) | uLow;
+}
+#define _xgetbv( i )       TestXGetBV( i )
+
+#endif // __Tests_intrin_H
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Harness of the unit tests: the case and failure counters, Check(), the
+// benchmark clock and the command line.
+//
+// A test executable includes this header in its test source only. The
+// first 20 failures are printed, main() returns TestResult().
+//-------------------------------------------------------------------------
+
+#ifndef __Tests_TestUtil_H
+#define __Tests_TestUtil_H
+
+static long glCases = 0;
+static long glFailures = 0;
+
+//=========================================================================
+// Check
+// -----
+//    Counts a case and prints it if the condition is not met.
+//=========================================================================
+static inline void Check( BOOL fCondition, const char* pszCase )
+{
+   glCases++;
+   if (!fCondition && glFailures++ < 20) {
+      printf( "FAILED: %s\n", pszCase );
+   }
+}
+
+//=========================================================================
+// NowSeconds
+// ----------
+//    Monotonic time in seconds for the benchmarks.
+//=========================================================================
+static inline double NowSeconds( void )
+{
+   return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//=========================================================================
+// IsBenchmark
+// -----------
+//    TRUE if the test is started with the argument --benchmark. The
+//    benchmark then runs instead of the test.
+//=========================================================================
+static inline BOOL IsBenchmark( int argc, char* argv[] )
+{
+   return argc > 1 && strcmp( argv[1], "--benchmark" ) == 0;
+}
+
+//=========================================================================
+// TestResult
+// ----------
+//    Prints the number of cases and failures and returns the exit code
+//    of the test.
+//=========================================================================
+static inline int TestResult( void )
+{
+   printf( "%ld cases, %ld failed\n", glCases, glFailures );
+   return glFailures ? 1 : 0;
+}
+
+#endif // __Tests_TestUtil_H
@@ -0,0 +1,715 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Precompiled header replacement of the unit tests. Provides the Windows
+// types and functions used by the server classes under test so that the
+// tests also build on other platforms. Only the subset used by the tested
+// classes is implemented.
+//
+// This header is force-included into the tested source files and defines
+// the include guard of Core/stdafx.h, which requires ATL.
+//-------------------------------------------------------------------------
+
+#ifndef __Tests_stdafx_H
+#define __Tests_stdafx_H
+
+#define AFX_STDAFX_H__5F66E434_FC32_11D0_A25F_0000E81E9085__INCLUDED_
+
+#include <assert.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <wctype.h>
+
+                  // The standard headers must be included before the
+                  // min() and max() macros are defined.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+
+#define NOMINMAX
+#include <windows.h>
+#include <oleauto.h>
+#include <process.h>
+#include <crtdbg.h>
+#undef NOMINMAX
+
+#else
+
+//-------------------------------------------------------------------------
+// Types
+//-------------------------------------------------------------------------
+typedef int                BOOL;
+typedef unsigned char      BYTE;
+typedef BYTE*              LPBYTE;
+typedef unsigned short     WORD;
+typedef WORD*              LPWORD;
+typedef unsigned int       DWORD;
+typedef DWORD*             LPDWORD;
+typedef int                LONG;
+typedef unsigned int       ULONG;
+typedef int                INT;
+typedef unsigned int       UINT;
+typedef short              SHORT;
+typedef unsigned short     USHORT;
+typedef char               CHAR;
+typedef long long          LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef unsigned long long DWORD_PTR;
+typedef unsigned long long ULONG_PTR;
+typedef float              FLOAT;
+typedef double             DOUBLE;
+typedef wchar_t            WCHAR;
+typedef WCHAR*             LPWSTR;
+typedef const WCHAR*       LPCWSTR;
+typedef char*              LPSTR;
+typedef const char*        LPCSTR;
+typedef void*              LPVOID;
+typedef void               VOID;
+typedef int                HRESULT;
+typedef int                SCODE;
+typedef void*              HANDLE;
+typedef void*              HMODULE;
+typedef void               (*FARPROC)( void );
+typedef WCHAR*             BSTR;
+typedef unsigned short     VARTYPE;
+typedef short              VARIANT_BOOL;
+typedef double             DATE;
+
+                  // LONG has 32 bits as on Windows
+#undef  LONG_MAX
+#define LONG_MAX     2147483647L
+#undef  LONG_MIN
+#define LONG_MIN     (-LONG_MAX - 1)
+
+typedef union tagCY {
+   struct { unsigned int Lo; int Hi; };
+   LONGLONG int64;
+} CY;
+
+typedef struct _FILETIME {
+   DWORD dwLowDateTime;
+   DWORD dwHighDateTime;
+} FILETIME, *LPFILETIME;
+
+typedef union _ULARGE_INTEGER {
+   struct { DWORD LowPart; DWORD HighPart; };
+   struct { DWORD LowPart; DWORD HighPart; } u;
+   ULONGLONG QuadPart;
+} ULARGE_INTEGER;
+
+typedef union _LARGE_INTEGER {
+   struct { DWORD LowPart; LONG HighPart; };
+   struct { DWORD LowPart; LONG HighPart; } u;
+   LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef struct tagSAFEARRAYBOUND {
+   ULONG cElements;
+   LONG  lLbound;
+} SAFEARRAYBOUND;
+
+typedef struct tagSAFEARRAY {
+   USHORT         cDims;
+   USHORT         fFeatures;
+   ULONG          cbElements;
+   ULONG          cLocks;
+   void*          pvData;
+   SAFEARRAYBOUND rgsabound[1];
+} SAFEARRAY;
+
+typedef struct tagVARIANT {
+   VARTYPE  vt;
+   WORD     wReserved1;
+   WORD     wReserved2;
+   WORD     wReserved3;
+   union {
+      LONGLONG       llVal;
+      ULONGLONG      ullVal;
+      LONG           lVal;
+      ULONG          ulVal;
+      INT            intVal;
+      UINT           uintVal;
+      BYTE           bVal;
+      CHAR           cVal;
+      SHORT          iVal;
+      USHORT         uiVal;
+      FLOAT          fltVal;
+      DOUBLE         dblVal;
+      VARIANT_BOOL   boolVal;
+      SCODE          scode;
+      CY             cyVal;
+      DATE           date;
+      BSTR           bstrVal;
+      SAFEARRAY*     parray;
+      void*          byref;
+   };
+} VARIANT, *LPVARIANT;
+
+#define V_VT( X )          ((X)->vt)
+#define V_ISARRAY( X )     (V_VT( X ) & VT_ARRAY)
+#define V_ISBYREF( X )     (V_VT( X ) & VT_BYREF)
+#define V_I1( X )          ((X)->cVal)
+#define V_UI1( X )         ((X)->bVal)
+#define V_I2( X )          ((X)->iVal)
+#define V_UI2( X )         ((X)->uiVal)
+#define V_I4( X )          ((X)->lVal)
+#define V_UI4( X )         ((X)->ulVal)
+#define V_I8( X )          ((X)->llVal)
+#define V_UI8( X )         ((X)->ullVal)
+#define V_R4( X )          ((X)->fltVal)
+#define V_R8( X )          ((X)->dblVal)
+#define V_BOOL( X )        ((X)->boolVal)
+#define V_BSTR( X )        ((X)->bstrVal)
+#define V_DATE( X )        ((X)->date)
+#define V_ARRAY( X )       ((X)->parray)
+
+enum {
+   VT_EMPTY = 0, VT_NULL = 1, VT_I2 = 2, VT_I4 = 3, VT_R4 = 4, VT_R8 = 5,
+   VT_CY = 6, VT_DATE = 7, VT_BSTR = 8, VT_DISPATCH = 9, VT_ERROR = 10,
+   VT_BOOL = 11, VT_VARIANT = 12, VT_UNKNOWN = 13, VT_DECIMAL = 14,
+   VT_I1 = 16, VT_UI1 = 17, VT_UI2 = 18, VT_UI4 = 19, VT_I8 = 20,
+   VT_UI8 = 21, VT_INT = 22, VT_UINT = 23, VT_ARRAY = 0x2000, VT_BYREF = 0x4000
+};
+
+typedef struct _SYSTEM_INFO {
+   DWORD dwNumberOfProcessors;
+} SYSTEM_INFO;
+
+struct IMalloc {
+   virtual void* Alloc( size_t cb ) = 0;
+   virtual void  Free( void* pv ) = 0;
+};
+
+
+//-------------------------------------------------------------------------
+// Constants and macros
+//-------------------------------------------------------------------------
+#define TRUE               1
+#define FALSE              0
+#define VARIANT_TRUE       ((VARIANT_BOOL)-1)
+#define VARIANT_FALSE      ((VARIANT_BOOL)0)
+
+#define S_OK               ((HRESULT)0L)
+#define S_FALSE            ((HRESULT)1L)
+#define E_FAIL             ((HRESULT)0x80004005L)
+#define E_NOTIMPL          ((HRESULT)0x80004001L)
+#define E_POINTER          ((HRESULT)0x80004003L)
+#define E_OUTOFMEMORY      ((HRESULT)0x8007000EL)
+#define E_INVALIDARG       ((HRESULT)0x80070057L)
+#define DISP_E_TYPEMISMATCH ((HRESULT)0x80020005L)
+#define DISP_E_OVERFLOW    ((HRESULT)0x8002000AL)
+#define FAILED( hr )       (((HRESULT)(hr)) < 0)
+#define SUCCEEDED( hr )    (((HRESULT)(hr)) >= 0)
+#define HRESULT_FROM_WIN32( x ) ((HRESULT)(x) <= 0 ? (HRESULT)(x) : (HRESULT)(((x) & 0x0000FFFF) | 0x80070000))
+
+#define INFINITE           0xFFFFFFFF
+#define WAIT_OBJECT_0      0
+#define WAIT_TIMEOUT       258
+#define WAIT_FAILED        0xFFFFFFFF
+#define TLS_OUT_OF_INDEXES 0xFFFFFFFF
+
+#define WINAPI
+#define __stdcall
+#define __forceinline      inline __attribute__((always_inline))
+#define __declspec( x )    __declspec_##x
+#define __declspec_thread  thread_local
+
+#define _ASSERTE( expr )   assert( expr )
+#define _isnan( x )        std::isnan( x )
+
+inline DWORD GetLastError( void ) { return 8; }    // ERROR_NOT_ENOUGH_MEMORY
+
+inline int wcscpy_s( WCHAR* pDest, size_t nSize, const WCHAR* pSrc )
+{
+   if (wcslen( pSrc ) >= nSize) abort();
+   wcscpy( pDest, pSrc );
+   return 0;
+}
+
+inline WCHAR* wcstok_s( WCHAR* pStr, const WCHAR* pDelim, WCHAR** ppContext )
+{
+   return wcstok( pStr, pDelim, ppContext );
+}
+
+inline int wcscat_s( WCHAR* pDest, size_t nSize, const WCHAR* pSrc )
+{
+   if (wcslen( pDest ) + wcslen( pSrc ) >= nSize) abort();
+   wcscat( pDest, pSrc );
+   return 0;
+}
+
+template <size_t N>
+inline int swprintf_s( WCHAR (&szDest)[N], const WCHAR* pszFormat, ... )
+{
+   va_list args;
+   va_start( args, pszFormat );
+   int iLen = vswprintf( szDest, N, pszFormat, args );
+   va_end( args );
+   if (iLen < 0) abort();
+   return iLen;
+}
+
+
+//-------------------------------------------------------------------------
+// Interlocked functions (full barriers like the Windows functions)
+//-------------------------------------------------------------------------
+inline LONG InterlockedIncrement( volatile LONG* p )                 { return __sync_add_and_fetch( p, 1 ); }
+inline LONG InterlockedDecrement( volatile LONG* p )                 { return __sync_sub_and_fetch( p, 1 ); }
+inline LONG InterlockedExchangeAdd( volatile LONG* p, LONG l )       { return __sync_fetch_and_add( p, l ); }
+inline LONG InterlockedExchange( volatile LONG* p, LONG l )          { __sync_synchronize(); return __sync_lock_test_and_set( p, l ); }
+inline LONG InterlockedCompareExchange( volatile LONG* p, LONG lNew, LONG lComp ) { return __sync_val_compare_and_swap( p, lComp, lNew ); }
+                  // Some classes use long, which differs from LONG on this platform
+inline long InterlockedIncrement( volatile long* p )                 { return __sync_add_and_fetch( p, 1 ); }
+inline long InterlockedDecrement( volatile long* p )                 { return __sync_sub_and_fetch( p, 1 ); }
+inline LONGLONG InterlockedIncrement64( volatile LONGLONG* p )       { return __sync_add_and_fetch( p, 1 ); }
+inline LONGLONG InterlockedDecrement64( volatile LONGLONG* p )       { return __sync_sub_and_fetch( p, 1 ); }
+inline LONGLONG InterlockedExchangeAdd64( volatile LONGLONG* p, LONGLONG ll ) { return __sync_fetch_and_add( p, ll ); }
+inline LONGLONG InterlockedAdd64( volatile LONGLONG* p, LONGLONG ll )      { return __sync_add_and_fetch( p, ll ); }
+inline LONGLONG InterlockedExchange64( volatile LONGLONG* p, LONGLONG ll ) { __sync_synchronize(); return __sync_lock_test_and_set( p, ll ); }
+inline LONGLONG InterlockedCompareExchange64( volatile LONGLONG* p, LONGLONG llNew, LONGLONG llComp ) { return __sync_val_compare_and_swap( p, llComp, llNew ); }
+template <class T>
+inline T* InterlockedCompareExchangePointer( T* volatile* p, T* pNew, T* pComp ) { return __sync_val_compare_and_swap( p, pComp, pNew ); }
+
+inline void YieldProcessor( void ) { __builtin_ia32_pause(); }
+inline void MemoryBarrier( void ) { __sync_synchronize(); }
+
+
+//-------------------------------------------------------------------------
+// Critical sections (recursive like the Windows critical sections)
+//-------------------------------------------------------------------------
+typedef std::recursive_mutex CRITICAL_SECTION;
+typedef CRITICAL_SECTION*    LPCRITICAL_SECTION;
+
+#define CRITICAL_SECTION_NO_DEBUG_INFO 0x01000000
+
+inline void InitializeCriticalSection( CRITICAL_SECTION* ) {}
+inline BOOL InitializeCriticalSectionAndSpinCount( CRITICAL_SECTION*, DWORD ) { return TRUE; }
+inline BOOL InitializeCriticalSectionEx( CRITICAL_SECTION*, DWORD, DWORD ) { return TRUE; }
+inline void DeleteCriticalSection( CRITICAL_SECTION* ) {}
+inline void EnterCriticalSection( CRITICAL_SECTION* pcs ) { pcs->lock(); }
+inline void LeaveCriticalSection( CRITICAL_SECTION* pcs ) { pcs->unlock(); }
+inline BOOL TryEnterCriticalSection( CRITICAL_SECTION* pcs ) { return pcs->try_lock() ? TRUE : FALSE; }
+
+
+//-------------------------------------------------------------------------
+// Time
+//-------------------------------------------------------------------------
+inline void Sleep( DWORD dwMilliseconds ) { std::this_thread::sleep_for( std::chrono::milliseconds( dwMilliseconds ) ); }
+inline BOOL SwitchToThread( void ) { std::this_thread::yield(); return TRUE; }
+
+inline ULONGLONG GetTickCount64( void )
+{
+   return (ULONGLONG)std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+inline DWORD GetTickCount( void ) { return (DWORD)GetTickCount64(); }
+
+inline BOOL QueryPerformanceFrequency( LARGE_INTEGER* pFrequency ) { pFrequency->QuadPart = 1000000000LL; return TRUE; }
+inline BOOL QueryPerformanceCounter( LARGE_INTEGER* pCounter )
+{
+   pCounter->QuadPart = (LONGLONG)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch() ).count();
+   return TRUE;
+}
+
+                  // 100 ns intervals since January 1, 1601
+inline void GetSystemTimePreciseAsFileTime( LPFILETIME pft )
+{
+   ULARGE_INTEGER t;
+   t.QuadPart = (ULONGLONG)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch() ).count() / 100
+                + 116444736000000000ULL;
+   pft->dwLowDateTime = t.LowPart;
+   pft->dwHighDateTime = t.HighPart;
+}
+                  // Like on Windows only the time of the last clock tick
+inline void GetSystemTimeAsFileTime( LPFILETIME pft )
+{
+   struct timespec ts;
+   clock_gettime( CLOCK_REALTIME_COARSE, &ts );
+   ULARGE_INTEGER t;
+   t.QuadPart = (ULONGLONG)ts.tv_sec * 10000000 + ts.tv_nsec / 100 + 116444736000000000ULL;
+   pft->dwLowDateTime = t.LowPart;
+   pft->dwHighDateTime = t.HighPart;
+}
+
+inline int localtime_s( struct tm* ptm, const time_t* pt ) { return localtime_r( pt, ptm ) ? 0 : 1; }
+
+inline LONG CompareFileTime( const FILETIME* pft1, const FILETIME* pft2 )
+{
+   ULONGLONG t1 = ((ULONGLONG)pft1->dwHighDateTime << 32) | pft1->dwLowDateTime;
+   ULONGLONG t2 = ((ULONGLONG)pft2->dwHighDateTime << 32) | pft2->dwLowDateTime;
+   return (t1 < t2) ? -1 : (t1 > t2) ? 1 : 0;
+}
+
+
+//-------------------------------------------------------------------------
+// Kernel objects: semaphores, events, mutexes and threads
+//-------------------------------------------------------------------------
+struct TestKernelObject {
+   std::mutex                 Mutex;
+   std::condition_variable    Signal;
+   virtual ~TestKernelObject() {}
+   virtual BOOL IsSignaled( void ) = 0;      // called with Mutex owned
+   virtual void Acquire( void ) {}           // called with Mutex owned
+   virtual void Close( void ) { delete this; }
+};
+
+struct TestSemaphore : TestKernelObject {
+   LONG lCount, lMax;
+   BOOL IsSignaled( void ) { return lCount > 0; }
+   void Acquire( void ) { lCount--; }
+};
+
+struct TestEvent : TestKernelObject {
+   BOOL fSignaled, fManualReset;
+   BOOL IsSignaled( void ) { return fSignaled; }
+   void Acquire( void ) { if (!fManualReset) fSignaled = FALSE; }
+};
+
+struct TestMutex : TestKernelObject {
+   std::thread::id   Owner;
+   LONG              lRecursion;
+   BOOL IsSignaled( void ) { return lRecursion == 0 || Owner == std::this_thread::get_id(); }
+   void Acquire( void ) { Owner = std::this_thread::get_id(); lRecursion++; }
+};
+
+                  // Like on Windows a thread continues if its handle is
+                  // closed, the thread then deletes the object at its end.
+struct TestThread : TestKernelObject {
+   std::thread Thread;
+   BOOL        fExited;
+   BOOL        fClosed;
+   BOOL IsSignaled( void ) { return fExited; }
+   void Close( void )
+   {
+      std::unique_lock<std::mutex> Lock( Mutex );
+      if (fExited) {
+         Lock.unlock();
+         delete this;
+         return;
+      }
+      fClosed = TRUE;
+      Thread.detach();
+   }
+   ~TestThread() { if (Thread.joinable()) Thread.join(); }
+};
+
+inline HANDLE CreateSemaphore( void*, LONG lInitialCount, LONG lMaximumCount, LPCWSTR )
+{
+   TestSemaphore* p = new TestSemaphore;
+   p->lCount = lInitialCount;
+   p->lMax = lMaximumCount;
+   return static_cast<TestKernelObject*>( p );
+}
+
+inline BOOL ReleaseSemaphore( HANDLE h, LONG lReleaseCount, LONG* plPreviousCount )
+{
+   TestSemaphore* p = static_cast<TestSemaphore*>( static_cast<TestKernelObject*>( h ) );
+   std::lock_guard<std::mutex> Lock( p->Mutex );
+   if (plPreviousCount) {
+      *plPreviousCount = p->lCount;
+   }
+   p->lCount = (LONG)std::min( (LONGLONG)p->lCount + lReleaseCount, (LONGLONG)p->lMax );
+   p->Signal.notify_all();
+   return TRUE;
+}
+
+inline HANDLE CreateEvent( void*, BOOL fManualReset, BOOL fInitialState, LPCWSTR )
+{
+   TestEvent* p = new TestEvent;
+   p->fManualReset = fManualReset;
+   p->fSignaled = fInitialState;
+   return static_cast<TestKernelObject*>( p );
+}
+
+inline HANDLE CreateMutex( void*, BOOL fInitialOwner, LPCWSTR )
+{
+   TestMutex* p = new TestMutex;
+   p->lRecursion = 0;
+   if (fInitialOwner) {
+      p->Acquire();
+   }
+   return static_cast<TestKernelObject*>( p );
+}
+
+inline BOOL ReleaseMutex( HANDLE h )
+{
+   TestMutex* p = static_cast<TestMutex*>( static_cast<TestKernelObject*>( h ) );
+   std::lock_guard<std::mutex> Lock( p->Mutex );
+   if (p->lRecursion == 0 || p->Owner != std::this_thread::get_id()) {
+      return FALSE;
+   }
+   if (--p->lRecursion == 0) {
+      p->Owner = std::thread::id();
+      p->Signal.notify_all();
+   }
+   return TRUE;
+}
+
+inline BOOL SetEvent( HANDLE h )
+{
+   TestEvent* p = static_cast<TestEvent*>( static_cast<TestKernelObject*>( h ) );
+   std::lock_guard<std::mutex> Lock( p->Mutex );
+   p->fSignaled = TRUE;
+   p->Signal.notify_all();
+   return TRUE;
+}
+
+inline BOOL ResetEvent( HANDLE h )
+{
+   TestEvent* p = static_cast<TestEvent*>( static_cast<TestKernelObject*>( h ) );
+   std::lock_guard<std::mutex> Lock( p->Mutex );
+   p->fSignaled = FALSE;
+   return TRUE;
+}
+
+inline DWORD WaitForSingleObject( HANDLE h, DWORD dwMilliseconds )
+{
+   TestKernelObject* p = static_cast<TestKernelObject*>( h );
+   std::unique_lock<std::mutex> Lock( p->Mutex );
+   if (dwMilliseconds == INFINITE) {
+      p->Signal.wait( Lock, [p] { return p->IsSignaled() != FALSE; } );
+   }
+   else if (!p->Signal.wait_for( Lock, std::chrono::milliseconds( dwMilliseconds ),
+                                 [p] { return p->IsSignaled() != FALSE; } )) {
+      return WAIT_TIMEOUT;
+   }
+   p->Acquire();
+   return WAIT_OBJECT_0;
+}
+
+inline BOOL CloseHandle( HANDLE h )
+{
+   static_cast<TestKernelObject*>( h )->Close();
+   return TRUE;
+}
+
+inline uintptr_t _beginthreadex( void*, unsigned, unsigned (*pfnStart)( void* ), void* pArg,
+                                 unsigned, unsigned* puThreadId )
+{
+   TestThread* p = new TestThread;
+   p->fExited = FALSE;
+   p->fClosed = FALSE;
+   std::lock_guard<std::mutex> Start( p->Mutex );   // Close() after Thread is set
+   p->Thread = std::thread( [p, pfnStart, pArg] {
+      pfnStart( pArg );
+      std::unique_lock<std::mutex> Lock( p->Mutex );
+      p->fExited = TRUE;
+      if (p->fClosed) {
+         Lock.unlock();
+         delete p;
+         return;
+      }
+      p->Signal.notify_all();
+   } );
+   if (puThreadId) {
+      *puThreadId = (unsigned)std::hash<std::thread::id>()( p->Thread.get_id() );
+   }
+   return (uintptr_t)static_cast<TestKernelObject*>( p );
+}
+
+                  // The thread procedures of the server return after
+                  // _endthreadex(), which ends the thread.
+inline void _endthreadex( unsigned ) {}
+
+inline BOOL TerminateThread( HANDLE, DWORD )
+{
+   fprintf( stderr, "TerminateThread() is not supported by the tests\n" );
+   abort();
+}
+
+inline void GetSystemInfo( SYSTEM_INFO* pSysInfo )
+{
+   pSysInfo->dwNumberOfProcessors = std::max( std::thread::hardware_concurrency(), 1u );
+}
+
+                  // Only the functions of the kernel used by the tested
+                  // classes are found
+inline HMODULE GetModuleHandleW( LPCWSTR ) { return (HMODULE)1; }
+inline FARPROC GetProcAddress( HMODULE, LPCSTR pszName )
+{
+   if (strcmp( pszName, "GetSystemTimePreciseAsFileTime" ) == 0) {
+      return (FARPROC)GetSystemTimePreciseAsFileTime;
+   }
+   return NULL;
+}
+
+
+//-------------------------------------------------------------------------
+// Virtual memory. As on Windows the memory is zero-initialized and
+// aligned to the allocation granularity of 64 KB.
+//-------------------------------------------------------------------------
+#define MEM_COMMIT         0x00001000
+#define MEM_RESERVE        0x00002000
+#define MEM_RELEASE        0x00008000
+#define PAGE_READWRITE     0x04
+
+inline LPVOID VirtualAlloc( LPVOID, size_t cb, DWORD, DWORD )
+{
+   cb = (cb + 0xFFFF) & ~(size_t)0xFFFF;
+   LPVOID pv = aligned_alloc( 0x10000, cb );
+   if (pv) {
+      memset( pv, 0, cb );
+   }
+   return pv;
+}
+inline BOOL VirtualFree( LPVOID pv, size_t, DWORD ) { free( pv ); return TRUE; }
+
+
+//-------------------------------------------------------------------------
+// Thread local storage
+//-------------------------------------------------------------------------
+#define TEST_TLS_INDEXES   64
+
+inline void** TestTlsSlots( void )
+{
+   static thread_local void* apSlots[ TEST_TLS_INDEXES ];
+   return apSlots;
+}
+
+inline DWORD TlsAlloc( void )
+{
+   static std::atomic<DWORD> dwNext( 0 );
+   DWORD dwIndex = dwNext++;
+   return (dwIndex < TEST_TLS_INDEXES) ? dwIndex : TLS_OUT_OF_INDEXES;
+}
+
+inline BOOL TlsFree( DWORD ) { return TRUE; }
+inline LPVOID TlsGetValue( DWORD dwIndex ) { return TestTlsSlots()[ dwIndex ]; }
+inline BOOL TlsSetValue( DWORD dwIndex, LPVOID pValue ) { TestTlsSlots()[ dwIndex ] = pValue; return TRUE; }
+
+
+//-------------------------------------------------------------------------
+// BSTR and VARIANT functions. Only scalar types and BSTR are supported.
+//-------------------------------------------------------------------------
+inline BSTR SysAllocStringLen( const WCHAR* psz, UINT uLen )
+{
+   UINT* p = (UINT*)malloc( sizeof (UINT) + (uLen + 1) * sizeof (WCHAR) );
+   if (p == NULL) {
+      return NULL;
+   }
+   *p = uLen * sizeof (WCHAR);
+   BSTR bstr = (BSTR)(p + 1);
+   if (psz) {
+      memcpy( bstr, psz, uLen * sizeof (WCHAR) );
+   }
+   bstr[ uLen ] = 0;
+   return bstr;
+}
+
+inline BSTR SysAllocString( const WCHAR* psz )
+{
+   return psz ? SysAllocStringLen( psz, (UINT)wcslen( psz ) ) : NULL;
+}
+
+inline void SysFreeString( BSTR bstr )
+{
+   if (bstr) {
+      free( ((UINT*)bstr) - 1 );
+   }
+}
+
+inline UINT SysStringByteLen( BSTR bstr ) { return bstr ? ((UINT*)bstr)[-1] : 0; }
+inline UINT SysStringLen( BSTR bstr ) { return SysStringByteLen( bstr ) / sizeof (WCHAR); }
+
+inline void VariantInit( VARIANT* pv )
+{
+   memset( pv, 0, sizeof (VARIANT) );
+}
+
+inline HRESULT VariantClear( VARIANT* pv )
+{
+   if (V_VT( pv ) == VT_BSTR) {
+      SysFreeString( V_BSTR( pv ) );
+   }
+   VariantInit( pv );
+   return S_OK;
+}
+
+inline HRESULT VariantCopy( VARIANT* pvDest, const VARIANT* pvSrc )
+{
+   if (pvDest == pvSrc) {
+      return S_OK;
+   }
+   VariantClear( pvDest );
+   *pvDest = *pvSrc;
+   if (V_VT( pvSrc ) == VT_BSTR && V_BSTR( pvSrc )) {
+      V_BSTR( pvDest ) = SysAllocStringLen( V_BSTR( pvSrc ), SysStringLen( V_BSTR( pvSrc ) ) );
+      if (V_BSTR( pvDest ) == NULL) {
+         VariantInit( pvDest );
+         return E_OUTOFMEMORY;
+      }
+   }
+   return S_OK;
+}
+
+                  // One-dimensional arrays only. The server passes the
+                  // index as long or LONG, which differ on this platform.
+template <class INDEX>
+inline HRESULT SafeArrayGetElement( SAFEARRAY* psa, INDEX* plIndex, void* pv )
+{
+   if (psa == NULL || psa->cDims != 1) {
+      return E_INVALIDARG;
+   }
+   LONG lIndex = (LONG) *plIndex - psa->rgsabound[0].lLbound;
+   if (lIndex < 0 || (ULONG)lIndex >= psa->rgsabound[0].cElements) {
+      return E_INVALIDARG;
+   }
+   memcpy( pv, (BYTE*)psa->pvData + (size_t)lIndex * psa->cbElements, psa->cbElements );
+   return S_OK;
+}
+
+#endif // _WIN32
+
+#ifndef max
+#define max( a, b )        (((a) > (b)) ? (a) : (b))
+#endif
+#ifndef min
+#define min( a, b )        (((a) < (b)) ? (a) : (b))
+#endif
+
+
+//-------------------------------------------------------------------------
+// OPC definitions used by the tested classes (opcda.h)
+//-------------------------------------------------------------------------
+#ifndef OPC_QUALITY_BAD
+#define OPC_QUALITY_BAD             0x00
+#define OPC_QUALITY_UNCERTAIN       0x40
+#define OPC_QUALITY_GOOD            0xC0
+#endif
+
+#endif // __Tests_stdafx_H
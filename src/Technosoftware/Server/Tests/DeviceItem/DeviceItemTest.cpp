@@ -0,0 +1,942 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the value cache of the Device Items: set_ItemValue(),
+// SetItemValues(), get_ItemValue(), ReadItemValues() and ReadShared()
+// with its shared subscriptions.
+// The updates are only protected by the value locks of the items;
+// concurrent single and bulk writers must never let a reader see a
+// value, quality and time stamp of different updates, an item going
+// back in time or a lost change notification.
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the update throughput of 1 - 32
+// producer threads with concurrent bulk readers is measured with the
+// lock of the items only and with the server wide read/write lock
+// taken for each update, as before. Then the throughput of one thread
+// updating with set_ItemValue() is compared with SetItemValues() in
+// blocks of different sizes, and with the time stamps taken from the
+// system time and from the clock ticker.
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include "DaDeviceItem.h"
+#include "DaGenericItem.h"
+#include "ReadWriteLock.h"
+#include "VariantCompare.h"
+#include "OpcClock.h"
+
+
+//=========================================================================
+// Functions used by DaDeviceItem.cpp which are not tested here. The
+// values are only read with their canonical data type.
+//=========================================================================
+IMalloc* pIMalloc = NULL;
+
+DaGenericGroup DaGenericItem::gDefaultGroup;
+
+HRESULT VariantFromVariant( LPVARIANT pvDest, VARTYPE vtRequested, const LPVARIANT pvSrc )
+{
+   if (V_VT( pvSrc ) != vtRequested) {
+      return DISP_E_TYPEMISMATCH;
+   }
+   return VariantCopy( pvDest, pvSrc );
+}
+
+HRESULT CompareVariant( DaDeviceItem&, float, const VARIANT& varLast, const VARIANT& varNew,
+                        BOOL& fItemValueChanged )
+{
+   fItemValueChanged = V_VT( &varLast ) != V_VT( &varNew ) || varLast.llVal != varNew.llVal;
+   return S_OK;
+}
+
+LONGLONG DaNewChangeVersion( void )
+{
+   static volatile LONGLONG llLastVersion = 0;
+
+   return InterlockedIncrement64( &llLastVersion );
+}
+
+WCHAR* WSTRClone( const WCHAR* oldstr, IMalloc* )
+{
+   WCHAR* c = new WCHAR[ wcslen( oldstr ) + 1 ];
+   wcscpy( c, oldstr );
+   return c;
+}
+
+void WSTRFree( WCHAR* c, IMalloc* )
+{
+   delete [] c;
+}
+
+HRESULT FileTimeToDATE( FILETIME*, DATE& )
+{
+   return E_NOTIMPL;
+}
+
+
+//=========================================================================
+// Values
+//    Each update of an item is derived from a counter k which is also
+//    the time stamp, so a reader can check that value, quality and time
+//    stamp belong to the same update. The canonical data type depends on
+//    the item.
+//=========================================================================
+static const VARTYPE gavtCanonical[] = { VT_I4, VT_R8, VT_I8 };
+
+static VARTYPE CanonicalType( DWORD i ) { return gavtCanonical[ i % 3 ]; }
+static WORD Quality( ULONGLONG k )      { return (WORD)(0xC0 | (k & 0x3F) | ((k >> 6) & 0x0F) << 10); }
+
+static FILETIME TimeStamp( ULONGLONG k )
+{
+   ULARGE_INTEGER t;
+   FILETIME       ft;
+
+   t.QuadPart = k;
+   ft.dwLowDateTime = t.LowPart;
+   ft.dwHighDateTime = t.HighPart;
+   return ft;
+}
+
+static ULONGLONG Counter( const FILETIME& ft )
+{
+   return ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+static void Value( VARTYPE vt, ULONGLONG k, VARIANT* pv )
+{
+   VariantInit( pv );
+   V_VT( pv ) = vt;
+   switch (vt) {
+      case VT_I4: V_I4( pv ) = (LONG)(k * 2654435761U);            break;
+      case VT_R8: V_R8( pv ) = (double)k * 0.25;                   break;
+      default:    V_I8( pv ) = (LONGLONG)(k * 0x9E3779B97F4A7C15ULL); break;
+   }
+}
+
+               // TRUE if value, quality and time stamp belong to update k
+static BOOL IsUpdate( VARTYPE vt, const VARIANT& v, WORD wQuality, const FILETIME& ft, ULONGLONG* pk )
+{
+   VARIANT vExpected;
+
+   *pk = Counter( ft );
+   Value( vt, *pk, &vExpected );
+   return V_VT( &v ) == vt && v.llVal == vExpected.llVal && wQuality == Quality( *pk );
+}
+
+               // Device Item of the servers: no overrides of the value
+               // accessors, the bulk functions access the cache directly
+class DirectItem : public DaDeviceItem {
+public:
+   DirectItem() { m_fDirectValueAccess = TRUE; }
+};
+
+static DaDeviceItem* NewItem( DWORD i, ULONGLONG k )
+{
+   DaDeviceItem*  pItem = new DirectItem;
+   WCHAR          szID[32];
+   VARIANT        v;
+
+   swprintf( szID, 32, L"Item%u", i );
+   Value( CanonicalType( i ), k, &v );
+   if (FAILED( pItem->Create( szID, OPC_READABLE | OPC_WRITEABLE, &v ) )) {
+      delete pItem;
+      return NULL;
+   }
+   return pItem;
+}
+
+               // Subscribes two active Generic Items, required by ReadShared()
+static void Subscribe( DaDeviceItem* pItem, DaGenericItem* pGItems )
+{
+   for (int s = 0; s < 2; s++) {
+      pItem->AddChangeSubscriber( &pGItems[s] );
+      pItem->SetChangeSubscriberActive( &pGItems[s], TRUE );
+   }
+}
+
+static void Unsubscribe( DaDeviceItem* pItem, DaGenericItem* pGItems )
+{
+   for (int s = 0; s < 2; s++) {
+      pItem->RemoveChangeSubscriber( &pGItems[s] );
+   }
+}
+
+
+//=========================================================================
+// Single and bulk updates and reads
+//=========================================================================
+static void TestSetAndRead()
+{
+   DaDeviceItem*  apItems[3];
+   VARIANT        avValues[4];
+   WORD           awQualities[4];
+   FILETIME       aftTimeStamps[4];
+   HRESULT        ahr[4];
+   OPCITEMSTATE   aStates[3];
+   VARIANT        v;
+   WORD           wQuality;
+   FILETIME       ft;
+   ULONGLONG      k;
+   DWORD          i;
+
+   apItems[0] = NewItem( 0, 1 );                // VT_I4
+   apItems[1] = NULL;
+   apItems[2] = NewItem( 1, 1 );                // VT_R8
+   Check( apItems[0] && apItems[2], "Create" );
+   Check( apItems[0]->get_CanonicalDataType() == VT_I4, "canonical data type of the initial value" );
+
+   Value( VT_I4, 5, &v );
+   ft = TimeStamp( 5 );
+   Check( apItems[0]->set_ItemValue( &v, Quality( 5 ), &ft ) == S_OK, "set_ItemValue" );
+   V_VT( &v ) = VT_EMPTY;
+   Check( apItems[0]->get_ItemValue( &v, &wQuality, &ft ) == S_OK, "get_ItemValue" );
+   Check( IsUpdate( VT_I4, v, wQuality, ft, &k ) && k == 5, "get_ItemValue returns the update" );
+
+   Value( VT_R8, 6, &v );
+   Check( apItems[0]->set_ItemValue( &v, Quality( 6 ), &ft ) == OPC_E_BADTYPE,
+          "set_ItemValue rejects a value without the canonical data type" );
+   Check( apItems[0]->set_ItemValue( NULL, Quality( 6 ), &ft ) == E_INVALIDARG, "set_ItemValue without a value" );
+
+                                                // Bulk update
+   Value( VT_I4, 7, &avValues[0] );             // valid
+   Value( VT_I4, 7, &avValues[1] );             // NULL item
+   Value( VT_I4, 7, &avValues[2] );             // not the canonical type
+   for (i = 0; i < 3; i++) {
+      awQualities[i] = Quality( 7 );
+      aftTimeStamps[i] = TimeStamp( 7 );
+   }
+   Check( DaDeviceItem::SetItemValues( 3, apItems, avValues, awQualities, aftTimeStamps, ahr ) == S_FALSE,
+          "SetItemValues with invalid items" );
+   Check( ahr[0] == S_OK, "SetItemValues: valid item" );
+   Check( ahr[1] == OPC_E_INVALIDHANDLE, "SetItemValues: NULL item" );
+   Check( ahr[2] == OPC_E_BADTYPE, "SetItemValues: value without the canonical data type" );
+   Check( ahr[2] == apItems[2]->set_ItemValue( &avValues[2], Quality( 7 ), &aftTimeStamps[2] ),
+          "SetItemValues and set_ItemValue return the same error" );
+
+   VariantInit( &avValues[2] );                 // quality only
+   awQualities[2] = OPC_QUALITY_UNCERTAIN;
+   aftTimeStamps[2] = TimeStamp( 8 );
+   apItems[1] = apItems[2];
+   Check( DaDeviceItem::SetItemValues( 1, &apItems[2], &avValues[2], &awQualities[2], &aftTimeStamps[2], ahr ) == S_OK,
+          "SetItemValues with VT_EMPTY" );
+
+                                                // Bulk read
+   apItems[1] = NULL;
+   for (i = 0; i < 3; i++) {
+      VariantInit( &aStates[i].vDataValue );
+      ahr[i] = S_OK;
+   }
+   Check( DaDeviceItem::ReadItemValues( 3, apItems, aStates, ahr ) == S_OK, "ReadItemValues" );
+   Check( IsUpdate( VT_I4, aStates[0].vDataValue, aStates[0].wQuality, aStates[0].ftTimeStamp, &k ) && k == 7,
+          "ReadItemValues returns the bulk update" );
+   Check( V_VT( &aStates[2].vDataValue ) == VT_R8 && V_R8( &aStates[2].vDataValue ) == 0.25 &&
+          aStates[2].wQuality == OPC_QUALITY_UNCERTAIN && Counter( aStates[2].ftTimeStamp ) == 8,
+          "SetItemValues with VT_EMPTY only updates quality and time stamp" );
+
+   ahr[0] = E_FAIL;                             // failed items are skipped
+   VariantInit( &aStates[0].vDataValue );
+   DaDeviceItem::ReadItemValues( 1, apItems, aStates, ahr );
+   Check( ahr[0] == E_FAIL && V_VT( &aStates[0].vDataValue ) == VT_EMPTY, "ReadItemValues skips failed items" );
+
+   apItems[0]->Kill( TRUE );
+   apItems[2]->Kill( TRUE );
+}
+
+
+//=========================================================================
+// Overrides of the value accessors
+//    The bulk functions call the overrides unless the derived class sets
+//    m_fDirectValueAccess.
+//=========================================================================
+class CountingItem : public DaDeviceItem {
+public:
+   CountingItem( BOOL fDirectValueAccess ) : m_lGet( 0 ), m_lSet( 0 ), m_lSetQuality( 0 )
+   {
+      m_fDirectValueAccess = fDirectValueAccess;
+   }
+
+   virtual HRESULT get_ItemValue( LPVARIANT pvValue, LPWORD pwQuality, LPFILETIME pftTimeStamp )
+   {
+      m_lGet++;
+      return DaDeviceItem::get_ItemValue( pvValue, pwQuality, pftTimeStamp );
+   }
+   virtual HRESULT set_ItemValue( LPVARIANT pvValue, WORD wQuality, LPFILETIME pftTimeStamp )
+   {
+      m_lSet++;
+      return DaDeviceItem::set_ItemValue( pvValue, wQuality, pftTimeStamp );
+   }
+   virtual HRESULT set_ItemQuality( WORD wQuality, LPFILETIME pftTimeStamp )
+   {
+      m_lSetQuality++;
+      return DaDeviceItem::set_ItemQuality( wQuality, pftTimeStamp );
+   }
+
+   long  m_lGet, m_lSet, m_lSetQuality;
+};
+
+static void TestOverrides()
+{
+   for (int o = 0; o < 2; o++) {
+      BOOL           fDirect = (o == 1);
+      CountingItem*  pItem = new CountingItem( fDirect );
+      DaDeviceItem*  pDItem = pItem;
+      VARIANT        v;
+      WORD           wQuality = Quality( 3 );
+      FILETIME       ft = TimeStamp( 3 );
+      OPCITEMSTATE   State;
+      HRESULT        hr = S_OK;
+      ULONGLONG      k;
+
+      Value( VT_R8, 1, &v );
+      pItem->Create( (LPWSTR)L"Counting", OPC_READABLE | OPC_WRITEABLE, &v );
+
+      Value( VT_R8, 3, &v );
+      DaDeviceItem::SetItemValues( 1, &pDItem, &v, &wQuality, &ft, &hr );
+      VariantInit( &v );
+      DaDeviceItem::SetItemValues( 1, &pDItem, &v, &wQuality, &ft, &hr );
+      VariantInit( &State.vDataValue );
+      DaDeviceItem::ReadItemValues( 1, &pDItem, &State, &hr );
+      Check( hr == S_OK && IsUpdate( VT_R8, State.vDataValue, State.wQuality, State.ftTimeStamp, &k ) && k == 3,
+             "overrides: bulk update and read" );
+
+      if (fDirect) {
+         Check( pItem->m_lSet == 0 && pItem->m_lSetQuality == 0 && pItem->m_lGet == 0,
+                "overrides are bypassed with m_fDirectValueAccess" );
+      }
+      else {
+         Check( pItem->m_lSet == 1 && pItem->m_lSetQuality == 1 && pItem->m_lGet == 1,
+                "overrides are called by default" );
+      }
+      pItem->Kill( TRUE );
+   }
+}
+
+
+//=========================================================================
+// Shared reads
+//=========================================================================
+static void TestReadShared()
+{
+   DaDeviceItem*  pItem = NewItem( 2, 1 );      // VT_I8
+   DaGenericItem  aGItems[2];
+   OPCITEMSTATE   State;
+   DASHAREDREAD   Shared, Shared2;
+   VARIANT        v;
+   FILETIME       ft;
+   ULONGLONG      k;
+
+   pItem->AddChangeSubscriber( &aGItems[0] );
+   pItem->SetChangeSubscriberActive( &aGItems[0], TRUE );
+   Check( pItem->ReadShared( VT_EMPTY, 1000, 0.0f, &State, &Shared ) == S_FALSE,
+          "ReadShared with one subscriber" );
+   pItem->RemoveChangeSubscriber( &aGItems[0] );
+
+   Subscribe( pItem, aGItems );
+   Value( VT_I8, 4, &v );
+   ft = TimeStamp( 4 );
+   pItem->set_ItemValue( &v, Quality( 4 ), &ft );
+   Check( aGItems[0].m_lDirty == 1 && aGItems[1].m_lDirty == 1, "an update marks the subscribers dirty" );
+
+   Check( pItem->ReadShared( VT_EMPTY, 1000, 0.0f, &State, &Shared ) == S_OK, "ReadShared" );
+   Check( IsUpdate( VT_I8, State.vDataValue, State.wQuality, State.ftTimeStamp, &k ) && k == 4,
+          "ReadShared returns the update" );
+   VariantClear( &State.vDataValue );
+   Check( pItem->ReadShared( VT_EMPTY, 1000, 0.0f, &State, &Shared2 ) == S_OK &&
+          Shared2.llToken == Shared.llToken && Shared.llToken != 0, "second group gets the same token" );
+   VariantClear( &State.vDataValue );
+
+   ft = TimeStamp( 5 );                         // same value and quality
+   pItem->set_ItemValue( &v, Quality( 4 ), &ft );
+   pItem->ReadShared( VT_EMPTY, 1000, 0.0f, &State, &Shared2 );
+   VariantClear( &State.vDataValue );
+   Check( Shared2.llToken == Shared.llToken, "unchanged value keeps the token" );
+
+   Value( VT_I8, 6, &v );
+   ft = TimeStamp( 6 );
+   pItem->set_ItemValue( &v, Quality( 6 ), &ft );
+   pItem->ReadShared( VT_EMPTY, 1000, 0.0f, &State, &Shared2 );
+   Check( Shared2.llToken != Shared.llToken && Shared2.llPrevToken == Shared.llToken,
+          "changed value gets a new token" );
+   Check( IsUpdate( VT_I8, State.vDataValue, State.wQuality, State.ftTimeStamp, &k ) && k == 6,
+          "ReadShared returns the new update" );
+   VariantClear( &State.vDataValue );
+
+   Unsubscribe( pItem, aGItems );
+   pItem->Kill( TRUE );
+}
+
+
+//=========================================================================
+// Shared subscriptions
+//    Groups reading an item with the same data type, update rate and
+//    deadband share one subscription: the value is read and compared once
+//    per change and all of them get the same token. A different update
+//    rate or deadband is a subscription of its own.
+//=========================================================================
+static LONGLONG ReadToken( DaDeviceItem* pItem, VARTYPE vtRequested, DWORD dwUpdateRate, float fltDeadband )
+{
+   OPCITEMSTATE   State;
+   DASHAREDREAD   Shared;
+
+   Shared.llToken = 0;
+   if (pItem->ReadShared( vtRequested, dwUpdateRate, fltDeadband, &State, &Shared ) != S_OK) {
+      return 0;
+   }
+   VariantClear( &State.vDataValue );
+   return Shared.llToken;
+}
+
+static void TestSharedSubscriptions()
+{
+   CountingItem*  pItem = new CountingItem( TRUE );
+   DaGenericItem  aGItems[2];
+   VARIANT        v;
+   FILETIME       ft;
+   LONGLONG       llToken, llDeadband, llRate;
+
+   Value( VT_I8, 1, &v );
+   pItem->Create( (LPWSTR)L"Shared", OPC_READABLE | OPC_WRITEABLE, &v );
+   Subscribe( pItem, aGItems );
+
+   llToken = ReadToken( pItem, VT_EMPTY, 1000, 0.0f );
+   Check( llToken != 0 && pItem->m_lGet == 1, "first group evaluates the subscription" );
+   Check( ReadToken( pItem, VT_EMPTY, 1000, 0.0f ) == llToken &&
+          ReadToken( pItem, VT_I8, 1000, 0.0f ) == llToken && pItem->m_lGet == 1,
+          "groups with the same rate and deadband share one evaluation" );
+
+   llDeadband = ReadToken( pItem, VT_EMPTY, 1000, 5.0f );
+   Check( llDeadband != 0 && llDeadband != llToken && pItem->m_lGet == 2,
+          "another deadband splits the subscription" );
+   llRate = ReadToken( pItem, VT_EMPTY, 500, 0.0f );
+   Check( llRate != 0 && llRate != llToken && llRate != llDeadband && pItem->m_lGet == 3,
+          "another update rate splits the subscription" );
+   Check( ReadToken( pItem, VT_EMPTY, 1000, 0.0f ) == llToken &&
+          ReadToken( pItem, VT_EMPTY, 1000, 5.0f ) == llDeadband &&
+          ReadToken( pItem, VT_EMPTY, 500, 0.0f ) == llRate && pItem->m_lGet == 3,
+          "split subscriptions keep their tokens" );
+
+   Value( VT_I8, 2, &v );                       // each subscription once per change
+   ft = TimeStamp( 2 );
+   pItem->set_ItemValue( &v, Quality( 2 ), &ft );
+   for (int r = 0; r < 2; r++) {
+      ReadToken( pItem, VT_EMPTY, 1000, 0.0f );
+      ReadToken( pItem, VT_EMPTY, 1000, 5.0f );
+      ReadToken( pItem, VT_EMPTY, 500, 0.0f );
+   }
+   Check( pItem->m_lGet == 6, "each subscription is evaluated once per change" );
+   Check( ReadToken( pItem, VT_EMPTY, 1000, 0.0f ) != llToken, "the change gets a new token" );
+
+   Unsubscribe( pItem, aGItems );
+   pItem->Kill( TRUE );
+}
+
+
+//=========================================================================
+// Change notification of the bulk update
+//    SetItemValues() queues the changed Generic Items with one call of
+//    AddDirtyItems() per group and block instead of one call per item.
+//    Items not queued are marked clean again.
+//=========================================================================
+static void TestBulkDirty()
+{
+   const DWORD                   dwItems = 1000;
+   DaGenericGroup                aGroups[2];
+   std::vector<DaGenericItem>    GItems( dwItems );
+   std::vector<DaDeviceItem*>    Items;
+   std::vector<VARIANT>          Values( dwItems );
+   std::vector<WORD>             Qualities( dwItems );
+   std::vector<HRESULT>          Errors( dwItems );
+   DWORD                         i;
+   BOOL                          fAll;
+
+   for (i = 0; i < dwItems; i++) {
+      Items.push_back( NewItem( i, 1 ) );
+      GItems[i].m_pGroup = &aGroups[ i < dwItems / 2 ? 0 : 1 ];
+      GItems[i].m_ServerHandle = i;
+      Items[i]->AddChangeSubscriber( &GItems[i] );
+      Items[i]->SetChangeSubscriberActive( &GItems[i], TRUE );
+      Value( CanonicalType( i ), 2, &Values[i] );
+      Qualities[i] = Quality( 2 );
+   }
+
+   Check( DaDeviceItem::SetItemValues( dwItems, &Items[0], &Values[0], &Qualities[0], NULL, &Errors[0] ) == S_OK,
+          "SetItemValues with subscribers" );
+   fAll = TRUE;
+   for (i = 0; i < dwItems; i++) {
+      fAll = fAll && GItems[i].m_lDirty == 1;
+   }
+   Check( fAll, "SetItemValues marks each subscriber dirty once" );
+   Check( aGroups[0].m_lDirtyItems + aGroups[1].m_lDirtyItems == (LONG)dwItems &&
+          aGroups[0].m_lDirtyItems == (LONG)dwItems / 2, "SetItemValues queues each subscriber to its group" );
+   Check( aGroups[0].m_lAddDirtyCalls <= 2 && aGroups[1].m_lAddDirtyCalls <= 2,
+          "SetItemValues queues the subscribers with one call per group and block" );
+
+   aGroups[0].m_hrAddDirty = E_OUTOFMEMORY;     // Items which cannot be queued
+   Value( CanonicalType( 0 ), 3, &Values[0] );
+   Value( CanonicalType( dwItems - 1 ), 3, &Values[ dwItems - 1 ] );
+   DaDeviceItem::SetItemValues( 1, &Items[0], &Values[0], &Qualities[0], NULL, &Errors[0] );
+   DaDeviceItem::SetItemValues( 1, &Items[ dwItems - 1 ], &Values[ dwItems - 1 ], &Qualities[0], NULL, &Errors[0] );
+   Check( GItems[0].m_lDirty == 0, "SetItemValues marks items clean if the group cannot queue them" );
+   Check( GItems[ dwItems - 1 ].m_lDirty == 2, "SetItemValues queues the items of the other groups" );
+
+   for (i = 0; i < dwItems; i++) {
+      Items[i]->RemoveChangeSubscriber( &GItems[i] );
+      Items[i]->Kill( TRUE );
+   }
+}
+
+
+//=========================================================================
+// Concurrent writers and readers
+// ------------------------------
+//    Each item is written by one writer, alternately with set_ItemValue()
+//    and with one SetItemValues() call for all items of the writer. The
+//    readers read all items with ReadItemValues() or single items with
+//    ReadShared() and get_ItemValue(). Each item has two active
+//    subscribers which must be marked dirty once per update.
+//=========================================================================
+struct ConcurrencyTest {
+   std::vector<DaDeviceItem*>    Items;
+   std::vector<ULONGLONG>        LastK;      // written by the writer of the item
+   std::vector<DaGenericItem>    GItems;     // two per item
+   std::atomic<bool>             fStop;
+   std::atomic<long>             lTorn;
+   std::atomic<long>             lBackwards;
+   std::atomic<long>             lErrors;
+   std::atomic<ULONGLONG>        ullReads;
+   std::atomic<ULONGLONG>        ullSharedReads;
+   std::atomic<ULONGLONG>        ullSingleWrites;
+   std::atomic<ULONGLONG>        ullBulkWrites;
+
+   ConcurrencyTest( DWORD dwItems ) : Items( dwItems ), LastK( dwItems ), GItems( 2 * dwItems ),
+                                      fStop( false ), lTorn( 0 ), lBackwards( 0 ), lErrors( 0 ),
+                                      ullReads( 0 ), ullSharedReads( 0 ),
+                                      ullSingleWrites( 0 ), ullBulkWrites( 0 ) {}
+};
+
+static void WriteThread( ConcurrencyTest* p, DWORD dwWriter, DWORD dwWriters )
+{
+   std::vector<DWORD>         Indexes;
+   std::vector<DaDeviceItem*> Items;
+   std::vector<VARIANT>       Values;
+   std::vector<WORD>          Qualities;
+   std::vector<FILETIME>      TimeStamps;
+   std::vector<HRESULT>       Errors;
+   size_t                     i;
+
+   for (i = dwWriter; i < p->Items.size(); i += dwWriters) {
+      Indexes.push_back( (DWORD)i );
+      Items.push_back( p->Items[i] );
+   }
+   Values.resize( Items.size() );
+   Qualities.resize( Items.size() );
+   TimeStamps.resize( Items.size() );
+   Errors.resize( Items.size() );
+
+   for (ULONGLONG r = 0; !p->fStop; r++) {
+      for (i = 0; i < Items.size(); i++) {
+         DWORD n = Indexes[i];
+         ULONGLONG k = p->LastK[n] + 1;
+         Value( CanonicalType( n ), k, &Values[i] );
+         Qualities[i] = Quality( k );
+         TimeStamps[i] = TimeStamp( k );
+         if ((r & 1) == 0) {
+            if (Items[i]->set_ItemValue( &Values[i], Qualities[i], &TimeStamps[i] ) != S_OK) {
+               p->lErrors++;
+            }
+            p->ullSingleWrites++;
+         }
+         p->LastK[n] = k;
+      }
+      if (r & 1) {
+         if (DaDeviceItem::SetItemValues( (DWORD)Items.size(), &Items[0], &Values[0], &Qualities[0],
+                                          &TimeStamps[0], &Errors[0] ) != S_OK) {
+            p->lErrors++;
+         }
+         p->ullBulkWrites += Items.size();
+      }
+   }
+}
+
+static void BulkReadThread( ConcurrencyTest* p )
+{
+   std::vector<OPCITEMSTATE>  States( p->Items.size() );
+   std::vector<HRESULT>       Errors( p->Items.size() );
+   std::vector<ULONGLONG>     LastRead( p->Items.size(), 0 );
+   ULONGLONG                  k;
+   size_t                     i;
+
+   while (!p->fStop) {
+      for (i = 0; i < States.size(); i++) {
+         VariantInit( &States[i].vDataValue );    // canonical data type
+         Errors[i] = S_OK;
+      }
+      if (DaDeviceItem::ReadItemValues( (DWORD)States.size(), &p->Items[0], &States[0], &Errors[0] ) != S_OK) {
+         p->lErrors++;
+      }
+      for (i = 0; i < States.size(); i++) {
+         if (!IsUpdate( CanonicalType( (DWORD)i ), States[i].vDataValue, States[i].wQuality,
+                        States[i].ftTimeStamp, &k )) {
+            p->lTorn++;
+         }
+         else if (k < LastRead[i]) {
+            p->lBackwards++;
+         }
+         LastRead[i] = k;
+         VariantClear( &States[i].vDataValue );
+      }
+      p->ullReads += States.size();
+   }
+}
+
+static void SharedReadThread( ConcurrencyTest* p, DWORD dwSeed )
+{
+   std::mt19937            Rand( dwSeed );
+   std::vector<ULONGLONG>  LastRead( p->Items.size(), 0 );
+   OPCITEMSTATE            State;
+   DASHAREDREAD            Shared;
+   ULONGLONG               k;
+
+   while (!p->fStop) {
+      DWORD i = Rand() % (DWORD)p->Items.size();
+      HRESULT hr;
+      VariantInit( &State.vDataValue );
+      if (Rand() & 1) {
+         hr = p->Items[i]->ReadShared( VT_EMPTY, 1000, 0.0f, &State, &Shared );
+      }
+      else {
+         hr = p->Items[i]->get_ItemValue( &State.vDataValue, &State.wQuality, &State.ftTimeStamp );
+      }
+      if (hr != S_OK) {
+         p->lErrors++;
+      }
+      else if (!IsUpdate( CanonicalType( i ), State.vDataValue, State.wQuality, State.ftTimeStamp, &k )) {
+         p->lTorn++;
+      }
+      else if (k < LastRead[i]) {
+         p->lBackwards++;
+      }
+      else {
+         LastRead[i] = k;
+      }
+      VariantClear( &State.vDataValue );
+      p->ullSharedReads++;
+   }
+}
+
+static void TestConcurrency( BOOL fVerbose )
+{
+   const DWORD          dwItems = 600;          // several read blocks
+   const DWORD          dwWriters = 4;
+   ConcurrencyTest*     p = new ConcurrencyTest( dwItems );
+   VARIANT              v;
+   FILETIME             ft;
+   DWORD                i;
+
+   for (i = 0; i < dwItems; i++) {
+      p->Items[i] = NewItem( i, 1 );
+      Subscribe( p->Items[i], &p->GItems[ 2 * i ] );
+      Value( CanonicalType( i ), 1, &v );       // first update before the readers start
+      ft = TimeStamp( 1 );
+      p->Items[i]->set_ItemValue( &v, Quality( 1 ), &ft );
+      p->LastK[i] = 1;
+   }
+
+   std::vector<std::thread> Threads;
+   for (i = 0; i < dwWriters; i++) {
+      Threads.push_back( std::thread( WriteThread, p, i, dwWriters ) );
+   }
+   Threads.push_back( std::thread( BulkReadThread, p ) );
+   Threads.push_back( std::thread( BulkReadThread, p ) );
+   Threads.push_back( std::thread( SharedReadThread, p, 1 ) );
+   Threads.push_back( std::thread( SharedReadThread, p, 2 ) );
+
+   Sleep( 1000 );
+   p->fStop = true;
+   for (i = 0; i < Threads.size(); i++) {
+      Threads[i].join();
+   }
+
+   if (fVerbose) {
+      printf( "concurrency: %llu single writes, %llu bulk writes, %llu bulk reads, %llu single reads\n",
+              (unsigned long long)p->ullSingleWrites, (unsigned long long)p->ullBulkWrites,
+              (unsigned long long)p->ullReads, (unsigned long long)p->ullSharedReads );
+   }
+   Check( p->ullSingleWrites > 0 && p->ullBulkWrites > 0 && p->ullReads > 0 && p->ullSharedReads > 0,
+          "concurrency: all threads ran" );
+   Check( p->lErrors == 0, "concurrency: no failed update or read" );
+   Check( p->lTorn == 0, "concurrency: value, quality and time stamp of the same update" );
+   Check( p->lBackwards == 0, "concurrency: no item goes back in time" );
+
+   BOOL fLast = TRUE, fDirty = TRUE;
+   for (i = 0; i < dwItems; i++) {
+      OPCITEMSTATE State;
+      ULONGLONG    k;
+      VariantInit( &State.vDataValue );
+      p->Items[i]->get_ItemValue( &State.vDataValue, &State.wQuality, &State.ftTimeStamp );
+      if (!IsUpdate( CanonicalType( i ), State.vDataValue, State.wQuality, State.ftTimeStamp, &k ) ||
+          k != p->LastK[i]) {
+         fLast = FALSE;
+      }
+      VariantClear( &State.vDataValue );
+                                                // the initial update was the first notification
+      if ((ULONGLONG)p->GItems[ 2 * i ].m_lDirty != p->LastK[i] ||
+          (ULONGLONG)p->GItems[ 2 * i + 1 ].m_lDirty != p->LastK[i]) {
+         fDirty = FALSE;
+      }
+      Unsubscribe( p->Items[i], &p->GItems[ 2 * i ] );
+      p->Items[i]->Kill( TRUE );
+   }
+   Check( fLast, "concurrency: the last update of each item is kept" );
+   Check( fDirty, "concurrency: each update marks the subscribers dirty once" );
+   delete p;
+}
+
+
+//=========================================================================
+// Benchmark
+// ---------
+//    Updates per second of 1 - 32 producer threads with set_ItemValue(),
+//    while two threads read all items with ReadItemValues(), with
+//       item lock   : only the lock of each item (current)
+//       server lock : in addition the server wide read/write lock, taken
+//                     for writing by each update and for reading by each
+//                     bulk read, as SetItemValue() and the client reads
+//                     did before
+//=========================================================================
+struct BenchmarkRun {
+   std::vector<DaDeviceItem*> Items;
+   ReadWriteLock              ServerLock;
+   BOOL                       fServerLock;
+   std::atomic<bool>          fStop;
+   std::atomic<ULONGLONG>     ullUpdates;
+   std::atomic<ULONGLONG>     ullReads;
+
+   BenchmarkRun() : fServerLock( FALSE ), fStop( false ), ullUpdates( 0 ), ullReads( 0 ) {}
+};
+
+static void BenchmarkProducer( BenchmarkRun* p, DWORD dwProducer, DWORD dwProducers )
+{
+   ULONGLONG   ullUpdates = 0;
+   ULONGLONG   k = 1;
+   VARIANT     v;
+   DWORD       i;
+
+   while (!p->fStop) {
+      k++;
+      for (i = dwProducer; i < p->Items.size() && !p->fStop; i += dwProducers) {
+         Value( CanonicalType( i ), k, &v );
+         if (p->fServerLock) {
+            p->ServerLock.BeginWriting();
+         }
+         p->Items[i]->set_ItemValue( &v, Quality( k ), NULL );
+         if (p->fServerLock) {
+            p->ServerLock.EndWriting();
+         }
+         ullUpdates++;
+      }
+   }
+   p->ullUpdates += ullUpdates;
+}
+
+static void BenchmarkReader( BenchmarkRun* p )
+{
+   std::vector<OPCITEMSTATE>  States( p->Items.size() );
+   std::vector<HRESULT>       Errors( p->Items.size() );
+   size_t                     i;
+
+   while (!p->fStop) {
+      for (i = 0; i < States.size(); i++) {
+         VariantInit( &States[i].vDataValue );
+         Errors[i] = S_OK;
+      }
+      if (p->fServerLock) {
+         p->ServerLock.BeginReading();
+      }
+      DaDeviceItem::ReadItemValues( (DWORD)States.size(), &p->Items[0], &States[0], &Errors[0] );
+      if (p->fServerLock) {
+         p->ServerLock.EndReading();
+      }
+      p->ullReads += States.size();
+   }
+}
+
+static void Benchmark()
+{
+   const DWORD    dwItems = 10000;
+   const double   dDuration = 0.5;
+   BenchmarkRun   Run;
+   DWORD          i;
+
+   Run.ServerLock.Initialize();
+   for (i = 0; i < dwItems; i++) {
+      Run.Items.push_back( NewItem( i, 1 ) );
+   }
+
+   printf( "%u items, 2 threads reading all items with ReadItemValues()\n", dwItems );
+   printf( "producers   item lock: updates/s   reads/s   server lock: updates/s   reads/s\n" );
+   for (DWORD dwProducers = 1; dwProducers <= 32; dwProducers *= 2) {
+      double adUpdates[2], adReads[2];
+      for (int l = 0; l < 2; l++) {
+         std::vector<std::thread> Threads;
+         Run.fServerLock = (l == 1);
+         Run.fStop = false;
+         Run.ullUpdates = 0;
+         Run.ullReads = 0;
+         double dStart = NowSeconds();
+         for (i = 0; i < dwProducers; i++) {
+            Threads.push_back( std::thread( BenchmarkProducer, &Run, i, dwProducers ) );
+         }
+         Threads.push_back( std::thread( BenchmarkReader, &Run ) );
+         Threads.push_back( std::thread( BenchmarkReader, &Run ) );
+         Sleep( (DWORD)(dDuration * 1000) );
+         Run.fStop = true;
+         for (i = 0; i < Threads.size(); i++) {
+            Threads[i].join();
+         }
+         double dSeconds = NowSeconds() - dStart;
+         adUpdates[l] = Run.ullUpdates / dSeconds;
+         adReads[l] = Run.ullReads / dSeconds;
+      }
+      printf( "%9u   %19.2fM %8.2fM   %21.2fM %8.2fM\n", dwProducers,
+              adUpdates[0] / 1e6, adReads[0] / 1e6, adUpdates[1] / 1e6, adReads[1] / 1e6 );
+   }
+
+   for (i = 0; i < dwItems; i++) {
+      Run.Items[i]->Kill( TRUE );
+   }
+}
+
+
+//=========================================================================
+// Benchmark of the bulk update
+// ----------------------------
+//    Updates per second of one thread updating all items with
+//    set_ItemValue() and with SetItemValues() in blocks of 16 - 4096
+//    items, as the plugin SetItemValues() does with blocks of 256.
+//    The current time is used as time stamp in both cases. Each item
+//    has an active subscriber in one of four groups; the number of
+//    calls of the groups per 1000 updates is printed.
+//=========================================================================
+static void BenchmarkBulk()
+{
+   const DWORD                dwItems = 10000;
+   const double               dDuration = 0.5;
+   DaGenericGroup             aGroups[4];
+   std::vector<DaGenericItem> GItems( dwItems );
+   std::vector<DaDeviceItem*> Items;
+   std::vector<VARIANT>       Values( dwItems );
+   std::vector<WORD>          Qualities( dwItems );
+   std::vector<HRESULT>       Errors( dwItems );
+   ULONGLONG                  k = 1, ullUpdates;
+   DWORD                      i, dwBlock;
+   double                     dStart, dSeconds, dSingle;
+   LONG                       lCalls;
+
+   for (i = 0; i < dwItems; i++) {
+      Items.push_back( NewItem( i, 1 ) );
+      GItems[i].m_pGroup = &aGroups[ i % 4 ];
+      Items[i]->AddChangeSubscriber( &GItems[i] );
+      Items[i]->SetChangeSubscriberActive( &GItems[i], TRUE );
+   }
+
+   printf( "\n%u items updated by one thread with set_ItemValue()\n", dwItems );
+   printf( "time stamp       updates/s   ns per update\n" );
+   for (int nTicker = 0; nTicker < 2; nTicker++) {
+      if (nTicker) {
+         OpcClockStartTicker();
+      }
+      ullUpdates = 0;
+      dStart = NowSeconds();
+      do {
+         k++;
+         for (i = 0; i < dwItems; i++) {
+            Value( CanonicalType( i ), k, &Values[i] );
+            Items[i]->set_ItemValue( &Values[i], Quality( k ), NULL );
+         }
+         ullUpdates += dwItems;
+      } while ((dSeconds = NowSeconds() - dStart) < dDuration);
+      if (nTicker) {
+         OpcClockStopTicker();
+      }
+      else {
+         dSingle = ullUpdates / dSeconds;
+      }
+      printf( "%-13s   %8.2fM   %13.1f\n", nTicker ? "clock ticker" : "system time",
+              ullUpdates / dSeconds / 1e6, dSeconds * 1e9 / ullUpdates );
+   }
+
+   printf( "\nblock size   updates/s   speedup   group calls per 1000\n" );
+   printf( "%10s   %8.2fM   %7.2f   %20.1f   (set_ItemValue)\n", "1", dSingle / 1e6, 1.0, 1000.0 );
+
+   for (dwBlock = 16; dwBlock <= 4096; dwBlock *= 4) {
+      lCalls = 0;
+      for (i = 0; i < 4; i++) {
+         lCalls -= aGroups[i].m_lAddDirtyCalls;
+      }
+      ullUpdates = 0;
+      dStart = NowSeconds();
+      do {
+         k++;
+         for (i = 0; i < dwItems; i++) {
+            Value( CanonicalType( i ), k, &Values[i] );
+            Qualities[i] = Quality( k );
+         }
+         for (i = 0; i < dwItems; i += dwBlock) {
+            DWORD dwCount = min( dwItems - i, dwBlock );
+            DaDeviceItem::SetItemValues( dwCount, &Items[i], &Values[i], &Qualities[i], NULL, &Errors[i] );
+         }
+         ullUpdates += dwItems;
+      } while ((dSeconds = NowSeconds() - dStart) < dDuration);
+      for (i = 0; i < 4; i++) {
+         lCalls += aGroups[i].m_lAddDirtyCalls;
+      }
+      printf( "%10u   %8.2fM   %7.2f   %20.1f\n", dwBlock, ullUpdates / dSeconds / 1e6,
+              ullUpdates / dSeconds / dSingle, lCalls * 1000.0 / ullUpdates );
+   }
+
+   for (i = 0; i < dwItems; i++) {
+      Items[i]->RemoveChangeSubscriber( &GItems[i] );
+      Items[i]->Kill( TRUE );
+   }
+}
+
+
+int main( int argc, char* argv[] )
+{
+   if (IsBenchmark( argc, argv )) {
+      Benchmark();
+      BenchmarkBulk();
+      TestConcurrency( TRUE );
+      return 0;
+   }
+
+   TestSetAndRead();
+   TestOverrides();
+   TestReadShared();
+   TestSharedSubscriptions();
+   TestBulkDirty();
+   TestConcurrency( FALSE );
+
+   return TestResult();
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of Da/DaBaseServer.h for the Device Item test. Only
+// provides the members used by DaDeviceItem::get_PropertyValue(), which
+// is not tested.
+//-------------------------------------------------------------------------
+#ifndef __Tests_DaBaseServer_H
+#define __Tests_DaBaseServer_H
+
+#include "ReadWriteLock.h"
+
+class DaBaseServer {
+public:
+   HRESULT RefreshInputCacheCoalesced( DWORD, DaDeviceItem**, HRESULT* pErrors ) { *pErrors = S_OK; return S_OK; }
+   DWORD   GetBaseUpdateRate( void ) { return 0; }
+
+   ReadWriteLock  readWriteLock_;
+};
+
+#endif // __Tests_DaBaseServer_H
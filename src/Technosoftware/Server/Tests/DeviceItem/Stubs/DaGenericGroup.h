@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of Da/DaGenericGroup.h for the Device Item test. Counts
+// the calls of AddDirtyItems() and the items added within a critical
+// section, like the dirty list of the group.
+//-------------------------------------------------------------------------
+#ifndef __Tests_DaGenericGroup_H
+#define __Tests_DaGenericGroup_H
+
+class DaGenericGroup {
+public:
+   DaGenericGroup() : m_lAddDirtyCalls( 0 ), m_lDirtyItems( 0 ), m_hrAddDirty( S_OK )
+   {
+      InitializeCriticalSection( &m_DirtyItemsCritSec );
+   }
+   ~DaGenericGroup()
+   {
+      DeleteCriticalSection( &m_DirtyItemsCritSec );
+   }
+
+   HRESULT AddDirtyItems( DWORD dwCount, const OPCHANDLE* phServerItems )
+   {
+      (void)phServerItems;
+      EnterCriticalSection( &m_DirtyItemsCritSec );
+      m_lAddDirtyCalls++;
+      if (SUCCEEDED( m_hrAddDirty )) {
+         m_lDirtyItems += dwCount;
+      }
+      LeaveCriticalSection( &m_DirtyItemsCritSec );
+      return m_hrAddDirty;
+   }
+
+   LONG              m_lAddDirtyCalls;    // calls of AddDirtyItems()
+   LONG              m_lDirtyItems;       // items added by AddDirtyItems()
+   HRESULT           m_hrAddDirty;        // result of AddDirtyItems()
+   CRITICAL_SECTION  m_DirtyItemsCritSec;
+};
+
+#endif // __Tests_DaGenericGroup_H
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of Da/DaGenericItem.h for the Device Item test. Provides
+// the members used by the change subscribers of DaDeviceItem and counts
+// the changes notified by MarkDirty() and SetDirty(). Each change is
+// queued to the group: MarkDirty() calls the group like the original and
+// SetDirty() always returns TRUE.
+//-------------------------------------------------------------------------
+#ifndef __Tests_DaGenericItem_H
+#define __Tests_DaGenericItem_H
+
+#include "DaDeviceItem.h"
+#include "DaGenericGroup.h"
+
+class DaGenericItem {
+public:
+   DaGenericItem() : m_iSubscriberIndex( -1 ), m_lDirty( 0 ), m_pGroup( &gDefaultGroup ), m_ServerHandle( 0 ) {}
+
+   void MarkDirty( void )  { InterlockedIncrement( &m_lDirty ); m_pGroup->AddDirtyItems( 1, &m_ServerHandle ); }
+   BOOL SetDirty( void )   { InterlockedIncrement( &m_lDirty ); return TRUE; }
+   BOOL ClearDirty( void ) { return InterlockedExchange( &m_lDirty, 0 ) != 0; }
+
+   DaGenericGroup* get_Group( void ) const { return m_pGroup; }
+   OPCHANDLE get_ServerHandle( void ) const { return m_ServerHandle; }
+
+   int            m_iSubscriberIndex;     // position in the subscribers of the Device Item
+   volatile LONG  m_lDirty;               // calls of MarkDirty() and SetDirty()
+   DaGenericGroup *m_pGroup;              // group queueing the items of SetItemValues()
+   OPCHANDLE      m_ServerHandle;
+
+   static DaGenericGroup gDefaultGroup;   // group of the items without m_pGroup set
+                                          // (defined in DeviceItemTest.cpp)
+};
+
+#endif // __Tests_DaGenericItem_H
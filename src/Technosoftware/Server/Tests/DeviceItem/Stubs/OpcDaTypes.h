@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// OPC and ATL definitions used by Da/DaDeviceItem.h. Force-included into
+// the Device Item test after Common/stdafx.h; on Windows the headers of
+// the OPC Foundation and ATL are used.
+//-------------------------------------------------------------------------
+#ifndef __Tests_OpcDaTypes_H
+#define __Tests_OpcDaTypes_H
+
+#ifdef _WIN32
+
+#include <atlbase.h>
+#include <atlsimpcoll.h>
+#include "opcda.h"
+#include "opcerror.h"
+
+#else
+
+typedef DWORD  OPCHANDLE;
+
+typedef enum tagOPCEUTYPE {
+   OPC_NOENUM        = 0,
+   OPC_ANALOG        = 1,
+   OPC_ENUMERATED    = 2
+} OPCEUTYPE;
+
+typedef struct tagOPCITEMSTATE {
+   OPCHANDLE   hClient;
+   FILETIME    ftTimeStamp;
+   WORD        wQuality;
+   WORD        wReserved;
+   VARIANT     vDataValue;
+} OPCITEMSTATE;
+
+typedef struct tagOPCITEMRESULT {
+   OPCHANDLE   hServer;
+   VARTYPE     vtCanonicalDataType;
+   WORD        wReserved;
+   DWORD       dwAccessRights;
+   DWORD       dwBlobSize;
+   BYTE*       pBlob;
+} OPCITEMRESULT;
+
+typedef struct tagOPCITEMVQT {
+   VARIANT     vDataValue;
+   BOOL        bQualitySpecified;
+   WORD        wQuality;
+   WORD        wReserved;
+   BOOL        bTimeStampSpecified;
+   DWORD       dwReserved;
+   FILETIME    ftTimeStamp;
+} OPCITEMVQT;
+
+#define OPC_READABLE                1
+#define OPC_WRITEABLE               2
+#define OPC_LIMIT_OK                0x00
+
+const DWORD OPC_PROPERTY_DATATYPE      = 1;
+const DWORD OPC_PROPERTY_VALUE         = 2;
+const DWORD OPC_PROPERTY_QUALITY       = 3;
+const DWORD OPC_PROPERTY_TIMESTAMP     = 4;
+const DWORD OPC_PROPERTY_ACCESS_RIGHTS = 5;
+const DWORD OPC_PROPERTY_SCAN_RATE     = 6;
+const DWORD OPC_PROPERTY_EU_TYPE       = 7;
+const DWORD OPC_PROPERTY_EU_INFO       = 8;
+const DWORD OPC_PROPERTY_HIGH_EU       = 102;
+const DWORD OPC_PROPERTY_LOW_EU        = 103;
+
+#define OPC_E_INVALIDHANDLE         ((HRESULT)0xC0040001L)
+#define OPC_E_BADTYPE               ((HRESULT)0xC0040004L)
+#define OPC_E_DEADBANDNOTSET        ((HRESULT)0xC0040400L)
+#define OPC_E_DEADBANDNOTSUPPORTED  ((HRESULT)0xC0040401L)
+
+
+//-------------------------------------------------------------------------
+// ATL CSimpleArray, only the functions used by the Device Items
+//-------------------------------------------------------------------------
+template <class T>
+class CSimpleArray {
+public:
+   CSimpleArray() {}
+
+   int   GetSize( void ) const   { return (int)m_Data.size(); }
+   BOOL  Add( const T& t )       { m_Data.push_back( t ); return TRUE; }
+   BOOL  RemoveAt( int nIndex )  { m_Data.erase( m_Data.begin() + nIndex ); return TRUE; }
+   T&    operator[]( int nIndex ) { return m_Data[ nIndex ]; }
+
+private:
+   std::vector<T> m_Data;
+};
+
+#endif // _WIN32
+
+                  // Memory allocator of COM (Core/CoreGenericMain.h)
+extern IMalloc*   pIMalloc;
+
+#endif // __Tests_OpcDaTypes_H
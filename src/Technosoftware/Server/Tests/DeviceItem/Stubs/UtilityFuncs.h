@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of Core/UtilityFuncs.h for the Device Item test, which
+// requires the OPC interface definitions. The functions are defined by
+// the test.
+//-------------------------------------------------------------------------
+#ifndef __Tests_UtilityFuncs_H
+#define __Tests_UtilityFuncs_H
+
+WCHAR*  WSTRClone( const WCHAR* oldstr, IMalloc* pmem = NULL );
+void    WSTRFree( WCHAR* c, IMalloc* pmem = NULL );
+HRESULT FileTimeToDATE( FILETIME* srcFT, DATE& destDATE );
+
+#endif // __Tests_UtilityFuncs_H
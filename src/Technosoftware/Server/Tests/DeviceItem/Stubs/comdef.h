@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of the Visual C++ header comdef.h. DaDeviceItem.cpp only
+// uses _variant_t as an empty variant.
+//-------------------------------------------------------------------------
+#ifndef __Tests_comdef_H
+#define __Tests_comdef_H
+
+class _variant_t : public tagVARIANT {
+public:
+   _variant_t()   { VariantInit( this ); }
+   ~_variant_t()  { VariantClear( this ); }
+};
+
+#endif // __Tests_comdef_H
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com 
+ * 
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of MatchPattern() and CompiledPattern. Each case is checked
+// against the expected result and against the recursive implementation
+// which was replaced by CompiledPattern (MatchPatternReference.cpp).
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the reference implementation is compared
+// with MatchPattern() and CompiledPattern on long Item IDs.
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include "MatchPattern.h"
+
+extern BOOL ReferenceMatchPattern( const MCHAR* String, const MCHAR* Pattern, BOOL bCaseSensitive );
+
+//=========================================================================
+// Checks one string with MatchPattern(), CompiledPattern and the
+// reference implementation. nExpected is -1 if only the implementations
+// are compared.
+//=========================================================================
+static void Check( const MCHAR* String, const MCHAR* Pattern, BOOL bCaseSensitive, int nExpected )
+{
+	BOOL fReference = ReferenceMatchPattern( String, Pattern, bCaseSensitive );
+	BOOL fCached = MatchPattern( String, Pattern, bCaseSensitive );
+
+	CompiledPattern Compiled;
+	BOOL fCompiled = SUCCEEDED( Compiled.Compile( Pattern, bCaseSensitive ) ) && Compiled.Match( String );
+
+	glCases++;
+	if (fCached != fReference || fCompiled != fReference ||
+		(nExpected >= 0 && fReference != (BOOL)nExpected)) {
+		if (glFailures++ < 20) {
+			printf( "FAILED: string \"%ls\" pattern \"%ls\" case sensitive %d: "
+					"expected %d reference %d MatchPattern %d CompiledPattern %d\n",
+					String ? String : L"(null)", Pattern ? Pattern : L"(null)",
+					bCaseSensitive, nExpected, fReference, fCached, fCompiled );
+		}
+	}
+}
+
+
+//=========================================================================
+// Hand-written cases with known results
+//=========================================================================
+static void TestKnownCases()
+{
+	// NULL and empty strings and patterns
+	Check( L"abc", NULL, FALSE, TRUE );
+	Check( NULL, L"*", FALSE, FALSE );
+	Check( L"", L"", FALSE, TRUE );
+	Check( L"", L"*", FALSE, TRUE );
+	Check( L"a", L"", FALSE, FALSE );
+	Check( L"", L"?", FALSE, FALSE );
+
+	// characters and case sensitivity
+	Check( L"abc", L"abc", FALSE, TRUE );
+	Check( L"ABC", L"abc", FALSE, TRUE );
+	Check( L"ABC", L"abc", TRUE, FALSE );
+	Check( L"abc", L"ab", FALSE, FALSE );
+	Check( L"ab", L"abc", FALSE, FALSE );
+
+	// '*'
+	Check( L"a", L"a*", FALSE, TRUE );
+	Check( L"abcabc", L"*abc", FALSE, TRUE );
+	Check( L"abcabd", L"a*c*d", FALSE, TRUE );
+	Check( L"abcabe", L"a*c*d", FALSE, FALSE );
+	Check( L"aaaa", L"*a*a*a*a*", FALSE, TRUE );
+	Check( L"aaa", L"*a*a*a*a*", FALSE, FALSE );
+	Check( L"xaby", L"**ab**", FALSE, TRUE );
+
+	// '?' and '#', also at the end of the string
+	Check( L"ab", L"a?", FALSE, TRUE );
+	Check( L"a", L"a?", FALSE, FALSE );
+	Check( L"a", L"?a", FALSE, FALSE );
+	Check( L"a1", L"a#", FALSE, TRUE );
+	Check( L"a", L"a#", FALSE, FALSE );
+	Check( L"ab", L"a#", FALSE, FALSE );
+	Check( L"12", L"##", FALSE, TRUE );
+	Check( L"1", L"##", FALSE, FALSE );
+	Check( L"x9", L"*#", FALSE, TRUE );
+	Check( L"x", L"*?", FALSE, TRUE );
+	Check( L"", L"*?", FALSE, FALSE );
+
+	// character lists and ranges
+	Check( L"b", L"[a-c]", FALSE, TRUE );
+	Check( L"a", L"[a-c]", FALSE, TRUE );
+	Check( L"c", L"[a-c]", FALSE, TRUE );
+	Check( L"d", L"[a-c]", FALSE, FALSE );
+	Check( L"B", L"[a-c]", FALSE, TRUE );
+	Check( L"B", L"[a-c]", TRUE, FALSE );
+	Check( L"", L"[a-c]", FALSE, FALSE );
+	Check( L"d", L"[!a-c]", FALSE, TRUE );
+	Check( L"b", L"[!a-c]", FALSE, FALSE );
+	Check( L"x", L"[ax-z]", FALSE, TRUE );
+	Check( L"b", L"[ax-z]", FALSE, FALSE );
+
+	// a '-' in front of ']' is a syntax error which fails the
+	// match unless a previous element of the list matched
+	Check( L"a", L"[a-]", FALSE, TRUE );
+	Check( L"-", L"[a-]", FALSE, FALSE );
+	Check( L"b", L"[a-]", FALSE, FALSE );
+	Check( L"a", L"[!a-]", FALSE, FALSE );
+	Check( L"b", L"[!a-]", FALSE, FALSE );
+	Check( L"-", L"[!a-]", FALSE, FALSE );
+	Check( L"ab", L"[a-]b", FALSE, TRUE );
+}
+
+
+//=========================================================================
+// Returns FALSE if a '[' of the pattern is not terminated by ']'. The
+// reference implementation reads beyond the end of such patterns.
+//=========================================================================
+static BOOL IsWellDefined( const MCHAR* Pattern )
+{
+	for (; *Pattern; Pattern++) {
+		if (*Pattern == _M('[')) {
+			const MCHAR* p = Pattern + 1;
+			if (*p == _M('!')) {
+				p++;
+			}
+			while (*p && *p != _M(']')) {
+				p++;
+			}
+			if (*p == 0) {
+				return FALSE;
+			}
+			Pattern = p;
+		}
+	}
+	return TRUE;
+}
+
+
+//=========================================================================
+// Randomized cases compared with the reference implementation
+//=========================================================================
+static void TestRandomCases( long lCount )
+{
+	static const MCHAR  PatternChars[] = _M("ab1A-]![*?#c");
+	static const MCHAR  StringChars[] = _M("abAB1c-]!");
+	const size_t        nPatternChars = sizeof(PatternChars) / sizeof(MCHAR) - 1;
+	const size_t        nStringChars = sizeof(StringChars) / sizeof(MCHAR) - 1;
+
+	std::mt19937 Random( 42 );                  // reproducible
+
+	for (long n = 0; n < lCount; ) {
+		MCHAR Pattern[12], String[12];
+		int   nPatternLen = Random() % 9;
+		int   nStringLen = Random() % 9;
+		int   i;
+
+		for (i = 0; i < nPatternLen; i++) {
+			Pattern[i] = PatternChars[Random() % nPatternChars];
+		}
+		Pattern[i] = 0;
+		for (i = 0; i < nStringLen; i++) {
+			String[i] = StringChars[Random() % nStringChars];
+		}
+		String[i] = 0;
+
+		if (!IsWellDefined( Pattern )) {
+			continue;
+		}
+		Check( String, Pattern, Random() % 2, -1 );
+		n++;
+	}
+}
+
+
+//=========================================================================
+// Benchmark
+//=========================================================================
+// Random Item IDs of the specified length. The characters do not include
+// 'c', so that '*a*b*c*' never matches and all positions are tried.
+static std::vector< std::vector<MCHAR> > ItemIDs( size_t nCount, size_t nLength )
+{
+	static const MCHAR  IDChars[] = _M("abxyzXYZ._0123");
+	const size_t        nIDChars = sizeof(IDChars) / sizeof(MCHAR) - 1;
+	std::mt19937        Random( 7 );
+	std::vector< std::vector<MCHAR> > IDs( nCount );
+
+	for (size_t n = 0; n < nCount; n++) {
+		IDs[n].resize( nLength + 1 );
+		for (size_t i = 0; i < nLength; i++) {
+			IDs[n][i] = IDChars[Random() % nIDChars];
+		}
+		IDs[n][nLength] = 0;
+	}
+	return IDs;
+}
+
+// Time per string of the three implementations
+static void BenchmarkPattern( const MCHAR* Pattern, size_t nLength )
+{
+	const size_t nCount = 2000;
+	std::vector< std::vector<MCHAR> > IDs = ItemIDs( nCount, nLength );
+	long         lRepeat = (long)(400000 / nCount / (nLength / 16));
+	long         lMatchesReference = 0, lMatchesCached = 0, lMatchesCompiled = 0;
+	double       dStart, dReference, dCached, dCompiled;
+
+	dStart = NowSeconds();
+	for (long r = 0; r < lRepeat; r++) {
+		for (size_t n = 0; n < nCount; n++) {
+			lMatchesReference += ReferenceMatchPattern( IDs[n].data(), Pattern, FALSE );
+		}
+	}
+	dReference = NowSeconds() - dStart;
+
+	dStart = NowSeconds();
+	for (long r = 0; r < lRepeat; r++) {
+		for (size_t n = 0; n < nCount; n++) {
+			lMatchesCached += MatchPattern( IDs[n].data(), Pattern, FALSE );
+		}
+	}
+	dCached = NowSeconds() - dStart;
+
+	CompiledPattern Compiled;
+	Compiled.Compile( Pattern, FALSE );
+	dStart = NowSeconds();
+	for (long r = 0; r < lRepeat; r++) {
+		for (size_t n = 0; n < nCount; n++) {
+			lMatchesCompiled += Compiled.Match( IDs[n].data() );
+		}
+	}
+	dCompiled = NowSeconds() - dStart;
+
+	double dStrings = (double)lRepeat * nCount;
+	printf( "%-14ls %6u  %10.0f  %12.0f  %15.0f  %8.1f%s\n", Pattern, (unsigned)nLength,
+			dReference * 1e9 / dStrings, dCached * 1e9 / dStrings, dCompiled * 1e9 / dStrings,
+			dReference / dCached,
+			(lMatchesCached == lMatchesReference && lMatchesCompiled == lMatchesReference) ? "" : "  (results differ)" );
+}
+
+static void Benchmark()
+{
+	static const MCHAR* const Patterns[] = { _M("*a*b*c*"), _M("*a*b*"), _M("a*"), _M("*_0?3*") };
+	static const size_t       Lengths[] = { 32, 64, 128, 256 };
+
+	printf( "ns per string: reference (recursive), MatchPattern() with the cache, CompiledPattern\n" );
+	printf( "pattern        length   reference  MatchPattern  CompiledPattern   speedup\n" );
+	for (size_t p = 0; p < sizeof(Patterns) / sizeof(Patterns[0]); p++) {
+		for (size_t l = 0; l < sizeof(Lengths) / sizeof(Lengths[0]); l++) {
+			BenchmarkPattern( Patterns[p], Lengths[l] );
+		}
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	if (IsBenchmark( argc, argv )) {
+		Benchmark();
+		return 0;
+	}
+
+	TestKnownCases();
+	TestRandomCases( 200000 );
+
+	return TestResult();
+}
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the slot map OpenArray: new / put / get, stale handles,
+// handles of another array, removal while iterating, a full array and
+// random operations compared with a std::map.
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the slot map is compared with the
+// OpenArray with linear search (OpenArrayReference.h).
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include <map>
+#include "OpenArray.h"
+#include "OpenArrayReference.h"
+
+               // Elements are pointers; the values are never dereferenced
+static int* Elem( long n )
+{
+   return reinterpret_cast<int*>( (n + 1) * 8 );
+}
+
+static long Generation( long handle )
+{
+   return (handle >> DA_HANDLE_INDEX_BITS) & DA_HANDLE_GENERATION_MASK;
+}
+
+static long WithGeneration( long handle, long generation )
+{
+   return (generation << DA_HANDLE_INDEX_BITS) | DaHandleIndex( handle );
+}
+
+
+//=========================================================================
+// New, PutElem, GetElem
+//=========================================================================
+static void TestNewPutGet()
+{
+   OpenArray<int*>   oa;
+   int*              p;
+   long              h1, h2;
+
+   Check( oa.TotElem() == 0, "empty array" );
+   Check( oa.GetElem( 1, &p ) == E_FAIL && p == NULL, "GetElem of empty array" );
+   Check( oa.GetElem( -1, &p ) == E_INVALIDARG, "GetElem of negative handle" );
+
+   h1 = oa.New();
+   Check( h1 == 1, "New returns 1 for an empty array, slot 0 is never used" );
+   Check( oa.New() == h1, "New without PutElem returns the same handle" );
+   Check( oa.PutElem( h1, Elem( 1 ) ) == S_OK, "PutElem" );
+   h2 = oa.New();
+   Check( h2 != h1, "New returns another handle" );
+   Check( oa.PutElem( h2, Elem( 2 ) ) == S_OK, "PutElem second" );
+
+   Check( oa.TotElem() == 2, "TotElem" );
+   Check( oa.GetElem( h1, &p ) == S_OK && p == Elem( 1 ), "GetElem first" );
+   Check( oa.GetElem( h2, &p ) == S_OK && p == Elem( 2 ), "GetElem second" );
+
+   Check( oa.PutElem( h1, Elem( 3 ) ) == S_OK, "PutElem replaces an element" );
+   Check( oa.GetElem( h1, &p ) == S_OK && p == Elem( 3 ), "GetElem of replaced element" );
+   Check( oa.TotElem() == 2, "TotElem after replace" );
+
+   Check( oa.PutElem( -1, Elem( 4 ) ) == E_INVALIDARG, "PutElem with negative handle" );
+   Check( oa.PutElem( 0, NULL ) == S_OK && oa.TotElem() == 2, "PutElem( 0, NULL ) is a no-op" );
+}
+
+
+//=========================================================================
+// Stale handles
+//=========================================================================
+static void TestStale()
+{
+   OpenArray<int*>   oa;
+   int*              p;
+   long              h, hNew, hLater;
+
+   h = oa.New();
+   oa.PutElem( h, Elem( 1 ) );
+   Check( oa.PutElem( h, NULL ) == S_OK, "remove" );
+   Check( oa.TotElem() == 0, "TotElem after remove" );
+   Check( oa.GetElem( h, &p ) == E_FAIL && p == NULL, "GetElem of removed element" );
+
+                                    // insert into the freed slot
+   Check( oa.PutElem( h, Elem( 2 ) ) == E_INVALIDARG, "PutElem with stale handle into freed slot" );
+   Check( oa.TotElem() == 0, "stale insert is not stored" );
+   Check( oa.PutElem( h, NULL ) == S_OK, "remove with stale handle of a free slot" );
+
+   hNew = oa.New();
+   Check( DaHandleIndex( hNew ) == DaHandleIndex( h ), "the only free slot is reused" );
+   Check( hNew != h, "reused slot has a new generation" );
+   Check( Generation( hNew ) == Generation( h ) + 1, "generation incremented" );
+   Check( oa.PutElem( hNew, Elem( 3 ) ) == S_OK, "PutElem with the new handle" );
+
+                                    // modify the new element of the slot
+   Check( oa.GetElem( h, &p ) == E_FAIL, "GetElem with stale handle of a reused slot" );
+   Check( oa.PutElem( h, Elem( 4 ) ) == E_INVALIDARG, "replace with stale handle" );
+   Check( oa.PutElem( h, NULL ) == E_INVALIDARG, "remove with stale handle" );
+   Check( oa.GetElem( hNew, &p ) == S_OK && p == Elem( 3 ), "new element unchanged" );
+
+                                    // a later generation than the slot has
+   oa.PutElem( hNew, NULL );
+   hLater = WithGeneration( hNew, Generation( hNew ) + 5 );
+   Check( oa.PutElem( hLater, Elem( 5 ) ) == E_INVALIDARG, "PutElem with a later generation" );
+   Check( oa.GetElem( hLater, &p ) == E_FAIL, "GetElem with a later generation" );
+
+                                    // generation wraps around
+   h = oa.New();
+   for (long i = 0; i <= DA_HANDLE_GENERATION_MASK; i++) {
+      oa.PutElem( h, Elem( 6 ) );
+      oa.PutElem( h, NULL );
+      h = oa.New();
+   }
+   Check( h == WithGeneration( hNew, Generation( hNew ) + 1 ), "generation wraps around" );
+}
+
+
+//=========================================================================
+// Handles of another array
+//=========================================================================
+static void TestHandlesOfAnotherArray()
+{
+   OpenArray<int*>   oa;
+   int*              p;
+   long              h = WithGeneration( 10, 7 );
+
+   Check( oa.PutElem( h, Elem( 1 ) ) == S_OK, "PutElem into a never used slot takes the generation" );
+   Check( oa.GetElem( h, &p ) == S_OK && p == Elem( 1 ), "GetElem with the generation of the handle" );
+   Check( oa.GetElem( 10, &p ) == E_FAIL, "GetElem with another generation" );
+   Check( oa.Size() == 11, "Size after PutElem beyond the end" );
+   Check( oa.New() == 1, "the skipped slots are free" );
+
+   oa.PutElem( h, NULL );                    // slot 10 has generation 8 now
+   Check( oa.PutElem( WithGeneration( 10, 3 ), Elem( 2 ) ) == E_INVALIDARG,
+          "PutElem with another generation into a used slot" );
+   Check( oa.PutElemAt( WithGeneration( 10, 3 ), Elem( 2 ) ) == S_OK,
+          "PutElemAt into a freed slot takes the generation" );
+   Check( oa.GetElem( WithGeneration( 10, 3 ), &p ) == S_OK && p == Elem( 2 ), "GetElem after PutElemAt" );
+   Check( oa.PutElemAt( WithGeneration( 10, 3 ), Elem( 3 ) ) == E_INVALIDARG, "PutElemAt into a used slot" );
+   Check( oa.PutElemAt( WithGeneration( 20, 1 ), Elem( 4 ) ) == S_OK, "PutElemAt beyond the end" );
+   Check( oa.PutElemAt( 30, NULL ) == E_INVALIDARG, "PutElemAt without element" );
+   Check( oa.TotElem() == 2, "TotElem after PutElemAt" );
+}
+
+
+//=========================================================================
+// Iteration
+//=========================================================================
+static void TestIterate()
+{
+   OpenArray<int*>   oa;
+   std::map<long, int*> Visited;
+   long              h, hNext;
+   int*              p;
+   HRESULT           hres;
+   long              i;
+
+   Check( oa.First( &h ) == E_FAIL, "First of empty array" );
+
+   for (i = 0; i < 100; i++) {
+      oa.PutElem( oa.New(), Elem( i ) );
+   }
+                                    // remove every other element while iterating
+   i = 0;
+   hres = oa.First( &h );
+   while (SUCCEEDED( hres )) {
+      oa.GetElem( h, &p );
+      Visited[h] = p;
+      if (i++ % 2 == 0) {
+         oa.PutElem( h, NULL );
+      }
+      hres = oa.Next( h, &hNext );
+      h = hNext;
+   }
+   Check( Visited.size() == 100, "all elements visited once while removing" );
+   Check( oa.TotElem() == 50, "TotElem after removing while iterating" );
+
+                                    // remove all elements while iterating
+   Visited.clear();
+   hres = oa.First( &h );
+   while (SUCCEEDED( hres )) {
+      Visited[h] = NULL;
+      oa.PutElem( h, NULL );
+      hres = oa.Next( h, &hNext );
+      h = hNext;
+   }
+   Check( Visited.size() == 50, "all remaining elements visited while removing all" );
+   Check( oa.TotElem() == 0, "empty after removing all while iterating" );
+   Check( oa.Next( 1, &h ) == E_FAIL && h == 0, "Next of empty array" );
+   Check( oa.Next( -1, &h ) == E_FAIL, "Next of negative handle" );
+}
+
+
+//=========================================================================
+// Full array
+//=========================================================================
+static void TestFull()
+{
+   OpenArray<int*>   oa;
+   long              h, i;
+
+   for (i = 1; i <= DA_HANDLE_INDEX_MASK; i++) {
+      h = oa.New();
+      if (h == -1 || FAILED( oa.PutElem( h, Elem( i ) ) )) {
+         break;
+      }
+   }
+   Check( i == DA_HANDLE_INDEX_MASK + 1, "all slots can be used" );
+   Check( oa.TotElem() == DA_HANDLE_INDEX_MASK, "TotElem of full array" );
+   Check( oa.New() == -1, "New returns -1 if the array is full" );
+   Check( oa.PutElem( oa.New(), Elem( 0 ) ) == E_INVALIDARG, "PutElem with -1 fails" );
+
+   oa.PutElem( 1234, NULL );
+   h = oa.New();
+   Check( DaHandleIndex( h ) == 1234, "New returns the freed slot of a full array" );
+   Check( oa.PutElem( h, Elem( 0 ) ) == S_OK, "PutElem into the freed slot of a full array" );
+   Check( oa.New() == -1, "full again" );
+}
+
+
+//=========================================================================
+// Random operations compared with a std::map
+//=========================================================================
+static void TestRandom()
+{
+   OpenArray<int*>      oa;
+   std::map<long, int*> Model;
+   std::vector<long>    Removed;
+   std::mt19937         Rand( 4711 );
+   int*                 p;
+   long                 h;
+
+   for (long n = 0; n < 20000; n++) {
+      unsigned r = Rand() % 10;
+      if (r < 4 || Model.empty()) {                         // insert
+         h = oa.New();
+         if (oa.PutElem( h, Elem( n ) ) != S_OK || Model.count( h )) {
+            Check( FALSE, "random: insert" );
+         }
+         Model[h] = Elem( n );
+      }
+      else if (r < 7) {                                     // remove
+         std::map<long, int*>::iterator it = Model.begin();
+         std::advance( it, Rand() % Model.size() );
+         if (oa.PutElem( it->first, NULL ) != S_OK) {
+            Check( FALSE, "random: remove" );
+         }
+         Removed.push_back( it->first );
+         Model.erase( it );
+      }
+      else if (r < 8 && !Removed.empty()) {                 // stale handle
+         h = Removed[ Rand() % Removed.size() ];
+         if (!Model.count( h ) && (oa.GetElem( h, &p ) != E_FAIL ||
+                                   oa.PutElem( h, Elem( n ) ) != E_INVALIDARG)) {
+            Check( FALSE, "random: stale handle" );
+         }
+      }
+      else {                                                // lookup
+         std::map<long, int*>::iterator it = Model.begin();
+         std::advance( it, Rand() % Model.size() );
+         if (oa.GetElem( it->first, &p ) != S_OK || p != it->second) {
+            Check( FALSE, "random: lookup" );
+         }
+      }
+   }
+
+   size_t   nVisited = 0;
+   BOOL     fMatch = (oa.TotElem() == (long)Model.size());
+   HRESULT  hres = oa.First( &h );
+   while (SUCCEEDED( hres )) {
+      oa.GetElem( h, &p );
+      fMatch = fMatch && Model.count( h ) && Model[h] == p;
+      nVisited++;
+      hres = oa.Next( h, &h );
+   }
+   Check( fMatch && nVisited == Model.size(), "random: iteration matches the model" );
+}
+
+
+//=========================================================================
+// Benchmark
+// ---------
+//    Operations per second with a given number of elements:
+//       add      : New() and PutElem()
+//       get      : GetElem()
+//       iterate  : First() / Next() over all elements
+//       churn    : remove and add an element (transactions, groups)
+//=========================================================================
+template <class A>
+static void BenchmarkArray( const char* pszName, long lElements )
+{
+   A*          poa = new A;
+   long        i, h;
+   int*        p;
+   double      dStart, dAdd, dGet, dIter, dChurn;
+   long        lChurn = lElements < 100000 ? lElements : 100000;
+   uintptr_t   Sum = 0;
+
+   dStart = NowSeconds();
+   for (i = 0; i < lElements; i++) {
+      poa->PutElem( poa->New(), Elem( i ) );
+   }
+   dAdd = NowSeconds() - dStart;
+
+   dStart = NowSeconds();
+   for (i = 0; i < lElements; i++) {
+      poa->GetElem( 1 + (i * 7919) % lElements, &p );
+      Sum += (uintptr_t)p;
+   }
+   dGet = NowSeconds() - dStart;
+
+   dStart = NowSeconds();
+   for (HRESULT hres = poa->First( &h ); SUCCEEDED( hres ); hres = poa->Next( h, &h )) {
+      Sum += h;
+   }
+   dIter = NowSeconds() - dStart;
+
+   dStart = NowSeconds();
+   for (i = 0; i < lChurn; i++) {
+      poa->First( &h );                      // remove an element at the front
+      poa->PutElem( h, NULL );
+      poa->PutElem( poa->New(), Elem( i ) );
+   }
+   dChurn = NowSeconds() - dStart;
+
+   printf( "   %-10s %8ld elements: add %7.1f ns, get %5.1f ns, iterate %5.1f ns, churn %9.1f ns  (%u)\n",
+           pszName, lElements, dAdd * 1e9 / lElements, dGet * 1e9 / lElements,
+           dIter * 1e9 / lElements, dChurn * 1e9 / lChurn, (unsigned)(Sum & 1) );
+   delete poa;
+}
+
+static void Benchmark()
+{
+   printf( "time per operation\n" );
+   static const long alElements[] = { 100, 10000, 100000 };
+   for (size_t n = 0; n < sizeof (alElements) / sizeof (alElements[0]); n++) {
+      BenchmarkArray< OpenArrayReference<int*> >( "linear", alElements[n] );
+      BenchmarkArray< OpenArray<int*> >( "slot map", alElements[n] );
+   }
+   BenchmarkArray< OpenArray<int*> >( "slot map", DA_HANDLE_INDEX_MASK );
+}
+
+
+int main( int argc, char* argv[] )
+{
+   if (IsBenchmark( argc, argv )) {
+      Benchmark();
+      return 0;
+   }
+
+   TestNewPutGet();
+   TestStale();
+   TestHandlesOfAnotherArray();
+   TestIterate();
+   TestFull();
+   TestRandom();
+
+   return TestResult();
+}
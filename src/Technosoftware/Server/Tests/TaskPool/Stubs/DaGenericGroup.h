@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Replacement of Da/DaGenericGroup.h for the transaction pool test.
+// Provides the members of the groups, the server and the Device Items
+// used by Da/DataCallbackThread.cpp. The reads return the cached value
+// of the items; the server class handler counts the admitted
+// transactions and queues them to its transaction pool or, as before
+// the pool, starts a thread per transaction.
+//-------------------------------------------------------------------------
+#ifndef __Tests_DaGenericGroup_H
+#define __Tests_DaGenericGroup_H
+
+#include <process.h>
+#include "OpenArray.h"
+#include "ReadWriteLock.h"
+#include "DaTaskPool.h"
+#include "UtilityDefs.h"
+#include "OpcClock.h"
+
+class DaAsynchronousThread;
+class DaGenericServer;
+class DaGenericGroup;
+
+
+//-------------------------------------------------------------------------
+// Device Item with a cached VT_I4 value
+//-------------------------------------------------------------------------
+class DaDeviceItem {
+public:
+   DaDeviceItem() : m_lValue( 0 ), m_lAttached( 0 ) {}
+
+   int Attach( void ) { return InterlockedIncrement( &m_lAttached ); }
+   int Detach( void ) { return InterlockedDecrement( &m_lAttached ); }
+
+   LONG           m_lValue;
+   volatile LONG  m_lAttached;
+};
+
+
+//-------------------------------------------------------------------------
+// Server class handler
+//-------------------------------------------------------------------------
+class DaBaseServer {
+public:
+   DaBaseServer() : fThreadPerTransaction_( FALSE ), asyncTransactions_( 0 ) {}
+
+   HRESULT AdmitAsyncTransaction( DaGenericServer* ) { InterlockedIncrement( &asyncTransactions_ ); return S_OK; }
+   void    CompleteAsyncTransaction( DaGenericServer* ) { InterlockedDecrement( &asyncTransactions_ ); }
+
+   HRESULT SubmitAsyncTransaction( DATASKPROC transactionHandler, void* transaction )
+   {
+      if (fThreadPerTransaction_) {
+         unsigned uThreadID;
+         HANDLE hThread = (HANDLE)_beginthreadex( NULL, 0, transactionHandler, transaction, 0, &uThreadID );
+         if (hThread == NULL) {
+            return HRESULT_FROM_WIN32( GetLastError() );
+         }
+         CloseHandle( hThread );
+         return S_OK;
+      }
+      return asyncPool_.Submit( transactionHandler, transaction );
+   }
+
+   DaTaskPool     asyncPool_;
+   BOOL           fThreadPerTransaction_;    // TRUE runs a thread per transaction
+   volatile LONG  asyncTransactions_;        // admitted and not completed transactions
+};
+
+
+//-------------------------------------------------------------------------
+// COM group with the callback interface of the client
+//-------------------------------------------------------------------------
+class DaGroup {
+public:
+   DaGroup() : m_pCallback( NULL ), m_pGGroup( NULL ) { InitializeCriticalSection( &m_CritSec ); }
+   ~DaGroup() { DeleteCriticalSection( &m_CritSec ); }
+
+   void Lock( void )   { EnterCriticalSection( &m_CritSec ); }
+   void Unlock( void ) { LeaveCriticalSection( &m_CritSec ); }
+
+   HRESULT GetCallbackInterface( IOPCDataCallback** ppCallback )
+   {
+      if (m_pCallback == NULL) {
+         return E_FAIL;
+      }
+      m_pCallback->AddRef();
+      *ppCallback = m_pCallback;
+      return S_OK;
+   }
+
+   HRESULT GetGenericGroup( DaGenericGroup** group ) { *group = m_pGGroup; return S_OK; }
+   HRESULT ReleaseGenericGroup( void ) { return S_OK; }
+
+   IOPCDataCallback* m_pCallback;
+   DaGenericGroup*   m_pGGroup;
+   CRITICAL_SECTION  m_CritSec;
+};
+
+template <class T>
+class CComObject : public T {
+};
+
+
+//-------------------------------------------------------------------------
+// Generic server (client connection)
+//-------------------------------------------------------------------------
+class DaGenericServer {
+public:
+   DaGenericServer() { CriticalSectionCOMGroupList.Initialize(); }
+
+   HRESULT InternalReadMaxAge( LPFILETIME, DWORD dwNumOfItems, DaDeviceItem** ppDItems,
+                               DaDeviceItem**, DWORD*, VARIANT* pvValues, WORD* pwQualities,
+                               FILETIME* pftTimeStamps, HRESULT* errors, BOOL* = NULL )
+   {
+      for (DWORD i = 0; i < dwNumOfItems; i++) {
+         VariantClear( &pvValues[i] );
+         V_VT( &pvValues[i] ) = VT_I4;
+         V_I4( &pvValues[i] ) = ppDItems[i]->m_lValue;
+         pwQualities[i] = OPC_QUALITY_GOOD;
+         OpcClockCoarse( &pftTimeStamps[i] );
+         errors[i] = S_OK;
+      }
+      return S_OK;
+   }
+
+   ReadWriteLock                    CriticalSectionCOMGroupList;
+   OpenArray<CComObject<DaGroup>*>  m_COMGroupList;
+};
+
+
+//-------------------------------------------------------------------------
+// Generic group
+//-------------------------------------------------------------------------
+class DaGenericGroup {
+public:
+   DaGenericGroup() : m_pServer( NULL ), m_pServerHandler( NULL ), m_hServerGroupHandle( 0 ),
+                      m_hClientGroupHandle( 0 ), m_lAttached( 0 ), m_fKilled( FALSE ), m_lKeepAlive( 0 )
+   {
+      InitializeCriticalSection( &m_AsyncThreadsCritSec );
+   }
+   ~DaGenericGroup() { DeleteCriticalSection( &m_AsyncThreadsCritSec ); }
+
+   int  Attach( void ) { return InterlockedIncrement( &m_lAttached ); }
+   int  Detach( void ) { return InterlockedDecrement( &m_lAttached ); }
+   BOOL Killed( void ) { return m_fKilled; }
+   void ResetKeepAliveCounter( void ) { InterlockedIncrement( &m_lKeepAlive ); }
+
+   HRESULT InternalRead( DWORD, DWORD numItems, DaDeviceItem** ppItems, OPCITEMSTATE* pItemValues,
+                         HRESULT* ppErrors, BOOL* = NULL )
+   {
+      for (DWORD i = 0; i < numItems; i++) {
+         VariantClear( &pItemValues[i].vDataValue );
+         V_VT( &pItemValues[i].vDataValue ) = VT_I4;
+         V_I4( &pItemValues[i].vDataValue ) = ppItems[i]->m_lValue;
+         pItemValues[i].wQuality = OPC_QUALITY_GOOD;
+         OpcClockCoarse( &pItemValues[i].ftTimeStamp );
+         ppErrors[i] = S_OK;
+      }
+      return S_OK;
+   }
+
+   HRESULT InternalWriteVQT( DWORD numItems, DaDeviceItem**, OPCITEMVQT*, HRESULT* errors, BOOL* = NULL )
+   {
+      for (DWORD i = 0; i < numItems; i++) {
+         errors[i] = S_OK;
+      }
+      return S_OK;
+   }
+
+   DaGenericServer*  m_pServer;
+   DaBaseServer*     m_pServerHandler;
+   long              m_hServerGroupHandle;
+   long              m_hClientGroupHandle;
+
+   OpenArray<DaAsynchronousThread*> m_oaAsyncThread;
+   CRITICAL_SECTION  m_AsyncThreadsCritSec;
+
+   volatile LONG     m_lAttached;            // Attach() minus Detach()
+   volatile BOOL     m_fKilled;
+   volatile LONG     m_lKeepAlive;           // calls of ResetKeepAliveCounter()
+};
+
+#endif // __Tests_DaGenericGroup_H
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// OPC definitions used by Da/DataCallbackThread.cpp. Force-included into
+// the transaction pool test after Common/stdafx.h; on Windows the headers
+// of the OPC Foundation and ATL are used.
+//-------------------------------------------------------------------------
+#ifndef __Tests_OpcDaTypes_H
+#define __Tests_OpcDaTypes_H
+
+#ifdef _WIN32
+
+#include <atlbase.h>
+#include "opcda.h"
+#include "opcerror.h"
+
+#else
+
+#define STDMETHODCALLTYPE
+
+typedef DWORD  OPCHANDLE;
+
+typedef enum tagOPCDATASOURCE {
+   OPC_DS_CACHE      = 1,
+   OPC_DS_DEVICE     = 2
+} OPCDATASOURCE;
+
+typedef struct tagOPCITEMSTATE {
+   OPCHANDLE   hClient;
+   FILETIME    ftTimeStamp;
+   WORD        wQuality;
+   WORD        wReserved;
+   VARIANT     vDataValue;
+} OPCITEMSTATE;
+
+typedef struct tagOPCITEMVQT {
+   VARIANT     vDataValue;
+   BOOL        bQualitySpecified;
+   WORD        wQuality;
+   WORD        wReserved;
+   BOOL        bTimeStampSpecified;
+   DWORD       dwReserved;
+   FILETIME    ftTimeStamp;
+} OPCITEMVQT;
+
+#define OPC_QUALITY_MASK            0xC0
+
+                  // Callback interface of the client, without IUnknown
+                  // except the reference counting
+struct IOPCDataCallback {
+   virtual ULONG   AddRef( void ) = 0;
+   virtual ULONG   Release( void ) = 0;
+   virtual HRESULT OnDataChange( DWORD dwTransid, OPCHANDLE hGroup, HRESULT hrMasterquality,
+                                 HRESULT hrMastererror, DWORD dwCount, OPCHANDLE* phClientItems,
+                                 VARIANT* pvValues, WORD* pwQualities, FILETIME* pftTimeStamps,
+                                 HRESULT* pErrors ) = 0;
+   virtual HRESULT OnReadComplete( DWORD dwTransid, OPCHANDLE hGroup, HRESULT hrMasterquality,
+                                   HRESULT hrMastererror, DWORD dwCount, OPCHANDLE* phClientItems,
+                                   VARIANT* pvValues, WORD* pwQualities, FILETIME* pftTimeStamps,
+                                   HRESULT* pErrors ) = 0;
+   virtual HRESULT OnWriteComplete( DWORD dwTransid, OPCHANDLE hGroup, HRESULT hrMastererr,
+                                    DWORD dwCount, OPCHANDLE* pClienthandles, HRESULT* pErrors ) = 0;
+   virtual HRESULT OnCancelComplete( DWORD dwTransid, OPCHANDLE hGroup ) = 0;
+};
+
+#endif // _WIN32
+
+                  // Memory allocator of COM (Core/CoreGenericMain.h)
+extern IMalloc*   pIMalloc;
+
+#endif // __Tests_OpcDaTypes_H
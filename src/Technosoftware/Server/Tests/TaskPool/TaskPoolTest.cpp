@@ -0,0 +1,742 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the transaction pool DaTaskPool: submit, submit while the
+// pool is stopped, work stealing, stop with queued tasks and the delay of
+// queued tasks while all worker threads are blocked. The asynchronous
+// Read and Refresh transactions (Da/DataCallbackThread.cpp) are executed
+// by the pool with the groups and the server of Stubs/: callbacks,
+// cancel of a queued transaction and the release of the bookkeeping.
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the throughput of the pool is compared
+// with a thread per task, and the asynchronous reads executed by the pool
+// with a thread per transaction as used before the pool was introduced.
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include <process.h>
+#include "DaTaskPool.h"
+#include "DataCallbackThread.h"
+
+#ifdef _WIN32
+IMalloc* pIMalloc = NULL;                       // CoGetMalloc() in main()
+#else
+                  // Memory allocator of COM for the callback arrays
+struct HeapMalloc : public IMalloc {
+   void* Alloc( size_t cb ) { return malloc( cb ); }
+   void  Free( void* pv )   { free( pv ); }
+};
+static HeapMalloc gHeapMalloc;
+IMalloc* pIMalloc = &gHeapMalloc;
+#endif
+
+               // Waits until *plCounter has reached lExpected, max 10 seconds
+static BOOL WaitForCount( volatile LONG* plCounter, LONG lExpected )
+{
+   for (int i = 0; i < 10000 && *plCounter < lExpected; i++) {
+      Sleep( 1 );
+   }
+   return *plCounter == lExpected;
+}
+
+               // Waits until *plCounter is 0, max 10 seconds
+static BOOL WaitForZero( volatile LONG* plCounter )
+{
+   for (int i = 0; i < 10000 && *plCounter != 0; i++) {
+      Sleep( 1 );
+   }
+   return *plCounter == 0;
+}
+
+
+//=========================================================================
+// Tasks
+//=========================================================================
+static unsigned __stdcall CountTask( void* pContext )
+{
+   InterlockedIncrement( static_cast<volatile LONG*>( pContext ) );
+   return 0;
+}
+
+static unsigned __stdcall WaitTask( void* pContext )
+{
+   WaitForSingleObject( static_cast<HANDLE>( pContext ), INFINITE );
+   return 0;
+}
+
+
+//=========================================================================
+// Submit
+//=========================================================================
+static void TestSubmit()
+{
+   const LONG        lTasks = 10000;
+   DaTaskPool        Pool;
+   DATASKPOOLSTATS   Stats;
+   volatile LONG     lExecuted = 0;
+
+   Check( Pool.Submit( CountTask, (void*)&lExecuted ) == E_FAIL, "Submit before Start fails" );
+
+   Check( SUCCEEDED( Pool.Start( 4 ) ), "Start" );
+   Check( Pool.GetThreadCount() == 4, "GetThreadCount" );
+
+   for (LONG i = 0; i < lTasks; i++) {
+      Pool.Submit( CountTask, (void*)&lExecuted );
+   }
+   Check( WaitForCount( &lExecuted, lTasks ), "all submitted tasks are executed" );
+
+   Pool.GetStatistics( &Stats );
+   Check( Stats.ullExecuted == (ULONGLONG)lTasks, "statistics: executed tasks" );
+   Check( Stats.dwQueuedTasks == 0, "statistics: no queued tasks" );
+
+   Pool.Stop();
+   Check( Pool.Submit( CountTask, (void*)&lExecuted ) == E_FAIL, "Submit after Stop fails" );
+   Check( lExecuted == lTasks, "no task executed after Stop" );
+}
+
+//=========================================================================
+// Submit while the pool is stopped
+//    A task submitted concurrently with Stop() is either rejected or
+//    executed, never lost.
+//=========================================================================
+static void TestSubmitWhileStopping()
+{
+   const DWORD dwSubmitters = 4;
+   BOOL        fAllExecuted = TRUE;
+
+   for (int r = 0; r < 20; r++) {
+      DaTaskPool        Pool;
+      volatile LONG     lAccepted = 0;
+      volatile LONG     lExecuted = 0;
+      std::vector<std::thread> Submitters;
+
+      Pool.Start( 2 );
+      for (DWORD i = 0; i < dwSubmitters; i++) {
+         Submitters.push_back( std::thread( [&Pool, &lAccepted, &lExecuted] {
+            while (SUCCEEDED( Pool.Submit( CountTask, (void*)&lExecuted ) )) {
+               InterlockedIncrement( &lAccepted );
+            }
+         } ) );
+      }
+      Sleep( 5 );
+      Pool.Stop();
+      for (DWORD i = 0; i < dwSubmitters; i++) {
+         Submitters[i].join();
+      }
+      if (lExecuted != lAccepted) {
+         fAllExecuted = FALSE;
+      }
+   }
+   Check( fAllExecuted, "a task accepted while the pool is stopped is executed" );
+}
+
+static void TestDefaultThreadCount()
+{
+   DaTaskPool Pool;
+
+   Check( SUCCEEDED( Pool.Start( 0 ) ), "Start with default thread count" );
+   Check( Pool.GetThreadCount() >= DA_TASKPOOL_MIN_THREADS, "default thread count" );
+   Pool.Stop();
+   Check( Pool.GetThreadCount() == 0, "no threads after Stop" );
+}
+
+
+//=========================================================================
+// Work stealing
+//    A task queues child tasks to the queue of its own worker and blocks
+//    until all children are executed. The children can only be executed
+//    if the other worker steals them.
+//=========================================================================
+struct StealContext {
+   DaTaskPool*    pPool;
+   LONG           lChildren;
+   volatile LONG  lExecuted;
+   HANDLE         hAllExecuted;
+   DWORD          dwWait;
+   volatile LONG  lParentDone;
+};
+
+static unsigned __stdcall StealChildTask( void* pContext )
+{
+   StealContext* p = static_cast<StealContext*>( pContext );
+   if (InterlockedIncrement( &p->lExecuted ) == p->lChildren) {
+      SetEvent( p->hAllExecuted );
+   }
+   return 0;
+}
+
+static unsigned __stdcall StealParentTask( void* pContext )
+{
+   StealContext* p = static_cast<StealContext*>( pContext );
+   for (LONG i = 0; i < p->lChildren; i++) {
+      p->pPool->Submit( StealChildTask, p );
+   }
+   p->dwWait = WaitForSingleObject( p->hAllExecuted, 10000 );
+   InterlockedIncrement( &p->lParentDone );
+   return 0;
+}
+
+static void TestSteal()
+{
+   DaTaskPool        Pool;
+   DATASKPOOLSTATS   Stats;
+   StealContext      Ctx;
+
+   Ctx.pPool = &Pool;
+   Ctx.lChildren = 100;
+   Ctx.lExecuted = 0;
+   Ctx.hAllExecuted = CreateEvent( NULL, TRUE, FALSE, NULL );
+   Ctx.dwWait = WAIT_FAILED;
+   Ctx.lParentDone = 0;
+
+   Check( SUCCEEDED( Pool.Start( 2 ) ), "Start" );
+   Pool.Submit( StealParentTask, &Ctx );
+   WaitForCount( &Ctx.lParentDone, 1 );         // Stop() would execute a queued parent itself
+
+   Pool.GetStatistics( &Stats );
+   Pool.Stop();
+   Check( Ctx.dwWait == WAIT_OBJECT_0, "children of a blocked worker are stolen" );
+   Check( Ctx.lExecuted == Ctx.lChildren, "all children executed" );
+   Check( Stats.ullStolen >= (ULONGLONG)Ctx.lChildren, "statistics: stolen tasks" );
+   CloseHandle( Ctx.hAllExecuted );
+}
+
+
+//=========================================================================
+// Stop with queued tasks
+//    The only worker is blocked while Stop() is called. The queued tasks
+//    must be executed by the thread which calls Stop().
+//=========================================================================
+struct StopContext {
+   volatile LONG     lExecuted;
+   volatile LONG     lOnStopThread;
+   std::thread::id   StopThread;
+};
+
+static unsigned __stdcall StopQueuedTask( void* pContext )
+{
+   StopContext* p = static_cast<StopContext*>( pContext );
+   if (std::this_thread::get_id() == p->StopThread) {
+      InterlockedIncrement( &p->lOnStopThread );
+   }
+   InterlockedIncrement( &p->lExecuted );
+   return 0;
+}
+
+static void TestStopWithQueuedTasks()
+{
+   const LONG        lTasks = 20;
+   DaTaskPool        Pool;
+   StopContext       Ctx;
+   HANDLE            hRelease = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+   Ctx.lExecuted = 0;
+   Ctx.lOnStopThread = 0;
+
+   Check( SUCCEEDED( Pool.Start( 1 ) ), "Start" );
+   Pool.Submit( WaitTask, hRelease );
+   for (LONG i = 0; i < lTasks; i++) {
+      Pool.Submit( StopQueuedTask, &Ctx );
+   }
+
+   std::thread Stopper( [&Pool, &Ctx] {
+      Ctx.StopThread = std::this_thread::get_id();
+      Pool.Stop();
+   } );
+   Sleep( 300 );                                // Stop() waits for the blocked worker
+   Check( Ctx.lExecuted == 0, "queued tasks wait while the worker is blocked" );
+   SetEvent( hRelease );
+   Stopper.join();
+
+   Check( Ctx.lExecuted == lTasks, "Stop executes the queued tasks" );
+   Check( Ctx.lOnStopThread == lTasks, "the queued tasks are executed by the thread calling Stop" );
+   CloseHandle( hRelease );
+}
+
+
+//=========================================================================
+// Blocked pool
+//    A task queued while all workers are blocked is delayed until a
+//    worker is free. A canceled transaction sends OnCancelComplete from
+//    the task, so the cancel latency is the same.
+//=========================================================================
+static void TestBlockedPoolDelaysQueuedTasks()
+{
+   const DWORD       dwThreads = 3;
+   DaTaskPool        Pool;
+   volatile LONG     lExecuted = 0;
+   HANDLE            hRelease = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+   Check( SUCCEEDED( Pool.Start( dwThreads ) ), "Start" );
+   for (DWORD i = 0; i < dwThreads; i++) {
+      Pool.Submit( WaitTask, hRelease );
+   }
+   Pool.Submit( CountTask, (void*)&lExecuted );
+   Sleep( 200 );
+   Check( lExecuted == 0, "no task is executed while all workers are blocked" );
+
+   SetEvent( hRelease );
+   Check( WaitForCount( &lExecuted, 1 ), "the queued task is executed when a worker is free" );
+   Pool.Stop();
+   CloseHandle( hRelease );
+}
+
+
+//=========================================================================
+// Asynchronous transactions
+//    A client (generic server, group and COM group with the callback)
+//    starts Read and Refresh transactions the way DaGroup::ReadAsync()
+//    and DaGroup::Cancel2() do.
+//=========================================================================
+class TestCallback : public IOPCDataCallback {
+public:
+   TestCallback() : m_lRefs( 1 ), m_lReadComplete( 0 ), m_lDataChange( 0 ), m_lCancelComplete( 0 ),
+                    m_lWrongResults( 0 ), m_dwLastTransid( 0 ) {}
+
+#ifdef _WIN32
+   HRESULT STDMETHODCALLTYPE QueryInterface( REFIID riid, void** ppv )
+   {
+      if (riid == IID_IUnknown) {
+         *ppv = this;
+         AddRef();
+         return S_OK;
+      }
+      *ppv = NULL;
+      return E_NOINTERFACE;
+   }
+#endif
+   ULONG STDMETHODCALLTYPE AddRef( void )  { return InterlockedIncrement( &m_lRefs ); }
+   ULONG STDMETHODCALLTYPE Release( void ) { return InterlockedDecrement( &m_lRefs ); }
+
+   HRESULT STDMETHODCALLTYPE OnDataChange( DWORD dwTransid, OPCHANDLE, HRESULT hrMasterquality,
+                                           HRESULT hrMastererror, DWORD dwCount, OPCHANDLE* phClientItems,
+                                           VARIANT* pvValues, WORD* pwQualities, FILETIME*, HRESULT* pErrors )
+   {
+      CheckResults( hrMasterquality, hrMastererror, dwCount, phClientItems, pvValues, pwQualities, pErrors );
+      m_dwLastTransid = dwTransid;
+      InterlockedIncrement( &m_lDataChange );
+      return S_OK;
+   }
+
+   HRESULT STDMETHODCALLTYPE OnReadComplete( DWORD dwTransid, OPCHANDLE, HRESULT hrMasterquality,
+                                             HRESULT hrMastererror, DWORD dwCount, OPCHANDLE* phClientItems,
+                                             VARIANT* pvValues, WORD* pwQualities, FILETIME*, HRESULT* pErrors )
+   {
+      CheckResults( hrMasterquality, hrMastererror, dwCount, phClientItems, pvValues, pwQualities, pErrors );
+      m_dwLastTransid = dwTransid;
+      InterlockedIncrement( &m_lReadComplete );
+      return S_OK;
+   }
+
+   HRESULT STDMETHODCALLTYPE OnWriteComplete( DWORD, OPCHANDLE, HRESULT, DWORD, OPCHANDLE*, HRESULT* )
+   {
+      return S_OK;
+   }
+
+   HRESULT STDMETHODCALLTYPE OnCancelComplete( DWORD dwTransid, OPCHANDLE )
+   {
+      m_dwLastTransid = dwTransid;
+      InterlockedIncrement( &m_lCancelComplete );
+      return S_OK;
+   }
+
+   volatile LONG  m_lRefs;
+   volatile LONG  m_lReadComplete;
+   volatile LONG  m_lDataChange;
+   volatile LONG  m_lCancelComplete;
+   volatile LONG  m_lWrongResults;              // callbacks with unexpected results
+   DWORD          m_dwLastTransid;
+
+private:
+               // Item i has the client handle i + 1 and the value 100 + i
+   void CheckResults( HRESULT hrMasterquality, HRESULT hrMastererror, DWORD dwCount,
+                      OPCHANDLE* phClientItems, VARIANT* pvValues, WORD* pwQualities, HRESULT* pErrors )
+   {
+      BOOL fOk = (hrMasterquality == S_OK && hrMastererror == S_OK);
+      for (DWORD i = 0; i < dwCount; i++) {
+         if (phClientItems[i] != i + 1 || V_VT( &pvValues[i] ) != VT_I4 ||
+             V_I4( &pvValues[i] ) != (LONG)(100 + i) || pwQualities[i] != OPC_QUALITY_GOOD ||
+             pErrors[i] != S_OK) {
+            fOk = FALSE;
+         }
+      }
+      if (!fOk) {
+         InterlockedIncrement( &m_lWrongResults );
+      }
+   }
+};
+
+struct AsyncClient {
+   DaGenericServer            Server;
+   DaGenericGroup             Group;
+   CComObject<DaGroup>        COMGroup;
+   TestCallback               Callback;
+   std::vector<DaDeviceItem>  Items;
+
+   AsyncClient( DaBaseServer* pHandler, DWORD dwItems ) : Items( dwItems )
+   {
+      Group.m_pServer = &Server;
+      Group.m_pServerHandler = pHandler;
+      Group.m_hClientGroupHandle = 7;
+      Group.m_hServerGroupHandle = Server.m_COMGroupList.New();
+      Server.m_COMGroupList.PutElem( Group.m_hServerGroupHandle, &COMGroup );
+      COMGroup.m_pCallback = &Callback;
+      COMGroup.m_pGGroup = &Group;
+      for (DWORD i = 0; i < dwItems; i++) {
+         Items[i].m_lValue = 100 + i;
+      }
+   }
+
+   LONG AttachedItems( void )
+   {
+      LONG lAttached = 0;
+      for (size_t i = 0; i < Items.size(); i++) {
+         lAttached += Items[i].m_lAttached;
+      }
+      return lAttached;
+   }
+
+   LONG OutstandingTransactions( void )
+   {
+      EnterCriticalSection( &Group.m_AsyncThreadsCritSec );
+      LONG lOutstanding = Group.m_oaAsyncThread.TotElem();
+      LeaveCriticalSection( &Group.m_AsyncThreadsCritSec );
+      return lOutstanding;
+   }
+};
+
+               // Starts a Read or Refresh of all items of the client
+static HRESULT StartRead( AsyncClient* pClient, BOOL fRefresh, DWORD dwTransactionID, DWORD* pdwCancelID )
+{
+   DWORD          dwCount = (DWORD)pClient->Items.size();
+   DaDeviceItem** ppDItems = new DaDeviceItem*[dwCount];
+   OPCITEMSTATE*  pItemStates = new OPCITEMSTATE[dwCount];
+
+   for (DWORD i = 0; i < dwCount; i++) {
+      ppDItems[i] = &pClient->Items[i];
+      ppDItems[i]->Attach();
+      pItemStates[i].hClient = i + 1;
+      VariantInit( &pItemStates[i].vDataValue );
+   }
+
+   DataCallbackThread* pThread = new DataCallbackThread( &pClient->Group );
+   HRESULT hr = fRefresh ?
+         pThread->CreateCustomRefresh( OPC_DS_CACHE, dwCount, dwTransactionID, ppDItems, pItemStates, NULL, pdwCancelID ) :
+         pThread->CreateCustomRead( dwCount, dwTransactionID, ppDItems, pItemStates, NULL, pdwCancelID );
+
+   if (FAILED( hr )) {                          // The arrays are still owned by the caller
+      delete pThread;
+      delete [] pItemStates;
+      for (DWORD i = 0; i < dwCount; i++) {
+         ppDItems[i]->Detach();
+      }
+      delete [] ppDItems;
+   }
+   return hr;
+}
+
+               // Cancels an outstanding transaction
+static HRESULT CancelRead( AsyncClient* pClient, DWORD dwCancelID )
+{
+   DataCallbackThread* pThreadToCancel;
+
+   EnterCriticalSection( &pClient->Group.m_AsyncThreadsCritSec );
+   HRESULT hr = pClient->Group.m_oaAsyncThread.GetElem( dwCancelID, (DaAsynchronousThread**)&pThreadToCancel );
+   if (SUCCEEDED( hr )) {
+      hr = pThreadToCancel->RequestCancel();
+   }
+   LeaveCriticalSection( &pClient->Group.m_AsyncThreadsCritSec );
+   return hr;
+}
+
+static void TestAsyncReadAndRefresh()
+{
+   DaBaseServer   Handler;
+   AsyncClient    Client( &Handler, 10 );
+   DWORD          dwReadID = 0;
+   DWORD          dwRefreshID = 0;
+
+   Handler.asyncPool_.Start( 2 );
+   Check( SUCCEEDED( StartRead( &Client, FALSE, 11, &dwReadID ) ), "asynchronous read is started" );
+   Check( WaitForCount( &Client.Callback.m_lReadComplete, 1 ), "OnReadComplete" );
+   Check( Client.Callback.m_dwLastTransid == 11, "OnReadComplete with the transaction ID" );
+   Check( SUCCEEDED( StartRead( &Client, TRUE, 12, &dwRefreshID ) ), "refresh is started" );
+   Check( WaitForCount( &Client.Callback.m_lDataChange, 1 ), "OnDataChange of the refresh" );
+   Check( Client.Callback.m_dwLastTransid == 12, "OnDataChange with the transaction ID" );
+   Check( Client.Callback.m_lWrongResults == 0, "the callbacks return the values of the items" );
+
+   Check( WaitForZero( &Client.Group.m_lAttached ), "completed transactions are deleted" );
+   Check( Handler.asyncTransactions_ == 0, "completed transactions release the admission" );
+   Check( Client.AttachedItems() == 0, "completed transactions release the items" );
+   Check( Client.OutstandingTransactions() == 0, "completed transactions are removed from the cancel list" );
+   Check( Client.Group.m_lKeepAlive == 2, "the callbacks reset the keep-alive counter" );
+   Check( FAILED( CancelRead( &Client, dwReadID ) ), "cancel of a completed transaction is too late" );
+   Handler.asyncPool_.Stop();
+}
+
+static void TestCancelQueuedRead()
+{
+   DaBaseServer   Handler;
+   AsyncClient    Client( &Handler, 10 );
+   DWORD          dwCancelID = 0;
+   HANDLE         hRelease = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+   Handler.asyncPool_.Start( 1 );
+   Handler.asyncPool_.Submit( WaitTask, hRelease );
+   Check( SUCCEEDED( StartRead( &Client, FALSE, 21, &dwCancelID ) ), "asynchronous read is queued" );
+   Check( Client.OutstandingTransactions() == 1, "queued transaction is in the cancel list" );
+   Check( SUCCEEDED( CancelRead( &Client, dwCancelID ) ), "cancel of a queued transaction" );
+   Sleep( 100 );
+   Check( Client.Callback.m_lCancelComplete == 0, "OnCancelComplete waits for a free worker" );
+
+   SetEvent( hRelease );
+   Check( WaitForCount( &Client.Callback.m_lCancelComplete, 1 ), "OnCancelComplete" );
+   Check( WaitForZero( &Client.Group.m_lAttached ), "canceled transaction is deleted" );
+   Check( Client.Callback.m_lReadComplete == 0, "no OnReadComplete for a canceled transaction" );
+   Check( Client.Callback.m_dwLastTransid == 21, "OnCancelComplete with the transaction ID" );
+   Check( Handler.asyncTransactions_ == 0, "canceled transaction releases the admission" );
+   Check( Client.AttachedItems() == 0, "canceled transaction releases the items" );
+   Check( Client.OutstandingTransactions() == 0, "canceled transaction is removed from the cancel list" );
+   Handler.asyncPool_.Stop();
+   CloseHandle( hRelease );
+}
+
+static void TestReadOfRemovedGroup()
+{
+   DaBaseServer   Handler;
+   AsyncClient    Client( &Handler, 10 );
+   DWORD          dwCancelID = 0;
+
+   Handler.asyncPool_.Start( 1 );
+   Client.Group.m_fKilled = TRUE;
+   Check( SUCCEEDED( StartRead( &Client, FALSE, 31, &dwCancelID ) ), "asynchronous read of a removed group" );
+   Check( WaitForZero( &Client.Group.m_lAttached ), "transaction of a removed group is deleted" );
+   Check( Client.Callback.m_lReadComplete + Client.Callback.m_lCancelComplete == 0,
+          "no callback for a removed group" );
+   Check( Handler.asyncTransactions_ == 0 && Client.AttachedItems() == 0 &&
+          Client.OutstandingTransactions() == 0, "transaction of a removed group releases the bookkeeping" );
+   Handler.asyncPool_.Stop();
+}
+
+static void TestReadWithStoppedPool()
+{
+   DaBaseServer   Handler;
+   AsyncClient    Client( &Handler, 10 );
+   DWORD          dwCancelID = 0;
+
+   Check( StartRead( &Client, FALSE, 41, &dwCancelID ) == E_FAIL, "read fails if the pool is stopped" );
+   Check( Client.Group.m_lAttached == 0, "rejected transaction is deleted" );
+   Check( Handler.asyncTransactions_ == 0 && Client.AttachedItems() == 0 &&
+          Client.OutstandingTransactions() == 0, "rejected transaction releases the bookkeeping" );
+}
+
+
+//=========================================================================
+// Benchmark
+// ---------
+//    Throughput of short tasks:
+//       pool          : tasks submitted by one thread to the pool
+//       fan-out       : tasks submitted by the workers to their own queue
+//       submitters    : tasks submitted by several client threads
+//       thread/task   : a thread per task as before the pool
+//    Throughput of asynchronous reads, each client thread reads its group
+//    with max 64 outstanding transactions and cancels every 10th:
+//       pool          : transactions executed by the pool
+//       thread/trans. : a thread per transaction as before the pool
+//=========================================================================
+struct FanOutContext {
+   DaTaskPool*    pPool;
+   volatile LONG* plExecuted;
+   LONG           lChildren;
+};
+
+static unsigned __stdcall FanOutTask( void* pContext )
+{
+   FanOutContext* p = static_cast<FanOutContext*>( pContext );
+   for (LONG i = 0; i < p->lChildren; i++) {
+      p->pPool->Submit( CountTask, (void*)p->plExecuted );
+   }
+   return 0;
+}
+
+               // Returns the transactions per second
+static double BenchmarkAsyncReads( BOOL fThreadPerTransaction, DWORD dwClients, LONG lReads )
+{
+   const LONG                 lMaxOutstanding = 64;
+   DaBaseServer               Handler;
+   std::vector<AsyncClient*>  Clients;
+   std::vector<std::thread>   Threads;
+
+   Handler.fThreadPerTransaction_ = fThreadPerTransaction;
+   if (!fThreadPerTransaction) {
+      Handler.asyncPool_.Start( 8 );
+   }
+   for (DWORD c = 0; c < dwClients; c++) {
+      Clients.push_back( new AsyncClient( &Handler, 10 ) );
+   }
+
+   double dStart = NowSeconds();
+   for (DWORD c = 0; c < dwClients; c++) {
+      AsyncClient* pClient = Clients[c];
+      LONG lClientReads = lReads / dwClients;
+      Threads.push_back( std::thread( [pClient, lClientReads, lMaxOutstanding] {
+         LONG lStarted = 0;
+         for (LONG r = 0; r < lClientReads; r++) {
+            while (lStarted - pClient->Callback.m_lReadComplete - pClient->Callback.m_lCancelComplete >= lMaxOutstanding) {
+               SwitchToThread();
+            }
+            DWORD dwCancelID;
+            if (SUCCEEDED( StartRead( pClient, FALSE, r, &dwCancelID ) )) {
+               lStarted++;
+               if (r % 10 == 0) {
+                  CancelRead( pClient, dwCancelID );
+               }
+            }
+         }
+      } ) );
+   }
+   for (DWORD c = 0; c < dwClients; c++) {
+      Threads[c].join();
+   }
+   for (DWORD c = 0; c < dwClients; c++) {
+      WaitForZero( &Clients[c]->Group.m_lAttached );
+   }
+   double dElapsed = NowSeconds() - dStart;
+
+   Handler.asyncPool_.Stop();
+   for (DWORD c = 0; c < dwClients; c++) {
+      delete Clients[c];
+   }
+   return (lReads / dwClients) * dwClients / dElapsed;
+}
+
+static void Benchmark()
+{
+   const LONG     lTasks = 200000;
+   const LONG     lThreadTasks = 2000;
+   double         dStart;
+
+   printf( "%ld short tasks per run\n", (long)lTasks );
+
+   static const DWORD adwThreads[] = { 1, 2, 4, 8, 16 };
+   for (DWORD t = 0; t < sizeof (adwThreads) / sizeof (adwThreads[0]); t++) {
+      DaTaskPool        Pool;
+      DATASKPOOLSTATS   Stats;
+      volatile LONG     lExecuted = 0;
+
+      Pool.Start( adwThreads[t] );
+      dStart = NowSeconds();
+      for (LONG i = 0; i < lTasks; i++) {
+         Pool.Submit( CountTask, (void*)&lExecuted );
+      }
+      WaitForCount( &lExecuted, lTasks );
+      double dPool = NowSeconds() - dStart;
+
+      lExecuted = 0;
+      const LONG lParents = adwThreads[t] * 4;
+      std::vector<FanOutContext> Ctx( lParents );
+      dStart = NowSeconds();
+      for (LONG i = 0; i < lParents; i++) {
+         Ctx[i].pPool = &Pool;
+         Ctx[i].plExecuted = &lExecuted;
+         Ctx[i].lChildren = lTasks / lParents;
+         Pool.Submit( FanOutTask, &Ctx[i] );
+      }
+      WaitForCount( &lExecuted, (lTasks / lParents) * lParents );
+      double dFanOut = NowSeconds() - dStart;
+
+      Pool.GetStatistics( &Stats );
+      Pool.Stop();
+      printf( "   pool, %2u threads: %9.0f tasks/s, fan-out %9.0f tasks/s, %llu stolen\n",
+              adwThreads[t], lTasks / dPool, lTasks / dFanOut, (unsigned long long)Stats.ullStolen );
+   }
+
+   static const DWORD adwSubmitters[] = { 1, 4, 16 };
+   for (DWORD t = 0; t < sizeof (adwSubmitters) / sizeof (adwSubmitters[0]); t++) {
+      DaTaskPool                 Pool;
+      volatile LONG              lExecuted = 0;
+      std::vector<std::thread>   Submitters;
+      const LONG                 lPerSubmitter = lTasks / adwSubmitters[t];
+
+      Pool.Start( 8 );
+      dStart = NowSeconds();
+      for (DWORD i = 0; i < adwSubmitters[t]; i++) {
+         Submitters.push_back( std::thread( [&Pool, &lExecuted, lPerSubmitter] {
+            for (LONG n = 0; n < lPerSubmitter; n++) {
+               Pool.Submit( CountTask, (void*)&lExecuted );
+            }
+         } ) );
+      }
+      for (DWORD i = 0; i < adwSubmitters[t]; i++) {
+         Submitters[i].join();
+      }
+      WaitForCount( &lExecuted, lPerSubmitter * (LONG)adwSubmitters[t] );
+      printf( "   pool,  8 threads, %2u submitting threads: %9.0f tasks/s\n",
+              adwSubmitters[t], lPerSubmitter * adwSubmitters[t] / (NowSeconds() - dStart) );
+      Pool.Stop();
+   }
+
+   volatile LONG lExecuted = 0;
+   dStart = NowSeconds();
+   for (LONG i = 0; i < lThreadTasks; i++) {
+      unsigned uThreadID;
+      HANDLE hThread = (HANDLE)_beginthreadex( NULL, 0, CountTask, (void*)&lExecuted, 0, &uThreadID );
+      CloseHandle( hThread );
+   }
+   WaitForCount( &lExecuted, lThreadTasks );
+   printf( "   thread per task:  %9.0f tasks/s\n", lThreadTasks / (NowSeconds() - dStart) );
+
+   printf( "asynchronous reads of 10 items\n" );
+   static const DWORD adwClients[] = { 1, 4, 16 };
+   for (DWORD c = 0; c < sizeof (adwClients) / sizeof (adwClients[0]); c++) {
+      double dPool = BenchmarkAsyncReads( FALSE, adwClients[c], 100000 );
+      double dThread = BenchmarkAsyncReads( TRUE, adwClients[c], 5000 );
+      printf( "   %2u clients: pool %9.0f transactions/s, thread per transaction %9.0f transactions/s\n",
+              adwClients[c], dPool, dThread );
+   }
+}
+
+
+int main( int argc, char* argv[] )
+{
+#ifdef _WIN32
+   CoGetMalloc( 1, &pIMalloc );
+#endif
+   if (IsBenchmark( argc, argv )) {
+      Benchmark();
+      return 0;
+   }
+
+   TestSubmit();
+   TestSubmitWhileStopping();
+   TestDefaultThreadCount();
+   TestSteal();
+   TestStopWithQueuedTasks();
+   TestBlockedPoolDelaysQueuedTasks();
+   TestAsyncReadAndRefresh();
+   TestCancelQueuedRead();
+   TestReadOfRemovedGroup();
+   TestReadWithStoppedPool();
+
+   return TestResult();
+}
@@ -0,0 +1,645 @@
+/*
+ * Copyright (c) 2011-2022 Technosoftware GmbH. All rights reserved
+ * Web: https://technosoftware.com
+ *
+ * The source code in this file is covered under a dual-license scenario:
+ *   - Owner of a purchased license: SCLA 1.0
+ *   - GPL V3: everybody else
+ *
+ * SCLA license terms accompanied with this source code.
+ * See https://technosoftware.com/license/Source_Code_License_Agreement.pdf
+ *
+ * GNU General Public License as published by the Free Software Foundation;
+ * version 3 of the License are accompanied with this source code.
+ * See https://technosoftware.com/license/GPLv3License.txt
+ *
+ * This source code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+//-------------------------------------------------------------------------
+// Unit test of the value store DaValueStore: allocation, the side table
+// and concurrent writers and readers over several pages. The lock-free
+// readers must never see a torn (data type, value, quality, time stamp)
+// tuple; the side table values must stay valid while ordinals on the
+// same pages are released and reused.
+// Returns 0 if all cases pass.
+//
+// With the argument --benchmark the read and write latency of the store
+// is compared with values stored in the items and read within the lock
+// of the item, as before the store was introduced. The read throughput
+// is also measured with 16 reader threads while one thread writes.
+//-------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "TestUtil.h"
+#include "DaValueStore.h"
+
+//-------------------------------------------------------------------------
+// Conversion used by DaValueStore (Da/VariantConversion.cpp requires the
+// SAFEARRAY functions). The tests read the values with the stored type.
+//-------------------------------------------------------------------------
+HRESULT VariantFromVariant( LPVARIANT pvDest, VARTYPE vtRequested, const LPVARIANT pvSrc )
+{
+   if (V_VT( pvSrc ) != vtRequested) {
+      return DISP_E_TYPEMISMATCH;
+   }
+   return VariantCopy( pvDest, pvSrc );
+}
+
+
+//=========================================================================
+// Values
+//    Each write is derived from a counter k which is also the time stamp,
+//    so a reader can check that all attributes belong to the same write.
+//=========================================================================
+static const VARTYPE gavtScalar[] = { VT_I4, VT_R8, VT_I8 };
+
+static VARTYPE ScalarType( ULONGLONG k )  { return gavtScalar[ k % 3 ]; }
+static LONGLONG ScalarBits( ULONGLONG k ) { return (LONGLONG)(k * 0x9E3779B97F4A7C15ULL); }
+static WORD Quality( ULONGLONG k )        { return (WORD)(0xC0 | (k & 0x3F) | ((k >> 6) & 0x0F) << 10); }
+
+static FILETIME TimeStamp( ULONGLONG k )
+{
+   ULARGE_INTEGER t;
+   FILETIME       ft;
+
+   t.QuadPart = k;
+   ft.dwLowDateTime = t.LowPart;
+   ft.dwHighDateTime = t.HighPart;
+   return ft;
+}
+
+static ULONGLONG Counter( const FILETIME& ft )
+{
+   return ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+static void ScalarValue( ULONGLONG k, VARIANT* pv )
+{
+   VariantInit( pv );
+   V_VT( pv ) = ScalarType( k );
+   pv->llVal = ScalarBits( k );
+}
+
+static void StringValue( ULONGLONG k, VARIANT* pv )
+{
+   WCHAR sz[32];
+
+   swprintf( sz, 32, L"value %llu", (unsigned long long)k );
+   VariantInit( pv );
+   V_VT( pv ) = VT_BSTR;
+   V_BSTR( pv ) = SysAllocString( sz );
+}
+
+static BOOL IsString( const VARIANT& v, ULONGLONG k )
+{
+   WCHAR sz[32];
+
+   swprintf( sz, 32, L"value %llu", (unsigned long long)k );
+   return V_VT( &v ) == VT_BSTR && wcscmp( V_BSTR( &v ), sz ) == 0;
+}
+
+               // TRUE if the tuple is the initial state or belongs to a write
+static BOOL IsConsistent( const DASCALARVQT& VQT, BOOL fSide )
+{
+   ULONGLONG k = Counter( VQT.ftTimeStamp );
+
+   if (k == 0) {
+      return VQT.vt == VT_EMPTY && VQT.wQuality == OPC_QUALITY_BAD && VQT.llValue == 0;
+   }
+   if (VQT.wQuality != Quality( k )) {
+      return FALSE;
+   }
+   if (fSide && (k & 1)) {                     // string in the side table
+      return VQT.vt == VT_BSTR;
+   }
+   if (fSide) {
+      return VQT.vt == VT_I8 && VQT.llValue == ScalarBits( k );
+   }
+   return VQT.vt == ScalarType( k ) && VQT.llValue == ScalarBits( k );
+}
+
+
+//=========================================================================
+// Allocate, Release and the side table
+//=========================================================================
+static void TestAllocate()
+{
+   DaValueStore         Store;
+   DAVALUESTORESTATS    Stats;
+   VARIANT              v;
+   WORD                 wQuality;
+   FILETIME             ft = TimeStamp( 5 );
+   HRESULT              hr;
+
+   DWORD o1 = Store.Allocate();
+   DWORD o2 = Store.Allocate();
+   Check( o1 == 0 && o2 == 1, "ordinals are dense" );
+   Check( Store.GetDataType( o1 ) == VT_EMPTY, "new ordinal is empty" );
+
+   ScalarValue( 5, &v );
+   Check( Store.SetValue( o1, &v, Quality( 5 ), &ft ) == S_OK, "SetValue scalar" );
+   VariantInit( &v );
+   Check( Store.ReadScalar( o1, VT_EMPTY, &v, &wQuality, &ft, &hr ) && SUCCEEDED( hr ),
+          "ReadScalar of a scalar value" );
+   Check( V_VT( &v ) == ScalarType( 5 ) && v.llVal == ScalarBits( 5 ) &&
+          wQuality == Quality( 5 ) && Counter( ft ) == 5, "scalar value read back" );
+
+   StringValue( 7, &v );
+   ft = TimeStamp( 7 );
+   Check( Store.SetValue( o2, &v, Quality( 7 ), &ft ) == S_OK, "SetValue string" );
+   VariantClear( &v );
+   Check( !Store.ReadScalar( o2, VT_EMPTY, &v, &wQuality, &ft, &hr ), "ReadScalar of a side value fails" );
+   Check( Store.ReadValue( o2, VT_EMPTY, &v, &wQuality, &ft ) == S_OK && IsString( v, 7 ) &&
+          wQuality == Quality( 7 ) && Counter( ft ) == 7, "ReadValue of a side value" );
+   VariantClear( &v );
+
+   Store.GetStatistics( &Stats );
+   Check( Stats.dwOrdinals == 2 && Stats.dwPages == 1 && Stats.dwSideValues == 1, "statistics" );
+
+   ScalarValue( 8, &v );                    // type change frees the side value
+   ft = TimeStamp( 8 );
+   Store.SetValue( o2, &v, Quality( 8 ), &ft );
+   Store.GetStatistics( &Stats );
+   Check( Stats.dwSideValues == 0, "side value freed when a scalar is written" );
+
+   StringValue( 9, &v );
+   ft = TimeStamp( 9 );
+   Store.SetValue( o2, &v, Quality( 9 ), &ft );
+   VariantClear( &v );
+   Store.Release( o2 );
+   Store.GetStatistics( &Stats );
+   Check( Stats.dwOrdinals == 1 && Stats.dwSideValues == 0, "Release frees the side value" );
+
+   DWORD o3 = Store.Allocate();
+   Check( o3 == o2, "released ordinal is reused" );
+   Check( Store.GetDataType( o3 ) == VT_EMPTY, "reused ordinal is empty" );
+   DASCALARVQT VQT;
+   Store.ReadScalars( 1, &o3, &VQT );
+   Check( IsConsistent( VQT, FALSE ) && Counter( VQT.ftTimeStamp ) == 0, "reused ordinal has the initial state" );
+
+   ft = TimeStamp( 11 );
+   Store.SetQuality( o1, Quality( 11 ), &ft );
+   Store.ReadQuality( o1, &wQuality, &ft );
+   Check( wQuality == Quality( 11 ) && Counter( ft ) == 11, "SetQuality / ReadQuality" );
+}
+
+
+//=========================================================================
+// Concurrent writers and readers
+// ------------------------------
+//    Scalar ordinals   : written by the writers with a scalar of a
+//                        changing type, read lock-free by the readers.
+//    Side ordinals     : alternately a string and a scalar, read lock-free
+//                        and within the lock of the ordinal.
+//    Churn ordinals    : allocated with a string value and released again
+//                        while the other ordinals of the pages are read.
+//    The ordinals span several pages. Each ordinal has a mutex which
+//    stands for DaDeviceItem::m_CritSec.
+//=========================================================================
+struct TestOrdinal {
+   std::mutex  Lock;
+   DWORD       dwOrdinal;
+   BOOL        fAllocated;                 // churn ordinals only
+   ULONGLONG   k;                          // last counter written
+};
+
+struct ConcurrencyTest {
+   DaValueStore               Store;
+   std::vector<TestOrdinal>   Scalar;
+   std::vector<TestOrdinal>   Side;
+   std::vector<TestOrdinal>   Churn;
+   std::atomic<bool>          fStop;
+   std::atomic<long>          lTorn;
+   std::atomic<long>          lBadSide;
+   std::atomic<ULONGLONG>     ullReads;
+   std::atomic<ULONGLONG>     ullSideReads;
+   std::atomic<ULONGLONG>     ullChurns;
+
+   ConcurrencyTest() : Scalar( 6000 ), Side( 3000 ), Churn( 3000 ),
+                       fStop( false ), lTorn( 0 ), lBadSide( 0 ),
+                       ullReads( 0 ), ullSideReads( 0 ), ullChurns( 0 ) {}
+};
+
+static void WriteThread( ConcurrencyTest* p, DWORD dwWriter, DWORD dwWriters )
+{
+   std::mt19937   Rand( dwWriter );
+   VARIANT        v;
+
+   while (!p->fStop) {
+      BOOL fSide = Rand() % 3 == 0;
+      std::vector<TestOrdinal>& Ordinals = fSide ? p->Side : p->Scalar;
+      size_t i = Rand() % Ordinals.size();
+      i -= i % dwWriters;                  // each writer writes other counters
+      if (i + dwWriter >= Ordinals.size()) {
+         continue;
+      }
+      TestOrdinal& o = Ordinals[i + dwWriter];
+      std::lock_guard<std::mutex> Lock( o.Lock );
+      ULONGLONG k = ++o.k;
+      FILETIME ft = TimeStamp( k );
+      if (fSide && (k & 1)) {
+         StringValue( k, &v );
+      }
+      else {
+         ScalarValue( k, &v );
+         if (fSide) {
+            V_VT( &v ) = VT_I8;
+         }
+      }
+      p->Store.SetValue( o.dwOrdinal, &v, Quality( k ), &ft );
+      VariantClear( &v );
+   }
+}
+
+static void LockFreeReadThread( ConcurrencyTest* p )
+{
+   std::vector<DWORD>         Ordinals;
+   std::vector<DASCALARVQT>   VQTs;
+   size_t                     i;
+
+   for (i = 0; i < p->Scalar.size(); i++) {
+      Ordinals.push_back( p->Scalar[i].dwOrdinal );
+   }
+   size_t nScalar = Ordinals.size();
+   for (i = 0; i < p->Side.size(); i++) {
+      Ordinals.push_back( p->Side[i].dwOrdinal );
+   }
+   VQTs.resize( Ordinals.size() );
+
+   while (!p->fStop) {
+      p->Store.ReadScalars( (DWORD)Ordinals.size(), &Ordinals[0], &VQTs[0] );
+      for (i = 0; i < Ordinals.size(); i++) {
+         if (!IsConsistent( VQTs[i], i >= nScalar )) {
+            p->lTorn++;
+         }
+      }
+      p->ullReads += Ordinals.size();
+   }
+}
+
+static void SideReadThread( ConcurrencyTest* p, DWORD dwSeed )
+{
+   std::mt19937   Rand( dwSeed );
+   VARIANT        v;
+   WORD           wQuality;
+   FILETIME       ft;
+
+   while (!p->fStop) {
+      BOOL fChurn = Rand() % 2 == 0;
+      std::vector<TestOrdinal>& Ordinals = fChurn ? p->Churn : p->Side;
+      TestOrdinal& o = Ordinals[ Rand() % Ordinals.size() ];
+      std::lock_guard<std::mutex> Lock( o.Lock );
+      if (fChurn && !o.fAllocated) {
+         continue;
+      }
+      VariantInit( &v );
+      if (FAILED( p->Store.ReadValue( o.dwOrdinal, VT_EMPTY, &v, &wQuality, &ft ) )) {
+         p->lBadSide++;
+         continue;
+      }
+      ULONGLONG k = Counter( ft );
+      BOOL fValid;
+      if (k == 0) {                        // never written
+         fValid = !fChurn && V_VT( &v ) == VT_EMPTY && wQuality == OPC_QUALITY_BAD;
+      }
+      else if (k & 1) {
+         fValid = IsString( v, k );
+      }
+      else {
+         fValid = !fChurn && V_VT( &v ) == VT_I8 && v.llVal == ScalarBits( k );
+      }
+      if (!fValid || k != o.k || (k && wQuality != Quality( k ))) {
+         p->lBadSide++;
+      }
+      VariantClear( &v );
+      p->ullSideReads++;
+   }
+}
+
+static void ChurnThread( ConcurrencyTest* p )
+{
+   std::mt19937   Rand( 99 );
+   VARIANT        v;
+   ULONGLONG      k = 1;
+
+   while (!p->fStop) {
+      TestOrdinal& o = p->Churn[ Rand() % p->Churn.size() ];
+      std::lock_guard<std::mutex> Lock( o.Lock );
+      if (o.fAllocated) {
+         p->Store.Release( o.dwOrdinal );
+         o.fAllocated = FALSE;
+      }
+      else {
+         o.dwOrdinal = p->Store.Allocate();
+         k += 2;
+         FILETIME ft = TimeStamp( k );
+         StringValue( k, &v );
+         p->Store.SetValue( o.dwOrdinal, &v, Quality( k ), &ft );
+         VariantClear( &v );
+         o.k = k;
+         o.fAllocated = TRUE;
+      }
+      p->ullChurns++;
+   }
+}
+
+static void TestConcurrency( BOOL fVerbose )
+{
+   const DWORD          dwWriters = 2;
+   ConcurrencyTest*     p = new ConcurrencyTest;
+   DAVALUESTORESTATS    Stats;
+   size_t               i;
+                                    // interleave the kinds over the pages
+   for (i = 0; i < p->Scalar.size(); i++) {
+      p->Scalar[i].dwOrdinal = p->Store.Allocate();
+      p->Scalar[i].k = 0;
+      if (i < p->Side.size()) {
+         p->Side[i].dwOrdinal = p->Store.Allocate();
+         p->Side[i].k = 0;
+         p->Churn[i].dwOrdinal = p->Store.Allocate();
+         p->Churn[i].fAllocated = TRUE;
+         p->Churn[i].k = 0;
+      }
+   }
+   for (i = 0; i < p->Churn.size(); i++) {  // churn ordinals start with a string
+      VARIANT v;
+      FILETIME ft = TimeStamp( 1 );
+      StringValue( 1, &v );
+      p->Store.SetValue( p->Churn[i].dwOrdinal, &v, Quality( 1 ), &ft );
+      VariantClear( &v );
+      p->Churn[i].k = 1;
+   }
+   p->Store.GetStatistics( &Stats );
+   Check( Stats.dwPages >= 3, "concurrency: ordinals span several pages" );
+
+   std::vector<std::thread> Threads;
+   for (DWORD w = 0; w < dwWriters; w++) {
+      Threads.push_back( std::thread( WriteThread, p, w, dwWriters ) );
+   }
+   Threads.push_back( std::thread( LockFreeReadThread, p ) );
+   Threads.push_back( std::thread( LockFreeReadThread, p ) );
+   Threads.push_back( std::thread( SideReadThread, p, 1 ) );
+   Threads.push_back( std::thread( SideReadThread, p, 2 ) );
+   Threads.push_back( std::thread( ChurnThread, p ) );
+
+   Sleep( 1000 );
+   p->fStop = true;
+   for (i = 0; i < Threads.size(); i++) {
+      Threads[i].join();
+   }
+
+   if (fVerbose) {
+      printf( "concurrency: %llu lock-free reads, %llu side reads, %llu churns\n",
+              (unsigned long long)p->ullReads, (unsigned long long)p->ullSideReads,
+              (unsigned long long)p->ullChurns );
+   }
+   Check( p->ullReads > 0 && p->ullSideReads > 0 && p->ullChurns > 0, "concurrency: all threads ran" );
+   Check( p->lTorn == 0, "concurrency: no torn tuple read lock-free" );
+   Check( p->lBadSide == 0, "concurrency: side values intact while ordinals are released" );
+
+   size_t nAllocated = p->Scalar.size() + p->Side.size();
+   size_t nSide = 0;
+   for (i = 0; i < p->Churn.size(); i++) {
+      if (p->Churn[i].fAllocated) {
+         nAllocated++;
+         nSide++;
+      }
+   }
+   for (i = 0; i < p->Side.size(); i++) {
+      if (p->Side[i].k & 1) {
+         nSide++;
+      }
+   }
+   p->Store.GetStatistics( &Stats );
+   Check( Stats.dwOrdinals == nAllocated, "concurrency: allocated ordinals" );
+   Check( Stats.dwSideValues == nSide, "concurrency: side values" );
+   delete p;
+}
+
+
+//=========================================================================
+// Benchmark
+// ---------
+//    Time per item of
+//       store       : the value store, read lock-free with ReadScalars()
+//                     or ReadScalar()
+//       item lock   : a VARIANT per item copied within the lock of the
+//                     item, as before the store
+//    without and with two threads writing the same items, and the
+//    throughput of 16 reader threads while one thread writes the items.
+//=========================================================================
+struct LockedItem {
+   CRITICAL_SECTION  CritSec;
+   VARIANT           vValue;
+   WORD              wQuality;
+   FILETIME          ftTimeStamp;
+};
+
+static void BenchmarkWriter( DaValueStore* pStore, LockedItem* pItems, DWORD dwItems,
+                             std::atomic<bool>* pfStop, DWORD dwSeed )
+{
+   std::mt19937   Rand( dwSeed );
+   VARIANT        v;
+   ULONGLONG      k = 1;
+
+   while (!*pfStop) {
+      DWORD i = Rand() % dwItems;
+      FILETIME ft = TimeStamp( ++k );
+      ScalarValue( k, &v );
+      EnterCriticalSection( &pItems[i].CritSec );
+      pStore->SetValue( i, &v, Quality( k ), &ft );
+      VariantCopy( &pItems[i].vValue, &v );
+      pItems[i].wQuality = Quality( k );
+      pItems[i].ftTimeStamp = ft;
+      LeaveCriticalSection( &pItems[i].CritSec );
+   }
+}
+
+enum READMETHOD { READ_SCALARS, READ_SCALAR, READ_ITEM_LOCK };
+
+               // Reads all items nRounds times, returns a sum of the values
+static LONGLONG BenchmarkReader( READMETHOD Method, DaValueStore* pStore, LockedItem* pItems,
+                                 DWORD dwItems, const DWORD* pOrdinals, int nRounds )
+{
+   std::vector<DASCALARVQT>   VQTs( Method == READ_SCALARS ? dwItems : 0 );
+   VARIANT                    v;
+   WORD                       wQuality;
+   FILETIME                   ft;
+   HRESULT                    hr;
+   LONGLONG                   llSum = 0;
+
+   for (int r = 0; r < nRounds; r++) {
+      if (Method == READ_SCALARS) {
+         pStore->ReadScalars( dwItems, pOrdinals, &VQTs[0] );
+         llSum += VQTs[r].llValue;
+         continue;
+      }
+      for (DWORD i = 0; i < dwItems; i++) {
+         VariantInit( &v );
+         if (Method == READ_SCALAR) {
+            pStore->ReadScalar( pOrdinals[i], VT_EMPTY, &v, &wQuality, &ft, &hr );
+         }
+         else {
+            EnterCriticalSection( &pItems[i].CritSec );
+            VariantCopy( &v, &pItems[i].vValue );
+            wQuality = pItems[i].wQuality;
+            ft = pItems[i].ftTimeStamp;
+            LeaveCriticalSection( &pItems[i].CritSec );
+         }
+         llSum += v.llVal;
+      }
+   }
+   return llSum;
+}
+
+               // Returns the items per second read by all readers together
+static double BenchmarkReaders( READMETHOD Method, int nReaders, DaValueStore* pStore, LockedItem* pItems,
+                                DWORD dwItems, const DWORD* pOrdinals, int nRounds, LONGLONG* pllSum )
+{
+   std::atomic<bool>          fStop( false );
+   std::thread                Writer( BenchmarkWriter, pStore, pItems, dwItems, &fStop, 1 );
+   std::vector<std::thread>   Readers;
+   std::vector<LONGLONG>      Sums( nReaders );
+
+   double dStart = NowSeconds();
+   for (int t = 0; t < nReaders; t++) {
+      LONGLONG* pllReaderSum = &Sums[t];
+      Readers.push_back( std::thread( [=] {
+         *pllReaderSum = BenchmarkReader( Method, pStore, pItems, dwItems, pOrdinals, nRounds );
+      } ) );
+   }
+   for (int t = 0; t < nReaders; t++) {
+      Readers[t].join();
+      *pllSum += Sums[t];
+   }
+   double dElapsed = NowSeconds() - dStart;
+
+   fStop = true;
+   Writer.join();
+   return nReaders * (double)nRounds * dwItems / dElapsed;
+}
+
+static void Benchmark()
+{
+   const DWORD                dwItems = 100000;
+   const int                  nRounds = 20;
+   DaValueStore               Store;
+   LockedItem*                pItems = new LockedItem[dwItems];
+   std::vector<DWORD>         Ordinals( dwItems );
+   std::vector<DASCALARVQT>   VQTs( dwItems );
+   VARIANT                    v;
+   WORD                       wQuality;
+   FILETIME                   ft;
+   HRESULT                    hr;
+   double                     dStart;
+   DWORD                      i;
+   LONGLONG                   llSum = 0;
+
+   for (i = 0; i < dwItems; i++) {
+      Ordinals[i] = Store.Allocate();
+      InitializeCriticalSection( &pItems[i].CritSec );
+      VariantInit( &pItems[i].vValue );
+   }
+
+   dStart = NowSeconds();
+   for (int r = 0; r < nRounds; r++) {
+      for (i = 0; i < dwItems; i++) {
+         ft = TimeStamp( i + 1 );
+         ScalarValue( i + 1, &v );
+         Store.SetValue( i, &v, Quality( i + 1 ), &ft );
+      }
+   }
+   double dSet = (NowSeconds() - dStart) * 1e9 / (nRounds * (double)dwItems);
+
+   dStart = NowSeconds();
+   for (int r = 0; r < nRounds; r++) {
+      for (i = 0; i < dwItems; i++) {
+         ft = TimeStamp( i + 1 );
+         ScalarValue( i + 1, &v );
+         EnterCriticalSection( &pItems[i].CritSec );
+         VariantCopy( &pItems[i].vValue, &v );
+         pItems[i].wQuality = Quality( i + 1 );
+         pItems[i].ftTimeStamp = ft;
+         LeaveCriticalSection( &pItems[i].CritSec );
+      }
+   }
+   double dSetLocked = (NowSeconds() - dStart) * 1e9 / (nRounds * (double)dwItems);
+   printf( "write:                         store %5.1f ns/item, item lock %5.1f ns/item\n", dSet, dSetLocked );
+
+   for (int nWriters = 0; nWriters <= 2; nWriters += 2) {
+      std::atomic<bool> fStop( false );
+      std::vector<std::thread> Writers;
+      for (int w = 0; w < nWriters; w++) {
+         Writers.push_back( std::thread( BenchmarkWriter, &Store, pItems, dwItems, &fStop, w + 1 ) );
+      }
+
+      dStart = NowSeconds();
+      for (int r = 0; r < nRounds; r++) {
+         Store.ReadScalars( dwItems, &Ordinals[0], &VQTs[0] );
+         llSum += VQTs[r].llValue;
+      }
+      double dBulk = (NowSeconds() - dStart) * 1e9 / (nRounds * (double)dwItems);
+
+      dStart = NowSeconds();
+      for (int r = 0; r < nRounds; r++) {
+         for (i = 0; i < dwItems; i++) {
+            VariantInit( &v );
+            Store.ReadScalar( i, VT_EMPTY, &v, &wQuality, &ft, &hr );
+            llSum += v.llVal;
+         }
+      }
+      double dSingle = (NowSeconds() - dStart) * 1e9 / (nRounds * (double)dwItems);
+
+      dStart = NowSeconds();
+      for (int r = 0; r < nRounds; r++) {
+         for (i = 0; i < dwItems; i++) {
+            VariantInit( &v );
+            EnterCriticalSection( &pItems[i].CritSec );
+            VariantCopy( &v, &pItems[i].vValue );
+            wQuality = pItems[i].wQuality;
+            ft = pItems[i].ftTimeStamp;
+            LeaveCriticalSection( &pItems[i].CritSec );
+            llSum += v.llVal;
+         }
+      }
+      double dLocked = (NowSeconds() - dStart) * 1e9 / (nRounds * (double)dwItems);
+
+      fStop = true;
+      for (size_t w = 0; w < Writers.size(); w++) {
+         Writers[w].join();
+      }
+      printf( "read, %d concurrent writers:  ReadScalars %5.1f ns/item, ReadScalar %5.1f ns/item, item lock %5.1f ns/item\n",
+              nWriters, dBulk, dSingle, dLocked );
+   }
+
+   const int nReaders = 16;
+   double dBulkItems = BenchmarkReaders( READ_SCALARS, nReaders, &Store, pItems, dwItems, &Ordinals[0], nRounds, &llSum );
+   double dSingleItems = BenchmarkReaders( READ_SCALAR, nReaders, &Store, pItems, dwItems, &Ordinals[0], nRounds, &llSum );
+   double dLockedItems = BenchmarkReaders( READ_ITEM_LOCK, nReaders, &Store, pItems, dwItems, &Ordinals[0], nRounds, &llSum );
+   printf( "read, %d readers, 1 writer:  ReadScalars %6.1f M items/s, ReadScalar %6.1f M items/s, item lock %6.1f M items/s\n",
+           nReaders, dBulkItems / 1e6, dSingleItems / 1e6, dLockedItems / 1e6 );
+
+   for (i = 0; i < dwItems; i++) {
+      DeleteCriticalSection( &pItems[i].CritSec );
+   }
+   delete [] pItems;
+   printf( "(%d)\n", (int)(llSum & 1) );
+}
+
+
+int main( int argc, char* argv[] )
+{
+   if (IsBenchmark( argc, argv )) {
+      Benchmark();
+      TestConcurrency( TRUE );
+      return 0;
+   }
+
+   TestAllocate();
+   TestConcurrency( FALSE );
+
+   return TestResult();
+}